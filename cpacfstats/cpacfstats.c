@@ -41,6 +41,8 @@ static const char *const usage =
 	"\t-p, --print   [counter]   Print one or all counter values\n"
 	"\t-n, --nonzero             Print all PAI counters\n"
 	"\t-j, --json                Print all counter values in JSON format\n"
+	"\t-i, --interval <ms>       Print counter values every <ms> milliseconds\n"
+	"\t-c, --count <count>       Stop after <count> intervals\n"
 	"\tcounter can be: 'aes' 'des' 'rng' 'sha' 'ecc'\n"
 	"\t                'pai_user' 'pai_kernel' or 'all'\n";
 
@@ -57,6 +59,17 @@ static const char *const counter_str[] = {
 
 
 static int paiprintnonzero;
+static const char *jsonsep = "";
+
+/*
+ * Source of answers: Either received one by one from socket s or taken
+ * from batch b, which has been received in one piece
+ */
+struct answers {
+	int s;
+	struct msg_batch_buf *b;
+	unsigned int pos;
+};
 
 
 static int send_query(int s, enum cmd_e cmd, enum ctr_e ctr)
@@ -74,12 +87,44 @@ static int send_query(int s, enum cmd_e cmd, enum ctr_e ctr)
 }
 
 
-static int recv_answer(int s, int *ctr, int *state, uint64_t *value)
+static int send_subscribe(int s, enum ctr_e ctr, uint32_t interval,
+			  uint32_t count)
 {
 	struct msg m;
+
+	memset(&m, 0, sizeof(m));
+
+	m.head.m_ver = VERSION;
+	m.head.m_type = SUBSCRIBE;
+	m.subscribe.m_ctr = ctr;
+	m.subscribe.m_interval = interval;
+	m.subscribe.m_count = count;
+
+	return send_msg(s, &m, 0);
+}
+
+
+static int recv_answer(struct answers *a, int *ctr, int *state,
+		       uint64_t *value)
+{
+	struct msg_answer *ans;
+	struct msg m;
 	int rc;
 
-	rc = recv_msg(s, &m, 0);
+	if (a->b) {
+		if (a->pos >= a->b->batch.m_cnt) {
+			eprint("Batch answer has only %u counters\n",
+			       a->b->batch.m_cnt);
+			return -1;
+		}
+		ans = &a->b->answer[a->pos++];
+		*ctr = ans->m_ctr;
+		*state = ans->m_state;
+		*value = ans->m_value;
+		return 0;
+	}
+
+	rc = recv_msg(a->s, &m, 0);
 	if (rc == 0) {
 		if (m.head.m_ver != VERSION) {
 			eprint("Received msg with wrong version %d != %d\n",
@@ -102,14 +147,12 @@ static int recv_answer(int s, int *ctr, int *state, uint64_t *value)
 
 static void printjsonsep(void)
 {
-	static const char *jsonsep = "";
-
 	fputs(jsonsep, stdout);
 	jsonsep = ",";
 }
 
 
-static void json_print_virtual_counter_answer(int s, int ctr,
+static void json_print_virtual_counter_answer(struct answers *a, int ctr,
 					      int state, uint64_t value)
 {
 	int paictr = 0, paistate = 0, ec;
@@ -148,7 +191,7 @@ static void json_print_virtual_counter_answer(int s, int ctr,
 		exit(EXIT_FAILURE);
 	}
 	for (i = 0; i < value; ++i) {
-		ec = recv_answer(s, &paictr, &paistate, &paivalue);
+		ec = recv_answer(a, &paictr, &paistate, &paivalue);
 		if (ec < 0 || paistate < 0) {
 			eprint("Error on receiving answer message from daemon\n");
 			/* No more data for this virtual event after error. */
@@ -171,7 +214,7 @@ static void json_print_virtual_counter_answer(int s, int ctr,
 }
 
 
-static void print_virtual_counter_answer(int s,
+static void print_virtual_counter_answer(struct answers *a,
 					 int ctr, int state, uint64_t value)
 {
 	static const char *const states[] = {
@@ -217,7 +260,7 @@ static void print_virtual_counter_answer(int s,
 		exit(EXIT_FAILURE);
 	}
 	for (i = 0; i < value; ++i) {
-		ec = recv_answer(s, &paictr, &paistate, &paivalue);
+		ec = recv_answer(a, &paictr, &paistate, &paivalue);
 		if (ec < 0 || paistate < 0) {
 			eprint("Error on receiving answer message from daemon\n");
 			/* No more data for this virtual event after error. */
@@ -231,10 +274,10 @@ static void print_virtual_counter_answer(int s,
 	}
 }
 
-static void print_answer(int s, int ctr, int state, uint64_t value)
+static void print_answer(struct answers *a, int ctr, int state, uint64_t value)
 {
 	if (ctr > ALL_COUNTER)
-		print_virtual_counter_answer(s, ctr, state, value);
+		print_virtual_counter_answer(a, ctr, state, value);
 	else if (state < 0)
 		printf(" %s counter: error state %d\n",
 		       counter_str[ctr], state);
@@ -247,10 +290,10 @@ static void print_answer(int s, int ctr, int state, uint64_t value)
 }
 
 
-static void json_print_answer(int s, int ctr, int state, uint64_t value)
+static void json_print_answer(struct answers *a, int ctr, int state, uint64_t value)
 {
 	if (ctr > ALL_COUNTER) {
-		json_print_virtual_counter_answer(s, ctr, state, value);
+		json_print_virtual_counter_answer(a, ctr, state, value);
 	} else if (state < 0) {
 		printjsonsep();
 		printf("{\"counter\":\"%s\",", counter_str[ctr]);
@@ -263,6 +306,79 @@ static void json_print_answer(int s, int ctr, int state, uint64_t value)
 }
 
 
+/*
+ * Receive and print num answers, where the answers of PAI_USER and
+ * PAI_KERNEL are followed by the answers of their PAI counters
+ */
+static int print_answers(struct answers *a, int num, int json)
+{
+	int i, j, state;
+	uint64_t value;
+
+	jsonsep = "";
+	if (json)
+		putchar('[');
+	for (i = 0; i < num; i++) {
+		/* receive answer */
+		if (recv_answer(a, &j, &state, &value) != 0) {
+			eprint("Error on receiving answer message from daemon\n");
+			return -1;
+		}
+		if (state < 0) {
+			eprint("Received bad status code %d from daemon\n",
+				state);
+			return -1;
+		}
+		if (json)
+			json_print_answer(a, j, state, value);
+		else
+			print_answer(a, j, state, value);
+	}
+	if (json)
+		putchar(']');
+
+	return 0;
+}
+
+
+/*
+ * Receive and print batch answers: One for a PRINT_BATCH query and one
+ * per interval for a subscription until the daemon closes the connection
+ */
+static int print_batches(int s, int num, int json, int subscribed)
+{
+	static struct msg_batch_buf b;
+	struct answers a = { .s = s, .b = &b };
+	int rc, received = 0;
+
+	do {
+		rc = recv_batch(s, &b, 0);
+		if (rc == 1 && subscribed && received)
+			return 0; /* subscription ended */
+		if (rc != 0) {
+			eprint("Error on receiving answer message from daemon\n");
+			return -1;
+		}
+		if (b.head.m_ver != VERSION) {
+			eprint("Received msg with wrong version %d != %d\n",
+			       b.head.m_ver, VERSION);
+			return -1;
+		}
+		if (subscribed && !json && b.batch.m_seq)
+			putchar('\n');
+		a.pos = 0;
+		if (print_answers(&a, num, json) != 0)
+			return -1;
+		received++;
+		if (subscribed && json)
+			putchar('\n');
+		fflush(stdout);
+	} while (subscribed);
+
+	return 0;
+}
+
+
 int eprint(const char *format, ...)
 {
 	char buf[1024];
@@ -285,8 +401,9 @@ int main(int argc, char *argv[])
 {
 	enum ctr_e ctr = ALL_COUNTER;
 	enum cmd_e cmd = PRINT;
-	int i, j, s, state, num, json = 0;
-	uint64_t value;
+	uint32_t interval = 0, count = 0;
+	int i, s, rc, num, json = 0;
+	char *endp;
 
 	if (argc > 1) {
 		int opt, idx = 0;
@@ -299,10 +416,12 @@ int main(int argc, char *argv[])
 			{ "print", 0, NULL, 'p' },
 			{ "nonzero", 0, NULL, 'n' },
 			{ "json", 0, NULL, 'j' },
+			{ "interval", 1, NULL, 'i' },
+			{ "count", 1, NULL, 'c' },
 			{ NULL, 0, NULL, 0 } };
 		while (1) {
 			opt = getopt_long(argc, argv,
-					  "hvedrpnj", long_opts, &idx);
+					  "hvedrpnji:c:", long_opts, &idx);
 			if (opt == -1)
 				break; /* no more arguments */
 			switch (opt) {
@@ -336,6 +455,21 @@ int main(int argc, char *argv[])
 				cmd = PRINT;
 				json = 1;
 				break;
+			case 'i':
+				interval = strtoul(optarg, &endp, 10);
+				if (*endp || interval < MIN_SUBSCRIBE_INTERVAL) {
+					eprint("Invalid interval '%s', minimum is %d ms\n",
+					       optarg, MIN_SUBSCRIBE_INTERVAL);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'c':
+				count = strtoul(optarg, &endp, 10);
+				if (*endp || count == 0) {
+					eprint("Invalid count '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+				break;
 			default:
 				eprint("Invalid argument, try -h or --help for more information\n");
 				return EXIT_FAILURE;
@@ -355,6 +489,14 @@ int main(int argc, char *argv[])
 	}
 	if (json)
 		ctr = ALL_COUNTER;
+	if (cmd != PRINT && interval) {
+		eprint("Option --interval is only valid for printing counters\n");
+		return EXIT_FAILURE;
+	}
+	if (count && !interval) {
+		eprint("Option --count requires option --interval\n");
+		return EXIT_FAILURE;
+	}
 
 	/* try to open and connect socket to the cpacfstatsd daemon */
 	s = open_socket(CLIENT);
@@ -363,8 +505,14 @@ int main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
-	/* send query */
-	if (send_query(s, cmd, ctr) != 0) {
+	/* send query, counter values are printed from batch answers */
+	if (cmd != PRINT)
+		rc = send_query(s, cmd, ctr);
+	else if (interval)
+		rc = send_subscribe(s, ctr, interval, count);
+	else
+		rc = send_query(s, PRINT_BATCH, ctr);
+	if (rc != 0) {
 		eprint("Error on sending query message to daemon\n");
 		close(s);
 		return EXIT_FAILURE;
@@ -378,27 +526,17 @@ int main(int argc, char *argv[])
 		/* +1 for hotplug state */
 		num = 1 + 1;
 	}
-	if (json)
-		putchar('[');
-	for (i = 0; i < num; i++) {
-		/* receive answer */
-		if (recv_answer(s, &j, &state, &value) != 0) {
-			eprint("Error on receiving answer message from daemon\n");
-			return EXIT_FAILURE;
-		}
-		if (state < 0) {
-			eprint("Received bad status code %d from daemon\n",
-				state);
-			close(s);
-			return EXIT_FAILURE;
-		}
-		if (json)
-			json_print_answer(s, j, state, value);
-		else
-			print_answer(s, j, state, value);
+	if (cmd == PRINT) {
+		rc = print_batches(s, num, json, interval != 0);
+	} else {
+		struct answers a = { .s = s };
+
+		rc = print_answers(&a, num, json);
+	}
+	if (rc != 0) {
+		close(s);
+		return EXIT_FAILURE;
 	}
-	if (json)
-		putchar(']');
 
 	/* close connection */
 	close(s);
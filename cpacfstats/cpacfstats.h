@@ -18,6 +18,7 @@
 
 #define DEFAULT_SEND_TIMEOUT  (30 * 1000)
 #define DEFAULT_RECV_TIMEOUT  (30 * 1000)
+#define SUBSCRIBE_SEND_TIMEOUT (1 * 1000)
 
 /*
  * Number of PAI counters. Contains all counters regardless of kernel or user
@@ -61,14 +62,17 @@ enum ctr_e {
 
 enum type_e {
 	QUERY = 0,
-	ANSWER
+	ANSWER,
+	BATCH,
+	SUBSCRIBE
 };
 
 enum cmd_e {
 	PRINT = 0,
 	ENABLE,
 	DISABLE,
-	RESET
+	RESET,
+	PRINT_BATCH
 };
 
 enum state_e {
@@ -107,6 +111,41 @@ struct msg_answer {
 	uint64_t m_value;
 } __packed;
 
+/*
+ * batch answer send from daemon to client
+ * Consist of:
+ * number of answers that follow the batch header
+ * sequence number of the snapshot, starting with 0 for each connection
+ * The answers have the same order and meaning as the single answers sent
+ * for the PRINT command, including the PAI counters and the hotplug state.
+ */
+struct msg_batch {
+	uint32_t m_cnt;
+	uint32_t m_seq;
+} __packed;
+
+/*
+ * subscription send from client to daemon
+ * Consist of:
+ * enum counter
+ * interval in milliseconds between two batch answers
+ * number of batch answers, 0 for no limit
+ */
+struct msg_subscribe {
+	uint32_t m_ctr;
+	uint32_t m_interval;
+	uint32_t m_count;
+} __packed;
+
+/*
+ * Maximum number of answers in a batch: The physical counters, the
+ * virtual PAI counters with all PAI counters each and the hotplug state.
+ */
+#define MAX_NUM_BATCH		(NUM_COUNTER + 2 * MAX_NUM_PAI)
+
+/* Minimum subscription interval in milliseconds */
+#define MIN_SUBSCRIBE_INTERVAL	100
+
 /* stats_sock.c */
 
 #define SERVER 1
@@ -114,6 +153,8 @@ struct msg_answer {
 
 #define BACKLOG 10
 
+#define MAX_SUBSCRIBERS 16
+
 #define SOCKET_FILE "/run/cpacfstatsd_socket"
 #define PID_FILE    "/run/cpacfstatsd.pid"
 
@@ -129,12 +170,25 @@ struct msg {
 	union {
 		struct msg_query  query;
 		struct msg_answer answer;
+		struct msg_batch  batch;
+		struct msg_subscribe subscribe;
 	};
 } __packed;
 
+/*
+ * batch message on the wire: Only the first batch.m_cnt answers are sent
+ */
+struct msg_batch_buf {
+	struct msg_header head;
+	struct msg_batch  batch;
+	struct msg_answer answer[MAX_NUM_BATCH];
+} __packed;
+
 int open_socket(int mode);
 int send_msg(int sfd, struct msg *m, int timeout);
 int recv_msg(int sfd, struct msg *m, int timeout);
+int send_batch(int sfd, struct msg_batch_buf *b, int timeout);
+int recv_batch(int sfd, struct msg_batch_buf *b, int timeout);
 
 /* perf_crypto.c */
 
@@ -149,7 +203,8 @@ int  perf_read_ctr(enum ctr_e ctr, uint64_t *value, unsigned int
 				   *supported_counters);
 int  perf_ecc_supported(void);
 int  perf_ctr_state(enum ctr_e ctr);
-int  perf_read_pai_ctr(unsigned int ctrnum, int user, uint64_t *value);
+int  perf_read_ctrs(uint64_t *values);
+int  perf_read_pai_ctrs(int user, uint64_t *values);
 
 /* cpacfstats_common.c */
 
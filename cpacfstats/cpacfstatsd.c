@@ -14,6 +14,7 @@
 #include <getopt.h>
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdint.h>
@@ -23,6 +24,7 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <syslog.h>
+#include <time.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <fcntl.h>
@@ -86,34 +88,67 @@ static const char *const usage =
 
 static int daemonized;
 
-static int recv_query(int s, enum ctr_e *ctr, enum cmd_e *cmd)
+/*
+ * Answers to one query are either sent one by one to socket s or
+ * collected in batch b, which is sent in one piece afterwards
+ */
+struct reply {
+	int s;
+	struct msg_batch_buf *b;
+};
+
+/*
+ * Subscribed client that gets a batch answer every interval milliseconds
+ */
+struct subscriber {
+	int s;
+	enum ctr_e ctr;
+	uint32_t interval;
+	uint32_t count;		/* remaining batches, 0 for no limit */
+	uint32_t seq;
+	uint64_t next;		/* time of next batch in milliseconds */
+};
+
+static struct subscriber subscribers[MAX_SUBSCRIBERS];
+static int num_subscribers;
+static struct msg_batch_buf batchbuf;
+
+static int recv_query(int s, struct msg *m)
 {
-	struct msg m;
 	int rc;
 
-	rc = recv_msg(s, &m, DEFAULT_RECV_TIMEOUT);
+	rc = recv_msg(s, m, DEFAULT_RECV_TIMEOUT);
 	if (rc == 0) {
-		if (m.head.m_ver != VERSION) {
+		if (m->head.m_ver != VERSION) {
 			eprint("Received msg with wrong version %d != %d\n",
-			       m.head.m_ver, VERSION);
+			       m->head.m_ver, VERSION);
 			return -1;
 		}
-		if (m.head.m_type != QUERY) {
+		if (m->head.m_type != QUERY && m->head.m_type != SUBSCRIBE) {
 			eprint("Received msg with wrong type %d != %d\n",
-			       m.head.m_type, QUERY);
+			       m->head.m_type, QUERY);
 			return -1;
 		}
-		*ctr = m.query.m_ctr;
-		*cmd = m.query.m_cmd;
 	}
 
 	return rc;
 }
 
-static int send_answer(int s, int ctr, int state, uint64_t value)
+static int send_answer(struct reply *r, int ctr, int state, uint64_t value)
 {
+	struct msg_answer *a;
 	struct msg m;
 
+	if (r->b) {
+		if (r->b->batch.m_cnt >= MAX_NUM_BATCH)
+			return -1;
+		a = &r->b->answer[r->b->batch.m_cnt++];
+		a->m_ctr = ctr;
+		a->m_state = state;
+		a->m_value = value;
+		return 0;
+	}
+
 	memset(&m, 0, sizeof(m));
 
 	m.head.m_ver = VERSION;
@@ -122,7 +157,7 @@ static int send_answer(int s, int ctr, int state, uint64_t value)
 	m.answer.m_state = state;
 	m.answer.m_value = value;
 
-	return send_msg(s, &m, DEFAULT_SEND_TIMEOUT);
+	return send_msg(r->s, &m, DEFAULT_SEND_TIMEOUT);
 }
 
 /*
@@ -132,35 +167,42 @@ static int send_answer(int s, int ctr, int state, uint64_t value)
  *   - for each PAI counter the value with state ENABLED
  * Note that the PAI counters are 0-based, not 1 based as in PoP!
  * Sending ends with the first error.
+ * In a batch the number of PAI counters in the answer of the virtual
+ * counter, which directly precedes them, is set to the number actually added.
  */
-static int do_send_pai(int s, int user, unsigned int *counter)
+static int do_send_pai(struct reply *r, int user, unsigned int *counter)
 {
+	unsigned int current_ctr, first = 0;
+	uint64_t values[MAX_NUM_PAI];
 	int ctr, state, i, rc = 0;
-	unsigned int current_ctr;
-	uint64_t value;
 
 	ctr = user ? PAI_USER : PAI_KERNEL;
 
 	state = perf_ctr_state(ctr);
 	if (state != ENABLED)
 		return rc;
+	rc = perf_read_pai_ctrs(user, values);
+	if (r->b)
+		first = r->b->batch.m_cnt;
 	for (i = 0; i < MAX_NUM_PAI; ++i) {
 		current_ctr = pai_idx[i];
 		if ((user && is_user_space(current_ctr) != KERNEL_AND_USER_COUNTER) ||
 		    (!user && is_user_space(current_ctr) == SUPPRESS_COUNTER) ||
 		    counter[current_ctr] != 1)
 			continue;
-		rc = perf_read_pai_ctr(current_ctr, user, &value);
 		if (rc != 0) {
-			send_answer(s, current_ctr, rc, 0);
+			send_answer(r, current_ctr, rc, 0);
 			break;
 		}
-		send_answer(s, current_ctr, state, value);
+		send_answer(r, current_ctr, state, values[current_ctr]);
 	}
+	if (r->b && first > 0)
+		r->b->answer[first - 1].m_value = r->b->batch.m_cnt - first;
 	return rc;
 }
 
-static int do_enable(int s, enum ctr_e ctr, unsigned int *supported_counters)
+static int do_enable(struct reply *r, enum ctr_e ctr,
+		     unsigned int *supported_counters)
 {
 	uint64_t value = 0;
 	int i, rc = 0;
@@ -174,7 +216,7 @@ static int do_enable(int s, enum ctr_e ctr, unsigned int *supported_counters)
 			if (state == DISABLED) {
 				rc = perf_enable_ctr(i, supported_counters);
 				if (rc != 0) {
-					send_answer(s, i, rc, 0);
+					send_answer(r, i, rc, 0);
 					break;
 				}
 				state = ENABLED;
@@ -182,25 +224,26 @@ static int do_enable(int s, enum ctr_e ctr, unsigned int *supported_counters)
 			if (state != UNSUPPORTED) {
 				rc = perf_read_ctr(i, &value, supported_counters);
 				if (rc != 0) {
-					send_answer(s, i, rc, 0);
+					send_answer(r, i, rc, 0);
 					break;
 				}
 			}
-			send_answer(s, i, state, value);
+			send_answer(r, i, state, value);
 			if (i == PAI_USER)
-				rc = do_send_pai(s, 1, supported_counters);
+				rc = do_send_pai(r, 1, supported_counters);
 			if (i == PAI_KERNEL)
-				rc = do_send_pai(s, 0, supported_counters);
+				rc = do_send_pai(r, 0, supported_counters);
 		}
 	}
 	if (rc == 0) {
 		rc = perf_read_ctr(HOTPLUG_DETECTED, &value, NULL);
-		send_answer(s, HOTPLUG_DETECTED, rc, value);
+		send_answer(r, HOTPLUG_DETECTED, rc, value);
 	}
 	return rc;
 }
 
-static int do_disable(int s, enum ctr_e ctr, unsigned int *supported_counters)
+static int do_disable(struct reply *r, enum ctr_e ctr,
+		      unsigned int *supported_counters)
 {
 	int i, rc = 0;
 	uint64_t value;
@@ -212,21 +255,22 @@ static int do_disable(int s, enum ctr_e ctr, unsigned int *supported_counters)
 			if (perf_ctr_state(i) == ENABLED) {
 				rc = perf_disable_ctr(i, supported_counters);
 				if (rc != 0) {
-					send_answer(s, i, rc, 0);
+					send_answer(r, i, rc, 0);
 					break;
 				}
 			}
-			send_answer(s, i, perf_ctr_state(i), 0);
+			send_answer(r, i, perf_ctr_state(i), 0);
 		}
 	}
 	if (rc == 0) {
 		rc = perf_read_ctr(HOTPLUG_DETECTED, &value, NULL);
-		send_answer(s, HOTPLUG_DETECTED, rc, value);
+		send_answer(r, HOTPLUG_DETECTED, rc, value);
 	}
 	return rc;
 }
 
-static int do_reset(int s, enum ctr_e ctr, unsigned int *supported_counters)
+static int do_reset(struct reply *r, enum ctr_e ctr,
+		    unsigned int *supported_counters)
 {
 	int i, rc = 0, state;
 	uint64_t value;
@@ -239,28 +283,33 @@ static int do_reset(int s, enum ctr_e ctr, unsigned int *supported_counters)
 			if (state == ENABLED) {
 				rc = perf_reset_ctr(i, &value, supported_counters);
 				if (rc != 0) {
-					send_answer(s, i, rc, 0);
+					send_answer(r, i, rc, 0);
 					break;
 				}
 			}
-			send_answer(s, i, state, value);
+			send_answer(r, i, state, value);
 			if (i == PAI_USER)
-				rc = do_send_pai(s, 1, supported_counters);
+				rc = do_send_pai(r, 1, supported_counters);
 			if (i == PAI_KERNEL)
-				rc = do_send_pai(s, 0, supported_counters);
+				rc = do_send_pai(r, 0, supported_counters);
 		}
 	}
 	if (rc == 0) {
 		rc = perf_read_ctr(HOTPLUG_DETECTED, &value, NULL);
-		send_answer(s, HOTPLUG_DETECTED, rc, value);
+		send_answer(r, HOTPLUG_DETECTED, rc, value);
 	}
 	return rc;
 }
 
-static int do_print(int s, enum ctr_e ctr, unsigned int *supported_counters)
+static int do_print(struct reply *r, enum ctr_e ctr,
+		    unsigned int *supported_counters)
 {
-	int i, rc = 0, state;
-	uint64_t value = 0;
+	uint64_t values[ALL_COUNTER], value = 0;
+	int i, rc = 0, state, ctrs_rc = 0;
+
+	/* Read all CPU-MF counters with one read per CPU */
+	if (ctr == ALL_COUNTER)
+		ctrs_rc = perf_read_ctrs(values);
 
 	for (i = 0; i < NUM_COUNTER; i++) {
 		if (i == ALL_COUNTER)
@@ -268,26 +317,188 @@ static int do_print(int s, enum ctr_e ctr, unsigned int *supported_counters)
 		if (i == (int) ctr || ctr == ALL_COUNTER) {
 			state = perf_ctr_state(i);
 			if (state == ENABLED) {
-				rc = perf_read_ctr(i, &value, supported_counters);
+				if (ctr == ALL_COUNTER && i < ALL_COUNTER) {
+					rc = ctrs_rc;
+					value = values[i];
+				} else {
+					rc = perf_read_ctr(i, &value,
+							   supported_counters);
+				}
 				if (rc != 0) {
-					send_answer(s, i, rc, 0);
+					send_answer(r, i, rc, 0);
 					break;
 				}
 			}
-			send_answer(s, i, state, value);
+			send_answer(r, i, state, value);
 			if (i == PAI_USER)
-				rc = do_send_pai(s, 1, supported_counters);
+				rc = do_send_pai(r, 1, supported_counters);
 			if (i == PAI_KERNEL)
-				rc = do_send_pai(s, 0, supported_counters);
+				rc = do_send_pai(r, 0, supported_counters);
 		}
 	}
 	if (rc == 0) {
 		rc = perf_read_ctr(HOTPLUG_DETECTED, &value, NULL);
-		send_answer(s, HOTPLUG_DETECTED, rc, value);
+		send_answer(r, HOTPLUG_DETECTED, rc, value);
 	}
 	return rc;
 }
 
+/*
+ * Collect the answers of a PRINT command for ctr into the batch buffer
+ */
+static int do_batch(enum ctr_e ctr, uint32_t seq,
+		    unsigned int *supported_counters)
+{
+	struct reply r = { .s = -1, .b = &batchbuf };
+
+	batchbuf.head.m_ver = VERSION;
+	batchbuf.batch.m_cnt = 0;
+	batchbuf.batch.m_seq = seq;
+	return do_print(&r, ctr, supported_counters);
+}
+
+static uint64_t now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int add_subscriber(int s, struct msg_subscribe *sub)
+{
+	struct subscriber *p;
+
+	if (num_subscribers >= MAX_SUBSCRIBERS) {
+		eprint("Too many subscribers, rejecting subscription\n");
+		return -1;
+	}
+	if (sub->m_ctr >= NUM_COUNTER) {
+		eprint("Received subscription for unknown counter %u\n",
+		       sub->m_ctr);
+		return -1;
+	}
+	p = &subscribers[num_subscribers++];
+	p->s = s;
+	p->ctr = sub->m_ctr;
+	p->interval = MAX(sub->m_interval, (uint32_t) MIN_SUBSCRIBE_INTERVAL);
+	p->count = sub->m_count;
+	p->seq = 0;
+	p->next = now_ms();
+	return 0;
+}
+
+static void remove_subscriber(int i)
+{
+	close(subscribers[i].s);
+	subscribers[i] = subscribers[--num_subscribers];
+}
+
+/*
+ * Returns the poll timeout until the next subscriber is due, -1 without
+ * subscribers
+ */
+static int subscriber_timeout(void)
+{
+	uint64_t now = now_ms(), next = UINT64_MAX;
+	int i;
+
+	if (!num_subscribers)
+		return -1;
+	for (i = 0; i < num_subscribers; i++)
+		next = MIN(next, subscribers[i].next);
+	return next > now ? (int) (next - now) : 0;
+}
+
+/*
+ * Send a batch to all subscribers which are due. A subscriber that does not
+ * take its batch within SUBSCRIBE_SEND_TIMEOUT is removed, so that a stuck
+ * client cannot block the daemon.
+ */
+static void do_subscribers(unsigned int *supported_counters)
+{
+	uint64_t now = now_ms();
+	struct subscriber *p;
+	int i;
+
+	for (i = num_subscribers - 1; i >= 0; i--) {
+		p = &subscribers[i];
+		if (p->next > now)
+			continue;
+		do_batch(p->ctr, p->seq++, supported_counters);
+		if (send_batch(p->s, &batchbuf, SUBSCRIBE_SEND_TIMEOUT) != 0 ||
+		    p->count == 1) {
+			remove_subscriber(i);
+			continue;
+		}
+		if (p->count)
+			p->count--;
+		p->next += p->interval;
+		/* Skip missed intervals instead of sending a burst */
+		if (p->next <= now)
+			p->next = now + p->interval;
+	}
+}
+
+/*
+ * Accept one client connection and handle its query. The connection is
+ * closed after the answer, except for subscriptions.
+ */
+static int do_client(int sfd, unsigned int *supported_counters)
+{
+	struct reply r = { .b = NULL };
+	struct msg m;
+	int s, rc;
+
+	s = accept(sfd, NULL, NULL);
+	if (s < 0) {
+		if (errno == EINTR || errno == ECONNABORTED)
+			return 0;
+		eprint("Accept() failure, errno=%d [%s]\n",
+		       errno, strerror(errno));
+		return -1;
+	}
+	r.s = s;
+
+	rc = recv_query(s, &m);
+	if (rc != 0) {
+		eprint("Recv_query() failed, ignoring\n");
+		close(s);
+		return 0;
+	}
+
+	if (m.head.m_type == SUBSCRIBE) {
+		if (add_subscriber(s, &m.subscribe) != 0)
+			close(s);
+		return 0;
+	}
+
+	switch (m.query.m_cmd) {
+	case ENABLE:
+		do_enable(&r, m.query.m_ctr, supported_counters);
+		break;
+	case DISABLE:
+		do_disable(&r, m.query.m_ctr, supported_counters);
+		break;
+	case RESET:
+		do_reset(&r, m.query.m_ctr, supported_counters);
+		break;
+	case PRINT:
+		do_print(&r, m.query.m_ctr, supported_counters);
+		break;
+	case PRINT_BATCH:
+		do_batch(m.query.m_ctr, 0, supported_counters);
+		send_batch(s, &batchbuf, DEFAULT_SEND_TIMEOUT);
+		break;
+	default:
+		eprint("Received unknown command %d, ignoring\n",
+		       (int) m.query.m_cmd);
+		break;
+	}
+	close(s);
+	return 0;
+}
+
 static int become_daemon(int *startup_pipe)
 {
 	int child_initialized = 0, fd;
@@ -596,40 +807,33 @@ int main(int argc, char *argv[])
 	startup_pipe = -1;
 
 	while (!stopsig) {
-		enum ctr_e ctr;
-		enum cmd_e cmd;
-		int s;
+		struct pollfd pfd[1 + MAX_SUBSCRIBERS];
+		int i, n = num_subscribers;
+
+		pfd[0].fd = sfd;
+		pfd[0].events = POLLIN;
+		/* Subscribers only send data to end the subscription */
+		for (i = 0; i < n; i++) {
+			pfd[1 + i].fd = subscribers[i].s;
+			pfd[1 + i].events = POLLIN;
+		}
 
-		s = accept(sfd, NULL, NULL);
-		if (s < 0) {
+		rc = poll(pfd, 1 + n, subscriber_timeout());
+		if (rc < 0) {
 			if (errno == EINTR)
 				continue;
-			eprint("Accept() failure, errno=%d [%s]\n",
+			eprint("Poll() failure, errno=%d [%s]\n",
 			       errno, strerror(errno));
 			goto error;
 		}
-
-		rc = recv_query(s, &ctr, &cmd);
-		if (rc != 0) {
-			eprint("Recv_query() failed, ignoring\n");
-			close(s);
-			continue;
-		}
-
-		if (cmd == ENABLE)
-			rc = do_enable(s, ctr, supported_counters);
-		else if (cmd == DISABLE)
-			rc = do_disable(s, ctr, supported_counters);
-		else if (cmd == RESET)
-			rc = do_reset(s, ctr, supported_counters);
-		else if (cmd == PRINT)
-			rc = do_print(s, ctr, supported_counters);
-		else {
-			eprint("Received unknown command %d, ignoring\n",
-			       (int) cmd);
-			close(s);
-			continue;
+		for (i = n - 1; i >= 0; i--) {
+			if (pfd[1 + i].revents)
+				remove_subscriber(i);
 		}
+		do_subscribers(supported_counters);
+		if ((pfd[0].revents & POLLIN) &&
+		    do_client(sfd, supported_counters) != 0)
+			goto error;
 	}
 
 	if (stopsig == SIGTERM)
@@ -50,10 +50,33 @@ static struct pmf_data {
 	int eventid;
 } pmf_counter_data[ALL_COUNTER];
 
+/*
+ * The counters of one PMU on one CPU are members of a perf event group, so
+ * that one read() returns the values of all counters. The group leader is
+ * a software dummy event, which is always enabled. This way the counters
+ * can still be enabled and disabled individually.
+ */
+struct ctrgroup {
+	int          fd;	/* leader, -1 if counters are read one by one */
+	unsigned int num;	/* number of events including the leader */
+};
+
+/* Maximum read size of a group: number of events, leader and counters */
+#define GROUP_BUF_SIZE		(2 + 2 * MAX_NUM_PAI)
+
+/*
+ * The position of a counter in the values of its group read. Position 0 is
+ * the leader, so 0 means that the counter is read with its own read().
+ */
 struct percpucounter {
 	int                   ctr_fds[ALL_COUNTER];
 	int                   pai_user[MAX_NUM_PAI];
 	int                   pai_kernel[MAX_NUM_PAI];
+	unsigned short        ctr_pos[ALL_COUNTER];
+	unsigned short        pai_user_pos[MAX_NUM_PAI];
+	unsigned short        pai_kernel_pos[MAX_NUM_PAI];
+	struct ctrgroup       cpumf_grp;
+	struct ctrgroup       pai_grp;
 	unsigned int          cpunum;
 	struct percpucounter *next;
 };
@@ -78,10 +101,12 @@ static struct percpucounter *allocpercpucounter(unsigned int cpunum)
 {
 	struct percpucounter *ppc;
 
-	ppc = malloc(sizeof(struct percpucounter));
+	ppc = calloc(1, sizeof(struct percpucounter));
 	if (ppc) {
 		int i;
 
+		ppc->cpumf_grp.fd = -1;
+		ppc->pai_grp.fd = -1;
 		for (i = 0; i < ALL_COUNTER; ++i)
 			ppc->ctr_fds[i] = -1;
 		for (i = 0; i < MAX_NUM_PAI; ++i) {
@@ -104,6 +129,8 @@ static void freepercpucounter(struct percpucounter *pcpu)
 		(void)close(pcpu->pai_user[i]);
 		(void)close(pcpu->pai_kernel[i]);
 	}
+	(void)close(pcpu->cpumf_grp.fd);
+	(void)close(pcpu->pai_grp.fd);
 	free(pcpu);
 }
 
@@ -225,6 +252,43 @@ static int perf_event_encode(int *pmutype, int *eventid,
 	return 0;
 }
 
+/*
+ * Open the dummy group leader for cpu. Without leader the counters are
+ * opened on their own.
+ */
+static void open_group(struct ctrgroup *grp, unsigned int cpu)
+{
+	struct perf_event_attr pfm_event;
+
+	memset(&pfm_event, 0, sizeof(pfm_event));
+	pfm_event.size = sizeof(pfm_event);
+	pfm_event.type = PERF_TYPE_SOFTWARE;
+	pfm_event.config = PERF_COUNT_SW_DUMMY;
+	pfm_event.read_format = PERF_FORMAT_GROUP;
+	grp->fd = perf_event_open(&pfm_event, -1, cpu, -1, 0);
+	grp->num = 1;
+}
+
+/*
+ * Open a counter for cpu as member of group grp and store its position
+ * in the group read in pos. If the PMU refuses the group, the counter is
+ * opened on its own.
+ */
+static int open_member(struct perf_event_attr *pfm_event, unsigned int cpu,
+		       struct ctrgroup *grp, unsigned short *pos)
+{
+	int fd;
+
+	if (grp->fd >= 0) {
+		fd = perf_event_open(pfm_event, -1, cpu, grp->fd, 0);
+		if (fd >= 0) {
+			*pos = grp->num++;
+			return fd;
+		}
+	}
+	return perf_event_open(pfm_event, -1, cpu, -1, 0);
+}
+
 static int activatecpu(unsigned int cpu, unsigned int *supported_counters)
 {
 	struct perf_event_attr pfm_event;
@@ -241,6 +305,12 @@ static int activatecpu(unsigned int cpu, unsigned int *supported_counters)
 		return -1;
 	}
 	/* activate CPU-MF */
+	for (i = 0; i < ALL_COUNTER; ++i) {
+		if (ctr_state[i] != UNSUPPORTED) {
+			open_group(&ppc->cpumf_grp, cpu);
+			break;
+		}
+	}
 	for (i = 0; i < ALL_COUNTER; ++i) {
 		if (ctr_state[i] == UNSUPPORTED)
 			continue;
@@ -253,12 +323,8 @@ static int activatecpu(unsigned int cpu, unsigned int *supported_counters)
 		 * the counter event should start disabled
 		 */
 		pfm_event.disabled = ctr_state[i] == DISABLED;
-		fd = perf_event_open(
-			&pfm_event,
-			-1,  /* pid -1 means all processes */
-			cpu,
-			-1,  /* group filedescriptor */
-			0);  /* flags */
+		fd = open_member(&pfm_event, cpu, &ppc->cpumf_grp,
+				 &ppc->ctr_pos[i]);
 		if (fd < 0) {
 			eprint("Perf_event_open() failed with errno=%d [%s]\n",
 				errno, strerror(errno));
@@ -273,6 +339,7 @@ static int activatecpu(unsigned int cpu, unsigned int *supported_counters)
 	   (ctr_state[PAI_USER] == UNSUPPORTED) ==
 	   (ctr_state[PAI_KERNEL] == UNSUPPORTED) */
 	if (ctr_state[PAI_USER] != UNSUPPORTED) {
+		open_group(&ppc->pai_grp, cpu);
 		for (i = 1; i <= MAX_NUM_PAI; ++i) {
 			if (is_user_space(i - 1) != KERNEL_AND_USER_COUNTER ||
 			    supported_counters[i - 1] != 1)
@@ -284,7 +351,8 @@ static int activatecpu(unsigned int cpu, unsigned int *supported_counters)
 			pfm_event.exclude_kernel = 1;
 			pfm_event.exclude_user = 0;
 			pfm_event.disabled = ctr_state[PAI_USER] == DISABLED;
-			fd = perf_event_open(&pfm_event, -1, cpu, -1, 0);
+			fd = open_member(&pfm_event, cpu, &ppc->pai_grp,
+					 &ppc->pai_user_pos[i - 1]);
 			if (fd < 0) {
 				eprint("Perf_event_open() failed with errno=%d [%s]\n",
 					errno, strerror(errno));
@@ -298,7 +366,8 @@ static int activatecpu(unsigned int cpu, unsigned int *supported_counters)
 			pfm_event.exclude_kernel = 0;
 			pfm_event.exclude_user = 1;
 			pfm_event.disabled = ctr_state[PAI_KERNEL] == DISABLED;
-			fd = perf_event_open(&pfm_event, -1, cpu, -1, 0);
+			fd = open_member(&pfm_event, cpu, &ppc->pai_grp,
+					 &ppc->pai_kernel_pos[i - 1]);
 			if (fd < 0) {
 				eprint("Perf_event_open() failed with errno=%d [%s]\n",
 					errno, strerror(errno));
@@ -325,7 +394,8 @@ static int activatecpu(unsigned int cpu, unsigned int *supported_counters)
 			pfm_event.exclude_kernel = 0;
 			pfm_event.exclude_user = 1;
 			pfm_event.disabled = ctr_state[PAI_KERNEL] == DISABLED;
-			fd = perf_event_open(&pfm_event, -1, cpu, -1, 0);
+			fd = open_member(&pfm_event, cpu, &ppc->pai_grp,
+					 &ppc->pai_kernel_pos[i - 1]);
 			if (fd < 0) {
 				eprint("Perf_event_open() failed with errno=%d [%s]\n",
 					errno, strerror(errno));
@@ -350,19 +420,12 @@ outevents:
 static void deactivatecpu(unsigned int cpunum)
 {
 	struct percpucounter *pcpu;
-	int i;
 
 	if (pthread_mutex_lock(&rootmux))
 		return;
 	pcpu = findcpu(cpunum, 1);
 	if (pcpu != NULL) {
-		for (i = 0; i < ALL_COUNTER; ++i)
-			(void)close(pcpu->ctr_fds[i]);
-		for (i = 0; i < MAX_NUM_PAI; ++i) {
-			(void)close(pcpu->pai_user[i]);
-			(void)close(pcpu->pai_kernel[i]);
-		}
-		free(pcpu);
+		freepercpucounter(pcpu);
 		if (enabledcounter)
 			hotplugdetected = 1;
 	}
@@ -778,12 +841,81 @@ int perf_reset_ctr(enum ctr_e ctr, uint64_t *value, unsigned int
 }
 
 
+/*
+ * Read group grp into buf: The number of events followed by the value of
+ * the leader and the values of the counters in the order of their positions
+ */
+static int read_group(struct ctrgroup *grp, uint64_t *buf)
+{
+	ssize_t len = (grp->num + 1) * sizeof(uint64_t);
+
+	if (read(grp->fd, buf, len) != len) {
+		eprint("Read() on perf group file descriptor failed with errno=%d [%s]\n",
+		       errno, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Add the value of counter fd at position pos in the group values to
+ * value, where grpvalues starts with the value of the leader. Counters
+ * outside of the group are read on their own.
+ */
+static int add_member(int fd, unsigned short pos, uint64_t *grpvalues,
+		      uint64_t *value)
+{
+	uint64_t val;
+
+	if (pos) {
+		*value += grpvalues[pos];
+		return 0;
+	}
+	if (read(fd, &val, sizeof(val)) != sizeof(val)) {
+		eprint("Read() on perf file descriptor failed with errno=%d [%s]\n",
+		       errno, strerror(errno));
+		return -1;
+	}
+	*value += val;
+	return 0;
+}
+
+/*
+ * Sum up the CPU-MF counters of all CPUs in values, which has room for
+ * ALL_COUNTER values
+ */
+int perf_read_ctrs(uint64_t *values)
+{
+	uint64_t grpvalues[GROUP_BUF_SIZE];
+	struct percpucounter *pcpu;
+	int i, rc = 0;
+
+	memset(values, 0, ALL_COUNTER * sizeof(*values));
+
+	foreachcpu(pcpu) {
+		if (pcpu->cpumf_grp.fd >= 0 &&
+		    read_group(&pcpu->cpumf_grp, grpvalues) != 0) {
+			rc = -1;
+			continue;
+		}
+		for (i = 0; i < ALL_COUNTER; ++i) {
+			if (pcpu->ctr_fds[i] < 0)
+				continue;
+			if (add_member(pcpu->ctr_fds[i], pcpu->ctr_pos[i],
+				       grpvalues + 1, &values[i]) != 0)
+				rc = -1;
+		}
+	}
+	endforeachcpu();
+
+	return rc;
+}
+
 int perf_read_ctr(enum ctr_e ctr, uint64_t *value, unsigned int
 				  *supported_counters)
 {
-	struct percpucounter *pcpu;
-	int ec, rc = 0;
-	uint64_t val;
+	uint64_t values[ALL_COUNTER];
+	int rc;
 
 	if (!value)
 		return -1;
@@ -816,19 +948,9 @@ int perf_read_ctr(enum ctr_e ctr, uint64_t *value, unsigned int
 	}
 	if (ctr >= ALL_COUNTER)
 		return -1;
-	*value = 0;
 
-	foreachcpu(pcpu) {
-		ec = read(pcpu->ctr_fds[ctr], &val, sizeof(val));
-		if (ec != sizeof(val)) {
-			eprint("Read() on perf file descriptor failed with errno=%d [%s]\n",
-			       errno, strerror(errno));
-			rc = -1;
-		} else {
-			*value += val;
-		}
-	}
-	endforeachcpu();
+	rc = perf_read_ctrs(values);
+	*value = values[ctr];
 
 	return rc;
 }
@@ -845,27 +967,33 @@ int perf_ctr_state(enum ctr_e ctr) {
 }
 
 
-int perf_read_pai_ctr(unsigned int ctrnum, int user, uint64_t *value)
+/*
+ * Sum up the user or kernel space PAI counters of all CPUs in values,
+ * which has room for MAX_NUM_PAI values
+ */
+int perf_read_pai_ctrs(int user, uint64_t *values)
 {
+	uint64_t grpvalues[GROUP_BUF_SIZE];
 	struct percpucounter *pcpu;
-	int *arr, ec, rc = 0;
-	uint64_t val;
-
-	*value = 0;
+	unsigned short *pos;
+	int i, *arr, rc = 0;
 
-	if (is_user_space(ctrnum) == SUPPRESS_COUNTER ||
-	    (user && is_user_space(ctrnum) == KERNEL_ONLY_COUNTER))
-		return -1;
+	memset(values, 0, MAX_NUM_PAI * sizeof(*values));
 
 	foreachcpu(pcpu) {
-		arr = user ? pcpu->pai_user : pcpu->pai_kernel;
-		ec = read(arr[ctrnum], &val, sizeof(val));
-		if (ec != sizeof(val)) {
-			eprint("Read() on perf file descriptor failed with errno=%d [%s]\n",
-			       errno, strerror(errno));
+		if (pcpu->pai_grp.fd >= 0 &&
+		    read_group(&pcpu->pai_grp, grpvalues) != 0) {
 			rc = -1;
-		} else {
-			*value += val;
+			continue;
+		}
+		arr = user ? pcpu->pai_user : pcpu->pai_kernel;
+		pos = user ? pcpu->pai_user_pos : pcpu->pai_kernel_pos;
+		for (i = 0; i < MAX_NUM_PAI; ++i) {
+			if (arr[i] < 0)
+				continue;
+			if (add_member(arr[i], pos[i], grpvalues + 1,
+				       &values[i]) != 0)
+				rc = -1;
 		}
 	}
 	endforeachcpu();
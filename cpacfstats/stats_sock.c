@@ -206,6 +206,12 @@ int send_msg(int sfd, struct msg *m, int timeout)
 	case ANSWER:
 		len += sizeof(m->answer);
 		break;
+	case BATCH:
+		len += sizeof(m->batch);
+		break;
+	case SUBSCRIBE:
+		len += sizeof(m->subscribe);
+		break;
 	default:
 		eprint("Unknown type %d\n", m->head.m_type);
 		return -1;
@@ -240,6 +246,12 @@ int recv_msg(int sfd, struct msg *m, int timeout)
 	case ANSWER:
 		len = sizeof(m->answer);
 		break;
+	case BATCH:
+		len = sizeof(m->batch);
+		break;
+	case SUBSCRIBE:
+		len = sizeof(m->subscribe);
+		break;
 	default:
 		eprint("Unknown type %d\n", m->head.m_type);
 		return -1;
@@ -255,3 +267,67 @@ int recv_msg(int sfd, struct msg *m, int timeout)
 
 	return 0;
 }
+
+/*
+ * Send a batch message with all its answers in one write
+ */
+int send_batch(int sfd, struct msg_batch_buf *b, int timeout)
+{
+	int n, len;
+
+	if (b->batch.m_cnt > MAX_NUM_BATCH) {
+		eprint("Too many answers in batch: %u\n", b->batch.m_cnt);
+		return -1;
+	}
+	b->head.m_type = BATCH;
+	len = sizeof(b->head) + sizeof(b->batch) +
+		b->batch.m_cnt * sizeof(b->answer[0]);
+
+	n = timeout ? __timedwrite(sfd, b, len, timeout) : __write(sfd, b, len);
+	if (n != len) {
+		eprint("Write() error: write()=%d expected %d, errno=%d [%s]\n",
+		       n, len, errno, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Receive a batch message with all its answers
+ * Returns 1 if the connection was closed before the batch message
+ */
+int recv_batch(int sfd, struct msg_batch_buf *b, int timeout)
+{
+	int n, len;
+
+	len = sizeof(b->head) + sizeof(b->batch);
+	n = timeout ? __timedread(sfd, b, len, timeout) : __read(sfd, b, len);
+	if (n == 0)
+		return 1;
+	if (n != len) {
+		eprint("Recv() error: read()=%d expected %d, errno=%d [%s]\n",
+		       n, len, errno, strerror(errno));
+		return -1;
+	}
+	if (b->head.m_type != BATCH) {
+		eprint("Received msg with wrong type %d != %d\n",
+		       b->head.m_type, BATCH);
+		return -1;
+	}
+	if (b->batch.m_cnt > MAX_NUM_BATCH) {
+		eprint("Too many answers in batch: %u\n", b->batch.m_cnt);
+		return -1;
+	}
+
+	len = b->batch.m_cnt * sizeof(b->answer[0]);
+	n = timeout ? __timedread(sfd, b->answer, len, timeout) :
+		__read(sfd, b->answer, len);
+	if (n != len) {
+		eprint("Recv() error: recv()=%d expected %d, errno=%d [%s]\n",
+		       n, len, errno, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
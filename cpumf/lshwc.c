@@ -39,6 +39,7 @@
 #include "lib/util_scandir.h"
 #include "lib/util_libc.h"
 #include "lib/util_file.h"
+#include "lib/util_fmt.h"
 #include "lib/libcpumf.h"
 
 #include "lshwc.h"
@@ -47,13 +48,51 @@
 #define CPUS_POSSIBLE	"/sys/devices/system/cpu/possible"
 #define CPUS_KERNELMAX	"/sys/devices/system/cpu/kernel_max"
 #define MAXCTRS		512
+#define MAXGROUPS	64
 #define IOCTLSLEEP	60U
+#define OPT_FORMAT	0x80	/* First non-printable character */
+#define FMT_API_LEVEL	1
 
 static unsigned int read_interval = IOCTLSLEEP;
 static int cfvn, csvn, authorization;
 static unsigned long loop_count = 1;
 static unsigned char *ioctlbuffer;
-static bool allcpu;
+static bool allcpu, delta, metrics;
+static bool fmt_specified;
+static enum util_fmt_t fmt;
+
+static cpu_set_t groups[MAXGROUPS];	/* CPU groups for aggregated lines */
+static unsigned int group_cnt;
+
+/* Numbers of the counters read, built on each output */
+static unsigned int ctrhit[MAXCTRS];
+static unsigned int ctrhit_cnt;
+static bool header_shown;		/* CSV header printed for counter sets */
+static char *ctrkey[MAXCTRS];		/* Keys for formatted output */
+
+/* Counter values of one output line, indexed by counter number */
+static unsigned long row[MAXCTRS];
+
+/* Derived metrics: Counter num divided by counter den, times scale */
+static const struct metric {
+	const char *name;	/* Metric name */
+	unsigned int num;	/* Counter number of numerator */
+	unsigned int den;	/* Counter number of denominator */
+	unsigned int scale;	/* Scale factor */
+} metric_tab[] = {
+	/* CPU_CYCLES per INSTRUCTIONS */
+	{ "CPI", 0, 1, 1 },
+	/* L1I_DIR_WRITES per 1000 INSTRUCTIONS */
+	{ "L1I_MPKI", 2, 1, 1000 },
+	/* L1I_PENALTY_CYCLES per INSTRUCTIONS */
+	{ "L1I_PENALTY_CPI", 3, 1, 1 },
+	/* L1D_DIR_WRITES per 1000 INSTRUCTIONS */
+	{ "L1D_MPKI", 4, 1, 1000 },
+	/* L1D_PENALTY_CYCLES per INSTRUCTIONS */
+	{ "L1D_PENALTY_CPI", 5, 1, 1 },
+	/* PROBLEM_STATE_CPU_CYCLES per PROBLEM_STATE_INSTRUCTIONS */
+	{ "PROBLEM_STATE_CPI", 32, 33, 1 },
+};
 
 static unsigned int max_possible_cpus;	/* No of possible CPUs */
 static struct ctrname {		/* List of defined counters */
@@ -61,6 +100,7 @@ static struct ctrname {		/* List of defined counters */
 	bool hitcnt;		/* Counter number read from ioctl() */
 	unsigned long total;	/* Total counter value */
 	unsigned long *ccv;	/* Per CPU counter value */
+	unsigned long *pcv;	/* Per CPU counter value of previous read */
 } ctrname[MAXCTRS];
 
 static bool read_counternames(void)
@@ -94,6 +134,8 @@ static void free_counternames(void)
 	for (size_t i = 0; i < ARRAY_SIZE(ctrname); ++i) {
 		free(ctrname[i].name);
 		free(ctrname[i].ccv);
+		free(ctrname[i].pcv);
+		free(ctrkey[i]);
 	}
 }
 
@@ -298,66 +340,145 @@ static bool check_setpossible(void)
 	return true;
 }
 
-static void show_header(void)
+/* Build the vector of counters read and their keys. */
+static void build_ctrhit(void)
+{
+	ctrhit_cnt = 0;
+	for (unsigned int i = 0; i < ARRAY_SIZE(ctrname); ++i) {
+		if (!ctrname[i].hitcnt)
+			continue;
+		ctrhit[ctrhit_cnt++] = i;
+		if (!fmt_specified || ctrkey[i])
+			continue;
+		if (ctrname[i].name)
+			ctrkey[i] = util_strdup(ctrname[i].name);
+		else
+			util_asprintf(&ctrkey[i], "Counter%u", i);
+		util_fmt_add_key("%s", ctrkey[i]);
+	}
+}
+
+/* Is the metric available for the counters read? */
+static bool metric_available(const struct metric *m)
 {
-	static bool header;
-	bool comma = false;
+	return metrics && ctrname[m->num].hitcnt && ctrname[m->den].hitcnt;
+}
 
-	if (header)
+static void show_header(void)
+{
+	build_ctrhit();
+	if (header_shown || fmt_specified)
 		return;			/* Printed already */
-	printf("Date,Time,CPU,");	/* Print counter name and number */
-	for (size_t i = 0; i < ARRAY_SIZE(ctrname); ++i) {
-		if (!ctrname[i].hitcnt)
+	printf("Date,Time,CPU");	/* Print counter name and number */
+	for (unsigned int i = 0; i < ctrhit_cnt; ++i)
+		printf(",%s(%u)", ctrname[ctrhit[i]].name ?: "Counter",
+		       ctrhit[i]);
+	for (size_t i = 0; i < ARRAY_SIZE(metric_tab); ++i) {
+		if (metric_available(&metric_tab[i]))
+			printf(",%s", metric_tab[i].name);
+	}
+	putchar('\n');
+	header_shown = true;
+}
+
+/* Fill row with counter values of one CPU. */
+static void row_cpu(unsigned int cpu)
+{
+	for (unsigned int i = 0; i < ctrhit_cnt; ++i) {
+		struct ctrname *c = &ctrname[ctrhit[i]];
+
+		row[ctrhit[i]] = c->ccv ? c->ccv[cpu] : 0;
+	}
+}
+
+/* Fill row with the sum of the counter values of the CPUs in set. */
+static void row_group(cpu_set_t *set)
+{
+	for (unsigned int i = 0; i < ctrhit_cnt; ++i) {
+		struct ctrname *c = &ctrname[ctrhit[i]];
+		unsigned long sum = 0;
+
+		for (unsigned int h = 0; c->ccv && h < max_possible_cpus &&
+					 h < CPU_SETSIZE; ++h) {
+			if (check[h].cpu_hit && CPU_ISSET(h, set))
+				sum += c->ccv[h];
+		}
+		row[ctrhit[i]] = sum;
+	}
+}
+
+/* Fill row with the total counter values of all CPUs. */
+static void row_total(void)
+{
+	for (unsigned int i = 0; i < ctrhit_cnt; ++i)
+		row[ctrhit[i]] = ctrname[ctrhit[i]].total;
+}
+
+static void row_print(char *header, const char *name)
+{
+	const struct metric *m;
+
+	if (fmt_specified) {
+		util_fmt_obj_start(FMT_ROW, NULL);
+		util_fmt_pair(FMT_QUOTE, "cpu", "%s", name);
+		for (unsigned int i = 0; i < ctrhit_cnt; ++i)
+			util_fmt_pair(FMT_DEFAULT, ctrkey[ctrhit[i]], "%lu",
+				      row[ctrhit[i]]);
+		for (size_t i = 0; i < ARRAY_SIZE(metric_tab); ++i) {
+			m = &metric_tab[i];
+			if (!metric_available(m))
+				continue;
+			if (row[m->den])
+				util_fmt_pair(FMT_DEFAULT, m->name, "%.3f",
+					      (double)row[m->num] * m->scale /
+					      row[m->den]);
+			else
+				util_fmt_pair(FMT_INVAL, m->name, "");
+		}
+		util_fmt_obj_end();
+		return;
+	}
+	printf("%s%s", header, name);
+	for (unsigned int i = 0; i < ctrhit_cnt; ++i)
+		printf(",%lu", row[ctrhit[i]]);
+	for (size_t i = 0; i < ARRAY_SIZE(metric_tab); ++i) {
+		m = &metric_tab[i];
+		if (!metric_available(m))
 			continue;
-		if (comma)
+		if (row[m->den])
+			printf(",%.3f", (double)row[m->num] * m->scale /
+			       row[m->den]);
+		else
 			putchar(',');
-		printf("%s(%ld)", ctrname[i].name ?: "Counter", i);
-		comma = true;
 	}
 	putchar('\n');
-	header = true;
 }
 
 static void line(char *header)
 {
-	bool comma;
+	char txt[16];
 
 	show_header();
 	if (allcpu) {
 		for (unsigned int h = 0; h < max_possible_cpus; ++h) {
-			char txt[16];
-
 			if (!check[h].cpu_hit)
 				continue;
-			comma = false;
-			snprintf(txt, sizeof(txt), "CPU%d,", h);
-			printf("%s%s", header, txt);
-			for (size_t i = 0; i < ARRAY_SIZE(ctrname); ++i) {
-				if (!ctrname[i].hitcnt)
-					continue;
-				if (comma)
-					putchar(',');
-				printf("%ld", ctrname[i].ccv[h]);
-				comma = true;
-			}
-			putchar('\n');
+			snprintf(txt, sizeof(txt), "CPU%d", h);
+			row_cpu(h);
+			row_print(header, txt);
 		}
 	}
+	for (unsigned int g = 0; g < group_cnt; ++g) {
+		snprintf(txt, sizeof(txt), "Group%u", g + 1);
+		row_group(&groups[g]);
+		row_print(header, txt);
+	}
 
 	/* Print total count of all CPUs */
-	printf("%sTotal,", header);
-	comma = false;
-	for (size_t i = 0; i < ARRAY_SIZE(ctrname); ++i) {
-		if (!ctrname[i].hitcnt)
-			continue;
-		if (comma)
-			putchar(',');
-		printf("%ld", ctrname[i].total);
-		comma = true;
-		ctrname[i].total = 0;
-		ctrname[i].hitcnt = false;
-	}
-	putchar('\n');
+	row_total();
+	row_print(header, "Total");
+	for (unsigned int i = 0; i < ctrhit_cnt; ++i)
+		ctrname[ctrhit[i]].total = 0;
 }
 
 static void show(void)
@@ -367,8 +488,22 @@ static void show(void)
 	char now_text[32];
 
 	now_tm = localtime(&now);
-	strftime(now_text, sizeof(now_text), "%F,%T,", now_tm);
-	line(now_text);
+	if (fmt_specified) {
+		util_fmt_obj_start(FMT_DEFAULT, NULL);
+		strftime(now_text, sizeof(now_text), "%F", now_tm);
+		util_fmt_pair(FMT_QUOTE | FMT_PERSIST, "date", "%s", now_text);
+		strftime(now_text, sizeof(now_text), "%T", now_tm);
+		util_fmt_pair(FMT_QUOTE | FMT_PERSIST, "time", "%s", now_text);
+		util_fmt_obj_start(FMT_LIST, "cpus");
+		line(NULL);
+		util_fmt_obj_end();
+		util_fmt_obj_end();
+	} else {
+		strftime(now_text, sizeof(now_text), "%F,%T,", now_tm);
+		line(now_text);
+	}
+	/* Allow immediate consumption of each read through pipes */
+	fflush(stdout);
 }
 
 /* Return Counter set size numbers (in counters) */
@@ -442,17 +577,25 @@ static bool add_countervalue(size_t idx, unsigned int cpu, unsigned long value)
 		warnx("Invalid CPU number %d", cpu);
 		return false;
 	}
-	if (!ctrname[idx].ccv)		/* Unknown counter */
-		ctrname[idx].ccv = calloc(max_possible_cpus,
-					  sizeof(unsigned long));
-	if (ctrname[idx].ccv)
-		ctrname[idx].ccv[cpu] = value;
+	if (!ctrname[idx].ccv) {	/* Unknown counter */
+		ctrname[idx].ccv = util_zalloc(max_possible_cpus *
+					       sizeof(unsigned long));
+		ctrname[idx].pcv = util_zalloc(max_possible_cpus *
+					       sizeof(unsigned long));
+	}
+	if (delta) {			/* Difference to previous read */
+		unsigned long prev = ctrname[idx].pcv[cpu];
+
+		ctrname[idx].pcv[cpu] = value;
+		value -= prev;
+	}
+	ctrname[idx].ccv[cpu] = value;
 	ctrname[idx].total += value;
 	ctrname[idx].hitcnt = true;
 	return true;
 }
 
-static int test_read(struct s390_hwctr_read *read)
+static int test_read(struct s390_hwctr_read *read, bool output)
 {
 	void *base = &read->data;
 	size_t offset = 0;
@@ -460,6 +603,8 @@ static int test_read(struct s390_hwctr_read *read)
 	/* Clear previous hit counters */
 	for (unsigned int i = 0; i < max_possible_cpus; ++i)
 		check[i].cpu_hit = false;
+	for (size_t i = 0; i < ARRAY_SIZE(ctrname); ++i)
+		ctrname[i].hitcnt = false;
 
 	/* Iterate over all CPUs */
 	for (unsigned int i = 0; i < read->no_cpus; ++i) {
@@ -493,7 +638,11 @@ static int test_read(struct s390_hwctr_read *read)
 			}
 		}
 	}
-	show();
+	if (output)
+		show();
+	else
+		for (size_t i = 0; i < ARRAY_SIZE(ctrname); ++i)
+			ctrname[i].total = 0;
 	return 0;
 }
 
@@ -524,7 +673,7 @@ static int do_start(int ioctlfd, struct s390_hwctr_start *start)
 	return rc;
 }
 
-static int do_read(int ioctlfd)
+static int do_read(int ioctlfd, bool output)
 {
 	size_t ioctlbuffer_len = PAGE_SIZE * max_possible_cpus +
 				 sizeof(struct s390_hwctr_read);
@@ -536,29 +685,32 @@ static int do_read(int ioctlfd)
 	read = (struct s390_hwctr_read *)ioctlbuffer;
 	rc = ioctl(ioctlfd, S390_HWCTR_READ, read);
 	if (!rc)
-		rc = test_read(read);
+		rc = test_read(read, output);
 	else
 		warn("ioctl S390_HWCTR_READ");
 	return rc;
 }
 
-static void do_sleep(void)
+/* Sleep until the next interval starts. The intervals are based on the
+ * previous wakeup time, so that the read operations do not drift.
+ */
+static void do_sleep(struct timespec *next)
 {
-	struct timespec req = {
-		.tv_sec = read_interval,
-		.tv_nsec = 0
-	};
-
-	nanosleep(&req, NULL);
+	next->tv_sec += read_interval;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, next, NULL) ==
+	       EINTR)
+		;
 }
 
 /* Execute commands and report first error */
 static int do_it(char *s)
 {
 	struct s390_hwctr_start start;
+	struct timespec next;
 	int ioctlfd;
 	int rc;
 
+	header_shown = false;		/* New header for each counter set */
 	memset(&start, 0, sizeof(start));
 	rc = max_possible_cpus / sizeof(uint64_t);
 	start.cpumask = alloca(max_possible_cpus / sizeof(uint64_t));
@@ -575,14 +727,20 @@ static int do_it(char *s)
 		return EXIT_FAILURE;
 	}
 
-	for (unsigned long i = 0; !rc && i < loop_count; ++i) {
-		rc = do_read(ioctlfd);
+	/* For deltas the first read only provides the start values */
+	if (delta && do_read(ioctlfd, false)) {
+		close(ioctlfd);
+		return EXIT_FAILURE;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for (unsigned long i = 0; !loop_count || i < loop_count; ++i) {
+		if (read_interval && (delta || i))
+			do_sleep(&next);
+		rc = do_read(ioctlfd, true);
 		if (rc) {
 			close(ioctlfd);
 			return EXIT_FAILURE;
 		}
-		if (read_interval && i + 1 < loop_count)
-			do_sleep();
 	}
 	rc = do_stop(ioctlfd);
 	close(ioctlfd);
@@ -605,6 +763,25 @@ static struct util_opt opt_vec[] = {
 		.argument = "NUMBER",
 		.desc = "Specifies interval between read operations (seconds)"
 	},
+	{
+		.option = { "delta", no_argument, NULL, 'd' },
+		.desc = "Displays counter value changes since previous read"
+	},
+	{
+		.option = { "metrics", no_argument, NULL, 'm' },
+		.desc = "Displays metrics derived from counter values"
+	},
+	{
+		.option = { "group", required_argument, NULL, 'g' },
+		.argument = "CPULIST",
+		.desc = "Displays sum of counter values of CPUs in CPULIST"
+	},
+	{
+		.option = { "format", required_argument, NULL, OPT_FORMAT },
+		.argument = "FORMAT",
+		.flags = UTIL_OPT_FLAG_NOSHORT,
+		.desc = "List data in specified FORMAT (json json-seq pairs)"
+	},
 	UTIL_OPT_HELP,
 	UTIL_OPT_VERSION,
 	UTIL_OPT_END
@@ -622,6 +799,25 @@ static const struct util_prg prg = {
 	}
 };
 
+static void fmt_init(void)
+{
+	unsigned int flags = FMT_DEFAULT;
+
+	/* Ensure correct JSON even if interrupted */
+	if (fmt == FMT_JSON || fmt == FMT_JSONSEQ)
+		flags |= FMT_HANDLEINT;
+	util_fmt_init(stdout, fmt, flags, FMT_API_LEVEL);
+	if (fmt != FMT_JSONSEQ)
+		util_fmt_obj_start(FMT_LIST, NULL);
+}
+
+static void fmt_exit(void)
+{
+	if (fmt != FMT_JSONSEQ)
+		util_fmt_obj_end();
+	util_fmt_exit();
+}
+
 /* Check for hardware support and exit if not available */
 static void have_support(void)
 {
@@ -668,6 +864,26 @@ int main(int argc, char **argv)
 		case 'a':
 			allcpu = true;
 			break;
+		case 'd':
+			delta = true;
+			break;
+		case 'm':
+			metrics = true;
+			break;
+		case 'g':
+			if (group_cnt == MAXGROUPS)
+				errx(EXIT_FAILURE, "Too many CPU groups");
+			if (libcpumf_cpuset(optarg, &groups[group_cnt++]))
+				errx(EXIT_FAILURE, "Cannot use CPU list %s",
+				     optarg);
+			break;
+		case OPT_FORMAT:
+			if (!util_fmt_name_to_type(optarg, &fmt) ||
+			    fmt == FMT_CSV)
+				errx(EXIT_FAILURE, "Unsupported format %s",
+				     optarg);
+			fmt_specified = true;
+			break;
 		}
 	}
 
@@ -681,6 +897,8 @@ int main(int argc, char **argv)
 		return EXIT_FAILURE;
 	}
 
+	if (fmt_specified)
+		fmt_init();
 	if (optind >= argc) {
 		ch = do_it(NULL);
 	} else {
@@ -690,6 +908,8 @@ int main(int argc, char **argv)
 				break;
 		}
 	}
+	if (fmt_specified)
+		fmt_exit();
 	free_counternames();
 	free(check);
 	return ch;
@@ -13,6 +13,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <pthread.h>
 #include <sched.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -22,8 +23,10 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
 #include <sys/time.h>
@@ -33,6 +36,7 @@
 
 #include "lib/util_base.h"
 #include "lib/util_file.h"
+#include "lib/util_fmt.h"
 #include "lib/util_libc.h"
 #include "lib/util_list.h"
 #include "lib/util_opt.h"
@@ -45,7 +49,14 @@
 #define S390_EVT_PAI_CRYPTO	0x1000
 #define S390_EVT_PAI_NNPA	0x1800
 
-/* Default values for select() timeout: 1 second */
+/* Size of the output buffer of each event. Ring buffer data is collected
+ * there and written to the event file in large chunks.
+ */
+#define PAI_OUTBUF_SIZE		(256 * 1024)
+/* Maximum number of events returned by one epoll_wait() call */
+#define PAI_EPOLL_EVENTS	64
+
+/* Default values for epoll_wait() timeout: 1 second */
 static unsigned long read_interval = 1000;
 /* Size of mapped perf event ring buffer in 4KB pages.
  * It must be power of two and >= 4 which is the
@@ -57,7 +68,18 @@ static cpu_set_t cpu_online_mask;
 static int verbose, humantime;
 static struct util_list list_pai_event;
 static struct util_list list_pmu_event;
-static bool summary;
+static bool summary, threads;
+
+/* Settings for aggregated report */
+#define OPT_FORMAT		0x80	/* First non-printable character */
+#define AGGR_TAB_SIZE_MIN	64
+#define AGGR_API_LEVEL		1
+
+static bool aggregate, fmt_specified;
+static enum util_fmt_t fmt;
+static unsigned long bucket_ms = 1000;
+static unsigned long top_cnt = 10;
+static unsigned long jobs;
 
 /* System call to perf_event_open(2) */
 static long perf_event_open(struct perf_event_attr *hw_event, pid_t pid,
@@ -162,6 +184,8 @@ static void ev_deinstall(void)
 		if (p->file_fd >= 0)
 			close(p->file_fd);
 		p->file_fd = -1;
+		free(p->buf);
+		p->buf = NULL;
 	}
 }
 
@@ -209,6 +233,8 @@ static void ev_mapevent(struct pai_event *p)
 	if (write(p->file_fd, &p->attr, sizeof(p->attr)) == -1)
 		err(EXIT_FAILURE, "write error for event %lld CPU %d",
 		    p->attr.config, p->cpu);
+	p->buf = util_malloc(PAI_OUTBUF_SIZE);
+	p->buf_len = 0;
 }
 
 /* Install one event using perf_event_open system call. */
@@ -240,34 +266,63 @@ static void ev_install(int group)
 	}
 }
 
-/* Return pointer to event for a given perf event file descriptor returned
- * by the perf_event_open system call.
- */
-static struct pai_event *perffd_2_event(int fd)
+/* Write all data to the event file. */
+static void ev_write_file(struct pai_event *p, void *data, size_t len)
 {
-	struct pai_event *p;
+	ssize_t rc;
+
+	while (len) {
+		rc = write(p->file_fd, data, len);
+		if (rc == -1) {
+			if (errno == EINTR)
+				continue;
+			err(EXIT_FAILURE, "write error for event file %s",
+			    p->file_name);
+		}
+		data += rc;
+		len -= rc;
+	}
+}
 
-	util_list_iterate(&list_pai_event, p)
-		if (p->fd == fd)
-			return p;
-	return NULL;
+/* Write the output buffer to the event file. */
+static void ev_flush(struct pai_event *p)
+{
+	ev_write_file(p, p->buf, p->buf_len);
+	p->buf_len = 0;
+}
+
+/* Append data to the output buffer of the event. Data larger than the
+ * output buffer is written directly.
+ */
+static void ev_write(struct pai_event *p, void *data, size_t len)
+{
+	if (p->buf_len + len > PAI_OUTBUF_SIZE)
+		ev_flush(p);
+	if (len >= PAI_OUTBUF_SIZE) {
+		ev_write_file(p, data, len);
+		return;
+	}
+	memcpy(p->buf + p->buf_len, data, len);
+	p->buf_len += len;
 }
 
 /* Read the perf event ring buffer and write output to a file.
  * The file contents is interpreted later after the data collection
  * phase.
  */
-static int savemap(int fd, void *data, struct data_pos *dp)
+static int savemap(struct pai_event *p, void *data, struct data_pos *dp)
 {
-	unsigned long d_head_old, d_head = dp->data_head;
+	unsigned long d_head_old, d_head;
 	unsigned long d_prev = dp->data_tail;
-	int diff = d_head - d_prev;
-	int wrapped;
+	int diff, wrapped;
 
+	/* Pairs with the kernel's write barrier before updating data_head */
+	d_head = __atomic_load_n(&dp->data_head, __ATOMIC_ACQUIRE);
+	diff = d_head - d_prev;
 	d_head_old = d_head;
 	if (verbose) {
-		printf("Data head:%#llx tail:%#llx offset:%#llx size:%#llx\n",
-		       dp->data_head, dp->data_tail, dp->data_offset,
+		printf("Data head:%#lx tail:%#llx offset:%#llx size:%#llx\n",
+		       d_head, dp->data_tail, dp->data_offset,
 		       dp->data_size);
 	}
 	if (!diff)
@@ -288,79 +343,194 @@ static int savemap(int fd, void *data, struct data_pos *dp)
 			printf("Write %d bytes [%ld,%lld)\n", part2, d_prev,
 			       dp->data_size);
 		}
-		if (write(fd, data + d_prev, part2) == -1)
-			err(EXIT_FAILURE, "write error for event file");
+		ev_write(p, data + d_prev, part2);
 		d_prev = 0;		/* Start at position zero */
 	}
 	if (verbose)
 		printf("Write %d bytes [%ld,%ld)\n", diff, d_prev, d_head);
-	if (write(fd, data + d_prev, diff) == -1)
-		err(EXIT_FAILURE, "write error for event file");
+	ev_write(p, data + d_prev, diff);
 
-	dp->data_tail = d_head_old;	/* Write last read position */
+	/* Data is copied, the kernel may overwrite it now */
+	__atomic_store_n(&dp->data_tail, d_head_old, __ATOMIC_RELEASE);
 	return 0;
 }
 
-static void readmap(int fd)
+static void readmap(struct pai_event *p)
 {
-	struct pai_event *p = perffd_2_event(fd);
 	struct perf_event_mmap_page *area;
 
 	if (verbose) {
-		printf("Ring buffer for fd %d %s(%d)\n", fd, p->file_name,
+		printf("Ring buffer for fd %d %s(%d)\n", p->fd, p->file_name,
 		       p->file_fd);
 	}
 	area = p->map_addr;
-	savemap(p->file_fd, p->map_addr + area->data_offset,
+	savemap(p, p->map_addr + area->data_offset,
 		(struct data_pos *)&area->data_head);
-	syncfs(p->file_fd);
 }
 
-/* Collect the data in the event ring buffers. Since there might be one
- * ring buffer per event, sleep some short time and always read all
- * ring buffer for new contents.
+/* Data collector for the ring buffers of all events or of all events
+ * of one CPU.
  */
-static int collect(unsigned long cnt)
+struct pai_collector {
+	pthread_t thread;	/* Collector thread */
+	int cpu;		/* CPU of events, -1 for all events */
+	int epfd;		/* Epoll file descriptor */
+	int nfds;		/* Number of events in epoll set */
+	unsigned long cnt;	/* Number of read operations */
+	int rc;			/* Return code */
+};
+
+/* Is the event handled by the collector? */
+static bool collector_has_event(struct pai_collector *c, struct pai_event *p)
 {
-	fd_set r_fds, e_fds, a_fds;
+	return p->map_addr && (c->cpu == -1 || c->cpu == p->cpu);
+}
+
+/* Add the ring buffers of the collector's events to its epoll set. */
+static void collector_init(struct pai_collector *c, int cpu,
+			   unsigned long cnt)
+{
+	struct epoll_event ev;
 	struct pai_event *p;
-	struct timeval tv;
-	int rc, max_fd;
 
-	do {
-		rc = -1;
-		max_fd = -1;
-		tv.tv_sec = read_interval / 1000;
-		tv.tv_usec = (1000 * read_interval) % 1000000;
-		FD_ZERO(&r_fds);
-		FD_ZERO(&e_fds);
-		FD_ZERO(&a_fds);
-		util_list_iterate(&list_pai_event, p) {
-			if (p->attr.watermark) {
-				FD_SET(p->fd, &r_fds);
-				FD_SET(p->fd, &e_fds);
-				FD_SET(p->fd, &a_fds);
-				if (p->fd > max_fd)
-					max_fd = p->fd;
-			}
-		}
+	memset(c, 0, sizeof(*c));
+	c->cpu = cpu;
+	c->cnt = cnt;
+	c->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (c->epfd == -1)
+		err(EXIT_FAILURE, "epoll_create1 error");
+	util_list_iterate(&list_pai_event, p) {
+		if (!collector_has_event(c, p))
+			continue;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.ptr = p;
+		if (epoll_ctl(c->epfd, EPOLL_CTL_ADD, p->fd, &ev))
+			err(EXIT_FAILURE, "epoll_ctl error for event %lld CPU %d",
+			    p->attr.config, p->cpu);
+		++c->nfds;
+	}
+}
 
-		if (max_fd == -1)
-			break;
-		rc = select(max_fd + 1, &r_fds, NULL, &e_fds, &tv);
-		if (rc >= 0) {
-			if (rc == 0)
-				/* Termination, trigger final read */
-				r_fds = a_fds;
-			for (int i = 0; i < max_fd + 1; ++i) {
-				if (FD_ISSET(i, &r_fds))
-					readmap(i);
-			}
+/* Read all ring buffers of the collector and write the output buffers. */
+static void collector_drain(struct pai_collector *c)
+{
+	struct pai_event *p;
+
+	util_list_iterate(&list_pai_event, p) {
+		if (!collector_has_event(c, p))
+			continue;
+		readmap(p);
+		ev_flush(p);
+	}
+}
+
+/* Collect the data in the event ring buffers. Ring buffers that reach
+ * their watermark are read immediately. Ring buffers below the watermark
+ * are read when no ring buffer reached its watermark for the read
+ * interval and at the end of the collection.
+ */
+static void *collector_run(void *arg)
+{
+	struct epoll_event evs[PAI_EPOLL_EVENTS];
+	struct pai_collector *c = arg;
+	unsigned long cnt = c->cnt;
+	int rc;
+
+	if (!c->nfds) {
+		c->rc = -1;
+		return NULL;
+	}
+	do {
+		rc = epoll_wait(c->epfd, evs, ARRAY_SIZE(evs), read_interval);
+		if (rc == 0) {
+			/* Timeout, read all ring buffers */
+			collector_drain(c);
+		} else {
+			for (int i = 0; i < rc; ++i)
+				readmap(evs[i].data.ptr);
 		}
 	} while (rc != -1 && --cnt > 0);
+	collector_drain(c);
+	c->rc = rc;
+	return NULL;
+}
+
+/* Start one collector thread for each CPU with events. The thread runs on
+ * the CPU of its events, so the ring buffers are read where they are
+ * written.
+ */
+static int collect_threads(unsigned long cnt)
+{
+	struct pai_collector *cvec;
+	int cpu, ncpu = 0, rc = 0;
+	pthread_attr_t attr;
+	cpu_set_t cpus, set;
+	struct pai_event *p;
+
+	CPU_ZERO(&cpus);
+	util_list_iterate(&list_pai_event, p) {
+		if (p->map_addr)
+			CPU_SET(p->cpu, &cpus);
+	}
+	cvec = util_zalloc(CPU_COUNT(&cpus) * sizeof(*cvec));
+	for (cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+		if (!CPU_ISSET(cpu, &cpus))
+			continue;
+		collector_init(&cvec[ncpu], cpu, cnt);
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		pthread_attr_init(&attr);
+		pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+		errno = pthread_create(&cvec[ncpu].thread, &attr,
+				       collector_run, &cvec[ncpu]);
+		if (errno)
+			err(EXIT_FAILURE, "Cannot create thread for CPU %d",
+			    cpu);
+		pthread_attr_destroy(&attr);
+		++ncpu;
+	}
+	if (!ncpu)
+		rc = -1;
+	for (int i = 0; i < ncpu; ++i) {
+		pthread_join(cvec[i].thread, NULL);
+		if (cvec[i].rc == -1)
+			rc = -1;
+		close(cvec[i].epfd);
+	}
+	free(cvec);
 	return rc;
 }
 
+/* Collect the data in the event ring buffers, either in this thread for
+ * all events or in one thread per CPU.
+ */
+static int collect(unsigned long cnt)
+{
+	struct pai_collector c;
+
+	if (threads)
+		return collect_threads(cnt);
+	collector_init(&c, -1, cnt);
+	collector_run(&c);
+	close(c.epfd);
+	return c.rc;
+}
+
+/* Each event needs file descriptors for the perf event and for its output
+ * file. Raise the limit of open files to support many CPUs.
+ */
+static void raise_nofile(void)
+{
+	struct rlimit rl;
+
+	if (getrlimit(RLIMIT_NOFILE, &rl) || rl.rlim_cur >= rl.rlim_max)
+		return;
+	rl.rlim_cur = rl.rlim_max;
+	if (setrlimit(RLIMIT_NOFILE, &rl) && verbose)
+		warn("Cannot raise limit of open files");
+}
+
 static void lookup_event(__u64 evtnum, __u16 ctr, __u64 value)
 {
 	struct pmu_events *p;
@@ -499,18 +669,20 @@ static void evt_show(__u64 evtnum, const char *evtsel, struct pai_event_out *ev)
 	putchar('\n');
 }
 
-/* Collect the contents of the event ring buffer data which was saved in
- * a file during data collection phase.
+/* Function called for each decoded entry of an event file */
+typedef void (*evt_fct_t)(struct perf_event_attr *pa,
+			  struct pai_event_out *ev, void *arg);
+
+/* Decode the contents of the event ring buffer data which was saved in
+ * a file during data collection phase. Call function fct for each entry.
  */
-static int evt_scan(char *fn, unsigned char *buf, size_t len,
-		    struct perf_event_attr *pa)
+static int evt_decode(char *fn, unsigned char *buf, size_t len,
+		      struct perf_event_attr *pa, evt_fct_t fct, void *arg)
 {
-	const char *evtsel = evt_selector(pa);
 	__u64 sample_type = pa->sample_type;
 	int allcnt = 0, cnt = 0, rawok = 0;
 	struct perf_event_header *hdr;
 	size_t offset = sizeof(*pa);
-	__u64 evtnum = pa->config;
 	struct pai_event_out ev;
 	size_t limit;
 	__u32 *ptr32;
@@ -648,7 +820,7 @@ static int evt_scan(char *fn, unsigned char *buf, size_t len,
 				++rawok;
 			}
 		}
-		evt_show(evtnum, evtsel, &ev);
+		fct(pa, &ev, arg);
 bypass:
 		if (offset != limit) {
 			warnx("%s error at offset:%#zx limit:%#zx",
@@ -803,11 +975,28 @@ static void remove_events(void)
 	}
 }
 
-/* Scan one file which contains event ring buffer output. Print out the
- * entries to stdout.
+static void evt_print(struct perf_event_attr *pa, struct pai_event_out *ev,
+		      void *UNUSED(arg))
+{
+	evt_show(pa->config, evt_selector(pa), ev);
+}
+
+/* Print the contents of the event ring buffer data which was saved in
+ * a file during data collection phase.
+ */
+static int evt_scan(char *fn, unsigned char *buf, size_t len,
+		    struct perf_event_attr *pa, void *UNUSED(arg))
+{
+	build_events(pa->type);
+	return evt_decode(fn, buf, len, pa, evt_print, NULL);
+}
+
+/* Scan one file which contains event ring buffer output. Call function
+ * fct with the file contents.
  */
 static int map_check(char *fn, int (*fct)(char *, unsigned char *, size_t,
-					  struct perf_event_attr *))
+					  struct perf_event_attr *, void *),
+		     void *arg)
 {
 	struct perf_event_attr pa;
 	unsigned char *p;
@@ -853,13 +1042,388 @@ static int map_check(char *fn, int (*fct)(char *, unsigned char *, size_t,
 		warnx("close() failed for %s", fn);
 		return rc;
 	}
-	build_events(pa.type);
-	rc = fct(fn, p, sb.st_size, &pa);
+	rc = fct(fn, p, sb.st_size, &pa, arg);
 	munmap(p, sb.st_size);
 
 	return rc;
 }
 
+/* Hash of key for aggregation table of given size (power of two) */
+static size_t aggr_hash(__u64 key, size_t size)
+{
+	return ((key * 0x9e3779b97f4a7c15ULL) >> 32) & (size - 1);
+}
+
+/* Return entry for key or the free entry where key has to be added. */
+static struct aggr_entry *aggr_tab_find(struct aggr_tab *t, __u64 key)
+{
+	size_t i = aggr_hash(key, t->size);
+
+	while (t->vec[i].used && t->vec[i].key != key)
+		i = (i + 1) & (t->size - 1);
+	return &t->vec[i];
+}
+
+static void aggr_tab_resize(struct aggr_tab *t, size_t size)
+{
+	struct aggr_entry *old = t->vec;
+	size_t old_size = t->size;
+
+	t->vec = util_zalloc(size * sizeof(*t->vec));
+	t->size = size;
+	for (size_t i = 0; i < old_size; ++i) {
+		if (old[i].used)
+			*aggr_tab_find(t, old[i].key) = old[i];
+	}
+	free(old);
+}
+
+/* Add samples and total to the entry of key. */
+static void aggr_tab_add(struct aggr_tab *t, __u64 key, __u64 samples,
+			 __u64 total)
+{
+	struct aggr_entry *e;
+
+	/* Keep load factor below one half */
+	if (2 * (t->cnt + 1) > t->size)
+		aggr_tab_resize(t, t->size ? 2 * t->size : AGGR_TAB_SIZE_MIN);
+	e = aggr_tab_find(t, key);
+	if (!e->used) {
+		e->used = true;
+		e->key = key;
+		++t->cnt;
+	}
+	e->samples += samples;
+	e->total += total;
+}
+
+static void aggr_tab_merge(struct aggr_tab *dst, struct aggr_tab *src)
+{
+	for (size_t i = 0; i < src->size; ++i) {
+		if (src->vec[i].used)
+			aggr_tab_add(dst, src->vec[i].key, src->vec[i].samples,
+				     src->vec[i].total);
+	}
+}
+
+static int aggr_cmp_key(const void *a, const void *b)
+{
+	const struct aggr_entry *ea = a, *eb = b;
+
+	return ea->key < eb->key ? -1 : ea->key > eb->key;
+}
+
+/* Sort by descending total, equal totals by key */
+static int aggr_cmp_total(const void *a, const void *b)
+{
+	const struct aggr_entry *ea = a, *eb = b;
+
+	if (ea->total != eb->total)
+		return ea->total < eb->total ? 1 : -1;
+	return aggr_cmp_key(a, b);
+}
+
+/* Return vector with the used entries of the table in sorted order. */
+static struct aggr_entry *aggr_tab_sort(struct aggr_tab *t,
+					int (*cmp)(const void *, const void *))
+{
+	struct aggr_entry *vec = util_malloc((t->cnt + 1) * sizeof(*vec));
+	size_t n = 0;
+
+	for (size_t i = 0; i < t->size; ++i) {
+		if (t->vec[i].used)
+			vec[n++] = t->vec[i];
+	}
+	qsort(vec, n, sizeof(*vec), cmp);
+	return vec;
+}
+
+static void aggr_free(struct pai_aggr *a)
+{
+	free(a->ctr.vec);
+	free(a->cpu.vec);
+	free(a->pid.vec);
+	free(a->time.vec);
+}
+
+static void aggr_merge(struct pai_aggr *dst, struct pai_aggr *src)
+{
+	aggr_tab_merge(&dst->ctr, &src->ctr);
+	aggr_tab_merge(&dst->cpu, &src->cpu);
+	aggr_tab_merge(&dst->pid, &src->pid);
+	aggr_tab_merge(&dst->time, &src->time);
+	dst->samples += src->samples;
+	dst->lost += src->lost;
+	dst->files += src->files;
+	dst->rc += src->rc;
+}
+
+/* Add one decoded entry to the aggregated data. The raw data is
+ * interpreted the same way as in evtraw_show().
+ */
+static void evt_aggr(struct perf_event_attr *pa, struct pai_event_out *ev,
+		     void *arg)
+{
+	unsigned char *raw = ev->raw;
+	size_t offset = 4, bytes;
+	struct pai_aggr *a = arg;
+	__u64 value, sum = 0;
+	__u16 ctr;
+
+	if (ev->type == PERF_RECORD_LOST) {
+		a->lost += ev->u.s_lost.lost;
+		return;
+	}
+	if (ev->type != PERF_RECORD_SAMPLE)
+		return;
+	++a->samples;
+	if (raw) {
+		bytes = *(__u32 *)raw;
+		while (offset < bytes) {
+			ctr = *(__u16 *)(raw + offset);
+			offset += sizeof(ctr);
+			value = *(__u64 *)(raw + offset);
+			offset += sizeof(value);
+			aggr_tab_add(&a->ctr, (__u64)pa->type << 16 | ctr, 1,
+				     value);
+			sum += value;
+			if (offset + sizeof(ctr) + sizeof(value) > bytes)
+				break;
+		}
+	}
+	aggr_tab_add(&a->cpu, ev->cpu, 1, sum);
+	aggr_tab_add(&a->pid, ev->u.s_sample.pid, 1, sum);
+	aggr_tab_add(&a->time, ev->time / (bucket_ms * 1000000), 1, sum);
+}
+
+static int evt_aggr_file(char *fn, unsigned char *buf, size_t len,
+			 struct perf_event_attr *pa, void *arg)
+{
+	return evt_decode(fn, buf, len, pa, evt_aggr, arg);
+}
+
+/* Files for aggregated report, shared by all decoder threads */
+static char **report_fvec;
+static int report_fcnt, report_fnext;
+
+/* Decode files until all files are taken. */
+static void *report_worker(void *arg)
+{
+	struct pai_aggr *a = arg;
+	int i;
+
+	while ((i = __atomic_fetch_add(&report_fnext, 1, __ATOMIC_RELAXED)) <
+	       report_fcnt) {
+		a->rc += map_check(report_fvec[i], evt_aggr_file, a);
+		++a->files;
+	}
+	return NULL;
+}
+
+/* Return PMU and event name for PMU type and counter number. */
+static const char *event_name(int type, int ctr, const char **pmu)
+{
+	struct pmu_events *p;
+
+	util_list_iterate(&list_pmu_event, p) {
+		if (p->type != type)
+			continue;
+		*pmu = p->name;
+		for (int i = 0; i < p->lstlen; ++i) {
+			if (p->base + ctr == p->lst[i].config)
+				return p->lst[i].name;
+		}
+		return "-";
+	}
+	*pmu = "-";
+	return "-";
+}
+
+/* Number of entries to show for top lists */
+static size_t top_limit(struct aggr_tab *t)
+{
+	return top_cnt ? MIN(top_cnt, t->cnt) : t->cnt;
+}
+
+static void report_print_text(struct pai_aggr *a, struct aggr_entry *ctr,
+			       struct aggr_entry *cpu, struct aggr_entry *pid,
+			       struct aggr_entry *time)
+{
+	const char *name, *pmu;
+	size_t i;
+
+	printf("Files %d samples %llu lost %llu\n", a->files, a->samples,
+	       a->lost);
+
+	printf("\nEvents\n%-16s %-24s %6s %12s %20s\n", "PMU", "Event", "Nr",
+	       "Samples", "Total");
+	for (i = 0; i < top_limit(&a->ctr); ++i) {
+		name = event_name(ctr[i].key >> 16, ctr[i].key & 0xffff, &pmu);
+		printf("%-16s %-24s %6lld %12lld %20lld\n", pmu, name,
+		       ctr[i].key & 0xffff, ctr[i].samples, ctr[i].total);
+	}
+
+	printf("\nCPUs\n%6s %12s %20s\n", "CPU", "Samples", "Total");
+	for (i = 0; i < a->cpu.cnt; ++i)
+		printf("%6lld %12lld %20lld\n", cpu[i].key, cpu[i].samples,
+		       cpu[i].total);
+
+	printf("\nProcesses\n%10s %12s %20s\n", "PID", "Samples", "Total");
+	for (i = 0; i < top_limit(&a->pid); ++i)
+		printf("%10lld %12lld %20lld\n", pid[i].key, pid[i].samples,
+		       pid[i].total);
+
+	printf("\nTime (%lu ms buckets)\n%20s %12s %20s %20s\n", bucket_ms,
+	       "Time", "Samples", "Total", "Total/s");
+	for (i = 0; i < a->time.cnt; ++i) {
+		if (humantime)
+			printf("%10lld.%09lld", time[i].key * bucket_ms / 1000,
+			       time[i].key * bucket_ms % 1000 * 1000000);
+		else
+			printf("%#20llx", time[i].key * bucket_ms * 1000000);
+		printf(" %12lld %20lld %20lld\n", time[i].samples,
+		       time[i].total, time[i].total * 1000 / bucket_ms);
+	}
+}
+
+static void report_print_fmt(struct pai_aggr *a, struct aggr_entry *ctr,
+			     struct aggr_entry *cpu, struct aggr_entry *pid,
+			     struct aggr_entry *time)
+{
+	const char *name, *pmu;
+	unsigned int flags = 0;
+	size_t i;
+
+	/* Ensure correct JSON even if interrupted */
+	if (fmt == FMT_JSON || fmt == FMT_JSONSEQ)
+		flags |= FMT_HANDLEINT;
+	util_fmt_init(stdout, fmt, flags, AGGR_API_LEVEL);
+	util_fmt_obj_start(FMT_DEFAULT, "pai");
+	util_fmt_pair(FMT_DEFAULT, "files", "%d", a->files);
+	util_fmt_pair(FMT_DEFAULT, "samples", "%llu", a->samples);
+	util_fmt_pair(FMT_DEFAULT, "lost", "%llu", a->lost);
+	util_fmt_pair(FMT_DEFAULT, "bucket_ms", "%lu", bucket_ms);
+
+	util_fmt_obj_start(FMT_LIST, "events");
+	for (i = 0; i < top_limit(&a->ctr); ++i) {
+		name = event_name(ctr[i].key >> 16, ctr[i].key & 0xffff, &pmu);
+		util_fmt_obj_start(FMT_ROW, NULL);
+		util_fmt_pair(FMT_QUOTE, "pmu", "%s", pmu);
+		util_fmt_pair(FMT_QUOTE, "event", "%s", name);
+		util_fmt_pair(FMT_DEFAULT, "nr", "%llu", ctr[i].key & 0xffff);
+		util_fmt_pair(FMT_DEFAULT, "samples", "%llu", ctr[i].samples);
+		util_fmt_pair(FMT_DEFAULT, "total", "%llu", ctr[i].total);
+		util_fmt_obj_end();
+	}
+	util_fmt_obj_end();
+
+	util_fmt_obj_start(FMT_LIST, "cpus");
+	for (i = 0; i < a->cpu.cnt; ++i) {
+		util_fmt_obj_start(FMT_ROW, NULL);
+		util_fmt_pair(FMT_DEFAULT, "cpu", "%llu", cpu[i].key);
+		util_fmt_pair(FMT_DEFAULT, "samples", "%llu", cpu[i].samples);
+		util_fmt_pair(FMT_DEFAULT, "total", "%llu", cpu[i].total);
+		util_fmt_obj_end();
+	}
+	util_fmt_obj_end();
+
+	util_fmt_obj_start(FMT_LIST, "processes");
+	for (i = 0; i < top_limit(&a->pid); ++i) {
+		util_fmt_obj_start(FMT_ROW, NULL);
+		util_fmt_pair(FMT_DEFAULT, "pid", "%llu", pid[i].key);
+		util_fmt_pair(FMT_DEFAULT, "samples", "%llu", pid[i].samples);
+		util_fmt_pair(FMT_DEFAULT, "total", "%llu", pid[i].total);
+		util_fmt_obj_end();
+	}
+	util_fmt_obj_end();
+
+	util_fmt_obj_start(FMT_LIST, "time");
+	for (i = 0; i < a->time.cnt; ++i) {
+		util_fmt_obj_start(FMT_ROW, NULL);
+		util_fmt_pair(FMT_DEFAULT, "time_ns", "%llu",
+			      time[i].key * bucket_ms * 1000000);
+		util_fmt_pair(FMT_DEFAULT, "samples", "%llu", time[i].samples);
+		util_fmt_pair(FMT_DEFAULT, "total", "%llu", time[i].total);
+		util_fmt_pair(FMT_DEFAULT, "rate", "%llu",
+			      time[i].total * 1000 / bucket_ms);
+		util_fmt_obj_end();
+	}
+	util_fmt_obj_end();
+
+	util_fmt_obj_end();
+	util_fmt_exit();
+}
+
+/* Print the aggregated data: Events and processes with the highest
+ * totals first, CPUs and time buckets in ascending order.
+ */
+static void report_print(struct pai_aggr *a)
+{
+	struct aggr_entry *ctr, *cpu, *pid, *time;
+	struct aggr_tab types;
+	size_t i;
+
+	/* Build event name lists once for each PMU type */
+	memset(&types, 0, sizeof(types));
+	for (i = 0; i < a->ctr.size; ++i) {
+		if (a->ctr.vec[i].used)
+			aggr_tab_add(&types, a->ctr.vec[i].key >> 16, 0, 0);
+	}
+	for (i = 0; i < types.size; ++i) {
+		if (types.vec[i].used)
+			build_events(types.vec[i].key);
+	}
+	free(types.vec);
+	ctr = aggr_tab_sort(&a->ctr, aggr_cmp_total);
+	cpu = aggr_tab_sort(&a->cpu, aggr_cmp_key);
+	pid = aggr_tab_sort(&a->pid, aggr_cmp_total);
+	time = aggr_tab_sort(&a->time, aggr_cmp_key);
+	if (fmt_specified)
+		report_print_fmt(a, ctr, cpu, pid, time);
+	else
+		report_print_text(a, ctr, cpu, pid, time);
+	free(ctr);
+	free(cpu);
+	free(pid);
+	free(time);
+}
+
+/* Decode and aggregate the event files in parallel. Each thread takes
+ * the next file that is not yet decoded and aggregates into its own
+ * tables, which are merged at the end.
+ */
+static int report_aggregate(char **fvec, int fcnt)
+{
+	struct pai_aggr total;
+	struct pai_worker *wvec;
+	int n;
+
+	n = jobs ? (int)jobs : CPU_COUNT(&cpu_online_mask);
+	n = MAX(MIN(n, fcnt), 1);
+	report_fvec = fvec;
+	report_fcnt = fcnt;
+	report_fnext = 0;
+	wvec = util_zalloc(n * sizeof(*wvec));
+	for (int i = 1; i < n; ++i) {
+		errno = pthread_create(&wvec[i].thread, NULL, report_worker,
+				       &wvec[i].aggr);
+		if (errno)
+			err(EXIT_FAILURE, "Cannot create decoder thread");
+	}
+	report_worker(&wvec[0].aggr);
+	memset(&total, 0, sizeof(total));
+	for (int i = 0; i < n; ++i) {
+		if (i)
+			pthread_join(wvec[i].thread, NULL);
+		aggr_merge(&total, &wvec[i].aggr);
+		aggr_free(&wvec[i].aggr);
+	}
+	free(wvec);
+	report_print(&total);
+	aggr_free(&total);
+	return total.rc;
+}
+
 /* Parse event attribute specification */
 static int parse_event_attr(char *cp)
 {
@@ -964,6 +1528,35 @@ static struct util_opt opt_vec[] = {
 		.argument = "NUMBER",
 		.desc = "Specifies interval between read operations in milliseconds"
 	},
+	{
+		.option = { "aggregate", no_argument, NULL, 'a' },
+		.desc = "Report aggregated counter values of all files"
+	},
+	{
+		.option = { "jobs", required_argument, NULL, 'j' },
+		.argument = "NUMBER",
+		.desc = "Number of threads decoding files for aggregated report"
+	},
+	{
+		.option = { "bucket", required_argument, NULL, 'b' },
+		.argument = "MS",
+		.desc = "Time bucket size in milliseconds for aggregated report"
+	},
+	{
+		.option = { "top", required_argument, NULL, 'T' },
+		.argument = "NUMBER",
+		.desc = "Number of events and processes in aggregated report"
+	},
+	{
+		.option = { "format", required_argument, NULL, OPT_FORMAT },
+		.argument = "FORMAT",
+		.flags = UTIL_OPT_FLAG_NOSHORT,
+		.desc = "Aggregated report in specified FORMAT (json json-seq pairs)"
+	},
+	{
+		.option = { "threads", no_argument, NULL, 't' },
+		.desc = "Collect data with one thread per CPU"
+	},
 	{
 		.option = { "verbose", no_argument, NULL, 'V' },
 		.desc = "Verbose output"
@@ -1098,6 +1691,39 @@ int main(int argc, char **argv)
 		case 'S':
 			summary = true;
 			break;
+		case 't':
+			threads = true;
+			break;
+		case 'a':
+			aggregate = true;
+			report = true;
+			break;
+		case 'j':
+			errno = 0;
+			jobs = strtoul(optarg, &slash, 0);
+			if (errno || !jobs || *slash)
+				errx(EXIT_FAILURE, "Invalid argument for -%c", ch);
+			break;
+		case 'b':
+			errno = 0;
+			bucket_ms = strtoul(optarg, &slash, 0);
+			if (errno || !bucket_ms || *slash)
+				errx(EXIT_FAILURE, "Invalid argument for -%c", ch);
+			break;
+		case 'T':
+			errno = 0;
+			top_cnt = strtoul(optarg, &slash, 0);
+			if (errno || *slash)
+				errx(EXIT_FAILURE, "Invalid argument for -%c", ch);
+			break;
+		case OPT_FORMAT:
+			if (!util_fmt_name_to_type(optarg, &fmt) ||
+			    fmt == FMT_CSV)
+				errx(EXIT_FAILURE, "Unsupported format %s", optarg);
+			fmt_specified = true;
+			aggregate = true;
+			report = true;
+			break;
 		case 'H':
 			humantime = 1;
 			break;
@@ -1122,6 +1748,7 @@ int main(int argc, char **argv)
 				errx(EXIT_FAILURE, "Invalid argument for runtime");
 		}
 
+		raise_nofile();
 		ev_install(group);
 		ev_enable();
 
@@ -1136,15 +1763,25 @@ int main(int argc, char **argv)
 	/* Must be reporting */
 	ch = 0;
 	if (optind < argc) {	/* Report mode command line has files */
-		for (; optind < argc; ++optind)
-			ch += map_check(argv[optind], evt_scan);
+		if (aggregate)
+			ch = report_aggregate(&argv[optind], argc - optind);
+		for (; !aggregate && optind < argc; ++optind)
+			ch += map_check(argv[optind], evt_scan, NULL);
 	} else {		/* Scan files in local directory */
 		struct dirent **de_vec;
 		int count = util_scandir(&de_vec, alphasort, ".",
 					 "pai(crypto|nnpa).[0-9]+");
+		char **fvec = util_malloc((count + 1) * sizeof(*fvec));
+		int fcnt = 0;
+
 		for (int i = 0; i < count; i++)
 			if (de_vec[i]->d_type == DT_REG)
-				ch += map_check(de_vec[i]->d_name, evt_scan);
+				fvec[fcnt++] = de_vec[i]->d_name;
+		if (aggregate)
+			ch = report_aggregate(fvec, fcnt);
+		for (int i = 0; !aggregate && i < fcnt; i++)
+			ch += map_check(fvec[i], evt_scan, NULL);
+		free(fvec);
 		util_scandir_free(de_vec, count);
 	}
 
@@ -30,6 +30,8 @@ struct pai_event {
 	int file_fd;			/* Map data output file descriptor */
 	int cpu;			/* Perf_event_open(2) CPU */
 	unsigned long flags;		/* Perf_event_open(2) flags */
+	char *buf;			/* Output buffer for event file */
+	size_t buf_len;			/* Used bytes in output buffer */
 };
 
 struct pai_event_out {		/* Output for CRYPTO_ALL event */
@@ -102,4 +104,33 @@ struct pmu_events {		/* Event list for PMU number to name xlate */
 	unsigned long base;	/* Base event number */
 	struct event_name *lst;	/* List of event names */
 };
+
+struct aggr_entry {		/* Aggregated values of one key */
+	__u64 key;		/* Counter, CPU, PID or time bucket */
+	__u64 samples;		/* Number of samples */
+	__u64 total;		/* Sum of counter values */
+	bool used;		/* Entry is in use */
+};
+
+struct aggr_tab {		/* Open addressing hash table */
+	struct aggr_entry *vec;	/* Entries, size is a power of two */
+	size_t size;		/* Number of entries */
+	size_t cnt;		/* Number of used entries */
+};
+
+struct pai_aggr {		/* Aggregated data of event files */
+	struct aggr_tab ctr;	/* Key: PMU type << 16 | counter number */
+	struct aggr_tab cpu;	/* Key: CPU number */
+	struct aggr_tab pid;	/* Key: Process ID */
+	struct aggr_tab time;	/* Key: Time bucket number */
+	__u64 samples;		/* Number of samples */
+	__u64 lost;		/* Number of lost records */
+	int files;		/* Number of decoded files */
+	int rc;			/* Sum of decoder return codes */
+};
+
+struct pai_worker {		/* Decoder thread for aggregated report */
+	pthread_t thread;	/* Thread */
+	struct pai_aggr aggr;	/* Aggregated data of decoded files */
+};
 #endif /* PAI_H */
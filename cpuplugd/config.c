@@ -76,16 +76,27 @@ static void add_var(char *name, char *rvalue)
 	return;
 }
 
-static int check_term(char *symbol, char *name, char *rvalue, struct term **term)
+/*
+ * Parse a rule or expression and compile it for evaluation, so that
+ * errors in the term are reported when the configuration is loaded
+ */
+static int check_term(char *symbol, char *name, char *rvalue,
+		      struct term **term, struct prog **prog, int rule)
 {
 	if (!strncasecmp(name, symbol, strlen(symbol))) {
 		cpuplugd_debug("found the following rule: %s = %s\n",
 			       name, rvalue);
 		*term = parse_term(&rvalue, OP_PRIO_NONE);
-		if (rvalue[0] == '\0')
-			return 1;
-		cpuplugd_exit("parsing error at %s, position: %s\n", symbol,
-			      rvalue);
+		if (rvalue[0] != '\0')
+			cpuplugd_exit("parsing error at %s, position: %s\n",
+				      symbol, rvalue);
+		free_prog(*prog);
+		*prog = rule ? compile_rule(*term) : compile_expr(*term);
+		if (*prog)
+			cpuplugd_debug("compiled %s into %u instructions, "
+				       "stack depth %u\n", symbol,
+				       (*prog)->len, (*prog)->max_depth);
+		return 1;
 	}
 	return 0;
 }
@@ -138,17 +149,23 @@ static void parse_configline(char *line)
 		cpuplugd_exit("the configuration file has syntax "
 			      "errors at %s, position: %s\n", name, rvalue);
 
-	if (check_term("hotplug", name, rvalue, &cfg.hotplug))
+	if (check_term("hotplug", name, rvalue, &cfg.hotplug,
+		       &cfg.hotplug_prog, 1))
 		return;
-	if (check_term("hotunplug", name, rvalue, &cfg.hotunplug))
+	if (check_term("hotunplug", name, rvalue, &cfg.hotunplug,
+		       &cfg.hotunplug_prog, 1))
 		return;
-	if (check_term("memplug", name, rvalue, &cfg.memplug))
+	if (check_term("memplug", name, rvalue, &cfg.memplug,
+		       &cfg.memplug_prog, 1))
 		return;
-	if (check_term("memunplug", name, rvalue, &cfg.memunplug))
+	if (check_term("memunplug", name, rvalue, &cfg.memunplug,
+		       &cfg.memunplug_prog, 1))
 		return;
-	if (check_term("cmm_inc", name, rvalue, &cfg.cmm_inc))
+	if (check_term("cmm_inc", name, rvalue, &cfg.cmm_inc,
+		       &cfg.cmm_inc_prog, 0))
 		return;
-	if (check_term("cmm_dec", name, rvalue, &cfg.cmm_dec))
+	if (check_term("cmm_dec", name, rvalue, &cfg.cmm_dec,
+		       &cfg.cmm_dec_prog, 0))
 		return;
 
 	if (check_value("update", name, rvalue, &cfg.update)) {
@@ -171,6 +188,17 @@ static void parse_configline(char *line)
 		return;
 	if (check_value("cmm_max", name, rvalue, &cfg.cmm_max))
 		return;
+	if (check_value("psi_cpu", name, rvalue, &cfg.psi_cpu))
+		return;
+	if (check_value("psi_memory", name, rvalue, &cfg.psi_memory))
+		return;
+	if (check_value("psi_window", name, rvalue, &cfg.psi_window)) {
+		if (cfg.psi_window >= PSI_WINDOW_MIN &&
+		    cfg.psi_window <= PSI_WINDOW_MAX)
+			return;
+		cpuplugd_exit("psi_window must be between %i and %i\n",
+			      PSI_WINDOW_MIN, PSI_WINDOW_MAX);
+	}
 
 	cpuplugd_debug("found the following variable: %s = %s\n",
 		       name, rvalue);
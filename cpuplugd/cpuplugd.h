@@ -30,11 +30,13 @@
 #define PIDFILE		"/run/cpuplugd.pid"
 #define LOCKFILE	"/var/lock/cpuplugd.lock"
 #define PROCINFO_LINE	512
-#define CPUSTAT_SIZE	1024
 #define VARINFO_SIZE	4096
 #define MAX_VARNAME	128
 #define MAX_LINESIZE	2048
 #define CPUSTATS	10
+#define PSI_WINDOW	1000	/* default PSI window in ms */
+#define PSI_WINDOW_MIN	500
+#define PSI_WINDOW_MAX	10000
 
 /*
  *  Precedence of C operators
@@ -101,6 +103,41 @@ enum operation {
 	VAR_ONLINE     /* number of online cpus */
 };
 
+/*
+ * Indexes of the built-in values in each history level, see
+ * proc_values_slot()
+ */
+enum proc_value_builtin {
+	PV_ONUMCPUS,
+	PV_LOADAVG,
+	PV_RUNNABLE_PROC,
+	PV_USER,
+	PV_NICE,
+	PV_SYSTEM,
+	PV_IDLE,
+	PV_IOWAIT,
+	PV_IRQ,
+	PV_SOFTIRQ,
+	PV_STEAL,
+	PV_GUEST,
+	PV_GUEST_NICE,
+	PV_TOTAL_TICKS,
+	PV_MEMFREE,
+	PV_PSWPIN,
+	PV_PSWPOUT,
+	PV_PGPGIN,
+	PV_PGPGOUT,
+	PV_BUILTIN_COUNT
+};
+
+/*
+ * Value of /proc/meminfo, /proc/vmstat or cpustat that is read each interval
+ */
+struct proc_value {
+	enum operation op;
+	const char *name;
+};
+
 struct symbols {
 	double loadavg;
 	double runnable_proc;
@@ -125,7 +162,47 @@ struct term {
 	double value;
 	struct term *left, *right;
 	char *proc_name;
-	unsigned int index;
+	unsigned int value_index;	/* index in history level */
+	unsigned int index;		/* history index */
+};
+
+/*
+ * Instructions of a compiled rule, see compile_rule() and compile_expr()
+ */
+enum prog_op {
+	PROG_CONST,		/* push value */
+	PROG_SYMBOL,		/* push struct symbols member at offset arg */
+	PROG_VALUE,		/* push proc value arg of history index */
+	PROG_TIME,		/* push timestamp of history index */
+	PROG_NEG,
+	PROG_NOT,
+	PROG_BOOL,		/* convert top of stack to 0 or 1 */
+	PROG_PLUS,
+	PROG_MINUS,
+	PROG_MULT,
+	PROG_DIV,
+	PROG_GREATER,
+	PROG_LESSER,
+	PROG_JUMP_FALSE,	/* keep 0 and jump to arg, else pop */
+	PROG_JUMP_TRUE,		/* keep 1 and jump to arg, else pop */
+};
+
+struct prog_insn {
+	enum prog_op op;
+	unsigned int arg;
+	unsigned int index;	/* history index */
+	double value;
+};
+
+/*
+ * Rule or expression in postfix order for evaluation on a value stack
+ */
+struct prog {
+	struct prog_insn *insn;
+	unsigned int len;
+	unsigned int size;
+	unsigned int depth;	/* stack depth while compiling */
+	unsigned int max_depth;
 };
 
 /*
@@ -144,6 +221,15 @@ struct config {
 	struct term *hotunplug;
 	struct term *memplug;
 	struct term *memunplug;
+	struct prog *cmm_inc_prog;
+	struct prog *cmm_dec_prog;
+	struct prog *hotplug_prog;
+	struct prog *hotunplug_prog;
+	struct prog *memplug_prog;
+	struct prog *memunplug_prog;
+	long psi_cpu;		/* CPU stall in ms per window for wakeup */
+	long psi_memory;	/* memory stall in ms per window for wakeup */
+	long psi_window;	/* PSI window in ms */
 };
 
 struct symbol_names {
@@ -160,15 +246,11 @@ extern int num_cpu_start; /* # of online cpus at the time of the startup */
 extern long cmm_pagesize_start; /* cmm_pageize at the time of daemon startup */
 extern struct config cfg;
 extern int reload_pending;
-extern unsigned long meminfo_size;
-extern unsigned long vmstat_size;
-extern unsigned long cpustat_size;
 extern unsigned long varinfo_size;
-extern char *meminfo;
-extern char *vmstat;
-extern char *cpustat;
 extern char *varinfo;
 extern double *timestamps;
+extern double *history_values;
+extern unsigned int num_proc_values;
 extern unsigned int history_max;
 extern unsigned int history_current;
 extern struct symbol_names sym_names[];
@@ -182,12 +264,19 @@ void reactivate_cpus();
 void parse_configfile(char *file);
 void print_term(struct term *fn);
 struct term *parse_term(char **p, enum op_prio prio);
-int eval_term(struct term *fn, struct symbols *symbols);
-double eval_double(struct term *fn, struct symbols *symbols);
-double get_proc_value(char *procinfo, char *name, char separator);
+struct prog *compile_rule(struct term *fn);
+struct prog *compile_expr(struct term *fn);
+void free_prog(struct prog *prog);
+int eval_rule(struct prog *prog, struct symbols *symbols);
+double eval_expr(struct prog *prog, struct symbols *symbols);
 void proc_read(char *procinfo, char *path, unsigned long size);
-void proc_cpu_read(char *procinfo);
 unsigned long proc_read_size(char *path);
+unsigned int proc_value_index(enum operation op, const char *name);
+const char *proc_value_name(unsigned int index);
+void proc_values_setup(void);
+double *proc_values_slot(unsigned int slot);
+void proc_values_read(double *values);
+int psi_open(const char *resource, long stall, long window);
 char *get_var_rvalue(char *var_name);
 void cleanup_cmm(void);
 int hotplug(int cpuid);
@@ -206,6 +295,7 @@ void set_cmm_pages(long size);
 int check_lpar();
 int cpu_is_configured(int cpuid);
 void setup_history(void);
+void setup_psi(void);
 
 
 #define cpuplugd_info(fmt, ...) ({			\
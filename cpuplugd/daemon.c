@@ -179,7 +179,7 @@ void reload_handler(int UNUSED(a))
 
 void reload_daemon()
 {
-	unsigned int temp_history;
+	unsigned int temp_history, temp_values;
 	long temp_mem;
 	int temp_cpu;
 
@@ -193,6 +193,7 @@ void reload_daemon()
 	temp_cpu = num_cpu_start;
 	temp_mem = cmm_pagesize_start;
 	temp_history = history_max;
+	temp_values = num_proc_values;
 
 	/* clear varinfo before re-reading variables from config file */
 	memset(varinfo, 0, varinfo_size);
@@ -201,14 +202,11 @@ void reload_daemon()
 	if (history_max > MAX_HISTORY)
 		cpuplugd_exit("History depth %i exceeded maximum (%i)\n",
 			      history_max, MAX_HISTORY);
-	if (history_max != temp_history) {
-		free(meminfo);
-		free(vmstat);
-		free(cpustat);
-		free(timestamps);
+	/* New values have no history, so accumulate it again */
+	if (history_max != temp_history || num_proc_values != temp_values)
 		setup_history();
-	}
 	check_config();
+	setup_psi();
 
 	num_cpu_start = temp_cpu;
 	cmm_pagesize_start = temp_mem;
@@ -9,11 +9,54 @@
  * it under the terms of the MIT license. See LICENSE for details.
  */
 
+#include <fcntl.h>
+#include <math.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
 #include "cpuplugd.h"
 
+/*
+ * Values used by cpuplugd itself, the rules can reference them as
+ * cpustat.<name>, meminfo.<name> and vmstat.<name>
+ */
+static const struct proc_value proc_value_builtin[] = {
+	[PV_ONUMCPUS]		= { OP_SYMBOL_CPUSTAT, "onumcpus" },
+	[PV_LOADAVG]		= { OP_SYMBOL_CPUSTAT, "loadavg" },
+	[PV_RUNNABLE_PROC]	= { OP_SYMBOL_CPUSTAT, "runnable_proc" },
+	[PV_USER]		= { OP_SYMBOL_CPUSTAT, "user" },
+	[PV_NICE]		= { OP_SYMBOL_CPUSTAT, "nice" },
+	[PV_SYSTEM]		= { OP_SYMBOL_CPUSTAT, "system" },
+	[PV_IDLE]		= { OP_SYMBOL_CPUSTAT, "idle" },
+	[PV_IOWAIT]		= { OP_SYMBOL_CPUSTAT, "iowait" },
+	[PV_IRQ]		= { OP_SYMBOL_CPUSTAT, "irq" },
+	[PV_SOFTIRQ]		= { OP_SYMBOL_CPUSTAT, "softirq" },
+	[PV_STEAL]		= { OP_SYMBOL_CPUSTAT, "steal" },
+	[PV_GUEST]		= { OP_SYMBOL_CPUSTAT, "guest" },
+	[PV_GUEST_NICE]		= { OP_SYMBOL_CPUSTAT, "guest_nice" },
+	[PV_TOTAL_TICKS]	= { OP_SYMBOL_CPUSTAT, "total_ticks" },
+	[PV_MEMFREE]		= { OP_SYMBOL_MEMINFO, "MemFree" },
+	[PV_PSWPIN]		= { OP_SYMBOL_VMSTAT, "pswpin" },
+	[PV_PSWPOUT]		= { OP_SYMBOL_VMSTAT, "pswpout" },
+	[PV_PGPGIN]		= { OP_SYMBOL_VMSTAT, "pgpgin" },
+	[PV_PGPGOUT]		= { OP_SYMBOL_VMSTAT, "pgpgout" },
+};
+
+/*
+ * All values that are read in each interval: The built-in values followed
+ * by the meminfo and vmstat values referenced by the rules. Values are
+ * only added, also on reload, so that value indexes in terms stay valid.
+ */
+static struct proc_value *proc_values;
+unsigned int num_proc_values;
+
+/* Ring buffer with num_proc_values values for each history level */
+double *history_values;
+
+/* Buffer for reading /proc/meminfo and /proc/vmstat */
+static char *procbuf;
+static unsigned long procbuf_size;
+
 /*
  * Return current load average and runnable processes based on /proc/loadavg
  *
@@ -44,39 +87,43 @@ void get_loadavg_runnable(double *loadavg, double *runnable)
 	return;
 }
 
-void proc_cpu_read(char *procinfo)
+/*
+ * Read cpustat values from /proc/stat and /proc/loadavg
+ */
+static void proc_cpu_read(double *values)
 {
 	FILE *filp;
-	unsigned int rc, onumcpus;
 	unsigned long user, nice, system, idle, iowait, irq, softirq, steal,
-		      guest, guest_nice, total_ticks;
+		      guest, guest_nice;
 	double loadavg, runnable;
 
-	guest = guest_nice = 0;		/* set to 0 if not present in kernel */
+	/* set to 0 if not present in kernel */
+	iowait = irq = softirq = steal = guest = guest_nice = 0;
 	filp = fopen("/proc/stat", "r");
 	if (!filp)
 		cpuplugd_exit("/proc/stat open failed: %s\n", strerror(errno));
-	rc = fscanf(filp, "cpu %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld", &user,
-		    &nice, &system, &idle, &iowait, &irq, &softirq, &steal,
-		    &guest, &guest_nice);
+	if (fscanf(filp, "cpu %ld %ld %ld %ld %ld %ld %ld %ld %ld %ld", &user,
+		   &nice, &system, &idle, &iowait, &irq, &softirq, &steal,
+		   &guest, &guest_nice) < 4)
+		cpuplugd_exit("cannot parse /proc/stat\n");
+	fclose(filp);
 
 	get_loadavg_runnable(&loadavg, &runnable);
-	onumcpus = get_num_online_cpus();
-	total_ticks = user + nice + system + idle + iowait + irq + softirq +
-		      steal + guest + guest_nice;
-
-	rc = snprintf(procinfo, cpustat_size, "onumcpus %d\nloadavg %f\n"
-		      "runnable_proc %f\nuser %ld\nnice %ld\nsystem %ld\n"
-		      "idle %ld\niowait %ld\nirq %ld\nsoftirq %ld\nsteal %ld\n"
-		      "guest %ld\nguest_nice %ld\ntotal_ticks %ld\n",
-		      onumcpus, loadavg, runnable, user, nice, system, idle,
-		      iowait, irq, softirq, steal, guest, guest_nice,
-		      total_ticks);
-	if (rc >= cpustat_size)
-		cpuplugd_exit("cpustat buffer too small: need %d, have %ld "
-			      "(bytes)\n", rc, cpustat_size);
-	fclose(filp);
-	return;
+	values[PV_ONUMCPUS] = get_num_online_cpus();
+	values[PV_LOADAVG] = loadavg;
+	values[PV_RUNNABLE_PROC] = runnable;
+	values[PV_USER] = user;
+	values[PV_NICE] = nice;
+	values[PV_SYSTEM] = system;
+	values[PV_IDLE] = idle;
+	values[PV_IOWAIT] = iowait;
+	values[PV_IRQ] = irq;
+	values[PV_SOFTIRQ] = softirq;
+	values[PV_STEAL] = steal;
+	values[PV_GUEST] = guest;
+	values[PV_GUEST_NICE] = guest_nice;
+	values[PV_TOTAL_TICKS] = user + nice + system + idle + iowait + irq +
+				 softirq + steal + guest + guest_nice;
 }
 
 void proc_read(char *procinfo, char *path, unsigned long size)
@@ -120,38 +167,165 @@ unsigned long proc_read_size(char *path)
 	return size;
 }
 
-double get_proc_value(char *procinfo, char *name, char separator)
+/*
+ * Return index of value "name" of /proc file "op" (OP_SYMBOL_MEMINFO,
+ * OP_SYMBOL_VMSTAT or OP_SYMBOL_CPUSTAT), add the value if needed
+ */
+unsigned int proc_value_index(enum operation op, const char *name)
+{
+	struct proc_value *new_values;
+	unsigned int i;
+	char *new_name;
+
+	if (!proc_values) {
+		num_proc_values = PV_BUILTIN_COUNT;
+		proc_values = malloc(sizeof(proc_value_builtin));
+		if (!proc_values)
+			cpuplugd_exit("Out of memory: proc_values\n");
+		memcpy(proc_values, proc_value_builtin,
+		       sizeof(proc_value_builtin));
+	}
+	for (i = 0; i < num_proc_values; i++) {
+		if (proc_values[i].op == op &&
+		    strcmp(proc_values[i].name, name) == 0)
+			return i;
+	}
+	/* cpustat only provides the built-in values */
+	if (op == OP_SYMBOL_CPUSTAT)
+		cpuplugd_exit("Symbol %s not found, check your config file\n",
+			      name);
+	new_values = realloc(proc_values,
+			     sizeof(*proc_values) * (num_proc_values + 1));
+	new_name = strdup(name);
+	if (!new_values || !new_name)
+		cpuplugd_exit("Out of memory: proc_values\n");
+	proc_values = new_values;
+	proc_values[num_proc_values].op = op;
+	proc_values[num_proc_values].name = new_name;
+	return num_proc_values++;
+}
+
+const char *proc_value_name(unsigned int index)
 {
-	char buf[PROCINFO_LINE];
-	char *proc_offset;
-	unsigned long proc_length, name_length;
-	double value;
-	int found;
-
-	value = -1;
-	found = 0;
-	name_length = strlen(name);
-	while ((proc_offset = strchr(procinfo, separator))) {
-		proc_length = proc_offset - procinfo;
-		/*
-		 * proc_read_size() made sure that proc_length < PROCINFO_LINE
-		 */
-		memcpy(buf, procinfo, proc_length);
-		buf[proc_length] = '\0';
-		procinfo = proc_offset + 1;
-		if (strncmp(buf, name, MAX(proc_length, name_length)) == 0) {
+	return proc_values[index].name;
+}
+
+/*
+ * Allocate the history ring buffer for history_max + 1 levels
+ */
+void proc_values_setup(void)
+{
+	unsigned long size;
+
+	/* Ensure that the built-in values are registered */
+	proc_value_index(OP_SYMBOL_CPUSTAT, "onumcpus");
+	/*
+	 * The /proc file size will vary during intervals, use double of current
+	 * size to have enough buffer for growing values.
+	 */
+	procbuf_size = proc_read_size("/proc/meminfo") * 2;
+	size = proc_read_size("/proc/vmstat") * 2;
+	procbuf_size = MAX(procbuf_size, size);
+	free(procbuf);
+	procbuf = malloc(procbuf_size);
+	if (!procbuf)
+		cpuplugd_exit("Out of memory: procbuf\n");
+	free(history_values);
+	history_values = calloc(num_proc_values * (history_max + 1),
+				sizeof(double));
+	if (!history_values)
+		cpuplugd_exit("Out of memory: history_values\n");
+}
+
+/*
+ * Return the values of history level "slot"
+ */
+double *proc_values_slot(unsigned int slot)
+{
+	return history_values + slot * num_proc_values;
+}
+
+/*
+ * Set the values of /proc file "op" from the lines "<name><separator><value>"
+ * in "procinfo". Stop as soon as all values are found.
+ */
+static void proc_parse(char *procinfo, enum operation op, char separator,
+		       double *values)
+{
+	unsigned int i, wanted = 0, found = 0;
+	char *line, *end, *sep;
+
+	for (i = 0; i < num_proc_values; i++) {
+		if (proc_values[i].op != op)
+			continue;
+		values[i] = NAN;
+		wanted++;
+	}
+	for (line = procinfo; *line && found < wanted; line = end + 1) {
+		end = strchr(line, '\n');
+		if (!end)
+			break;
+		sep = memchr(line, separator, end - line);
+		if (!sep)
+			continue;
+		*sep = '\0';
+		for (i = 0; i < num_proc_values; i++) {
+			if (proc_values[i].op != op ||
+			    strcmp(proc_values[i].name, line) != 0)
+				continue;
 			errno = 0;
-			value = strtod(procinfo, NULL);
+			values[i] = strtod(sep + 1, NULL);
 			if (errno)
 				cpuplugd_exit("strtod failed\n");
-			found = 1;
+			found++;
 			break;
 		}
-		proc_offset = strchr(procinfo, '\n');
-		procinfo = proc_offset + 1;
 	}
-	if (!found)
-		cpuplugd_exit("Symbol %s not found, check your config file\n",
-			      name);
-	return value;
+	if (found == wanted)
+		return;
+	for (i = 0; i < num_proc_values; i++) {
+		if (proc_values[i].op == op && isnan(values[i]))
+			cpuplugd_exit("Symbol %s not found, check your config "
+				      "file\n", proc_values[i].name);
+	}
+}
+
+/*
+ * Read all values of the current interval into "values"
+ */
+void proc_values_read(double *values)
+{
+	proc_cpu_read(values);
+	proc_read(procbuf, "/proc/meminfo", procbuf_size);
+	proc_parse(procbuf, OP_SYMBOL_MEMINFO, ':', values);
+	proc_read(procbuf, "/proc/vmstat", procbuf_size);
+	proc_parse(procbuf, OP_SYMBOL_VMSTAT, ' ', values);
+}
+
+/*
+ * Register a PSI trigger for "resource" (cpu or memory) that fires when
+ * tasks are stalled for more than "stall" ms within "window" ms. Returns
+ * the file descriptor to poll for POLLPRI or -1 if PSI is not available.
+ */
+int psi_open(const char *resource, long stall, long window)
+{
+	char path[64], trigger[64];
+	int fd, len;
+
+	snprintf(path, sizeof(path), "/proc/pressure/%s", resource);
+	fd = open(path, O_RDWR | O_NONBLOCK);
+	if (fd < 0) {
+		cpuplugd_error("Opening %s failed: %s\n", path,
+			       strerror(errno));
+		return -1;
+	}
+	len = snprintf(trigger, sizeof(trigger), "some %ld %ld",
+		       stall * 1000, window * 1000);
+	if (write(fd, trigger, len + 1) < 0) {
+		cpuplugd_error("Writing PSI trigger \"%s\" to %s failed: "
+			       "%s\n", trigger, path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	return fd;
 }
@@ -11,6 +11,7 @@
 
 #include <fcntl.h>
 #include <fenv.h>
+#include <poll.h>
 #include <sys/file.h>
 #include <sys/time.h>
 #include <time.h>
@@ -52,12 +53,15 @@ struct config cfg = {
 	.memunplug = NULL,
 	.hotplug = NULL,
 	.hotunplug = NULL,
+	.psi_cpu = 0,
+	.psi_memory = 0,
+	.psi_window = PSI_WINDOW,
 };
 
 int num_cpu_start, memory, cpu, reload_pending;
 long cmm_pagesize_start;
-unsigned long meminfo_size, vmstat_size, cpustat_size, varinfo_size;
-char *meminfo, *vmstat, *cpustat, *varinfo;
+unsigned long varinfo_size;
+char *varinfo;
 double *timestamps;
 unsigned int history_max, history_current, history_prev, sym_names_count;
 
@@ -65,6 +69,11 @@ static struct symbols symbols;
 static jmp_buf jmpenv;
 static struct sigaction act;
 
+/* PSI triggers polled between intervals, see setup_psi() */
+static struct pollfd psi_fds[2];
+static const char *psi_names[2];
+static unsigned int psi_count;
+
 /*
  * Handle the sigfpe signal which we might catch during rule evaluating
  */
@@ -73,46 +82,32 @@ static void sigfpe_handler(int UNUSED(sig))
 	longjmp(jmpenv, 1);
 }
 
-static void eval_cpu_rules(void)
+/*
+ * Evaluate the cpu rules. Returns 1 if a cpu should be enabled, -1 if a cpu
+ * should be disabled and 0 otherwise.
+ */
+static int eval_cpu_rules(void)
 {
 	double diffs[CPUSTATS], diffs_total, percent_factor;
-	char *procinfo_current, *procinfo_prev;
-	int cpu, nr_cpus, on_off;
+	double *values_current, *values_prev;
+	int on_off, i;
 
-	nr_cpus = get_numcpus();
-	procinfo_current = cpustat + history_current * cpustat_size;
-	procinfo_prev = cpustat + history_prev * cpustat_size;
-
-	diffs[0] = get_proc_value(procinfo_current, "user", ' ') -
-		   get_proc_value(procinfo_prev, "user", ' ');
-	diffs[1] = get_proc_value(procinfo_current, "nice", ' ') -
-		   get_proc_value(procinfo_prev, "nice", ' ');
-	diffs[2] = get_proc_value(procinfo_current, "system", ' ') -
-		   get_proc_value(procinfo_prev, "system", ' ');
-	diffs[3] = get_proc_value(procinfo_current, "idle", ' ') -
-		   get_proc_value(procinfo_prev, "idle", ' ');
-	diffs[4] = get_proc_value(procinfo_current, "iowait", ' ') -
-		   get_proc_value(procinfo_prev, "iowait", ' ');
-	diffs[5] = get_proc_value(procinfo_current, "irq", ' ') -
-		   get_proc_value(procinfo_prev, "irq", ' ');
-	diffs[6] = get_proc_value(procinfo_current, "softirq", ' ') -
-		   get_proc_value(procinfo_prev, "softirq", ' ');
-	diffs[7] = get_proc_value(procinfo_current, "steal", ' ') -
-		   get_proc_value(procinfo_prev, "steal", ' ');
-	diffs[8] = get_proc_value(procinfo_current, "guest", ' ') -
-		   get_proc_value(procinfo_prev, "guest", ' ');
-	diffs[9] = get_proc_value(procinfo_current, "guest_nice", ' ') -
-		   get_proc_value(procinfo_prev, "guest_nice", ' ');
-
-	diffs_total = get_proc_value(procinfo_current, "total_ticks", ' ') -
-		      get_proc_value(procinfo_prev, "total_ticks", ' ');
+	values_current = proc_values_slot(history_current);
+	values_prev = proc_values_slot(history_prev);
+
+	/* user, nice, system, idle, ... guest_nice */
+	for (i = 0; i < CPUSTATS; i++)
+		diffs[i] = values_current[PV_USER + i] -
+			   values_prev[PV_USER + i];
+
+	diffs_total = values_current[PV_TOTAL_TICKS] -
+		      values_prev[PV_TOTAL_TICKS];
 	if (diffs_total == 0)
 		diffs_total = 1;
 
-	symbols.loadavg = get_proc_value(procinfo_current, "loadavg", ' ');
-	symbols.runnable_proc = get_proc_value(procinfo_current,
-					       "runnable_proc", ' ');
-	symbols.onumcpus = get_proc_value(procinfo_current, "onumcpus", ' ');
+	symbols.loadavg = values_current[PV_LOADAVG];
+	symbols.runnable_proc = values_current[PV_RUNNABLE_PROC];
+	symbols.onumcpus = values_current[PV_ONUMCPUS];
 
 	percent_factor = 100 * symbols.onumcpus;
 	symbols.user = (diffs[0] / diffs_total) * percent_factor;
@@ -127,8 +122,10 @@ static void eval_cpu_rules(void)
 	symbols.guest_nice = (diffs[9] / diffs_total) * percent_factor;
 
 	/* only use this for development and testing */
-	cpuplugd_debug("cpustat values:\n%s", cpustat + history_current *
-		       cpustat_size);
+	cpuplugd_debug("cpustat values:\n");
+	for (i = PV_ONUMCPUS; i <= PV_TOTAL_TICKS; i++)
+		cpuplugd_debug("%s %f\n", proc_value_name(i),
+			       values_current[i]);
 	if (debug && foreground == 1) {
 		printf("-------------------- CPU --------------------\n");
 		printf("cpu_min: %ld\n", cfg.cpu_min);
@@ -144,7 +141,7 @@ static void eval_cpu_rules(void)
 		printf("steal percent = %f\n", symbols.steal);
 		printf("guest percent = %f\n", symbols.guest);
 		printf("guest_nice percent = %f\n", symbols.guest_nice);
-		printf("numcpus %d\n", nr_cpus);
+		printf("numcpus %d\n", get_numcpus());
 		printf("runnable_proc: %d\n", (int) symbols.runnable_proc);
 		printf("---------------------------------------------\n");
 		printf("onumcpus:   %d\n", (int) symbols.onumcpus);
@@ -160,11 +157,22 @@ static void eval_cpu_rules(void)
 
 	on_off = 0;
 	/* Evaluate the hotplug rule */
-	if (eval_term(cfg.hotplug, &symbols))
+	if (eval_rule(cfg.hotplug_prog, &symbols))
 		on_off++;
 	/* Evaluate the hotunplug rule only if hotplug did not match */
-	else if (eval_term(cfg.hotunplug, &symbols))
+	else if (eval_rule(cfg.hotunplug_prog, &symbols))
 		on_off--;
+	return on_off;
+}
+
+/*
+ * Enable or disable a cpu according to the result of eval_cpu_rules()
+ */
+static void apply_cpu_rules(int on_off)
+{
+	int cpu, nr_cpus;
+
+	nr_cpus = get_numcpus();
 	if (on_off > 0) {
 		/* check the cpu nr limit */
 		if (symbols.onumcpus + 1 > cfg.cpu_max) {
@@ -209,26 +217,24 @@ static void eval_cpu_rules(void)
 	}
 }
 
-static void eval_mem_rules(double interval)
+/*
+ * Evaluate the memory rules. Returns the new cmm pool size, the current
+ * size is stored in "cmm_cur".
+ */
+static long eval_mem_rules(double interval, long *cmm_cur)
 {
 	long cmmpages_size, cmm_inc, cmm_dec, cmm_new;
 	double free_memory, swaprate, apcr;
-	char *procinfo_current, *procinfo_prev;
+	double *values_current, *values_prev;
 
-	procinfo_current = meminfo + history_current * meminfo_size;
-	free_memory = get_proc_value(procinfo_current, "MemFree", ':');
-
-	procinfo_current = vmstat + history_current * vmstat_size;
-	procinfo_prev = vmstat + history_prev * vmstat_size;
-	swaprate = (get_proc_value(procinfo_current, "pswpin", ' ') +
-		    get_proc_value(procinfo_current, "pswpout", ' ') -
-		    get_proc_value(procinfo_prev, "pswpin", ' ') -
-		    get_proc_value(procinfo_prev, "pswpout", ' ')) /
+	values_current = proc_values_slot(history_current);
+	values_prev = proc_values_slot(history_prev);
+	free_memory = values_current[PV_MEMFREE];
+	swaprate = (values_current[PV_PSWPIN] + values_current[PV_PSWPOUT] -
+		    values_prev[PV_PSWPIN] - values_prev[PV_PSWPOUT]) /
 		    interval;
-	apcr = (get_proc_value(procinfo_current, "pgpgin", ' ') +
-		get_proc_value(procinfo_current, "pgpgout", ' ') -
-		get_proc_value(procinfo_prev, "pgpgin", ' ') -
-		get_proc_value(procinfo_prev, "pgpgout", ' ')) /
+	apcr = (values_current[PV_PGPGIN] + values_current[PV_PGPGOUT] -
+		values_prev[PV_PGPGIN] - values_prev[PV_PGPGOUT]) /
 		interval;
 
 	cmmpages_size = get_cmmpages_size();
@@ -236,10 +242,10 @@ static void eval_mem_rules(double interval)
 	symbols.swaprate = swaprate;		// swaprate in 4K pages / sec
 	symbols.freemem = free_memory / 1024;	// freemem in MB
 
-	cmm_inc = eval_double(cfg.cmm_inc, &symbols);
+	cmm_inc = eval_expr(cfg.cmm_inc_prog, &symbols);
 	/* cmm_dec is optional */
 	if (cfg.cmm_dec)
-		cmm_dec = eval_double(cfg.cmm_dec, &symbols);
+		cmm_dec = eval_expr(cfg.cmm_dec_prog, &symbols);
 	else
 		cmm_dec = cmm_inc;
 
@@ -274,7 +280,7 @@ static void eval_mem_rules(double interval)
 
 	cmm_new = cmmpages_size;
 	/* Evaluate the memplug rule */
-	if (eval_term(cfg.memplug, &symbols)) {
+	if (eval_rule(cfg.memplug_prog, &symbols)) {
 		if (cmm_dec < 0) {
 			cpuplugd_error("cmm_dec went negative (%ld), set it "
 				       "to 0.\n", cmm_dec);
@@ -282,7 +288,7 @@ static void eval_mem_rules(double interval)
 		}
 		cmm_new -= cmm_dec;
 	/* Evaluate the memunplug rule only if memplug did not match */
-	} else if (eval_term(cfg.memunplug, &symbols)) {
+	} else if (eval_rule(cfg.memunplug_prog, &symbols)) {
 		if (cmm_inc < 0) {
 			cpuplugd_error("cmm_inc went negative (%ld), set it "
 				       "to 0.\n", cmm_inc);
@@ -298,8 +304,8 @@ static void eval_mem_rules(double interval)
 		cpuplugd_debug("maximum memory limit is reached\n");
 		cmm_new = cfg.cmm_max;
 	}
-	if (cmm_new != cmmpages_size)
-		set_cmm_pages(cmm_new);
+	*cmm_cur = cmmpages_size;
+	return cmm_new;
 }
 
 static void time_read(double *timestamps)
@@ -319,25 +325,46 @@ static void time_read(double *timestamps)
 	return;
 }
 
+/*
+ * Return monotonic time in microseconds for measuring the evaluation cost
+ */
+static double time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static void psi_add(const char *resource, long stall)
+{
+	int fd;
+
+	if (stall >= cfg.psi_window)
+		cpuplugd_exit("psi_%s must be below psi_window (%ld ms)\n",
+			      resource, cfg.psi_window);
+	fd = psi_open(resource, stall, cfg.psi_window);
+	if (fd < 0) {
+		cpuplugd_info("No %s pressure wakeups, using the update "
+			      "interval only\n", resource);
+		return;
+	}
+	cpuplugd_debug("%s pressure trigger: %ld ms stall in %ld ms\n",
+		       resource, stall, cfg.psi_window);
+	psi_names[psi_count] = resource;
+	psi_fds[psi_count].fd = fd;
+	psi_fds[psi_count].events = POLLPRI;
+	psi_count++;
+}
+
 void setup_history()
 {
 	/*
-	 * The /proc file size will vary during intervals, use double of current
-	 * size to have enough buffer for growing values.
+	 * Only the values used by cpuplugd and the rules are kept in the
+	 * history, see proc_values_read().
 	 */
-	meminfo_size = proc_read_size("/proc/meminfo") * 2;
-	vmstat_size = proc_read_size("/proc/vmstat") * 2;
-	cpustat_size = CPUSTAT_SIZE;
-
-	meminfo = malloc(meminfo_size * (history_max + 1));
-	if (!meminfo)
-		cpuplugd_exit("Out of memory: meminfo\n");
-	vmstat = malloc(vmstat_size * (history_max + 1));
-	if (!vmstat)
-		cpuplugd_exit("Out of memory: vmstat\n");
-	cpustat = malloc(cpustat_size * (history_max + 1));
-	if (!cpustat)
-		cpuplugd_exit("Out of memory: cpustat\n");
+	proc_values_setup();
+	free(timestamps);
 	timestamps = malloc(sizeof(double) * (history_max + 1));
 	if (!timestamps)
 		cpuplugd_exit("Out of memory: timestamps\n");
@@ -350,20 +377,74 @@ void setup_history()
 		      history_max);
 	do {
 		time_read(&timestamps[history_current]);
-		proc_read(meminfo + history_current * meminfo_size,
-			  "/proc/meminfo", meminfo_size);
-		proc_read(vmstat + history_current * vmstat_size,
-			  "/proc/vmstat", vmstat_size);
-		proc_cpu_read(cpustat + history_current * cpustat_size);
+		proc_values_read(proc_values_slot(history_current));
 		sleep(cfg.update);
 		history_current++;
 	} while (history_current < history_max);
 	history_current--;
 }
 
+/*
+ * Register the PSI triggers of the configuration, so that a stall of
+ * tasks starts the next interval early instead of waiting for the update
+ * interval to expire
+ */
+void setup_psi(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < psi_count; i++)
+		close(psi_fds[i].fd);
+	psi_count = 0;
+	if (cpu == 1 && cfg.psi_cpu > 0)
+		psi_add("cpu", cfg.psi_cpu);
+	if (memory == 1 && cfg.psi_memory > 0)
+		psi_add("memory", cfg.psi_memory);
+}
+
+/*
+ * Wait for the update interval or until a PSI trigger fires. A signal
+ * ends the wait like it ends sleep().
+ */
+static void wait_interval(void)
+{
+	double end_us, now_us;
+	unsigned int i;
+	int rc;
+
+	if (psi_count == 0) {
+		sleep(cfg.update);
+		return;
+	}
+	end_us = time_us() + cfg.update * 1000000.0;
+	while ((now_us = time_us()) < end_us) {
+		rc = poll(psi_fds, psi_count, (end_us - now_us) / 1000 + 1);
+		if (rc <= 0)
+			return;
+		for (i = 0; i < psi_count; i++) {
+			if (psi_fds[i].revents & POLLPRI) {
+				cpuplugd_debug("%s pressure trigger fired\n",
+					       psi_names[i]);
+				return;
+			}
+			if (psi_fds[i].revents & (POLLERR | POLLNVAL)) {
+				cpuplugd_error("PSI trigger for %s failed, "
+					       "disabled\n", psi_names[i]);
+				/* poll() ignores negative descriptors */
+				close(psi_fds[i].fd);
+				psi_fds[i].fd = -1;
+			}
+		}
+	}
+}
+
 int main(int argc, char *argv[])
 {
-	double interval;
+	double interval, start_us, read_us, eval_us;
+	/* Set between setjmp() and longjmp() */
+	volatile long cmm_new, cmm_cur;
+	volatile int on_off;
+	long cmm_size;
 	int fd, rc;
 
 	reload_pending = 0;
@@ -438,6 +519,7 @@ int main(int argc, char *argv[])
 			      strerror(errno));
 
 	setup_history();
+	setup_psi();
 
 	/* Main loop */
 	while (1) {
@@ -449,11 +531,9 @@ int main(int argc, char *argv[])
 		history_prev = history_current;
 		history_current = (history_current + 1) % (history_max + 1);
 		time_read(&timestamps[history_current]);
-		proc_read(meminfo + history_current * meminfo_size,
-			  "/proc/meminfo", meminfo_size);
-		proc_read(vmstat + history_current * vmstat_size,
-			  "/proc/vmstat", vmstat_size);
-		proc_cpu_read(cpustat + history_current * cpustat_size);
+		start_us = time_us();
+		proc_values_read(proc_values_slot(history_current));
+		read_us = time_us() - start_us;
 		interval = timestamps[history_current] -
 			   timestamps[history_prev];
 		cpuplugd_debug("config update interval: %ld seconds\n",
@@ -461,23 +541,36 @@ int main(int argc, char *argv[])
 		cpuplugd_debug("real update interval: %f seconds\n", interval);
 
 		/* Run code that may signal failure via longjmp. */
+		on_off = 0;
+		cmm_new = cmm_cur = 0;
 		if (cpu == 1) {
 			if (setjmp(jmpenv) == 0)
-				eval_cpu_rules();
+				on_off = eval_cpu_rules();
 			else
 				cpuplugd_error("Floating point exception, "
 					       "skipping cpu rule "
 					       "evaluation.\n");
 		}
 		if (memory == 1) {
-			if (setjmp(jmpenv) == 0)
-				eval_mem_rules(interval);
-			else
+			if (setjmp(jmpenv) == 0) {
+				cmm_new = eval_mem_rules(interval, &cmm_size);
+				cmm_cur = cmm_size;
+			} else {
 				cpuplugd_error("Floating point exception, "
 					       "skipping memory rule "
 					       "evaluation.\n");
+			}
 		}
-		sleep(cfg.update);
+		eval_us = time_us() - start_us - read_us;
+		cpuplugd_debug("interval cost: %.0f us reading %u values, "
+			       "%.0f us evaluating rules\n", read_us,
+			       num_proc_values, eval_us);
+		/* Hotplug and cmm actions are not part of the evaluation cost */
+		if (on_off)
+			apply_cpu_rules(on_off);
+		if (cmm_new != cmm_cur)
+			set_cmm_pages(cmm_new);
+		wait_interval();
 	}
 	return 0;
 }
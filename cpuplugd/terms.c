@@ -1,7 +1,7 @@
 /*
  * cpuplugd - Linux for System z Hotplug Daemon
  *
- * Term parsing
+ * Term parsing and compilation
  *
  * Copyright IBM Corp. 2007, 2017
  *
@@ -9,6 +9,8 @@
  * it under the terms of the MIT license. See LICENSE for details.
  */
 
+#include <stddef.h>
+
 #include "cpuplugd.h"
 
 static enum op_prio op_prio_table[] =
@@ -326,6 +328,7 @@ struct term *parse_term(char **p, enum op_prio prio)
 			if (fn == NULL)
 				goto out_error;
 			fn->op = sym_names[i].symop;
+			fn->index = 0;
 			s += strlen(sym_names[i].name);
 			length = 0;
 			if (fn->op == OP_SYMBOL_MEMINFO ||
@@ -338,6 +341,8 @@ struct term *parse_term(char **p, enum op_prio prio)
 					goto out_error;
 				strncpy(fn->proc_name, s, length);
 				fn->proc_name[length] = '\0';
+				fn->value_index = proc_value_index(fn->op,
+								   fn->proc_name);
 			}
 			if (fn->op == OP_SYMBOL_MEMINFO ||
 			    fn->op == OP_SYMBOL_VMSTAT ||
@@ -413,105 +418,156 @@ out_error:
 	return NULL;
 }
 
-static double get_value(struct term *fn)
+/*
+ * Offsets of the symbols in struct symbols
+ */
+static const size_t symbol_offset_table[] = {
+	[OP_SYMBOL_LOADAVG] = offsetof(struct symbols, loadavg),
+	[OP_SYMBOL_RUNABLE] = offsetof(struct symbols, runnable_proc),
+	[OP_SYMBOL_CPUS] = offsetof(struct symbols, onumcpus),
+	[OP_SYMBOL_USER] = offsetof(struct symbols, user),
+	[OP_SYMBOL_NICE] = offsetof(struct symbols, nice),
+	[OP_SYMBOL_SYSTEM] = offsetof(struct symbols, system),
+	[OP_SYMBOL_IDLE] = offsetof(struct symbols, idle),
+	[OP_SYMBOL_IOWAIT] = offsetof(struct symbols, iowait),
+	[OP_SYMBOL_IRQ] = offsetof(struct symbols, irq),
+	[OP_SYMBOL_SOFTIRQ] = offsetof(struct symbols, softirq),
+	[OP_SYMBOL_STEAL] = offsetof(struct symbols, steal),
+	[OP_SYMBOL_GUEST] = offsetof(struct symbols, guest),
+	[OP_SYMBOL_GUEST_NICE] = offsetof(struct symbols, guest_nice),
+	[OP_SYMBOL_APCR] = offsetof(struct symbols, apcr),
+	[OP_SYMBOL_SWAPRATE] = offsetof(struct symbols, swaprate),
+	[OP_SYMBOL_FREEMEM] = offsetof(struct symbols, freemem),
+};
+
+/*
+ * Append an instruction to a program and track the stack depth. Returns
+ * the position of the instruction for patching jump targets.
+ */
+static unsigned int emit(struct prog *prog, enum prog_op op,
+			 unsigned int arg, unsigned int index, double value)
 {
-	double value = 0;
-	char *procinfo;
-	unsigned int history_index;
+	struct prog_insn *insn;
 
-	if (fn->index <= history_current)
-		history_index = history_current - fn->index;
-	else
-		history_index = history_max + 1 - (fn->index - history_current);
+	if (prog->len == prog->size) {
+		prog->size = prog->size ? prog->size * 2 : 16;
+		prog->insn = realloc(prog->insn,
+				     prog->size * sizeof(struct prog_insn));
+		if (!prog->insn)
+			cpuplugd_exit("Out of memory: rule program\n");
+	}
+	insn = &prog->insn[prog->len];
+	insn->op = op;
+	insn->arg = arg;
+	insn->index = index;
+	insn->value = value;
+	switch (op) {
+	case PROG_CONST:
+	case PROG_SYMBOL:
+	case PROG_VALUE:
+	case PROG_TIME:
+		prog->depth++;
+		if (prog->depth > prog->max_depth)
+			prog->max_depth = prog->depth;
+		break;
+	case PROG_NEG:
+	case PROG_NOT:
+	case PROG_BOOL:
+		break;
+	default:
+		/* Binary operators and the not taken path of jumps pop */
+		prog->depth--;
+		break;
+	}
+	return prog->len++;
+}
+
+static void compile_double(struct prog *prog, struct term *fn);
+
+/*
+ * Compile term with the semantics of a boolean rule: The result is 0 or 1
+ * and the right side of '&' and '|' is only evaluated if needed.
+ */
+static void compile_bool(struct prog *prog, struct term *fn)
+{
+	unsigned int jump;
 
 	switch (fn->op) {
-	case OP_SYMBOL_MEMINFO:
-		procinfo = meminfo + history_index * meminfo_size;
-		value = get_proc_value(procinfo, fn->proc_name, ':');
-		break;
-	case OP_SYMBOL_VMSTAT:
-		procinfo = vmstat + history_index * vmstat_size;
-		value = get_proc_value(procinfo, fn->proc_name, ' ');
+	case OP_NOT:
+		compile_bool(prog, fn->left);
+		emit(prog, PROG_NOT, 0, 0, 0);
 		break;
-	case OP_SYMBOL_CPUSTAT:
-		procinfo = cpustat + history_index * cpustat_size;
-		value = get_proc_value(procinfo, fn->proc_name, ' ');
+	case OP_OR:
+	case OP_AND:
+		compile_bool(prog, fn->left);
+		jump = emit(prog, fn->op == OP_OR ? PROG_JUMP_TRUE :
+			    PROG_JUMP_FALSE, 0, 0, 0);
+		compile_bool(prog, fn->right);
+		prog->insn[jump].arg = prog->len;
 		break;
-	case OP_SYMBOL_TIME:
-		value = timestamps[history_index];
+	case OP_GREATER:
+	case OP_LESSER:
+		compile_double(prog, fn->left);
+		compile_double(prog, fn->right);
+		emit(prog, fn->op == OP_GREATER ? PROG_GREATER : PROG_LESSER,
+		     0, 0, 0);
 		break;
 	default:
-		cpuplugd_exit("Invalid term specified: %i\n", fn->op);
+		compile_double(prog, fn);
+		emit(prog, PROG_BOOL, 0, 0, 0);
+		break;
 	}
-	return value;
 }
 
-double eval_double(struct term *fn, struct symbols *symbols)
+/*
+ * Compile term with the semantics of an algebraic expression
+ */
+static void compile_double(struct prog *prog, struct term *fn)
 {
-	double a, b, sum;
-
 	switch (fn->op) {
 	case OP_SYMBOL_LOADAVG:
-		return symbols->loadavg;
 	case OP_SYMBOL_RUNABLE:
-		return symbols->runnable_proc;
 	case OP_SYMBOL_CPUS:
-		return symbols->onumcpus;
 	case OP_SYMBOL_USER:
-		return symbols->user;
 	case OP_SYMBOL_NICE:
-		return symbols->nice;
 	case OP_SYMBOL_SYSTEM:
-		return symbols->system;
 	case OP_SYMBOL_IDLE:
-		return symbols->idle;
 	case OP_SYMBOL_IOWAIT:
-		return symbols->iowait;
 	case OP_SYMBOL_IRQ:
-		return symbols->irq;
 	case OP_SYMBOL_SOFTIRQ:
-		return symbols->softirq;
 	case OP_SYMBOL_STEAL:
-		return symbols->steal;
 	case OP_SYMBOL_GUEST:
-		return symbols->guest;
 	case OP_SYMBOL_GUEST_NICE:
-		return symbols->guest_nice;
-	case OP_SYMBOL_FREEMEM:
-		return symbols->freemem;
 	case OP_SYMBOL_APCR:
-		return symbols->apcr;
 	case OP_SYMBOL_SWAPRATE:
-		return symbols->swaprate;
+	case OP_SYMBOL_FREEMEM:
+		emit(prog, PROG_SYMBOL, symbol_offset_table[fn->op], 0, 0);
+		break;
 	case OP_SYMBOL_MEMINFO:
 	case OP_SYMBOL_VMSTAT:
 	case OP_SYMBOL_CPUSTAT:
+		emit(prog, PROG_VALUE, fn->value_index, fn->index, 0);
+		break;
 	case OP_SYMBOL_TIME:
-		return get_value(fn);
+		emit(prog, PROG_TIME, 0, fn->index, 0);
+		break;
 	case OP_CONST:
-		return fn->value;
+		emit(prog, PROG_CONST, 0, 0, fn->value);
+		break;
 	case OP_NEG:
-		return -eval_double(fn->left, symbols);
+		compile_double(prog, fn->left);
+		emit(prog, PROG_NEG, 0, 0, 0);
+		break;
 	case OP_PLUS:
-		return eval_double(fn->left, symbols) +
-			eval_double(fn->right, symbols);
 	case OP_MINUS:
-		return eval_double(fn->left, symbols) -
-			eval_double(fn->right, symbols);
 	case OP_MULT:
-		a = eval_double(fn->left, symbols);
-		b = eval_double(fn->right, symbols);
-		sum = a*b;
-		return sum;
-		/*return eval_double(fn->left, symbols) *
-			eval_double(fn->right, symbols);*/
 	case OP_DIV:
-		a = eval_double(fn->left, symbols);
-		b = eval_double(fn->right, symbols);
-		sum = a/b;
-		return sum;
-		/*return eval_double(fn->left, symbols) /
-			eval_double(fn->right, symbols); */
+		compile_double(prog, fn->left);
+		compile_double(prog, fn->right);
+		emit(prog, fn->op == OP_PLUS ? PROG_PLUS :
+		     fn->op == OP_MINUS ? PROG_MINUS :
+		     fn->op == OP_MULT ? PROG_MULT : PROG_DIV, 0, 0, 0);
+		break;
 	case OP_NOT:
 	case OP_AND:
 	case OP_OR:
@@ -522,29 +578,144 @@ double eval_double(struct term *fn, struct symbols *symbols)
 	case VAR_ONLINE:
 		cpuplugd_exit("Invalid term specified: %i\n", fn->op);
 	}
-	return 0;
 }
 
-int eval_term(struct term *fn, struct symbols *symbols)
+static struct prog *compile(struct term *fn, int rule)
 {
-	if (fn == NULL || symbols == NULL)
-		return 0.0;
-	switch (fn->op) {
-	case OP_NOT:
-		return !eval_term(fn->left, symbols);
-	case OP_OR:
-		return eval_term(fn->left, symbols) == 1 ||
-			eval_term(fn->right, symbols) == 1;
-	case OP_AND:
-		return eval_term(fn->left, symbols) == 1 &&
-			eval_term(fn->right, symbols) == 1;
-	case OP_GREATER:
-		return eval_double(fn->left, symbols) >
-			eval_double(fn->right, symbols);
-	case OP_LESSER:
-		return eval_double(fn->left, symbols) <
-			eval_double(fn->right, symbols);
-	default:
-		return eval_double(fn, symbols) != 0.0;
+	struct prog *prog;
+
+	if (fn == NULL)
+		return NULL;
+	prog = calloc(1, sizeof(struct prog));
+	if (!prog)
+		cpuplugd_exit("Out of memory: rule program\n");
+	if (rule)
+		compile_bool(prog, fn);
+	else
+		compile_double(prog, fn);
+	return prog;
+}
+
+/*
+ * Compile a hotplug or memplug rule into a program for eval_rule()
+ */
+struct prog *compile_rule(struct term *fn)
+{
+	return compile(fn, 1);
+}
+
+/*
+ * Compile a cmm_inc or cmm_dec expression into a program for eval_expr()
+ */
+struct prog *compile_expr(struct term *fn)
+{
+	return compile(fn, 0);
+}
+
+void free_prog(struct prog *prog)
+{
+	if (!prog)
+		return;
+	free(prog->insn);
+	free(prog);
+}
+
+/*
+ * Return the slot of history level "index" intervals before the current one
+ */
+static unsigned int history_slot(unsigned int index)
+{
+	if (index <= history_current)
+		return history_current - index;
+	return history_max + 1 - (index - history_current);
+}
+
+/*
+ * Run a program on a value stack and return the top of stack
+ */
+static double run_prog(struct prog *prog, struct symbols *symbols)
+{
+	double stack[prog->max_depth];
+	struct prog_insn *insn;
+	unsigned int pc, sp;
+
+	sp = 0;
+	for (pc = 0; pc < prog->len; pc++) {
+		insn = &prog->insn[pc];
+		switch (insn->op) {
+		case PROG_CONST:
+			stack[sp++] = insn->value;
+			break;
+		case PROG_SYMBOL:
+			stack[sp++] = *(double *)((char *) symbols + insn->arg);
+			break;
+		case PROG_VALUE:
+			stack[sp++] = proc_values_slot(
+				history_slot(insn->index))[insn->arg];
+			break;
+		case PROG_TIME:
+			stack[sp++] = timestamps[history_slot(insn->index)];
+			break;
+		case PROG_NEG:
+			stack[sp - 1] = -stack[sp - 1];
+			break;
+		case PROG_NOT:
+			stack[sp - 1] = stack[sp - 1] == 0.0;
+			break;
+		case PROG_BOOL:
+			stack[sp - 1] = stack[sp - 1] != 0.0;
+			break;
+		case PROG_PLUS:
+			sp--;
+			stack[sp - 1] = stack[sp - 1] + stack[sp];
+			break;
+		case PROG_MINUS:
+			sp--;
+			stack[sp - 1] = stack[sp - 1] - stack[sp];
+			break;
+		case PROG_MULT:
+			sp--;
+			stack[sp - 1] = stack[sp - 1] * stack[sp];
+			break;
+		case PROG_DIV:
+			sp--;
+			stack[sp - 1] = stack[sp - 1] / stack[sp];
+			break;
+		case PROG_GREATER:
+			sp--;
+			stack[sp - 1] = stack[sp - 1] > stack[sp];
+			break;
+		case PROG_LESSER:
+			sp--;
+			stack[sp - 1] = stack[sp - 1] < stack[sp];
+			break;
+		case PROG_JUMP_FALSE:
+			if (stack[sp - 1] == 0.0)
+				pc = insn->arg - 1;
+			else
+				sp--;
+			break;
+		case PROG_JUMP_TRUE:
+			if (stack[sp - 1] != 0.0)
+				pc = insn->arg - 1;
+			else
+				sp--;
+			break;
+		}
 	}
+	return stack[0];
+}
+
+double eval_expr(struct prog *prog, struct symbols *symbols)
+{
+	if (prog == NULL || symbols == NULL)
+		return 0.0;
+	return run_prog(prog, symbols);
+}
+
+int eval_rule(struct prog *prog, struct symbols *symbols)
+{
+	if (prog == NULL || symbols == NULL)
+		return 0;
+	return run_prog(prog, symbols) != 0.0;
 }
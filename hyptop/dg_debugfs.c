@@ -14,8 +14,10 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include "dg_debugfs.h"
+#include "dg_record.h"
 #include "helper.h"
 #include "hyptop.h"
 
@@ -50,8 +52,14 @@ int dg_debugfs_init(int exit_on_err)
 {
 	int rc;
 
-	l_debugfs_dir = ht_mount_point_get("debugfs");
-	if (!l_debugfs_dir) {
+	if (g.o.replay_file) {
+		dg_replay_init(g.o.replay_file);
+	} else {
+		l_debugfs_dir = ht_mount_point_get("debugfs");
+		if (g.o.record_file)
+			dg_record_init(g.o.record_file);
+	}
+	if (!l_debugfs_dir && !g.o.replay_file) {
 		if (!exit_on_err)
 			return -ENODEV;
 		ERR_EXIT("Debugfs is not mounted, try \"mount none -t debugfs "
@@ -91,3 +99,48 @@ int dg_debugfs_open(const char *file)
 	else
 		return fh;
 }
+
+/*
+ * Check if a debugfs file is available
+ */
+int dg_debugfs_check(const char *file)
+{
+	int rc;
+
+	if (g.o.replay_file)
+		return dg_replay_check(file);
+	rc = dg_debugfs_open(file);
+	if (rc >= 0) {
+		close(rc);
+		rc = 0;
+	}
+	if (g.o.record_file)
+		dg_record_check(file, rc);
+	return rc;
+}
+
+/*
+ * Read debugfs file into "buf"
+ *
+ * Return number of read bytes or -1 with errno set
+ */
+ssize_t dg_debugfs_read(const char *file, void *buf, size_t size)
+{
+	int fh, err;
+	ssize_t rc;
+
+	if (g.o.replay_file)
+		return dg_replay_read(file, buf, size);
+	fh = dg_debugfs_open(file);
+	if (fh < 0) {
+		errno = -fh;
+		return -1;
+	}
+	rc = read(fh, buf, size);
+	err = errno;
+	close(fh);
+	errno = err;
+	if (rc >= 0 && g.o.record_file)
+		dg_record_read(file, buf, rc);
+	return rc;
+}
@@ -20,6 +20,8 @@ extern int dg_debugfs_init(int exit_on_err);
 extern int dg_debugfs_vm_init(void);
 extern int dg_debugfs_lpar_init(void);
 extern int dg_debugfs_open(const char *file);
+extern int dg_debugfs_check(const char *file);
+extern ssize_t dg_debugfs_read(const char *file, void *buf, size_t size);
 
 /*
  * z/VM diag 0C prototypes
@@ -218,15 +218,12 @@ static void l_read_debugfs(struct l_debugfs_d204_hdr **hdr,
 	long real_buf_size;
 	ssize_t rc;
 	void *buf;
-	int fh;
 
 	do {
-		fh = dg_debugfs_open(DEBUGFS_FILE);
 		*hdr = buf = ht_alloc(l_204_buf_size);
-		rc = read(fh, buf, l_204_buf_size);
+		rc = dg_debugfs_read(DEBUGFS_FILE, buf, l_204_buf_size);
 		if (rc == -1)
 			ERR_EXIT_ERRNO("Reading hypervisor data failed");
-		close(fh);
 		real_buf_size = (*hdr)->len + sizeof(struct l_debugfs_d204_hdr);
 		if (rc == real_buf_size)
 			break;
@@ -304,6 +301,10 @@ static struct sd_sys_item *l_sys_item_vec[] = {
 	&sd_sys_item_thread,
 	&sd_sys_item_mgm,
 	&sd_sys_item_online,
+	&sd_sys_item_hist_min,
+	&sd_sys_item_hist_avg,
+	&sd_sys_item_hist_max,
+	&sd_sys_item_hist_trend,
 	NULL,
 };
 
@@ -334,6 +335,10 @@ static struct sd_cpu_item *l_cpu_item_vec[] = {
 	&sd_cpu_item_thread,
 	&sd_cpu_item_mgm,
 	&sd_cpu_item_online,
+	&sd_cpu_item_hist_min,
+	&sd_cpu_item_hist_avg,
+	&sd_cpu_item_hist_max,
+	&sd_cpu_item_hist_trend,
 	NULL,
 };
 
@@ -375,14 +380,12 @@ static struct sd_dg l_sd_dg = {
  */
 int dg_debugfs_lpar_init(void)
 {
-	int fh;
+	int rc;
 
 	l_204_buf_size = sizeof(struct l_debugfs_d204_hdr);
-	fh = dg_debugfs_open(DEBUGFS_FILE);
-	if (fh < 0)
-		return fh;
-	else
-		close(fh);
+	rc = dg_debugfs_check(DEBUGFS_FILE);
+	if (rc < 0)
+		return rc;
 	sd_dg_register(&l_sd_dg, 1);
 	return 0;
 }
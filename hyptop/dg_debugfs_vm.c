@@ -189,15 +189,12 @@ static void l_read_debugfs(struct l_debugfs_d2fc_hdr **hdr,
 	long real_buf_size;
 	ssize_t rc;
 	void *buf;
-	int fh;
 
 	do {
-		fh = dg_debugfs_open(DEBUGFS_FILE);
 		*hdr = buf = ht_alloc(l_2fc_buf_size);
-		rc = read(fh, buf, l_2fc_buf_size);
+		rc = dg_debugfs_read(DEBUGFS_FILE, buf, l_2fc_buf_size);
 		if (rc == -1)
 			ERR_EXIT_ERRNO("Reading hypervisor data failed");
-		close(fh);
 		real_buf_size = (*hdr)->len + sizeof(struct l_debugfs_d2fc_hdr);
 		if (rc == real_buf_size)
 			break;
@@ -284,6 +281,11 @@ static struct sd_sys_item *l_sys_item_vec[] = {
 	&sd_sys_item_mem_max,
 	&sd_sys_item_weight_cur,
 	&sd_sys_item_weight_max,
+	&sd_sys_item_hist_min,
+	&sd_sys_item_hist_avg,
+	&sd_sys_item_hist_max,
+	&sd_sys_item_hist_trend,
+	&sd_sys_item_hist_mem_trend,
 	NULL,
 };
 
@@ -310,6 +312,10 @@ static struct sd_cpu_item *l_cpu_item_vec[] = {
 	&sd_cpu_item_cpu,
 	&sd_cpu_item_mgm,
 	&sd_cpu_item_online,
+	&sd_cpu_item_hist_min,
+	&sd_cpu_item_hist_avg,
+	&sd_cpu_item_hist_max,
+	&sd_cpu_item_hist_trend,
 	NULL,
 };
 
@@ -346,16 +352,14 @@ static struct sd_dg dg_debugfs_vm_dg = {
  */
 int dg_debugfs_vm_init(void)
 {
-	int fh;
+	int rc;
 
-	fh = dg_debugfs_vmd0c_init();
-	if (fh == 0)
+	rc = dg_debugfs_vmd0c_init();
+	if (rc == 0)
 		l_use_debugfs_vmd0c = 1;
-	fh = dg_debugfs_open(DEBUGFS_FILE);
-	if (fh < 0)
-		return fh;
-	else
-		close(fh);
+	rc = dg_debugfs_check(DEBUGFS_FILE);
+	if (rc < 0)
+		return rc;
 	l_2fc_buf_size = sizeof(struct l_debugfs_d2fc_hdr);
 	l_guest_name_init();
 	sd_dg_register(&dg_debugfs_vm_dg, 0);
@@ -83,17 +83,12 @@ static void l_read_debugfs(struct hypfs_diag0c_hdr **hdr,
 	long real_buf_size;
 	ssize_t rc;
 	void *buf;
-	int fh;
 
 	do {
-		fh = dg_debugfs_open(DEBUGFS_FILE);
-		if (fh < 0)
-			ERR_EXIT_ERRNO("Could not open file: %s", DEBUGFS_FILE);
 		*hdr = buf = ht_alloc(l_0c_buf_size);
-		rc = read(fh, buf, l_0c_buf_size);
+		rc = dg_debugfs_read(DEBUGFS_FILE, buf, l_0c_buf_size);
 		if (rc == -1)
 			ERR_EXIT_ERRNO("Reading hypervisor data failed");
-		close(fh);
 		real_buf_size = (*hdr)->len + sizeof(struct hypfs_diag0c_hdr);
 		if (rc == real_buf_size)
 			break;
@@ -138,13 +133,11 @@ void dg_debugfs_vmd0c_sys_cpu_fill(struct sd_sys *sys, u64 online_time,
  */
 int dg_debugfs_vmd0c_init(void)
 {
-	int fh;
+	int rc;
 
-	fh = dg_debugfs_open(DEBUGFS_FILE);
-	if (fh < 0)
+	rc = dg_debugfs_check(DEBUGFS_FILE);
+	if (rc < 0)
 		return -1;
-	else
-		close(fh);
 	l_0c_buf_size = sizeof(struct hypfs_diag0c_hdr);
 	return 0;
 }
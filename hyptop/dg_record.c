@@ -0,0 +1,277 @@
+/*
+ * hyptop - Show hypervisor performance data on System z
+ *
+ * Record and replay of debugfs hypervisor data
+ *
+ * A recording is a gzip compressed stream that starts with a magic string
+ * followed by one record for each check and read operation on a debugfs
+ * file. On replay the data gatherers perform the same sequence of
+ * operations, which is served from the recording instead of debugfs.
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include "dg_record.h"
+#include "helper.h"
+#include "hyptop.h"
+
+#ifdef HAVE_ZLIB
+
+#include <zlib.h>
+
+#define DG_REC_MAGIC		"HYPTOPR1"
+#define DG_REC_MAGIC_LEN	8
+#define DG_REC_NAME_MAX		255
+
+/*
+ * Record types
+ */
+enum dg_rec_type {
+	DG_REC_CHECK	= 1,
+	DG_REC_READ	= 2,
+};
+
+/*
+ * Record header: Followed by "name_len" bytes file name and "len" bytes data
+ */
+struct dg_rec_hdr {
+	u8	type;
+	u8	name_len;
+	u8	reserved[2];
+	s32	rc;
+	u64	time_us;
+	u64	len;
+} __attribute__ ((packed));
+
+static gzFile		l_file;
+static const char	*l_path;
+static u64		l_time_start_us;
+static u64		l_time_last_us;
+static struct dg_rec_hdr l_next;
+static char		l_next_name[DG_REC_NAME_MAX + 1];
+static int		l_next_valid;
+
+/*
+ * Get monotonic time in microseconds
+ */
+static u64 l_time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * Write buffer to recording
+ */
+static void l_write(const void *buf, size_t len)
+{
+	if (len == 0)
+		return;
+	if (gzwrite(l_file, buf, len) != (int) len)
+		ERR_EXIT("Could not write recording \"%s\"\n", l_path);
+}
+
+/*
+ * Write record to recording
+ */
+static void l_record_write(enum dg_rec_type type, const char *file, int rc,
+			   const void *buf, size_t len)
+{
+	struct dg_rec_hdr hdr;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.type = type;
+	hdr.name_len = MIN(strlen(file), (size_t) DG_REC_NAME_MAX);
+	hdr.rc = rc;
+	hdr.time_us = l_time_us() - l_time_start_us;
+	hdr.len = len;
+	l_write(&hdr, sizeof(hdr));
+	l_write(file, hdr.name_len);
+	l_write(buf, len);
+}
+
+/*
+ * Close recording at exit to write the gzip trailer
+ */
+static void l_record_exit(void)
+{
+	gzclose(l_file);
+}
+
+/*
+ * Start recording to file "path"
+ */
+void dg_record_init(const char *path)
+{
+	l_path = path;
+	l_file = gzopen(path, "wb");
+	if (!l_file)
+		ERR_EXIT_ERRNO("Could not open recording \"%s\"", path);
+	l_time_start_us = l_time_us();
+	l_write(DG_REC_MAGIC, DG_REC_MAGIC_LEN);
+	atexit(l_record_exit);
+}
+
+/*
+ * Record result of a debugfs file check
+ */
+void dg_record_check(const char *file, int rc)
+{
+	l_record_write(DG_REC_CHECK, file, rc, NULL, 0);
+}
+
+/*
+ * Record data read from a debugfs file
+ *
+ * Flush after each read, so that the recording is usable up to the last
+ * update also when hyptop is killed.
+ */
+void dg_record_read(const char *file, const void *buf, ssize_t len)
+{
+	l_record_write(DG_REC_READ, file, 0, buf, len);
+	if (gzflush(l_file, Z_SYNC_FLUSH) != Z_OK)
+		ERR_EXIT("Could not write recording \"%s\"\n", l_path);
+}
+
+/*
+ * Read next record header from recording
+ *
+ * A short read means end of recording. This is also the case for
+ * recordings without gzip trailer.
+ */
+static void l_replay_next(void)
+{
+	l_next_valid = 0;
+	if (gzread(l_file, &l_next, sizeof(l_next)) != sizeof(l_next))
+		return;
+	if (gzread(l_file, l_next_name, l_next.name_len) != l_next.name_len)
+		return;
+	l_next_name[l_next.name_len] = 0;
+	l_next_valid = 1;
+}
+
+/*
+ * Get next record of "type" for "file" or exit at end of recording
+ */
+static struct dg_rec_hdr *l_replay_get(enum dg_rec_type type,
+				       const char *file)
+{
+	if (!l_next_valid)
+		hyptop_exit(0);
+	if (l_next.type != type || strcmp(l_next_name, file) != 0)
+		ERR_EXIT("Recording \"%s\" does not match data gatherer\n",
+			 l_path);
+	return &l_next;
+}
+
+/*
+ * Start replay of recording in file "path"
+ */
+void dg_replay_init(const char *path)
+{
+	char magic[DG_REC_MAGIC_LEN];
+
+	l_path = path;
+	l_file = gzopen(path, "rb");
+	if (!l_file)
+		ERR_EXIT_ERRNO("Could not open recording \"%s\"", path);
+	if (gzread(l_file, magic, sizeof(magic)) != sizeof(magic) ||
+	    memcmp(magic, DG_REC_MAGIC, sizeof(magic)) != 0)
+		ERR_EXIT("File \"%s\" is not a hyptop recording\n", path);
+	l_replay_next();
+	l_time_last_us = l_next_valid ? l_next.time_us : 0;
+}
+
+/*
+ * Replay check of a debugfs file
+ */
+int dg_replay_check(const char *file)
+{
+	int rc;
+
+	rc = l_replay_get(DG_REC_CHECK, file)->rc;
+	l_replay_next();
+	return rc;
+}
+
+/*
+ * Replay read of a debugfs file
+ *
+ * As for debugfs, the data is truncated if "buf" is too small.
+ */
+ssize_t dg_replay_read(const char *file, void *buf, size_t size)
+{
+	struct dg_rec_hdr *hdr = l_replay_get(DG_REC_READ, file);
+	size_t len = MIN(hdr->len, size);
+
+	if (gzread(l_file, buf, len) != (int) len)
+		ERR_EXIT("Recording \"%s\" is truncated\n", l_path);
+	if (hdr->len > len &&
+	    gzseek(l_file, hdr->len - len, SEEK_CUR) == -1)
+		ERR_EXIT("Recording \"%s\" is truncated\n", l_path);
+	l_time_last_us = hdr->time_us;
+	l_replay_next();
+	return len;
+}
+
+/*
+ * Get time until the next recorded update should be replayed
+ */
+u64 dg_replay_delay_us(void)
+{
+	if (!l_next_valid || g.o.replay_speed == 0)
+		return 0;
+	if (l_next.time_us <= l_time_last_us)
+		return 0;
+	return (l_next.time_us - l_time_last_us) / g.o.replay_speed;
+}
+
+#else /* HAVE_ZLIB */
+
+/*
+ * Without zlib, record and replay are rejected during option parsing,
+ * so the following functions are never called
+ */
+void dg_record_init(const char *UNUSED(path))
+{
+}
+
+void dg_record_check(const char *UNUSED(file), int UNUSED(rc))
+{
+}
+
+void dg_record_read(const char *UNUSED(file), const void *UNUSED(buf),
+		    ssize_t UNUSED(len))
+{
+}
+
+void dg_replay_init(const char *UNUSED(path))
+{
+}
+
+int dg_replay_check(const char *UNUSED(file))
+{
+	return -ENOENT;
+}
+
+ssize_t dg_replay_read(const char *UNUSED(file), void *UNUSED(buf),
+		       size_t UNUSED(size))
+{
+	return -EIO;
+}
+
+u64 dg_replay_delay_us(void)
+{
+	return 0;
+}
+
+#endif /* HAVE_ZLIB */
@@ -0,0 +1,34 @@
+/*
+ * hyptop - Show hypervisor performance data on System z
+ *
+ * Record and replay of debugfs hypervisor data
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef DG_RECORD_H
+#define DG_RECORD_H
+
+#include <sys/types.h>
+
+#include "helper.h"
+
+/*
+ * Record functions
+ */
+void dg_record_init(const char *path);
+void dg_record_check(const char *file, int rc);
+void dg_record_read(const char *file, const void *buf, ssize_t len);
+
+/*
+ * Replay functions
+ */
+void dg_replay_init(const char *path);
+int dg_replay_check(const char *file);
+ssize_t dg_replay_read(const char *file, void *buf, size_t size);
+u64 dg_replay_delay_us(void);
+
+#endif /* DG_RECORD_H */
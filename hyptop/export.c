@@ -0,0 +1,313 @@
+/*
+ * hyptop - Show hypervisor performance data on System z
+ *
+ * Structured export of system data
+ *
+ * Instead of formatting the window tables, the selected fields of the
+ * selected systems (window "sys_list") or of the CPUs of the selected
+ * system (window "sys") are written in one of the util_fmt formats.
+ * All values are raw numbers: Times are in microseconds and values
+ * "per second" are the deltas to the previous update divided by the
+ * elapsed time.
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lib/util_fmt.h"
+
+#include "export.h"
+#include "helper.h"
+#include "hyptop.h"
+#include "opts.h"
+#include "sd.h"
+#include "table.h"
+
+#define EXPORT_API_LEVEL	1
+#define EXPORT_KEY_SIZE		(TABLE_HEADING_SIZE + 8)
+
+#define KEY_ITERATION		"iteration"
+#define KEY_TIME		"time_us"
+#define KEY_INTERVAL		"interval_us"
+#define KEY_SYSTEM		"system"
+#define KEY_CPU			"cpuid"
+
+/*
+ * Exported system and CPU items with keys
+ */
+struct export_sys_item {
+	struct sd_sys_item	*item;
+	char			key[EXPORT_KEY_SIZE];
+};
+
+struct export_cpu_item {
+	struct sd_cpu_item	*item;
+	char			key[EXPORT_KEY_SIZE];
+};
+
+static struct export_sys_item	*l_sys_item_vec;
+static unsigned int		l_sys_item_cnt;
+static struct export_cpu_item	*l_cpu_item_vec;
+static unsigned int		l_cpu_item_cnt;
+static unsigned int		l_iteration;
+static u64			l_update_time_us;
+static int			l_list_open;
+
+/*
+ * Generate key out of column heading, e.g. "#core" -> "core_cnt" and
+ * "core+" -> "core_total"
+ */
+static void l_key_gen(char *key, const char *head)
+{
+	const char *suffix = "";
+	int len;
+
+	if (head[0] == '#') {
+		head++;
+		suffix = "_cnt";
+	}
+	len = strlen(head);
+	if (len > 0 && head[len - 1] == '+') {
+		len--;
+		suffix = "_total";
+	}
+	snprintf(key, EXPORT_KEY_SIZE, "%.*s%s", len, head, suffix);
+	for (; *key; key++) {
+		if (*key == ' ')
+			*key = '_';
+	}
+}
+
+/*
+ * Setup vectors of enabled system and CPU items
+ */
+static void l_items_init(void)
+{
+	struct sd_sys_item *sys_item;
+	struct sd_cpu_item *cpu_item;
+	struct table_col *col;
+	unsigned int i;
+
+	l_sys_item_vec = ht_zalloc(sizeof(*l_sys_item_vec) * sd_sys_item_cnt());
+	sd_sys_item_iterate(sys_item, i) {
+		col = sd_sys_item_table_col(sys_item);
+		if (!table_col_enabled(col))
+			continue;
+		l_sys_item_vec[l_sys_item_cnt].item = sys_item;
+		l_key_gen(l_sys_item_vec[l_sys_item_cnt].key,
+			  table_col_head(col));
+		l_sys_item_cnt++;
+	}
+	l_cpu_item_vec = ht_zalloc(sizeof(*l_cpu_item_vec) * sd_cpu_item_cnt());
+	sd_cpu_item_iterate(cpu_item, i) {
+		col = sd_cpu_item_table_col(cpu_item);
+		if (!table_col_enabled(col))
+			continue;
+		l_cpu_item_vec[l_cpu_item_cnt].item = cpu_item;
+		l_key_gen(l_cpu_item_vec[l_cpu_item_cnt].key,
+			  table_col_head(col));
+		l_cpu_item_cnt++;
+	}
+}
+
+/*
+ * Register keys so that CSV output gets a stable column list
+ */
+static void l_keys_add(void)
+{
+	unsigned int i;
+
+	util_fmt_add_key(KEY_ITERATION);
+	util_fmt_add_key(KEY_TIME);
+	util_fmt_add_key(KEY_INTERVAL);
+	if (g.o.cur_win == &win_sys) {
+		util_fmt_add_key(KEY_SYSTEM);
+		util_fmt_add_key(KEY_CPU);
+		for (i = 0; i < l_cpu_item_cnt; i++)
+			util_fmt_add_key("%s", l_cpu_item_vec[i].key);
+	} else {
+		util_fmt_add_key(KEY_SYSTEM);
+		for (i = 0; i < l_sys_item_cnt; i++)
+			util_fmt_add_key("%s", l_sys_item_vec[i].key);
+	}
+}
+
+/*
+ * Export system item
+ */
+static void l_sys_item_export(struct sd_sys *sys, struct export_sys_item *e)
+{
+	struct sd_sys_item *item = e->item;
+
+	if (!sd_sys_item_set(sys, item)) {
+		util_fmt_pair(FMT_INVAL, e->key, "");
+		return;
+	}
+	switch (sd_sys_item_type(item)) {
+	case SD_TYPE_U64:
+	case SD_TYPE_U32:
+	case SD_TYPE_U16:
+		util_fmt_pair(FMT_DEFAULT, e->key, "%llu",
+			      sd_sys_item_u64(sys, item));
+		break;
+	case SD_TYPE_S64:
+		util_fmt_pair(FMT_DEFAULT, e->key, "%lld",
+			      sd_sys_item_s64(sys, item));
+		break;
+	case SD_TYPE_STR:
+		util_fmt_pair(FMT_QUOTE, e->key, "%s",
+			      sd_sys_item_str(sys, item));
+		break;
+	}
+}
+
+/*
+ * Export CPU item
+ */
+static void l_cpu_item_export(struct sd_cpu *cpu, struct export_cpu_item *e)
+{
+	struct sd_cpu_item *item = e->item;
+
+	if (!sd_cpu_item_set(item, cpu)) {
+		util_fmt_pair(FMT_INVAL, e->key, "");
+		return;
+	}
+	switch (sd_cpu_item_type(item)) {
+	case SD_TYPE_U64:
+	case SD_TYPE_U32:
+	case SD_TYPE_U16:
+		util_fmt_pair(FMT_DEFAULT, e->key, "%llu",
+			      sd_cpu_item_u64(item, cpu));
+		break;
+	case SD_TYPE_S64:
+		util_fmt_pair(FMT_DEFAULT, e->key, "%lld",
+			      (s64) sd_cpu_item_s64(item, cpu));
+		break;
+	case SD_TYPE_STR:
+		util_fmt_pair(FMT_QUOTE, e->key, "%s",
+			      sd_cpu_item_str(item, cpu));
+		break;
+	}
+}
+
+/*
+ * Export all selected systems
+ */
+static void l_sys_list_export(void)
+{
+	struct sd_sys *parent, *sys;
+	unsigned int i;
+
+	parent = sd_sys_root_get();
+	util_fmt_obj_start(FMT_LIST, "systems");
+	sd_sys_iterate(parent, sys) {
+		if (!opts_sys_specified(&win_sys_list, sd_sys_id(sys)))
+			continue;
+		util_fmt_obj_start(FMT_ROW, NULL);
+		util_fmt_pair(FMT_QUOTE, KEY_SYSTEM, "%s", sd_sys_id(sys));
+		for (i = 0; i < l_sys_item_cnt; i++)
+			l_sys_item_export(sys, &l_sys_item_vec[i]);
+		util_fmt_obj_end();
+	}
+	util_fmt_obj_end();
+}
+
+/*
+ * Export all CPUs of the selected system
+ */
+static void l_sys_export(void)
+{
+	const char *sys_id = win_sys.opts.sys.vec[0];
+	struct sd_sys *sys;
+	struct sd_cpu *cpu;
+	unsigned int i;
+
+	sys = sd_sys_get(sd_sys_root_get(), sys_id);
+	if (!sys)
+		ERR_EXIT("System \"%s\" not available.\n", sys_id);
+	util_fmt_obj_start(FMT_LIST, "cpus");
+	sd_cpu_iterate(sys, cpu) {
+		util_fmt_obj_start(FMT_ROW, NULL);
+		util_fmt_pair(FMT_QUOTE | FMT_PERSIST, KEY_SYSTEM, "%s",
+			      sd_sys_id(sys));
+		util_fmt_pair(FMT_QUOTE, KEY_CPU, "%s", sd_cpu_id(cpu));
+		for (i = 0; i < l_cpu_item_cnt; i++)
+			l_cpu_item_export(cpu, &l_cpu_item_vec[i]);
+		util_fmt_obj_end();
+	}
+	util_fmt_obj_end();
+}
+
+/*
+ * Export one update
+ */
+static void l_export(void)
+{
+	u64 update_time_us = sd_sys_root_get()->update_time_us;
+
+	util_fmt_obj_start(FMT_DEFAULT, NULL);
+	util_fmt_pair(FMT_PERSIST, KEY_ITERATION, "%u", l_iteration++);
+	util_fmt_pair(FMT_PERSIST, KEY_TIME, "%llu", update_time_us);
+	if (l_update_time_us)
+		util_fmt_pair(FMT_PERSIST, KEY_INTERVAL, "%llu",
+			      l_sub_64(update_time_us, l_update_time_us));
+	else
+		util_fmt_pair(FMT_PERSIST | FMT_INVAL, KEY_INTERVAL, "");
+	l_update_time_us = update_time_us;
+	if (g.o.cur_win == &win_sys)
+		l_sys_export();
+	else
+		l_sys_list_export();
+	util_fmt_obj_end();
+	/* Allow immediate consumption of each update through pipes */
+	fflush(stdout);
+}
+
+/*
+ * Complete output at exit
+ */
+static void l_export_exit(void)
+{
+	if (l_list_open)
+		util_fmt_obj_end();
+	util_fmt_exit();
+}
+
+/*
+ * Initialize util_fmt
+ */
+static void l_fmt_init(void)
+{
+	unsigned int flags = FMT_DEFAULT;
+
+	/* Ensure correct JSON even if interrupted */
+	if (g.o.format == FMT_JSON || g.o.format == FMT_JSONSEQ)
+		flags |= FMT_HANDLEINT;
+	util_fmt_init(stdout, g.o.format, flags, EXPORT_API_LEVEL);
+	util_fmt_set_indent(0, 2, ' ');
+	l_keys_add();
+	atexit(l_export_exit);
+	if (g.o.format != FMT_JSONSEQ) {
+		util_fmt_obj_start(FMT_LIST, NULL);
+		l_list_open = 1;
+	}
+}
+
+/*
+ * Export loop: Write one record for each update
+ */
+void export_run(void)
+{
+	l_items_init();
+	l_fmt_init();
+	while (1) {
+		l_export();
+		hyptop_process_input_timeout();
+		sd_update();
+	}
+}
@@ -0,0 +1,19 @@
+/*
+ * hyptop - Show hypervisor performance data on System z
+ *
+ * Structured export of system data
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "lib/zt_common.h"
+
+void __noreturn export_run(void);
+
+#endif /* EXPORT_H */
@@ -19,6 +19,8 @@
 #include <time.h>
 
 #include "dg_debugfs.h"
+#include "dg_record.h"
+#include "export.h"
 #include "helper.h"
 #include "hyptop.h"
 #include "opts.h"
@@ -118,16 +120,26 @@ static enum hyptop_win_action l_sleep(time_t time_s, long time_us)
 
 /*
  * External process input with timeout funciton
+ *
+ * On replay the delay is taken from the recording.
  */
 enum hyptop_win_action hyptop_process_input_timeout(void)
 {
+	time_t delay_s = g.o.delay_s;
+	long delay_us = g.o.delay_us;
 	enum hyptop_win_action rc;
+	u64 replay_delay_us;
 
+	if (g.o.replay_file) {
+		replay_delay_us = dg_replay_delay_us();
+		delay_s = replay_delay_us / 1000000;
+		delay_us = replay_delay_us % 1000000;
+	}
 	if (g.o.batch_mode_specified) {
 		opts_iterations_next();
-		rc = l_sleep(g.o.delay_s, g.o.delay_us);
+		rc = l_sleep(delay_s, delay_us);
 	} else {
-		rc = l_process_input_timeout(g.o.delay_s, g.o.delay_us);
+		rc = l_process_input_timeout(delay_s, delay_us);
 		opts_iterations_next();
 	}
 	return rc;
@@ -223,8 +235,12 @@ static void l_term_check(void)
  */
 static void l_term_init(void)
 {
-	if (g.o.batch_mode_specified)
+	if (g.o.batch_mode_specified) {
+		/* Exit properly to complete the recording */
+		if (g.o.record_file)
+			l_sig_handler_init();
 		return;
+	}
 
 	l_term_check();
 
@@ -252,6 +268,11 @@ fail:
 #ifdef WITH_HYPFS
 static void l_dg_init(void)
 {
+	/* Record and replay is only supported for debugfs */
+	if (g.o.record_file || g.o.replay_file) {
+		dg_debugfs_init(1);
+		return;
+	}
 	if (dg_debugfs_init(0) == 0)
 		return;
 	if (dg_hypfs_init() == 0)
@@ -369,6 +390,8 @@ int main(int argc, char *argv[])
 	win_sys_list_init();
 	win_sys_init();
 	g.win_cpu_types = win_cpu_types_new();
+	if (g.o.format_specified)
+		export_run();
 	l_event_loop();
 	return 0;
 }
@@ -17,12 +17,15 @@
 #include <stdlib.h>
 #include <termios.h>
 
+#include "lib/util_fmt.h"
+
 #include "helper.h"
 #include "nav_desc.h"
 #include "table.h"
 
 #define HYPTOP_OPT_DEFAULT_DELAY	2
 #define HYPTOP_OPT_DEFAULT_SMT_SCALE	1.3
+#define HYPTOP_OPT_DEFAULT_HISTORY	60
 #define HYPTOP_MAX_WIN_DEPTH		4
 #define HYPTOP_MAX_LINE			512
 #define PROG_NAME			"hyptop"
@@ -63,6 +66,15 @@ struct hyptop_opts {
 	int				delay_us;
 
 	double				smt_factor;
+
+	char				*record_file;
+	char				*replay_file;
+	double				replay_speed;
+
+	unsigned int			format_specified;
+	enum util_fmt_t			format;
+
+	unsigned int			history_depth;
 };
 
 /*
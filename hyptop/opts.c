@@ -22,6 +22,10 @@
 
 static const char l_copyright_str[] = "Copyright IBM Corp. 2010, 2017";
 
+#define OPT_REPLAY_SPEED	256
+#define OPT_FORMAT		257
+#define OPT_HISTORY		258
+
 /*
  * Help text for tool
  */
@@ -39,8 +43,14 @@ static char HELP_TEXT[] =
 "-t, --cpu_types TYPE[,..]       CPU types used for time calculations\n"
 "-b, --batch_mode                Use batch mode (no curses)\n"
 "-d, --delay SECONDS             Delay time between screen updates\n"
+"    --format FORMAT             Export data in FORMAT (implies batch mode):\n"
+"                                json, json-seq, pairs, csv\n"
+"    --history NUMBER            Number of updates kept for history fields\n"
 "-m, --smt_factor FACTOR         Machine generation dependent SMT speedup factor.\n"
-"-n, --iterations NUMBER         Number of iterations before ending\n";
+"-n, --iterations NUMBER         Number of iterations before ending\n"
+"-r, --record FILE               Record hypervisor data to FILE\n"
+"-p, --replay FILE               Replay hypervisor data from FILE\n"
+"    --replay_speed FACTOR       Replay speed factor (0 for no delay)\n";
 
 /*
  * Initialize default settings
@@ -50,6 +60,8 @@ static void l_init_defaults(void)
 	g.prog_name = PROG_NAME;
 	g.o.delay_s = HYPTOP_OPT_DEFAULT_DELAY;
 	g.o.smt_factor = HYPTOP_OPT_DEFAULT_SMT_SCALE;
+	g.o.replay_speed = 1;
+	g.o.history_depth = HYPTOP_OPT_DEFAULT_HISTORY;
 	g.w.cur = &win_sys_list;
 	g.o.cur_win = &win_sys_list;
 }
@@ -97,17 +109,30 @@ static int l_number_check(const char *str)
 }
 
 /*
- * Set delay option
+ * Set delay option (fractions of seconds are allowed)
  */
 static void l_delay_set(char *delay_string)
 {
-	int secs;
+	double secs;
+	char *end;
 
-	l_number_check(delay_string);
-	if (sscanf(delay_string, "%i", &secs) != 1)
+	secs = strtod(delay_string, &end);
+	if (end == delay_string || *end != 0 || secs < 0 || secs > INT_MAX)
 		ERR_EXIT("The delay value \"%s\" is invalid\n", delay_string);
 	g.o.delay_s = secs;
-	g.o.delay_us = 0;
+	g.o.delay_us = (secs - g.o.delay_s) * 1000000;
+}
+
+/*
+ * Set export format option
+ */
+static void l_format_set(const char *str)
+{
+	if (!util_fmt_name_to_type(str, &g.o.format))
+		ERR_EXIT("The format \"%s\" is unknown, supported formats: "
+			 FMT_TYPE_NAMES "\n", str);
+	g.o.format_specified = 1;
+	g.o.batch_mode_specified = 1;
 }
 
 /*
@@ -124,6 +149,20 @@ static void l_factor_set(char *value_string)
 	g.o.smt_factor = factor;
 }
 
+/*
+ * Set replay speed option
+ */
+static void l_replay_speed_set(char *value_string)
+{
+	double speed;
+
+	if (sscanf(value_string, "%lf", &speed) != 1)
+		ERR_EXIT("The replay speed \"%s\" is invalid\n", value_string);
+	if (speed < 0)
+		ERR_EXIT("The replay speed \"%s\" is < 0\n", value_string);
+	g.o.replay_speed = speed;
+}
+
 /*
  * Get number of occurrences of character 'c' in "str"
  */
@@ -279,6 +318,17 @@ static void l_iterations_set(const char *str)
 	g.o.iterations = atoi(str);
 }
 
+/*
+ * Set the "--history" option
+ */
+static void l_history_set(const char *str)
+{
+	l_number_check(str);
+	g.o.history_depth = atoi(str);
+	if (g.o.history_depth == 0)
+		ERR_EXIT("The history depth must be greater than 0\n");
+}
+
 /*
  * Set the "--batch_mode" option
  */
@@ -294,6 +344,14 @@ static void l_parse_finish(void)
 {
 	if (g.o.iterations_specified && g.o.iterations == 0)
 		hyptop_exit(0);
+	if (g.o.record_file && g.o.replay_file)
+		ERR_EXIT("The options \"--record\" and \"--replay\" cannot "
+			 "be specified together\n");
+#ifndef HAVE_ZLIB
+	if (g.o.record_file || g.o.replay_file)
+		ERR_EXIT("The options \"--record\" and \"--replay\" are not "
+			 "supported: hyptop was built without zlib\n");
+#endif
 	if (g.o.cur_win != &win_sys)
 		return;
 	if (!win_sys.opts.sys.specified)
@@ -322,9 +380,14 @@ void opts_parse(int argc, char *argv[])
 		{ "fields",      required_argument, NULL, 'f'},
 		{ "sort_field",  required_argument, NULL, 'S'},
 		{ "cpu_types",   required_argument, NULL, 't'},
+		{ "record",      required_argument, NULL, 'r'},
+		{ "replay",      required_argument, NULL, 'p'},
+		{ "replay_speed", required_argument, NULL, OPT_REPLAY_SPEED},
+		{ "format",      required_argument, NULL, OPT_FORMAT},
+		{ "history",     required_argument, NULL, OPT_HISTORY},
 		{ NULL,          0,                 NULL, 0  }
 	};
-	static const char option_string[] = "vhbd:m:w:s:n:f:t:S:";
+	static const char option_string[] = "vhbd:m:w:s:n:f:t:S:r:p:";
 
 	l_init_defaults();
 	while (1) {
@@ -366,6 +429,21 @@ void opts_parse(int argc, char *argv[])
 		case 'S':
 			l_sort_field_set(optarg);
 			break;
+		case 'r':
+			g.o.record_file = optarg;
+			break;
+		case 'p':
+			g.o.replay_file = optarg;
+			break;
+		case OPT_REPLAY_SPEED:
+			l_replay_speed_set(optarg);
+			break;
+		case OPT_FORMAT:
+			l_format_set(optarg);
+			break;
+		case OPT_HISTORY:
+			l_history_set(optarg);
+			break;
 		default:
 			l_std_usage_exit();
 		}
@@ -434,7 +512,7 @@ void opts_iterations_next(void)
 		if (g.o.iterations_act >= g.o.iterations)
 			hyptop_exit(0);
 	}
-	if (g.o.batch_mode_specified)
+	if (g.o.batch_mode_specified && !g.o.format_specified)
 		printf("---------------------------------------------------"
 		       "----------------------------\n");
 }
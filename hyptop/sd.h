@@ -19,6 +19,8 @@
 
 #define SD_DG_INIT_INTERVAL_SEC	1
 #define SD_SYS_ID_SIZE		9
+#define SD_HASH_BUCKET_CNT_MIN	16
+#define SD_HIST_TREND_LEN	16
 
 /*
  * CPU info
@@ -70,24 +72,65 @@ struct sd_info {
 
 struct sd_cpu;
 
+/*
+ * SD hash index for looking up systems and CPUs by ID
+ */
+struct sd_hash_node {
+	struct sd_hash_node	*next;
+	const char		*id;
+	void			*entry;
+};
+
+struct sd_hash {
+	struct sd_hash_node	**bucket_vec;
+	u32			bucket_cnt;
+	u32			entry_cnt;
+};
+
+/*
+ * SD history: Ring buffer with one array of samples for each value
+ */
+enum sd_hist_val {
+	SD_HIST_CPU,
+	SD_HIST_MEM,
+	SD_HIST_VAL_CNT,
+};
+
+struct sd_hist {
+	u64	*vec;
+	u32	pos;
+	u32	cnt;
+};
+
+void sd_hist_update(struct sd_sys *root);
+void sd_hist_free(struct sd_hist *hist);
+u64 sd_hist_min(struct sd_hist *hist, enum sd_hist_val val);
+u64 sd_hist_max(struct sd_hist *hist, enum sd_hist_val val);
+u64 sd_hist_avg(struct sd_hist *hist, enum sd_hist_val val);
+void sd_hist_trend(struct sd_hist *hist, enum sd_hist_val val, char *str);
+
 /*
  * SD System (can be e.g. CEC, VM or guest/LPAR)
  */
 struct sd_sys {
 	struct util_list_node	list;
+	struct sd_hash_node	hash_node;
 	struct sd_info		i;
 	u64			update_time_us;
 	u32			child_cnt;
 	u32			child_cnt_active;
 	struct util_list	child_list;
+	struct sd_hash		child_hash;
 	u32			cpu_cnt;
 	u32			cpu_cnt_active;
 	struct util_list	cpu_list;
+	struct sd_hash		cpu_hash;
 	u32			threads_per_core;
 	char			id[SD_SYS_ID_SIZE];
 	struct sd_sys_name	name;
 	struct sd_mem		mem;
 	struct sd_weight	weight;
+	struct sd_hist		hist;
 };
 
 #define sd_sys_id(sys) ((sys)->id)
@@ -192,6 +235,7 @@ enum sd_cpu_state {
 
 struct sd_cpu {
 	struct util_list_node	list;
+	struct sd_hash_node	hash_node;
 	struct sd_info		i;
 	char			id[9];
 	struct sd_cpu_type	*type;
@@ -202,6 +246,7 @@ struct sd_cpu {
 	u16			cnt;
 	int			threads_per_core;
 	enum sd_cpu_state	state;
+	struct sd_hist		hist;
 };
 
 static inline char *sd_cpu_state_str(enum sd_cpu_state state)
@@ -353,6 +398,11 @@ extern struct sd_cpu_item sd_cpu_item_wait;
 extern struct sd_cpu_item sd_cpu_item_steal;
 extern struct sd_cpu_item sd_cpu_item_online;
 
+extern struct sd_cpu_item sd_cpu_item_hist_min;
+extern struct sd_cpu_item sd_cpu_item_hist_avg;
+extern struct sd_cpu_item sd_cpu_item_hist_max;
+extern struct sd_cpu_item sd_cpu_item_hist_trend;
+
 /*
  * System item
  */
@@ -365,6 +415,7 @@ struct sd_sys_item {
 	int (*fn_set)(struct sd_sys_item *, struct sd_sys *);
 	u64 (*fn_u64)(struct sd_sys_item *, struct sd_sys *);
 	s64 (*fn_s64)(struct sd_sys_item *, struct sd_sys *);
+	char *(*fn_str)(struct sd_sys_item *, struct sd_sys *);
 };
 
 #define sd_sys_item_table_col(item) (&item->table_col)
@@ -396,7 +447,10 @@ static inline s64 sd_sys_item_s64(struct sd_sys *sys,
 static inline char *sd_sys_item_str(struct sd_sys *sys,
 				    struct sd_sys_item *item)
 {
-	return ((char *) sys) + item->offset;
+	if (item->fn_str)
+		return item->fn_str(item, sys);
+	else
+		return ((char *) sys) + item->offset;
 }
 
 /*
@@ -437,6 +491,12 @@ extern struct sd_sys_item sd_sys_item_os_name;
 extern struct sd_sys_item sd_sys_item_samples_total;
 extern struct sd_sys_item sd_sys_item_samples_cpu_using;
 
+extern struct sd_sys_item sd_sys_item_hist_min;
+extern struct sd_sys_item sd_sys_item_hist_avg;
+extern struct sd_sys_item sd_sys_item_hist_max;
+extern struct sd_sys_item sd_sys_item_hist_trend;
+extern struct sd_sys_item sd_sys_item_hist_mem_trend;
+
 /*
  * Data gatherer backend
  */
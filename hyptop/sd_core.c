@@ -166,7 +166,9 @@ void sd_dg_register(struct sd_dg *dg, int has_core_data)
 		l_cpu_item_cnt++;
 
 	sd_update();
-	nanosleep(&ts, NULL);
+	/* On replay the recorded data already contains the delay */
+	if (!g.o.replay_file)
+		nanosleep(&ts, NULL);
 	sd_update();
 
 	l_cpu_types_init();
@@ -181,19 +183,102 @@ int sd_dg_has_core_data(void)
 }
 
 /*
- * Get CPU from sys by ID
+ * Hash function for IDs (FNV-1a)
  */
-struct sd_cpu *sd_cpu_get(struct sd_sys *sys, const char* id)
+static u32 l_hash_fn(const char *id)
 {
-	struct sd_cpu *cpu;
+	u32 hash = 2166136261U;
+
+	while (*id) {
+		hash ^= (unsigned char) *id++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
 
-	util_list_iterate(&sys->cpu_list, cpu) {
-		if (strcmp(cpu->id, id) == 0)
-			return cpu;
+/*
+ * Find entry with ID in hash
+ */
+static void *l_hash_lookup(struct sd_hash *hash, const char *id)
+{
+	struct sd_hash_node *node;
+
+	if (!hash->bucket_cnt)
+		return NULL;
+	node = hash->bucket_vec[l_hash_fn(id) & (hash->bucket_cnt - 1)];
+	for (; node; node = node->next) {
+		if (strcmp(node->id, id) == 0)
+			return node->entry;
 	}
 	return NULL;
 }
 
+/*
+ * Resize hash to "bucket_cnt" buckets (must be a power of two)
+ */
+static void l_hash_resize(struct sd_hash *hash, u32 bucket_cnt)
+{
+	struct sd_hash_node **bucket_vec, *node, *next;
+	u32 i, idx;
+
+	bucket_vec = ht_zalloc(sizeof(*bucket_vec) * bucket_cnt);
+	for (i = 0; i < hash->bucket_cnt; i++) {
+		for (node = hash->bucket_vec[i]; node; node = next) {
+			next = node->next;
+			idx = l_hash_fn(node->id) & (bucket_cnt - 1);
+			node->next = bucket_vec[idx];
+			bucket_vec[idx] = node;
+		}
+	}
+	ht_free(hash->bucket_vec);
+	hash->bucket_vec = bucket_vec;
+	hash->bucket_cnt = bucket_cnt;
+}
+
+/*
+ * Add entry to hash
+ */
+static void l_hash_add(struct sd_hash *hash, struct sd_hash_node *node,
+		       const char *id, void *entry)
+{
+	u32 idx;
+
+	if (hash->entry_cnt >= hash->bucket_cnt)
+		l_hash_resize(hash, hash->bucket_cnt ? hash->bucket_cnt * 2 :
+			      SD_HASH_BUCKET_CNT_MIN);
+	node->id = id;
+	node->entry = entry;
+	idx = l_hash_fn(id) & (hash->bucket_cnt - 1);
+	node->next = hash->bucket_vec[idx];
+	hash->bucket_vec[idx] = node;
+	hash->entry_cnt++;
+}
+
+/*
+ * Remove entry from hash
+ */
+static void l_hash_remove(struct sd_hash *hash, struct sd_hash_node *node)
+{
+	struct sd_hash_node **ptr;
+
+	ptr = &hash->bucket_vec[l_hash_fn(node->id) & (hash->bucket_cnt - 1)];
+	for (; *ptr; ptr = &(*ptr)->next) {
+		if (*ptr == node) {
+			*ptr = node->next;
+			hash->entry_cnt--;
+			return;
+		}
+	}
+}
+
+/*
+ * Get CPU from sys by ID
+ */
+struct sd_cpu *sd_cpu_get(struct sd_sys *sys, const char* id)
+{
+	return l_hash_lookup(&sys->cpu_hash, id);
+}
+
 /*
  * Get CPU type by ID
  */
@@ -225,6 +310,7 @@ struct sd_cpu *sd_cpu_new(struct sd_sys *parent, const char *id,
 	cpu->cnt = cnt;
 
 	util_list_add_tail(&parent->cpu_list, cpu);
+	l_hash_add(&parent->cpu_hash, &cpu->hash_node, cpu->id, cpu);
 
 	return cpu;
 }
@@ -234,13 +320,7 @@ struct sd_cpu *sd_cpu_new(struct sd_sys *parent, const char *id,
  */
 struct sd_sys *sd_sys_get(struct sd_sys *parent, const char* id)
 {
-	struct sd_sys *sys;
-
-	util_list_iterate(&parent->child_list, sys) {
-		if (strcmp(sys->id, id) == 0)
-			return sys;
-	}
-	return NULL;
+	return l_hash_lookup(&parent->child_hash, id);
 }
 
 /*
@@ -259,25 +339,38 @@ struct sd_sys *sd_sys_new(struct sd_sys *parent, const char *id)
 		sys_new->i.parent = parent;
 		parent->child_cnt++;
 		util_list_add_tail(&parent->child_list, sys_new);
+		l_hash_add(&parent->child_hash, &sys_new->hash_node,
+			   sys_new->id, sys_new);
 	}
 	sys_new->threads_per_core = 1;
 	return sys_new;
 }
 
 /*
- * Free system
+ * Free CPU
  */
-static void sd_sys_free(struct sd_sys *sys)
+static void sd_cpu_free(struct sd_cpu *cpu)
 {
-	ht_free(sys);
+	sd_hist_free(&cpu->hist);
+	ht_free(cpu);
 }
 
 /*
- * Free CPU
+ * Free system including its CPUs and children
  */
-static void sd_cpu_free(struct sd_cpu *cpu)
+static void sd_sys_free(struct sd_sys *sys)
 {
-	ht_free(cpu);
+	struct sd_sys *child, *child_tmp;
+	struct sd_cpu *cpu, *cpu_tmp;
+
+	util_list_iterate_safe(&sys->cpu_list, cpu, cpu_tmp)
+		sd_cpu_free(cpu);
+	util_list_iterate_safe(&sys->child_list, child, child_tmp)
+		sd_sys_free(child);
+	ht_free(sys->cpu_hash.bucket_vec);
+	ht_free(sys->child_hash.bucket_vec);
+	sd_hist_free(&sys->hist);
+	ht_free(sys);
 }
 
 /*
@@ -330,6 +423,7 @@ static void l_cpu_update_end(struct sd_sys *sys)
 		if (!cpu->i.active) {
 			/* CPU has not been updated, remove it */
 			util_list_remove(&sys->cpu_list, cpu);
+			l_hash_remove(&sys->cpu_hash, &cpu->hash_node);
 			sd_cpu_free(cpu);
 			continue;
 		}
@@ -350,6 +444,7 @@ static void l_sys_update_end(struct sd_sys *sys)
 		if (!child->i.active) {
 			/* child has not been updated, remove it */
 			util_list_remove(&sys->child_list, child);
+			l_hash_remove(&sys->child_hash, &child->hash_node);
 			sd_sys_free(child);
 			continue;
 		}
@@ -366,6 +461,7 @@ void sd_sys_update_end(struct sd_sys *sys, u64 update_time_us)
 {
 	sys->update_time_us = update_time_us;
 	l_sys_update_end(sys);
+	sd_hist_update(sys);
 }
 
 /*
@@ -240,3 +240,61 @@ struct sd_cpu_item sd_cpu_item_online = {
 	.desc	= "Online time",
 	.fn_u64	= l_cpu_item_64,
 };
+
+/*
+ * History items: The value index is stored in "offset"
+ */
+static u64 l_cpu_hist_min(struct sd_cpu_item *item, struct sd_cpu *cpu)
+{
+	return sd_hist_min(&cpu->hist, item->offset);
+}
+
+static u64 l_cpu_hist_avg(struct sd_cpu_item *item, struct sd_cpu *cpu)
+{
+	return sd_hist_avg(&cpu->hist, item->offset);
+}
+
+static u64 l_cpu_hist_max(struct sd_cpu_item *item, struct sd_cpu *cpu)
+{
+	return sd_hist_max(&cpu->hist, item->offset);
+}
+
+static char *l_cpu_hist_trend(struct sd_cpu_item *item, struct sd_cpu *cpu)
+{
+	static char str[SD_HIST_TREND_LEN + 1];
+
+	sd_hist_trend(&cpu->hist, item->offset, str);
+	return str;
+}
+
+struct sd_cpu_item sd_cpu_item_hist_min = {
+	.table_col = TABLE_COL_TIME_DIFF_SUM(table_col_unit_perc, 'L', "hlow"),
+	.type	= SD_TYPE_U64,
+	.offset = SD_HIST_CPU,
+	.desc	= "Minimum CPU time per second in history",
+	.fn_u64	= l_cpu_hist_min,
+};
+
+struct sd_cpu_item sd_cpu_item_hist_avg = {
+	.table_col = TABLE_COL_TIME_DIFF_SUM(table_col_unit_perc, 'A', "havg"),
+	.type	= SD_TYPE_U64,
+	.offset = SD_HIST_CPU,
+	.desc	= "Average CPU time per second in history",
+	.fn_u64	= l_cpu_hist_avg,
+};
+
+struct sd_cpu_item sd_cpu_item_hist_max = {
+	.table_col = TABLE_COL_TIME_DIFF_SUM(table_col_unit_perc, 'H', "hmax"),
+	.type	= SD_TYPE_U64,
+	.offset = SD_HIST_CPU,
+	.desc	= "Maximum CPU time per second in history",
+	.fn_u64	= l_cpu_hist_max,
+};
+
+struct sd_cpu_item sd_cpu_item_hist_trend = {
+	.table_col = TABLE_COL_STR_LEFT('R', "trend"),
+	.type	= SD_TYPE_STR,
+	.offset = SD_HIST_CPU,
+	.desc	= "Trend of CPU time per second in history",
+	.fn_str	= l_cpu_hist_trend,
+};
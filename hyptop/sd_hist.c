@@ -0,0 +1,218 @@
+/*
+ * hyptop - Show hypervisor performance data on System z
+ *
+ * System data history: Keep the last samples of systems and CPUs
+ *
+ * Each system and CPU has a ring buffer with "--history" samples for each
+ * history value. The buffer is one allocation with one array per value.
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#include <string.h>
+
+#include "helper.h"
+#include "hyptop.h"
+#include "sd.h"
+
+/* Trend characters from low to high values */
+static const char l_trend_chars[] = " _.-=+*#";
+
+#define TREND_LEVELS	(sizeof(l_trend_chars) - 2)
+
+static struct sd_sys_item *l_sys_cpu_item;
+static struct sd_cpu_item *l_cpu_cpu_item;
+static int l_has_mem;
+
+/*
+ * Get samples of value "val"
+ */
+static inline u64 *l_hist_vec(struct sd_hist *hist, enum sd_hist_val val)
+{
+	return &hist->vec[val * g.o.history_depth];
+}
+
+/*
+ * Get "i"th valid sample, starting with the oldest one
+ */
+static inline u64 l_hist_get(struct sd_hist *hist, u64 *vec, u32 i)
+{
+	u32 depth = g.o.history_depth;
+
+	return vec[(hist->pos + depth - hist->cnt + i) % depth];
+}
+
+/*
+ * Add new sample for all "val_cnt" values
+ */
+static void l_hist_add(struct sd_hist *hist, u64 *sample, int val_cnt)
+{
+	u32 depth = g.o.history_depth;
+	int i;
+
+	if (!hist->vec)
+		hist->vec = ht_zalloc(sizeof(u64) * depth * val_cnt);
+	for (i = 0; i < val_cnt; i++)
+		l_hist_vec(hist, i)[hist->pos] = sample[i];
+	hist->pos = (hist->pos + 1) % depth;
+	if (hist->cnt < depth)
+		hist->cnt++;
+}
+
+/*
+ * Does the CPU have a previous data set?
+ *
+ * In the first update cycle of a CPU the previous data set is still zero.
+ */
+static int l_cpu_has_prev(struct sd_cpu *cpu)
+{
+	return cpu->d_prev && cpu->d_prev->online_time_us != 0;
+}
+
+/*
+ * Do all CPUs of the system have a previous data set?
+ */
+static int l_sys_has_prev(struct sd_sys *sys)
+{
+	struct sd_cpu *cpu;
+
+	sd_cpu_iterate(sys, cpu) {
+		if (!l_cpu_has_prev(cpu))
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * Add current values of system and its CPUs and children to history
+ */
+static void l_sys_update(struct sd_sys *sys)
+{
+	u64 sample[SD_HIST_VAL_CNT];
+	struct sd_sys *child;
+	struct sd_cpu *cpu;
+
+	sd_cpu_iterate(sys, cpu) {
+		/* Without previous data there is no time per second */
+		if (!l_cpu_has_prev(cpu))
+			continue;
+		sample[SD_HIST_CPU] = sd_cpu_item_u64(l_cpu_cpu_item, cpu);
+		l_hist_add(&cpu->hist, sample, 1);
+	}
+	if (l_sys_has_prev(sys)) {
+		sample[SD_HIST_CPU] = sd_sys_item_u64(sys, l_sys_cpu_item);
+		sample[SD_HIST_MEM] = l_has_mem ?
+			sd_sys_item_u64(sys, &sd_sys_item_mem_use) : 0;
+		l_hist_add(&sys->hist, sample, SD_HIST_VAL_CNT);
+	}
+	sd_sys_iterate(sys, child)
+		l_sys_update(child);
+}
+
+/*
+ * Add current values of all systems and CPUs to history
+ */
+void sd_hist_update(struct sd_sys *root)
+{
+	if (!l_sys_cpu_item) {
+		if (sd_sys_item_available(&sd_sys_item_core_diff))
+			l_sys_cpu_item = &sd_sys_item_core_diff;
+		else
+			l_sys_cpu_item = &sd_sys_item_cpu_diff;
+		if (sd_cpu_item_available(&sd_cpu_item_core_diff))
+			l_cpu_cpu_item = &sd_cpu_item_core_diff;
+		else
+			l_cpu_cpu_item = &sd_cpu_item_cpu_diff;
+		l_has_mem = sd_sys_item_available(&sd_sys_item_mem_use);
+	}
+	l_sys_update(root);
+}
+
+/*
+ * Free history
+ */
+void sd_hist_free(struct sd_hist *hist)
+{
+	ht_free(hist->vec);
+}
+
+/*
+ * Minimum of value "val" in history
+ */
+u64 sd_hist_min(struct sd_hist *hist, enum sd_hist_val val)
+{
+	u64 *vec, min = (u64) -1;
+	u32 i;
+
+	if (!hist->cnt)
+		return 0;
+	vec = l_hist_vec(hist, val);
+	for (i = 0; i < hist->cnt; i++)
+		min = MIN(min, vec[i]);
+	return min;
+}
+
+/*
+ * Maximum of value "val" in history
+ */
+u64 sd_hist_max(struct sd_hist *hist, enum sd_hist_val val)
+{
+	u64 *vec, max = 0;
+	u32 i;
+
+	if (!hist->cnt)
+		return 0;
+	vec = l_hist_vec(hist, val);
+	for (i = 0; i < hist->cnt; i++)
+		max = MAX(max, vec[i]);
+	return max;
+}
+
+/*
+ * Average of value "val" in history
+ */
+u64 sd_hist_avg(struct sd_hist *hist, enum sd_hist_val val)
+{
+	u64 *vec, sum = 0;
+	u32 i;
+
+	if (!hist->cnt)
+		return 0;
+	vec = l_hist_vec(hist, val);
+	for (i = 0; i < hist->cnt; i++)
+		sum += vec[i];
+	return sum / hist->cnt;
+}
+
+/*
+ * Format trend of value "val" into "str" (oldest sample first)
+ *
+ * If there are more samples than characters, each character shows the
+ * maximum of its samples, so that short peaks remain visible. The values
+ * are scaled to the maximum in the history.
+ */
+void sd_hist_trend(struct sd_hist *hist, enum sd_hist_val val, char *str)
+{
+	u32 len, i, j, start, end;
+	u64 *vec, max, v;
+
+	len = MIN(hist->cnt, (u32) SD_HIST_TREND_LEN);
+	max = sd_hist_max(hist, val);
+	vec = l_hist_vec(hist, val);
+	for (i = 0; i < len; i++) {
+		start = i * hist->cnt / len;
+		end = (i + 1) * hist->cnt / len;
+		v = 0;
+		for (j = start; j < end; j++)
+			v = MAX(v, l_hist_get(hist, vec, j));
+		if (max == 0 || v == 0)
+			str[i] = l_trend_chars[0];
+		else
+			str[i] = l_trend_chars[1 + v * TREND_LEVELS / max -
+					       (v == max)];
+	}
+	str[len] = 0;
+}
@@ -418,3 +418,69 @@ struct sd_sys_item sd_sys_item_weight_max = {
 	.desc	= "Maximum weight",
 	.fn_u64	= l_sys_item_u64,
 };
+
+/*
+ * History items: The value index is stored in "offset"
+ */
+static u64 l_sys_hist_min(struct sd_sys_item *item, struct sd_sys *sys)
+{
+	return sd_hist_min(&sys->hist, item->offset);
+}
+
+static u64 l_sys_hist_avg(struct sd_sys_item *item, struct sd_sys *sys)
+{
+	return sd_hist_avg(&sys->hist, item->offset);
+}
+
+static u64 l_sys_hist_max(struct sd_sys_item *item, struct sd_sys *sys)
+{
+	return sd_hist_max(&sys->hist, item->offset);
+}
+
+static char *l_sys_hist_trend(struct sd_sys_item *item, struct sd_sys *sys)
+{
+	static char str[SD_HIST_TREND_LEN + 1];
+
+	sd_hist_trend(&sys->hist, item->offset, str);
+	return str;
+}
+
+struct sd_sys_item sd_sys_item_hist_min = {
+	.table_col = TABLE_COL_TIME_DIFF_SUM(table_col_unit_perc, 'L', "hlow"),
+	.offset = SD_HIST_CPU,
+	.type	= SD_TYPE_U64,
+	.desc	= "Minimum CPU time per second in history",
+	.fn_u64	= l_sys_hist_min,
+};
+
+struct sd_sys_item sd_sys_item_hist_avg = {
+	.table_col = TABLE_COL_TIME_DIFF_SUM(table_col_unit_perc, 'A', "havg"),
+	.offset = SD_HIST_CPU,
+	.type	= SD_TYPE_U64,
+	.desc	= "Average CPU time per second in history",
+	.fn_u64	= l_sys_hist_avg,
+};
+
+struct sd_sys_item sd_sys_item_hist_max = {
+	.table_col = TABLE_COL_TIME_DIFF_SUM(table_col_unit_perc, 'H', "hmax"),
+	.offset = SD_HIST_CPU,
+	.type	= SD_TYPE_U64,
+	.desc	= "Maximum CPU time per second in history",
+	.fn_u64	= l_sys_hist_max,
+};
+
+struct sd_sys_item sd_sys_item_hist_trend = {
+	.table_col = TABLE_COL_STR_LEFT('R', "trend"),
+	.offset = SD_HIST_CPU,
+	.type	= SD_TYPE_STR,
+	.desc	= "Trend of CPU time per second in history",
+	.fn_str	= l_sys_hist_trend,
+};
+
+struct sd_sys_item sd_sys_item_hist_mem_trend = {
+	.table_col = TABLE_COL_STR_LEFT('N', "mtrend"),
+	.offset = SD_HIST_MEM,
+	.type	= SD_TYPE_STR,
+	.desc	= "Trend of used memory in history",
+	.fn_str	= l_sys_hist_trend,
+};
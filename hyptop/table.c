@@ -410,36 +410,74 @@ static void l_row_last_calc(struct table *t)
 	l_row_format(t, t->row_last);
 }
 
+/*
+ * Merge sort "vec" using "tmp" as buffer (ordering: large to small)
+ *
+ * The sort is stable, so rows with equal values keep their order.
+ */
+static void l_row_vec_sort(struct table *t, struct table_row **vec,
+			   struct table_row **tmp, int cnt)
+{
+	int mid = cnt / 2, i = 0, j = mid, k = 0;
+
+	if (cnt < 2)
+		return;
+	l_row_vec_sort(t, vec, tmp, mid);
+	l_row_vec_sort(t, vec + mid, tmp, cnt - mid);
+	while (i < mid && j < cnt) {
+		if (l_row_less_than(t, vec[i], vec[j]))
+			tmp[k++] = vec[j++];
+		else
+			tmp[k++] = vec[i++];
+	}
+	while (i < mid)
+		tmp[k++] = vec[i++];
+	/* Remaining elements of the right half are already in place */
+	memcpy(vec, tmp, k * sizeof(*vec));
+}
+
+/*
+ * Sort table (ordering: large to small)
+ */
+static void l_table_sort(struct table *t)
+{
+	struct table_row **vec, **tmp, *row;
+	int cnt = 0, i;
+
+	if (!t->col_selected || t->row_cnt < 2)
+		return;
+	vec = ht_alloc(sizeof(*vec) * t->row_cnt * 2);
+	tmp = vec + t->row_cnt;
+	util_list_iterate(&t->row_list, row)
+		vec[cnt++] = row;
+	l_row_vec_sort(t, vec, tmp, cnt);
+	util_list_init(&t->row_list, struct table_row, list);
+	for (i = 0; i < cnt; i++)
+		util_list_add_tail(&t->row_list, vec[i]);
+	ht_free(vec);
+}
+
 /*
  * Finish table after all rows have been added
  */
 void table_finish(struct table *t)
 {
+	if (t->attr_sorted_table)
+		l_table_sort(t);
 	l_row_last_calc(t);
 	t->ready = 1;
 }
 
 /*
  * Add new row to table
+ *
+ * Sorted tables are sorted once in table_finish() instead of inserting
+ * each row at its place, which would be O(n^2) for n rows.
  */
 void table_row_add(struct table *t, struct table_row *row)
 {
-	struct table_row *tmp;
-
 	l_row_format(t, row);
-
-	if (util_list_is_empty(&t->row_list) || !t->attr_sorted_table) {
-		util_list_add_tail(&t->row_list, row);
-	} else {
-		util_list_iterate(&t->row_list, tmp) {
-			if (l_row_less_than(t, tmp, row))
-				break;
-		}
-		if (tmp)
-			util_list_add_prev(&t->row_list, row, tmp);
-		else
-			util_list_add_tail(&t->row_list, row);
-	}
+	util_list_add_tail(&t->row_list, row);
 	if (l_row_is_marked(t, row)) {
 		row->marked = 1;
 		t->row_cnt_marked++;
@@ -463,22 +501,6 @@ void table_rebuild(struct table *t)
 	l_row_format(t, t->row_last);
 }
 
-/*
- * Compare callback for linked list sorting (ordering: large to small)
- */
-static int l_row_cmp_fn(void *a, void *b, void *data)
-{
-	return l_row_less_than(data, a, b) ? 1 : -1;
-}
-
-/*
- * Sort table (ordering: large to small)
- */
-static void l_table_sort(struct table *t)
-{
-	util_list_sort(&t->row_list, l_row_cmp_fn, t);
-}
-
 /*
  * Adjust table values for select mode (e.g. for window resize or scrolling)
  */
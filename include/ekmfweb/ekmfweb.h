@@ -15,6 +15,13 @@
 
 typedef void CURL;
 
+/**
+ * A multi handle performs multiple requests to the EKMFWeb server in
+ * parallel, and keeps its connections and TLS sessions alive for subsequent
+ * requests.
+ */
+struct ekmf_multi_handle;
+
 struct ekmf_config {
 	/** The base URL of the server. Should use https:// ! */
 	const char *base_url;
@@ -517,6 +524,66 @@ int ekmf_retrieve_key(const struct ekmf_config *config, CURL **curl_handle,
 		      size_t *key_blob_length, char **error_msg,
 		      const struct ekmf_ext_lib *ext_lib, bool verbose);
 
+/**
+ * Requests multiple keys to be retrieved from EKMFweb and imported under the
+ * current HSM's master key. The requests are sent to the server in parallel,
+ * while the session keys are generated, the requests are signed, and the keys
+ * are imported one after the other by the calling thread.
+ *
+ * To perform a single set of requests, set multi_handle to NULL. This will
+ * cause the function to initialize a new multi handle, use it, and destroy it.
+ * If you plan to perform multiple sets of requests to the same host, supply the
+ * address of a multi handle pointer that is initially NULL. This function will
+ * then initialize a new multi handle on the first call. On subsequent calls,
+ * pass in the address of the same pointer so that the multi handle, and thus
+ * its connections and TLS sessions, are reused. After the last request, the
+ * multi handle must be destroyed by calling ekmf_multi_destroy.
+ *
+ * @param config            the configuration structure
+ * @param multi_handle      address of a multi handle used for reusing the same
+ *                          connections with multiple calls.
+ * @param max_parallel      the maximum number of requests in flight at the
+ *                          same time. If 0, then a default of 8 is used.
+ * @param multiplex         if true, the requests are multiplexed over a single
+ *                          HTTP/2 connection, if the server supports HTTP/2.
+ * @param key_uuids         the UUIDs of the keys to retrieve
+ * @param num_keys          the number of keys to retrieve
+ * @param sess_ec_curve_nid The OpenSSL nid of the EC curve used for the session
+ *                          ECC keys. If 0, then the default curve is used.
+ * @param sign_rsa_digest_nid The OpenSSL nid of a digest used to sign the
+ *                          requests with if the identity key is an RSA-type
+ *                          key. If 0, then the default digest is used.
+ *                          Ignored for ECC-type identity keys.
+ * @param use_rsa_pss       If true, and the identity key is an RSA-type key,
+ *                          use RSA-PSS to sign the requests.
+ * @param signature_kid     the Key ID for the signature of the requests
+ * @param key_blobs         an array of num_keys buffers to store the retrieved
+ *                          key blobs to
+ * @param key_blob_lengths  an array of num_keys lengths.
+ *                          On entry: the sizes of the buffers
+ *                          On return: the sizes of the key blobs retrieved
+ * @param key_rcs           an array of num_keys return codes. On return, it
+ *                          contains zero or a negative errno for each key.
+ * @param error_msg         on return: If not NULL, then a textual error message
+ *                          of the first failing request is returned. The caller
+ *                          must free the error string when it is not NULL.
+ * @param ext_lib           External secure key crypto library to use
+ * @param verbose           if true, verbose messages are printed
+ *
+ * @returns zero if the keys were requested (check key_rcs for the result of
+ *          each key), or a negative errno in case of an error.
+ *          -EACCES is returned, if no or no valid login token is available.
+ */
+int ekmf_retrieve_keys(const struct ekmf_config *config,
+		       struct ekmf_multi_handle **multi_handle,
+		       unsigned int max_parallel, bool multiplex,
+		       const char **key_uuids, size_t num_keys,
+		       int sess_ec_curve_nid, int sign_rsa_digest_nid,
+		       bool use_rsa_pss, const char *signature_kid,
+		       unsigned char **key_blobs, size_t *key_blob_lengths,
+		       int *key_rcs, char **error_msg,
+		       const struct ekmf_ext_lib *ext_lib, bool verbose);
+
 struct ekmf_tag_definition {
 	/** name of the tag */
 	const char *name;
@@ -876,6 +943,53 @@ int ekmf_get_key_info(const struct ekmf_config *config, CURL **curl_handle,
 		      const char *key_uuid, struct ekmf_key_info **key,
 		      char **error_msg, bool verbose);
 
+/**
+ * Gets information about multiple keys identified by their UUIDs. The requests
+ * for the keys, their custom tags, and their export control infos are
+ * performed in parallel.
+ *
+ * To perform a single set of requests, set multi_handle to NULL. This will
+ * cause the function to initialize a new multi handle, use it, and destroy it.
+ * If you plan to perform multiple sets of requests to the same host, supply the
+ * address of a multi handle pointer that is initially NULL. This function will
+ * then initialize a new multi handle on the first call. On subsequent calls,
+ * pass in the address of the same pointer so that the multi handle, and thus
+ * its connections and TLS sessions, are reused. After the last request, the
+ * multi handle must be destroyed by calling ekmf_multi_destroy.
+ *
+ * @param config            the configuration structure
+ * @param multi_handle      address of a multi handle used for reusing the same
+ *                          connections with multiple calls.
+ * @param max_parallel      the maximum number of requests in flight at the
+ *                          same time. If 0, then a default of 8 is used.
+ * @param multiplex         if true, the requests are multiplexed over a single
+ *                          HTTP/2 connection, if the server supports HTTP/2.
+ * @param key_uuids         the UUIDs of the keys to get info for
+ * @param num_keys          the number of keys to get info for
+ * @param keys              an array of num_keys key info pointers. On return,
+ *                          each pointer is updated to point to a newly
+ *                          allocated key info struct, or NULL if the info of
+ *                          the key could not be obtained. The key infos must be
+ *                          freed by the caller using ekmf_free_key_info when no
+ *                          longer needed.
+ * @param key_rcs           an array of num_keys return codes. On return, it
+ *                          contains zero or a negative errno for each key.
+ * @param error_msg         on return: If not NULL, then a textual error message
+ *                          of the first failing request is returned. The caller
+ *                          must free the error string when it is not NULL.
+ * @param verbose           if true, verbose messages are printed
+ *
+ * @returns zero if the key infos were requested (check key_rcs for the result
+ *          of each key), or a negative errno in case of an error.
+ *          -EACCES is returned, if no or no valid login token is available.
+ */
+int ekmf_get_key_infos(const struct ekmf_config *config,
+		       struct ekmf_multi_handle **multi_handle,
+		       unsigned int max_parallel, bool multiplex,
+		       const char **key_uuids, size_t num_keys,
+		       struct ekmf_key_info **keys, int *key_rcs,
+		       char **error_msg, bool verbose);
+
 /**
  * Changes the state of a key identified by its UUID. To update a key,
  * the timestamp from the last update is required. This can be found in
@@ -1068,4 +1182,11 @@ int ekmf_generate_key(const struct ekmf_config *config, CURL **curl_handle,
  */
 void ekmf_curl_destroy(CURL *curl_handle);
 
+/**
+ * Close the connections to the EKMFWeb server by destroying the multi handle.
+ *
+ * @param multi_handle      the multi handle to destroy
+ */
+void ekmf_multi_destroy(struct ekmf_multi_handle *multi_handle);
+
 #endif
@@ -1397,9 +1397,17 @@ struct kmip_conn_config {
 };
 
 /* Opaque KMIP node and connection structures */
+struct kmip_arena;
+struct kmip_async;
 struct kmip_connection;
+struct kmip_connection_pool;
 struct kmip_node;
 
+/* KMIP node arena related functions */
+struct kmip_arena *kmip_arena_new(size_t chunk_size);
+void kmip_arena_free(struct kmip_arena *arena);
+struct kmip_arena *kmip_arena_use(struct kmip_arena *arena);
+
 /* Generic KMIP node constructors/destructors and getters */
 struct kmip_node *kmip_node_clone(const struct kmip_node *node);
 void kmip_node_upref(struct kmip_node *node);
@@ -2063,4 +2071,40 @@ int kmip_connection_get_server_cert(const char *server,
 				    bool *verified,
 				    bool debug);
 
+/* Connection pool related functions */
+int kmip_connection_pool_new(const struct kmip_conn_config *config,
+			     unsigned int max_connections,
+			     unsigned int idle_timeout,
+			     const char *session_cache,
+			     struct kmip_connection_pool **pool,
+			     bool debug);
+int kmip_connection_pool_get(struct kmip_connection_pool *pool,
+			     struct kmip_connection **connection,
+			     bool debug);
+void kmip_connection_pool_put(struct kmip_connection_pool *pool,
+			      struct kmip_connection *connection,
+			      bool discard, bool debug);
+void kmip_connection_pool_free(struct kmip_connection_pool *pool, bool debug);
+
+/* Asynchronous request related functions */
+
+/**
+ * Callback for completed asynchronous requests. The response is NULL if rc
+ * is a negative errno value. The response is freed when the callback returns,
+ * use kmip_node_upref() to keep it.
+ */
+typedef void (*kmip_async_cb_t)(struct kmip_node *request,
+				struct kmip_node *response, int rc,
+				void *private);
+
+int kmip_async_new(struct kmip_connection_pool *pool,
+		   unsigned int pipeline_depth, struct kmip_async **async,
+		   bool debug);
+int kmip_async_submit(struct kmip_async *async, struct kmip_node *request,
+		      kmip_async_cb_t callback, void *private, bool debug);
+unsigned int kmip_async_outstanding(struct kmip_async *async);
+int kmip_async_poll(struct kmip_async *async, int timeout, bool debug);
+int kmip_async_wait(struct kmip_async *async, bool debug);
+void kmip_async_free(struct kmip_async *async, bool debug);
+
 #endif
@@ -67,6 +67,7 @@
 #define EKMF_URI_TEMPLATE_SEQNO		"/api/v1/templates/%s/sequenceNumber"
 
 #define LIST_ELEMENTS_PER_PAGE		20
+#define EKMF_DEFAULT_MAX_PARALLEL	8
 #define TEMPLATE_STATE_ACTIVE		"ACTIVE"
 #define KEY_STATE_ACTIVE		"ACTIVE"
 #define KEY_ALGORITHM_AES		"AES"
@@ -137,6 +138,19 @@ struct curl_sslctx_cb_data {
 	bool verbose;
 };
 
+/*
+ * State of a request from _ekmf_prepare_request() to _ekmf_complete_request().
+ * The callback data must stay valid while the request is performed.
+ */
+struct ekmf_request_state {
+	struct curl_header_cb_data header_cb;
+	struct curl_sslctx_cb_data sslctx_cb;
+	struct curl_write_cb_data write_cb;
+	char error_str[CURL_ERROR_SIZE];
+	struct curl_slist *list;
+	char *url;
+};
+
 #define CURL_CERTINFO_CERT	"Cert:"
 #define HTTP_HDR_CONTENT_TYPE	"Content-Type:"
 
@@ -706,13 +720,14 @@ static CURLcode _ekmf_sslctx_cb(CURL *UNUSED(curl), void *sslctx, void *parm)
 }
 
 /**
- * Perform an HTTP request to the url constructed from the base_url in config
- * and th uri specified using the specified HTTP request.
- * The config structure contains information about TLS certificates.
- * If specified, it serializes the request data (JSON) and sends it to the
- * server. The response data (JSON) is parsed and returned in the response data.
- * If the response content type is not JSON, then an error is returned.
- * The HTTP status code is returned in status_code.
+ * Prepares an HTTP request to the url constructed from the base_url in config
+ * and the uri specified using the specified HTTP request, so that it can be
+ * performed with curl_easy_perform(), or by adding the CURL handle to a CURL
+ * multi handle. The config structure contains information about TLS
+ * certificates. If specified, it serializes the request data (JSON) to be sent
+ * to the server. The request data must not be freed before the request has
+ * been completed with _ekmf_complete_request(), which must also be called if
+ * this function fails.
  *
  * @param config            the configuration structure
  * @param uri               the uri (and query parameters) to concatenate to the
@@ -722,56 +737,40 @@ static CURLcode _ekmf_sslctx_cb(CURL *UNUSED(curl), void *sslctx, void *parm)
  * @param request_headers   a NULL terminated list of pointers to HTTP headers
  *                          to send along with the request. Can be NULL.
  * @param login_token       if not NULL, a Bearer token to authorize with
- * @param response_data     on return the JSON response data is returned. When
- *                          no longer needed, it must be released using
- *                          json_object_put()
  * @param response headers  address of a curl_slist to add response headers to,
  *                          or NULL to not return any headers.
- * @param status_code       on return the HTTP status code is returned
- * @param error_msg         on return: If not NULL, then a textual error message
- *                          is returned in case of a failing request. The caller
- *                          must free the error string when it is not NULL.
+ * @param state             the request state, initialized to all zeros
  * @param curl              a CURL handle to perform the request with.
  * @param verbose           if true, verbose messages are printed
  *
  * @returns zero for success, a negative errno or a positive CURL error code in
  *          case of an error
  */
-static int _ekmf_perform_request(const struct ekmf_config *config,
+static int _ekmf_prepare_request(const struct ekmf_config *config,
 				 const char *uri, const char *request,
 				 json_object *request_data,
 				 char **request_headers,
 				 const char *login_token,
-				 json_object **response_data,
 				 struct curl_slist **response_headers,
-				 long *status_code, char **error_msg,
+				 struct ekmf_request_state *state,
 				 CURL *curl, bool verbose)
 {
 	const struct curl_tlssessioninfo *info = NULL;
-	struct curl_header_cb_data header_cb = { 0 };
-	struct curl_sslctx_cb_data sslctx_cb = { 0 };
-	struct curl_write_cb_data write_cb = { 0 };
-	char error_str[CURL_ERROR_SIZE] = { 0 };
-	struct curl_slist *list = NULL;
-	char *url = NULL;
 	const char *str;
 	struct stat sb;
 	char *auth_hdr;
 	int i, rc;
 
 	if (config == NULL || uri == NULL || request == NULL ||
-	    status_code == NULL || curl == NULL)
+	    state == NULL || curl == NULL)
 		return -EINVAL;
 
-	if (error_msg != NULL)
-		*error_msg = NULL;
-
-	if (asprintf(&url, "%s%s", config->base_url, uri) < 0) {
+	if (asprintf(&state->url, "%s%s", config->base_url, uri) < 0) {
 		pr_verbose(verbose, "asprintf failed");
 		return -ENOMEM;
 	}
 
-	pr_verbose(verbose, "Performing request for '%s'", url);
+	pr_verbose(verbose, "Performing request for '%s'", state->url);
 
 	curl_easy_reset(curl);
 
@@ -791,11 +790,11 @@ static int _ekmf_perform_request(const struct ekmf_config *config,
 	rc = curl_easy_setopt(curl, CURLOPT_VERBOSE, verbose ? 1 : 0);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_VERBOSE", verbose, out);
 
-	rc = curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, error_str);
+	rc = curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, state->error_str);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_ERRORBUFFER", verbose,
 			 out);
 
-	rc = curl_easy_setopt(curl, CURLOPT_URL, url);
+	rc = curl_easy_setopt(curl, CURLOPT_URL, state->url);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_URL", verbose, out);
 
 	rc = curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER,
@@ -906,9 +905,9 @@ static int _ekmf_perform_request(const struct ekmf_config *config,
 			CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_POST",
 					 verbose, out);
 
-			list = curl_slist_append(list,
+			state->list = curl_slist_append(state->list,
 				"Content-Type: application/json;charset=UTF-8");
-			if (list == NULL) {
+			if (state->list == NULL) {
 				pr_verbose(verbose, "curl_slist_append failed");
 				rc = -ENOMEM;
 				goto out;
@@ -929,21 +928,22 @@ static int _ekmf_perform_request(const struct ekmf_config *config,
 		}
 	}
 
-	list = curl_slist_append(list, "Accept: application/json");
-	if (list == NULL) {
+	state->list = curl_slist_append(state->list,
+					"Accept: application/json");
+	if (state->list == NULL) {
 		pr_verbose(verbose, "curl_slist_append failed");
 		rc = -ENOMEM;
 		goto out;
 	}
-	list = curl_slist_append(list, "Accept-Charset: UTF-8");
-	if (list == NULL) {
+	state->list = curl_slist_append(state->list, "Accept-Charset: UTF-8");
+	if (state->list == NULL) {
 		pr_verbose(verbose, "curl_slist_append failed");
 		rc = -ENOMEM;
 		goto out;
 	}
 	/* Disable "Expect: 100-continue" */
-	list = curl_slist_append(list, "Expect:");
-	if (list == NULL) {
+	state->list = curl_slist_append(state->list, "Expect:");
+	if (state->list == NULL) {
 		pr_verbose(verbose, "curl_slist_append failed");
 		rc = -ENOMEM;
 		goto out;
@@ -961,9 +961,9 @@ static int _ekmf_perform_request(const struct ekmf_config *config,
 			rc = -ENOMEM;
 			goto out;
 		}
-		list = curl_slist_append(list, auth_hdr);
+		state->list = curl_slist_append(state->list, auth_hdr);
 		free(auth_hdr);
-		if (list == NULL) {
+		if (state->list == NULL) {
 			pr_verbose(verbose, "curl_slist_append failed");
 			rc = -ENOMEM;
 			goto out;
@@ -972,43 +972,46 @@ static int _ekmf_perform_request(const struct ekmf_config *config,
 
 	for (i = 0; request_headers != NULL &&
 		    request_headers[i] != NULL; i++) {
-		list = curl_slist_append(list, request_headers[i]);
-		if (list == NULL) {
+		state->list = curl_slist_append(state->list,
+						request_headers[i]);
+		if (state->list == NULL) {
 			pr_verbose(verbose, "curl_slist_append failed");
 			rc = -ENOMEM;
 			goto out;
 		}
 	}
 
-	rc = curl_easy_setopt(curl, CURLOPT_HTTPHEADER, list);
+	rc = curl_easy_setopt(curl, CURLOPT_HTTPHEADER, state->list);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_HTTPHEADER", verbose,
 			 out);
 
-	header_cb.headers = response_headers;
-	header_cb.verbose = verbose;
+	state->header_cb.headers = response_headers;
+	state->header_cb.verbose = verbose;
 
-	write_cb.verbose = verbose;
-	write_cb.tok = json_tokener_new();
-	if (write_cb.tok == NULL) {
+	state->write_cb.verbose = verbose;
+	state->write_cb.tok = json_tokener_new();
+	if (state->write_cb.tok == NULL) {
 		pr_verbose(verbose, "json_tokener_new failed");
 		rc = -ENOMEM;
 		goto out;
 	}
 
-	sslctx_cb.tls_server_cert = config->tls_server_cert;
-	sslctx_cb.verbose = verbose;
+	state->sslctx_cb.tls_server_cert = config->tls_server_cert;
+	state->sslctx_cb.verbose = verbose;
 
 	rc = curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, _ekmf_header_cb);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_HEADERFUNCTION", verbose,
 			 out);
-	rc = curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void *)&header_cb);
+	rc = curl_easy_setopt(curl, CURLOPT_HEADERDATA,
+			      (void *)&state->header_cb);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_HEADERDATA", verbose,
 			 out);
 
 	rc = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, _ekmf_write_cb);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_WRITEFUNCTION", verbose,
 			 out);
-	rc = curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&write_cb);
+	rc = curl_easy_setopt(curl, CURLOPT_WRITEDATA,
+			      (void *)&state->write_cb);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_WRITEDATA", verbose,
 			 out);
 
@@ -1018,18 +1021,52 @@ static int _ekmf_perform_request(const struct ekmf_config *config,
 		CURL_ERROR_CHECK(rc, "curl_easy_setopt "
 				 "CURLOPT_SSL_CTX_FUNCTION", verbose, out);
 		rc = curl_easy_setopt(curl, CURLOPT_SSL_CTX_DATA,
-				      &sslctx_cb);
+				      &state->sslctx_cb);
 		CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_SSL_CTX_DATA",
 				 verbose, out);
 	}
 
-	rc = curl_easy_perform(curl);
+out:
+	return rc;
+}
+
+/**
+ * Completes an HTTP request prepared with _ekmf_prepare_request(). The response
+ * data (JSON) is parsed and returned in the response data. If the response
+ * content type is not JSON, then an error is returned. The HTTP status code is
+ * returned in status_code. The request state is cleaned up in any case.
+ *
+ * @param state             the request state
+ * @param rc                the result of preparing the request if performed is
+ *                          false, or the CURL result of performing it
+ * @param performed         true if the request has been performed
+ * @param response_data     on return the JSON response data is returned. When
+ *                          no longer needed, it must be released using
+ *                          json_object_put()
+ * @param status_code       on return the HTTP status code is returned
+ * @param error_msg         on return: If not NULL, then a textual error message
+ *                          is returned in case of a failing request. The caller
+ *                          must free the error string when it is not NULL.
+ * @param curl              the CURL handle the request was performed with.
+ * @param verbose           if true, verbose messages are printed
+ *
+ * @returns zero for success, a negative errno or a positive CURL error code in
+ *          case of an error
+ */
+static int _ekmf_complete_request(struct ekmf_request_state *state, int rc,
+				  bool performed, json_object **response_data,
+				  long *status_code, char **error_msg,
+				  CURL *curl, bool verbose)
+{
+	if (!performed)
+		goto out;
+
 	if (rc != CURLE_OK) {
 		pr_verbose(verbose, "curl_easy_perform for '%s' failed: %s",
-			   url, curl_easy_strerror(rc));
-		pr_verbose(verbose, "Error: %s", error_str);
+			   state->url, curl_easy_strerror(rc));
+		pr_verbose(verbose, "Error: %s", state->error_str);
 
-		if (header_cb.error) {
+		if (state->header_cb.error) {
 			pr_verbose(verbose, "Unexpected Content-Type");
 			rc = -EBADMSG;
 			if (error_msg != NULL && *error_msg == NULL) {
@@ -1038,7 +1075,7 @@ static int _ekmf_perform_request(const struct ekmf_config *config,
 					error_msg = NULL;
 			}
 		}
-		if (write_cb.error) {
+		if (state->write_cb.error) {
 			pr_verbose(verbose, "JSON parsing failed");
 			rc = -EBADMSG;
 			if (error_msg != NULL && *error_msg == NULL) {
@@ -1054,33 +1091,34 @@ static int _ekmf_perform_request(const struct ekmf_config *config,
 	CURL_ERROR_CHECK(rc, "curl_easy_getinfo CURLINFO_RESPONSE_CODE",
 			 verbose, out);
 
-	if (*status_code >= 400 && write_cb.obj != NULL &&
+	if (*status_code >= 400 && state->write_cb.obj != NULL &&
 	    error_msg != NULL && *error_msg == NULL) {
-		rc = _ekmf_get_api_error(write_cb.obj, error_msg);
-		json_object_put(write_cb.obj);
-		write_cb.obj = NULL;
+		rc = _ekmf_get_api_error(state->write_cb.obj, error_msg);
+		json_object_put(state->write_cb.obj);
+		state->write_cb.obj = NULL;
 		if (rc != 0)
 			goto out;
 	}
 
 	if (response_data != NULL) {
-		*response_data = write_cb.obj;
+		*response_data = state->write_cb.obj;
 	} else {
-		if (write_cb.obj != NULL)
-			json_object_put(write_cb.obj);
+		if (state->write_cb.obj != NULL)
+			json_object_put(state->write_cb.obj);
 	}
 
 out:
-	if (write_cb.tok != NULL)
-		json_tokener_free(write_cb.tok);
-	if (url != NULL)
-		free(url);
-	if (list != NULL)
-		curl_slist_free_all(list);
+	if (state->write_cb.tok != NULL)
+		json_tokener_free(state->write_cb.tok);
+	if (state->url != NULL)
+		free(state->url);
+	if (state->list != NULL)
+		curl_slist_free_all(state->list);
 
 	if (rc > 0 && error_msg != NULL && *error_msg == NULL) {
-		if (asprintf(error_msg, "CURL: %s", strlen(error_str) > 0 ?
-				error_str : curl_easy_strerror(rc)) < 0) {
+		if (asprintf(error_msg, "CURL: %s",
+			     strlen(state->error_str) > 0 ? state->error_str :
+			     curl_easy_strerror(rc)) < 0) {
 			pr_verbose(verbose, "asprintf failed");
 			rc = -ENOMEM;
 		}
@@ -1091,6 +1129,71 @@ out:
 	return rc;
 }
 
+/**
+ * Perform an HTTP request to the url constructed from the base_url in config
+ * and th uri specified using the specified HTTP request.
+ * The config structure contains information about TLS certificates.
+ * If specified, it serializes the request data (JSON) and sends it to the
+ * server. The response data (JSON) is parsed and returned in the response data.
+ * If the response content type is not JSON, then an error is returned.
+ * The HTTP status code is returned in status_code.
+ *
+ * @param config            the configuration structure
+ * @param uri               the uri (and query parameters) to concatenate to the
+ *                          base_url from the config structure.
+ * @param request           the HTTP request to perform (e.g. GET, PUT, POST)
+ * @param request_data      the JSON data to be sent with the request.
+ * @param request_headers   a NULL terminated list of pointers to HTTP headers
+ *                          to send along with the request. Can be NULL.
+ * @param login_token       if not NULL, a Bearer token to authorize with
+ * @param response_data     on return the JSON response data is returned. When
+ *                          no longer needed, it must be released using
+ *                          json_object_put()
+ * @param response headers  address of a curl_slist to add response headers to,
+ *                          or NULL to not return any headers.
+ * @param status_code       on return the HTTP status code is returned
+ * @param error_msg         on return: If not NULL, then a textual error message
+ *                          is returned in case of a failing request. The caller
+ *                          must free the error string when it is not NULL.
+ * @param curl              a CURL handle to perform the request with.
+ * @param verbose           if true, verbose messages are printed
+ *
+ * @returns zero for success, a negative errno or a positive CURL error code in
+ *          case of an error
+ */
+static int _ekmf_perform_request(const struct ekmf_config *config,
+				 const char *uri, const char *request,
+				 json_object *request_data,
+				 char **request_headers,
+				 const char *login_token,
+				 json_object **response_data,
+				 struct curl_slist **response_headers,
+				 long *status_code, char **error_msg,
+				 CURL *curl, bool verbose)
+{
+	struct ekmf_request_state state = { 0 };
+	int rc;
+
+	if (config == NULL || uri == NULL || request == NULL ||
+	    status_code == NULL || curl == NULL)
+		return -EINVAL;
+
+	if (error_msg != NULL)
+		*error_msg = NULL;
+
+	rc = _ekmf_prepare_request(config, uri, request, request_data,
+				   request_headers, login_token,
+				   response_headers, &state, curl, verbose);
+	if (rc != 0)
+		return _ekmf_complete_request(&state, rc, false, response_data,
+					      status_code, error_msg, curl,
+					      verbose);
+
+	rc = curl_easy_perform(curl);
+	return _ekmf_complete_request(&state, rc, true, response_data,
+				      status_code, error_msg, curl, verbose);
+}
+
 /**
  * Allocates or reuses a CURL handle. If curl_handle is not NULL, and
  * points to a non-NULL CURL handle, it is used, otherwise a new CURL handle
@@ -1130,136 +1233,531 @@ static void _ekmf_release_curl_handle(CURL **curl_handle, CURL *curl)
 }
 
 /**
- * Print the certificate(s) contained in the specified PEM file.
- *
- * @param cert_pem          the file name of the PEM file to print
- * @param verbose           if true, verbose messages are printed
- *
- * @returns -EIO if the file could not be opened. -ENOENT if the PEM file
- *          does not contain any certificates. 0 if success.
+ * A multi handle performs multiple requests in parallel. The CURL handles of
+ * the multi handle share the DNS cache and the TLS sessions, and the multi
+ * handle keeps the connections alive for subsequent requests.
  */
-int ekmf_print_certificates(const char *cert_pem, bool verbose)
+struct ekmf_multi_handle {
+	CURLM *multi;
+	CURLSH *share;
+	CURL **curls;
+	unsigned int num_curls;
+};
+
+/**
+ * A request performed in parallel with other requests by
+ * _ekmf_perform_requests()
+ */
+struct ekmf_parallel_request {
+	/* Input fields */
+	char *uri;
+	const char *request;
+	json_object *request_data;
+	/* Output fields */
+	json_object *response_obj;
+	long status_code;
+	char *error_msg;
+	int rc;
+};
+
+struct ekmf_parallel_slot {
+	CURL *curl;
+	struct ekmf_request_state state;
+	struct ekmf_parallel_request *req;
+};
+
+/**
+ * Adds CURL handles to a multi handle until it contains at least num_curls
+ * handles. The added handles use the share handle of the multi handle.
+ */
+static int _ekmf_multi_add_curls(struct ekmf_multi_handle *mh,
+				 unsigned int num_curls, bool verbose)
 {
-	int rc = -ENOENT;
-	X509 *cert;
-	FILE *fp;
+	CURL **curls;
+	int rc;
 
-	if (cert_pem == NULL)
-		return -EINVAL;
+	if (mh->num_curls >= num_curls)
+		return 0;
 
-	fp = fopen(cert_pem, "r");
-	if (fp == NULL) {
-		pr_verbose(verbose, "File '%s': %s", cert_pem, strerror(errno));
-		return -EIO;
+	curls = realloc(mh->curls, num_curls * sizeof(CURL *));
+	if (curls == NULL) {
+		pr_verbose(verbose, "realloc failed");
+		return -ENOMEM;
 	}
+	mh->curls = curls;
 
-	while (1) {
-		cert = PEM_read_X509(fp, NULL, NULL, NULL);
-		if (cert == NULL)
-			break;
-
-		X509_print_ex_fp(stdout, cert, 0, X509_FLAG_NO_EXTENSIONS);
+	for (; mh->num_curls < num_curls; mh->num_curls++) {
+		mh->curls[mh->num_curls] = curl_easy_init();
+		if (mh->curls[mh->num_curls] == NULL) {
+			pr_verbose(verbose, "Failed to get CURL handle");
+			return -EIO;
+		}
 
-		X509_free(cert);
-		rc = 0;
+		rc = curl_easy_setopt(mh->curls[mh->num_curls], CURLOPT_SHARE,
+				      mh->share);
+		CURL_ERROR_CHECK(rc, "CURLOPT_SHARE", verbose, out);
 	}
 
-	fclose(fp);
-	return rc;
+	return 0;
+
+out:
+	curl_easy_cleanup(mh->curls[mh->num_curls]);
+	return -EIO;
 }
 
 /**
- * Checks if the login token stored in the file denoted by field login_token
- * of the config structure is valid or not. The file (if existent) contains a
- * JSON Web Token (JWT, see RFC7519). It is valid if the current date and time
- * is before its expiration time ("exp" claim), and after or equal its
- * not-before time ("nbf" claim).
- * Note: The signature (if any) of the JWT is not checked, nor any other JWT
- * fields.
- *
- * @param config            the configuration structure
- * @param valid             On return: true if the token is valid, false if not
- * @param login_token       On return: If not NULL: the login token, if the
- *                          token is still valid. The returned string must
- *                          be freed by the caller when no longer needed.
- * @param verbose           if true, verbose messages are printed
- *
- * @returns a negative errno in case of an error, 0 if success.
+ * Allocates or reuses a multi handle. If multi_handle is not NULL, and
+ * points to a non-NULL multi handle, it is used, otherwise a new multi handle
+ * is allocated. A multi handle always contains at least one CURL handle.
  */
-int ekmf_check_login_token(const struct ekmf_config *config, bool *valid,
-			   char **login_token, bool verbose)
+static int _ekmf_get_multi_handle(struct ekmf_multi_handle **multi_handle,
+				  struct ekmf_multi_handle **mh, bool verbose)
 {
-	json_object *jwt_payload = NULL;
-	json_object *exp_claim = NULL;
-	json_object *nbf_claim = NULL;
-	char *token = NULL;
-	size_t count, size;
-	int64_t exp, nbf;
-	FILE *fp = NULL;
-	struct stat sb;
-	int rc = 0;
-	time_t now;
+	int rc;
 
-	if (config == NULL || valid == NULL)
+	if (mh == NULL)
 		return -EINVAL;
 
-	if (config->login_token == NULL) {
-		*valid = false;
-		return 0;
-	}
+	if (multi_handle != NULL)
+		*mh = *multi_handle;
 
-	if (login_token != NULL)
-		*login_token = NULL;
+	if (*mh != NULL)
+		return 0;
 
-	pr_verbose(verbose, "Reading login token from file : '%s'",
-		   config->login_token);
+	*mh = calloc(1, sizeof(struct ekmf_multi_handle));
+	if (*mh == NULL) {
+		pr_verbose(verbose, "calloc failed");
+		return -ENOMEM;
+	}
 
-	if (stat(config->login_token, &sb)) {
-		rc = -errno;
-		pr_verbose(verbose, "stat on file %s failed: '%s'",
-			   config->login_token, strerror(-rc));
-		return rc;
+	(*mh)->multi = curl_multi_init();
+	(*mh)->share = curl_share_init();
+	if ((*mh)->multi == NULL || (*mh)->share == NULL) {
+		pr_verbose(verbose, "Failed to get CURL multi handle");
+		rc = -EIO;
+		goto out;
 	}
-	size = sb.st_size;
-	if (size == 0) {
-		pr_verbose(verbose, "File %s is empty", config->login_token);
+
+	rc = curl_share_setopt((*mh)->share, CURLSHOPT_SHARE,
+			       CURL_LOCK_DATA_DNS);
+	if (rc == CURLSHE_OK)
+		rc = curl_share_setopt((*mh)->share, CURLSHOPT_SHARE,
+				       CURL_LOCK_DATA_SSL_SESSION);
+	if (rc != CURLSHE_OK) {
+		pr_verbose(verbose, "CURLSHOPT_SHARE failed: %s",
+			   curl_share_strerror(rc));
 		rc = -EIO;
 		goto out;
 	}
 
-	token = (char *)malloc(size + 1);
-	if (token == NULL) {
-		pr_verbose(verbose, "Failed to allocate a buffer");
-		return -ENOMEM;
+	rc = _ekmf_multi_add_curls(*mh, 1, verbose);
+
+out:
+	if (rc != 0) {
+		ekmf_multi_destroy(*mh);
+		*mh = NULL;
 	}
 
-	fp = fopen(config->login_token, "r");
-	if (fp == NULL) {
-		rc = -errno;
-		pr_verbose(verbose, "Failed to open file %s: '%s'",
-			   config->login_token, strerror(-rc));
+	return rc;
+}
+
+/**
+ * Releases a multi handle. If multi_handle is not NULL, then the used multi
+ * handle is passed back via *multi_handle. If multi_handle is NULL, then the
+ * used multi handle is destroyed.
+ */
+static void _ekmf_release_multi_handle(struct ekmf_multi_handle **multi_handle,
+				       struct ekmf_multi_handle *mh)
+{
+	if (mh == NULL)
+		return;
+
+	if (multi_handle != NULL)
+		*multi_handle = mh;
+	else
+		ekmf_multi_destroy(mh);
+}
+
+/**
+ * Starts a request on a free slot. If the request can not be started, it is
+ * completed with an error and the slot stays free.
+ */
+static int _ekmf_start_request(const struct ekmf_config *config,
+			       struct ekmf_multi_handle *mh,
+			       struct ekmf_parallel_slot *slot,
+			       struct ekmf_parallel_request *req,
+			       bool multiplex, const char *login_token,
+			       bool verbose)
+{
+	int rc;
+
+	memset(&slot->state, 0, sizeof(slot->state));
+
+	rc = _ekmf_prepare_request(config, req->uri, req->request,
+				   req->request_data, NULL, login_token, NULL,
+				   &slot->state, slot->curl, verbose);
+	if (rc != 0)
 		goto out;
+
+	/* curl_easy_reset() keeps the share, but set it again to be sure */
+	rc = curl_easy_setopt(slot->curl, CURLOPT_SHARE, mh->share);
+	CURL_ERROR_CHECK(rc, "CURLOPT_SHARE", verbose, out);
+	rc = curl_easy_setopt(slot->curl, CURLOPT_PRIVATE, slot);
+	CURL_ERROR_CHECK(rc, "CURLOPT_PRIVATE", verbose, out);
+
+	if (multiplex) {
+		rc = curl_easy_setopt(slot->curl, CURLOPT_HTTP_VERSION,
+				      CURL_HTTP_VERSION_2TLS);
+		CURL_ERROR_CHECK(rc, "CURLOPT_HTTP_VERSION", verbose, out);
+		/* Wait for a connection to multiplex on, if one is pending */
+		rc = curl_easy_setopt(slot->curl, CURLOPT_PIPEWAIT, 1L);
+		CURL_ERROR_CHECK(rc, "CURLOPT_PIPEWAIT", verbose, out);
 	}
 
-	count = fread(token, 1, size, fp);
-	if (count != size) {
-		pr_verbose(verbose, "Failed to read the token");
+	rc = curl_multi_add_handle(mh->multi, slot->curl);
+	if (rc != CURLM_OK) {
+		pr_verbose(verbose, "curl_multi_add_handle failed: %s",
+			   curl_multi_strerror(rc));
 		rc = -EIO;
 		goto out;
 	}
-	token[size] = '\0';
-	if (token[size - 1] == '\n')
-		token[size - 1] = '\0';
 
-	fclose(fp);
-	fp = NULL;
+	slot->req = req;
+	return 0;
 
-	time(&now);
-	*valid = true;
+out:
+	req->rc = _ekmf_complete_request(&slot->state, rc, false, NULL,
+					 &req->status_code, &req->error_msg,
+					 slot->curl, verbose);
+	if (req->rc > 0)
+		req->rc = -EIO;
+	return req->rc;
+}
 
-	rc = parse_json_web_token(token, NULL, &jwt_payload, NULL, NULL);
-	if (rc != 0) {
-		pr_verbose(verbose, "parse_json_web_token failed");
+/**
+ * Performs multiple requests in parallel using the CURL handles of a multi
+ * handle. At most max_parallel requests are in flight at the same time.
+ * If multiplex is true, then the requests are multiplexed over as few HTTP/2
+ * connections as possible, otherwise each request in flight uses its own
+ * connection. The result of each request is returned in the request's output
+ * fields. The caller must free the error message and the response object of
+ * each request.
+ *
+ * All requests are performed by the calling thread.
+ *
+ * @returns zero if all requests were performed (check the rc field of each
+ *          request for its result), or a negative errno in case the multi
+ *          handle failed.
+ */
+static int _ekmf_perform_requests(const struct ekmf_config *config,
+				  struct ekmf_multi_handle *mh,
+				  unsigned int max_parallel, bool multiplex,
+				  const char *login_token,
+				  struct ekmf_parallel_request *reqs,
+				  size_t num_reqs, bool verbose)
+{
+	struct ekmf_parallel_slot *slots = NULL, *slot;
+	unsigned int i, active = 0;
+	int running = 0, msgs;
+	size_t next = 0;
+	CURLcode result;
+	CURLMsg *msg;
+	CURL *easy;
+	int rc;
+
+	if (num_reqs == 0)
+		return 0;
+
+	if (max_parallel == 0)
+		max_parallel = EKMF_DEFAULT_MAX_PARALLEL;
+	if (max_parallel > num_reqs)
+		max_parallel = num_reqs;
+
+	rc = _ekmf_multi_add_curls(mh, max_parallel, verbose);
+	if (rc != 0)
+		return rc;
+
+	slots = calloc(max_parallel, sizeof(struct ekmf_parallel_slot));
+	if (slots == NULL) {
+		pr_verbose(verbose, "calloc failed");
+		return -ENOMEM;
+	}
+	for (i = 0; i < max_parallel; i++)
+		slots[i].curl = mh->curls[i];
+
+	curl_multi_setopt(mh->multi, CURLMOPT_PIPELINING, multiplex ?
+			  CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+	/*
+	 * With multiplexing, CURLOPT_PIPEWAIT makes the requests wait for the
+	 * first connection, and only if that is not HTTP/2, further
+	 * connections are opened.
+	 */
+	curl_multi_setopt(mh->multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+			  (long)max_parallel);
+
+	pr_verbose(verbose, "Performing %lu requests, %u in parallel%s",
+		   num_reqs, max_parallel, multiplex ? " (multiplexed)" : "");
+
+	while (next < num_reqs || active > 0) {
+		for (i = 0; i < max_parallel && next < num_reqs; i++) {
+			if (slots[i].req != NULL)
+				continue;
+			if (_ekmf_start_request(config, mh, &slots[i],
+						&reqs[next++], multiplex,
+						login_token, verbose) == 0)
+				active++;
+		}
+
+		if (active == 0)
+			continue;
+
+		rc = curl_multi_perform(mh->multi, &running);
+		if (rc != CURLM_OK) {
+			pr_verbose(verbose, "curl_multi_perform failed: %s",
+				   curl_multi_strerror(rc));
+			rc = -EIO;
+			goto out;
+		}
+
+		while ((msg = curl_multi_info_read(mh->multi, &msgs)) != NULL) {
+			if (msg->msg != CURLMSG_DONE)
+				continue;
+
+			easy = msg->easy_handle;
+			result = msg->data.result;
+			curl_easy_getinfo(easy, CURLINFO_PRIVATE, (char **)&slot);
+			curl_multi_remove_handle(mh->multi, easy);
+
+			slot->req->rc = _ekmf_complete_request(&slot->state,
+						result, true,
+						&slot->req->response_obj,
+						&slot->req->status_code,
+						&slot->req->error_msg,
+						slot->curl, verbose);
+			if (slot->req->rc > 0)
+				slot->req->rc = -EIO;
+			slot->req = NULL;
+			active--;
+		}
+
+		if (running > 0) {
+			rc = curl_multi_wait(mh->multi, NULL, 0, 1000, NULL);
+			if (rc != CURLM_OK) {
+				pr_verbose(verbose, "curl_multi_wait failed: "
+					   "%s", curl_multi_strerror(rc));
+				rc = -EIO;
+				goto out;
+			}
+		}
+	}
+
+	rc = 0;
+
+out:
+	for (i = 0; i < max_parallel; i++) {
+		if (slots[i].req == NULL)
+			continue;
+		curl_multi_remove_handle(mh->multi, slots[i].curl);
+		if (slots[i].state.write_cb.obj != NULL)
+			json_object_put(slots[i].state.write_cb.obj);
+		slots[i].req->rc = _ekmf_complete_request(&slots[i].state, rc,
+						false, NULL,
+						&slots[i].req->status_code,
+						NULL, slots[i].curl, verbose);
+	}
+	for (; next < num_reqs; next++)
+		reqs[next].rc = rc;
+	free(slots);
+
+	return rc;
+}
+
+/**
+ * Frees the input and output fields of parallel requests
+ */
+static void _ekmf_free_parallel_requests(struct ekmf_parallel_request *reqs,
+					 size_t num_reqs)
+{
+	size_t i;
+
+	if (reqs == NULL)
+		return;
+
+	for (i = 0; i < num_reqs; i++) {
+		if (reqs[i].uri != NULL)
+			free(reqs[i].uri);
+		if (reqs[i].response_obj != NULL)
+			json_object_put(reqs[i].response_obj);
+		if (reqs[i].error_msg != NULL)
+			free(reqs[i].error_msg);
+	}
+	free(reqs);
+}
+
+/**
+ * Checks the HTTP status code of a request that is expected to return 200.
+ * If not_found is false, status code 404 is treated like any other
+ * unexpected status code, and -EIO is returned.
+ */
+static int _ekmf_check_status_code(long status_code, bool not_found,
+				   bool verbose)
+{
+	switch (status_code) {
+	case 200:
+		return 0;
+	case 400:
+		pr_verbose(verbose, "Bad request");
+		return -EBADMSG;
+	case 401:
+		pr_verbose(verbose, "Not authorized");
+		return -EACCES;
+	case 403:
+		pr_verbose(verbose, "Insufficient permissions");
+		return -EPERM;
+	case 404:
+		if (not_found) {
+			pr_verbose(verbose, "Not found");
+			return -ENOENT;
+		}
+		/* fall through */
+	default:
+		pr_verbose(verbose, "REST Call failed with HTTP status code: "
+			   "%ld", status_code);
+		return -EIO;
+	}
+}
+
+/**
+ * Print the certificate(s) contained in the specified PEM file.
+ *
+ * @param cert_pem          the file name of the PEM file to print
+ * @param verbose           if true, verbose messages are printed
+ *
+ * @returns -EIO if the file could not be opened. -ENOENT if the PEM file
+ *          does not contain any certificates. 0 if success.
+ */
+int ekmf_print_certificates(const char *cert_pem, bool verbose)
+{
+	int rc = -ENOENT;
+	X509 *cert;
+	FILE *fp;
+
+	if (cert_pem == NULL)
+		return -EINVAL;
+
+	fp = fopen(cert_pem, "r");
+	if (fp == NULL) {
+		pr_verbose(verbose, "File '%s': %s", cert_pem, strerror(errno));
+		return -EIO;
+	}
+
+	while (1) {
+		cert = PEM_read_X509(fp, NULL, NULL, NULL);
+		if (cert == NULL)
+			break;
+
+		X509_print_ex_fp(stdout, cert, 0, X509_FLAG_NO_EXTENSIONS);
+
+		X509_free(cert);
+		rc = 0;
+	}
+
+	fclose(fp);
+	return rc;
+}
+
+/**
+ * Checks if the login token stored in the file denoted by field login_token
+ * of the config structure is valid or not. The file (if existent) contains a
+ * JSON Web Token (JWT, see RFC7519). It is valid if the current date and time
+ * is before its expiration time ("exp" claim), and after or equal its
+ * not-before time ("nbf" claim).
+ * Note: The signature (if any) of the JWT is not checked, nor any other JWT
+ * fields.
+ *
+ * @param config            the configuration structure
+ * @param valid             On return: true if the token is valid, false if not
+ * @param login_token       On return: If not NULL: the login token, if the
+ *                          token is still valid. The returned string must
+ *                          be freed by the caller when no longer needed.
+ * @param verbose           if true, verbose messages are printed
+ *
+ * @returns a negative errno in case of an error, 0 if success.
+ */
+int ekmf_check_login_token(const struct ekmf_config *config, bool *valid,
+			   char **login_token, bool verbose)
+{
+	json_object *jwt_payload = NULL;
+	json_object *exp_claim = NULL;
+	json_object *nbf_claim = NULL;
+	char *token = NULL;
+	size_t count, size;
+	int64_t exp, nbf;
+	FILE *fp = NULL;
+	struct stat sb;
+	int rc = 0;
+	time_t now;
+
+	if (config == NULL || valid == NULL)
+		return -EINVAL;
+
+	if (config->login_token == NULL) {
+		*valid = false;
+		return 0;
+	}
+
+	if (login_token != NULL)
+		*login_token = NULL;
+
+	pr_verbose(verbose, "Reading login token from file : '%s'",
+		   config->login_token);
+
+	if (stat(config->login_token, &sb)) {
+		rc = -errno;
+		pr_verbose(verbose, "stat on file %s failed: '%s'",
+			   config->login_token, strerror(-rc));
+		return rc;
+	}
+	size = sb.st_size;
+	if (size == 0) {
+		pr_verbose(verbose, "File %s is empty", config->login_token);
+		rc = -EIO;
+		goto out;
+	}
+
+	token = (char *)malloc(size + 1);
+	if (token == NULL) {
+		pr_verbose(verbose, "Failed to allocate a buffer");
+		return -ENOMEM;
+	}
+
+	fp = fopen(config->login_token, "r");
+	if (fp == NULL) {
+		rc = -errno;
+		pr_verbose(verbose, "Failed to open file %s: '%s'",
+			   config->login_token, strerror(-rc));
+		goto out;
+	}
+
+	count = fread(token, 1, size, fp);
+	if (count != size) {
+		pr_verbose(verbose, "Failed to read the token");
+		rc = -EIO;
+		goto out;
+	}
+	token[size] = '\0';
+	if (token[size - 1] == '\n')
+		token[size - 1] = '\0';
+
+	fclose(fp);
+	fp = NULL;
+
+	time(&now);
+	*valid = true;
+
+	rc = parse_json_web_token(token, NULL, &jwt_payload, NULL, NULL);
+	if (rc != 0) {
+		pr_verbose(verbose, "parse_json_web_token failed");
 		goto out;
 	}
 
@@ -2344,133 +2842,53 @@ static int _ekmf_pub_key_as_json_web_key(const struct sk_pub_key_info *pub_key,
 }
 
 /**
- * Requests a key to be retrieved from EKMFweb and imported under the current
- * HSM's master key.
- *
- * To perform a single request, set curl_handle to NULL. This will cause the
- * function to initialize a new CURL handle, use it, and destroy it.
- * If you plan to perform multiple requests to the same host, supply the address
- * of a CURL pointer that is initially NULL. This function will then initialize
- * a new CURL handle on the first call. On subsequent calls, pass in the address
- * of the same CURL pointer so that the CURL handle is reused. After the last
- * request, the CURL handle must be destroyed by calling ekmf_curl_destroy).
- *
- * @param config            the configuration structure
- * @param curl_handle       address of a CURL handle used for reusing the same
- *                          CURL handle with multiple requests.
- * @param key_uuid          the UUID of the key to retrieve
- * @param sess_ec_curve_nid The OpenSSL nid of the EC curve used for the session
- *                          ECC key. If 0, then the default curve is used.
- * @param sign_rsa_digest_nid The OpenSSL nid of a digest used to sign the
- *                          request with if the identity key is an RSA-type key.
- *                          If 0, then the default digest is used.
- *                          Ignored for ECC-type identity keys.
- * @param use_rsa_pss       If true, and the identity key is an RSA-type key,
- *                          use RSA-PSS to sign the request.
- * @param signature_kid     the Key ID for the signature of the request
- * @param key_blob          a buffer to store the retrieved key blob to
- * @param key_blob_length   On entry: the size ofthe buffer
- *                          On return: the size of the key blob retrieved
- * @param error_msg         on return: If not NULL, then a textual error message
- *                          is returned in case of a failing request. The caller
- *                          must free the error string when it is not NULL.
- * @param ext_lib           External secure key crypto library to use
- * @param verbose           if true, verbose messages are printed
- *
- * @returns zero for success, a negative errno in case of an error.
- *          -EACCES is returned, if no or no valid login token is available.
- *          -EPERM is returned if the login token does not have permission to
- *          retrieve the key
+ * State of a key retrieval. The session EC key and the party info of the
+ * request are needed to import the key from the response.
  */
-int ekmf_retrieve_key(const struct ekmf_config *config, CURL **curl_handle,
-		      const char *key_uuid, int sess_ec_curve_nid,
-		      int sign_rsa_digest_nid, bool use_rsa_pss,
-		      const char *signature_kid, unsigned char *key_blob,
-		      size_t *key_blob_length, char **error_msg,
-		      const struct ekmf_ext_lib *ext_lib, bool verbose)
-{
-	size_t req_party_info_length, resp_party_info_length;
-	unsigned char req_party_info[SHA512_DIGEST_LENGTH];
-	size_t req_sess_ec_key_length, identity_key_length;
+struct ekmf_retrieve_ctx {
 	unsigned char req_sess_ec_key[MAX_KEY_BLOB_SIZE];
-	unsigned char identity_key[MAX_KEY_BLOB_SIZE];
-	json_object *resp_originator_obj = NULL;
-	json_object *resp_addl_info_obj = NULL;
-	json_object *req_party_info_obj = NULL;
+	size_t req_sess_ec_key_length;
+	unsigned char req_party_info[SHA512_DIGEST_LENGTH];
+	size_t req_party_info_length;
+	json_object *request_obj;
+	char *uri;
+};
+
+/**
+ * Builds the request to retrieve a key: A session EC key is generated, and
+ * the request is signed with the identity key.
+ */
+static int _ekmf_build_retrieve_request(const char *key_uuid, CURL *curl,
+					int sess_ec_curve_nid,
+					int sign_rsa_digest_nid,
+					bool use_rsa_pss,
+					const char *signature_kid,
+					unsigned char *identity_key,
+					size_t identity_key_length,
+					struct ekmf_retrieve_ctx *ctx,
+					const struct ekmf_ext_lib *ext_lib,
+					bool verbose)
+{
+	json_object *req_party_info_obj = NULL;
 	json_object *req_originator_obj = NULL;
 	json_object *req_timestamp_obj = NULL;
 	json_object *req_addl_info_obj = NULL;
 	json_object *req_signature_obj = NULL;
-	unsigned char *resp_party_info = NULL;
-	json_object *resp_sess_jwk_obj = NULL;
 	json_object *req_sess_jwk_obj = NULL;
-	json_object *resp_exp_jwk_obj = NULL;
 	struct ext_lib_info ext_lib_info;
-	json_object *response_obj = NULL;
-	json_object *request_obj = NULL;
 	struct sk_key_gen_info gen_info;
-	EVP_PKEY *server_pubkey = NULL;
 	char *escaped_uuid = NULL;
-	char *login_token = NULL;
-	bool token_valid = false;
-	CURL *curl = NULL;
-	long status_code;
-	char *uri = NULL;
 	int rc;
 
-	if (config == NULL || key_uuid == NULL || key_blob == NULL ||
-	    key_blob_length == NULL || ext_lib == NULL)
-		return -EINVAL;
-
 	_ekmf_copy_ext_lib(ext_lib, &ext_lib_info);
 
-	rc = SK_OPENSSL_init(verbose);
-	if (rc != 0) {
-		pr_verbose(verbose, "Failed to initialize secure key support: "
-			   "%s", strerror(-rc));
-		return rc;
-	}
-
-	rc = ekmf_check_login_token(config, &token_valid, &login_token,
-				    verbose);
-	if (rc != 0 || !token_valid) {
-		pr_verbose(verbose, "No valid login token available");
-		rc = -EACCES;
-		goto out;
-	}
-
-	rc = _ekmf_get_curl_handle(curl_handle, &curl);
-	if (rc != 0) {
-		pr_verbose(verbose, "Failed to get CURL handle");
-		rc = -EIO;
-		goto out;
-	}
-
-	rc = read_public_key(config->ekmf_server_pubkey, &server_pubkey);
-	if (rc != 0) {
-		pr_verbose(verbose, "Failed to read EKMFWeb server's public key"
-			   " '%s': %s", config->ekmf_server_pubkey,
-			   strerror(-rc));
-		goto out;
-	}
-
-	identity_key_length = sizeof(identity_key);
-	rc = read_key_blob(config->identity_secure_key, identity_key,
-			   &identity_key_length);
-	if (rc != 0) {
-		pr_verbose(verbose, "Failed to read identity key from file "
-			   "'%s': %s", config->identity_secure_key,
-			   strerror(-rc));
-		goto out;
-	}
-
 	gen_info.type = SK_KEY_TYPE_EC;
 	gen_info.ec.curve_nid = sess_ec_curve_nid != 0 ? sess_ec_curve_nid :
 						DEFAULT_SESSION_EC_KEY_CURVE;
 
-	req_sess_ec_key_length = sizeof(req_sess_ec_key);
-	rc = SK_OPENSSL_generate_secure_key(req_sess_ec_key,
-					    &req_sess_ec_key_length,
+	ctx->req_sess_ec_key_length = sizeof(ctx->req_sess_ec_key);
+	rc = SK_OPENSSL_generate_secure_key(ctx->req_sess_ec_key,
+					    &ctx->req_sess_ec_key_length,
 					    &gen_info, &ext_lib_info.ext_lib,
 					    verbose);
 	if (rc != 0) {
@@ -2479,8 +2897,8 @@ int ekmf_retrieve_key(const struct ekmf_config *config, CURL **curl_handle,
 		goto out;
 	}
 
-	rc = SK_OPENSSL_get_public_from_secure_key(req_sess_ec_key,
-						   req_sess_ec_key_length,
+	rc = SK_OPENSSL_get_public_from_secure_key(ctx->req_sess_ec_key,
+						   ctx->req_sess_ec_key_length,
 						_ekmf_pub_key_as_json_web_key,
 						   &req_sess_jwk_obj,
 						   &ext_lib_info.ext_lib,
@@ -2494,11 +2912,11 @@ int ekmf_retrieve_key(const struct ekmf_config *config, CURL **curl_handle,
 	JSON_CHECK_ERROR(req_timestamp_obj == NULL, rc, -EIO,
 			 "Failed to generate timestamp", verbose, out);
 
-	req_party_info_length = sizeof(req_party_info);
+	ctx->req_party_info_length = sizeof(ctx->req_party_info);
 	rc = _ekmf_build_party_info(key_uuid,
 				    json_object_get_string(req_timestamp_obj),
-				    NID_sha256, req_party_info,
-				    &req_party_info_length,
+				    NID_sha256, ctx->req_party_info,
+				    &ctx->req_party_info_length,
 				    &req_party_info_obj, verbose);
 	if (rc != 0) {
 		pr_verbose(verbose, "Failed to build the party info");
@@ -2543,23 +2961,23 @@ int ekmf_retrieve_key(const struct ekmf_config *config, CURL **curl_handle,
 			 verbose, out);
 	req_party_info_obj = NULL;
 
-	request_obj = json_object_new_object();
-	JSON_CHECK_ERROR(request_obj == NULL, rc, -ENOMEM,
+	ctx->request_obj = json_object_new_object();
+	JSON_CHECK_ERROR(ctx->request_obj == NULL, rc, -ENOMEM,
 			 "Failed to generate JSON object", verbose, out);
 
-	rc = json_object_object_add_ex(request_obj, "originator",
+	rc = json_object_object_add_ex(ctx->request_obj, "originator",
 				       req_originator_obj, 0);
 	JSON_CHECK_ERROR(rc != 0, rc, -EIO, "Failed to add data to JSON object",
 			 verbose, out);
 	req_originator_obj = NULL;
-	rc = json_object_object_add_ex(request_obj, "additionalInfo",
+	rc = json_object_object_add_ex(ctx->request_obj, "additionalInfo",
 				       req_addl_info_obj, 0);
 	JSON_CHECK_ERROR(rc != 0, rc, -EIO, "Failed to add data to JSON object",
 			 verbose, out);
 	req_addl_info_obj = NULL;
 
 	rc = _ekmf_build_signature(identity_key, identity_key_length,
-				   request_obj, &req_signature_obj,
+				   ctx->request_obj, &req_signature_obj,
 				   sign_rsa_digest_nid, use_rsa_pss,
 				   signature_kid, ext_lib, verbose);
 	if (rc != 0) {
@@ -2567,148 +2985,510 @@ int ekmf_retrieve_key(const struct ekmf_config *config, CURL **curl_handle,
 		goto out;
 	}
 
-	rc = json_object_object_add_ex(request_obj, "signature",
+	rc = json_object_object_add_ex(ctx->request_obj, "signature",
 				       req_signature_obj, 0);
 	JSON_CHECK_ERROR(rc != 0, rc, -EIO, "Failed to add data to JSON object",
 			 verbose, out);
 	req_signature_obj = NULL;
 
-	escaped_uuid = curl_easy_escape(curl, key_uuid, 0);
-	if (escaped_uuid == NULL) {
-		pr_verbose(verbose, "Failed to url-escape the key uuid");
-		rc = -EIO;
-		goto out;
-	}
+	escaped_uuid = curl_easy_escape(curl, key_uuid, 0);
+	if (escaped_uuid == NULL) {
+		pr_verbose(verbose, "Failed to url-escape the key uuid");
+		rc = -EIO;
+		goto out;
+	}
+
+	if (asprintf(&ctx->uri, EKMF_URI_KEYS_EXPORT, escaped_uuid) < 0) {
+		pr_verbose(verbose, "asprintf failed");
+		ctx->uri = NULL;
+		rc = -ENOMEM;
+		goto out;
+	}
+
+out:
+	if (req_sess_jwk_obj != NULL)
+		json_object_put(req_sess_jwk_obj);
+	if (req_timestamp_obj != NULL)
+		json_object_put(req_timestamp_obj);
+	if (req_addl_info_obj != NULL)
+		json_object_put(req_addl_info_obj);
+	if (req_party_info_obj != NULL)
+		json_object_put(req_party_info_obj);
+	if (req_originator_obj != NULL)
+		json_object_put(req_originator_obj);
+	if (req_signature_obj != NULL)
+		json_object_put(req_signature_obj);
+	if (escaped_uuid != NULL)
+		curl_free(escaped_uuid);
+
+	return rc;
+}
+
+/**
+ * Processes the response of a key retrieval: The response signature is
+ * verified, and the retrieved key is imported under the current HSM's master
+ * key.
+ */
+static int _ekmf_process_retrieve_response(struct ekmf_retrieve_ctx *ctx,
+					   json_object *response_obj,
+					   long status_code,
+					   EVP_PKEY *server_pubkey,
+					   unsigned char *key_blob,
+					   size_t *key_blob_length,
+					   const struct ekmf_ext_lib *ext_lib,
+					   bool verbose)
+{
+	json_object *resp_originator_obj = NULL;
+	json_object *resp_addl_info_obj = NULL;
+	unsigned char *resp_party_info = NULL;
+	json_object *resp_sess_jwk_obj = NULL;
+	json_object *resp_exp_jwk_obj = NULL;
+	size_t resp_party_info_length;
+	int rc = 0;
+
+	switch (status_code) {
+	case 200:
+		break;
+	case 400:
+		pr_verbose(verbose, "Bad request");
+		rc = -EBADMSG;
+		goto out;
+	case 401:
+		pr_verbose(verbose, "Not authorized");
+		rc = -EACCES;
+		goto out;
+	case 403:
+		pr_verbose(verbose, "Insufficient permissions");
+		rc = -EPERM;
+		goto out;
+	case 404:
+		pr_verbose(verbose, "Not found");
+		rc = -ENOENT;
+		goto out;
+	default:
+		pr_verbose(verbose, "REST Call failed with HTTP status code: "
+			   "%ld", status_code);
+		rc = -EIO;
+		goto out;
+	}
+
+	JSON_CHECK_OBJ(response_obj, json_type_object, rc, -EBADMSG,
+		       "No or invalid response", verbose, out);
+
+	rc = _ekmf_verify_signature(response_obj, server_pubkey, verbose);
+	if (rc != 0)
+		goto out;
+
+	json_object_object_get_ex(response_obj, "originator",
+				  &resp_originator_obj);
+	JSON_CHECK_OBJ(resp_originator_obj, json_type_object, rc, -EBADMSG,
+		       "Failed to get the response originator", verbose, out);
+
+	json_object_object_get_ex(resp_originator_obj, "session",
+				  &resp_sess_jwk_obj);
+	JSON_CHECK_OBJ(resp_sess_jwk_obj, json_type_object, rc, -EBADMSG,
+		       "Failed to get the response session key", verbose, out);
+
+	rc = json_object_get_base64url(resp_originator_obj, "partyInfo",
+				       NULL, &resp_party_info_length);
+	if (rc != 0) {
+		pr_verbose(verbose, "Failed to get the response partyInfo");
+		goto out;
+	}
+
+	resp_party_info = malloc(resp_party_info_length);
+	if (resp_party_info == NULL) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	rc = json_object_get_base64url(resp_originator_obj, "partyInfo",
+				       resp_party_info,
+				       &resp_party_info_length);
+	if (rc != 0) {
+		pr_verbose(verbose, "Failed to get the response partyInfo");
+		goto out;
+	}
+
+	json_object_object_get_ex(response_obj, "additionalInfo",
+				  &resp_addl_info_obj);
+	JSON_CHECK_OBJ(resp_addl_info_obj, json_type_object, rc, -EBADMSG,
+		       "Failed to get the response addl.info", verbose, out);
+
+	json_object_object_get_ex(resp_addl_info_obj, "exportedKey",
+				  &resp_exp_jwk_obj);
+	JSON_CHECK_OBJ(resp_exp_jwk_obj, json_type_object, rc, -EBADMSG,
+		       "Failed to get the response exported key", verbose, out);
+
+	rc = _ekmf_import_key(ctx->req_sess_ec_key, ctx->req_sess_ec_key_length,
+			      ctx->req_party_info, ctx->req_party_info_length,
+			      resp_party_info, resp_party_info_length,
+			      resp_sess_jwk_obj, resp_exp_jwk_obj,
+			      key_blob, key_blob_length, ext_lib, verbose);
+	if (rc != 0) {
+		pr_verbose(verbose, "Failed to import the retrieved key");
+		goto out;
+	}
+
+out:
+	if (resp_party_info != NULL)
+		free(resp_party_info);
+
+	return rc;
+}
+
+/**
+ * Frees the request and the URI of a key retrieval
+ */
+static void _ekmf_free_retrieve_ctx(struct ekmf_retrieve_ctx *ctx)
+{
+	if (ctx->request_obj != NULL)
+		json_object_put(ctx->request_obj);
+	if (ctx->uri != NULL)
+		free(ctx->uri);
+	ctx->request_obj = NULL;
+	ctx->uri = NULL;
+}
+
+/**
+ * Requests a key to be retrieved from EKMFweb and imported under the current
+ * HSM's master key.
+ *
+ * To perform a single request, set curl_handle to NULL. This will cause the
+ * function to initialize a new CURL handle, use it, and destroy it.
+ * If you plan to perform multiple requests to the same host, supply the address
+ * of a CURL pointer that is initially NULL. This function will then initialize
+ * a new CURL handle on the first call. On subsequent calls, pass in the address
+ * of the same CURL pointer so that the CURL handle is reused. After the last
+ * request, the CURL handle must be destroyed by calling ekmf_curl_destroy).
+ *
+ * @param config            the configuration structure
+ * @param curl_handle       address of a CURL handle used for reusing the same
+ *                          CURL handle with multiple requests.
+ * @param key_uuid          the UUID of the key to retrieve
+ * @param sess_ec_curve_nid The OpenSSL nid of the EC curve used for the session
+ *                          ECC key. If 0, then the default curve is used.
+ * @param sign_rsa_digest_nid The OpenSSL nid of a digest used to sign the
+ *                          request with if the identity key is an RSA-type key.
+ *                          If 0, then the default digest is used.
+ *                          Ignored for ECC-type identity keys.
+ * @param use_rsa_pss       If true, and the identity key is an RSA-type key,
+ *                          use RSA-PSS to sign the request.
+ * @param signature_kid     the Key ID for the signature of the request
+ * @param key_blob          a buffer to store the retrieved key blob to
+ * @param key_blob_length   On entry: the size ofthe buffer
+ *                          On return: the size of the key blob retrieved
+ * @param error_msg         on return: If not NULL, then a textual error message
+ *                          is returned in case of a failing request. The caller
+ *                          must free the error string when it is not NULL.
+ * @param ext_lib           External secure key crypto library to use
+ * @param verbose           if true, verbose messages are printed
+ *
+ * @returns zero for success, a negative errno in case of an error.
+ *          -EACCES is returned, if no or no valid login token is available.
+ *          -EPERM is returned if the login token does not have permission to
+ *          retrieve the key
+ */
+int ekmf_retrieve_key(const struct ekmf_config *config, CURL **curl_handle,
+		      const char *key_uuid, int sess_ec_curve_nid,
+		      int sign_rsa_digest_nid, bool use_rsa_pss,
+		      const char *signature_kid, unsigned char *key_blob,
+		      size_t *key_blob_length, char **error_msg,
+		      const struct ekmf_ext_lib *ext_lib, bool verbose)
+{
+	unsigned char identity_key[MAX_KEY_BLOB_SIZE];
+	struct ekmf_retrieve_ctx *ctx = NULL;
+	json_object *response_obj = NULL;
+	EVP_PKEY *server_pubkey = NULL;
+	size_t identity_key_length;
+	char *login_token = NULL;
+	bool token_valid = false;
+	CURL *curl = NULL;
+	long status_code;
+	int rc;
+
+	if (config == NULL || key_uuid == NULL || key_blob == NULL ||
+	    key_blob_length == NULL || ext_lib == NULL)
+		return -EINVAL;
+
+	rc = SK_OPENSSL_init(verbose);
+	if (rc != 0) {
+		pr_verbose(verbose, "Failed to initialize secure key support: "
+			   "%s", strerror(-rc));
+		return rc;
+	}
+
+	rc = ekmf_check_login_token(config, &token_valid, &login_token,
+				    verbose);
+	if (rc != 0 || !token_valid) {
+		pr_verbose(verbose, "No valid login token available");
+		rc = -EACCES;
+		goto out;
+	}
+
+	rc = _ekmf_get_curl_handle(curl_handle, &curl);
+	if (rc != 0) {
+		pr_verbose(verbose, "Failed to get CURL handle");
+		rc = -EIO;
+		goto out;
+	}
+
+	rc = read_public_key(config->ekmf_server_pubkey, &server_pubkey);
+	if (rc != 0) {
+		pr_verbose(verbose, "Failed to read EKMFWeb server's public key"
+			   " '%s': %s", config->ekmf_server_pubkey,
+			   strerror(-rc));
+		goto out;
+	}
+
+	identity_key_length = sizeof(identity_key);
+	rc = read_key_blob(config->identity_secure_key, identity_key,
+			   &identity_key_length);
+	if (rc != 0) {
+		pr_verbose(verbose, "Failed to read identity key from file "
+			   "'%s': %s", config->identity_secure_key,
+			   strerror(-rc));
+		goto out;
+	}
+
+	ctx = calloc(1, sizeof(struct ekmf_retrieve_ctx));
+	if (ctx == NULL) {
+		pr_verbose(verbose, "calloc failed");
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	rc = _ekmf_build_retrieve_request(key_uuid, curl, sess_ec_curve_nid,
+					  sign_rsa_digest_nid, use_rsa_pss,
+					  signature_kid, identity_key,
+					  identity_key_length, ctx, ext_lib,
+					  verbose);
+	if (rc != 0)
+		goto out;
+
+	rc = _ekmf_perform_request(config, ctx->uri, "POST", ctx->request_obj,
+				   NULL, login_token, &response_obj, NULL,
+				   &status_code, error_msg, curl, verbose);
+	if (rc != 0) {
+		pr_verbose(verbose, "Failed perform the REST call");
+		if (rc > 0)
+			rc = -EIO;
+		goto out;
+	}
+
+	rc = _ekmf_process_retrieve_response(ctx, response_obj, status_code,
+					     server_pubkey, key_blob,
+					     key_blob_length, ext_lib, verbose);
+
+out:
+	_ekmf_release_curl_handle(curl_handle, curl);
+
+	if (ctx != NULL) {
+		_ekmf_free_retrieve_ctx(ctx);
+		free(ctx);
+	}
+	if (response_obj != NULL)
+		json_object_put(response_obj);
+	if (login_token != NULL)
+		free(login_token);
+	if (server_pubkey != NULL)
+		EVP_PKEY_free(server_pubkey);
+	SK_OPENSSL_term();
+
+	return rc;
+}
+
+/**
+ * Requests multiple keys to be retrieved from EKMFweb and imported under the
+ * current HSM's master key. The requests are sent to the server in parallel,
+ * while the session keys are generated, the requests are signed, and the keys
+ * are imported one after the other by the calling thread.
+ *
+ * To perform a single set of requests, set multi_handle to NULL. This will
+ * cause the function to initialize a new multi handle, use it, and destroy it.
+ * If you plan to perform multiple sets of requests to the same host, supply the
+ * address of a multi handle pointer that is initially NULL. This function will
+ * then initialize a new multi handle on the first call. On subsequent calls,
+ * pass in the address of the same pointer so that the multi handle, and thus
+ * its connections and TLS sessions, are reused. After the last request, the
+ * multi handle must be destroyed by calling ekmf_multi_destroy.
+ *
+ * @param config            the configuration structure
+ * @param multi_handle      address of a multi handle used for reusing the same
+ *                          connections with multiple calls.
+ * @param max_parallel      the maximum number of requests in flight at the
+ *                          same time. If 0, then a default of 8 is used.
+ * @param multiplex         if true, the requests are multiplexed over a single
+ *                          HTTP/2 connection, if the server supports HTTP/2.
+ * @param key_uuids         the UUIDs of the keys to retrieve
+ * @param num_keys          the number of keys to retrieve
+ * @param sess_ec_curve_nid The OpenSSL nid of the EC curve used for the session
+ *                          ECC keys. If 0, then the default curve is used.
+ * @param sign_rsa_digest_nid The OpenSSL nid of a digest used to sign the
+ *                          requests with if the identity key is an RSA-type
+ *                          key. If 0, then the default digest is used.
+ *                          Ignored for ECC-type identity keys.
+ * @param use_rsa_pss       If true, and the identity key is an RSA-type key,
+ *                          use RSA-PSS to sign the requests.
+ * @param signature_kid     the Key ID for the signature of the requests
+ * @param key_blobs         an array of num_keys buffers to store the retrieved
+ *                          key blobs to
+ * @param key_blob_lengths  an array of num_keys lengths.
+ *                          On entry: the sizes of the buffers
+ *                          On return: the sizes of the key blobs retrieved
+ * @param key_rcs           an array of num_keys return codes. On return, it
+ *                          contains zero or a negative errno for each key.
+ * @param error_msg         on return: If not NULL, then a textual error message
+ *                          of the first failing request is returned. The caller
+ *                          must free the error string when it is not NULL.
+ * @param ext_lib           External secure key crypto library to use
+ * @param verbose           if true, verbose messages are printed
+ *
+ * @returns zero if the keys were requested (check key_rcs for the result of
+ *          each key), or a negative errno in case of an error.
+ *          -EACCES is returned, if no or no valid login token is available.
+ */
+int ekmf_retrieve_keys(const struct ekmf_config *config,
+		       struct ekmf_multi_handle **multi_handle,
+		       unsigned int max_parallel, bool multiplex,
+		       const char **key_uuids, size_t num_keys,
+		       int sess_ec_curve_nid, int sign_rsa_digest_nid,
+		       bool use_rsa_pss, const char *signature_kid,
+		       unsigned char **key_blobs, size_t *key_blob_lengths,
+		       int *key_rcs, char **error_msg,
+		       const struct ekmf_ext_lib *ext_lib, bool verbose)
+{
+	unsigned char identity_key[MAX_KEY_BLOB_SIZE];
+	struct ekmf_parallel_request *reqs = NULL;
+	struct ekmf_retrieve_ctx *ctxs = NULL;
+	struct ekmf_multi_handle *mh = NULL;
+	EVP_PKEY *server_pubkey = NULL;
+	size_t identity_key_length;
+	char *login_token = NULL;
+	bool token_valid = false;
+	size_t *key_idx = NULL;
+	size_t i, k, num = 0;
+	int rc;
+
+	if (config == NULL || key_uuids == NULL || key_blobs == NULL ||
+	    key_blob_lengths == NULL || key_rcs == NULL || ext_lib == NULL)
+		return -EINVAL;
 
-	if (asprintf(&uri, EKMF_URI_KEYS_EXPORT, escaped_uuid) < 0) {
-		pr_verbose(verbose, "asprintf failed");
-		rc = -ENOMEM;
-		goto out;
-	}
+	if (error_msg != NULL)
+		*error_msg = NULL;
+	for (i = 0; i < num_keys; i++)
+		key_rcs[i] = 0;
 
-	rc = _ekmf_perform_request(config, uri, "POST", request_obj, NULL,
-				   login_token, &response_obj, NULL,
-				   &status_code, error_msg, curl, verbose);
+	rc = SK_OPENSSL_init(verbose);
 	if (rc != 0) {
-		pr_verbose(verbose, "Failed perform the REST call");
-		if (rc > 0)
-			rc = -EIO;
-		goto out;
+		pr_verbose(verbose, "Failed to initialize secure key support: "
+			   "%s", strerror(-rc));
+		return rc;
 	}
 
-	switch (status_code) {
-	case 200:
-		break;
-	case 400:
-		pr_verbose(verbose, "Bad request");
-		rc = -EBADMSG;
-		goto out;
-	case 401:
-		pr_verbose(verbose, "Not authorized");
+	rc = ekmf_check_login_token(config, &token_valid, &login_token,
+				    verbose);
+	if (rc != 0 || !token_valid) {
+		pr_verbose(verbose, "No valid login token available");
 		rc = -EACCES;
 		goto out;
-	case 403:
-		pr_verbose(verbose, "Insufficient permissions");
-		rc = -EPERM;
-		goto out;
-	case 404:
-		pr_verbose(verbose, "Not found");
-		rc = -ENOENT;
-		goto out;
-	default:
-		pr_verbose(verbose, "REST Call failed with HTTP status code: "
-			   "%ld", status_code);
-		rc = -EIO;
-		goto out;
 	}
 
-	JSON_CHECK_OBJ(response_obj, json_type_object, rc, -EBADMSG,
-		       "No or invalid response", verbose, out);
-
-	rc = _ekmf_verify_signature(response_obj, server_pubkey, verbose);
-	if (rc != 0)
+	rc = _ekmf_get_multi_handle(multi_handle, &mh, verbose);
+	if (rc != 0) {
+		pr_verbose(verbose, "Failed to get multi handle");
 		goto out;
+	}
 
-	json_object_object_get_ex(response_obj, "originator",
-				  &resp_originator_obj);
-	JSON_CHECK_OBJ(resp_originator_obj, json_type_object, rc, -EBADMSG,
-		       "Failed to get the response originator", verbose, out);
-
-	json_object_object_get_ex(resp_originator_obj, "session",
-				  &resp_sess_jwk_obj);
-	JSON_CHECK_OBJ(resp_sess_jwk_obj, json_type_object, rc, -EBADMSG,
-		       "Failed to get the response session key", verbose, out);
-
-	rc = json_object_get_base64url(resp_originator_obj, "partyInfo",
-				       NULL, &resp_party_info_length);
+	rc = read_public_key(config->ekmf_server_pubkey, &server_pubkey);
 	if (rc != 0) {
-		pr_verbose(verbose, "Failed to get the response partyInfo");
+		pr_verbose(verbose, "Failed to read EKMFWeb server's public key"
+			   " '%s': %s", config->ekmf_server_pubkey,
+			   strerror(-rc));
 		goto out;
 	}
 
-	resp_party_info = malloc(resp_party_info_length);
-	if (resp_party_info == NULL) {
-		rc = -ENOMEM;
+	identity_key_length = sizeof(identity_key);
+	rc = read_key_blob(config->identity_secure_key, identity_key,
+			   &identity_key_length);
+	if (rc != 0) {
+		pr_verbose(verbose, "Failed to read identity key from file "
+			   "'%s': %s", config->identity_secure_key,
+			   strerror(-rc));
 		goto out;
 	}
 
-	rc = json_object_get_base64url(resp_originator_obj, "partyInfo",
-				       resp_party_info,
-				       &resp_party_info_length);
-	if (rc != 0) {
-		pr_verbose(verbose, "Failed to get the response partyInfo");
+	ctxs = calloc(num_keys, sizeof(struct ekmf_retrieve_ctx));
+	reqs = calloc(num_keys, sizeof(struct ekmf_parallel_request));
+	key_idx = calloc(num_keys, sizeof(size_t));
+	if (num_keys > 0 && (ctxs == NULL || reqs == NULL || key_idx == NULL)) {
+		pr_verbose(verbose, "calloc failed");
+		rc = -ENOMEM;
 		goto out;
 	}
 
-	json_object_object_get_ex(response_obj, "additionalInfo",
-				  &resp_addl_info_obj);
-	JSON_CHECK_OBJ(resp_addl_info_obj, json_type_object, rc, -EBADMSG,
-		       "Failed to get the response addl.info", verbose, out);
+	for (i = 0; i < num_keys; i++) {
+		key_rcs[i] = _ekmf_build_retrieve_request(key_uuids[i],
+							  mh->curls[0],
+							  sess_ec_curve_nid,
+							  sign_rsa_digest_nid,
+							  use_rsa_pss,
+							  signature_kid,
+							  identity_key,
+							  identity_key_length,
+							  &ctxs[i], ext_lib,
+							  verbose);
+		if (key_rcs[i] != 0)
+			continue;
 
-	json_object_object_get_ex(resp_addl_info_obj, "exportedKey",
-				  &resp_exp_jwk_obj);
-	JSON_CHECK_OBJ(resp_exp_jwk_obj, json_type_object, rc, -EBADMSG,
-		       "Failed to get the response exported key", verbose, out);
+		key_idx[num] = i;
+		reqs[num].uri = ctxs[i].uri;
+		ctxs[i].uri = NULL;
+		reqs[num].request = "POST";
+		reqs[num].request_data = ctxs[i].request_obj;
+		num++;
+	}
 
-	rc = _ekmf_import_key(req_sess_ec_key, req_sess_ec_key_length,
-			      req_party_info, req_party_info_length,
-			      resp_party_info, resp_party_info_length,
-			      resp_sess_jwk_obj, resp_exp_jwk_obj,
-			      key_blob, key_blob_length, ext_lib, verbose);
-	if (rc != 0) {
-		pr_verbose(verbose, "Failed to import the retrieved key");
+	rc = _ekmf_perform_requests(config, mh, max_parallel, multiplex,
+				    login_token, reqs, num, verbose);
+	if (rc != 0)
 		goto out;
+
+	for (k = 0; k < num; k++) {
+		i = key_idx[k];
+		key_rcs[i] = reqs[k].rc;
+		if (key_rcs[i] == 0)
+			key_rcs[i] = _ekmf_process_retrieve_response(&ctxs[i],
+						reqs[k].response_obj,
+						reqs[k].status_code,
+						server_pubkey, key_blobs[i],
+						&key_blob_lengths[i], ext_lib,
+						verbose);
+		if (key_rcs[i] != 0) {
+			pr_verbose(verbose, "Failed to retrieve key '%s'",
+				   key_uuids[i]);
+			if (error_msg != NULL && *error_msg == NULL) {
+				*error_msg = reqs[k].error_msg;
+				reqs[k].error_msg = NULL;
+			}
+		}
 	}
 
 out:
-	_ekmf_release_curl_handle(curl_handle, curl);
+	_ekmf_release_multi_handle(multi_handle, mh);
 
-	if (req_sess_jwk_obj != NULL)
-		json_object_put(req_sess_jwk_obj);
-	if (req_timestamp_obj != NULL)
-		json_object_put(req_timestamp_obj);
-	if (req_addl_info_obj != NULL)
-		json_object_put(req_addl_info_obj);
-	if (req_party_info_obj != NULL)
-		json_object_put(req_party_info_obj);
-	if (req_originator_obj != NULL)
-		json_object_put(req_originator_obj);
-	if (req_signature_obj != NULL)
-		json_object_put(req_signature_obj);
-	if (request_obj != NULL)
-		json_object_put(request_obj);
-	if (response_obj != NULL)
-		json_object_put(response_obj);
-	if (uri != NULL)
-		free(uri);
+	_ekmf_free_parallel_requests(reqs, num);
+	if (ctxs != NULL) {
+		for (i = 0; i < num_keys; i++)
+			_ekmf_free_retrieve_ctx(&ctxs[i]);
+		free(ctxs);
+	}
+	if (key_idx != NULL)
+		free(key_idx);
 	if (login_token != NULL)
 		free(login_token);
 	if (server_pubkey != NULL)
 		EVP_PKEY_free(server_pubkey);
-	if (resp_party_info != NULL)
-		free(resp_party_info);
-	if (escaped_uuid != NULL)
-		curl_free(escaped_uuid);
 	SK_OPENSSL_term();
 
 	return rc;
@@ -3922,6 +4702,218 @@ out:
 	return rc;
 }
 
+/**
+ * Builds the URI of a key related request from a format containing the
+ * url-escaped key UUID.
+ */
+static char *_ekmf_build_key_uri(CURL *curl, const char *uri_fmt,
+				 const char *key_uuid, bool verbose)
+{
+	char *escaped_uuid;
+	char *uri = NULL;
+
+	escaped_uuid = curl_easy_escape(curl, key_uuid, 0);
+	if (escaped_uuid == NULL) {
+		pr_verbose(verbose, "Failed to url-escape the key uuid");
+		return NULL;
+	}
+
+	if (asprintf(&uri, uri_fmt, escaped_uuid) < 0) {
+		pr_verbose(verbose, "asprintf failed");
+		uri = NULL;
+	}
+
+	curl_free(escaped_uuid);
+	return uri;
+}
+
+/**
+ * Builds the key info of a key from the responses of the key, its custom tags,
+ * and its export control requests.
+ */
+static int _ekmf_process_key_info_responses(struct ekmf_parallel_request *reqs,
+					    struct ekmf_key_info **key,
+					    char **error_msg, bool verbose)
+{
+	int rc = 0, i;
+
+	/*
+	 * As for the serial requests, only a missing key is reported as
+	 * -ENOENT, but not missing custom tags or export control infos.
+	 */
+	for (i = 0; i < 3; i++) {
+		rc = reqs[i].rc;
+		if (rc == 0)
+			rc = _ekmf_check_status_code(reqs[i].status_code,
+						     i == 0, verbose);
+		if (rc != 0) {
+			if (error_msg != NULL && *error_msg == NULL) {
+				*error_msg = reqs[i].error_msg;
+				reqs[i].error_msg = NULL;
+			}
+			return rc;
+		}
+	}
+
+	JSON_CHECK_OBJ(reqs[0].response_obj, json_type_object, rc, -EBADMSG,
+		       "No or invalid response", verbose, out);
+	JSON_CHECK_OBJ(reqs[1].response_obj, json_type_array, rc, -EIO,
+		       "No or invalid response content", verbose, out);
+	JSON_CHECK_OBJ(reqs[2].response_obj, json_type_object, rc, -EIO,
+		       "No or invalid response content", verbose, out);
+
+	*key = calloc(1, sizeof(struct ekmf_key_info));
+	if (*key == NULL) {
+		pr_verbose(verbose, "calloc failed");
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	rc = json_build_key_info(reqs[0].response_obj, reqs[1].response_obj,
+				 reqs[2].response_obj, *key, true);
+	if (rc != 0) {
+		pr_verbose(verbose, "Failed to build key info");
+		free(*key);
+		*key = NULL;
+	}
+
+out:
+	return rc;
+}
+
+/**
+ * Gets information about multiple keys identified by their UUIDs. The requests
+ * for the keys, their custom tags, and their export control infos are
+ * performed in parallel.
+ *
+ * To perform a single set of requests, set multi_handle to NULL. This will
+ * cause the function to initialize a new multi handle, use it, and destroy it.
+ * If you plan to perform multiple sets of requests to the same host, supply the
+ * address of a multi handle pointer that is initially NULL. This function will
+ * then initialize a new multi handle on the first call. On subsequent calls,
+ * pass in the address of the same pointer so that the multi handle, and thus
+ * its connections and TLS sessions, are reused. After the last request, the
+ * multi handle must be destroyed by calling ekmf_multi_destroy.
+ *
+ * @param config            the configuration structure
+ * @param multi_handle      address of a multi handle used for reusing the same
+ *                          connections with multiple calls.
+ * @param max_parallel      the maximum number of requests in flight at the
+ *                          same time. If 0, then a default of 8 is used.
+ * @param multiplex         if true, the requests are multiplexed over a single
+ *                          HTTP/2 connection, if the server supports HTTP/2.
+ * @param key_uuids         the UUIDs of the keys to get info for
+ * @param num_keys          the number of keys to get info for
+ * @param keys              an array of num_keys key info pointers. On return,
+ *                          each pointer is updated to point to a newly
+ *                          allocated key info struct, or NULL if the info of
+ *                          the key could not be obtained. The key infos must be
+ *                          freed by the caller using ekmf_free_key_info when no
+ *                          longer needed.
+ * @param key_rcs           an array of num_keys return codes. On return, it
+ *                          contains zero or a negative errno for each key.
+ * @param error_msg         on return: If not NULL, then a textual error message
+ *                          of the first failing request is returned. The caller
+ *                          must free the error string when it is not NULL.
+ * @param verbose           if true, verbose messages are printed
+ *
+ * @returns zero if the key infos were requested (check key_rcs for the result
+ *          of each key), or a negative errno in case of an error.
+ *          -EACCES is returned, if no or no valid login token is available.
+ */
+int ekmf_get_key_infos(const struct ekmf_config *config,
+		       struct ekmf_multi_handle **multi_handle,
+		       unsigned int max_parallel, bool multiplex,
+		       const char **key_uuids, size_t num_keys,
+		       struct ekmf_key_info **keys, int *key_rcs,
+		       char **error_msg, bool verbose)
+{
+	struct ekmf_parallel_request *reqs = NULL;
+	struct ekmf_multi_handle *mh = NULL;
+	char *login_token = NULL;
+	bool token_valid = false;
+	size_t i;
+	int rc;
+
+	if (config == NULL || key_uuids == NULL || keys == NULL ||
+	    key_rcs == NULL)
+		return -EINVAL;
+
+	if (error_msg != NULL)
+		*error_msg = NULL;
+	for (i = 0; i < num_keys; i++) {
+		keys[i] = NULL;
+		key_rcs[i] = 0;
+	}
+
+	rc = ekmf_check_login_token(config, &token_valid, &login_token,
+				    verbose);
+	if (rc != 0 || !token_valid) {
+		pr_verbose(verbose, "No valid login token available");
+		rc = -EACCES;
+		goto out;
+	}
+
+	rc = _ekmf_get_multi_handle(multi_handle, &mh, verbose);
+	if (rc != 0) {
+		pr_verbose(verbose, "Failed to get multi handle");
+		goto out;
+	}
+
+	/* Per key: the key itself, its custom tags, and its export control */
+	reqs = calloc(3 * num_keys, sizeof(struct ekmf_parallel_request));
+	if (num_keys > 0 && reqs == NULL) {
+		pr_verbose(verbose, "calloc failed");
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < num_keys; i++) {
+		reqs[3 * i].uri = _ekmf_build_key_uri(mh->curls[0],
+						      EKMF_URI_KEYS_GET,
+						      key_uuids[i], verbose);
+		reqs[3 * i + 1].uri = _ekmf_build_key_uri(mh->curls[0],
+						EKMF_URI_KEYS_TAGS,
+						key_uuids[i], verbose);
+		reqs[3 * i + 2].uri = _ekmf_build_key_uri(mh->curls[0],
+						EKMF_URI_KEYS_EXPORT_CONTROL,
+						key_uuids[i], verbose);
+		if (reqs[3 * i].uri == NULL || reqs[3 * i + 1].uri == NULL ||
+		    reqs[3 * i + 2].uri == NULL) {
+			rc = -ENOMEM;
+			goto out;
+		}
+
+		reqs[3 * i].request = "GET";
+		reqs[3 * i + 1].request = "GET";
+		reqs[3 * i + 2].request = "GET";
+	}
+
+	rc = _ekmf_perform_requests(config, mh, max_parallel, multiplex,
+				    login_token, reqs, 3 * num_keys, verbose);
+	if (rc != 0)
+		goto out;
+
+	for (i = 0; i < num_keys; i++) {
+		key_rcs[i] = _ekmf_process_key_info_responses(&reqs[3 * i],
+							      &keys[i],
+							      error_msg,
+							      verbose);
+		if (key_rcs[i] != 0)
+			pr_verbose(verbose, "Failed to get key '%s'",
+				   key_uuids[i]);
+	}
+
+out:
+	_ekmf_release_multi_handle(multi_handle, mh);
+
+	_ekmf_free_parallel_requests(reqs, 3 * num_keys);
+	if (login_token != NULL)
+		free(login_token);
+
+	return rc;
+}
+
 /**
  * Changes the state of a key identified by its UUID. To update a key,
  * the timestamp from the last update is required. This can be found in
@@ -5293,6 +6285,29 @@ void ekmf_curl_destroy(CURL *curl_handle)
 	curl_easy_cleanup(curl_handle);
 }
 
+/**
+ * Close the connections to the EKMFWeb server by destroying the multi handle.
+ *
+ * @param multi_handle      the multi handle to destroy
+ */
+void ekmf_multi_destroy(struct ekmf_multi_handle *multi_handle)
+{
+	unsigned int i;
+
+	if (multi_handle == NULL)
+		return;
+
+	for (i = 0; i < multi_handle->num_curls; i++)
+		curl_easy_cleanup(multi_handle->curls[i]);
+	if (multi_handle->curls != NULL)
+		free(multi_handle->curls);
+	if (multi_handle->multi != NULL)
+		curl_multi_cleanup(multi_handle->multi);
+	if (multi_handle->share != NULL)
+		curl_share_cleanup(multi_handle->share);
+	free(multi_handle);
+}
+
 /**
  * Library constructor
  */
@@ -0,0 +1,268 @@
+/*
+ * libkmipclient - KMIP client library
+ *
+ * Arena (region) allocator for KMIP nodes
+ *
+ * Nodes created while an arena is in use are allocated together with their
+ * names and values from a list of chunks with a bump pointer. The chunks are
+ * released in one step when the last node allocated from the arena is freed,
+ * and the arena itself was freed.
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "lib/zt_common.h"
+
+#include "kmip.h"
+
+#define KMIP_ARENA_ALIGN		16
+#define KMIP_ARENA_ALIGNED(len)						\
+		(((len) + KMIP_ARENA_ALIGN - 1) &			\
+					~(size_t)(KMIP_ARENA_ALIGN - 1))
+
+struct kmip_arena_chunk {
+	struct kmip_arena_chunk *next;
+	size_t size;
+	size_t used;
+	unsigned char data[] __attribute__ ((aligned(KMIP_ARENA_ALIGN)));
+};
+
+struct kmip_arena {
+	volatile unsigned long ref_count;
+	size_t chunk_size;
+	struct kmip_arena_chunk *chunks;
+};
+
+/* The arena used for new nodes by the current thread */
+static __thread struct kmip_arena *current_arena;
+
+/**
+ * Allocates a new chunk of at least the specified size and makes it the
+ * current chunk of the arena.
+ *
+ * @param arena             the arena
+ * @param size              the minimum size of the chunk
+ *
+ * @returns the allocated chunk, or NULL in case of an error
+ */
+static struct kmip_arena_chunk *kmip_arena_add_chunk(struct kmip_arena *arena,
+						     size_t size)
+{
+	struct kmip_arena_chunk *chunk;
+
+	size = MAX(size, arena->chunk_size);
+	chunk = malloc(sizeof(struct kmip_arena_chunk) + size);
+	if (chunk == NULL)
+		return NULL;
+
+	chunk->size = size;
+	chunk->used = 0;
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+
+	/* Grow the chunks with the number of allocations in the arena */
+	if (arena->chunk_size < KMIP_ARENA_MAX_CHUNK_SIZE)
+		arena->chunk_size = MIN(arena->chunk_size * 2,
+					(size_t)KMIP_ARENA_MAX_CHUNK_SIZE);
+
+	return chunk;
+}
+
+/**
+ * Creates a new arena for allocating KMIP nodes. The newly allocated arena has
+ * a reference count of 1. Nodes are only allocated from the arena while it is
+ * in use via kmip_arena_use().
+ *
+ * @param chunk_size        the size of the first chunk of memory. Subsequent
+ *                          chunks grow in size. If 0, a default is used.
+ *
+ * @returns the allocated arena, or NULL in case of an error
+ */
+struct kmip_arena *kmip_arena_new(size_t chunk_size)
+{
+	struct kmip_arena *arena;
+
+	if (chunk_size == 0)
+		chunk_size = KMIP_ARENA_DEFAULT_CHUNK_SIZE;
+
+	arena = calloc(1, sizeof(struct kmip_arena));
+	if (arena == NULL)
+		return NULL;
+
+	arena->ref_count = 1;
+	arena->chunk_size = KMIP_ARENA_ALIGNED(chunk_size);
+
+	if (kmip_arena_add_chunk(arena, 0) == NULL) {
+		free(arena);
+		return NULL;
+	}
+
+	return arena;
+}
+
+/**
+ * Increments the reference count of an arena
+ *
+ * @param arena             the arena
+ */
+void kmip_arena_upref(struct kmip_arena *arena)
+{
+	if (arena == NULL)
+		return;
+
+	__sync_add_and_fetch((unsigned long *)&arena->ref_count, 1);
+}
+
+/**
+ * Frees an arena. Each node allocated from the arena holds a reference to it,
+ * so the memory of the arena is released together with the last of its nodes.
+ * An arena must no longer be in use by kmip_arena_use() when it is freed.
+ *
+ * @param arena             the arena to free
+ */
+void kmip_arena_free(struct kmip_arena *arena)
+{
+	struct kmip_arena_chunk *chunk, *next;
+
+	if (arena == NULL)
+		return;
+
+	if (__sync_sub_and_fetch((unsigned long *)&arena->ref_count, 1) > 0)
+		return;
+
+	for (chunk = arena->chunks; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+	free(arena);
+}
+
+/**
+ * Sets the arena that KMIP nodes created by the calling thread are allocated
+ * from. This affects all nodes created by the library functions, e.g. when
+ * building a request. Nodes decoded from a TTLV encoded response are always
+ * allocated from an arena of their own.
+ *
+ * An arena must not be in use by more than one thread at the same time. The
+ * nodes allocated from the arena can be freed by any thread.
+ *
+ * @param arena             the arena to use, or NULL to allocate new nodes
+ *                          individually from the heap
+ *
+ * @returns the arena that was in use before
+ */
+struct kmip_arena *kmip_arena_use(struct kmip_arena *arena)
+{
+	struct kmip_arena *prev = current_arena;
+
+	current_arena = arena;
+	return prev;
+}
+
+/**
+ * Returns the arena used for new nodes by the calling thread
+ *
+ * @returns the arena, or NULL if no arena is in use
+ */
+struct kmip_arena *kmip_arena_current(void)
+{
+	return current_arena;
+}
+
+/**
+ * Allocates memory from an arena. The memory is not initialized.
+ *
+ * @param arena             the arena
+ * @param size              the size to allocate
+ *
+ * @returns the allocated memory, or NULL in case of an error
+ */
+static void *kmip_arena_alloc_raw(struct kmip_arena *arena, size_t size)
+{
+	struct kmip_arena_chunk *chunk = arena->chunks;
+	void *ptr;
+
+	size = KMIP_ARENA_ALIGNED(size);
+	if (chunk->size - chunk->used < size) {
+		chunk = kmip_arena_add_chunk(arena, size);
+		if (chunk == NULL)
+			return NULL;
+	}
+
+	ptr = chunk->data + chunk->used;
+	chunk->used += size;
+	return ptr;
+}
+
+/**
+ * Allocates zeroed memory from an arena, or from the heap if no arena is
+ * specified.
+ *
+ * @param arena             the arena, or NULL
+ * @param size              the size to allocate
+ *
+ * @returns the allocated memory, or NULL in case of an error
+ */
+void *kmip_arena_zalloc(struct kmip_arena *arena, size_t size)
+{
+	void *ptr;
+
+	if (arena == NULL)
+		return calloc(1, size);
+
+	ptr = kmip_arena_alloc_raw(arena, size);
+	if (ptr != NULL)
+		memset(ptr, 0, size);
+	return ptr;
+}
+
+/**
+ * Copies data into memory allocated from an arena, or from the heap if no
+ * arena is specified. If terminate is true, a NUL character is appended.
+ *
+ * @param arena             the arena, or NULL
+ * @param data              the data to copy
+ * @param size              the size of the data
+ * @param terminate         if true, the copy is NUL terminated
+ *
+ * @returns the allocated copy, or NULL in case of an error
+ */
+void *kmip_arena_memdup(struct kmip_arena *arena, const void *data,
+			size_t size, bool terminate)
+{
+	size_t alloc_size = size + (terminate ? 1 : 0);
+	unsigned char *ptr;
+
+	if (arena == NULL)
+		ptr = malloc(alloc_size);
+	else
+		ptr = kmip_arena_alloc_raw(arena, alloc_size);
+	if (ptr == NULL)
+		return NULL;
+
+	memcpy(ptr, data, size);
+	if (terminate)
+		ptr[size] = 0;
+	return ptr;
+}
+
+/**
+ * Duplicates a string into memory allocated from an arena, or from the heap
+ * if no arena is specified.
+ *
+ * @param arena             the arena, or NULL
+ * @param str               the string to duplicate
+ *
+ * @returns the allocated copy, or NULL in case of an error
+ */
+char *kmip_arena_strdup(struct kmip_arena *arena, const char *str)
+{
+	return kmip_arena_memdup(arena, str, strlen(str), true);
+}
@@ -0,0 +1,739 @@
+/*
+ * libkmipclient - KMIP client library
+ *
+ * Asynchronous requests over pooled connections
+ *
+ * Requests are submitted to an asynchronous context, and their callbacks are
+ * called when the responses have been received. With Plain-TLS transport,
+ * several requests are pipelined on one connection: the server processes the
+ * requests of a connection in order, so the responses are received in the
+ * order of the requests. With HTTPS transport, each request uses a connection
+ * of its own, and all transfers are performed by a curl multi handle, which
+ * multiplexes them over HTTP/2 connections where possible. In both cases,
+ * further connections are checked out from the connection pool while
+ * requests are waiting to be sent.
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kmip.h"
+#include "utils.h"
+
+#define KMIP_ASYNC_WAIT_INTERVAL	1000
+
+struct kmip_async_request {
+	struct kmip_node *request;
+	kmip_async_cb_t callback;
+	void *private;
+	struct kmip_async_conn *aconn;
+	struct kmip_https_xfer *xfer;
+	struct kmip_async_request *next;
+};
+
+struct kmip_async_conn {
+	struct kmip_connection *conn;
+	/* Requests sent, but not completed, in the order they were sent */
+	struct kmip_async_request *head;
+	struct kmip_async_request *tail;
+	unsigned int in_flight;
+	bool failed;
+	struct kmip_async_conn *next;
+};
+
+struct kmip_async {
+	struct kmip_connection_pool *pool;
+	unsigned int pipeline_depth;
+	/* Requests submitted, but not yet sent */
+	struct kmip_async_request *pending;
+	struct kmip_async_request *pending_tail;
+	struct kmip_async_conn *conns;
+	unsigned int num_pending;
+	unsigned int num_in_flight;
+	CURLM *multi;
+};
+
+/**
+ * Completes a request: The callback is called, and the request is freed
+ *
+ * @param req               the request to complete
+ * @param response          the response, or NULL in case of an error
+ * @param rc                0 in case of success, or a negative errno value
+ * @param debug             if true, debug messages are printed
+ */
+static void kmip_async_complete(struct kmip_async_request *req,
+				struct kmip_node *response, int rc, bool debug)
+{
+	if (rc == 0 && response != NULL) {
+		kmip_debug(debug, "KMIP Response:");
+		kmip_node_dump(response, debug);
+	} else {
+		kmip_debug(debug, "Asynchronous request failed: %s",
+			   strerror(-rc));
+	}
+
+	if (req->callback != NULL)
+		req->callback(req->request, response, rc, req->private);
+
+	kmip_node_free(response);
+	kmip_node_free(req->request);
+	free(req);
+}
+
+/**
+ * Marks a connection as failed, and fails all requests in flight on it. With
+ * Plain-TLS transport, the responses to the following requests can no longer
+ * be associated with their requests.
+ *
+ * @param async             the asynchronous context
+ * @param aconn             the connection
+ * @param rc                the negative errno value to fail the requests with
+ * @param debug             if true, debug messages are printed
+ */
+static void kmip_async_fail_conn(struct kmip_async *async,
+				 struct kmip_async_conn *aconn, int rc,
+				 bool debug)
+{
+	struct kmip_async_request *req;
+	struct kmip_node *response;
+
+	aconn->failed = true;
+
+	while (aconn->head != NULL) {
+		req = aconn->head;
+		aconn->head = req->next;
+		aconn->in_flight--;
+		async->num_in_flight--;
+
+		if (req->xfer != NULL) {
+			curl_multi_remove_handle(async->multi,
+						 aconn->conn->https.curl);
+			kmip_connection_https_complete(aconn->conn, req->xfer,
+						       CURLE_ABORTED_BY_CALLBACK,
+						       &response, debug);
+			req->xfer = NULL;
+		}
+
+		kmip_async_complete(req, NULL, rc, debug);
+	}
+	aconn->tail = NULL;
+}
+
+/**
+ * Returns connections that are no longer needed to the pool. Failed
+ * connections are discarded.
+ *
+ * @param async             the asynchronous context
+ * @param all               if true, all idle connections are returned, else
+ *                          idle connections are kept while requests are
+ *                          waiting to be sent
+ * @param debug             if true, debug messages are printed
+ */
+static void kmip_async_release_conns(struct kmip_async *async, bool all,
+				     bool debug)
+{
+	struct kmip_async_conn **prev = &async->conns, *aconn;
+
+	while (*prev != NULL) {
+		aconn = *prev;
+		if (aconn->in_flight > 0 ||
+		    (!aconn->failed && !all && async->pending != NULL)) {
+			prev = &aconn->next;
+			continue;
+		}
+
+		*prev = aconn->next;
+		kmip_connection_pool_put(async->pool, aconn->conn,
+					 aconn->failed, debug);
+		free(aconn);
+	}
+}
+
+/**
+ * Adds a connection checked out from the pool to the asynchronous context
+ *
+ * @param async             the asynchronous context
+ * @param conn              the connection
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns the added connection, or NULL in case of an error
+ */
+static struct kmip_async_conn *kmip_async_add_conn(struct kmip_async *async,
+						   struct kmip_connection *conn,
+						   bool debug)
+{
+	struct kmip_async_conn *aconn;
+
+	if (conn->config.transport == KMIP_TRANSPORT_HTTPS &&
+	    async->multi == NULL) {
+		async->multi = curl_multi_init();
+		if (async->multi == NULL) {
+			kmip_debug(debug, "curl_multi_init failed");
+			goto error;
+		}
+		/* Multiplex the transfers over HTTP/2 connections */
+		curl_multi_setopt(async->multi, CURLMOPT_PIPELINING,
+				  CURLPIPE_MULTIPLEX);
+	}
+
+	aconn = calloc(1, sizeof(struct kmip_async_conn));
+	if (aconn == NULL) {
+		kmip_debug(debug, "calloc failed");
+		goto error;
+	}
+
+	aconn->conn = conn;
+	aconn->next = async->conns;
+	async->conns = aconn;
+	return aconn;
+
+error:
+	kmip_connection_pool_put(async->pool, conn, false, debug);
+	return NULL;
+}
+
+/**
+ * Selects the connection to send the next request on. An idle connection is
+ * preferred, then a new connection from the pool, and then the connection
+ * with the least requests in flight, if it can take another request.
+ *
+ * @param async             the asynchronous context
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns the connection, or NULL if no connection is available
+ */
+static struct kmip_async_conn *kmip_async_select_conn(struct kmip_async *async,
+						      bool debug)
+{
+	struct kmip_async_conn *aconn, *best = NULL;
+	struct kmip_connection *conn;
+	unsigned int depth;
+
+	for (aconn = async->conns; aconn != NULL; aconn = aconn->next) {
+		if (aconn->failed)
+			continue;
+		if (best == NULL || aconn->in_flight < best->in_flight)
+			best = aconn;
+	}
+	if (best != NULL && best->in_flight == 0)
+		return best;
+
+	if (kmip_connection_pool_try_get(async->pool, &conn, debug) == 0)
+		return kmip_async_add_conn(async, conn, debug);
+
+	if (best == NULL)
+		return NULL;
+
+	/* Requests can only be pipelined with Plain-TLS transport */
+	depth = best->conn->config.transport == KMIP_TRANSPORT_PLAIN_TLS ?
+						async->pipeline_depth : 1;
+	if (best->in_flight >= depth)
+		return NULL;
+
+	return best;
+}
+
+/**
+ * Sends a request on a connection
+ *
+ * @param async             the asynchronous context
+ * @param aconn             the connection
+ * @param req               the request
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+static int kmip_async_send(struct kmip_async *async,
+			   struct kmip_async_conn *aconn,
+			   struct kmip_async_request *req, bool debug)
+{
+	struct kmip_node *response;
+	CURLMcode mrc;
+	int rc;
+
+	kmip_debug(debug, "KMIP Request:");
+	kmip_node_dump(req->request, debug);
+
+	switch (aconn->conn->config.transport) {
+	case KMIP_TRANSPORT_PLAIN_TLS:
+		rc = kmip_connection_tls_send(aconn->conn, req->request, debug);
+		if (rc != 0)
+			return rc;
+		break;
+
+	case KMIP_TRANSPORT_HTTPS:
+		rc = kmip_connection_https_prepare(aconn->conn, req->request,
+						   &req->xfer, debug);
+		if (rc != 0)
+			return rc;
+
+		curl_easy_setopt(aconn->conn->https.curl, CURLOPT_PRIVATE,
+				 req);
+		mrc = curl_multi_add_handle(async->multi,
+					    aconn->conn->https.curl);
+		if (mrc != CURLM_OK) {
+			kmip_debug(debug, "curl_multi_add_handle failed: %s",
+				   curl_multi_strerror(mrc));
+			kmip_connection_https_complete(aconn->conn, req->xfer,
+						       CURLE_ABORTED_BY_CALLBACK,
+						       &response, debug);
+			req->xfer = NULL;
+			return -EIO;
+		}
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	req->aconn = aconn;
+	req->next = NULL;
+	if (aconn->tail == NULL)
+		aconn->head = req;
+	else
+		aconn->tail->next = req;
+	aconn->tail = req;
+	aconn->in_flight++;
+	async->num_in_flight++;
+
+	return 0;
+}
+
+/**
+ * Sends waiting requests as long as connections are available
+ *
+ * @param async             the asynchronous context
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns the number of requests that failed to be sent
+ */
+static int kmip_async_dispatch(struct kmip_async *async, bool debug)
+{
+	struct kmip_async_conn *aconn;
+	struct kmip_async_request *req;
+	int rc, failed = 0;
+
+	while (async->pending != NULL) {
+		aconn = kmip_async_select_conn(async, debug);
+		if (aconn == NULL)
+			break;
+
+		req = async->pending;
+		async->pending = req->next;
+		if (async->pending == NULL)
+			async->pending_tail = NULL;
+		async->num_pending--;
+
+		rc = kmip_async_send(async, aconn, req, debug);
+		if (rc != 0) {
+			kmip_debug(debug, "kmip_async_send failed");
+			kmip_async_fail_conn(async, aconn, rc, debug);
+			kmip_async_complete(req, NULL, rc, debug);
+			failed++;
+		}
+	}
+
+	return failed;
+}
+
+/**
+ * Receives the responses on a Plain-TLS connection that are available
+ *
+ * @param async             the asynchronous context
+ * @param aconn             the connection
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns the number of completed requests
+ */
+static int kmip_async_receive_tls(struct kmip_async *async,
+				  struct kmip_async_conn *aconn, bool debug)
+{
+	struct kmip_async_request *req;
+	struct kmip_node *response;
+	int rc, completed = 0;
+
+	do {
+		rc = kmip_connection_tls_receive(aconn->conn, &response,
+						 debug);
+		if (rc != 0) {
+			kmip_debug(debug, "kmip_connection_tls_receive failed");
+			completed += aconn->in_flight;
+			kmip_async_fail_conn(async, aconn, rc, debug);
+			break;
+		}
+
+		req = aconn->head;
+		aconn->head = req->next;
+		if (aconn->head == NULL)
+			aconn->tail = NULL;
+		aconn->in_flight--;
+		async->num_in_flight--;
+
+		kmip_async_complete(req, response, 0, debug);
+		completed++;
+	} while (aconn->in_flight > 0 &&
+		 kmip_connection_tls_has_pending(aconn->conn));
+
+	return completed;
+}
+
+/**
+ * Processes the finished HTTPS transfers
+ *
+ * @param async             the asynchronous context
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns the number of completed requests
+ */
+static int kmip_async_receive_https(struct kmip_async *async, bool debug)
+{
+	struct kmip_async_request *req;
+	struct kmip_async_conn *aconn;
+	struct kmip_node *response;
+	int msgs, rc, completed = 0;
+	CURLMsg *msg;
+
+	while ((msg = curl_multi_info_read(async->multi, &msgs)) != NULL) {
+		if (msg->msg != CURLMSG_DONE)
+			continue;
+
+		req = NULL;
+		curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &req);
+		if (req == NULL)
+			continue;
+
+		aconn = req->aconn;
+		curl_multi_remove_handle(async->multi, msg->easy_handle);
+		rc = kmip_connection_https_complete(aconn->conn, req->xfer,
+						    msg->data.result, &response,
+						    debug);
+		req->xfer = NULL;
+
+		/* Only one request is in flight on a HTTPS connection */
+		aconn->head = NULL;
+		aconn->tail = NULL;
+		aconn->in_flight--;
+		async->num_in_flight--;
+
+		kmip_async_complete(req, rc == 0 ? response : NULL, rc,
+				    debug);
+		completed++;
+	}
+
+	return completed;
+}
+
+/**
+ * Constructs a new context for asynchronous requests. The connections for the
+ * requests are checked out from the specified pool, which must not be freed
+ * before the context.
+ *
+ * @param pool              the connection pool
+ * @param pipeline_depth    the maximum number of requests in flight on one
+ *                          Plain-TLS connection. Not all servers process
+ *                          pipelined requests, use 1 to send the next request
+ *                          on a connection only after the response to the
+ *                          previous one has been received. With HTTPS
+ *                          transport, there is one request in flight per
+ *                          connection.
+ * @param async             On return: the asynchronous context
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_async_new(struct kmip_connection_pool *pool,
+		   unsigned int pipeline_depth, struct kmip_async **async,
+		   bool debug)
+{
+	struct kmip_async *a;
+
+	if (pool == NULL || async == NULL || pipeline_depth == 0)
+		return -EINVAL;
+
+	a = calloc(1, sizeof(struct kmip_async));
+	if (a == NULL) {
+		kmip_debug(debug, "calloc failed");
+		return -ENOMEM;
+	}
+
+	a->pool = pool;
+	a->pipeline_depth = pipeline_depth;
+
+	*async = a;
+	return 0;
+}
+
+/**
+ * Submits a request. The request is sent as soon as a connection is
+ * available. The callback is called from kmip_async_poll(),
+ * kmip_async_wait() or kmip_async_free() when the request has completed, or
+ * from this function, if sending the request fails. Callbacks may submit
+ * further requests.
+ *
+ * @param async             the asynchronous context
+ * @param request           the request to send. Its reference count is
+ *                          increased until the request has completed.
+ * @param callback          the callback to call when the request completed.
+ * @param private           a pointer that is passed as-is to the callback
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value. If sending the
+ * request fails, the callback has been called, and 0 is returned.
+ */
+int kmip_async_submit(struct kmip_async *async, struct kmip_node *request,
+		      kmip_async_cb_t callback, void *private, bool debug)
+{
+	struct kmip_async_request *req;
+
+	if (async == NULL || request == NULL)
+		return -EINVAL;
+
+	req = calloc(1, sizeof(struct kmip_async_request));
+	if (req == NULL) {
+		kmip_debug(debug, "calloc failed");
+		return -ENOMEM;
+	}
+
+	kmip_node_upref(request);
+	req->request = request;
+	req->callback = callback;
+	req->private = private;
+
+	if (async->pending_tail == NULL)
+		async->pending = req;
+	else
+		async->pending_tail->next = req;
+	async->pending_tail = req;
+	async->num_pending++;
+
+	kmip_async_dispatch(async, debug);
+	return 0;
+}
+
+/**
+ * Returns the number of requests that have been submitted, but not completed
+ *
+ * @param async             the asynchronous context
+ *
+ * @returns the number of outstanding requests
+ */
+unsigned int kmip_async_outstanding(struct kmip_async *async)
+{
+	if (async == NULL)
+		return 0;
+
+	return async->num_pending + async->num_in_flight;
+}
+
+/**
+ * Waits for responses, and completes the requests for which the response has
+ * been received. Waiting requests are sent when connections become available.
+ *
+ * @param async             the asynchronous context
+ * @param timeout           the maximum time to wait in milliseconds, or -1 to
+ *                          wait until at least one request has completed
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns the number of completed requests, or a negative errno value
+ */
+int kmip_async_poll(struct kmip_async *async, int timeout, bool debug)
+{
+	struct kmip_async_conn *aconn, **tls_conns = NULL;
+	struct curl_waitfd *fds = NULL;
+	unsigned int i, num_fds = 0;
+	int rc, running, completed, done;
+	struct pollfd *pfds = NULL;
+	bool https = false;
+	CURLMcode mrc;
+
+	if (async == NULL)
+		return -EINVAL;
+
+	completed = kmip_async_dispatch(async, debug);
+
+	if (async->num_in_flight == 0 && async->pending != NULL) {
+		/* All connections of the pool are in use by others */
+		struct kmip_connection *conn;
+
+		rc = kmip_connection_pool_get(async->pool, &conn, debug);
+		if (rc != 0) {
+			kmip_debug(debug, "kmip_connection_pool_get failed");
+			goto out;
+		}
+		if (kmip_async_add_conn(async, conn, debug) == NULL) {
+			rc = -ENOMEM;
+			goto out;
+		}
+		completed += kmip_async_dispatch(async, debug);
+	}
+
+	if (async->num_in_flight == 0) {
+		rc = completed;
+		goto out;
+	}
+
+	for (aconn = async->conns; aconn != NULL; aconn = aconn->next) {
+		if (aconn->failed || aconn->in_flight == 0)
+			continue;
+		if (aconn->conn->config.transport == KMIP_TRANSPORT_HTTPS) {
+			https = true;
+			continue;
+		}
+		num_fds++;
+	}
+
+	if (num_fds > 0) {
+		tls_conns = calloc(num_fds, sizeof(struct kmip_async_conn *));
+		fds = calloc(num_fds, sizeof(struct curl_waitfd));
+		pfds = calloc(num_fds, sizeof(struct pollfd));
+		if (tls_conns == NULL || fds == NULL || pfds == NULL) {
+			kmip_debug(debug, "calloc failed");
+			rc = -ENOMEM;
+			goto out;
+		}
+
+		i = 0;
+		for (aconn = async->conns; aconn != NULL; aconn = aconn->next) {
+			if (aconn->failed || aconn->in_flight == 0 ||
+			    aconn->conn->config.transport !=
+						KMIP_TRANSPORT_PLAIN_TLS)
+				continue;
+			tls_conns[i] = aconn;
+			fds[i].fd = kmip_connection_tls_get_fd(aconn->conn);
+			fds[i].events = CURL_WAIT_POLLIN;
+			pfds[i].fd = fds[i].fd;
+			pfds[i].events = POLLIN;
+			/* Buffered data is not indicated by the socket */
+			if (kmip_connection_tls_has_pending(aconn->conn))
+				timeout = 0;
+			i++;
+		}
+	}
+
+	if (https) {
+		/* curl_multi_wait() does not support waiting without limit */
+		do {
+			mrc = curl_multi_perform(async->multi, &running);
+			if (mrc == CURLM_OK)
+				mrc = curl_multi_wait(async->multi, fds, num_fds,
+						      timeout < 0 ?
+						      KMIP_ASYNC_WAIT_INTERVAL :
+						      timeout, NULL);
+			if (mrc == CURLM_OK)
+				mrc = curl_multi_perform(async->multi,
+							 &running);
+			if (mrc != CURLM_OK) {
+				kmip_debug(debug, "curl_multi_perform failed: "
+					   "%s", curl_multi_strerror(mrc));
+				rc = -EIO;
+				goto out;
+			}
+			done = kmip_async_receive_https(async, debug);
+			completed += done;
+
+			for (i = 0; i < num_fds; i++) {
+				pfds[i].revents = fds[i].revents &
+						CURL_WAIT_POLLIN ? POLLIN : 0;
+				if (pfds[i].revents != 0)
+					done++;
+			}
+		} while (timeout < 0 && done == 0);
+	} else if (num_fds > 0) {
+		rc = poll(pfds, num_fds, timeout);
+		if (rc < 0 && errno != EINTR) {
+			rc = -errno;
+			kmip_debug(debug, "poll failed: %s", strerror(-rc));
+			goto out;
+		}
+	}
+
+	for (i = 0; i < num_fds; i++) {
+		aconn = tls_conns[i];
+		if (aconn->failed || aconn->in_flight == 0)
+			continue;
+		if (pfds[i].revents == 0 &&
+		    !kmip_connection_tls_has_pending(aconn->conn))
+			continue;
+
+		completed += kmip_async_receive_tls(async, aconn, debug);
+	}
+
+	completed += kmip_async_dispatch(async, debug);
+	rc = completed;
+
+out:
+	kmip_async_release_conns(async, false, debug);
+
+	free(tls_conns);
+	free(fds);
+	free(pfds);
+
+	return rc;
+}
+
+/**
+ * Waits until all submitted requests have completed
+ *
+ * @param async             the asynchronous context
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_async_wait(struct kmip_async *async, bool debug)
+{
+	int rc;
+
+	if (async == NULL)
+		return -EINVAL;
+
+	while (kmip_async_outstanding(async) > 0) {
+		rc = kmip_async_poll(async, -1, debug);
+		if (rc < 0)
+			return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Frees an asynchronous context. Requests that have not completed are
+ * cancelled, their callbacks are called with -ECANCELED. The connections are
+ * returned to the pool.
+ *
+ * @param async             the asynchronous context
+ * @param debug             if true, debug messages are printed
+ */
+void kmip_async_free(struct kmip_async *async, bool debug)
+{
+	struct kmip_async_request *req;
+	struct kmip_async_conn *aconn;
+
+	if (async == NULL)
+		return;
+
+	while (async->pending != NULL) {
+		req = async->pending;
+		async->pending = req->next;
+		async->num_pending--;
+		kmip_async_complete(req, NULL, -ECANCELED, debug);
+	}
+	async->pending_tail = NULL;
+
+	for (aconn = async->conns; aconn != NULL; aconn = aconn->next) {
+		if (aconn->in_flight > 0)
+			kmip_async_fail_conn(async, aconn, -ECANCELED, debug);
+	}
+
+	kmip_async_release_conns(async, true, debug);
+
+	if (async->multi != NULL)
+		curl_multi_cleanup(async->multi);
+	free(async);
+}
@@ -1046,7 +1046,7 @@ int kmip_get_attribute_reference(const struct kmip_node *node,
 			*attr_tag = kmip_node_get_enumeration(node);
 
 		if (vendor_id != NULL)
-			vendor_id = NULL;
+			*vendor_id = NULL;
 		if (name != NULL)
 			*name = NULL;
 
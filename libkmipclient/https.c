@@ -60,6 +60,19 @@ struct curl_header_cb_data {
 	bool debug;
 };
 
+struct kmip_https_xfer {
+	struct curl_sslctx_cb_data sslctx_cb;
+	struct curl_header_cb_data header_cb;
+	struct curl_write_cb_data write_cb;
+	char error_str[CURL_ERROR_SIZE];
+	json_object *req_json_obj;
+	xmlNode *req_xml_obj;
+	xmlDoc *req_xml_doc;
+	BIO *req_mem_bio;
+	char *req_buff;
+	int req_buff_size;
+};
+
 /**
  * Initializes a new HTTPS connection to a KMIP server.
  *
@@ -492,67 +505,118 @@ out:
 
 
 /**
- * Perform a request over the KMIP connection
+ * Frees the state of a transfer over a HTTPS KMIP connection, and resets the
+ * curl handle of the connection for the next transfer.
  *
  * @param conn              the KMIP connection
- * @param request           the request to send
- * @param response          On return: the received response. Must be freed by
- *                          the caller.
+ * @param xfer              the transfer state
+ */
+static void kmip_connection_https_xfer_free(struct kmip_connection *conn,
+					    struct kmip_https_xfer *xfer)
+{
+	/* Cleanup */
+	switch (conn->config.encoding) {
+	case KMIP_ENCODING_TTLV:
+		if (xfer->req_mem_bio != NULL)
+			BIO_free(xfer->req_mem_bio);
+		if (xfer->write_cb.ttlv.resp_mem_bio != NULL)
+			BIO_free(xfer->write_cb.ttlv.resp_mem_bio);
+
+		break;
+	case KMIP_ENCODING_JSON:
+		if (xfer->write_cb.json.tok != NULL)
+			json_tokener_free(xfer->write_cb.json.tok);
+		if (xfer->write_cb.json.resp_obj != NULL)
+			json_object_put(xfer->write_cb.json.resp_obj);
+		if (xfer->req_json_obj != NULL)
+			json_object_put(xfer->req_json_obj);
+		break;
+	case KMIP_ENCODING_XML:
+		if (xfer->write_cb.xml.ctx != NULL) {
+			xmlFreeDoc(xfer->write_cb.xml.ctx->myDoc);
+			xmlFreeParserCtxt(xfer->write_cb.xml.ctx);
+		}
+		if (xfer->req_xml_doc != NULL)
+			xmlFreeDoc(xfer->req_xml_doc);
+		if (xfer->req_xml_obj != NULL)
+			xmlFreeNode(xfer->req_xml_obj);
+		if (xfer->req_buff != NULL)
+			xmlFree(xfer->req_buff);
+		break;
+	}
+
+	curl_easy_setopt(conn->https.curl, CURLOPT_SSL_CTX_FUNCTION, NULL);
+	curl_easy_setopt(conn->https.curl, CURLOPT_SSL_CTX_DATA, NULL);
+	curl_easy_setopt(conn->https.curl, CURLOPT_WRITEFUNCTION, NULL);
+	curl_easy_setopt(conn->https.curl, CURLOPT_WRITEDATA, NULL);
+	curl_easy_setopt(conn->https.curl, CURLOPT_HEADERFUNCTION, NULL);
+	curl_easy_setopt(conn->https.curl, CURLOPT_HEADERDATA, NULL);
+	curl_easy_setopt(conn->https.curl, CURLOPT_ERRORBUFFER, NULL);
+	curl_easy_setopt(conn->https.curl, CURLOPT_POSTFIELDS, NULL);
+	curl_easy_setopt(conn->https.curl, CURLOPT_POSTFIELDSIZE, -1);
+
+	free(xfer);
+}
+
+/**
+ * Prepares a request over a HTTPS KMIP connection: The request is encoded, and
+ * the curl handle of the connection is set up to post it. The transfer can
+ * then be performed with curl_easy_perform(), or with a curl multi handle.
+ * When the transfer is done, kmip_connection_https_complete() must be called.
  *
+ * @param conn              the KMIP connection
+ * @param request           the request to send
+ * @param xfer              On return: the transfer state
  * @param debug             if true, debug messages are printed
  *
  * @returns 0 in case of success, or a negative errno value
  */
-int kmip_connection_https_perform(struct kmip_connection *conn,
+int kmip_connection_https_prepare(struct kmip_connection *conn,
 				  struct kmip_node *request,
-				  struct kmip_node **response,
+				  struct kmip_https_xfer **xfer,
 				  bool debug)
 {
-	struct curl_sslctx_cb_data sslctx_cb = { 0 };
-	struct curl_header_cb_data header_cb = { 0 };
-	struct curl_write_cb_data write_cb = { 0 };
-	char error_str[CURL_ERROR_SIZE] = { 0 };
-	json_object *req_json_obj = NULL;
-	xmlNode *req_xml_obj = NULL;
-	xmlDoc *req_xml_doc = NULL;
-	BIO *req_mem_bio = NULL;
-	char *req_buff = NULL;
-	int req_buff_size = 0;
-	long status_code;
+	struct kmip_https_xfer *x;
 	size_t size;
 	int rc;
 
-	if (conn == NULL || request == NULL || response == NULL)
+	if (conn == NULL || request == NULL || xfer == NULL)
 		return -EINVAL;
 
-	*response = NULL;
+	*xfer = NULL;
+
+	x = calloc(1, sizeof(struct kmip_https_xfer));
+	if (x == NULL) {
+		kmip_debug(debug, "calloc failed");
+		return -ENOMEM;
+	}
 
 	rc = curl_easy_setopt(conn->https.curl, CURLOPT_ERRORBUFFER,
-			      error_str);
+			      x->error_str);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_ERRORBUFFER", debug,
 			 out);
 
 	/* Setup SSL Context callback */
-	sslctx_cb.conn = conn;
-	sslctx_cb.debug = debug;
+	x->sslctx_cb.conn = conn;
+	x->sslctx_cb.debug = debug;
 
 	rc = curl_easy_setopt(conn->https.curl, CURLOPT_SSL_CTX_FUNCTION,
 			      mkip_connection_https_sslctx_cb);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt "
 			 "CURLOPT_SSL_CTX_FUNCTION", debug, out);
 	rc = curl_easy_setopt(conn->https.curl, CURLOPT_SSL_CTX_DATA,
-			      &sslctx_cb);
+			      &x->sslctx_cb);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_SSL_CTX_DATA",
 			 debug, out);
 
 	/* Setup write callback to handle received data */
-	write_cb.conn = conn;
-	write_cb.debug = debug;
+	x->write_cb.conn = conn;
+	x->write_cb.debug = debug;
 
 	switch (conn->config.encoding) {
 	case KMIP_ENCODING_TTLV:
-		write_cb.ttlv.resp_mem_bio = BIO_new(BIO_s_mem());
-		if (write_cb.ttlv.resp_mem_bio == NULL) {
+		x->write_cb.ttlv.resp_mem_bio = BIO_new(BIO_s_mem());
+		if (x->write_cb.ttlv.resp_mem_bio == NULL) {
 			kmip_debug(debug, "BIO_new failed");
 			rc = -ENOMEM;
 			goto out;
@@ -560,8 +624,8 @@ int kmip_connection_https_perform(struct kmip_connection *conn,
 		break;
 
 	case KMIP_ENCODING_JSON:
-		write_cb.json.tok = json_tokener_new();
-		if (write_cb.json.tok == NULL) {
+		x->write_cb.json.tok = json_tokener_new();
+		if (x->write_cb.json.tok == NULL) {
 			kmip_debug(debug, "json_tokener_new failed");
 			rc = -EIO;
 			goto out;
@@ -569,9 +633,9 @@ int kmip_connection_https_perform(struct kmip_connection *conn,
 		break;
 
 	case KMIP_ENCODING_XML:
-		write_cb.xml.ctx = xmlCreatePushParserCtxt(NULL, NULL, NULL, 0,
-							   NULL);
-		if (write_cb.xml.ctx == NULL) {
+		x->write_cb.xml.ctx = xmlCreatePushParserCtxt(NULL, NULL, NULL,
+							      0, NULL);
+		if (x->write_cb.xml.ctx == NULL) {
 			kmip_debug(debug, "xmlCreatePushParserCtxt failed");
 			rc = -EIO;
 			goto out;
@@ -584,20 +648,20 @@ int kmip_connection_https_perform(struct kmip_connection *conn,
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_WRITEFUNCTION", debug,
 			 out);
 	rc = curl_easy_setopt(conn->https.curl, CURLOPT_WRITEDATA,
-			      (void *)&write_cb);
+			      (void *)&x->write_cb);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_WRITEDATA", debug,
 			 out);
 
 	/* Setup header callback to check content type */
-	header_cb.conn = conn;
-	header_cb.debug = debug;
+	x->header_cb.conn = conn;
+	x->header_cb.debug = debug;
 
 	rc = curl_easy_setopt(conn->https.curl, CURLOPT_HEADERFUNCTION,
 			      mkip_connection_https_header_cb);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_HEADERFUNCTION", debug,
 			 out);
 	rc = curl_easy_setopt(conn->https.curl, CURLOPT_HEADERDATA,
-			      (void *)&header_cb);
+			      (void *)&x->header_cb);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_HEADERDATA", debug,
 			 out);
 
@@ -612,30 +676,31 @@ int kmip_connection_https_perform(struct kmip_connection *conn,
 
 	switch (conn->config.encoding) {
 	case KMIP_ENCODING_TTLV:
-		req_mem_bio = BIO_new(BIO_s_mem());
-		if (req_mem_bio == NULL) {
+		x->req_mem_bio = BIO_new(BIO_s_mem());
+		if (x->req_mem_bio == NULL) {
 			kmip_debug(debug, "BIO_new failed");
 			rc = -ENOMEM;
 			goto out;
 		}
 
-		rc = kmip_encode_ttlv(request, req_mem_bio, &size, debug);
+		rc = kmip_encode_ttlv(request, x->req_mem_bio, &size, debug);
 		if (rc != 0) {
 			kmip_debug(debug, "kmip_encode_ttlv failed");
 			goto out;
 		}
 
-		req_buff_size = BIO_get_mem_data(req_mem_bio, &req_buff);
+		x->req_buff_size = BIO_get_mem_data(x->req_mem_bio,
+						    &x->req_buff);
 
 		kmip_debug(debug, "Request Data (TTLV): %d bytes",
-			   req_buff_size);
+			   x->req_buff_size);
 		if (debug)
-			kmip_print_dump(__func__, (unsigned char *)req_buff,
-					req_buff_size, 2);
+			kmip_print_dump(__func__, (unsigned char *)x->req_buff,
+					x->req_buff_size, 2);
 		break;
 
 	case KMIP_ENCODING_JSON:
-		rc = kmip_encode_json(request, &req_json_obj, debug);
+		rc = kmip_encode_json(request, &x->req_json_obj, debug);
 		if (rc != 0) {
 			kmip_debug(debug, "kmip_encode_json failed");
 			goto out;
@@ -645,74 +710,113 @@ int kmip_connection_https_perform(struct kmip_connection *conn,
 		 * The memory returned by json_object_to_json_string_ext
 		 * is freed when the JSON object is freed.
 		 */
-		req_buff = (char *)json_object_to_json_string_ext(req_json_obj,
+		x->req_buff = (char *)json_object_to_json_string_ext(
+					x->req_json_obj,
 					JSON_C_TO_STRING_PLAIN |
 					JSON_C_TO_STRING_NOSLASHESCAPE);
-		if (req_buff == NULL) {
+		if (x->req_buff == NULL) {
 			kmip_debug(debug,
 				   "json_object_to_json_string_ext failed");
 			rc = -EIO;
 			goto out;
 		}
-		req_buff_size = strlen(req_buff);
+		x->req_buff_size = strlen(x->req_buff);
 
 		kmip_debug(debug, "Request Data (JSON):");
-		kmip_debug(debug, "  ->%*s<-", req_buff_size,
-			   req_buff);
+		kmip_debug(debug, "  ->%*s<-", x->req_buff_size,
+			   x->req_buff);
 		break;
 
 	case KMIP_ENCODING_XML:
-		req_xml_doc = xmlNewDoc((xmlChar *)"1.0");
-		if (req_xml_doc == NULL) {
+		x->req_xml_doc = xmlNewDoc((xmlChar *)"1.0");
+		if (x->req_xml_doc == NULL) {
 			kmip_debug(debug, "xmlNewDoc failed");
 			rc = -EIO;
 			goto out;
 		}
 
-		rc = kmip_encode_xml(request, &req_xml_obj, debug);
+		rc = kmip_encode_xml(request, &x->req_xml_obj, debug);
 		if (rc != 0) {
 			kmip_debug(debug, "kmip_encode_xml failed");
 			goto out;
 		}
 
-		xmlDocSetRootElement(req_xml_doc, req_xml_obj);
-		req_xml_obj = NULL;
+		xmlDocSetRootElement(x->req_xml_doc, x->req_xml_obj);
+		x->req_xml_obj = NULL;
 
-		xmlDocDumpFormatMemoryEnc(req_xml_doc, (xmlChar **)&req_buff,
-					  &req_buff_size, "UTF-8", 0);
-		if (req_buff == NULL || req_buff_size == 0) {
+		xmlDocDumpFormatMemoryEnc(x->req_xml_doc,
+					  (xmlChar **)&x->req_buff,
+					  &x->req_buff_size, "UTF-8", 0);
+		if (x->req_buff == NULL || x->req_buff_size == 0) {
 			kmip_debug(debug, "xmlDocDumpFormatMemoryEnc failed");
 			rc = -EIO;
 			goto out;
 		}
 
 		kmip_debug(debug, "Request Data (XML):");
-		kmip_debug(debug, "  ->%*s<-", req_buff_size,
-			   req_buff);
+		kmip_debug(debug, "  ->%*s<-", x->req_buff_size,
+			   x->req_buff);
 		break;
 	}
 
 	rc = curl_easy_setopt(conn->https.curl, CURLOPT_POSTFIELDSIZE,
-			      req_buff_size);
+			      x->req_buff_size);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_POSTFIELDSIZE",
 			 debug, out);
 	rc = curl_easy_setopt(conn->https.curl, CURLOPT_POSTFIELDS,
-			      req_buff);
+			      x->req_buff);
 	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_POSTFIELDS",
 			 debug, out);
 
-	/* Perform the request */
-	rc = curl_easy_perform(conn->https.curl);
-	if (rc != CURLE_OK) {
+	*xfer = x;
+	rc = 0;
+
+out:
+	if (rc != 0)
+		kmip_connection_https_xfer_free(conn, x);
+
+	return rc;
+}
+
+/**
+ * Completes a request over a HTTPS KMIP connection that was prepared with
+ * kmip_connection_https_prepare(): The result of the transfer is checked and
+ * the response is decoded. The transfer state is freed, and the curl handle is
+ * reset, in any case.
+ *
+ * @param conn              the KMIP connection
+ * @param xfer              the transfer state
+ * @param result            the result of the transfer
+ * @param response          On return: the received response. Must be freed by
+ *                          the caller.
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_connection_https_complete(struct kmip_connection *conn,
+				   struct kmip_https_xfer *xfer,
+				   CURLcode result,
+				   struct kmip_node **response,
+				   bool debug)
+{
+	long status_code;
+	int rc;
+
+	if (conn == NULL || xfer == NULL || response == NULL)
+		return -EINVAL;
+
+	*response = NULL;
+
+	if (result != CURLE_OK) {
 		kmip_debug(debug, "curl_easy_perform for '%s' failed: %s",
-			   conn->config.server, curl_easy_strerror(rc));
-		kmip_debug(debug, "Error: %s", error_str);
+			   conn->config.server, curl_easy_strerror(result));
+		kmip_debug(debug, "Error: %s", xfer->error_str);
 
-		if (header_cb.error) {
+		if (xfer->header_cb.error) {
 			kmip_debug(debug, "Unexpected Content-Type");
 			rc = -EBADMSG;
 		}
-		if (write_cb.error) {
+		if (xfer->write_cb.error) {
 			kmip_debug(debug, "JSON/XML parsing failed");
 			rc = -EBADMSG;
 		}
@@ -734,7 +838,7 @@ int kmip_connection_https_perform(struct kmip_connection *conn,
 	/* Process received data */
 	switch (conn->config.encoding) {
 	case KMIP_ENCODING_TTLV:
-		rc = kmip_decode_ttlv(write_cb.ttlv.resp_mem_bio, NULL,
+		rc = kmip_decode_ttlv(xfer->write_cb.ttlv.resp_mem_bio, NULL,
 				      response, debug);
 		if (rc != 0) {
 			kmip_debug(debug, "kmip_decode_ttlv failed");
@@ -743,14 +847,14 @@ int kmip_connection_https_perform(struct kmip_connection *conn,
 		break;
 
 	case KMIP_ENCODING_JSON:
-		if (write_cb.json.resp_obj == NULL) {
+		if (xfer->write_cb.json.resp_obj == NULL) {
 			kmip_debug(debug, "JSON content not wellformed");
 			rc = -EBADMSG;
 			goto out;
 		}
 
-		rc = kmip_decode_json(write_cb.json.resp_obj, NULL, response,
-				      debug);
+		rc = kmip_decode_json(xfer->write_cb.json.resp_obj, NULL,
+				      response, debug);
 		if (rc != 0) {
 			kmip_debug(debug, "kmip_decode_json failed");
 			goto out;
@@ -758,16 +862,16 @@ int kmip_connection_https_perform(struct kmip_connection *conn,
 		break;
 
 	case KMIP_ENCODING_XML:
-		rc = xmlParseChunk(write_cb.xml.ctx, "", 0, 1);
-		if (rc != XML_ERR_OK || !write_cb.xml.ctx->wellFormed ||
-		    write_cb.xml.ctx->myDoc == NULL) {
+		rc = xmlParseChunk(xfer->write_cb.xml.ctx, "", 0, 1);
+		if (rc != XML_ERR_OK || !xfer->write_cb.xml.ctx->wellFormed ||
+		    xfer->write_cb.xml.ctx->myDoc == NULL) {
 			kmip_debug(debug, "XML content not wellformed");
 			rc = -EBADMSG;
 			goto out;
 		}
 
 		rc = kmip_decode_xml(xmlDocGetRootElement(
-						write_cb.xml.ctx->myDoc),
+					xfer->write_cb.xml.ctx->myDoc),
 				     NULL, response, debug);
 		if (rc != 0) {
 			kmip_debug(debug, "kmip_decode_xml failed");
@@ -779,55 +883,53 @@ int kmip_connection_https_perform(struct kmip_connection *conn,
 	rc = 0;
 
 out:
-	/* Cleanup */
-	switch (conn->config.encoding) {
-	case KMIP_ENCODING_TTLV:
-		if (req_mem_bio != NULL)
-			BIO_free(req_mem_bio);
-		if (write_cb.ttlv.resp_mem_bio != NULL)
-			BIO_free(write_cb.ttlv.resp_mem_bio);
-
-		break;
-	case KMIP_ENCODING_JSON:
-		if (write_cb.json.tok != NULL)
-			json_tokener_free(write_cb.json.tok);
-		if (write_cb.json.resp_obj != NULL)
-			json_object_put(write_cb.json.resp_obj);
-		if (req_json_obj != NULL)
-			json_object_put(req_json_obj);
-		break;
-	case KMIP_ENCODING_XML:
-		if (write_cb.xml.ctx != NULL) {
-			xmlFreeDoc(write_cb.xml.ctx->myDoc);
-			xmlFreeParserCtxt(write_cb.xml.ctx);
-		}
-		if (req_xml_doc != NULL)
-			xmlFreeDoc(req_xml_doc);
-		if (req_xml_obj != NULL)
-			xmlFreeNode(req_xml_obj);
-		if (req_buff != NULL)
-			xmlFree(req_buff);
-		break;
-	}
-
 	if (rc != 0 && *response != NULL) {
 		kmip_node_free(*response);
 		*response = NULL;
 	}
 
-	curl_easy_setopt(conn->https.curl, CURLOPT_SSL_CTX_FUNCTION, NULL);
-	curl_easy_setopt(conn->https.curl, CURLOPT_SSL_CTX_DATA, NULL);
-	curl_easy_setopt(conn->https.curl, CURLOPT_WRITEFUNCTION, NULL);
-	curl_easy_setopt(conn->https.curl, CURLOPT_WRITEDATA, NULL);
-	curl_easy_setopt(conn->https.curl, CURLOPT_HEADERFUNCTION, NULL);
-	curl_easy_setopt(conn->https.curl, CURLOPT_HEADERDATA, NULL);
-	curl_easy_setopt(conn->https.curl, CURLOPT_ERRORBUFFER, NULL);
-	curl_easy_setopt(conn->https.curl, CURLOPT_POSTFIELDS, NULL);
-	curl_easy_setopt(conn->https.curl, CURLOPT_POSTFIELDSIZE, -1);
+	kmip_connection_https_xfer_free(conn, xfer);
 
 	return rc;
 }
 
+/**
+ * Perform a request over the KMIP connection
+ *
+ * @param conn              the KMIP connection
+ * @param request           the request to send
+ * @param response          On return: the received response. Must be freed by
+ *                          the caller.
+ *
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_connection_https_perform(struct kmip_connection *conn,
+				  struct kmip_node *request,
+				  struct kmip_node **response,
+				  bool debug)
+{
+	struct kmip_https_xfer *xfer;
+	CURLcode result;
+	int rc;
+
+	if (conn == NULL || request == NULL || response == NULL)
+		return -EINVAL;
+
+	*response = NULL;
+
+	rc = kmip_connection_https_prepare(conn, request, &xfer, debug);
+	if (rc != 0)
+		return rc;
+
+	/* Perform the request */
+	result = curl_easy_perform(conn->https.curl);
+
+	return kmip_connection_https_complete(conn, xfer, result, response,
+					      debug);
+}
+
 /**
  * Terminates a HTTPS KMIP connection.
  *
@@ -846,3 +948,37 @@ void kmip_connection_https_term(struct kmip_connection *conn)
 		curl_slist_free_all(conn->https.headers);
 	conn->https.headers = NULL;
 }
+
+/**
+ * Enables TCP keep-alive probes on the connections used by a HTTPS KMIP
+ * connection. libcurl keeps the connection to the server open between
+ * requests, the probes prevent that idle connections are dropped by
+ * firewalls.
+ *
+ * @param conn              the KMIP connection
+ * @param idle              the idle time in seconds before probes are sent
+ * @param debug             if true, debug messages are printed
+ */
+void kmip_connection_https_set_keepalive(struct kmip_connection *conn,
+					 unsigned int idle, bool debug)
+{
+	CURLcode rc;
+
+	if (conn == NULL || conn->https.curl == NULL)
+		return;
+
+	rc = curl_easy_setopt(conn->https.curl, CURLOPT_TCP_KEEPALIVE, 1L);
+	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_TCP_KEEPALIVE", debug,
+			 out);
+	rc = curl_easy_setopt(conn->https.curl, CURLOPT_TCP_KEEPIDLE,
+			      (long)idle);
+	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_TCP_KEEPIDLE", debug,
+			 out);
+	rc = curl_easy_setopt(conn->https.curl, CURLOPT_TCP_KEEPINTVL,
+			      (long)idle);
+	CURL_ERROR_CHECK(rc, "curl_easy_setopt CURLOPT_TCP_KEEPINTVL", debug,
+			 out);
+
+out:
+	return;
+}
@@ -24,9 +24,36 @@
 void __attribute__ ((constructor)) kmip_init(void);
 void __attribute__ ((destructor)) kmip_exit(void);
 
+/**
+ * Allocates a new, empty KMIP node from the specified arena, or from the heap
+ * if no arena is specified. The newly allocated node has a reference count of
+ * 1. A node allocated from an arena holds a reference to the arena.
+ *
+ * @param arena             the arena to allocate from, or NULL
+ *
+ * @returns the allocated node, or NULL in case of an error
+ */
+struct kmip_node *kmip_node_alloc(struct kmip_arena *arena)
+{
+	struct kmip_node *node;
+
+	node = kmip_arena_zalloc(arena, sizeof(struct kmip_node));
+	if (node == NULL)
+		return NULL;
+
+	node->ref_count = 1;
+	if (arena != NULL) {
+		kmip_arena_upref(arena);
+		node->arena = arena;
+	}
+
+	return node;
+}
+
 /**
  * Constructs a new KMIP node with the specified tag and type, and an optional
- * name. The newly allocated node has a reference count of 1.
+ * name. The newly allocated node has a reference count of 1. The node is
+ * allocated from the arena in use by the calling thread, if any.
  *
  * @param tag               the tag of the new node
  * @param name              Optional: the name of the node (only used with JSON
@@ -40,18 +67,17 @@ static struct kmip_node *kmip_node_new(enum kmip_tag tag, const char *name,
 {
 	struct kmip_node *node;
 
-	node = calloc(1, sizeof(struct kmip_node));
+	node = kmip_node_alloc(kmip_arena_current());
 	if (node == NULL)
 		return NULL;
 
-	node->ref_count = 1;
 	node->tag = tag;
 	node->type = type;
 
 	if (name != NULL) {
-		node->name = strdup(name);
+		node->name = kmip_arena_strdup(node->arena, name);
 		if (node->name == NULL) {
-			free(node);
+			kmip_node_free(node);
 			return NULL;
 		}
 	}
@@ -624,9 +650,9 @@ struct kmip_node *kmip_node_new_text_string(enum kmip_tag tag, const char *name,
 		return NULL;
 
 	if (value != NULL) {
-		node->text_value = strdup(value);
+		node->text_value = kmip_arena_strdup(node->arena, value);
 		if (node->text_value == NULL) {
-			free(node);
+			kmip_node_free(node);
 			return NULL;
 		}
 		node->length = strlen(value);
@@ -678,12 +704,12 @@ struct kmip_node *kmip_node_new_byte_string(enum kmip_tag tag, const char *name,
 		return NULL;
 
 	if (value != NULL && length > 0) {
-		node->bytes_value = malloc(length);
+		node->bytes_value = kmip_arena_memdup(node->arena, value,
+						      length, false);
 		if (node->bytes_value == NULL) {
-			free(node);
+			kmip_node_free(node);
 			return NULL;
 		}
-		memcpy(node->bytes_value, value, length);
 		node->length = length;
 	}
 	return node;
@@ -847,7 +873,8 @@ int64_t kmip_node_get_date_time_ext(const struct kmip_node *node)
 
 /**
  * Clones (copies) a KMIP node with all its data and elements (in case of a
- * structure node).
+ * structure node). The clone is allocated from the arena in use by the calling
+ * thread, if any, independent of where the original node was allocated from.
  *
  * @param node              the KMIP node to clone
  *
@@ -855,8 +882,7 @@ int64_t kmip_node_get_date_time_ext(const struct kmip_node *node)
  */
 struct kmip_node *kmip_node_clone(const struct kmip_node *node)
 {
-	struct kmip_node *clone, *element, *cloned_element;
-	int rc;
+	struct kmip_node *clone, *element, *cloned_element, *last = NULL;
 
 	clone = kmip_node_new(node->tag, node->name, node->type);
 	if (clone == NULL)
@@ -869,11 +895,13 @@ struct kmip_node *kmip_node_clone(const struct kmip_node *node)
 			cloned_element = kmip_node_clone(element);
 			if (cloned_element == NULL)
 				goto error;
-			rc = kmip_node_add_structure_element(clone,
-							     cloned_element);
-			kmip_node_free(cloned_element);
-			if (rc != 0)
-				goto error;
+			/* Link directly to avoid walking the list */
+			cloned_element->parent = clone;
+			if (last == NULL)
+				clone->structure_value = cloned_element;
+			else
+				last->next = cloned_element;
+			last = cloned_element;
 			element = element->next;
 		}
 		break;
@@ -896,19 +924,21 @@ struct kmip_node *kmip_node_clone(const struct kmip_node *node)
 		break;
 	case KMIP_TYPE_TEXT_STRING:
 		if (node->text_value != NULL) {
-			clone->text_value = strdup(node->text_value);
-			if (node->text_value == NULL)
+			clone->text_value = kmip_arena_strdup(clone->arena,
+							      node->text_value);
+			if (clone->text_value == NULL)
 				goto error;
 			clone->length = strlen(clone->text_value);
 		}
 		break;
 	case KMIP_TYPE_BYTE_STRING:
 		if (node->bytes_value != NULL && node->length > 0) {
-			clone->bytes_value = malloc(node->length);
+			clone->bytes_value = kmip_arena_memdup(clone->arena,
+							       node->bytes_value,
+							       node->length,
+							       false);
 			if (clone->bytes_value == NULL)
 				goto error;
-			memcpy(clone->bytes_value, node->bytes_value,
-			       node->length);
 			clone->length = node->length;
 		}
 		break;
@@ -946,7 +976,8 @@ void kmip_node_upref(struct kmip_node *node)
 }
 
 /**
- * Free a KMIP node, including its value (structure elements, etc)
+ * Free a KMIP node, including its value (structure elements, etc). The memory
+ * of a node allocated from an arena is released together with the arena.
  *
  * @param node              the node to free
  */
@@ -988,15 +1019,24 @@ void kmip_node_free(struct kmip_node *node)
 		BN_free(node->big_integer_value);
 		break;
 	case KMIP_TYPE_TEXT_STRING:
-		free(node->text_value);
+		if (node->arena == NULL)
+			free(node->text_value);
 		break;
 	case KMIP_TYPE_BYTE_STRING:
-		free(node->bytes_value);
+		if (node->buffer != NULL)
+			kmip_buffer_free(node->buffer);
+		else if (node->arena == NULL)
+			free(node->bytes_value);
 		break;
 	default:
 		break;
 	}
 
+	if (node->arena != NULL) {
+		kmip_arena_free(node->arena);
+		return;
+	}
+
 	free(node->name);
 	free(node);
 }
@@ -1030,6 +1070,157 @@ const struct kmip_version *kmip_get_default_protocol_version(void)
 	return &default_protocol_version;
 }
 
+/**
+ * Copies a connection configuration. The strings are duplicated, and the
+ * reference count of the PKEY is increased.
+ *
+ * @param dst               the configuration to copy to. Must be zeroed.
+ * @param src               the configuration to copy from
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_conn_config_copy(struct kmip_conn_config *dst,
+			  const struct kmip_conn_config *src, bool debug)
+{
+	int rc;
+
+	dst->encoding = src->encoding;
+	dst->transport = src->transport;
+	kmip_debug(debug, "encoding: %d", dst->encoding);
+	kmip_debug(debug, "transport: %d", dst->transport);
+
+	dst->server = strdup(src->server);
+	if (dst->server == NULL) {
+		kmip_debug(debug, "strdup failed");
+		rc = -ENOMEM;
+		goto out;
+	}
+	kmip_debug(debug, "server: '%s'", dst->server);
+
+	if (EVP_PKEY_up_ref(src->tls_client_key) != 1) {
+		kmip_debug(debug, "EVP_PKEY_up_ref failed");
+		rc = -EIO;
+		goto out;
+	}
+	dst->tls_client_key = src->tls_client_key;
+	kmip_debug(debug, "client key: %p", dst->tls_client_key);
+
+	dst->tls_client_cert = strdup(src->tls_client_cert);
+	if (dst->tls_client_cert == NULL) {
+		kmip_debug(debug, "strdup failed");
+		rc = -ENOMEM;
+		goto out;
+	}
+	kmip_debug(debug, "client cert: '%s'", dst->tls_client_cert);
+
+	if (src->tls_ca != NULL) {
+		dst->tls_ca = strdup(src->tls_ca);
+		if (dst->tls_ca == NULL) {
+			kmip_debug(debug, "strdup failed");
+			rc = -ENOMEM;
+			goto out;
+		}
+		kmip_debug(debug, "CA: '%s'", dst->tls_ca);
+	}
+
+	if (src->tls_issuer_cert != NULL) {
+		dst->tls_issuer_cert = strdup(src->tls_issuer_cert);
+		if (dst->tls_issuer_cert == NULL) {
+			kmip_debug(debug, "strdup failed");
+			rc = -ENOMEM;
+			goto out;
+		}
+		kmip_debug(debug, "issuer cert: '%s'", dst->tls_issuer_cert);
+	}
+
+	if (src->tls_pinned_pubkey != NULL) {
+		dst->tls_pinned_pubkey = strdup(src->tls_pinned_pubkey);
+		if (dst->tls_pinned_pubkey == NULL) {
+			kmip_debug(debug, "strdup failed");
+			rc = -ENOMEM;
+			goto out;
+		}
+		kmip_debug(debug, "pinned pubkey: '%s'",
+			   dst->tls_pinned_pubkey);
+	}
+
+	if (src->tls_server_cert != NULL) {
+		dst->tls_server_cert = strdup(src->tls_server_cert);
+		if (dst->tls_server_cert == NULL) {
+			kmip_debug(debug, "strdup failed");
+			rc = -ENOMEM;
+			goto out;
+		}
+		kmip_debug(debug, "server cert: '%s'", dst->tls_server_cert);
+	}
+
+	dst->tls_verify_peer = src->tls_verify_peer;
+	dst->tls_verify_host = src->tls_verify_host;
+	kmip_debug(debug, "verify peer: %d", dst->tls_verify_peer);
+	kmip_debug(debug, "verify host: %d", dst->tls_verify_host);
+
+	if (src->tls_cipher_list != NULL) {
+		dst->tls_cipher_list = strdup(src->tls_cipher_list);
+		if (dst->tls_cipher_list == NULL) {
+			kmip_debug(debug, "strdup failed");
+			rc = -ENOMEM;
+			goto out;
+		}
+		kmip_debug(debug, "TLS cipher list: '%s'",
+			   dst->tls_cipher_list);
+	}
+
+	if (src->tls13_cipher_list != NULL) {
+		dst->tls13_cipher_list = strdup(src->tls13_cipher_list);
+		if (dst->tls13_cipher_list == NULL) {
+			kmip_debug(debug, "strdup failed");
+			rc = -ENOMEM;
+			goto out;
+		}
+		kmip_debug(debug, "TLSv1.3 cipher list: '%s'",
+			   dst->tls13_cipher_list);
+	}
+
+	rc = 0;
+
+out:
+	if (rc != 0)
+		kmip_conn_config_free(dst);
+
+	return rc;
+}
+
+/**
+ * Frees the strings of a connection configuration copied with
+ * kmip_conn_config_copy(), and releases the reference to the PKEY.
+ *
+ * @param config            the configuration to free
+ */
+void kmip_conn_config_free(struct kmip_conn_config *config)
+{
+	if (config->server != NULL)
+		free((void *)config->server);
+	if (config->tls_client_key != NULL)
+		EVP_PKEY_free(config->tls_client_key);
+	if (config->tls_client_cert != NULL)
+		free((void *)config->tls_client_cert);
+	if (config->tls_ca != NULL)
+		free((void *)config->tls_ca);
+	if (config->tls_issuer_cert != NULL)
+		free((void *)config->tls_issuer_cert);
+	if (config->tls_pinned_pubkey != NULL)
+		free((void *)config->tls_pinned_pubkey);
+	if (config->tls_server_cert != NULL)
+		free((void *)config->tls_server_cert);
+	if (config->tls_cipher_list != NULL)
+		free((void *)config->tls_cipher_list);
+	if (config->tls13_cipher_list != NULL)
+		free((void *)config->tls13_cipher_list);
+
+	memset(config, 0, sizeof(*config));
+}
+
 /**
  * Constructs a new connection to a KMIP server using the specified connection
  * configuration. The strings specified in the configuration are copied into the
@@ -1046,6 +1237,27 @@ const struct kmip_version *kmip_get_default_protocol_version(void)
 int kmip_connection_new(const struct kmip_conn_config *config,
 			struct kmip_connection **connection,
 			bool debug)
+{
+	return kmip_connection_new_session(config, NULL, connection, debug);
+}
+
+/**
+ * Constructs a new connection to a KMIP server like kmip_connection_new(), and
+ * tries to resume the specified TLS session. If the server does not accept
+ * the session, a full handshake is performed. The session is only used with
+ * the Plain-TLS transport.
+ *
+ * @param config            the connection configuration
+ * @param session           Optional: the TLS session to resume. Can be NULL.
+ * @param connection        On return: a newly allocated KMIP connection
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_connection_new_session(const struct kmip_conn_config *config,
+				SSL_SESSION *session,
+				struct kmip_connection **connection,
+				bool debug)
 {
 	struct kmip_connection *conn = NULL;
 	int rc;
@@ -1108,105 +1320,18 @@ int kmip_connection_new(const struct kmip_conn_config *config,
 		return -ENOMEM;
 	}
 
-	conn->config.encoding = config->encoding;
-	conn->config.transport = config->transport;
-	kmip_debug(debug, "encoding: %d", conn->config.encoding);
-	kmip_debug(debug, "transport: %d", conn->config.transport);
-
-	conn->config.server = strdup(config->server);
-	if (conn->config.server == NULL) {
-		kmip_debug(debug, "strdup failed");
-		rc = -ENOMEM;
-		goto out;
-	}
-	kmip_debug(debug, "server: '%s'", conn->config.server);
-
-	conn->config.tls_client_key = config->tls_client_key;
-	if (EVP_PKEY_up_ref(conn->config.tls_client_key) != 1) {
-		kmip_debug(debug, "EVP_PKEY_up_ref failed");
-		rc = -EIO;
-		goto out;
-	}
-	kmip_debug(debug, "client key: %p", conn->config.tls_client_key);
-
-	conn->config.tls_client_cert = strdup(config->tls_client_cert);
-	if (conn->config.tls_client_cert == NULL) {
-		kmip_debug(debug, "strdup failed");
-		rc = -ENOMEM;
+	rc = kmip_conn_config_copy(&conn->config, config, debug);
+	if (rc != 0)
 		goto out;
-	}
-	kmip_debug(debug, "client cert: '%s'", conn->config.tls_client_cert);
 
-	if (config->tls_ca != NULL) {
-		conn->config.tls_ca = strdup(config->tls_ca);
-		if (conn->config.tls_ca == NULL) {
-			kmip_debug(debug, "strdup failed");
-			rc = -ENOMEM;
+	if (session != NULL &&
+	    conn->config.transport == KMIP_TRANSPORT_PLAIN_TLS) {
+		if (SSL_SESSION_up_ref(session) != 1) {
+			kmip_debug(debug, "SSL_SESSION_up_ref failed");
+			rc = -EIO;
 			goto out;
 		}
-		kmip_debug(debug, "CA: '%s'", conn->config.tls_ca);
-	}
-
-	if (config->tls_issuer_cert != NULL) {
-		conn->config.tls_issuer_cert = strdup(config->tls_issuer_cert);
-		if (conn->config.tls_issuer_cert == NULL) {
-			kmip_debug(debug, "strdup failed");
-			rc = -ENOMEM;
-			goto out;
-		}
-		kmip_debug(debug, "issuer cert: '%s'",
-			   conn->config.tls_issuer_cert);
-	}
-
-	if (config->tls_pinned_pubkey != NULL) {
-		conn->config.tls_pinned_pubkey =
-					strdup(config->tls_pinned_pubkey);
-		if (conn->config.tls_pinned_pubkey == NULL) {
-			kmip_debug(debug, "strdup failed");
-			rc = -ENOMEM;
-			goto out;
-		}
-		kmip_debug(debug, "pinned pubkey: '%s'",
-			   conn->config.tls_pinned_pubkey);
-	}
-
-	if (config->tls_server_cert != NULL) {
-		conn->config.tls_server_cert = strdup(config->tls_server_cert);
-		if (conn->config.tls_server_cert == NULL) {
-			kmip_debug(debug, "strdup failed");
-			rc = -ENOMEM;
-			goto out;
-		}
-		kmip_debug(debug, "server cert: '%s'",
-			   conn->config.tls_server_cert);
-	}
-
-	conn->config.tls_verify_peer = config->tls_verify_peer;
-	conn->config.tls_verify_host = config->tls_verify_host;
-	kmip_debug(debug, "verify peer: %d", conn->config.tls_verify_peer);
-	kmip_debug(debug, "verify host: %d", conn->config.tls_verify_host);
-
-	if (config->tls_cipher_list != NULL) {
-		conn->config.tls_cipher_list = strdup(config->tls_cipher_list);
-		if (conn->config.tls_cipher_list == NULL) {
-			kmip_debug(debug, "strdup failed");
-			rc = -ENOMEM;
-			goto out;
-		}
-		kmip_debug(debug, "TLS cipher list: '%s'",
-			   conn->config.tls_cipher_list);
-	}
-
-	if (config->tls13_cipher_list != NULL) {
-		conn->config.tls13_cipher_list =
-					strdup(config->tls13_cipher_list);
-		if (conn->config.tls13_cipher_list == NULL) {
-			kmip_debug(debug, "strdup failed");
-			rc = -ENOMEM;
-			goto out;
-		}
-		kmip_debug(debug, "TLSv1.3 cipher list: '%s'",
-			   conn->config.tls13_cipher_list);
+		conn->plain_tls.session = session;
 	}
 
 	switch (conn->config.transport) {
@@ -1308,22 +1433,7 @@ void kmip_connection_free(struct kmip_connection *connection)
 		break;
 	}
 
-	free((void *)connection->config.server);
-	EVP_PKEY_free(connection->config.tls_client_key);
-	free((void *)connection->config.tls_client_cert);
-	if (connection->config.tls_ca != NULL)
-		free((void *)connection->config.tls_ca);
-	if (connection->config.tls_issuer_cert != NULL)
-		free((void *)connection->config.tls_issuer_cert);
-	if (connection->config.tls_pinned_pubkey != NULL)
-		free((void *)connection->config.tls_pinned_pubkey);
-	if (connection->config.tls_server_cert != NULL)
-		free((void *)connection->config.tls_server_cert);
-	if (connection->config.tls_cipher_list != NULL)
-		free((void *)connection->config.tls_cipher_list);
-	if (connection->config.tls13_cipher_list != NULL)
-		free((void *)connection->config.tls13_cipher_list);
-
+	kmip_conn_config_free(&connection->config);
 	free(connection);
 }
 
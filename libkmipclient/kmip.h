@@ -23,6 +23,8 @@
 #include "kmipclient/kmipclient.h"
 
 /* KMIP Connection related structures */
+struct kmip_https_xfer;
+
 #define KMIP_DEFAULT_PROTOCOL_VERSION_MAJOR	1
 #define KMIP_DEFAULT_PROTOCOL_VERSION_MINOR	0
 
@@ -33,6 +35,7 @@ struct kmip_connection {
 			SSL_CTX *ssl_ctx;
 			SSL *ssl;
 			BIO *bio;
+			SSL_SESSION *session;
 		} plain_tls;
 		struct {
 			CURL **curl;
@@ -41,6 +44,17 @@ struct kmip_connection {
 	};
 };
 
+/* Buffer holding TTLV encoded data, referenced by decoded byte strings */
+struct kmip_buffer {
+	volatile unsigned long ref_count;
+	size_t size;
+	unsigned char data[];
+};
+
+/* Arena for allocating KMIP nodes */
+#define KMIP_ARENA_DEFAULT_CHUNK_SIZE	4096
+#define KMIP_ARENA_MAX_CHUNK_SIZE	(1024 * 1024)
+
 /* KMIP node related structures */
 struct kmip_node {
 	enum kmip_tag tag;
@@ -63,6 +77,9 @@ struct kmip_node {
 	struct kmip_node *parent;
 	struct kmip_node *next;
 	volatile unsigned long ref_count;
+	struct kmip_buffer *buffer; /* if set, bytes_value points into it */
+	struct kmip_arena *arena; /* if set, name and value are allocated
+				     from it, and the node itself too */
 };
 
 /* Attribute related internal functions */
@@ -80,25 +97,77 @@ int kmip_get_attribute_name_v1(const struct kmip_node *node,
 			       struct kmip_node **v2_attr_ref);
 
 /* Connection related internal functions */
+int kmip_conn_config_copy(struct kmip_conn_config *dst,
+			  const struct kmip_conn_config *src, bool debug);
+void kmip_conn_config_free(struct kmip_conn_config *config);
+int kmip_connection_new_session(const struct kmip_conn_config *config,
+				SSL_SESSION *session,
+				struct kmip_connection **connection,
+				bool debug);
+
+int kmip_connection_pool_try_get(struct kmip_connection_pool *pool,
+				 struct kmip_connection **connection,
+				 bool debug);
+
 int kmip_connection_tls_init(struct kmip_connection *connection, bool debug);
 int kmip_connection_tls_perform(struct kmip_connection *connection,
 				struct kmip_node *request,
 				struct kmip_node **response,
 				bool debug);
 void kmip_connection_tls_term(struct kmip_connection *connection);
+SSL_SESSION *kmip_connection_tls_get_session(
+				struct kmip_connection *connection);
+bool kmip_connection_tls_is_alive(struct kmip_connection *connection);
+int kmip_connection_tls_send(struct kmip_connection *connection,
+			     struct kmip_node *request, bool debug);
+int kmip_connection_tls_receive(struct kmip_connection *connection,
+				struct kmip_node **response, bool debug);
+int kmip_connection_tls_get_fd(struct kmip_connection *connection);
+bool kmip_connection_tls_has_pending(struct kmip_connection *connection);
+void kmip_connection_tls_set_keepalive(struct kmip_connection *connection,
+				       unsigned int idle, bool debug);
 
 int kmip_connection_https_init(struct kmip_connection *connection, bool debug);
 int kmip_connection_https_perform(struct kmip_connection *connection,
 				  struct kmip_node *request,
 				  struct kmip_node **response,
 				  bool debug);
+int kmip_connection_https_prepare(struct kmip_connection *connection,
+				  struct kmip_node *request,
+				  struct kmip_https_xfer **xfer,
+				  bool debug);
+int kmip_connection_https_complete(struct kmip_connection *connection,
+				   struct kmip_https_xfer *xfer,
+				   CURLcode result,
+				   struct kmip_node **response,
+				   bool debug);
 void kmip_connection_https_term(struct kmip_connection *connection);
+void kmip_connection_https_set_keepalive(struct kmip_connection *connection,
+					 unsigned int idle, bool debug);
+
+/* Arena related internal functions */
+void kmip_arena_upref(struct kmip_arena *arena);
+struct kmip_arena *kmip_arena_current(void);
+void *kmip_arena_zalloc(struct kmip_arena *arena, size_t size);
+void *kmip_arena_memdup(struct kmip_arena *arena, const void *data,
+			size_t size, bool terminate);
+char *kmip_arena_strdup(struct kmip_arena *arena, const char *str);
+
+struct kmip_node *kmip_node_alloc(struct kmip_arena *arena);
 
 /* KIMP decoding and encoding internal functions */
+struct kmip_buffer *kmip_buffer_new(size_t size);
+void kmip_buffer_upref(struct kmip_buffer *buffer);
+void kmip_buffer_free(struct kmip_buffer *buffer);
+
 int kmip_decode_ttlv(BIO *bio, size_t *size, struct kmip_node **node,
 		     bool debug);
+int kmip_decode_ttlv_buffer(struct kmip_buffer *buffer,
+			    struct kmip_node **node, bool debug);
 int kmip_encode_ttlv(struct kmip_node *node, BIO *bio, size_t *size,
 		     bool debug);
+int kmip_encode_ttlv_buffer(struct kmip_node *node, unsigned char **buffer,
+			    size_t *size, bool debug);
 
 int kmip_decode_json(const json_object *obj, struct kmip_node *parent,
 		     struct kmip_node **node, bool debug);
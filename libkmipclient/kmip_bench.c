@@ -0,0 +1,335 @@
+/*
+ * libkmipclient - KMIP client library
+ *
+ * Benchmark for building, encoding, decoding, and freeing KMIP messages
+ *
+ * The messages are modeled after the requests and responses of the zkey KMIP
+ * plugin: Locate of the keys with a label, GetAttributes of a key with its
+ * zkey vendor attributes, and Get of a key. Requests are built with
+ * the nodes allocated from the heap and from an arena. Not installed, run
+ * with 'make bench'.
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lib/zt_common.h"
+
+#include "kmip.h"
+
+#define BENCH_DEFAULT_ITERATIONS	20000
+#define BENCH_LOCATED_ITEMS		100
+#define BENCH_VENDOR_ATTRS		12
+
+#define BENCH_KEY_ID	"5bfbb1e5-2ad3-4d38-8c4f-cb1bb1f5a5a7"
+
+typedef struct kmip_node *(*bench_build_t)(void);
+
+struct bench_msg {
+	const char *name;
+	bench_build_t build;
+};
+
+static const unsigned char bench_key[64] = { 0x01, 0x02, 0x03, 0x04 };
+
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static struct kmip_node *bench_request(enum kmip_operation operation,
+				       struct kmip_node *payload)
+{
+	struct kmip_node *hdr, *bi, *req;
+
+	hdr = kmip_new_request_header(NULL, 0, NULL, NULL, false, NULL, 0,
+				      true, 1);
+	bi = kmip_new_request_batch_item(operation, NULL, 0, payload);
+	req = kmip_new_request_va(hdr, 1, bi);
+	kmip_node_free(hdr);
+	kmip_node_free(bi);
+	kmip_node_free(payload);
+	return req;
+}
+
+/*
+ * Build a structure and drop the references to its elements
+ */
+static struct kmip_node *bench_structure(enum kmip_tag tag,
+					 unsigned int num_elements,
+					 struct kmip_node **elements)
+{
+	struct kmip_node *node;
+	unsigned int i;
+
+	node = kmip_node_new_structure(tag, NULL, num_elements, elements);
+	for (i = 0; i < num_elements; i++)
+		kmip_node_free(elements[i]);
+	return node;
+}
+
+static struct kmip_node *bench_response(enum kmip_operation operation,
+					struct kmip_node *payload)
+{
+	struct kmip_version version = { .major = 1, .minor = 2 };
+	struct kmip_node *hdr[3], *bi[3], *msg[2];
+
+	hdr[0] = kmip_new_protocol_version(&version);
+	hdr[1] = kmip_node_new_date_time(KMIP_TAG_TIME_STAMP, NULL, 1760000000);
+	hdr[2] = kmip_node_new_integer(KMIP_TAG_BATCH_COUNT, NULL, 1);
+	msg[0] = bench_structure(KMIP_TAG_RESPONSE_HEADER, 3, hdr);
+
+	bi[0] = kmip_node_new_enumeration(KMIP_TAG_OPERATION, NULL, operation);
+	bi[1] = kmip_node_new_enumeration(KMIP_TAG_RESULT_STATUS, NULL,
+					  KMIP_RESULT_STATUS_SUCCESS);
+	bi[2] = payload;
+	msg[1] = bench_structure(KMIP_TAG_BATCH_ITEM, 3, bi);
+
+	return bench_structure(KMIP_TAG_RESPONSE_MESSAGE, 2, msg);
+}
+
+static struct kmip_node *bench_vendor_attr(unsigned int i)
+{
+	struct kmip_node *value, *attr;
+	char name[32];
+
+	sprintf(name, "zkey-attribute-%u", i);
+	value = kmip_node_new_text_string(KMIP_TAG_ATTRIBUTE_VALUE, NULL,
+					  "aes-xts-plain64:/dev/disk/by-id/"
+					  "dm-uuid-CRYPT-LUKS2-volume");
+	attr = kmip_new_vendor_attribute("zkey", name, value);
+	kmip_node_free(value);
+	return attr;
+}
+
+static struct kmip_node *bench_locate_request(void)
+{
+	struct kmip_node *attrs[4];
+	struct kmip_node *pl;
+	unsigned int i;
+
+	attrs[0] = kmip_new_object_type(KMIP_OBJECT_TYPE_SYMMETRIC_KEY);
+	attrs[1] = kmip_new_cryptographic_algorithm(KMIP_CRYPTO_ALGO_AES);
+	attrs[2] = kmip_new_name("zkey-disk*",
+				 KMIP_NAME_TYPE_UNINTERPRETED_TEXT_STRING);
+	attrs[3] = bench_vendor_attr(0);
+	pl = kmip_new_locate_request_payload(NULL, 0, 0, 0, 0, 4, attrs);
+	for (i = 0; i < 4; i++)
+		kmip_node_free(attrs[i]);
+
+	return bench_request(KMIP_OPERATION_LOCATE, pl);
+}
+
+static struct kmip_node *bench_locate_response(void)
+{
+	struct kmip_node *e[1 + BENCH_LOCATED_ITEMS];
+	unsigned int i;
+
+	e[0] = kmip_node_new_integer(KMIP_TAG_LOCATED_ITEMS, NULL,
+				     BENCH_LOCATED_ITEMS);
+	for (i = 1; i <= BENCH_LOCATED_ITEMS; i++)
+		e[i] = kmip_new_unique_identifier(BENCH_KEY_ID, 0, 0);
+
+	return bench_response(KMIP_OPERATION_LOCATE,
+			      bench_structure(KMIP_TAG_RESPONSE_PAYLOAD,
+					      ARRAY_SIZE(e), e));
+}
+
+static struct kmip_node *bench_get_attrs_request(void)
+{
+	struct kmip_node *uid, *pl;
+
+	uid = kmip_new_unique_identifier(BENCH_KEY_ID, 0, 0);
+	pl = kmip_new_get_attributes_request_payload(NULL, uid, 0, NULL);
+	kmip_node_free(uid);
+
+	return bench_request(KMIP_OPERATION_GET_ATTRIBUTES, pl);
+}
+
+static struct kmip_node *bench_get_attrs_response(void)
+{
+	struct kmip_node *e[4 + BENCH_VENDOR_ATTRS];
+	unsigned int i;
+
+	e[0] = kmip_new_unique_identifier(BENCH_KEY_ID, 0, 0);
+	e[1] = kmip_new_name("zkey-disk-volume-key",
+			     KMIP_NAME_TYPE_UNINTERPRETED_TEXT_STRING);
+	e[2] = kmip_new_state(KMIP_STATE_ACTIVE);
+	e[3] = kmip_new_cryptographic_length(512);
+	for (i = 0; i < BENCH_VENDOR_ATTRS; i++)
+		e[4 + i] = bench_vendor_attr(i);
+
+	return bench_response(KMIP_OPERATION_GET_ATTRIBUTES,
+			      bench_structure(KMIP_TAG_RESPONSE_PAYLOAD,
+					      ARRAY_SIZE(e), e));
+}
+
+static struct kmip_node *bench_get_request(void)
+{
+	struct kmip_node *uid, *pl;
+
+	uid = kmip_new_unique_identifier(BENCH_KEY_ID, 0, 0);
+	pl = kmip_new_get_request_payload(NULL, uid, KMIP_KEY_FORMAT_TYPE_RAW,
+					  0, 0, NULL);
+	kmip_node_free(uid);
+
+	return bench_request(KMIP_OPERATION_GET, pl);
+}
+
+static struct kmip_node *bench_get_response(void)
+{
+	struct kmip_node *material, *value, *block, *e[3];
+
+	material = kmip_new_raw_key(bench_key, sizeof(bench_key));
+	value = kmip_new_key_value(NULL, material, 0, NULL);
+	block = kmip_new_key_block(KMIP_KEY_FORMAT_TYPE_RAW, 0, value,
+				   KMIP_CRYPTO_ALGO_AES, 512, NULL);
+	e[0] = kmip_new_object_type(KMIP_OBJECT_TYPE_SYMMETRIC_KEY);
+	e[1] = kmip_new_unique_identifier(BENCH_KEY_ID, 0, 0);
+	e[2] = kmip_new_symmetric_key(block);
+	kmip_node_free(material);
+	kmip_node_free(value);
+	kmip_node_free(block);
+
+	return bench_response(KMIP_OPERATION_GET,
+			      bench_structure(KMIP_TAG_RESPONSE_PAYLOAD,
+					      ARRAY_SIZE(e), e));
+}
+
+static const struct bench_msg bench_msgs[] = {
+	{ "Locate request", bench_locate_request },
+	{ "Locate response", bench_locate_response },
+	{ "GetAttributes request", bench_get_attrs_request },
+	{ "GetAttributes response", bench_get_attrs_response },
+	{ "Get request", bench_get_request },
+	{ "Get response", bench_get_response },
+};
+
+/*
+ * Build, encode, and free a message with the nodes allocated from the heap,
+ * or from an arena per message
+ */
+static int bench_build_encode(const struct bench_msg *msg, bool arena,
+			      unsigned int iterations, size_t *size)
+{
+	struct kmip_arena *a = NULL;
+	unsigned char *data;
+	struct kmip_node *node;
+	double start;
+	unsigned int i;
+	int rc;
+
+	start = bench_now();
+	for (i = 0; i < iterations; i++) {
+		if (arena) {
+			a = kmip_arena_new(0);
+			kmip_arena_use(a);
+		}
+		node = msg->build();
+		if (arena) {
+			kmip_arena_use(NULL);
+			kmip_arena_free(a);
+		}
+		if (node == NULL)
+			return -ENOMEM;
+		rc = kmip_encode_ttlv_buffer(node, &data, size, false);
+		kmip_node_free(node);
+		if (rc != 0)
+			return rc;
+		free(data);
+	}
+	printf("  %-22s build+encode+free (%s): %8.0f ns\n", msg->name,
+	       arena ? "arena" : "heap ", (bench_now() - start) * 1e9 /
+	       iterations);
+	return 0;
+}
+
+/*
+ * Decode and free a message. Decoded nodes are always allocated from an arena.
+ */
+static int bench_decode(const struct bench_msg *msg, unsigned int iterations)
+{
+	struct kmip_buffer *buffer;
+	struct kmip_node *node;
+	double start;
+	unsigned char *data;
+	unsigned int i;
+	size_t size;
+	int rc;
+
+	node = msg->build();
+	if (node == NULL)
+		return -ENOMEM;
+	rc = kmip_encode_ttlv_buffer(node, &data, &size, false);
+	kmip_node_free(node);
+	if (rc != 0)
+		return rc;
+
+	buffer = kmip_buffer_new(size);
+	if (buffer == NULL) {
+		free(data);
+		return -ENOMEM;
+	}
+	memcpy(buffer->data, data, size);
+	free(data);
+
+	start = bench_now();
+	for (i = 0; i < iterations; i++) {
+		rc = kmip_decode_ttlv_buffer(buffer, &node, false);
+		if (rc != 0)
+			break;
+		kmip_node_free(node);
+	}
+	kmip_buffer_free(buffer);
+	if (rc != 0)
+		return rc;
+
+	printf("  %-22s decode+free (arena):       %8.0f ns\n", msg->name,
+	       (bench_now() - start) * 1e9 / iterations);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int iterations = BENCH_DEFAULT_ITERATIONS;
+	size_t size;
+	unsigned int i;
+	int rc;
+
+	if (argc > 1)
+		iterations = strtoul(argv[1], NULL, 10);
+	if (iterations == 0) {
+		fprintf(stderr, "Usage: %s [ITERATIONS]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	printf("%u iterations per message\n", iterations);
+	for (i = 0; i < ARRAY_SIZE(bench_msgs); i++) {
+		rc = bench_build_encode(&bench_msgs[i], false, iterations,
+					&size);
+		if (rc == 0)
+			rc = bench_build_encode(&bench_msgs[i], true,
+						iterations, &size);
+		if (rc == 0)
+			rc = bench_decode(&bench_msgs[i], iterations);
+		if (rc != 0) {
+			fprintf(stderr, "%s failed: %s\n", bench_msgs[i].name,
+				strerror(-rc));
+			return EXIT_FAILURE;
+		}
+		printf("  %-22s %lu bytes\n", bench_msgs[i].name, size);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,795 @@
+/*
+ * libkmipclient - KMIP client library
+ *
+ * Load generator for KMIP servers
+ *
+ * Sends requests of one kind to a KMIP server for a given time, and reports
+ * the operations per second and the latency percentiles of the requests. The
+ * requests are sent in one of the following modes:
+ *   sync:    each thread uses a connection of its own and sends one request
+ *            after the other with kmip_connection_perform().
+ *   batched: like sync, but each request message contains several batch
+ *            items.
+ *   pooled:  the threads share a connection pool with fewer connections than
+ *            threads.
+ *   async:   one thread keeps several requests outstanding with the
+ *            asynchronous API, pipelined on the connections of a pool.
+ *
+ * Before the measurement, a number of keys is created on the server, the Get,
+ * Get Attributes, and Locate requests refer to these keys. Use together with
+ * kmip_server for tests without a KMIP appliance. Not installed, build with
+ * 'make kmip_load'.
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include <openssl/pem.h>
+
+#include "lib/zt_common.h"
+
+#include "kmip.h"
+
+#define LOAD_DEFAULT_THREADS		4
+#define LOAD_DEFAULT_DURATION		10
+#define LOAD_DEFAULT_BATCH_SIZE		8
+#define LOAD_DEFAULT_PIPELINE_DEPTH	4
+#define LOAD_DEFAULT_KEYS		16
+#define LOAD_KEY_NAME			"kmip-load-key"
+
+enum load_mode {
+	LOAD_MODE_SYNC,
+	LOAD_MODE_BATCHED,
+	LOAD_MODE_POOLED,
+	LOAD_MODE_ASYNC,
+};
+
+static const char *const load_mode_names[] = {
+	[LOAD_MODE_SYNC] = "sync",
+	[LOAD_MODE_BATCHED] = "batched",
+	[LOAD_MODE_POOLED] = "pooled",
+	[LOAD_MODE_ASYNC] = "async",
+};
+
+struct load_op {
+	const char *name;
+	enum kmip_operation operation;
+};
+
+static const struct load_op load_ops[] = {
+	{ "get", KMIP_OPERATION_GET },
+	{ "get-attributes", KMIP_OPERATION_GET_ATTRIBUTES },
+	{ "locate", KMIP_OPERATION_LOCATE },
+	{ "create", KMIP_OPERATION_CREATE },
+};
+
+struct load {
+	struct kmip_conn_config config;
+	enum load_mode mode;
+	const struct load_op *op;
+	unsigned int threads;
+	unsigned int connections;
+	unsigned int batch_size;
+	unsigned int pipeline_depth;
+	unsigned int num_keys;
+	char **key_ids;
+	double end;
+	struct kmip_connection_pool *pool;
+	bool debug;
+};
+
+/* Latencies in microseconds */
+struct load_stats {
+	unsigned long ops;
+	unsigned long errors;
+	double *lat;
+	size_t num_lat;
+	size_t max_lat;
+};
+
+struct load_thread {
+	pthread_t tid;
+	struct load *load;
+	unsigned int index;
+	struct load_stats stats;
+	int rc;
+};
+
+/* An outstanding request of the async mode */
+struct load_async_req {
+	struct load *load;
+	struct load_stats *stats;
+	struct kmip_async *async;
+	double start;
+	unsigned int seq;
+};
+
+static double load_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int load_record(struct load_stats *stats, double start)
+{
+	double *lat;
+
+	if (stats->num_lat == stats->max_lat) {
+		stats->max_lat = stats->max_lat == 0 ? 4096 :
+							stats->max_lat * 2;
+		lat = realloc(stats->lat, stats->max_lat * sizeof(double));
+		if (lat == NULL)
+			return -ENOMEM;
+		stats->lat = lat;
+	}
+	stats->lat[stats->num_lat++] = (load_now() - start) * 1e6;
+	return 0;
+}
+
+static struct kmip_node *load_new_key_name(unsigned int seq)
+{
+	char name[64];
+
+	sprintf(name, "%s-%u", LOAD_KEY_NAME, seq);
+	return kmip_new_name(name, KMIP_NAME_TYPE_UNINTERPRETED_TEXT_STRING);
+}
+
+/*
+ * Build the request payload of the operation to measure. The sequence number
+ * selects the key to refer to, or the name of the key to create.
+ */
+static struct kmip_node *load_new_payload(struct load *load,
+					  enum kmip_operation operation,
+					  unsigned int seq)
+{
+	struct kmip_node *uid = NULL, *attrs[3], *pl = NULL;
+	unsigned int i;
+
+	switch (operation) {
+	case KMIP_OPERATION_GET:
+		uid = kmip_new_unique_identifier(
+				load->key_ids[seq % load->num_keys], 0, 0);
+		pl = kmip_new_get_request_payload(NULL, uid,
+						  KMIP_KEY_FORMAT_TYPE_RAW,
+						  0, 0, NULL);
+		break;
+	case KMIP_OPERATION_GET_ATTRIBUTES:
+		uid = kmip_new_unique_identifier(
+				load->key_ids[seq % load->num_keys], 0, 0);
+		pl = kmip_new_get_attributes_request_payload(NULL, uid, 0,
+							     NULL);
+		break;
+	case KMIP_OPERATION_LOCATE:
+		attrs[0] = kmip_new_name(LOAD_KEY_NAME "-*",
+				KMIP_NAME_TYPE_UNINTERPRETED_TEXT_STRING);
+		attrs[1] = kmip_new_object_type(
+					KMIP_OBJECT_TYPE_SYMMETRIC_KEY);
+		pl = kmip_new_locate_request_payload(NULL, 0, 0, 0, 0, 2,
+						     attrs);
+		for (i = 0; i < 2; i++)
+			kmip_node_free(attrs[i]);
+		break;
+	case KMIP_OPERATION_CREATE:
+		attrs[0] = kmip_new_cryptographic_algorithm(
+						KMIP_CRYPTO_ALGO_AES);
+		attrs[1] = kmip_new_cryptographic_length(256);
+		attrs[2] = load_new_key_name(seq);
+		pl = kmip_new_create_request_payload(NULL,
+					KMIP_OBJECT_TYPE_SYMMETRIC_KEY,
+					NULL, 3, attrs);
+		for (i = 0; i < 3; i++)
+			kmip_node_free(attrs[i]);
+		break;
+	default:
+		break;
+	}
+
+	kmip_node_free(uid);
+	return pl;
+}
+
+static struct kmip_node *load_new_request(struct load *load,
+					  enum kmip_operation operation,
+					  unsigned int count, unsigned int seq)
+{
+	struct kmip_node *hdr, *req = NULL, **bi;
+	struct kmip_node *pl;
+	unsigned int i;
+
+	bi = calloc(count, sizeof(struct kmip_node *));
+	if (bi == NULL)
+		return NULL;
+
+	hdr = kmip_new_request_header(NULL, 0, NULL, NULL, false, NULL, 0,
+				      true, count);
+	for (i = 0; i < count; i++) {
+		pl = load_new_payload(load, operation, seq + i);
+		bi[i] = kmip_new_request_batch_item(operation, NULL, 0, pl);
+		kmip_node_free(pl);
+		if (bi[i] == NULL)
+			goto out;
+	}
+	req = kmip_new_request(hdr, count, bi);
+
+out:
+	for (i = 0; i < count; i++)
+		kmip_node_free(bi[i]);
+	free(bi);
+	kmip_node_free(hdr);
+	return req;
+}
+
+/*
+ * Check the result of each batch item of a response. Optionally returns the
+ * response payload of the first batch item.
+ */
+static int load_check_response(struct load *load, struct kmip_node *resp,
+			       unsigned int count, struct kmip_node **payload)
+{
+	enum kmip_result_status status = 0;
+	enum kmip_result_reason reason = 0;
+	const char *message = NULL;
+	struct kmip_node *bi;
+	unsigned int i;
+	int rc = 0;
+
+	for (i = 0; i < count && rc == 0; i++) {
+		rc = kmip_get_response(resp, NULL, i, &bi);
+		if (rc != 0)
+			break;
+
+		rc = kmip_get_response_batch_item(bi, NULL, NULL, NULL,
+						  &status, &reason, &message,
+						  NULL, NULL,
+						  i == 0 ? payload : NULL);
+		kmip_node_free(bi);
+		if (rc == 0 && status != KMIP_RESULT_STATUS_SUCCESS) {
+			if (load->debug)
+				fprintf(stderr, "Operation failed: reason %u: "
+					"%s\n", reason,
+					message != NULL ? message : "");
+			rc = -EIO;
+		}
+	}
+
+	if (rc != 0 && payload != NULL) {
+		kmip_node_free(*payload);
+		*payload = NULL;
+	}
+	return rc;
+}
+
+static int load_perform(struct load *load, struct kmip_connection *conn,
+			enum kmip_operation operation, unsigned int count,
+			unsigned int seq, struct kmip_node **payload)
+{
+	struct kmip_node *req, *resp = NULL;
+	int rc;
+
+	req = load_new_request(load, operation, count, seq);
+	if (req == NULL)
+		return -ENOMEM;
+
+	rc = kmip_connection_perform(conn, req, &resp, load->debug);
+	kmip_node_free(req);
+	if (rc != 0)
+		return rc;
+
+	rc = load_check_response(load, resp, count, payload);
+	kmip_node_free(resp);
+	return rc;
+}
+
+/*
+ * Create the keys the requests refer to
+ */
+static int load_setup_keys(struct load *load)
+{
+	struct kmip_connection *conn;
+	struct kmip_node *pl, *uid;
+	const char *text_id;
+	unsigned int i;
+	int rc;
+
+	rc = kmip_connection_new(&load->config, &conn, load->debug);
+	if (rc != 0)
+		return rc;
+
+	load->key_ids = calloc(load->num_keys, sizeof(char *));
+	if (load->key_ids == NULL) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < load->num_keys; i++) {
+		rc = load_perform(load, conn, KMIP_OPERATION_CREATE, 1, i, &pl);
+		if (rc != 0)
+			goto out;
+
+		text_id = NULL;
+		rc = kmip_get_create_response_payload(pl, NULL, &uid, NULL, 0,
+						      NULL);
+		if (rc == 0)
+			rc = kmip_get_unique_identifier(uid, &text_id, NULL,
+							NULL);
+		if (rc == 0 && text_id != NULL)
+			load->key_ids[i] = strdup(text_id);
+		else if (rc == 0)
+			rc = -EBADMSG;
+		kmip_node_free(uid);
+		kmip_node_free(pl);
+		if (rc != 0)
+			goto out;
+	}
+
+out:
+	kmip_connection_free(conn);
+	return rc;
+}
+
+/*
+ * Thread function of the sync, batched, and pooled modes
+ */
+static void *load_thread_fn(void *arg)
+{
+	struct load_thread *t = arg;
+	struct load *load = t->load;
+	struct kmip_connection *conn = NULL;
+	unsigned int count, seq;
+	double start;
+	int rc;
+
+	count = load->mode == LOAD_MODE_BATCHED ? load->batch_size : 1;
+	seq = t->index * 1000000;
+
+	if (load->mode != LOAD_MODE_POOLED) {
+		t->rc = kmip_connection_new(&load->config, &conn, load->debug);
+		if (t->rc != 0)
+			return NULL;
+	}
+
+	while (load_now() < load->end) {
+		start = load_now();
+		if (load->mode == LOAD_MODE_POOLED) {
+			t->rc = kmip_connection_pool_get(load->pool, &conn,
+							 load->debug);
+			if (t->rc != 0)
+				break;
+		}
+
+		rc = load_perform(load, conn, load->op->operation, count, seq,
+				  NULL);
+		seq += count;
+
+		if (load->mode == LOAD_MODE_POOLED) {
+			kmip_connection_pool_put(load->pool, conn, rc != 0,
+						 load->debug);
+			conn = NULL;
+		}
+
+		if (rc != 0) {
+			t->stats.errors += count;
+			continue;
+		}
+		t->stats.ops += count;
+		t->rc = load_record(&t->stats, start);
+		if (t->rc != 0)
+			break;
+	}
+
+	kmip_connection_free(conn);
+	return NULL;
+}
+
+static void load_async_submit(struct load_async_req *r);
+
+static void load_async_cb(struct kmip_node *UNUSED(request),
+			  struct kmip_node *response, int rc, void *private)
+{
+	struct load_async_req *r = private;
+
+	if (rc == 0)
+		rc = load_check_response(r->load, response, 1, NULL);
+	if (rc == 0) {
+		r->stats->ops++;
+		load_record(r->stats, r->start);
+	} else {
+		r->stats->errors++;
+	}
+
+	/* Keep the request outstanding until the end of the measurement */
+	if (rc != -ECANCELED && load_now() < r->load->end)
+		load_async_submit(r);
+	else
+		free(r);
+}
+
+static void load_async_submit(struct load_async_req *r)
+{
+	struct kmip_node *req;
+
+	req = load_new_request(r->load, r->load->op->operation, 1, r->seq);
+	r->seq += r->load->pipeline_depth * r->load->connections;
+	r->start = load_now();
+	if (req == NULL ||
+	    kmip_async_submit(r->async, req, load_async_cb, r,
+			      r->load->debug) != 0) {
+		r->stats->errors++;
+		free(r);
+	}
+	kmip_node_free(req);
+}
+
+/*
+ * Run the async mode: keep pipeline_depth requests outstanding per connection
+ */
+static int load_run_async(struct load *load, struct load_stats *stats)
+{
+	struct load_async_req *r;
+	struct kmip_async *async;
+	unsigned int i;
+	int rc;
+
+	rc = kmip_async_new(load->pool, load->pipeline_depth, &async,
+			    load->debug);
+	if (rc != 0)
+		return rc;
+
+	for (i = 0; i < load->pipeline_depth * load->connections; i++) {
+		r = calloc(1, sizeof(struct load_async_req));
+		if (r == NULL) {
+			rc = -ENOMEM;
+			goto out;
+		}
+		r->load = load;
+		r->stats = stats;
+		r->async = async;
+		r->seq = i;
+		load_async_submit(r);
+	}
+
+	rc = kmip_async_wait(async, load->debug);
+
+out:
+	kmip_async_free(async, load->debug);
+	return rc;
+}
+
+static int load_cmp_double(const void *a, const void *b)
+{
+	double da = *(const double *)a, db = *(const double *)b;
+
+	return da < db ? -1 : da > db ? 1 : 0;
+}
+
+static double load_percentile(struct load_stats *stats, double p)
+{
+	if (stats->num_lat == 0)
+		return 0;
+	return stats->lat[(size_t)(p * (stats->num_lat - 1) + 0.5)];
+}
+
+/*
+ * Merge the statistics of a thread into the total
+ */
+static int load_merge(struct load_stats *total, struct load_stats *stats)
+{
+	double *lat;
+
+	total->ops += stats->ops;
+	total->errors += stats->errors;
+	if (stats->num_lat == 0)
+		return 0;
+
+	lat = realloc(total->lat,
+		      (total->num_lat + stats->num_lat) * sizeof(double));
+	if (lat == NULL)
+		return -ENOMEM;
+	total->lat = lat;
+	memcpy(total->lat + total->num_lat, stats->lat,
+	       stats->num_lat * sizeof(double));
+	total->num_lat += stats->num_lat;
+	return 0;
+}
+
+static void load_report(struct load *load, struct load_stats *total,
+			double elapsed)
+{
+	qsort(total->lat, total->num_lat, sizeof(double), load_cmp_double);
+
+	printf("Mode:        %s, %s", load_mode_names[load->mode],
+	       load->op->name);
+	switch (load->mode) {
+	case LOAD_MODE_SYNC:
+		printf(", %u threads\n", load->threads);
+		break;
+	case LOAD_MODE_BATCHED:
+		printf(", %u threads, %u items per request\n", load->threads,
+		       load->batch_size);
+		break;
+	case LOAD_MODE_POOLED:
+		printf(", %u threads, %u connections\n", load->threads,
+		       load->connections);
+		break;
+	case LOAD_MODE_ASYNC:
+		printf(", %u connections, pipeline depth %u\n",
+		       load->connections, load->pipeline_depth);
+		break;
+	}
+	printf("Operations:  %lu in %.1f s, %lu failed\n", total->ops, elapsed,
+	       total->errors);
+	printf("Throughput:  %.1f operations/s\n", total->ops / elapsed);
+	printf("Latency per request (us): p50 %.0f  p90 %.0f  p99 %.0f  "
+	       "max %.0f\n", load_percentile(total, 0.50),
+	       load_percentile(total, 0.90), load_percentile(total, 0.99),
+	       total->num_lat > 0 ? total->lat[total->num_lat - 1] : 0);
+}
+
+static void load_usage(const char *prg)
+{
+	printf("Usage: %s [OPTIONS] --server SERVER --cert FILE --key FILE\n\n"
+	       "Load generator for KMIP servers\n\n"
+	       "  -s, --server SERVER     'host:port' for Plain-TLS, or\n"
+	       "                          'https://host:port/uri' for HTTPS\n"
+	       "  -c, --cert FILE         Client certificate PEM file\n"
+	       "  -k, --key FILE          Client private key PEM file\n"
+	       "  -a, --ca FILE           CA certificate to verify the server.\n"
+	       "                          Default: the server is not verified\n"
+	       "  -e, --encoding ENC      'ttlv', 'json', or 'xml' (HTTPS only)\n"
+	       "                          Default: ttlv\n"
+	       "  -V, --kmip-version VER  KMIP protocol version, e.g. '1.2'\n"
+	       "  -m, --mode MODE         'sync', 'batched', 'pooled', or\n"
+	       "                          'async'. Default: sync\n"
+	       "  -o, --operation OP      'get', 'get-attributes', 'locate', or\n"
+	       "                          'create'. Default: get\n"
+	       "  -t, --threads NUM       Number of threads. Default: %u\n"
+	       "  -C, --connections NUM   Number of connections of the pool for\n"
+	       "                          the pooled and async modes.\n"
+	       "                          Default: half the number of threads\n"
+	       "  -b, --batch-size NUM    Batch items per request in batched\n"
+	       "                          mode. Default: %u\n"
+	       "  -p, --pipeline NUM      Outstanding requests per connection\n"
+	       "                          in async mode. Default: %u\n"
+	       "  -n, --keys NUM          Number of keys to create before the\n"
+	       "                          measurement. Default: %u\n"
+	       "  -d, --duration SEC      Duration of the measurement.\n"
+	       "                          Default: %u\n"
+	       "  -D, --debug             Print debug messages\n"
+	       "  -h, --help              Print this help, then exit\n",
+	       prg, LOAD_DEFAULT_THREADS, LOAD_DEFAULT_BATCH_SIZE,
+	       LOAD_DEFAULT_PIPELINE_DEPTH, LOAD_DEFAULT_KEYS,
+	       LOAD_DEFAULT_DURATION);
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option opts[] = {
+		{ "server", required_argument, NULL, 's' },
+		{ "cert", required_argument, NULL, 'c' },
+		{ "key", required_argument, NULL, 'k' },
+		{ "ca", required_argument, NULL, 'a' },
+		{ "encoding", required_argument, NULL, 'e' },
+		{ "kmip-version", required_argument, NULL, 'V' },
+		{ "mode", required_argument, NULL, 'm' },
+		{ "operation", required_argument, NULL, 'o' },
+		{ "threads", required_argument, NULL, 't' },
+		{ "connections", required_argument, NULL, 'C' },
+		{ "batch-size", required_argument, NULL, 'b' },
+		{ "pipeline", required_argument, NULL, 'p' },
+		{ "keys", required_argument, NULL, 'n' },
+		{ "duration", required_argument, NULL, 'd' },
+		{ "debug", no_argument, NULL, 'D' },
+		{ "help", no_argument, NULL, 'h' },
+		{ NULL, 0, NULL, 0 },
+	};
+	struct load load = {
+		.config.encoding = KMIP_ENCODING_TTLV,
+		.mode = LOAD_MODE_SYNC,
+		.op = &load_ops[0],
+		.threads = LOAD_DEFAULT_THREADS,
+		.batch_size = LOAD_DEFAULT_BATCH_SIZE,
+		.pipeline_depth = LOAD_DEFAULT_PIPELINE_DEPTH,
+		.num_keys = LOAD_DEFAULT_KEYS,
+	};
+	unsigned int i, duration = LOAD_DEFAULT_DURATION;
+	struct load_stats total = { 0 };
+	struct load_thread *threads = NULL;
+	struct kmip_version version;
+	const char *key_file = NULL;
+	int c, rc = 0, ret = EXIT_FAILURE;
+	double start;
+	FILE *fp;
+
+	while ((c = getopt_long(argc, argv, "s:c:k:a:e:V:m:o:t:C:b:p:n:d:Dh",
+				opts, NULL)) != -1) {
+		switch (c) {
+		case 's':
+			load.config.server = optarg;
+			break;
+		case 'c':
+			load.config.tls_client_cert = optarg;
+			break;
+		case 'k':
+			key_file = optarg;
+			break;
+		case 'a':
+			load.config.tls_ca = optarg;
+			load.config.tls_verify_peer = true;
+			break;
+		case 'e':
+			if (strcasecmp(optarg, "ttlv") == 0)
+				load.config.encoding = KMIP_ENCODING_TTLV;
+			else if (strcasecmp(optarg, "json") == 0)
+				load.config.encoding = KMIP_ENCODING_JSON;
+			else if (strcasecmp(optarg, "xml") == 0)
+				load.config.encoding = KMIP_ENCODING_XML;
+			else
+				goto invalid;
+			break;
+		case 'V':
+			if (sscanf(optarg, "%u.%u", &version.major,
+				   &version.minor) != 2)
+				goto invalid;
+			kmip_set_default_protocol_version(&version);
+			break;
+		case 'm':
+			for (i = 0; i < ARRAY_SIZE(load_mode_names); i++) {
+				if (strcasecmp(optarg, load_mode_names[i]) == 0)
+					break;
+			}
+			if (i == ARRAY_SIZE(load_mode_names))
+				goto invalid;
+			load.mode = i;
+			break;
+		case 'o':
+			for (i = 0; i < ARRAY_SIZE(load_ops); i++) {
+				if (strcasecmp(optarg, load_ops[i].name) == 0)
+					break;
+			}
+			if (i == ARRAY_SIZE(load_ops))
+				goto invalid;
+			load.op = &load_ops[i];
+			break;
+		case 't':
+			load.threads = strtoul(optarg, NULL, 10);
+			break;
+		case 'C':
+			load.connections = strtoul(optarg, NULL, 10);
+			break;
+		case 'b':
+			load.batch_size = strtoul(optarg, NULL, 10);
+			break;
+		case 'p':
+			load.pipeline_depth = strtoul(optarg, NULL, 10);
+			break;
+		case 'n':
+			load.num_keys = strtoul(optarg, NULL, 10);
+			break;
+		case 'd':
+			duration = strtoul(optarg, NULL, 10);
+			break;
+		case 'D':
+			load.debug = true;
+			break;
+		case 'h':
+			load_usage(argv[0]);
+			return EXIT_SUCCESS;
+		default:
+			load_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (load.config.server == NULL || load.config.tls_client_cert == NULL ||
+	    key_file == NULL) {
+		load_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (load.threads == 0 || load.batch_size == 0 ||
+	    load.pipeline_depth == 0 || load.num_keys == 0 || duration == 0) {
+		fprintf(stderr, "Numeric options must be greater than 0\n");
+		return EXIT_FAILURE;
+	}
+	if (load.connections == 0)
+		load.connections = MAX(load.threads / 2, 1U);
+	load.config.transport = strncmp(load.config.server, "https://", 8) == 0 ?
+			KMIP_TRANSPORT_HTTPS : KMIP_TRANSPORT_PLAIN_TLS;
+
+	fp = fopen(key_file, "r");
+	if (fp == NULL) {
+		perror(key_file);
+		return EXIT_FAILURE;
+	}
+	load.config.tls_client_key = PEM_read_PrivateKey(fp, NULL, NULL, NULL);
+	fclose(fp);
+	if (load.config.tls_client_key == NULL) {
+		fprintf(stderr, "Reading the client key failed\n");
+		return EXIT_FAILURE;
+	}
+
+	rc = load_setup_keys(&load);
+	if (rc != 0) {
+		fprintf(stderr, "Creating the keys failed: %s\n",
+			strerror(-rc));
+		goto out;
+	}
+
+	if (load.mode == LOAD_MODE_POOLED || load.mode == LOAD_MODE_ASYNC) {
+		rc = kmip_connection_pool_new(&load.config, load.connections,
+					      0, NULL, &load.pool, load.debug);
+		if (rc != 0) {
+			fprintf(stderr, "Creating the pool failed: %s\n",
+				strerror(-rc));
+			goto out;
+		}
+	}
+
+	start = load_now();
+	load.end = start + duration;
+
+	if (load.mode == LOAD_MODE_ASYNC) {
+		rc = load_run_async(&load, &total);
+	} else {
+		threads = calloc(load.threads, sizeof(struct load_thread));
+		if (threads == NULL) {
+			rc = -ENOMEM;
+			goto out;
+		}
+		for (i = 0; i < load.threads; i++) {
+			threads[i].load = &load;
+			threads[i].index = i;
+			if (pthread_create(&threads[i].tid, NULL,
+					   load_thread_fn, &threads[i]) != 0) {
+				/* Stop the threads already started */
+				load.end = 0;
+				load.threads = i;
+				rc = -EAGAIN;
+				break;
+			}
+		}
+		for (i = 0; i < load.threads; i++) {
+			pthread_join(threads[i].tid, NULL);
+			if (threads[i].rc != 0 && rc == 0)
+				rc = threads[i].rc;
+			if (load_merge(&total, &threads[i].stats) != 0 &&
+			    rc == 0)
+				rc = -ENOMEM;
+			free(threads[i].stats.lat);
+		}
+	}
+	if (rc != 0) {
+		fprintf(stderr, "Running the load failed: %s\n",
+			strerror(-rc));
+		goto out;
+	}
+
+	load_report(&load, &total, load_now() - start);
+	ret = EXIT_SUCCESS;
+
+out:
+	free(threads);
+	free(total.lat);
+	kmip_connection_pool_free(load.pool, load.debug);
+	for (i = 0; load.key_ids != NULL && i < load.num_keys; i++)
+		free(load.key_ids[i]);
+	free(load.key_ids);
+	EVP_PKEY_free(load.config.tls_client_key);
+	return ret;
+
+invalid:
+	fprintf(stderr, "Invalid value for option '-%c': %s\n", c, optarg);
+	return EXIT_FAILURE;
+}
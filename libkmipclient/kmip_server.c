@@ -0,0 +1,1775 @@
+/*
+ * libkmipclient - KMIP client library
+ *
+ * Local KMIP stand-in server for tests
+ *
+ * Serves KMIP requests over Plain-TLS (TTLV encoding), or over HTTPS (TTLV,
+ * JSON, or XML encoding, as indicated by the Content-Type of each request).
+ * The messages are encoded and decoded with the functions of the library.
+ * Managed objects are kept in memory only. The operations Discover Versions,
+ * Query, Create, Register, Activate, Get, Get Attributes, Add Attribute,
+ * Modify Attribute, Locate, and Destroy are supported, with the subset of
+ * their fields that is used by the clients of this library. Key wrapping is
+ * not supported, Get always returns the key material as is. An artificial
+ * latency can be added to each response.
+ *
+ * This is not a KMIP server for production use. Not installed, build with
+ * 'make kmip_server'.
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#include <errno.h>
+#include <fnmatch.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/rand.h>
+
+#include "lib/zt_common.h"
+
+#include "kmip.h"
+#include "utils.h"
+
+#define SRV_DEFAULT_TLS_PORT		5696
+#define SRV_DEFAULT_HTTPS_PORT		8443
+#define SRV_DEFAULT_KEY_LENGTH		256
+#define SRV_MAX_LINE			4096
+#define SRV_MAX_BODY			(16 * 1024 * 1024)
+#define SRV_VENDOR_ID			"s390-tools kmip_server"
+
+struct srv_object {
+	char uid[32];
+	enum kmip_object_type type;
+	struct kmip_node *object;
+	/* Attributes as KMIP v2.x attributes */
+	struct kmip_node **attrs;
+	unsigned int num_attrs;
+};
+
+struct srv {
+	enum kmip_transport transport;
+	SSL_CTX *ssl_ctx;
+	unsigned long latency_us;
+	bool debug;
+	pthread_mutex_t mutex;
+	/* Objects indexed by their numeric unique identifier */
+	struct srv_object **objects;
+	unsigned long num_objects;
+	/* Connections whose thread is still running, protected by mutex */
+	struct srv_conn *conns;
+	unsigned long num_conns;
+	pthread_cond_t conns_done;
+};
+
+struct srv_conn {
+	struct srv *srv;
+	struct srv_conn *prev;
+	struct srv_conn *next;
+	int fd;
+};
+
+/* Context of a request message */
+struct srv_ctx {
+	struct srv *srv;
+	struct kmip_version version;
+	char id_placeholder[32];
+};
+
+struct srv_result {
+	enum kmip_result_reason reason;
+	const char *message;
+};
+
+typedef int (*srv_op_t)(struct srv_ctx *ctx, struct kmip_node *req_pl,
+			struct kmip_node **resp_pl, struct srv_result *res);
+
+static const struct kmip_version srv_versions[] = {
+	{ .major = 2, .minor = 1 },
+	{ .major = 2, .minor = 0 },
+	{ .major = 1, .minor = 4 },
+	{ .major = 1, .minor = 3 },
+	{ .major = 1, .minor = 2 },
+	{ .major = 1, .minor = 1 },
+	{ .major = 1, .minor = 0 },
+};
+
+static volatile bool srv_stop;
+
+static void srv_fail(struct srv_result *res, enum kmip_result_reason reason,
+		     const char *message)
+{
+	res->reason = reason;
+	res->message = message;
+}
+
+/*
+ * Compare two nodes by tag, type, and value, including all elements of
+ * structures
+ */
+static bool srv_node_equal(const struct kmip_node *a,
+			   const struct kmip_node *b)
+{
+	const struct kmip_node *ea, *eb;
+
+	if (a->tag != b->tag || a->type != b->type)
+		return false;
+
+	switch (a->type) {
+	case KMIP_TYPE_STRUCTURE:
+		for (ea = a->structure_value, eb = b->structure_value;
+		     ea != NULL && eb != NULL; ea = ea->next, eb = eb->next) {
+			if (!srv_node_equal(ea, eb))
+				return false;
+		}
+		return ea == NULL && eb == NULL;
+	case KMIP_TYPE_INTEGER:
+		return a->integer_value == b->integer_value;
+	case KMIP_TYPE_LONG_INTEGER:
+		return a->long_value == b->long_value;
+	case KMIP_TYPE_BIG_INTEGER:
+		return BN_cmp(a->big_integer_value, b->big_integer_value) == 0;
+	case KMIP_TYPE_ENUMERATION:
+		return a->enumeration_value == b->enumeration_value;
+	case KMIP_TYPE_BOOLEAN:
+		return a->boolean_value == b->boolean_value;
+	case KMIP_TYPE_TEXT_STRING:
+		return strcmp(a->text_value, b->text_value) == 0;
+	case KMIP_TYPE_BYTE_STRING:
+		return a->length == b->length &&
+			memcmp(a->bytes_value, b->bytes_value, a->length) == 0;
+	case KMIP_TYPE_DATE_TIME:
+		return a->date_time_value == b->date_time_value;
+	case KMIP_TYPE_INTERVAL:
+		return a->interval_value == b->interval_value;
+	case KMIP_TYPE_DATE_TIME_EXTENDED:
+		return a->date_time_ext_value == b->date_time_ext_value;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Check if an attribute matches an attribute reference. A vendor attribute is
+ * referenced by its vendor identification and name, any other attribute by
+ * its tag.
+ */
+static bool srv_attr_is(const struct kmip_node *attr, enum kmip_tag tag,
+			const char *vendor_id, const char *name)
+{
+	const char *v = NULL, *n = NULL;
+
+	if (vendor_id == NULL)
+		return kmip_node_get_tag(attr) == tag;
+
+	if (kmip_get_vendor_attribute(attr, &v, &n, NULL) != 0)
+		return false;
+	return strcmp(v, vendor_id) == 0 && strcmp(n, name) == 0;
+}
+
+/*
+ * Check if two attributes are of the same kind, i.e. have the same tag, and
+ * for vendor attributes, the same vendor identification and name.
+ */
+static bool srv_attr_same(const struct kmip_node *a, const struct kmip_node *b)
+{
+	const char *vendor_id = NULL, *name = NULL;
+
+	if (kmip_get_vendor_attribute(b, &vendor_id, &name, NULL) != 0)
+		vendor_id = NULL;
+	return srv_attr_is(a, kmip_node_get_tag(b), vendor_id, name);
+}
+
+/*
+ * Check if an attribute matches a Locate filter attribute. Names are matched
+ * as shell wildcard patterns.
+ */
+static bool srv_attr_matches(const struct kmip_node *attr,
+			     const struct kmip_node *filter)
+{
+	const char *value, *pattern;
+
+	if (!srv_attr_same(attr, filter))
+		return false;
+
+	if (kmip_node_get_tag(filter) == KMIP_TAG_NAME) {
+		if (kmip_get_name(attr, &value, NULL) != 0 ||
+		    kmip_get_name(filter, &pattern, NULL) != 0)
+			return false;
+		return fnmatch(pattern, value, 0) == 0;
+	}
+
+	return srv_node_equal(attr, filter);
+}
+
+static void srv_object_free(struct srv_object *obj)
+{
+	unsigned int i;
+
+	if (obj == NULL)
+		return;
+
+	for (i = 0; i < obj->num_attrs; i++)
+		kmip_node_free(obj->attrs[i]);
+	free(obj->attrs);
+	kmip_node_free(obj->object);
+	free(obj);
+}
+
+/*
+ * Add an attribute to an object, or replace the first attribute of the same
+ * kind if replace is true. The attribute is cloned, so that it does not keep
+ * the request message alive.
+ */
+static int srv_object_set_attr(struct srv_object *obj, struct kmip_node *attr,
+			       bool replace)
+{
+	struct kmip_node *clone, **attrs;
+	unsigned int i;
+
+	clone = kmip_node_clone(attr);
+	if (clone == NULL)
+		return -ENOMEM;
+
+	for (i = 0; replace && i < obj->num_attrs; i++) {
+		if (!srv_attr_same(obj->attrs[i], clone))
+			continue;
+		kmip_node_free(obj->attrs[i]);
+		obj->attrs[i] = clone;
+		return 0;
+	}
+
+	attrs = realloc(obj->attrs,
+			(obj->num_attrs + 1) * sizeof(struct kmip_node *));
+	if (attrs == NULL) {
+		kmip_node_free(clone);
+		return -ENOMEM;
+	}
+	obj->attrs = attrs;
+	obj->attrs[obj->num_attrs++] = clone;
+	return 0;
+}
+
+/*
+ * Add the attributes of a request, and the attributes set by the server, to a
+ * new object
+ */
+static int srv_object_init_attrs(struct srv_object *obj,
+				 struct kmip_node *attrs)
+{
+	struct kmip_node *attr;
+	unsigned int i, num = 0;
+	int rc = 0;
+
+	if (attrs != NULL) {
+		rc = kmip_get_attributes(attrs, &num, 0, NULL);
+		if (rc != 0)
+			return rc;
+	}
+
+	for (i = 0; i < num; i++) {
+		rc = kmip_get_attributes(attrs, NULL, i, &attr);
+		if (rc != 0)
+			return rc;
+		rc = srv_object_set_attr(obj, attr, false);
+		kmip_node_free(attr);
+		if (rc != 0)
+			return rc;
+	}
+
+	attr = kmip_new_object_type(obj->type);
+	rc = attr != NULL ? srv_object_set_attr(obj, attr, true) : -ENOMEM;
+	kmip_node_free(attr);
+	if (rc != 0)
+		return rc;
+
+	attr = kmip_new_state(KMIP_STATE_PRE_ACTIVE);
+	rc = attr != NULL ? srv_object_set_attr(obj, attr, true) : -ENOMEM;
+	kmip_node_free(attr);
+	if (rc != 0)
+		return rc;
+
+	attr = kmip_node_new_date_time(KMIP_TAG_INITIAL_DATE, NULL,
+				       time(NULL));
+	rc = attr != NULL ? srv_object_set_attr(obj, attr, true) : -ENOMEM;
+	kmip_node_free(attr);
+	return rc;
+}
+
+/*
+ * Add a new object to the store and assign its unique identifier
+ */
+static int srv_store_add(struct srv *srv, struct srv_object *obj)
+{
+	struct srv_object **objects;
+
+	pthread_mutex_lock(&srv->mutex);
+	objects = realloc(srv->objects, (srv->num_objects + 1) *
+			  sizeof(struct srv_object *));
+	if (objects == NULL) {
+		pthread_mutex_unlock(&srv->mutex);
+		return -ENOMEM;
+	}
+	srv->objects = objects;
+	sprintf(obj->uid, "%lu", srv->num_objects);
+	srv->objects[srv->num_objects++] = obj;
+	pthread_mutex_unlock(&srv->mutex);
+
+	return 0;
+}
+
+/*
+ * Look up an object by its unique identifier. Must be called with the mutex
+ * of the store held.
+ */
+static struct srv_object *srv_store_find(struct srv *srv, const char *uid)
+{
+	unsigned long id;
+	char *end;
+
+	if (uid == NULL || *uid == '\0')
+		return NULL;
+
+	id = strtoul(uid, &end, 10);
+	if (*end != '\0' || id >= srv->num_objects)
+		return NULL;
+
+	return srv->objects[id];
+}
+
+/*
+ * Get the text unique identifier of a request payload, or the ID placeholder
+ * of the message if the payload does not contain a unique identifier
+ */
+static const char *srv_get_uid(struct srv_ctx *ctx, struct kmip_node *req_pl)
+{
+	enum kmip_unique_identifier enum_id = 0;
+	const char *text_id = NULL;
+	struct kmip_node *uid;
+	int32_t int_id = 0;
+
+	uid = kmip_node_get_structure_element_by_tag(req_pl,
+						KMIP_TAG_UNIQUE_IDENTIFIER, 0);
+	if (uid == NULL)
+		return ctx->id_placeholder;
+
+	kmip_get_unique_identifier(uid, &text_id, &enum_id, &int_id);
+	kmip_node_free(uid);
+	if (text_id == NULL)
+		return ctx->id_placeholder;
+
+	/* The text of the node lives as long as the request */
+	return text_id;
+}
+
+static struct kmip_node *srv_new_payload(unsigned int num_elements,
+					 struct kmip_node **elements)
+{
+	struct kmip_node *pl;
+	unsigned int i;
+
+	pl = kmip_node_new_structure(KMIP_TAG_RESPONSE_PAYLOAD, NULL,
+				     num_elements, elements);
+	for (i = 0; i < num_elements; i++)
+		kmip_node_free(elements[i]);
+	return pl;
+}
+
+static int srv_uid_payload(const char *uid, struct kmip_node *attr,
+			   struct kmip_node **resp_pl)
+{
+	struct kmip_node *e[2];
+
+	e[0] = kmip_new_unique_identifier(uid, 0, 0);
+	e[1] = attr != NULL ? kmip_node_clone(attr) : NULL;
+	*resp_pl = srv_new_payload(attr != NULL ? 2 : 1, e);
+	return *resp_pl != NULL ? 0 : -ENOMEM;
+}
+
+static int srv_op_discover_versions(struct srv_ctx *UNUSED(ctx),
+				    struct kmip_node *req_pl,
+				    struct kmip_node **resp_pl,
+				    struct srv_result *UNUSED(res))
+{
+	struct kmip_node *e[ARRAY_SIZE(srv_versions)], *n;
+	unsigned int i, k, num, count = 0;
+	struct kmip_version version;
+
+	num = kmip_node_get_structure_element_by_tag_count(req_pl,
+						KMIP_TAG_PROTOCOL_VERSION);
+	if (num == 0) {
+		for (i = 0; i < ARRAY_SIZE(srv_versions); i++)
+			e[count++] = kmip_new_protocol_version(
+							&srv_versions[i]);
+		goto out;
+	}
+
+	/* Return the supported versions in the order of the client */
+	for (i = 0; i < num && count < ARRAY_SIZE(e); i++) {
+		n = kmip_node_get_structure_element_by_tag(req_pl,
+					KMIP_TAG_PROTOCOL_VERSION, i);
+		if (kmip_get_protocol_version(n, &version) != 0) {
+			kmip_node_free(n);
+			continue;
+		}
+		kmip_node_free(n);
+
+		for (k = 0; k < ARRAY_SIZE(srv_versions); k++) {
+			if (srv_versions[k].major == version.major &&
+			    srv_versions[k].minor == version.minor)
+				break;
+		}
+		if (k < ARRAY_SIZE(srv_versions))
+			e[count++] = kmip_new_protocol_version(&version);
+	}
+
+out:
+	*resp_pl = srv_new_payload(count, e);
+	return *resp_pl != NULL ? 0 : -ENOMEM;
+}
+
+static const enum kmip_operation srv_query_ops[] = {
+	KMIP_OPERATION_CREATE,
+	KMIP_OPERATION_REGISTER,
+	KMIP_OPERATION_LOCATE,
+	KMIP_OPERATION_GET,
+	KMIP_OPERATION_GET_ATTRIBUTES,
+	KMIP_OPERATION_ADD_ATTRIBUTE,
+	KMIP_OPERATION_MODIFY_ATTRIBUTE,
+	KMIP_OPERATION_ACTIVATE,
+	KMIP_OPERATION_DESTROY,
+	KMIP_OPERATION_QUERY,
+	KMIP_OPERATION_DISCOVER_VERSIONS,
+};
+
+static int srv_op_query(struct srv_ctx *UNUSED(ctx),
+			struct kmip_node *UNUSED(req_pl),
+			struct kmip_node **resp_pl,
+			struct srv_result *UNUSED(res))
+{
+	struct kmip_node *e[ARRAY_SIZE(srv_query_ops) + 2];
+	unsigned int i, count = 0;
+
+	for (i = 0; i < ARRAY_SIZE(srv_query_ops); i++)
+		e[count++] = kmip_node_new_enumeration(KMIP_TAG_OPERATION,
+						       NULL, srv_query_ops[i]);
+	e[count++] = kmip_new_object_type(KMIP_OBJECT_TYPE_SYMMETRIC_KEY);
+	e[count++] = kmip_node_new_text_string(KMIP_TAG_VENDOR_IDENTIFICATION,
+					       NULL, SRV_VENDOR_ID);
+
+	*resp_pl = srv_new_payload(count, e);
+	return *resp_pl != NULL ? 0 : -ENOMEM;
+}
+
+static struct kmip_node *srv_get_attrs_node(struct kmip_node *req_pl)
+{
+	struct kmip_node *attrs;
+
+	attrs = kmip_node_get_structure_element_by_tag(req_pl,
+						KMIP_TAG_ATTRIBUTES, 0);
+	if (attrs == NULL)
+		attrs = kmip_node_get_structure_element_by_tag(req_pl,
+						KMIP_TAG_TEMPLATE_ATTRIBUTE, 0);
+	return attrs;
+}
+
+/*
+ * Generate the key material of a new symmetric key with the algorithm and
+ * length from its attributes
+ */
+static struct kmip_node *srv_new_symmetric_key(struct srv_object *obj)
+{
+	struct kmip_node *material = NULL, *value = NULL, *block = NULL;
+	enum kmip_crypto_algo algo = KMIP_CRYPTO_ALGO_AES;
+	int32_t length = SRV_DEFAULT_KEY_LENGTH;
+	struct kmip_node *key = NULL;
+	unsigned char *bytes;
+	unsigned int i;
+
+	for (i = 0; i < obj->num_attrs; i++) {
+		switch (kmip_node_get_tag(obj->attrs[i])) {
+		case KMIP_TAG_CRYPTOGRAPHIC_ALGORITHM:
+			kmip_get_cryptographic_algorithm(obj->attrs[i], &algo);
+			break;
+		case KMIP_TAG_CRYPTOGRAPHIC_LENGTH:
+			kmip_get_cryptographic_length(obj->attrs[i], &length);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (length <= 0 || length % 8 != 0)
+		return NULL;
+
+	bytes = malloc(length / 8);
+	if (bytes == NULL)
+		return NULL;
+	if (RAND_bytes(bytes, length / 8) != 1)
+		goto out;
+
+	material = kmip_new_raw_key(bytes, length / 8);
+	value = kmip_new_key_value(NULL, material, 0, NULL);
+	block = kmip_new_key_block(KMIP_KEY_FORMAT_TYPE_RAW, 0, value, algo,
+				   length, NULL);
+	key = kmip_new_symmetric_key(block);
+
+out:
+	OPENSSL_cleanse(bytes, length / 8);
+	free(bytes);
+	kmip_node_free(material);
+	kmip_node_free(value);
+	kmip_node_free(block);
+	return key;
+}
+
+/*
+ * Create or register an object. For Create, object is NULL and a symmetric
+ * key is generated.
+ */
+static int srv_new_object(struct srv_ctx *ctx, struct kmip_node *req_pl,
+			  struct kmip_node *object, struct srv_object **new,
+			  struct srv_result *res)
+{
+	struct kmip_node *type, *attrs;
+	struct srv_object *obj;
+	int rc;
+
+	obj = calloc(1, sizeof(struct srv_object));
+	if (obj == NULL)
+		return -ENOMEM;
+
+	type = kmip_node_get_structure_element_by_tag(req_pl,
+						KMIP_TAG_OBJECT_TYPE, 0);
+	if (type == NULL) {
+		srv_fail(res, KMIP_RESULT_REASON_MISSING_DATA,
+			 "Object Type is missing");
+		rc = -EBADMSG;
+		goto out;
+	}
+	kmip_get_object_type(type, &obj->type);
+	kmip_node_free(type);
+
+	attrs = srv_get_attrs_node(req_pl);
+	rc = srv_object_init_attrs(obj, attrs);
+	kmip_node_free(attrs);
+	if (rc != 0) {
+		srv_fail(res, KMIP_RESULT_REASON_INVALID_MESSAGE,
+			 "Attributes are invalid");
+		goto out;
+	}
+
+	if (object != NULL) {
+		obj->object = kmip_node_clone(object);
+	} else if (obj->type == KMIP_OBJECT_TYPE_SYMMETRIC_KEY) {
+		obj->object = srv_new_symmetric_key(obj);
+	} else {
+		srv_fail(res, KMIP_RESULT_REASON_FEATURE_NOT_SUPPORTED,
+			 "Only symmetric keys can be created");
+		rc = -EOPNOTSUPP;
+		goto out;
+	}
+	if (obj->object == NULL) {
+		srv_fail(res, KMIP_RESULT_REASON_CRYPTOGRAPHIC_FAILURE,
+			 "Creating the object failed");
+		rc = -EIO;
+		goto out;
+	}
+
+	rc = srv_store_add(ctx->srv, obj);
+	if (rc != 0)
+		goto out;
+
+	strcpy(ctx->id_placeholder, obj->uid);
+	*new = obj;
+
+out:
+	if (rc != 0)
+		srv_object_free(obj);
+	return rc;
+}
+
+static int srv_op_create(struct srv_ctx *ctx, struct kmip_node *req_pl,
+			 struct kmip_node **resp_pl, struct srv_result *res)
+{
+	struct srv_object *obj;
+	struct kmip_node *e[2];
+	int rc;
+
+	rc = srv_new_object(ctx, req_pl, NULL, &obj, res);
+	if (rc != 0)
+		return rc;
+
+	e[0] = kmip_new_object_type(obj->type);
+	e[1] = kmip_new_unique_identifier(obj->uid, 0, 0);
+	*resp_pl = srv_new_payload(2, e);
+	return *resp_pl != NULL ? 0 : -ENOMEM;
+}
+
+static int srv_op_register(struct srv_ctx *ctx, struct kmip_node *req_pl,
+			   struct kmip_node **resp_pl, struct srv_result *res)
+{
+	struct kmip_node *object = NULL, *n;
+	struct srv_object *obj;
+	unsigned int i;
+	int rc;
+
+	for (i = 0; object == NULL &&
+	     (n = kmip_node_get_structure_element_by_index(req_pl, i)) != NULL;
+	     i++) {
+		switch (kmip_node_get_tag(n)) {
+		case KMIP_TAG_CERTIFICATE:
+		case KMIP_TAG_OPAQUE_OBJECT:
+		case KMIP_TAG_PGP_KEY:
+		case KMIP_TAG_PRIVATE_KEY:
+		case KMIP_TAG_PUBLIC_KEY:
+		case KMIP_TAG_SECRET_DATA:
+		case KMIP_TAG_SYMMETRIC_KEY:
+			object = n;
+			break;
+		default:
+			kmip_node_free(n);
+			break;
+		}
+	}
+	if (object == NULL) {
+		srv_fail(res, KMIP_RESULT_REASON_MISSING_DATA,
+			 "Object is missing");
+		return -EBADMSG;
+	}
+
+	rc = srv_new_object(ctx, req_pl, object, &obj, res);
+	kmip_node_free(object);
+	if (rc != 0)
+		return rc;
+
+	return srv_uid_payload(obj->uid, NULL, resp_pl);
+}
+
+static int srv_op_activate(struct srv_ctx *ctx, struct kmip_node *req_pl,
+			   struct kmip_node **resp_pl, struct srv_result *res)
+{
+	const char *uid = srv_get_uid(ctx, req_pl);
+	struct kmip_node *state, *date;
+	struct srv_object *obj;
+	int rc;
+
+	state = kmip_new_state(KMIP_STATE_ACTIVE);
+	date = kmip_node_new_date_time(KMIP_TAG_ACTIVATION_DATE, NULL,
+				       time(NULL));
+	if (state == NULL || date == NULL) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	pthread_mutex_lock(&ctx->srv->mutex);
+	obj = srv_store_find(ctx->srv, uid);
+	if (obj == NULL) {
+		pthread_mutex_unlock(&ctx->srv->mutex);
+		srv_fail(res, KMIP_RESULT_REASON_ITEM_NOT_FOUND,
+			 "Object not found");
+		rc = -ENOENT;
+		goto out;
+	}
+	rc = srv_object_set_attr(obj, state, true);
+	if (rc == 0)
+		rc = srv_object_set_attr(obj, date, true);
+	pthread_mutex_unlock(&ctx->srv->mutex);
+	if (rc != 0)
+		goto out;
+
+	rc = srv_uid_payload(uid, NULL, resp_pl);
+
+out:
+	kmip_node_free(state);
+	kmip_node_free(date);
+	return rc;
+}
+
+static int srv_op_destroy(struct srv_ctx *ctx, struct kmip_node *req_pl,
+			  struct kmip_node **resp_pl, struct srv_result *res)
+{
+	const char *uid = srv_get_uid(ctx, req_pl);
+	struct srv_object *obj;
+
+	pthread_mutex_lock(&ctx->srv->mutex);
+	obj = srv_store_find(ctx->srv, uid);
+	if (obj != NULL)
+		ctx->srv->objects[strtoul(uid, NULL, 10)] = NULL;
+	pthread_mutex_unlock(&ctx->srv->mutex);
+
+	if (obj == NULL) {
+		srv_fail(res, KMIP_RESULT_REASON_ITEM_NOT_FOUND,
+			 "Object not found");
+		return -ENOENT;
+	}
+	srv_object_free(obj);
+
+	return srv_uid_payload(uid, NULL, resp_pl);
+}
+
+static int srv_op_get(struct srv_ctx *ctx, struct kmip_node *req_pl,
+		      struct kmip_node **resp_pl, struct srv_result *res)
+{
+	const char *uid = srv_get_uid(ctx, req_pl);
+	struct srv_object *obj;
+	struct kmip_node *e[3];
+
+	pthread_mutex_lock(&ctx->srv->mutex);
+	obj = srv_store_find(ctx->srv, uid);
+	if (obj == NULL) {
+		pthread_mutex_unlock(&ctx->srv->mutex);
+		srv_fail(res, KMIP_RESULT_REASON_ITEM_NOT_FOUND,
+			 "Object not found");
+		return -ENOENT;
+	}
+	e[0] = kmip_new_object_type(obj->type);
+	e[1] = kmip_new_unique_identifier(obj->uid, 0, 0);
+	/*
+	 * A node can be the element of one structure only, and concurrent
+	 * requests may return the same object, so the response gets a clone
+	 */
+	e[2] = kmip_node_clone(obj->object);
+	pthread_mutex_unlock(&ctx->srv->mutex);
+
+	*resp_pl = srv_new_payload(3, e);
+	return *resp_pl != NULL ? 0 : -ENOMEM;
+}
+
+/*
+ * Check if an attribute is selected by the attribute names (KMIP v1.x) or
+ * attribute references (KMIP v2.x) of a Get Attributes request payload. If
+ * there are none, all attributes are selected.
+ */
+static bool srv_attr_selected(struct kmip_node *req_pl,
+			      const struct kmip_node *attr)
+{
+	const char *vendor_id, *name;
+	struct kmip_node *ref, *n;
+	unsigned int i, num;
+	enum kmip_tag tag;
+	bool found = false;
+	bool v1;
+
+	num = kmip_node_get_structure_element_by_tag_count(req_pl,
+						KMIP_TAG_ATTRIBUTE_REFERENCE);
+	v1 = num == 0;
+	if (v1)
+		num = kmip_node_get_structure_element_by_tag_count(req_pl,
+						KMIP_TAG_ATTRIBUTE_NAME);
+	if (num == 0)
+		return true;
+
+	for (i = 0; i < num && !found; i++) {
+		n = kmip_node_get_structure_element_by_tag(req_pl,
+				v1 ? KMIP_TAG_ATTRIBUTE_NAME :
+				     KMIP_TAG_ATTRIBUTE_REFERENCE, i);
+		if (v1) {
+			if (kmip_get_attribute_name_v1(n, &ref) != 0)
+				ref = NULL;
+		} else {
+			ref = n;
+			kmip_node_upref(ref);
+		}
+		kmip_node_free(n);
+		if (ref == NULL)
+			continue;
+
+		vendor_id = NULL;
+		name = NULL;
+		if (kmip_get_attribute_reference(ref, &tag, &vendor_id,
+						 &name) == 0)
+			found = srv_attr_is(attr, tag, vendor_id, name);
+		kmip_node_free(ref);
+	}
+
+	return found;
+}
+
+static int srv_op_get_attributes(struct srv_ctx *ctx, struct kmip_node *req_pl,
+				 struct kmip_node **resp_pl,
+				 struct srv_result *res)
+{
+	const char *uid = srv_get_uid(ctx, req_pl);
+	struct kmip_node **attrs = NULL, **e = NULL;
+	unsigned int i, max, count = 0;
+	struct srv_object *obj;
+	int rc = 0;
+
+	pthread_mutex_lock(&ctx->srv->mutex);
+	obj = srv_store_find(ctx->srv, uid);
+	if (obj == NULL) {
+		pthread_mutex_unlock(&ctx->srv->mutex);
+		srv_fail(res, KMIP_RESULT_REASON_ITEM_NOT_FOUND,
+			 "Object not found");
+		return -ENOENT;
+	}
+	max = obj->num_attrs;
+	attrs = calloc(max + 1, sizeof(struct kmip_node *));
+	e = calloc(max + 2, sizeof(struct kmip_node *));
+	if (attrs == NULL || e == NULL) {
+		pthread_mutex_unlock(&ctx->srv->mutex);
+		rc = -ENOMEM;
+		goto out;
+	}
+	for (i = 0; i < obj->num_attrs; i++) {
+		if (!srv_attr_selected(req_pl, obj->attrs[i]))
+			continue;
+		attrs[count] = kmip_node_clone(obj->attrs[i]);
+		if (attrs[count] == NULL) {
+			pthread_mutex_unlock(&ctx->srv->mutex);
+			rc = -ENOMEM;
+			goto out;
+		}
+		count++;
+	}
+	pthread_mutex_unlock(&ctx->srv->mutex);
+
+	e[0] = kmip_new_unique_identifier(uid, 0, 0);
+	if (ctx->version.major == 1) {
+		/* KMIP v1.x: the attributes are returned one by one */
+		for (i = 0; i < count; i++) {
+			rc = kmip_v1_attr_from_v2_attr(attrs[i], &e[1 + i]);
+			if (rc != 0)
+				goto out;
+		}
+		*resp_pl = srv_new_payload(1 + count, e);
+	} else {
+		e[1] = kmip_new_attributes(&ctx->version, KMIP_TAG_ATTRIBUTES,
+					   count, attrs);
+		*resp_pl = srv_new_payload(2, e);
+	}
+	memset(e, 0, (max + 2) * sizeof(struct kmip_node *));
+	if (*resp_pl == NULL)
+		rc = -ENOMEM;
+
+out:
+	for (i = 0; attrs != NULL && i < count; i++)
+		kmip_node_free(attrs[i]);
+	for (i = 0; e != NULL && i < count + 1; i++)
+		kmip_node_free(e[i]);
+	free(attrs);
+	free(e);
+	return rc;
+}
+
+/*
+ * Add an attribute (Add Attribute), or replace it (Modify Attribute)
+ */
+static int srv_set_attribute(struct srv_ctx *ctx, struct kmip_node *req_pl,
+			     struct kmip_node **resp_pl,
+			     struct srv_result *res, bool replace)
+{
+	const char *uid = srv_get_uid(ctx, req_pl);
+	struct kmip_node *n, *attr = NULL, *v1_attr = NULL;
+	struct srv_object *obj;
+	int rc;
+
+	if (ctx->version.major == 1) {
+		v1_attr = kmip_node_get_structure_element_by_tag(req_pl,
+							KMIP_TAG_ATTRIBUTE, 0);
+		if (v1_attr != NULL &&
+		    kmip_v2_attr_from_v1_attr(v1_attr, &attr) != 0)
+			attr = NULL;
+	} else {
+		n = kmip_node_get_structure_element_by_tag(req_pl,
+						KMIP_TAG_NEW_ATTRIBUTE, 0);
+		attr = kmip_node_get_structure_element_by_index(n, 0);
+		kmip_node_free(n);
+	}
+	if (attr == NULL) {
+		srv_fail(res, KMIP_RESULT_REASON_MISSING_DATA,
+			 "Attribute is missing or invalid");
+		rc = -EBADMSG;
+		goto out;
+	}
+
+	pthread_mutex_lock(&ctx->srv->mutex);
+	obj = srv_store_find(ctx->srv, uid);
+	rc = obj != NULL ? srv_object_set_attr(obj, attr, replace) : -ENOENT;
+	pthread_mutex_unlock(&ctx->srv->mutex);
+	if (rc == -ENOENT) {
+		srv_fail(res, KMIP_RESULT_REASON_ITEM_NOT_FOUND,
+			 "Object not found");
+		goto out;
+	}
+	if (rc != 0)
+		goto out;
+
+	/* KMIP v1.x returns the attribute */
+	rc = srv_uid_payload(uid, v1_attr, resp_pl);
+
+out:
+	kmip_node_free(attr);
+	kmip_node_free(v1_attr);
+	return rc;
+}
+
+static int srv_op_add_attribute(struct srv_ctx *ctx, struct kmip_node *req_pl,
+				struct kmip_node **resp_pl,
+				struct srv_result *res)
+{
+	return srv_set_attribute(ctx, req_pl, resp_pl, res, false);
+}
+
+static int srv_op_modify_attribute(struct srv_ctx *ctx,
+				   struct kmip_node *req_pl,
+				   struct kmip_node **resp_pl,
+				   struct srv_result *res)
+{
+	return srv_set_attribute(ctx, req_pl, resp_pl, res, true);
+}
+
+/*
+ * Get the filter attributes of a Locate request payload as KMIP v2.x
+ * attributes
+ */
+static int srv_get_locate_filters(struct kmip_node *req_pl,
+				  struct kmip_node ***filters,
+				  unsigned int *num_filters)
+{
+	struct kmip_node *attrs, *v1_attr;
+	unsigned int i, num = 0;
+	bool v1 = false;
+	int rc = 0;
+
+	attrs = kmip_node_get_structure_element_by_tag(req_pl,
+						KMIP_TAG_ATTRIBUTES, 0);
+	if (attrs != NULL) {
+		rc = kmip_get_attributes(attrs, &num, 0, NULL);
+	} else {
+		v1 = true;
+		num = kmip_node_get_structure_element_by_tag_count(req_pl,
+							KMIP_TAG_ATTRIBUTE);
+	}
+	if (rc != 0)
+		goto out;
+
+	*filters = calloc(num + 1, sizeof(struct kmip_node *));
+	if (*filters == NULL) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < num; i++) {
+		if (v1) {
+			v1_attr = kmip_node_get_structure_element_by_tag(req_pl,
+							KMIP_TAG_ATTRIBUTE, i);
+			rc = kmip_v2_attr_from_v1_attr(v1_attr,
+						       &(*filters)[i]);
+			kmip_node_free(v1_attr);
+		} else {
+			rc = kmip_get_attributes(attrs, NULL, i,
+						 &(*filters)[i]);
+		}
+		if (rc != 0)
+			break;
+	}
+	*num_filters = i;
+
+out:
+	kmip_node_free(attrs);
+	return rc;
+}
+
+static int srv_op_locate(struct srv_ctx *ctx, struct kmip_node *req_pl,
+			 struct kmip_node **resp_pl, struct srv_result *res)
+{
+	unsigned int i, k, f, num_filters = 0, count = 0, located = 0;
+	struct kmip_node **filters = NULL, **e = NULL, *n;
+	int32_t max_items = 0, offset = 0;
+	struct srv_object *obj;
+	unsigned long id;
+	int rc;
+
+	rc = srv_get_locate_filters(req_pl, &filters, &num_filters);
+	if (rc != 0) {
+		srv_fail(res, KMIP_RESULT_REASON_INVALID_MESSAGE,
+			 "Attributes are invalid");
+		goto out;
+	}
+
+	n = kmip_node_get_structure_element_by_tag(req_pl,
+						   KMIP_TAG_MAXIMUM_ITEMS, 0);
+	if (n != NULL)
+		max_items = kmip_node_get_integer(n);
+	kmip_node_free(n);
+	n = kmip_node_get_structure_element_by_tag(req_pl,
+						   KMIP_TAG_OFFSET_ITEMS, 0);
+	if (n != NULL)
+		offset = kmip_node_get_integer(n);
+	kmip_node_free(n);
+
+	pthread_mutex_lock(&ctx->srv->mutex);
+	e = calloc(ctx->srv->num_objects + 1, sizeof(struct kmip_node *));
+	if (e == NULL) {
+		pthread_mutex_unlock(&ctx->srv->mutex);
+		rc = -ENOMEM;
+		goto out;
+	}
+	for (id = 0; id < ctx->srv->num_objects; id++) {
+		obj = ctx->srv->objects[id];
+		if (obj == NULL)
+			continue;
+
+		/* Each filter attribute must match one of the attributes */
+		for (f = 0; f < num_filters; f++) {
+			for (k = 0; k < obj->num_attrs; k++) {
+				if (srv_attr_matches(obj->attrs[k],
+						     filters[f]))
+					break;
+			}
+			if (k == obj->num_attrs)
+				break;
+		}
+		if (f < num_filters)
+			continue;
+
+		located++;
+		if (offset > 0) {
+			offset--;
+			continue;
+		}
+		if (max_items > 0 && (int32_t)count >= max_items)
+			continue;
+		e[1 + count++] = kmip_new_unique_identifier(obj->uid, 0, 0);
+	}
+	pthread_mutex_unlock(&ctx->srv->mutex);
+
+	/*
+	 * Located Items is available since KMIP v1.3, it is the number of all
+	 * matching objects, regardless of Maximum Items and Offset Items
+	 */
+	if (ctx->version.major > 1 || ctx->version.minor >= 3) {
+		e[0] = kmip_node_new_integer(KMIP_TAG_LOCATED_ITEMS, NULL,
+					     located);
+		*resp_pl = srv_new_payload(1 + count, e);
+	} else {
+		*resp_pl = srv_new_payload(count, e + 1);
+	}
+	if (*resp_pl == NULL)
+		rc = -ENOMEM;
+
+out:
+	for (i = 0; i < num_filters; i++)
+		kmip_node_free(filters[i]);
+	free(filters);
+	free(e);
+	return rc;
+}
+
+static srv_op_t srv_get_op(enum kmip_operation operation)
+{
+	switch (operation) {
+	case KMIP_OPERATION_DISCOVER_VERSIONS:
+		return srv_op_discover_versions;
+	case KMIP_OPERATION_QUERY:
+		return srv_op_query;
+	case KMIP_OPERATION_CREATE:
+		return srv_op_create;
+	case KMIP_OPERATION_REGISTER:
+		return srv_op_register;
+	case KMIP_OPERATION_ACTIVATE:
+		return srv_op_activate;
+	case KMIP_OPERATION_DESTROY:
+		return srv_op_destroy;
+	case KMIP_OPERATION_GET:
+		return srv_op_get;
+	case KMIP_OPERATION_GET_ATTRIBUTES:
+		return srv_op_get_attributes;
+	case KMIP_OPERATION_ADD_ATTRIBUTE:
+		return srv_op_add_attribute;
+	case KMIP_OPERATION_MODIFY_ATTRIBUTE:
+		return srv_op_modify_attribute;
+	case KMIP_OPERATION_LOCATE:
+		return srv_op_locate;
+	default:
+		return NULL;
+	}
+}
+
+/*
+ * Process a request batch item and build the response batch item
+ */
+static struct kmip_node *srv_process_batch_item(struct srv_ctx *ctx,
+						struct kmip_node *bi)
+{
+	struct kmip_node *op_node, *id, *req_pl, *resp_pl = NULL, *e[6];
+	struct srv_result res = { .reason = 0, .message = NULL };
+	enum kmip_operation operation = 0;
+	unsigned int count = 0, i;
+	struct kmip_node *resp;
+	srv_op_t op;
+	int rc;
+
+	op_node = kmip_node_get_structure_element_by_tag(bi,
+							 KMIP_TAG_OPERATION, 0);
+	if (op_node != NULL)
+		operation = kmip_node_get_enumeration(op_node);
+	kmip_node_free(op_node);
+	id = kmip_node_get_structure_element_by_tag(bi,
+					KMIP_TAG_UNIQUE_BATCH_ITEM_ID, 0);
+	req_pl = kmip_node_get_structure_element_by_tag(bi,
+					KMIP_TAG_REQUEST_PAYLOAD, 0);
+
+	op = srv_get_op(operation);
+	if (op == NULL) {
+		srv_fail(&res, KMIP_RESULT_REASON_OPERATION_NOT_SUCCESSFUL,
+			 "Operation not supported");
+		rc = -EOPNOTSUPP;
+	} else if (req_pl == NULL) {
+		srv_fail(&res, KMIP_RESULT_REASON_INVALID_MESSAGE,
+			 "Request Payload is missing");
+		rc = -EBADMSG;
+	} else {
+		rc = op(ctx, req_pl, &resp_pl, &res);
+	}
+	if (rc != 0 && res.reason == 0)
+		srv_fail(&res, KMIP_RESULT_REASON_GENERAL_FAILURE,
+			 strerror(-rc));
+
+	e[count++] = kmip_node_new_enumeration(KMIP_TAG_OPERATION, NULL,
+					       operation);
+	if (id != NULL)
+		e[count++] = kmip_node_clone(id);
+	e[count++] = kmip_node_new_enumeration(KMIP_TAG_RESULT_STATUS, NULL,
+				rc == 0 ? KMIP_RESULT_STATUS_SUCCESS :
+					  KMIP_RESULT_STATUS_OPERATION_FAILED);
+	if (rc != 0) {
+		e[count++] = kmip_node_new_enumeration(KMIP_TAG_RESULT_REASON,
+						       NULL, res.reason);
+		e[count++] = kmip_node_new_text_string(KMIP_TAG_RESULT_MESSAGE,
+						       NULL, res.message);
+	} else if (resp_pl != NULL) {
+		e[count++] = resp_pl;
+		resp_pl = NULL;
+	}
+
+	resp = kmip_node_new_structure(KMIP_TAG_BATCH_ITEM, NULL, count, e);
+
+	for (i = 0; i < count; i++)
+		kmip_node_free(e[i]);
+	kmip_node_free(resp_pl);
+	kmip_node_free(req_pl);
+	kmip_node_free(id);
+	return resp;
+}
+
+/*
+ * Process a request message and build the response message. The batch items
+ * are processed in order, so that a later item can refer to the object of an
+ * earlier one via the ID placeholder.
+ */
+static struct kmip_node *srv_process(struct srv *srv, struct kmip_node *req)
+{
+	struct kmip_node *hdr, *pv, *ts, *bc, *bi, **e = NULL, *resp = NULL;
+	struct srv_ctx ctx = { .srv = srv };
+	unsigned int i, num_items;
+
+	if (kmip_node_get_tag(req) != KMIP_TAG_REQUEST_MESSAGE)
+		return NULL;
+
+	hdr = kmip_node_get_structure_element_by_tag(req,
+						KMIP_TAG_REQUEST_HEADER, 0);
+	pv = kmip_node_get_structure_element_by_tag(hdr,
+						KMIP_TAG_PROTOCOL_VERSION, 0);
+	kmip_node_free(hdr);
+	if (pv == NULL || kmip_get_protocol_version(pv, &ctx.version) != 0) {
+		kmip_node_free(pv);
+		return NULL;
+	}
+
+	num_items = kmip_node_get_structure_element_by_tag_count(req,
+							KMIP_TAG_BATCH_ITEM);
+	e = calloc(num_items + 1, sizeof(struct kmip_node *));
+	if (e == NULL)
+		goto out;
+
+	ts = kmip_node_new_date_time(KMIP_TAG_TIME_STAMP, NULL, time(NULL));
+	bc = kmip_node_new_integer(KMIP_TAG_BATCH_COUNT, NULL, num_items);
+	kmip_node_free(pv);
+	pv = kmip_new_protocol_version(&ctx.version);
+	e[0] = kmip_node_new_structure_va(KMIP_TAG_RESPONSE_HEADER, NULL, 3,
+					  pv, ts, bc);
+	kmip_node_free(ts);
+	kmip_node_free(bc);
+	for (i = 0; i < num_items; i++) {
+		bi = kmip_node_get_structure_element_by_tag(req,
+						KMIP_TAG_BATCH_ITEM, i);
+		e[1 + i] = srv_process_batch_item(&ctx, bi);
+		kmip_node_free(bi);
+	}
+
+	resp = kmip_node_new_structure(KMIP_TAG_RESPONSE_MESSAGE, NULL,
+				       1 + num_items, e);
+
+out:
+	for (i = 0; e != NULL && i < 1 + num_items; i++)
+		kmip_node_free(e[i]);
+	free(e);
+	kmip_node_free(pv);
+	return resp;
+}
+
+static void srv_delay(struct srv *srv)
+{
+	struct timespec ts;
+
+	if (srv->latency_us == 0)
+		return;
+
+	ts.tv_sec = srv->latency_us / 1000000;
+	ts.tv_nsec = (srv->latency_us % 1000000) * 1000;
+	nanosleep(&ts, NULL);
+}
+
+/*
+ * Serve TTLV encoded requests over Plain-TLS until the client closes the
+ * connection
+ */
+static void srv_serve_tls(struct srv *srv, BIO *bio)
+{
+	struct kmip_node *req, *resp;
+	size_t size;
+	int rc;
+
+	while (!srv_stop) {
+		rc = kmip_decode_ttlv(bio, NULL, &req, srv->debug);
+		if (rc != 0)
+			break;
+
+		kmip_debug(srv->debug, "KMIP Request:");
+		kmip_node_dump(req, srv->debug);
+
+		resp = srv_process(srv, req);
+		kmip_node_free(req);
+		if (resp == NULL) {
+			kmip_debug(srv->debug, "Invalid request message");
+			break;
+		}
+
+		kmip_debug(srv->debug, "KMIP Response:");
+		kmip_node_dump(resp, srv->debug);
+
+		srv_delay(srv);
+		rc = kmip_encode_ttlv(resp, bio, &size, srv->debug);
+		kmip_node_free(resp);
+		if (rc != 0 || BIO_flush(bio) != 1)
+			break;
+	}
+}
+
+/*
+ * Decode the body of a HTTP request with the encoding indicated by its
+ * Content-Type
+ */
+static int srv_https_decode(struct srv *srv, enum kmip_encoding encoding,
+			    const char *body, size_t body_len,
+			    struct kmip_node **req)
+{
+	struct kmip_buffer *buffer;
+	json_object *obj;
+	xmlDoc *doc;
+	int rc;
+
+	switch (encoding) {
+	case KMIP_ENCODING_TTLV:
+		buffer = kmip_buffer_new(body_len);
+		if (buffer == NULL)
+			return -ENOMEM;
+		memcpy(buffer->data, body, body_len);
+		rc = kmip_decode_ttlv_buffer(buffer, req, srv->debug);
+		kmip_buffer_free(buffer);
+		return rc;
+
+	case KMIP_ENCODING_JSON:
+		obj = json_tokener_parse(body);
+		if (obj == NULL)
+			return -EBADMSG;
+		rc = kmip_decode_json(obj, NULL, req, srv->debug);
+		json_object_put(obj);
+		return rc;
+
+	case KMIP_ENCODING_XML:
+		doc = xmlReadMemory(body, body_len, NULL, "UTF-8",
+				    XML_PARSE_NONET);
+		if (doc == NULL)
+			return -EBADMSG;
+		rc = kmip_decode_xml(xmlDocGetRootElement(doc), NULL, req,
+				     srv->debug);
+		xmlFreeDoc(doc);
+		return rc;
+
+	default:
+		return -EINVAL;
+	}
+}
+
+/*
+ * Encode a response and send it as HTTP response
+ */
+static int srv_https_respond(struct srv *srv, BIO *bio,
+			     enum kmip_encoding encoding,
+			     struct kmip_node *resp)
+{
+	json_object *obj = NULL;
+	xmlNode *xml = NULL;
+	unsigned char *ttlv = NULL;
+	xmlChar *xml_buff = NULL;
+	const char *content_type, *data = NULL;
+	xmlDoc *doc = NULL;
+	size_t size = 0;
+	int xml_size, rc;
+
+	switch (encoding) {
+	case KMIP_ENCODING_TTLV:
+		content_type = "application/octet-stream";
+		rc = kmip_encode_ttlv_buffer(resp, &ttlv, &size, srv->debug);
+		data = (const char *)ttlv;
+		break;
+	case KMIP_ENCODING_JSON:
+		content_type = "application/json";
+		rc = kmip_encode_json(resp, &obj, srv->debug);
+		if (rc != 0)
+			break;
+		data = json_object_to_json_string_ext(obj,
+					JSON_C_TO_STRING_PLAIN |
+					JSON_C_TO_STRING_NOSLASHESCAPE);
+		size = data != NULL ? strlen(data) : 0;
+		break;
+	case KMIP_ENCODING_XML:
+		content_type = "text/xml";
+		rc = kmip_encode_xml(resp, &xml, srv->debug);
+		if (rc != 0)
+			break;
+		doc = xmlNewDoc((xmlChar *)"1.0");
+		if (doc == NULL) {
+			xmlFreeNode(xml);
+			rc = -ENOMEM;
+			break;
+		}
+		xmlDocSetRootElement(doc, xml);
+		xmlDocDumpFormatMemoryEnc(doc, &xml_buff, &xml_size, "UTF-8",
+					  0);
+		data = (const char *)xml_buff;
+		size = xml_buff != NULL ? xml_size : 0;
+		break;
+	default:
+		return -EINVAL;
+	}
+	if (rc == 0 && data == NULL)
+		rc = -EIO;
+	if (rc != 0)
+		goto out;
+
+	srv_delay(srv);
+	if (BIO_printf(bio, "HTTP/1.1 200 OK\r\nContent-Type: %s\r\n"
+		       "Content-Length: %lu\r\n\r\n", content_type, size) <= 0 ||
+	    BIO_write(bio, data, size) != (int)size || BIO_flush(bio) != 1)
+		rc = -EIO;
+
+out:
+	free(ttlv);
+	if (obj != NULL)
+		json_object_put(obj);
+	if (xml_buff != NULL)
+		xmlFree(xml_buff);
+	if (doc != NULL)
+		xmlFreeDoc(doc);
+	return rc;
+}
+
+/*
+ * Serve HTTP POST requests until the client closes the connection
+ */
+static void srv_serve_https(struct srv *srv, BIO *bio)
+{
+	enum kmip_encoding encoding;
+	struct kmip_node *req, *resp;
+	char line[SRV_MAX_LINE];
+	size_t body_len, ofs;
+	char *body, *p;
+	bool close;
+	int len, rc;
+
+	while (!srv_stop) {
+		/* Request line */
+		if (BIO_gets(bio, line, sizeof(line)) <= 0)
+			break;
+		if (strncmp(line, "POST ", 5) != 0) {
+			BIO_puts(bio, "HTTP/1.1 405 Method Not Allowed\r\n"
+				 "Content-Length: 0\r\nConnection: close\r\n\r\n");
+			BIO_flush(bio);
+			break;
+		}
+
+		encoding = KMIP_ENCODING_TTLV;
+		body_len = 0;
+		close = false;
+		while ((len = BIO_gets(bio, line, sizeof(line))) > 0) {
+			if (strcmp(line, "\r\n") == 0 || strcmp(line, "\n") == 0)
+				break;
+			p = strchr(line, ':');
+			if (p == NULL)
+				continue;
+			for (p++; *p == ' '; p++)
+				;
+			if (strncasecmp(line, "Content-Length:", 15) == 0)
+				body_len = strtoul(p, NULL, 10);
+			else if (strncasecmp(line, "Content-Type:", 13) == 0 &&
+				 strncasecmp(p, "application/json", 16) == 0)
+				encoding = KMIP_ENCODING_JSON;
+			else if (strncasecmp(line, "Content-Type:", 13) == 0 &&
+				 strncasecmp(p, "text/xml", 8) == 0)
+				encoding = KMIP_ENCODING_XML;
+			else if (strncasecmp(line, "Connection:", 11) == 0 &&
+				 strncasecmp(p, "close", 5) == 0)
+				close = true;
+		}
+		if (len <= 0 || body_len == 0 || body_len > SRV_MAX_BODY)
+			break;
+
+		body = malloc(body_len + 1);
+		if (body == NULL)
+			break;
+		for (ofs = 0; ofs < body_len; ofs += len) {
+			len = BIO_read(bio, body + ofs, body_len - ofs);
+			if (len <= 0)
+				break;
+		}
+		body[ofs] = '\0';
+		if (ofs < body_len) {
+			free(body);
+			break;
+		}
+
+		rc = srv_https_decode(srv, encoding, body, body_len, &req);
+		free(body);
+		if (rc != 0) {
+			kmip_debug(srv->debug, "Decoding the request failed");
+			BIO_puts(bio, "HTTP/1.1 400 Bad Request\r\n"
+				 "Content-Length: 0\r\n\r\n");
+			BIO_flush(bio);
+			continue;
+		}
+
+		kmip_debug(srv->debug, "KMIP Request:");
+		kmip_node_dump(req, srv->debug);
+
+		resp = srv_process(srv, req);
+		kmip_node_free(req);
+		if (resp == NULL) {
+			BIO_puts(bio, "HTTP/1.1 400 Bad Request\r\n"
+				 "Content-Length: 0\r\n\r\n");
+			BIO_flush(bio);
+			continue;
+		}
+
+		kmip_debug(srv->debug, "KMIP Response:");
+		kmip_node_dump(resp, srv->debug);
+
+		rc = srv_https_respond(srv, bio, encoding, resp);
+		kmip_node_free(resp);
+		if (rc != 0 || close)
+			break;
+	}
+}
+
+static void *srv_conn_thread(void *arg)
+{
+	struct srv_conn *conn = arg;
+	struct srv *srv = conn->srv;
+	BIO *bio = NULL, *ssl_bio;
+
+	ssl_bio = BIO_new_ssl(srv->ssl_ctx, 0);
+	if (ssl_bio == NULL) {
+		close(conn->fd);
+		goto out;
+	}
+	BIO_push(ssl_bio, BIO_new_socket(conn->fd, BIO_CLOSE));
+
+	bio = BIO_new(BIO_f_buffer());
+	if (bio == NULL) {
+		BIO_free_all(ssl_bio);
+		goto out;
+	}
+	BIO_push(bio, ssl_bio);
+
+	if (BIO_do_handshake(bio) != 1) {
+		kmip_debug(srv->debug, "TLS handshake failed");
+		if (srv->debug)
+			ERR_print_errors_fp(stderr);
+		goto out;
+	}
+
+	if (srv->transport == KMIP_TRANSPORT_HTTPS)
+		srv_serve_https(srv, bio);
+	else
+		srv_serve_tls(srv, bio);
+
+out:
+	/* Unlink first, so that the socket is not shut down after its close */
+	pthread_mutex_lock(&srv->mutex);
+	if (conn->prev != NULL)
+		conn->prev->next = conn->next;
+	else
+		srv->conns = conn->next;
+	if (conn->next != NULL)
+		conn->next->prev = conn->prev;
+	pthread_mutex_unlock(&srv->mutex);
+
+	if (bio != NULL)
+		BIO_free_all(bio);
+	free(conn);
+
+	pthread_mutex_lock(&srv->mutex);
+	if (--srv->num_conns == 0)
+		pthread_cond_signal(&srv->conns_done);
+	pthread_mutex_unlock(&srv->mutex);
+	return NULL;
+}
+
+/*
+ * Accept TLS certificates of any client, the client certificate is only
+ * requested to exercise the TLS handshake of the client.
+ */
+static int srv_verify_cb(int UNUSED(preverify_ok),
+			 X509_STORE_CTX *UNUSED(ctx))
+{
+	return 1;
+}
+
+static SSL_CTX *srv_new_ssl_ctx(const char *cert, const char *key)
+{
+	static const unsigned char sid_ctx[] = "kmip_server";
+	SSL_CTX *ctx;
+
+	ctx = SSL_CTX_new(TLS_server_method());
+	if (ctx == NULL)
+		return NULL;
+
+	if (SSL_CTX_use_certificate_chain_file(ctx, cert) != 1 ||
+	    SSL_CTX_use_PrivateKey_file(ctx, key, SSL_FILETYPE_PEM) != 1 ||
+	    SSL_CTX_check_private_key(ctx) != 1) {
+		ERR_print_errors_fp(stderr);
+		SSL_CTX_free(ctx);
+		return NULL;
+	}
+
+	SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, srv_verify_cb);
+	/* Required for session resumption with client certificates */
+	SSL_CTX_set_session_id_context(ctx, sid_ctx, sizeof(sid_ctx) - 1);
+	SSL_CTX_set_mode(ctx, SSL_MODE_AUTO_RETRY);
+
+	return ctx;
+}
+
+static void srv_signal_handler(int UNUSED(sig))
+{
+	srv_stop = true;
+}
+
+static void srv_usage(const char *prg)
+{
+	printf("Usage: %s [OPTIONS] --cert FILE --key FILE\n\n"
+	       "Local KMIP stand-in server for tests\n\n"
+	       "  -c, --cert FILE       Server certificate PEM file\n"
+	       "  -k, --key FILE        Server private key PEM file\n"
+	       "  -t, --transport TYPE  'tls' (Plain-TLS, TTLV encoding) or\n"
+	       "                        'https' (TTLV, JSON, or XML encoding)\n"
+	       "                        Default: tls\n"
+	       "  -p, --port PORT       Port to listen on. Default: %u for\n"
+	       "                        'tls', %u for 'https'\n"
+	       "  -l, --latency MSEC    Artificial latency added to each\n"
+	       "                        response. Default: 0\n"
+	       "  -d, --debug           Print debug messages\n"
+	       "  -h, --help            Print this help, then exit\n",
+	       prg, SRV_DEFAULT_TLS_PORT, SRV_DEFAULT_HTTPS_PORT);
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option opts[] = {
+		{ "cert", required_argument, NULL, 'c' },
+		{ "key", required_argument, NULL, 'k' },
+		{ "transport", required_argument, NULL, 't' },
+		{ "port", required_argument, NULL, 'p' },
+		{ "latency", required_argument, NULL, 'l' },
+		{ "debug", no_argument, NULL, 'd' },
+		{ "help", no_argument, NULL, 'h' },
+		{ NULL, 0, NULL, 0 },
+	};
+	struct srv srv = { .transport = KMIP_TRANSPORT_PLAIN_TLS };
+	const char *cert = NULL, *key = NULL;
+	struct sockaddr_in addr = { 0 };
+	struct sigaction sa = { 0 };
+	sigset_t stop_set, old_set;
+	struct srv_conn *conn;
+	unsigned long id;
+	int c, fd, rc, one = 1;
+	long port = 0;
+	pthread_t tid;
+
+	while ((c = getopt_long(argc, argv, "c:k:t:p:l:dh", opts,
+				NULL)) != -1) {
+		switch (c) {
+		case 'c':
+			cert = optarg;
+			break;
+		case 'k':
+			key = optarg;
+			break;
+		case 't':
+			if (strcasecmp(optarg, "tls") == 0) {
+				srv.transport = KMIP_TRANSPORT_PLAIN_TLS;
+			} else if (strcasecmp(optarg, "https") == 0) {
+				srv.transport = KMIP_TRANSPORT_HTTPS;
+			} else {
+				fprintf(stderr, "Invalid transport: %s\n",
+					optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'p':
+			port = strtol(optarg, NULL, 10);
+			if (port <= 0 || port > 65535) {
+				fprintf(stderr, "Invalid port: %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'l':
+			srv.latency_us = strtod(optarg, NULL) * 1000;
+			break;
+		case 'd':
+			srv.debug = true;
+			break;
+		case 'h':
+			srv_usage(argv[0]);
+			return EXIT_SUCCESS;
+		default:
+			srv_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (cert == NULL || key == NULL) {
+		srv_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (port == 0)
+		port = srv.transport == KMIP_TRANSPORT_HTTPS ?
+				SRV_DEFAULT_HTTPS_PORT : SRV_DEFAULT_TLS_PORT;
+
+	srv.ssl_ctx = srv_new_ssl_ctx(cert, key);
+	if (srv.ssl_ctx == NULL) {
+		fprintf(stderr, "Setting up the TLS context failed\n");
+		return EXIT_FAILURE;
+	}
+	pthread_mutex_init(&srv.mutex, NULL);
+	pthread_cond_init(&srv.conns_done, NULL);
+
+	signal(SIGPIPE, SIG_IGN);
+	sa.sa_handler = srv_signal_handler;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	sigemptyset(&stop_set);
+	sigaddset(&stop_set, SIGINT);
+	sigaddset(&stop_set, SIGTERM);
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		return EXIT_FAILURE;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+	    listen(fd, 64) != 0) {
+		perror("bind");
+		close(fd);
+		return EXIT_FAILURE;
+	}
+
+	printf("Listening on port %ld (%s)\n", port,
+	       srv.transport == KMIP_TRANSPORT_HTTPS ? "HTTPS" : "Plain-TLS");
+	fflush(stdout);
+
+	while (!srv_stop) {
+		c = accept(fd, NULL, NULL);
+		if (c < 0)
+			continue;
+		setsockopt(c, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		conn = calloc(1, sizeof(struct srv_conn));
+		if (conn == NULL) {
+			close(c);
+			continue;
+		}
+		conn->srv = &srv;
+		conn->fd = c;
+
+		pthread_mutex_lock(&srv.mutex);
+		conn->next = srv.conns;
+		if (srv.conns != NULL)
+			srv.conns->prev = conn;
+		srv.conns = conn;
+		srv.num_conns++;
+		pthread_mutex_unlock(&srv.mutex);
+
+		/*
+		 * The stop signals must interrupt accept() in this thread, so
+		 * block them in the connection threads
+		 */
+		pthread_sigmask(SIG_BLOCK, &stop_set, &old_set);
+		rc = pthread_create(&tid, NULL, srv_conn_thread, conn);
+		pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+		if (rc != 0) {
+			pthread_mutex_lock(&srv.mutex);
+			srv.conns = conn->next;
+			if (conn->next != NULL)
+				conn->next->prev = NULL;
+			srv.num_conns--;
+			pthread_mutex_unlock(&srv.mutex);
+			close(c);
+			free(conn);
+			continue;
+		}
+		pthread_detach(tid);
+	}
+
+	close(fd);
+
+	/*
+	 * Wake up the connection threads that wait for a request, and wait
+	 * until all of them are done before the object store is freed
+	 */
+	pthread_mutex_lock(&srv.mutex);
+	for (conn = srv.conns; conn != NULL; conn = conn->next)
+		shutdown(conn->fd, SHUT_RDWR);
+	while (srv.num_conns > 0)
+		pthread_cond_wait(&srv.conns_done, &srv.mutex);
+	pthread_mutex_unlock(&srv.mutex);
+	pthread_cond_destroy(&srv.conns_done);
+
+	SSL_CTX_free(srv.ssl_ctx);
+	for (id = 0; id < srv.num_objects; id++)
+		srv_object_free(srv.objects[id]);
+	free(srv.objects);
+
+	return EXIT_SUCCESS;
+}
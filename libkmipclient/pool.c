@@ -0,0 +1,538 @@
+/*
+ * libkmipclient - KMIP client library
+ *
+ * Connection pool with TLS session resumption
+ *
+ * A pool keeps idle connections to one KMIP server for reuse, so that
+ * subsequent requests do not need a new TCP connection and TLS handshake.
+ * For Plain-TLS connections, the last resumable TLS session can be stored in
+ * a session cache file, so that new connections, also from other processes,
+ * can use an abbreviated handshake.
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/pem.h>
+
+#include "kmip.h"
+#include "utils.h"
+
+#define KMIP_POOL_KEEPALIVE_IDLE	30
+#define KMIP_POOL_SESSION_HDR		"Server: "
+
+struct kmip_pool_entry {
+	struct kmip_connection *conn;
+	time_t last_used;
+	struct kmip_pool_entry *next;
+};
+
+struct kmip_connection_pool {
+	struct kmip_conn_config config;
+	unsigned int max_connections;
+	unsigned int idle_timeout;
+	char *session_cache;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	struct kmip_pool_entry *idle;
+	unsigned int num_connections;
+	SSL_SESSION *session;
+	bool session_saved;
+};
+
+/**
+ * Returns the monotonic time in seconds
+ */
+static time_t kmip_pool_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec;
+}
+
+/**
+ * Reads the TLS session from the session cache file. The session is only
+ * used if it was established with the same server and has not yet expired.
+ *
+ * @param pool              the connection pool
+ * @param debug             if true, debug messages are printed
+ */
+static void kmip_pool_load_session(struct kmip_connection_pool *pool,
+				   bool debug)
+{
+	char line[1024], *p;
+	SSL_SESSION *session;
+	FILE *fp;
+
+	fp = fopen(pool->session_cache, "r");
+	if (fp == NULL) {
+		kmip_debug(debug, "No TLS session cached in '%s': %s",
+			   pool->session_cache, strerror(errno));
+		return;
+	}
+
+	if (fgets(line, sizeof(line), fp) == NULL ||
+	    strncmp(line, KMIP_POOL_SESSION_HDR,
+		    strlen(KMIP_POOL_SESSION_HDR)) != 0) {
+		kmip_debug(debug, "Malformed session cache '%s'",
+			   pool->session_cache);
+		goto out;
+	}
+	p = line + strlen(KMIP_POOL_SESSION_HDR);
+	p[strcspn(p, "\n")] = 0;
+	if (strcmp(p, pool->config.server) != 0) {
+		kmip_debug(debug, "Cached TLS session is for server '%s'", p);
+		goto out;
+	}
+
+	session = PEM_read_SSL_SESSION(fp, NULL, NULL, NULL);
+	if (session == NULL) {
+		kmip_debug(debug, "PEM_read_SSL_SESSION failed: '%s'",
+			   pool->session_cache);
+		if (debug)
+			ERR_print_errors_fp(stderr);
+		goto out;
+	}
+
+	if (SSL_SESSION_is_resumable(session) != 1 ||
+	    SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) <=
+								time(NULL)) {
+		kmip_debug(debug, "Cached TLS session has expired");
+		SSL_SESSION_free(session);
+		goto out;
+	}
+
+	kmip_debug(debug, "Using cached TLS session from '%s'",
+		   pool->session_cache);
+	pool->session = session;
+	pool->session_saved = true;
+
+out:
+	fclose(fp);
+}
+
+/**
+ * Writes the TLS session to the session cache file. The session contains the
+ * secret to resume it, so the file is only accessible by the owner. The file
+ * is replaced atomically, so that concurrent readers see either the old or
+ * the new session.
+ *
+ * @param pool              the connection pool
+ * @param debug             if true, debug messages are printed
+ */
+static void kmip_pool_save_session(struct kmip_connection_pool *pool,
+				   bool debug)
+{
+	char *tmp = NULL;
+	FILE *fp = NULL;
+	int fd;
+
+	if (pool->session_cache == NULL || pool->session == NULL ||
+	    pool->session_saved)
+		return;
+
+	if (asprintf(&tmp, "%s-XXXXXX", pool->session_cache) < 0) {
+		kmip_debug(debug, "asprintf failed");
+		return;
+	}
+
+	/* mkstemp creates the file with mode 0600 */
+	fd = mkstemp(tmp);
+	if (fd < 0) {
+		kmip_debug(debug, "Failed to create '%s': %s", tmp,
+			   strerror(errno));
+		goto out;
+	}
+
+	fp = fdopen(fd, "w");
+	if (fp == NULL) {
+		close(fd);
+		goto err;
+	}
+
+	if (fprintf(fp, KMIP_POOL_SESSION_HDR "%s\n",
+		    pool->config.server) < 0)
+		goto err;
+	if (PEM_write_SSL_SESSION(fp, pool->session) != 1) {
+		kmip_debug(debug, "PEM_write_SSL_SESSION failed");
+		if (debug)
+			ERR_print_errors_fp(stderr);
+		goto err;
+	}
+	if (fclose(fp) != 0) {
+		fp = NULL;
+		goto err;
+	}
+	fp = NULL;
+
+	if (rename(tmp, pool->session_cache) != 0)
+		goto err;
+
+	kmip_debug(debug, "TLS session saved to '%s'", pool->session_cache);
+	pool->session_saved = true;
+	goto out;
+
+err:
+	kmip_debug(debug, "Failed to save the TLS session to '%s'",
+		   pool->session_cache);
+	if (fp != NULL)
+		fclose(fp);
+	unlink(tmp);
+out:
+	free(tmp);
+}
+
+/**
+ * Remembers the current TLS session of a connection for new connections
+ *
+ * @param pool              the connection pool. The mutex must be held.
+ * @param conn              the KMIP connection
+ */
+static void kmip_pool_update_session(struct kmip_connection_pool *pool,
+				     struct kmip_connection *conn)
+{
+	SSL_SESSION *session;
+
+	if (conn->config.transport != KMIP_TRANSPORT_PLAIN_TLS)
+		return;
+
+	session = kmip_connection_tls_get_session(conn);
+	if (session == NULL)
+		return;
+
+	if (session == pool->session) {
+		SSL_SESSION_free(session);
+		return;
+	}
+
+	if (pool->session != NULL)
+		SSL_SESSION_free(pool->session);
+	pool->session = session;
+	pool->session_saved = false;
+}
+
+/**
+ * Checks if an idle connection can be reused
+ *
+ * @param pool              the connection pool
+ * @param entry             the pool entry of the idle connection
+ * @param now               the current monotonic time in seconds
+ *
+ * @returns true if the connection can be reused
+ */
+static bool kmip_pool_entry_usable(struct kmip_connection_pool *pool,
+				   struct kmip_pool_entry *entry, time_t now)
+{
+	if (pool->idle_timeout != 0 &&
+	    now - entry->last_used >= (time_t)pool->idle_timeout)
+		return false;
+
+	switch (entry->conn->config.transport) {
+	case KMIP_TRANSPORT_PLAIN_TLS:
+		return kmip_connection_tls_is_alive(entry->conn);
+	default:
+		/* libcurl reconnects by itself when required */
+		return true;
+	}
+}
+
+/**
+ * Constructs a new pool of connections to a KMIP server. No connection is
+ * established until one is requested with kmip_connection_pool_get(). The
+ * configuration is copied as with kmip_connection_new().
+ *
+ * @param config            the connection configuration
+ * @param max_connections   the maximum number of connections, must be > 0.
+ *                          If all connections are in use,
+ *                          kmip_connection_pool_get() waits until one is
+ *                          returned to the pool.
+ * @param idle_timeout      the time in seconds after which an idle connection
+ *                          is closed instead of being reused. 0 means no
+ *                          timeout.
+ * @param session_cache     Optional: the name of a file to store the TLS
+ *                          session for resumption by other processes. Only
+ *                          used with Plain-TLS transport. Can be NULL.
+ * @param pool              On return: a newly allocated connection pool
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_connection_pool_new(const struct kmip_conn_config *config,
+			     unsigned int max_connections,
+			     unsigned int idle_timeout,
+			     const char *session_cache,
+			     struct kmip_connection_pool **pool,
+			     bool debug)
+{
+	struct kmip_connection_pool *p;
+	int rc;
+
+	if (config == NULL || pool == NULL || max_connections == 0)
+		return -EINVAL;
+	if (config->server == NULL || config->tls_client_key == NULL ||
+	    config->tls_client_cert == NULL)
+		return -EINVAL;
+
+	*pool = NULL;
+
+	p = calloc(1, sizeof(struct kmip_connection_pool));
+	if (p == NULL) {
+		kmip_debug(debug, "calloc failed");
+		return -ENOMEM;
+	}
+
+	rc = kmip_conn_config_copy(&p->config, config, debug);
+	if (rc != 0) {
+		free(p);
+		return rc;
+	}
+
+	p->max_connections = max_connections;
+	p->idle_timeout = idle_timeout;
+	pthread_mutex_init(&p->mutex, NULL);
+	pthread_cond_init(&p->cond, NULL);
+
+	if (session_cache != NULL &&
+	    config->transport == KMIP_TRANSPORT_PLAIN_TLS) {
+		p->session_cache = strdup(session_cache);
+		if (p->session_cache == NULL) {
+			kmip_debug(debug, "strdup failed");
+			kmip_connection_pool_free(p, debug);
+			return -ENOMEM;
+		}
+		kmip_pool_load_session(p, debug);
+	}
+
+	*pool = p;
+	return 0;
+}
+
+/**
+ * Checks out a connection from the pool. An idle connection is reused if
+ * possible, otherwise a new connection is established, resuming the last
+ * known TLS session.
+ *
+ * @param pool              the connection pool
+ * @param connection        On return: the KMIP connection
+ * @param wait              if true, waits until a connection is returned to
+ *                          the pool if all connections are in use
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, -EAGAIN if all connections are in use and
+ * wait is false, or a negative errno value
+ */
+static int kmip_pool_get(struct kmip_connection_pool *pool,
+			 struct kmip_connection **connection, bool wait,
+			 bool debug)
+{
+	struct kmip_pool_entry *entry;
+	SSL_SESSION *session;
+	time_t now;
+	int rc;
+
+	if (pool == NULL || connection == NULL)
+		return -EINVAL;
+
+	*connection = NULL;
+
+	pthread_mutex_lock(&pool->mutex);
+	while (1) {
+		/* The most recently used connection is most likely alive */
+		now = kmip_pool_now();
+		while (pool->idle != NULL) {
+			entry = pool->idle;
+			pool->idle = entry->next;
+
+			if (kmip_pool_entry_usable(pool, entry, now)) {
+				*connection = entry->conn;
+				free(entry);
+				pthread_mutex_unlock(&pool->mutex);
+				kmip_debug(debug, "Reusing pooled connection");
+				return 0;
+			}
+
+			kmip_debug(debug, "Closing stale pooled connection");
+			kmip_connection_free(entry->conn);
+			free(entry);
+			pool->num_connections--;
+		}
+
+		if (pool->num_connections < pool->max_connections)
+			break;
+
+		if (!wait) {
+			pthread_mutex_unlock(&pool->mutex);
+			return -EAGAIN;
+		}
+
+		pthread_cond_wait(&pool->cond, &pool->mutex);
+	}
+
+	/* Establish the connection without holding the mutex */
+	pool->num_connections++;
+	session = pool->session;
+	if (session != NULL)
+		SSL_SESSION_up_ref(session);
+	pthread_mutex_unlock(&pool->mutex);
+
+	rc = kmip_connection_new_session(&pool->config, session, connection,
+					 debug);
+	if (session != NULL)
+		SSL_SESSION_free(session);
+
+	if (rc != 0) {
+		kmip_debug(debug, "kmip_connection_new_session failed");
+		pthread_mutex_lock(&pool->mutex);
+		pool->num_connections--;
+		pthread_cond_signal(&pool->cond);
+		pthread_mutex_unlock(&pool->mutex);
+		return rc;
+	}
+
+	switch (pool->config.transport) {
+	case KMIP_TRANSPORT_PLAIN_TLS:
+		kmip_connection_tls_set_keepalive(*connection,
+						  KMIP_POOL_KEEPALIVE_IDLE,
+						  debug);
+		break;
+	case KMIP_TRANSPORT_HTTPS:
+		kmip_connection_https_set_keepalive(*connection,
+						    KMIP_POOL_KEEPALIVE_IDLE,
+						    debug);
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+/**
+ * Checks out a connection from the pool. An idle connection is reused if
+ * possible, otherwise a new connection is established, resuming the last
+ * known TLS session. This function is thread-safe.
+ *
+ * @param pool              the connection pool
+ * @param connection        On return: the KMIP connection. Must be returned
+ *                          with kmip_connection_pool_put().
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_connection_pool_get(struct kmip_connection_pool *pool,
+			     struct kmip_connection **connection,
+			     bool debug)
+{
+	return kmip_pool_get(pool, connection, true, debug);
+}
+
+/**
+ * Checks out a connection from the pool as with kmip_connection_pool_get(),
+ * but does not wait if all connections are in use. This function is
+ * thread-safe.
+ *
+ * @param pool              the connection pool
+ * @param connection        On return: the KMIP connection. Must be returned
+ *                          with kmip_connection_pool_put().
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, -EAGAIN if all connections are in use, or a
+ * negative errno value
+ */
+int kmip_connection_pool_try_get(struct kmip_connection_pool *pool,
+				 struct kmip_connection **connection,
+				 bool debug)
+{
+	return kmip_pool_get(pool, connection, false, debug);
+}
+
+/**
+ * Returns a connection to the pool. A connection that encountered an error
+ * must be discarded, because its state is unknown. This function is
+ * thread-safe.
+ *
+ * @param pool              the connection pool
+ * @param connection        the KMIP connection obtained with
+ *                          kmip_connection_pool_get()
+ * @param discard           if true, the connection is closed instead of being
+ *                          kept for reuse
+ * @param debug             if true, debug messages are printed
+ */
+void kmip_connection_pool_put(struct kmip_connection_pool *pool,
+			      struct kmip_connection *connection,
+			      bool discard, bool debug)
+{
+	struct kmip_pool_entry *entry = NULL;
+
+	if (pool == NULL || connection == NULL)
+		return;
+
+	if (!discard) {
+		entry = calloc(1, sizeof(struct kmip_pool_entry));
+		if (entry == NULL)
+			kmip_debug(debug, "calloc failed");
+	}
+
+	pthread_mutex_lock(&pool->mutex);
+	if (entry != NULL) {
+		kmip_pool_update_session(pool, connection);
+		entry->conn = connection;
+		entry->last_used = kmip_pool_now();
+		entry->next = pool->idle;
+		pool->idle = entry;
+	} else {
+		pool->num_connections--;
+	}
+	pthread_cond_signal(&pool->cond);
+	pthread_mutex_unlock(&pool->mutex);
+
+	if (entry == NULL) {
+		kmip_debug(debug, "Closing pooled connection");
+		kmip_connection_free(connection);
+	}
+}
+
+/**
+ * Closes all idle connections and frees the pool. The last TLS session is
+ * written to the session cache file. All connections must have been returned
+ * to the pool before.
+ *
+ * @param pool              the connection pool
+ * @param debug             if true, debug messages are printed
+ */
+void kmip_connection_pool_free(struct kmip_connection_pool *pool, bool debug)
+{
+	struct kmip_pool_entry *entry;
+
+	if (pool == NULL)
+		return;
+
+	kmip_pool_save_session(pool, debug);
+
+	while (pool->idle != NULL) {
+		entry = pool->idle;
+		pool->idle = entry->next;
+		kmip_connection_free(entry->conn);
+		free(entry);
+	}
+
+	if (pool->session != NULL)
+		SSL_SESSION_free(pool->session);
+	free(pool->session_cache);
+	kmip_conn_config_free(&pool->config);
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->mutex);
+	free(pool);
+}
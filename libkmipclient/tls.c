@@ -8,9 +8,14 @@
  */
 
 #include <errno.h>
+#include <poll.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
 #include <openssl/err.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
@@ -416,6 +421,16 @@ int kmip_connection_tls_init(struct kmip_connection *conn, bool debug)
 
 	SSL_set_mode(conn->plain_tls.ssl, SSL_MODE_AUTO_RETRY);
 
+	if (conn->plain_tls.session != NULL) {
+		if (SSL_set_session(conn->plain_tls.ssl,
+				    conn->plain_tls.session) != 1) {
+			kmip_debug(debug, "SSL_set_session failed, session "
+				   "is not resumed");
+			if (debug)
+				ERR_print_errors_fp(stderr);
+		}
+	}
+
 	BIO_set_conn_hostname(conn->plain_tls.bio, hostname);
 	BIO_set_conn_port(conn->plain_tls.bio, port);
 
@@ -429,6 +444,10 @@ int kmip_connection_tls_init(struct kmip_connection *conn, bool debug)
 
 	kmip_debug(debug, "TLS connection established using %s",
 		   SSL_get_cipher_name(conn->plain_tls.ssl));
+	if (conn->plain_tls.session != NULL)
+		kmip_debug(debug, "TLS session resumed: %s",
+			   SSL_session_reused(conn->plain_tls.ssl) ?
+							"yes" : "no");
 
 	rc = kmip_connection_tls_verify_server(conn, debug);
 	if (rc != 0) {
@@ -450,6 +469,70 @@ out:
 	return rc;
 }
 
+/**
+ * Sends a request over a plain TLS KMIP connection, without waiting for the
+ * response. Several requests can be sent before their responses are received,
+ * the server sends the responses in the order of the requests.
+ *
+ * @param conn              the KMIP connection
+ * @param request           the request to send
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_connection_tls_send(struct kmip_connection *conn,
+			     struct kmip_node *request, bool debug)
+{
+	size_t size;
+	int rc;
+
+	if (conn == NULL || request == NULL)
+		return -EINVAL;
+
+	rc = kmip_encode_ttlv(request, conn->plain_tls.bio, &size, debug);
+	if (rc != 0) {
+		kmip_debug(debug, "kmip_encode_ttlv failed");
+		return rc;
+	}
+	if (BIO_flush(conn->plain_tls.bio) != 1) {
+		kmip_debug(debug, "BIO_flush failed");
+		return -EIO;
+	}
+	kmip_debug(debug, "%lu bytes sent", size);
+
+	return 0;
+}
+
+/**
+ * Receives the response to the oldest outstanding request over a plain TLS
+ * KMIP connection. Blocks until the complete response has been received.
+ *
+ * @param conn              the KMIP connection
+ * @param response          On return: the received response. Must be freed by
+ *                          the caller.
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_connection_tls_receive(struct kmip_connection *conn,
+				struct kmip_node **response, bool debug)
+{
+	int rc;
+
+	if (conn == NULL || response == NULL)
+		return -EINVAL;
+
+	*response = NULL;
+
+	rc = kmip_decode_ttlv(conn->plain_tls.bio, NULL, response, debug);
+	if (rc != 0 || *response == NULL) {
+		kmip_debug(debug, "kmip_decode_ttlv failed");
+		return rc != 0 ? rc : -EIO;
+	}
+
+	return 0;
+}
+
 /**
  * Perform a request over the KMIP connection
  *
@@ -467,7 +550,6 @@ int kmip_connection_tls_perform(struct kmip_connection *conn,
 				struct kmip_node **response,
 				bool debug)
 {
-	size_t size;
 	int rc;
 
 	if (conn == NULL || request == NULL || response == NULL)
@@ -476,25 +558,12 @@ int kmip_connection_tls_perform(struct kmip_connection *conn,
 	*response = NULL;
 
 	/* Send out the request */
-	rc = kmip_encode_ttlv(request, conn->plain_tls.bio, &size, debug);
-	if (rc != 0) {
-		kmip_debug(debug, "kmip_encode_ttlv failed");
-		goto out;
-	}
-	if (BIO_flush(conn->plain_tls.bio) != 1) {
-		kmip_debug(debug, "BIO_flush failed");
+	rc = kmip_connection_tls_send(conn, request, debug);
+	if (rc != 0)
 		goto out;
-	}
-	kmip_debug(debug, "%lu bytes sent", size);
 
 	/* receive the response */
-	rc = kmip_decode_ttlv(conn->plain_tls.bio, NULL, response, debug);
-	if (rc != 0 || *response == NULL) {
-		kmip_debug(debug, "kmip_decode_ttlv failed");
-		goto out;
-	}
-
-	rc = 0;
+	rc = kmip_connection_tls_receive(conn, response, debug);
 
 out:
 	if (rc != 0) {
@@ -521,8 +590,140 @@ void kmip_connection_tls_term(struct kmip_connection *conn)
 	}
 	if (conn->plain_tls.ssl_ctx != NULL)
 		SSL_CTX_free(conn->plain_tls.ssl_ctx);
+	if (conn->plain_tls.session != NULL)
+		SSL_SESSION_free(conn->plain_tls.session);
 
 	conn->plain_tls.bio = NULL;
 	conn->plain_tls.ssl_ctx = NULL;
 	conn->plain_tls.ssl = NULL;
+	conn->plain_tls.session = NULL;
+}
+
+/**
+ * Returns the current TLS session of a plain TLS KMIP connection, if it can be
+ * resumed. With TLS 1.3 the session ticket is sent by the server after the
+ * handshake, so the session only becomes resumable once a response has been
+ * received.
+ *
+ * @param conn              the KMIP connection
+ *
+ * @returns the session with its reference count increased, or NULL
+ */
+SSL_SESSION *kmip_connection_tls_get_session(struct kmip_connection *conn)
+{
+	SSL_SESSION *session;
+
+	if (conn == NULL || conn->plain_tls.ssl == NULL)
+		return NULL;
+
+	session = SSL_get1_session(conn->plain_tls.ssl);
+	if (session == NULL)
+		return NULL;
+
+	if (SSL_SESSION_is_resumable(session) != 1) {
+		SSL_SESSION_free(session);
+		return NULL;
+	}
+
+	return session;
+}
+
+/**
+ * Checks if an idle plain TLS KMIP connection can still be used. A connection
+ * that is readable while no request is outstanding has either been closed by
+ * the server, or the server has sent an alert.
+ *
+ * @param conn              the KMIP connection
+ *
+ * @returns true if the connection is usable
+ */
+bool kmip_connection_tls_is_alive(struct kmip_connection *conn)
+{
+	struct pollfd pfd = { 0 };
+	int fd;
+
+	if (conn == NULL || conn->plain_tls.bio == NULL)
+		return false;
+
+	if (BIO_get_fd(conn->plain_tls.bio, &fd) < 0 || fd < 0)
+		return false;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, 0) != 0)
+		return false;
+
+	return true;
+}
+
+/**
+ * Returns the socket of a plain TLS KMIP connection, to wait for a response
+ * with poll(). Data that has already been read from the socket, but not yet
+ * consumed, is not indicated by poll(), so check with
+ * kmip_connection_tls_has_pending() before.
+ *
+ * @param conn              the KMIP connection
+ *
+ * @returns the file descriptor of the socket, or -1
+ */
+int kmip_connection_tls_get_fd(struct kmip_connection *conn)
+{
+	int fd;
+
+	if (conn == NULL || conn->plain_tls.bio == NULL)
+		return -1;
+
+	if (BIO_get_fd(conn->plain_tls.bio, &fd) < 0)
+		return -1;
+
+	return fd;
+}
+
+/**
+ * Checks if received data is buffered in a plain TLS KMIP connection
+ *
+ * @param conn              the KMIP connection
+ *
+ * @returns true if data can be read without waiting
+ */
+bool kmip_connection_tls_has_pending(struct kmip_connection *conn)
+{
+	if (conn == NULL || conn->plain_tls.ssl == NULL)
+		return false;
+
+	return SSL_pending(conn->plain_tls.ssl) > 0;
+}
+
+/**
+ * Enables TCP keep-alive probes on a plain TLS KMIP connection, so that idle
+ * connections are not dropped by firewalls.
+ *
+ * @param conn              the KMIP connection
+ * @param idle              the idle time in seconds before probes are sent
+ * @param debug             if true, debug messages are printed
+ */
+void kmip_connection_tls_set_keepalive(struct kmip_connection *conn,
+				       unsigned int idle, bool debug)
+{
+	int fd, val = 1;
+
+	if (conn == NULL || conn->plain_tls.bio == NULL)
+		return;
+
+	if (BIO_get_fd(conn->plain_tls.bio, &fd) < 0 || fd < 0) {
+		kmip_debug(debug, "BIO_get_fd failed");
+		return;
+	}
+
+	if (setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &val, sizeof(val)) != 0) {
+		kmip_debug(debug, "setsockopt SO_KEEPALIVE failed: %s",
+			   strerror(errno));
+		return;
+	}
+
+	val = idle;
+	if (setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &val, sizeof(val)) != 0 ||
+	    setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &val, sizeof(val)) != 0)
+		kmip_debug(debug, "setsockopt TCP_KEEPIDLE failed: %s",
+			   strerror(errno));
 }
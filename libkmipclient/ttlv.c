@@ -11,116 +11,152 @@
 #include <endian.h>
 #include <string.h>
 
+#include "lib/zt_common.h"
+
 #include "kmip.h"
 #include "utils.h"
 
 #define KMIP_TTLV_HEADER_LENGTH		8
 #define KMIP_TTLV_BLOCK_LENGTH		8
+#define KMIP_TTLV_MAX_LENGTH		(64 * 1024 * 1024)
+
+#define KMIP_TTLV_PADDED(len)						\
+		(((len) + KMIP_TTLV_BLOCK_LENGTH - 1) &			\
+					~(size_t)(KMIP_TTLV_BLOCK_LENGTH - 1))
 
 /**
- * Decode a KMIP node from the data in BIO using the TTLV encoding.
+ * Allocates a buffer for TTLV encoded data. The newly allocated buffer has a
+ * reference count of 1.
  *
- * @param bio               the OpenSSL bio to read the data from
- * @param size              Optional: If not NULL:
- *                          On entry: The number of bytes available to read
- *                          On return: decremented by the number of bytes read
- *                          If NULL, it is assumed that we can read from bio
- *                          as many bytes as needed.
- * @param node              On return: the decoded node. The newly allocated
- *                          node has a reference count of 1.
+ * @param size              the size of the data
+ *
+ * @returns the allocated buffer, or NULL in case of an error
+ */
+struct kmip_buffer *kmip_buffer_new(size_t size)
+{
+	struct kmip_buffer *buffer;
+
+	buffer = malloc(sizeof(struct kmip_buffer) + size);
+	if (buffer == NULL)
+		return NULL;
+
+	buffer->ref_count = 1;
+	buffer->size = size;
+	return buffer;
+}
+
+/**
+ * Increments the reference count of a buffer
+ *
+ * @param buffer            the buffer
+ */
+void kmip_buffer_upref(struct kmip_buffer *buffer)
+{
+	if (buffer == NULL)
+		return;
+
+	__sync_add_and_fetch((unsigned long *)&buffer->ref_count, 1);
+}
+
+/**
+ * Decrements the reference count of a buffer, and frees it if the reference
+ * count drops to zero.
+ *
+ * @param buffer            the buffer
+ */
+void kmip_buffer_free(struct kmip_buffer *buffer)
+{
+	if (buffer == NULL)
+		return;
+
+	if (__sync_sub_and_fetch((unsigned long *)&buffer->ref_count, 1) > 0)
+		return;
+
+	free(buffer);
+}
+
+/**
+ * Parses the header of a TTLV encoded item
+ *
+ * @param data              the TTLV header (8 bytes)
+ * @param tag               On return: the tag
+ * @param type              On return: the type
+ * @param length            On return: the length of the value
+ */
+static void kmip_ttlv_parse_header(const unsigned char *data,
+				   enum kmip_tag *tag, enum kmip_type *type,
+				   uint32_t *length)
+{
+	/* Tag: 3-byte binary unsigned integer, transmitted big endian */
+	*tag = (uint32_t)data[0] << 16 | (uint32_t)data[1] << 8 | data[2];
+
+	/* Type: 1 byte containing a coded value that indicates the data type */
+	*type = data[3];
+
+	/* Length: 32-bit binary integer, transmitted big-endian */
+	*length = (uint32_t)data[4] << 24 | (uint32_t)data[5] << 16 |
+		  (uint32_t)data[6] << 8 | data[7];
+}
+
+/**
+ * Decode a KMIP node from TTLV encoded data in a buffer
+ *
+ * @param arena             the arena to allocate the nodes from
+ * @param buffer            the buffer containing the data
+ * @param data              the data of the item to decode
+ * @param size              On entry: The number of bytes available
+ *                          On return: decremented by the number of bytes used
+ * @param node              On return: the decoded node
  * @param debug             if true, debug messages are printed
  *
  * @returns 0 in case of success, or a negative errno value
  */
-int kmip_decode_ttlv(BIO *bio, size_t *size, struct kmip_node **node,
-		     bool debug)
+static int kmip_ttlv_decode(struct kmip_arena *arena,
+			    struct kmip_buffer *buffer,
+			    const unsigned char *data, size_t *size,
+			    struct kmip_node **node, bool debug)
 {
-	unsigned char padding[KMIP_TTLV_BLOCK_LENGTH];
-	unsigned char ttlv[KMIP_TTLV_HEADER_LENGTH];
-	size_t value_len, pad_len;
-	struct kmip_node *n, *e;
-	void *value = NULL;
+	struct kmip_node *n, *e, *last = NULL;
+	const unsigned char *value;
+	size_t value_len, avail;
 	uint32_t int32;
 	uint64_t int64;
 	int rc;
 
-	if (bio == NULL || node == NULL)
-		return -EINVAL;
-
-	if (size != NULL)
-		kmip_debug(debug, "size: %lu", *size);
-	else
-		kmip_debug(debug, "size: unknown");
-
-	if (size != NULL && *size < sizeof(ttlv)) {
+	if (*size < KMIP_TTLV_HEADER_LENGTH) {
 		kmip_debug(debug, "length %u > available size %lu",
-			  sizeof(ttlv), *size);
+			   KMIP_TTLV_HEADER_LENGTH, *size);
 		return -EMSGSIZE;
 	}
 
-	if (BIO_read(bio, ttlv, sizeof(ttlv)) != sizeof(ttlv)) {
-		kmip_debug(debug, "BIO_read failed");
-		return -EIO;
-	}
-	if (size != NULL)
-		*size -= sizeof(ttlv);
-
-	n = calloc(1, sizeof(struct kmip_node));
+	n = kmip_node_alloc(arena);
 	if (n == NULL) {
-		kmip_debug(debug, "calloc failed");
+		kmip_debug(debug, "kmip_node_alloc failed");
 		return -ENOMEM;
 	}
-	n->ref_count = 1;
-
-	/* Tag: 3-byte binary unsigned integer, transmitted big endian */
-	n->tag |= (uint32_t)(ttlv[0] << 16);
-	n->tag |= (uint32_t)(ttlv[1] << 8);
-	n->tag |= (uint32_t)(ttlv[2]);
-
-	/* Type: 1 byte containing a coded value that indicates the data type */
-	n->type = ttlv[3];
-
-	/* Length: 32-bit binary integer, transmitted big-endian */
-	n->length |= (uint32_t)(ttlv[4] << 24);
-	n->length |= (uint32_t)(ttlv[5] << 16);
-	n->length |= (uint32_t)(ttlv[6] << 8);
-	n->length |= (uint32_t)(ttlv[7]);
 
+	kmip_ttlv_parse_header(data, &n->tag, &n->type, &n->length);
 	kmip_debug(debug, "tag: 0x%x type: 0x%x, length: %u", n->tag, n->type,
 		   n->length);
 
 	switch (n->type) {
 	case KMIP_TYPE_STRUCTURE:
-		value_len = n->length;
-		break;
-
 	case KMIP_TYPE_BIG_INTEGER:
 	case KMIP_TYPE_TEXT_STRING:
 	case KMIP_TYPE_BYTE_STRING:
 		value_len = n->length;
-		value = calloc(1, value_len + 1);
-		if (value == NULL) {
-			kmip_debug(debug, "calloc failed");
-			rc = -ENOMEM;
-			goto out;
-		}
 		break;
-
 	case KMIP_TYPE_INTEGER:
 	case KMIP_TYPE_ENUMERATION:
 	case KMIP_TYPE_INTERVAL:
 		value_len = sizeof(int32);
-		value = &int32;
 		break;
-
 	case KMIP_TYPE_LONG_INTEGER:
 	case KMIP_TYPE_BOOLEAN:
 	case KMIP_TYPE_DATE_TIME:
 	case KMIP_TYPE_DATE_TIME_EXTENDED:
 		value_len = sizeof(int64);
-		value = &int64;
 		break;
-
 	default:
 		kmip_debug(debug, "unknown type: 0x%x", n->type);
 		rc = -EBADMSG;
@@ -133,62 +169,44 @@ int kmip_decode_ttlv(BIO *bio, size_t *size, struct kmip_node **node,
 		rc = -EBADMSG;
 		goto out;
 	}
-	if (size != NULL && *size < n->length) {
+	if (*size - KMIP_TTLV_HEADER_LENGTH < value_len) {
 		kmip_debug(debug, "length %u > available size %lu", n->length,
-			   *size);
+			   *size - KMIP_TTLV_HEADER_LENGTH);
 		rc = -EMSGSIZE;
 		goto out;
 	}
 
-	if (n->type != KMIP_TYPE_STRUCTURE && value_len > 0) {
-		if (BIO_read(bio, value, value_len) != (int)value_len) {
-			kmip_debug(debug, "BIO_read failed");
-			rc = -EIO;
-			goto out;
-		}
-	}
-	if (size != NULL)
-		*size -= value_len;
-
-	if ((value_len % KMIP_TTLV_BLOCK_LENGTH) != 0) {
-		pad_len = KMIP_TTLV_BLOCK_LENGTH -
-					(value_len % KMIP_TTLV_BLOCK_LENGTH);
-
-		kmip_debug(debug, "pad_len: %lu", pad_len);
-		if (BIO_read(bio, padding, pad_len) != (int)pad_len) {
-			kmip_debug(debug, "BIO_read failed (padding)");
-			rc = -EIO;
-			goto out;
-		}
-		if (size != NULL)
-			*size -= pad_len;
-	}
+	value = data + KMIP_TTLV_HEADER_LENGTH;
 
 	switch (n->type) {
 	case KMIP_TYPE_STRUCTURE:
-		while (value_len > 0) {
-			rc = kmip_decode_ttlv(bio, &value_len, &e, debug);
+		/* Elements are linked directly to avoid walking the list */
+		avail = value_len;
+		while (avail > 0) {
+			rc = kmip_ttlv_decode(arena, buffer,
+					      value + value_len - avail,
+					      &avail, &e, debug);
 			if (rc != 0) {
-				kmip_debug(debug, "kmip_decode_ttlv failed: "
+				kmip_debug(debug, "kmip_ttlv_decode failed: "
 					   "rc: %d", rc);
 				goto out;
 			}
-			rc = kmip_node_add_structure_element(n, e);
-			kmip_node_free(e);
-			if (rc != 0) {
-				kmip_debug(debug,
-					"kmip_node_structure_add_element "
-					"failed: rc: %d", rc);
-				goto out;
-			}
+			e->parent = n;
+			if (last == NULL)
+				n->structure_value = e;
+			else
+				last->next = e;
+			last = e;
 		}
 		break;
 
 	case KMIP_TYPE_INTEGER:
+		memcpy(&int32, value, sizeof(int32));
 		n->integer_value = be32toh(int32);
 		break;
 
 	case KMIP_TYPE_LONG_INTEGER:
+		memcpy(&int64, value, sizeof(int64));
 		n->long_value = be64toh(int64);
 		break;
 
@@ -199,313 +217,471 @@ int kmip_decode_ttlv(BIO *bio, size_t *size, struct kmip_node **node,
 			kmip_debug(debug, "kmip_decode_bignum failed");
 			goto out;
 		}
-		free(value);
-		value = NULL;
 		break;
 
 	case KMIP_TYPE_ENUMERATION:
+		memcpy(&int32, value, sizeof(int32));
 		n->enumeration_value = be32toh(int32);
 		break;
 
 	case KMIP_TYPE_BOOLEAN:
+		memcpy(&int64, value, sizeof(int64));
 		n->boolean_value = int64 != 0;
 		break;
 
 	case KMIP_TYPE_TEXT_STRING:
-		n->text_value = value;
+		/* Text strings must be NUL terminated, so they are copied */
+		n->text_value = kmip_arena_memdup(arena, value, value_len,
+						  true);
+		if (n->text_value == NULL) {
+			kmip_debug(debug, "kmip_arena_memdup failed");
+			rc = -ENOMEM;
+			goto out;
+		}
 		break;
 
 	case KMIP_TYPE_BYTE_STRING:
-		n->bytes_value = value;
+		/* Byte strings reference the data in the buffer */
+		if (value_len > 0) {
+			n->bytes_value = (unsigned char *)value;
+			n->buffer = buffer;
+			kmip_buffer_upref(buffer);
+		}
 		break;
 
 	case KMIP_TYPE_DATE_TIME:
+		memcpy(&int64, value, sizeof(int64));
 		n->date_time_value = be64toh(int64);
 		break;
 
 	case KMIP_TYPE_INTERVAL:
+		memcpy(&int32, value, sizeof(int32));
 		n->interval_value = be32toh(int32);
 		break;
 
 	case KMIP_TYPE_DATE_TIME_EXTENDED:
+		memcpy(&int64, value, sizeof(int64));
 		n->date_time_ext_value = be64toh(int64);
 		break;
 
 	default:
-		kmip_debug(debug, "unknown type: 0x%x", n->type);
-		rc = -EBADMSG;
-		goto out;
+		break;
 	}
 
+	/* The padding of the last item of a message may be missing */
+	value_len = MIN(KMIP_TTLV_PADDED(value_len),
+			*size - KMIP_TTLV_HEADER_LENGTH);
+	*size -= KMIP_TTLV_HEADER_LENGTH + value_len;
+
 	*node = n;
 	rc = 0;
 
 out:
-	if (rc != 0) {
-		switch (n->type) {
-		case KMIP_TYPE_BIG_INTEGER:
-		case KMIP_TYPE_TEXT_STRING:
-		case KMIP_TYPE_BYTE_STRING:
-			free(value);
-			break;
-		default:
-			break;
-		}
-
+	if (rc != 0)
 		kmip_node_free(n);
-	}
+
 	return rc;
 }
 
 /**
- * Gets the length of the value part of a KMIP node (in TTLV encoding)
+ * Decode a KMIP node from a buffer containing a complete TTLV encoded
+ * message. Byte string values of the decoded nodes reference the data in the
+ * buffer instead of being copied, and hold a reference to the buffer.
+ * The decoded nodes are allocated from an arena of their own, so the memory of
+ * the whole message is retained as long as any of its nodes is referenced.
+ *
+ * @param buffer            the buffer to decode
+ * @param node              On return: the decoded node. The newly allocated
+ *                          node has a reference count of 1.
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
  */
-static int kmip_node_get_length(struct kmip_node *node, size_t *length)
+int kmip_decode_ttlv_buffer(struct kmip_buffer *buffer,
+			    struct kmip_node **node, bool debug)
 {
-	struct kmip_node *element;
-	size_t len;
+	struct kmip_arena *arena;
+	size_t size;
 	int rc;
 
-	if (node == NULL || length == NULL)
+	if (buffer == NULL || node == NULL)
+		return -EINVAL;
+
+	size = buffer->size;
+	kmip_debug(debug, "size: %lu", size);
+
+	/*
+	 * A node takes about 4 times the size of its TTLV encoding, unless it
+	 * is a byte string, which references the buffer.
+	 */
+	arena = kmip_arena_new(MIN(MAX(size * 4,
+				       (size_t)KMIP_ARENA_DEFAULT_CHUNK_SIZE),
+				   (size_t)KMIP_ARENA_MAX_CHUNK_SIZE));
+	if (arena == NULL) {
+		kmip_debug(debug, "kmip_arena_new failed");
+		return -ENOMEM;
+	}
+
+	rc = kmip_ttlv_decode(arena, buffer, buffer->data, &size, node, debug);
+	kmip_arena_free(arena);
+	if (rc != 0)
+		return rc;
+
+	if (size != 0)
+		kmip_debug(debug, "%lu bytes of trailing data ignored", size);
+
+	return 0;
+}
+
+/**
+ * Decode a KMIP node from the data in BIO using the TTLV encoding. The
+ * message is read into a buffer with one read for the header, and one for
+ * the remaining data, and is then decoded from the buffer.
+ *
+ * @param bio               the OpenSSL bio to read the data from
+ * @param size              Optional: If not NULL:
+ *                          On entry: The number of bytes available to read
+ *                          On return: decremented by the number of bytes read
+ *                          If NULL, it is assumed that we can read from bio
+ *                          as many bytes as needed.
+ * @param node              On return: the decoded node. The newly allocated
+ *                          node has a reference count of 1.
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_decode_ttlv(BIO *bio, size_t *size, struct kmip_node **node,
+		     bool debug)
+{
+	unsigned char ttlv[KMIP_TTLV_HEADER_LENGTH];
+	struct kmip_buffer *buffer;
+	enum kmip_type type;
+	enum kmip_tag tag;
+	size_t msg_len;
+	uint32_t length;
+	int rc = 0;
+
+	if (bio == NULL || node == NULL)
 		return -EINVAL;
 
+	if (size != NULL && *size < sizeof(ttlv)) {
+		kmip_debug(debug, "length %lu > available size %lu",
+			   sizeof(ttlv), *size);
+		return -EMSGSIZE;
+	}
+
+	if (BIO_read(bio, ttlv, sizeof(ttlv)) != sizeof(ttlv)) {
+		kmip_debug(debug, "BIO_read failed");
+		return -EIO;
+	}
+
+	kmip_ttlv_parse_header(ttlv, &tag, &type, &length);
+	if (length > KMIP_TTLV_MAX_LENGTH) {
+		kmip_debug(debug, "length %u exceeds the maximum", length);
+		return -EMSGSIZE;
+	}
+
+	/* Items of fixed size types are padded to the block length */
+	msg_len = sizeof(ttlv) + KMIP_TTLV_PADDED(length);
+	if (size != NULL && *size < msg_len) {
+		kmip_debug(debug, "length %lu > available size %lu", msg_len,
+			   *size);
+		return -EMSGSIZE;
+	}
+
+	buffer = kmip_buffer_new(msg_len);
+	if (buffer == NULL) {
+		kmip_debug(debug, "malloc failed");
+		return -ENOMEM;
+	}
+
+	memcpy(buffer->data, ttlv, sizeof(ttlv));
+	if (msg_len > sizeof(ttlv) &&
+	    BIO_read(bio, buffer->data + sizeof(ttlv),
+		     msg_len - sizeof(ttlv)) != (int)(msg_len - sizeof(ttlv))) {
+		kmip_debug(debug, "BIO_read failed");
+		rc = -EIO;
+		goto out;
+	}
+	if (size != NULL)
+		*size -= msg_len;
+
+	rc = kmip_decode_ttlv_buffer(buffer, node, debug);
+
+out:
+	kmip_buffer_free(buffer);
+	return rc;
+}
+
+/**
+ * Calculates the length of the value part of a KMIP node and all of its
+ * elements (in TTLV encoding), and stores it in the length field of the
+ * nodes. Each node is visited once.
+ *
+ * @param node              the node
+ * @param length            On return: the encoded size of the node including
+ *                          header and padding
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+static int kmip_ttlv_prepare(struct kmip_node *node, size_t *length)
+{
+	struct kmip_node *element;
+	size_t len, elem_len;
+	int rc;
+
 	switch (node->type) {
 	case KMIP_TYPE_STRUCTURE:
-		*length = 0;
-		element = node->structure_value;
-		while (element != NULL) {
-			rc = kmip_node_get_length(element, &len);
+		len = 0;
+		for (element = node->structure_value; element != NULL;
+		     element = element->next) {
+			rc = kmip_ttlv_prepare(element, &elem_len);
 			if (rc != 0)
 				return rc;
-
-			*length += KMIP_TTLV_HEADER_LENGTH + len;
-			if ((len % KMIP_TTLV_BLOCK_LENGTH) != 0)
-				*length += KMIP_TTLV_BLOCK_LENGTH -
-						(len % KMIP_TTLV_BLOCK_LENGTH);
-
-			element = element->next;
+			len += elem_len;
 		}
 		break;
 
 	case KMIP_TYPE_INTEGER:
 	case KMIP_TYPE_ENUMERATION:
 	case KMIP_TYPE_INTERVAL:
-		*length = sizeof(int32_t);
+		len = sizeof(int32_t);
 		break;
 
 	case KMIP_TYPE_LONG_INTEGER:
 	case KMIP_TYPE_BOOLEAN:
 	case KMIP_TYPE_DATE_TIME:
 	case KMIP_TYPE_DATE_TIME_EXTENDED:
-		*length = sizeof(int64_t);
+		len = sizeof(int64_t);
 		break;
 
 	case KMIP_TYPE_BIG_INTEGER:
-		*length = kmip_encode_bignum_length(node->big_integer_value);
+		len = kmip_encode_bignum_length(node->big_integer_value);
 		/* BIG INTEGERS must be a multiple of 8 bytes long */
-		if ((*length % KMIP_BIG_INTEGER_BLOCK_LENGTH) != 0)
-			*length += KMIP_BIG_INTEGER_BLOCK_LENGTH -
-				(*length % KMIP_BIG_INTEGER_BLOCK_LENGTH);
+		if ((len % KMIP_BIG_INTEGER_BLOCK_LENGTH) != 0)
+			len += KMIP_BIG_INTEGER_BLOCK_LENGTH -
+				(len % KMIP_BIG_INTEGER_BLOCK_LENGTH);
 		break;
 
 	case KMIP_TYPE_BYTE_STRING:
-		*length = node->length;
+		len = node->length;
 		break;
 
 	case KMIP_TYPE_TEXT_STRING:
 		if (node->text_value != NULL)
-			*length = strlen(node->text_value);
+			len = strlen(node->text_value);
 		else
-			*length = 0;
+			len = 0;
 		break;
 
 	default:
 		return -EINVAL;
 	}
 
+	if (len > UINT32_MAX)
+		return -EMSGSIZE;
+
+	node->length = len;
+	*length = KMIP_TTLV_HEADER_LENGTH + KMIP_TTLV_PADDED(len);
 	return 0;
 }
 
 /**
- * Encode a KMIP node into a BIO using the TTLV encoding.
+ * Serializes a KMIP node, whose lengths have been calculated with
+ * kmip_ttlv_prepare(), into a buffer. The padding must already be zeroed.
  *
- * @param node              the node to encode
- * @param bio               the OpenSSL bio to write the data to
- * @param size              On return: the number of bytes written to BIO
- * @param debug             if true, debug messages are printed
+ * @param node              the node to serialize
+ * @param data              the buffer to write to
  *
- * @returns 0 in case of success, or a negative errno value
+ * @returns the number of bytes written, or a negative errno value
  */
-int kmip_encode_ttlv(struct kmip_node *node, BIO *bio, size_t *size,
-		     bool debug)
+static ssize_t kmip_ttlv_serialize(const struct kmip_node *node,
+				   unsigned char *data)
 {
-	const unsigned char padding[KMIP_TTLV_BLOCK_LENGTH] = { 0 };
-	unsigned char ttlv[KMIP_TTLV_HEADER_LENGTH];
-	size_t len, elem_len, value_len, pad_len;
-	struct kmip_node *element;
-	void *value = NULL;
+	const struct kmip_node *element;
+	unsigned char *value;
+	ssize_t len, ofs;
 	uint32_t int32;
 	uint64_t int64;
 	int rc;
 
-	if (bio == NULL || node == NULL || size == NULL)
-		return -EINVAL;
-
-	kmip_debug(debug, "tag: 0x%x type: 0x%x, length: %u", node->tag,
-		   node->type, node->length);
-
-	*size = 0;
-
-	/* Update node's length field to match node's current data */
-	rc = kmip_node_get_length(node, &len);
-	if (rc != 0) {
-		kmip_debug(debug, "kmip_node_get_length failed");
-		return rc;
-	}
-	node->length = len;
-
 	/* Tag: 3-byte binary unsigned integer, transmitted big endian */
-	ttlv[0] = (node->tag & 0xff0000) >> 16;
-	ttlv[1] = (node->tag & 0xff00) >> 8;
-	ttlv[2] = (node->tag & 0xff);
+	data[0] = (node->tag & 0xff0000) >> 16;
+	data[1] = (node->tag & 0xff00) >> 8;
+	data[2] = (node->tag & 0xff);
 
 	/* Type: 1 byte containing a coded value that indicates the data type */
-	ttlv[3] = node->type;
+	data[3] = node->type;
 
 	/* Length: 32-bit binary integer, transmitted big-endian */
-	ttlv[4] = (node->length & 0xff000000) >> 24;
-	ttlv[5] = (node->length & 0xff0000) >> 16;
-	ttlv[6] = (node->length & 0xff00) >> 8;
-	ttlv[7] = (node->length & 0xff);
+	data[4] = (node->length & 0xff000000) >> 24;
+	data[5] = (node->length & 0xff0000) >> 16;
+	data[6] = (node->length & 0xff00) >> 8;
+	data[7] = (node->length & 0xff);
 
-	if (BIO_write(bio, ttlv, sizeof(ttlv)) != sizeof(ttlv)) {
-		kmip_debug(debug, "BIO_write failed");
-		return -EIO;
-	}
-	*size += sizeof(ttlv);
+	value = data + KMIP_TTLV_HEADER_LENGTH;
 
 	switch (node->type) {
 	case KMIP_TYPE_STRUCTURE:
-		value_len = 0;
-		element = node->structure_value;
-		while (element != NULL) {
-			rc = kmip_encode_ttlv(element, bio, &elem_len, debug);
-			if (rc != 0) {
-				kmip_debug(debug, "kmip_encode_ttlv failed");
-				return rc;
-			}
-			value_len += elem_len;
-			element = element->next;
-		}
-		if (value_len != node->length) {
-			kmip_debug(debug, "written length %lu not as expected "
-				   "(%u)", len, node->length);
-			return -EIO;
+		ofs = 0;
+		for (element = node->structure_value; element != NULL;
+		     element = element->next) {
+			len = kmip_ttlv_serialize(element, value + ofs);
+			if (len < 0)
+				return len;
+			ofs += len;
 		}
 		break;
 
 	case KMIP_TYPE_INTEGER:
 		int32 = htobe32(node->integer_value);
-		value_len = sizeof(int32);
-		value = &int32;
+		memcpy(value, &int32, sizeof(int32));
 		break;
 
 	case KMIP_TYPE_LONG_INTEGER:
 		int64 = htobe64(node->long_value);
-		value_len = sizeof(int64);
-		value = &int64;
+		memcpy(value, &int64, sizeof(int64));
 		break;
 
 	case KMIP_TYPE_BIG_INTEGER:
-		value_len = node->length; /* was already calculated above */
-		value = malloc(value_len);
-		if (value == NULL) {
-			kmip_debug(debug, "malloc failed");
-			return -ENOMEM;
-		}
 		rc = kmip_encode_bignum(node->big_integer_value, value,
-					value_len);
-		if (rc != 0) {
-			kmip_debug(debug, "kmip_encode_bignum failed");
-			goto out;
-		}
+					node->length);
+		if (rc != 0)
+			return rc;
 		break;
 
 	case KMIP_TYPE_ENUMERATION:
 		int32 = htobe32(node->enumeration_value);
-		value_len = sizeof(int32);
-		value = &int32;
+		memcpy(value, &int32, sizeof(int32));
 		break;
 
 	case KMIP_TYPE_BOOLEAN:
-		int64 = node->boolean_value ? 1 : 0;
-		value_len = sizeof(int64);
-		value = &int64;
+		int64 = htobe64(node->boolean_value ? 1 : 0);
+		memcpy(value, &int64, sizeof(int64));
 		break;
 
 	case KMIP_TYPE_TEXT_STRING:
-		value_len = node->length;
-		value = node->text_value;
+		if (node->length > 0)
+			memcpy(value, node->text_value, node->length);
 		break;
 
 	case KMIP_TYPE_BYTE_STRING:
-		value_len = node->length;
-		value = node->bytes_value;
+		if (node->length > 0)
+			memcpy(value, node->bytes_value, node->length);
 		break;
 
 	case KMIP_TYPE_DATE_TIME:
 		int64 = htobe64(node->date_time_value);
-		value_len = sizeof(int64);
-		value = &int64;
+		memcpy(value, &int64, sizeof(int64));
 		break;
 
 	case KMIP_TYPE_INTERVAL:
 		int32 = htobe32(node->interval_value);
-		value_len = sizeof(int32);
-		value = &int32;
+		memcpy(value, &int32, sizeof(int32));
 		break;
 
 	case KMIP_TYPE_DATE_TIME_EXTENDED:
 		int64 = htobe64(node->date_time_ext_value);
-		value_len = sizeof(int64);
-		value = &int64;
+		memcpy(value, &int64, sizeof(int64));
 		break;
 
 	default:
-		kmip_debug(debug, "unknown type: 0x%x", node->type);
 		return -EINVAL;
 	}
 
-	if (value != NULL) {
-		if (BIO_write(bio, value, value_len) != (int)value_len) {
-			kmip_debug(debug, "BIO_write failed");
-			rc = -EIO;
-			goto out;
-		}
+	return KMIP_TTLV_HEADER_LENGTH + KMIP_TTLV_PADDED(node->length);
+}
 
+/**
+ * Encode a KMIP node into a newly allocated buffer using the TTLV encoding.
+ * The lengths of all nodes are calculated in one pass, and the node is then
+ * serialized into one contiguous buffer.
+ *
+ * @param node              the node to encode
+ * @param buffer            On return: the allocated buffer with the encoded
+ *                          data. Must be freed by the caller.
+ * @param size              On return: the size of the encoded data
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_encode_ttlv_buffer(struct kmip_node *node, unsigned char **buffer,
+			    size_t *size, bool debug)
+{
+	unsigned char *buf;
+	size_t len;
+	ssize_t rc;
+
+	if (node == NULL || buffer == NULL || size == NULL)
+		return -EINVAL;
+
+	rc = kmip_ttlv_prepare(node, &len);
+	if (rc != 0) {
+		kmip_debug(debug, "kmip_ttlv_prepare failed");
+		return rc;
 	}
-	*size += value_len;
 
-	if ((value_len % KMIP_TTLV_BLOCK_LENGTH) != 0) {
-		pad_len = KMIP_TTLV_BLOCK_LENGTH -
-					(value_len % KMIP_TTLV_BLOCK_LENGTH);
+	/* Zeroed memory takes care of all paddings */
+	buf = calloc(1, len);
+	if (buf == NULL) {
+		kmip_debug(debug, "calloc failed");
+		return -ENOMEM;
+	}
 
-		kmip_debug(debug, "pad_len: %lu", pad_len);
-		if (BIO_write(bio, padding, pad_len) != (int)pad_len) {
-			kmip_debug(debug, "BIO_write failed (padding)");
-			rc = -EIO;
-			goto out;
-		}
-		*size += pad_len;
+	rc = kmip_ttlv_serialize(node, buf);
+	if (rc < 0) {
+		kmip_debug(debug, "kmip_ttlv_serialize failed");
+		free(buf);
+		return rc;
+	}
+	if ((size_t)rc != len) {
+		kmip_debug(debug, "written length %ld not as expected (%lu)",
+			   rc, len);
+		free(buf);
+		return -EIO;
 	}
 
-	kmip_debug(debug, "size: %lu", *size);
+	kmip_debug(debug, "size: %lu", len);
 
-	rc = 0;
-out:
-	if (node->type == KMIP_TYPE_BIG_INTEGER)
-		free(value);
+	*buffer = buf;
+	*size = len;
+	return 0;
+}
 
+/**
+ * Encode a KMIP node into a BIO using the TTLV encoding.
+ *
+ * @param node              the node to encode
+ * @param bio               the OpenSSL bio to write the data to
+ * @param size              On return: the number of bytes written to BIO
+ * @param debug             if true, debug messages are printed
+ *
+ * @returns 0 in case of success, or a negative errno value
+ */
+int kmip_encode_ttlv(struct kmip_node *node, BIO *bio, size_t *size,
+		     bool debug)
+{
+	unsigned char *buf = NULL;
+	size_t len;
+	int rc;
+
+	if (bio == NULL || node == NULL || size == NULL)
+		return -EINVAL;
+
+	*size = 0;
+
+	rc = kmip_encode_ttlv_buffer(node, &buf, &len, debug);
+	if (rc != 0)
+		return rc;
+
+	if (BIO_write(bio, buf, len) != (int)len) {
+		kmip_debug(debug, "BIO_write failed");
+		rc = -EIO;
+		goto out;
+	}
+	*size = len;
+
+out:
+	free(buf);
 	return rc;
 }
-
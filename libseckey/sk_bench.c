@@ -0,0 +1,302 @@
+/*
+ * libseckey - Secure key library
+ *
+ * Benchmark for signing with secure keys from multiple threads
+ *
+ * The secure key functions are simulated with a clear EC key and an optional
+ * delay per operation that models the crypto adapter latency, so that the
+ * overhead and the scalability of the secure key provider are measured, not
+ * the one of the adapters. Each thread signs with the same PKEY, like a TLS
+ * server does for its handshakes. Not installed, run with 'make bench'.
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <openssl/evp.h>
+#include <openssl/err.h>
+
+#include "lib/zt_common.h"
+
+#include "libseckey/sk_openssl.h"
+
+#if OPENSSL_VERSION_PREREQ(3, 0)
+
+#include <openssl/core_names.h>
+
+#define BENCH_DEFAULT_ITERATIONS	2000
+#define BENCH_DEFAULT_LATENCY_US	200
+#define BENCH_DEFAULT_MAX_THREADS	16
+
+#define BENCH_PRIME_LEN			32
+
+struct bench_adapter {
+	OSSL_LIB_CTX *libctx;
+	EVP_PKEY *clear_key;
+	unsigned int latency_us;
+};
+
+struct bench_thread {
+	pthread_t thread;
+	EVP_PKEY *pkey;
+	unsigned int iterations;
+	int rc;
+};
+
+static const unsigned char bench_secure_key[128] = { 0x1e, 0x00, 0x00, 0x00 };
+static const unsigned char bench_data[] = "TLS 1.3, server CertificateVerify";
+
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Simulated secure key ECDSA sign function: sign with the clear key in a
+ * separate library context after waiting for the adapter latency
+ */
+static int bench_ecdsa_sign(const unsigned char *UNUSED(key_blob),
+			    size_t UNUSED(key_blob_length), unsigned char *sig,
+			    size_t *siglen, const unsigned char *tbs,
+			    size_t tbslen, int UNUSED(md_nid), void *private,
+			    bool UNUSED(debug))
+{
+	struct bench_adapter *adapter = private;
+	struct timespec ts;
+	EVP_PKEY_CTX *ctx;
+	int rc = -EIO;
+
+	if (adapter->latency_us > 0) {
+		ts.tv_sec = adapter->latency_us / 1000000;
+		ts.tv_nsec = (adapter->latency_us % 1000000) * 1000;
+		nanosleep(&ts, NULL);
+	}
+
+	ctx = EVP_PKEY_CTX_new_from_pkey(adapter->libctx, adapter->clear_key,
+					 NULL);
+	if (ctx == NULL)
+		return -ENOMEM;
+
+	if (EVP_PKEY_sign_init(ctx) == 1 &&
+	    EVP_PKEY_sign(ctx, sig, siglen, tbs, tbslen) == 1)
+		rc = 0;
+
+	EVP_PKEY_CTX_free(ctx);
+	return rc;
+}
+
+static const struct sk_funcs bench_funcs = {
+	.ecdsa_sign = bench_ecdsa_sign,
+};
+
+static int bench_get_pkey(struct bench_adapter *adapter, EVP_PKEY **pkey)
+{
+	unsigned char x[BENCH_PRIME_LEN], y[BENCH_PRIME_LEN];
+	struct sk_pub_key_info pub_key;
+	BIGNUM *bx = NULL, *by = NULL;
+	int rc = -EIO;
+
+	adapter->clear_key = EVP_PKEY_Q_keygen(adapter->libctx, NULL, "EC",
+					       "P-256");
+	if (adapter->clear_key == NULL)
+		return -EIO;
+
+	if (EVP_PKEY_get_bn_param(adapter->clear_key,
+				  OSSL_PKEY_PARAM_EC_PUB_X, &bx) != 1 ||
+	    EVP_PKEY_get_bn_param(adapter->clear_key,
+				  OSSL_PKEY_PARAM_EC_PUB_Y, &by) != 1 ||
+	    BN_bn2binpad(bx, x, sizeof(x)) != sizeof(x) ||
+	    BN_bn2binpad(by, y, sizeof(y)) != sizeof(y))
+		goto out;
+
+	pub_key.type = SK_KEY_TYPE_EC;
+	pub_key.ec.curve_nid = NID_X9_62_prime256v1;
+	pub_key.ec.prime_len = BENCH_PRIME_LEN;
+	pub_key.ec.x = x;
+	pub_key.ec.y = y;
+
+	rc = SK_OPENSSL_get_pkey(bench_secure_key, sizeof(bench_secure_key),
+				 &pub_key, false, &bench_funcs, adapter, pkey,
+				 false);
+
+out:
+	BN_free(bx);
+	BN_free(by);
+	return rc;
+}
+
+/*
+ * Sign with a new digest sign context per operation, and verify the
+ * signature with the clear key
+ */
+static int bench_sign(EVP_PKEY *pkey, EVP_PKEY *verify_key)
+{
+	unsigned char sig[256];
+	size_t siglen = sizeof(sig);
+	EVP_MD_CTX *md_ctx;
+	int rc = -EIO;
+
+	md_ctx = EVP_MD_CTX_new();
+	if (md_ctx == NULL)
+		return -ENOMEM;
+
+	if (EVP_DigestSignInit_ex(md_ctx, NULL, "SHA256", NULL, NULL, pkey,
+				  NULL) != 1 ||
+	    EVP_DigestSign(md_ctx, sig, &siglen, bench_data,
+			   sizeof(bench_data)) != 1)
+		goto out;
+
+	if (verify_key != NULL) {
+		EVP_MD_CTX_reset(md_ctx);
+		if (EVP_DigestVerifyInit_ex(md_ctx, NULL, "SHA256", NULL, NULL,
+					    verify_key, NULL) != 1 ||
+		    EVP_DigestVerify(md_ctx, sig, siglen, bench_data,
+				     sizeof(bench_data)) != 1)
+			goto out;
+	}
+
+	rc = 0;
+
+out:
+	EVP_MD_CTX_free(md_ctx);
+	return rc;
+}
+
+static void *bench_thread(void *arg)
+{
+	struct bench_thread *t = arg;
+	unsigned int i;
+
+	for (i = 0; i < t->iterations; i++) {
+		t->rc = bench_sign(t->pkey, NULL);
+		if (t->rc != 0) {
+			ERR_print_errors_fp(stderr);
+			break;
+		}
+	}
+	return NULL;
+}
+
+static int bench_threads(EVP_PKEY *pkey, unsigned int num_threads,
+			 unsigned int iterations, unsigned int latency_us)
+{
+	struct bench_thread *threads;
+	unsigned int i, started;
+	double start, elapsed;
+	int rc = 0;
+
+	threads = calloc(num_threads, sizeof(*threads));
+	if (threads == NULL)
+		return -ENOMEM;
+
+	start = bench_now();
+	for (started = 0; started < num_threads; started++) {
+		threads[started].pkey = pkey;
+		threads[started].iterations = iterations;
+		rc = -pthread_create(&threads[started].thread, NULL,
+				     bench_thread, &threads[started]);
+		if (rc != 0)
+			break;
+	}
+	for (i = 0; i < started; i++) {
+		pthread_join(threads[i].thread, NULL);
+		if (rc == 0)
+			rc = threads[i].rc;
+	}
+	elapsed = bench_now() - start;
+	free(threads);
+	if (rc != 0)
+		return rc;
+
+	printf("  %5u us latency %3u threads: %10.0f signs/s\n", latency_us,
+	       num_threads, num_threads * iterations / elapsed);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int max_threads = BENCH_DEFAULT_MAX_THREADS;
+	unsigned int iterations = BENCH_DEFAULT_ITERATIONS;
+	struct bench_adapter adapter = { 0 };
+	unsigned int num_threads, latency;
+	EVP_PKEY *pkey = NULL;
+	int rc;
+
+	adapter.latency_us = BENCH_DEFAULT_LATENCY_US;
+	if (argc > 1)
+		iterations = strtoul(argv[1], NULL, 10);
+	if (argc > 2)
+		adapter.latency_us = strtoul(argv[2], NULL, 10);
+	if (argc > 3)
+		max_threads = strtoul(argv[3], NULL, 10);
+	if (iterations == 0 || max_threads == 0) {
+		fprintf(stderr,
+			"Usage: %s [ITERATIONS [LATENCY_US [MAX_THREADS]]]\n",
+			argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	rc = SK_OPENSSL_init(false);
+	if (rc != 0) {
+		fprintf(stderr, "SK_OPENSSL_init failed: %s\n", strerror(-rc));
+		return EXIT_FAILURE;
+	}
+
+	adapter.libctx = OSSL_LIB_CTX_new();
+	if (adapter.libctx == NULL) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	rc = bench_get_pkey(&adapter, &pkey);
+	if (rc == 0)
+		rc = bench_sign(pkey, adapter.clear_key);
+	if (rc != 0)
+		goto out;
+
+	printf("%u ECDSA P-256 signs per thread\n", iterations);
+	latency = adapter.latency_us;
+	for (adapter.latency_us = 0; rc == 0;
+	     adapter.latency_us = latency) {
+		for (num_threads = 1; num_threads <= max_threads &&
+		     rc == 0; num_threads *= 2)
+			rc = bench_threads(pkey, num_threads, iterations,
+					   adapter.latency_us);
+		if (adapter.latency_us == latency)
+			break;
+	}
+
+out:
+	if (rc != 0) {
+		fprintf(stderr, "Signing failed: %s\n", strerror(-rc));
+		ERR_print_errors_fp(stderr);
+	}
+	EVP_PKEY_free(pkey);
+	EVP_PKEY_free(adapter.clear_key);
+	OSSL_LIB_CTX_free(adapter.libctx);
+	SK_OPENSSL_term();
+
+	return rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#else
+
+int main(void)
+{
+	fprintf(stderr, "The benchmark requires OpenSSL 3.0 or later\n");
+	return EXIT_FAILURE;
+}
+
+#endif
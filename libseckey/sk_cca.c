@@ -8,6 +8,7 @@
  */
 #include <dlfcn.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <err.h>
@@ -229,15 +230,39 @@ struct cca_rsa_crt_priv_key_section {
 
 #define POINT_CONVERSION_ODD_EVEN	0x01
 
+/*
+ * The CCA library function entry points resolved for a library handle.
+ * dlsym() serializes on the dynamic loader lock, so the entry points are
+ * resolved once and not for each operation. They are freed with
+ * sk_cca_free_library_functions() when the secure key support for OpenSSL is
+ * terminated.
+ */
+struct cca_lib_funcs {
+	void *cca_lib;
+	struct cca_lib cca;
+};
+
+static struct cca_lib_funcs *sk_cca_lib_funcs;
+
+void sk_cca_free_library_functions(void);
+
 /**
  * Gets the CCA library function entry points from the library handle
  */
 static int sk_cca_get_library_functions(const struct sk_ext_cca_lib *cca_lib,
 					struct cca_lib *cca)
 {
+	struct cca_lib_funcs *funcs, *expected = NULL;
+
 	if (cca_lib == NULL || cca == NULL)
 		return -EINVAL;
 
+	funcs = __atomic_load_n(&sk_cca_lib_funcs, __ATOMIC_ACQUIRE);
+	if (funcs != NULL && funcs->cca_lib == cca_lib->cca_lib) {
+		*cca = funcs->cca;
+		return 0;
+	}
+
 	cca->dll_CSNDPKG = (CSNDPKG_t)dlsym(cca_lib->cca_lib, "CSNDPKG");
 	cca->dll_CSNDPKB = (CSNDPKB_t)dlsym(cca_lib->cca_lib, "CSNDPKB");
 	cca->dll_CSNDKTC = (CSNDKTC_t)dlsym(cca_lib->cca_lib, "CSNDKTC");
@@ -249,9 +274,33 @@ static int sk_cca_get_library_functions(const struct sk_ext_cca_lib *cca_lib,
 	    cca->dll_CSNDPKD == NULL)
 		return -EIO;
 
+	/* Only the first library handle is remembered */
+	if (funcs != NULL)
+		return 0;
+
+	funcs = malloc(sizeof(*funcs));
+	if (funcs == NULL)
+		return 0;
+
+	funcs->cca_lib = cca_lib->cca_lib;
+	funcs->cca = *cca;
+	if (!__atomic_compare_exchange_n(&sk_cca_lib_funcs, &expected, funcs,
+					 false, __ATOMIC_RELEASE,
+					 __ATOMIC_RELAXED))
+		free(funcs);
+
 	return 0;
 }
 
+/**
+ * Frees the resolved CCA library function entry points. Must not be called
+ * while other threads use the CCA functions.
+ */
+void sk_cca_free_library_functions(void)
+{
+	free(__atomic_exchange_n(&sk_cca_lib_funcs, NULL, __ATOMIC_ACQ_REL));
+}
+
 /**
  * Generates an CCA EC key of the specified curve type and length using the
  * CCA host library.
@@ -8,6 +8,7 @@
  */
 #include <dlfcn.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
@@ -138,15 +139,39 @@ struct ep11kblob_header {
 
 #define POINT_CONVERSION_ODD_EVEN	0x01
 
+/*
+ * The EP11 library function entry points resolved for a library handle.
+ * dlsym() serializes on the dynamic loader lock, so the entry points are
+ * resolved once and not for each operation. They are freed with
+ * sk_ep11_free_library_functions() when the secure key support for OpenSSL is
+ * terminated.
+ */
+struct ep11_lib_funcs {
+	void *ep11_lib;
+	struct ep11_lib ep11;
+};
+
+static struct ep11_lib_funcs *sk_ep11_lib_funcs;
+
+void sk_ep11_free_library_functions(void);
+
 /**
  * Gets the Ep11 library function entry points from the library handle
  */
 static int sk_ep11_get_library_functions(const struct sk_ext_ep11_lib *ep11_lib,
 					 struct ep11_lib *ep11)
 {
+	struct ep11_lib_funcs *funcs, *expected = NULL;
+
 	if (ep11_lib == NULL || ep11 == NULL)
 		return -EINVAL;
 
+	funcs = __atomic_load_n(&sk_ep11_lib_funcs, __ATOMIC_ACQUIRE);
+	if (funcs != NULL && funcs->ep11_lib == ep11_lib->ep11_lib) {
+		*ep11 = funcs->ep11;
+		return 0;
+	}
+
 	ep11->dll_m_GenerateKeyPair = (m_GenerateKeyPair_t)
 			dlsym(ep11_lib->ep11_lib, "m_GenerateKeyPair");
 	ep11->dll_m_SignSingle = (m_SignSingle_t)
@@ -171,9 +196,33 @@ static int sk_ep11_get_library_functions(const struct sk_ext_ep11_lib *ep11_lib,
 	    ep11->dll_xcpa_internal_rv == NULL)
 		return -EIO;
 
+	/* Only the first library handle is remembered */
+	if (funcs != NULL)
+		return 0;
+
+	funcs = malloc(sizeof(*funcs));
+	if (funcs == NULL)
+		return 0;
+
+	funcs->ep11_lib = ep11_lib->ep11_lib;
+	funcs->ep11 = *ep11;
+	if (!__atomic_compare_exchange_n(&sk_ep11_lib_funcs, &expected, funcs,
+					 false, __ATOMIC_RELEASE,
+					 __ATOMIC_RELAXED))
+		free(funcs);
+
 	return 0;
 }
 
+/**
+ * Frees the resolved EP11 library function entry points. Must not be called
+ * while other threads use the EP11 functions.
+ */
+void sk_ep11_free_library_functions(void)
+{
+	free(__atomic_exchange_n(&sk_ep11_lib_funcs, NULL, __ATOMIC_ACQ_REL));
+}
+
 /**
  * Generates an EP11 asymmetric key using the specified key type, mechanism, and
  * templates.
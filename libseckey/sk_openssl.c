@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdarg.h>
 #include <sys/stat.h>
@@ -31,6 +32,45 @@
 
 #define SERIAL_NUMBER_BIT_SIZE		159
 
+#define SK_KEY_CACHE_SIZE		32
+
+/*
+ * Copy of an external library structure that cached PKEYs refer to, since
+ * the caller's one may be gone before the PKEY is freed. A copy is shared by
+ * all PKEYs of the same external library (and EP11 target), and is kept until
+ * the secure key support for OpenSSL is terminated.
+ */
+struct sk_ext_lib_copy {
+	struct sk_ext_lib_copy *next;
+	enum sk_ext_lib_type type;
+	union {
+		struct sk_ext_cca_lib cca;
+		struct sk_ext_ep11_lib ep11;
+	};
+};
+
+/*
+ * Cache of the PKEYs of secure keys, so that a secure key that is used
+ * repeatedly is parsed and imported into OpenSSL only once. An entry is
+ * identified by the SHA-256 hash of the secure key and the external library.
+ * Once the cache is full, the least recently used entry is evicted. The cache
+ * is freed when the secure key support for OpenSSL is terminated.
+ */
+struct sk_key_cache_entry {
+	unsigned char hash[SHA256_DIGEST_LENGTH];
+	size_t secure_key_size;
+	bool rsa_pss;
+	struct sk_ext_lib_copy *lib;
+	unsigned long last_used;
+	EVP_PKEY *pkey;
+};
+
+static pthread_mutex_t sk_key_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct sk_key_cache_entry sk_key_cache[SK_KEY_CACHE_SIZE];
+static unsigned int sk_key_cache_num;
+static unsigned long sk_key_cache_clock;
+static struct sk_ext_lib_copy *sk_ext_lib_copies;
+
 int sk_openssl_get_pkey_ec(const unsigned char *secure_key,
 			   size_t secure_key_size, int nid, size_t prime_len,
 			   const unsigned char *x, const unsigned char *y,
@@ -44,6 +84,10 @@ int sk_openssl_get_pkey_rsa(const unsigned char *secure_key,
 			    int pkey_type, const struct sk_funcs *sk_funcs,
 			    const void *private, EVP_PKEY **pkey, bool debug);
 
+void sk_openssl_free_caches(void);
+void sk_cca_free_library_functions(void);
+void sk_ep11_free_library_functions(void);
+
 /**
  * Generate a secure key using the specified secure key crypto library.
  *
@@ -185,8 +229,173 @@ int SK_OPENSSL_reencipher_secure_key(unsigned char *secure_key,
 	return 0;
 }
 
+static int sk_openssl_get_pkey_ext_lib(const unsigned char *secure_key,
+					size_t secure_key_size, bool rsa_pss,
+					EVP_PKEY **pkey,
+					const struct sk_ext_lib *ext_lib,
+					bool debug)
+{
+	switch (ext_lib->type) {
+	case SK_EXT_LIB_CCA:
+		return SK_CCA_get_secure_key_as_pkey(ext_lib->cca, secure_key,
+						     secure_key_size, rsa_pss,
+						     pkey, debug);
+
+	case SK_EXT_LIB_EP11:
+		return SK_EP11_get_secure_key_as_pkey(ext_lib->ep11, secure_key,
+						      secure_key_size, rsa_pss,
+						      pkey, debug);
+
+	default:
+		sk_debug(debug, "ERROR: Invalid ext lib type: %d",
+			 ext_lib->type);
+		return -EINVAL;
+	}
+}
+
+/*
+ * Returns the shared copy of an external library structure, and allocates it
+ * if it does not exist yet. Returns NULL if out of memory. Must be called with
+ * the key cache mutex held.
+ */
+static struct sk_ext_lib_copy *sk_openssl_get_ext_lib_copy(
+					const struct sk_ext_lib *ext_lib)
+{
+	struct sk_ext_lib_copy *lib;
+
+	for (lib = sk_ext_lib_copies; lib != NULL; lib = lib->next) {
+		if (lib->type != ext_lib->type)
+			continue;
+
+		switch (ext_lib->type) {
+		case SK_EXT_LIB_CCA:
+			if (lib->cca.cca_lib == ext_lib->cca->cca_lib)
+				return lib;
+			break;
+		case SK_EXT_LIB_EP11:
+			if (lib->ep11.ep11_lib == ext_lib->ep11->ep11_lib &&
+			    lib->ep11.target == ext_lib->ep11->target)
+				return lib;
+			break;
+		}
+	}
+
+	lib = calloc(1, sizeof(*lib));
+	if (lib == NULL)
+		return NULL;
+
+	lib->type = ext_lib->type;
+	switch (ext_lib->type) {
+	case SK_EXT_LIB_CCA:
+		lib->cca = *ext_lib->cca;
+		break;
+	case SK_EXT_LIB_EP11:
+		lib->ep11 = *ext_lib->ep11;
+		break;
+	}
+
+	lib->next = sk_ext_lib_copies;
+	sk_ext_lib_copies = lib;
+	return lib;
+}
+
+/*
+ * Finds the cache entry of a secure key, and marks it as recently used. Must
+ * be called with the key cache mutex held.
+ */
+static struct sk_key_cache_entry *sk_openssl_find_cached_key(
+					const unsigned char *hash,
+					size_t secure_key_size, bool rsa_pss,
+					const struct sk_ext_lib_copy *lib)
+{
+	struct sk_key_cache_entry *entry;
+	unsigned int i;
+
+	for (i = 0; i < sk_key_cache_num; i++) {
+		entry = &sk_key_cache[i];
+		if (entry->lib != lib ||
+		    entry->rsa_pss != rsa_pss ||
+		    entry->secure_key_size != secure_key_size ||
+		    memcmp(entry->hash, hash, sizeof(entry->hash)) != 0)
+			continue;
+
+		entry->last_used = ++sk_key_cache_clock;
+		return entry;
+	}
+
+	return NULL;
+}
+
+/*
+ * Adds the PKEY of a secure key to the cache. If the cache is full, the least
+ * recently used entry is evicted. Must be called with the key cache mutex
+ * held.
+ */
+static void sk_openssl_add_cached_key(const unsigned char *hash,
+				      size_t secure_key_size, bool rsa_pss,
+				      struct sk_ext_lib_copy *lib,
+				      EVP_PKEY *pkey, bool debug)
+{
+	struct sk_key_cache_entry *entry;
+	unsigned int i;
+
+	if (EVP_PKEY_up_ref(pkey) != 1)
+		return;
+
+	if (sk_key_cache_num < SK_KEY_CACHE_SIZE) {
+		entry = &sk_key_cache[sk_key_cache_num++];
+	} else {
+		entry = &sk_key_cache[0];
+		for (i = 1; i < SK_KEY_CACHE_SIZE; i++) {
+			if (sk_key_cache[i].last_used < entry->last_used)
+				entry = &sk_key_cache[i];
+		}
+		sk_debug(debug, "key cache full, evict pkey: %p", entry->pkey);
+		EVP_PKEY_free(entry->pkey);
+	}
+
+	memcpy(entry->hash, hash, sizeof(entry->hash));
+	entry->secure_key_size = secure_key_size;
+	entry->rsa_pss = rsa_pss;
+	entry->lib = lib;
+	entry->last_used = ++sk_key_cache_clock;
+	entry->pkey = pkey;
+}
+
+/**
+ * Frees the cached PKEYs of secure keys, the external library structures they
+ * refer to, and the resolved external library functions. Called when the
+ * secure key support for OpenSSL is terminated. PKEYs of secure keys can not
+ * be used afterwards, even if the caller still holds a reference.
+ */
+void sk_openssl_free_caches(void)
+{
+	struct sk_ext_lib_copy *lib;
+	unsigned int i;
+
+	pthread_mutex_lock(&sk_key_cache_mutex);
+	for (i = 0; i < sk_key_cache_num; i++)
+		EVP_PKEY_free(sk_key_cache[i].pkey);
+	memset(sk_key_cache, 0, sizeof(sk_key_cache));
+	sk_key_cache_num = 0;
+	sk_key_cache_clock = 0;
+	while ((lib = sk_ext_lib_copies) != NULL) {
+		sk_ext_lib_copies = lib->next;
+		free(lib);
+	}
+	pthread_mutex_unlock(&sk_key_cache_mutex);
+
+	sk_cca_free_library_functions();
+	sk_ep11_free_library_functions();
+}
+
 /**
  * Extracts the public key from a secure key, and returns it as OpenSSL PKEY.
+ * The PKEY of a secure key is cached, and the same PKEY is returned when the
+ * same secure key is requested again with the same external library, as long
+ * as it has not been evicted from the cache. The returned PKEY must be freed
+ * by the caller with EVP_PKEY_free(), and must not be modified. It can not be
+ * used after SK_OPENSSL_term() has been called.
  *
  * @param secure_key        the key token containing an secure key
  * @param secure_key_size   the size of the key token
@@ -204,6 +413,10 @@ int SK_OPENSSL_get_secure_key_as_pkey(const unsigned char *secure_key,
 				      const struct sk_ext_lib *ext_lib,
 				      bool debug)
 {
+	unsigned char hash[SHA256_DIGEST_LENGTH];
+	struct sk_key_cache_entry *entry;
+	struct sk_ext_lib_copy *lib = NULL;
+	struct sk_ext_lib cached_ext_lib;
 	int rc;
 
 	if (ext_lib == NULL || secure_key == NULL || pkey == NULL)
@@ -211,32 +424,67 @@ int SK_OPENSSL_get_secure_key_as_pkey(const unsigned char *secure_key,
 
 	sk_debug(debug, "ext-lib type: %d rsa_pss: %d", ext_lib->type, rsa_pss);
 
-	switch (ext_lib->type) {
-	case SK_EXT_LIB_CCA:
-		rc = SK_CCA_get_secure_key_as_pkey(ext_lib->cca, secure_key,
-						   secure_key_size, rsa_pss,
-						   pkey, debug);
-		break;
+	/* The cca and ep11 pointers share the same union */
+	if ((ext_lib->type == SK_EXT_LIB_CCA ||
+	     ext_lib->type == SK_EXT_LIB_EP11) && ext_lib->cca != NULL &&
+	    SHA256(secure_key, secure_key_size, hash) != NULL) {
+		pthread_mutex_lock(&sk_key_cache_mutex);
+
+		lib = sk_openssl_get_ext_lib_copy(ext_lib);
+		entry = lib != NULL ? sk_openssl_find_cached_key(hash,
+						secure_key_size, rsa_pss, lib) :
+				      NULL;
+		if (entry != NULL) {
+			rc = EVP_PKEY_up_ref(entry->pkey) == 1 ? 0 : -EIO;
+			if (rc == 0)
+				*pkey = entry->pkey;
+			sk_debug(debug, "cached pkey: %p", entry->pkey);
+			pthread_mutex_unlock(&sk_key_cache_mutex);
+			return rc;
+		}
 
-	case SK_EXT_LIB_EP11:
-		rc = SK_EP11_get_secure_key_as_pkey(ext_lib->ep11, secure_key,
-						    secure_key_size, rsa_pss,
-						    pkey, debug);
-		break;
+		pthread_mutex_unlock(&sk_key_cache_mutex);
+	}
 
-	default:
-		sk_debug(debug, "ERROR: Invalid ext lib type: %d",
-			 ext_lib->type);
-		return -EINVAL;
+	if (lib != NULL) {
+		cached_ext_lib.type = lib->type;
+		if (lib->type == SK_EXT_LIB_CCA)
+			cached_ext_lib.cca = &lib->cca;
+		else
+			cached_ext_lib.ep11 = &lib->ep11;
+		ext_lib = &cached_ext_lib;
 	}
 
+	/* Import without the mutex held, it may take long on a cache miss */
+	rc = sk_openssl_get_pkey_ext_lib(secure_key, secure_key_size, rsa_pss,
+					 pkey, ext_lib, debug);
 	if (rc != 0) {
 		sk_debug(debug, "ERROR: Failed to get PKEY: rc: %d - %s",
 			 rc, strerror(-rc));
 		return rc;
 	}
 
+	if (lib != NULL) {
+		pthread_mutex_lock(&sk_key_cache_mutex);
+
+		/* Another thread may have cached the same key meanwhile */
+		entry = sk_openssl_find_cached_key(hash, secure_key_size,
+						   rsa_pss, lib);
+		if (entry != NULL) {
+			if (EVP_PKEY_up_ref(entry->pkey) == 1) {
+				EVP_PKEY_free(*pkey);
+				*pkey = entry->pkey;
+			}
+		} else {
+			sk_openssl_add_cached_key(hash, secure_key_size,
+						  rsa_pss, lib, *pkey, debug);
+		}
+
+		pthread_mutex_unlock(&sk_key_cache_mutex);
+	}
+
 	sk_debug(debug, "pkey: %p", *pkey);
+
 	return 0;
 }
 
@@ -57,6 +57,8 @@ int sk_openssl_get_pkey_rsa(const unsigned char *secure_key,
 			    int pkey_type, const struct sk_funcs *sk_funcs,
 			    const void *private, EVP_PKEY **pkey, bool debug);
 
+void sk_openssl_free_caches(void);
+
 #define sk_debug_data(data, fmt...)	sk_debug(data->debug, fmt)
 
 static void sk_pkey_meth_put_error(int err, const char *file, int line,
@@ -843,6 +845,9 @@ int SK_OPENSSL_init(bool debug)
  */
 void SK_OPENSSL_term(void)
 {
+	/* The cached PKEYs refer to the secure key PKEY methods */
+	sk_openssl_free_caches();
+
 	if (sk_pkey_data_ec_index >= 0)
 		CRYPTO_free_ex_index(CRYPTO_EX_INDEX_EC_KEY,
 				     sk_pkey_data_ec_index);
@@ -91,7 +91,9 @@ struct sk_prov_key {
 	size_t secure_key_size;
 	struct sk_funcs *funcs;
 	void *private;
-	unsigned int ref_count;
+	unsigned long ref_count;
+	int max_size; /* cached OSSL_PKEY_PARAM_MAX_SIZE, 0 if not yet known */
+	int bits; /* cached OSSL_PKEY_PARAM_BITS, 0 if not yet known */
 };
 
 struct sk_prov_op_ctx {
@@ -124,6 +126,8 @@ int sk_openssl_get_pkey_rsa(const unsigned char *secure_key,
 			    int pkey_type, const struct sk_funcs *sk_funcs,
 			    const void *private, EVP_PKEY **pkey, bool debug);
 
+void sk_openssl_free_caches(void);
+
 
 static OSSL_FUNC_provider_teardown_fn		sk_prov_teardown;
 static OSSL_FUNC_provider_gettable_params_fn	sk_prov_gettable_params;
@@ -133,6 +137,7 @@ static OSSL_FUNC_provider_get_reason_strings_fn	sk_prov_get_reason_strings;
 static OSSL_FUNC_provider_get_capabilities_fn	sk_prov_prov_get_capabilities;
 
 static OSSL_FUNC_keymgmt_free_fn		sk_prov_keymgmt_free;
+static OSSL_FUNC_keymgmt_dup_fn			sk_prov_keymgmt_dup;
 static OSSL_FUNC_keymgmt_gen_cleanup_fn		sk_prov_keymgmt_gen_cleanup;
 static OSSL_FUNC_keymgmt_load_fn		sk_prov_keymgmt_load;
 static OSSL_FUNC_keymgmt_gen_set_template_fn
@@ -348,7 +353,7 @@ static func_t sk_prov_get_default_func(struct sk_prov_ctx *provctx,
 				       const char *algorithm,
 				       int function_id)
 {
-	const OSSL_ALGORITHM *default_algos, *algs;
+	const OSSL_ALGORITHM *default_algos, *algs, *expected;
 	const OSSL_DISPATCH *default_impl, *impl;
 	int algolen = strlen(algorithm);
 	int no_cache = 0, query = 0;
@@ -362,7 +367,9 @@ static func_t sk_prov_get_default_func(struct sk_prov_ctx *provctx,
 	sk_debug_ctx(provctx, "operation_id: %d, algo: %s, func: %d",
 		     operation_id, algorithm, function_id);
 
-	default_algos = provctx->cached_default_algos[operation_id];
+	default_algos = __atomic_load_n(
+			&provctx->cached_default_algos[operation_id],
+			__ATOMIC_ACQUIRE);
 	if (default_algos == NULL) {
 		default_algos = OSSL_PROVIDER_query_operation(
 				provctx->default_provider,
@@ -395,9 +402,17 @@ static func_t sk_prov_get_default_func(struct sk_prov_ctx *provctx,
 						operation_id,
 						default_algos);
 
-	if (no_cache == 0 &&
-	    provctx->cached_default_algos[operation_id] == NULL)
-		provctx->cached_default_algos[operation_id] = default_algos;
+	/*
+	 * The provider may be used by multiple threads concurrently. If
+	 * another thread has cached the algorithms meanwhile, keep its ones.
+	 */
+	if (no_cache == 0 && query == 1 && default_algos != NULL) {
+		expected = NULL;
+		__atomic_compare_exchange_n(
+			&provctx->cached_default_algos[operation_id],
+			&expected, default_algos, false, __ATOMIC_RELEASE,
+			__ATOMIC_RELAXED);
+	}
 
 	sk_debug_ctx(provctx, "func: %p", func);
 	return func;
@@ -508,7 +523,7 @@ static const OSSL_PARAM *sk_prov_get_cached_params(struct sk_prov_ctx *provctx,
 		return NULL;
 	}
 
-	return provctx->cached_parms[index];
+	return __atomic_load_n(&provctx->cached_parms[index], __ATOMIC_ACQUIRE);
 }
 
 static const OSSL_PARAM *sk_prov_cached_params_build(
@@ -520,6 +535,7 @@ static const OSSL_PARAM *sk_prov_cached_params_build(
 						const OSSL_PARAM *params2)
 {
 	int index, count = 0, i, k = 0;
+	const OSSL_PARAM *expected = NULL;
 	OSSL_PARAM *params;
 
 	sk_debug_ctx(provctx, "pkey_type: %d operation: %d selection: %x",
@@ -533,11 +549,6 @@ static const OSSL_PARAM *sk_prov_cached_params_build(
 		return NULL;
 	}
 
-	if (provctx->cached_parms[index] != NULL) {
-		OPENSSL_free((void *)provctx->cached_parms[index]);
-		provctx->cached_parms[index] = NULL;
-	}
-
 	for (i = 0; params1 != NULL && params1[i].key != NULL; i++, count++)
 		;
 	for (i = 0; params2 != NULL && params2[i].key != NULL; i++, count++)
@@ -563,8 +574,18 @@ static const OSSL_PARAM *sk_prov_cached_params_build(
 	}
 	params[k] = OSSL_PARAM_construct_end();
 
-	provctx->cached_parms[index] = params;
-	return provctx->cached_parms[index];
+	/*
+	 * Another thread may have built the same parameters meanwhile. Its
+	 * ones may already be in use, so keep them and free ours.
+	 */
+	if (!__atomic_compare_exchange_n(&provctx->cached_parms[index],
+					 &expected, params, false,
+					 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		OPENSSL_free(params);
+		return expected;
+	}
+
+	return params;
 }
 
 #pragma GCC diagnostic push
@@ -2384,23 +2405,26 @@ static int sk_prov_sign_op_digest_verify_final(void *vctx,
 
 static void sk_prov_keymgmt_upref(struct sk_prov_key *key)
 {
+	unsigned long ref_count;
+
 	sk_debug_key(key, "key: %p", key);
 
-	key->ref_count++;
+	ref_count = __sync_add_and_fetch(&key->ref_count, 1);
 
-	sk_debug_key(key, "ref_count: %u", key->ref_count);
+	sk_debug_key(key, "ref_count: %lu", ref_count);
 }
 
-static unsigned int sk_prov_keymgmt_downref(struct sk_prov_key *key)
+static unsigned long sk_prov_keymgmt_downref(struct sk_prov_key *key)
 {
+	unsigned long ref_count;
+
 	sk_debug_key(key, "key: %p ", key);
 
-	if (key->ref_count > 0)
-		key->ref_count--;
+	ref_count = __sync_sub_and_fetch(&key->ref_count, 1);
 
-	sk_debug_key(key, "ref_count: %u", key->ref_count);
+	sk_debug_key(key, "ref_count: %lu", ref_count);
 
-	return key->ref_count;
+	return ref_count;
 }
 
 static struct sk_prov_key *sk_prov_keymgmt_new(struct sk_prov_ctx *provctx,
@@ -2477,6 +2501,77 @@ static void sk_prov_keymgmt_free(void *vkey)
 	OPENSSL_free(key);
 }
 
+/*
+ * The private part of a secure key is not exported (see
+ * sk_prov_keymgmt_export), so copies of a key, e.g. via EVP_PKEY_dup(), can
+ * not be made by an export and import round trip. Duplicate the key directly
+ * instead, together with its secure key.
+ */
+static void *sk_prov_keymgmt_dup(const void *vkey, int selection)
+{
+	OSSL_FUNC_keymgmt_dup_fn *default_dup_fn;
+	const struct sk_prov_key *key = vkey;
+	struct sk_prov_key *new_key;
+
+	if (key == NULL)
+		return NULL;
+
+	sk_debug_key(key, "key: %p selection: %x", key, selection);
+
+	default_dup_fn = (OSSL_FUNC_keymgmt_dup_fn *)
+			sk_prov_get_default_keymgmt_func(key->provctx,
+					key->type, OSSL_FUNC_KEYMGMT_DUP);
+	if (default_dup_fn == NULL) {
+		put_error_key(key, SK_PROV_ERR_DEFAULT_PROV_FUNC_MISSING,
+			      "no default dup_fn");
+		return NULL;
+	}
+
+	new_key = OPENSSL_zalloc(sizeof(struct sk_prov_key));
+	if (new_key == NULL) {
+		put_error_key(key, SK_PROV_ERR_MALLOC_FAILED,
+			      "OPENSSL_zalloc failed");
+		return NULL;
+	}
+
+	new_key->provctx = key->provctx;
+	new_key->type = key->type;
+
+	if (key->secure_key != NULL &&
+	    (selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0) {
+		new_key->secure_key = OPENSSL_memdup(key->secure_key,
+						     key->secure_key_size);
+		if (new_key->secure_key == NULL) {
+			put_error_key(key, SK_PROV_ERR_MALLOC_FAILED,
+				      "OPENSSL_memdup failed");
+			OPENSSL_free(new_key);
+			return NULL;
+		}
+		new_key->secure_key_size = key->secure_key_size;
+		new_key->funcs = key->funcs;
+		new_key->private = key->private;
+	}
+
+	new_key->default_key = default_dup_fn(key->default_key, selection);
+	if (new_key->default_key == NULL) {
+		put_error_key(key, SK_PROV_ERR_DEFAULT_PROV_FUNC_FAILED,
+			      "default_dup_fn failed");
+		if (new_key->secure_key != NULL)
+			OPENSSL_free(new_key->secure_key);
+		OPENSSL_free(new_key);
+		return NULL;
+	}
+
+	new_key->max_size = key->max_size;
+	new_key->bits = key->bits;
+
+	sk_prov_keymgmt_upref(new_key);
+
+	sk_debug_key(key, "new_key: %p", new_key);
+
+	return new_key;
+}
+
 static int sk_prov_keymgmt_match(const void *vkey1, const void *vkey2,
 				 int selection)
 {
@@ -2632,6 +2727,8 @@ static int sk_prov_keymgmt_set_params(void *vkey, const OSSL_PARAM params[])
 				      "default_set_params_fn failed");
 			return 0;
 		}
+		key->max_size = 0;
+		key->bits = 0;
 	}
 
 	if (key->secure_key == NULL)
@@ -2771,77 +2868,10 @@ static int sk_prov_keymgmt_has(const void *vkey, int selection)
 	return default_has_fn(key->default_key, default_selection);
 }
 
-struct sk_prov_export_cb {
-	struct sk_prov_key *key;
-	OSSL_CALLBACK *param_callback;
-	void *cbarg;
-};
-
-static int sk_prov_keymgmt_export_cb(const OSSL_PARAM params[], void *arg)
-{
-	struct sk_prov_export_cb *cb_data = arg;
-	OSSL_PARAM *np, *new_params;
-	struct sk_prov_key *key;
-	const OSSL_PARAM *p;
-	int rc, count, i;
-
-	if (cb_data == NULL)
-		return 0;
-
-	key = cb_data->key;
-
-	sk_debug_key(key, "key: %p", key);
-
-	for (count = 0, p = params; p != NULL && p->key != NULL; p++, count++)
-		;
-	count += 3 + 1; /* 3 addl params plus end marker */
-
-	new_params = OPENSSL_zalloc(count * sizeof(OSSL_PARAM));
-	if (new_params == NULL) {
-		put_error_key(key, SK_PROV_ERR_MALLOC_FAILED,
-			      "OPENSSL_zalloc failed");
-		return 0;
-	}
-
-	for (i = 0, p = params; p != NULL && p->key != NULL; p++, i++) {
-		sk_debug_key(key, "param: key: %s", p->key);
-		new_params[i] = *p;
-	}
-
-	np = &new_params[i++];
-	*np = OSSL_PARAM_construct_octet_string(SK_PROV_PKEY_PARAM_SK_BLOB,
-						key->secure_key,
-						key->secure_key_size);
-	sk_debug_key(key, "param: key: %s", np->key);
-
-	np = &new_params[i++];
-	*np = OSSL_PARAM_construct_octet_ptr(SK_PROV_PKEY_PARAM_SK_FUNCS,
-					     (void **)key->funcs,
-					     sizeof(struct sk_funcs));
-	sk_debug_key(key, "param: key: %s", np->key);
-
-	np = &new_params[i++];
-	*np = OSSL_PARAM_construct_octet_ptr(SK_PROV_PKEY_PARAM_SK_PRIVATE,
-					     key->private, 0);
-	sk_debug_key(key, "param: key: %s", np->key);
-
-	np = &new_params[i++];
-	*np = OSSL_PARAM_construct_end();
-
-	rc = cb_data->param_callback(new_params, cb_data->cbarg);
-	if (rc != 1)
-		sk_debug_key(key, "ERROR: param_callback failed");
-
-	OPENSSL_free(new_params);
-
-	return rc;
-}
-
 static int sk_prov_keymgmt_export(void *vkey, int selection,
 				  OSSL_CALLBACK *param_callback, void *cbarg)
 {
 	OSSL_FUNC_keymgmt_export_fn *default_export_fn;
-	struct sk_prov_export_cb cb_data;
 	struct sk_prov_key *key = vkey;
 
 	if (key == NULL || param_callback == NULL)
@@ -2849,6 +2879,21 @@ static int sk_prov_keymgmt_export(void *vkey, int selection,
 
 	sk_debug_key(key, "key: %p selection: %x", key, selection);
 
+	/*
+	 * The private part of a secure key can only be used by this provider.
+	 * Exporting it to another provider gives a public key only, and an
+	 * operation fetched from that provider fails. This happens for threads
+	 * that do not have the secure key library context as default library
+	 * context. Refuse the export, so that OpenSSL uses the operation of
+	 * this provider instead. Don't put an error, since OpenSSL continues
+	 * with the next provider and the error would stay in the error queue.
+	 */
+	if (key->secure_key != NULL &&
+	    (selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0) {
+		sk_debug_key(key, "no export of the private secure key part");
+		return 0;
+	}
+
 	default_export_fn = (OSSL_FUNC_keymgmt_export_fn *)
 			sk_prov_get_default_keymgmt_func(key->provctx,
 					key->type, OSSL_FUNC_KEYMGMT_EXPORT);
@@ -2858,27 +2903,8 @@ static int sk_prov_keymgmt_export(void *vkey, int selection,
 		return 0;
 	}
 
-	if (key->secure_key == NULL ||
-	    (selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) == 0) {
-		/*
-		 * Clear key, or no private key selected, call default_export_fn
-		 *  with original callback
-		 */
-		if (!default_export_fn(key->default_key, selection,
-				       param_callback, cbarg)) {
-			put_error_key(key, SK_PROV_ERR_DEFAULT_PROV_FUNC_FAILED,
-				      "default_export_fn failed");
-			return 0;
-		}
-		return 1;
-	}
-
-	/* Let the callback add our 3 addl. params */
-	cb_data.key = key;
-	cb_data.param_callback = param_callback;
-	cb_data.cbarg = cbarg;
-	if (!default_export_fn(key->default_key, selection,
-			       sk_prov_keymgmt_export_cb, &cb_data)) {
+	if (!default_export_fn(key->default_key, selection, param_callback,
+			       cbarg)) {
 		put_error_key(key, SK_PROV_ERR_DEFAULT_PROV_FUNC_FAILED,
 			      "default_export_fn failed");
 		return 0;
@@ -2924,6 +2950,8 @@ static int sk_prov_keymgmt_import(void *vkey, int selection,
 	key->secure_key_size = 0;
 	key->funcs = NULL;
 	key->private = NULL;
+	key->max_size = 0;
+	key->bits = 0;
 
 	p_blob = OSSL_PARAM_locate_const(params, SK_PROV_PKEY_PARAM_SK_BLOB);
 	p_funcs = OSSL_PARAM_locate_const(params, SK_PROV_PKEY_PARAM_SK_FUNCS);
@@ -3271,6 +3299,11 @@ static int sk_prov_keymgmt_get_size(struct sk_prov_key *key)
 
 	sk_debug_key(key, "key: %p", key);
 
+	/* Avoid the default provider round trip for each sign operation */
+	size = __atomic_load_n(&key->max_size, __ATOMIC_RELAXED);
+	if (size > 0)
+		return size;
+
 	if (!sk_prov_keymgmt_get_params(key, key_params) ||
 	    !OSSL_PARAM_modified(&key_params[0]) ||
 	    size <= 0) {
@@ -3280,6 +3313,8 @@ static int sk_prov_keymgmt_get_size(struct sk_prov_key *key)
 		return -1;
 	}
 
+	__atomic_store_n(&key->max_size, size, __ATOMIC_RELAXED);
+
 	sk_debug_key(key, "size: %d", size);
 	return size;
 }
@@ -3294,6 +3329,10 @@ static int sk_prov_keymgmt_get_bits(struct sk_prov_key *key)
 
 	sk_debug_key(key, "key: %p", key);
 
+	bits = __atomic_load_n(&key->bits, __ATOMIC_RELAXED);
+	if (bits > 0)
+		return bits;
+
 	if (!sk_prov_keymgmt_get_params(key, key_params) ||
 	    !OSSL_PARAM_modified(&key_params[0]) ||
 	    bits <= 0) {
@@ -3303,6 +3342,8 @@ static int sk_prov_keymgmt_get_bits(struct sk_prov_key *key)
 		return -1;
 	}
 
+	__atomic_store_n(&key->bits, bits, __ATOMIC_RELAXED);
+
 	sk_debug_key(key, "bits: %d", bits);
 	return bits;
 }
@@ -4704,6 +4745,7 @@ static const OSSL_DISPATCH sk_prov_rsa_keymgmt_functions[] = {
 	/* Constructor, destructor */
 	{ OSSL_FUNC_KEYMGMT_NEW, (void (*)(void))sk_prov_keymgmt_rsa_new },
 	{ OSSL_FUNC_KEYMGMT_FREE, (void (*)(void))sk_prov_keymgmt_free },
+	{ OSSL_FUNC_KEYMGMT_DUP, (void (*)(void))sk_prov_keymgmt_dup },
 
 	/* Key generation and loading */
 	{ OSSL_FUNC_KEYMGMT_GEN_INIT,
@@ -4763,6 +4805,7 @@ static const OSSL_DISPATCH sk_prov_rsapss_keymgmt_functions[] = {
 	/* Constructor, destructor */
 	{ OSSL_FUNC_KEYMGMT_NEW, (void (*)(void))sk_prov_keymgmt_rsa_pss_new },
 	{ OSSL_FUNC_KEYMGMT_FREE, (void (*)(void))sk_prov_keymgmt_free },
+	{ OSSL_FUNC_KEYMGMT_DUP, (void (*)(void))sk_prov_keymgmt_dup },
 
 	/* Key generation and loading */
 	{ OSSL_FUNC_KEYMGMT_GEN_INIT,
@@ -4822,6 +4865,7 @@ static const OSSL_DISPATCH sk_prov_ec_keymgmt_functions[] = {
 	/* Constructor, destructor */
 	{ OSSL_FUNC_KEYMGMT_NEW, (void (*)(void))sk_prov_keymgmt_ec_new },
 	{ OSSL_FUNC_KEYMGMT_FREE, (void (*)(void))sk_prov_keymgmt_free },
+	{ OSSL_FUNC_KEYMGMT_DUP, (void (*)(void))sk_prov_keymgmt_dup },
 
 	/* Key generation and loading */
 	{ OSSL_FUNC_KEYMGMT_GEN_INIT,
@@ -5203,6 +5247,9 @@ int SK_OPENSSL_init(bool debug)
  */
 void SK_OPENSSL_term(void)
 {
+	/* The cached PKEYs refer to the secure key provider */
+	sk_openssl_free_caches();
+
 	if (sk_prov_securekey_provider != NULL)
 		OSSL_PROVIDER_unload(sk_prov_securekey_provider);
 	sk_prov_securekey_provider = NULL;
@@ -5250,11 +5297,16 @@ static int sk_openssl_pkey_from_data(OSSL_PARAM_BLD *bld, int pkey_type,
 		goto out;
 	}
 
-	pctx = EVP_PKEY_CTX_new_from_name(NULL, key_name,
+	/*
+	 * Use the secure key library context explicitly, it is the default
+	 * library context only in the thread that called SK_OPENSSL_init()
+	 */
+	pctx = EVP_PKEY_CTX_new_from_name(sk_prov_securekey_libctx, key_name,
 					  "provider="SK_PROV_NAME);
 	if (pctx == NULL) {
 		sk_debug(debug, "ERROR: EVP_PKEY_CTX_new_from_name failed");
-		return -EIO;
+		rc = -EIO;
+		goto out;
 	}
 
 	if (EVP_PKEY_fromdata_init(pctx) <= 0) {
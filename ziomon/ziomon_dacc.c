@@ -499,6 +499,66 @@ static int get_header(FILE *fp, struct file_header *hdr)
 }
 
 
+int refresh_file_header(FILE *fp, struct file_header *f_hdr)
+{
+	struct file_header hdr;
+	long pos = ftell(fp);
+	int rc;
+
+	clearerr(fp);
+	rc = get_header(fp, &hdr);
+	fseek(fp, pos, SEEK_SET);
+	if (rc)
+		return rc;
+	hdr.begin_time = f_hdr->begin_time;
+	*f_hdr = hdr;
+
+	return 0;
+}
+
+
+int sync_log_file(FILE *fp, struct file_header *f_hdr, __u64 begin)
+{
+	struct message_preview msg;
+	long pos = ftell(fp);
+	int rc, rewound = 0;
+
+	if (refresh_file_header(fp, f_hdr))
+		return -1;
+	if (!f_hdr->first_msg_offset)
+		return 0;
+
+	/* the oldest message is the first non-garbage message at or after
+	   first_msg_offset, possibly after wrapping to the start */
+	if (fseek(fp, f_hdr->first_msg_offset, SEEK_SET) < 0)
+		return -1;
+	do {
+		rc = read_message_preview(fp, &msg, f_hdr);
+		if (rc > 0 && !rewound) {
+			clearerr(fp);
+			if (position_at_first_msg(fp) < 0)
+				return -1;
+			rewound = 1;
+			msg.type = ZIOMON_DACC_GARBAGE_MSG;
+			rc = 0;
+		}
+	} while (rc == 0 && msg.type == ZIOMON_DACC_GARBAGE_MSG);
+	clearerr(fp);
+	fseek(fp, pos, SEEK_SET);
+	if (rc < 0)
+		return -1;
+	if (rc == 0 && msg.timestamp > begin)
+		return 1;
+
+	/* Messages behind first_msg_offset are older than the ones in
+	   front of it, so read up to the end and wrap around from there.
+	   Otherwise we have already wrapped and stop at first_msg_offset. */
+	wrapped = (pos > (long)f_hdr->first_msg_offset ? 0 : 1);
+
+	return 0;
+}
+
+
 int open_log_file(FILE **fp, const char *filename, struct file_header *fhdr)
 {
 	int rc = 0;
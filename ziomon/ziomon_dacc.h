@@ -131,6 +131,24 @@ int open_log_file(FILE **fp, const char *filename, struct file_header *fhdr);
  * Must be called to close fp and reset internals */
 void close_log_file(FILE *fp);
 
+/**
+ * Re-read the header of a .log file opened via open_log_file() or
+ * open_data_files() while ziomon_mgr might still be writing to it.
+ * Keeps the current file position and 'begin_time', and clears any
+ * end-of-file condition so that messages appended in the meantime
+ * can be read.
+ * Returns 0 on success, <0 in case of error. */
+int refresh_file_header(FILE *fp, struct file_header *f_hdr);
+
+/**
+ * Like refresh_file_header(), but also adjust the wrap-around handling of
+ * the .log file to the current position of ziomon_mgr, so that reading can
+ * continue from the current file position after ziomon_mgr wrapped.
+ * 'begin' is the timestamp of the oldest message that is still required.
+ * Returns 0 on success, >0 if ziomon_mgr overwrote messages at or after
+ * 'begin' and the file has to be re-opened, <0 in case of error. */
+int sync_log_file(FILE *fp, struct file_header *f_hdr, __u64 begin);
+
 /**
  * Open the data files. This function will not only open the .log and .agg
  * files, but also
@@ -0,0 +1,1069 @@
+/*
+ * FCP adapter trace utility
+ *
+ * Generator for synthetic capture sets
+ *
+ * Writes .log, .agg and .cfg files as created by a ziomon run for a
+ * configurable number of host adapters, target ports and LUNs. The data
+ * is derived from a seeded pseudo-random generator, hence identical
+ * parameters always result in identical files. Intended to benchmark and
+ * test the ziorep tools without access to a system with FCP devices.
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * s390-tools is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <linux/types.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib/zt_common.h"
+
+#include "ziomon_dacc.h"
+#include "ziomon_msg_tools.h"
+#include "ziomon_tools.h"
+#include "ziomon_util.h"
+#include "ziomon_zfcpdd.h"
+#include "blkiomon.h"
+
+
+const char *toolname = "ziomon_gencap";
+int verbose = 0;
+
+/* message ids as used by the ziomon script */
+#define GENCAP_MSGID_UTIL	1
+#define GENCAP_MSGID_IOERR	2
+#define GENCAP_MSGID_BLKIOMON	3
+#define GENCAP_MSGID_ZFCPDD	4
+
+/* default start of data: 2024-01-01 00:00:00 UTC */
+#define GENCAP_BEGIN_DFT	1704067200ULL
+
+#define GENCAP_CHPID_BASE	0x50
+#define GENCAP_WWPN_BASE	0x500507630300c560ULL
+#define GENCAP_LUN_BASE		0x4010400000000000ULL
+#define GENCAP_DM_MAJOR		253
+#define GENCAP_SG_MAJOR		21
+
+enum gencap_shape {
+	GENCAP_SHAPE_NORMAL,	/* log-normal around a single median */
+	GENCAP_SHAPE_BIMODAL,	/* mix of cache hits and misses */
+	GENCAP_SHAPE_LONGTAIL,	/* pareto distributed */
+	GENCAP_SHAPE_UNIFORM,
+};
+
+static const char *shape_names[] = {
+	"normal", "bimodal", "longtail", "uniform", NULL
+};
+
+struct gencap_device {
+	struct hctl_ident	hctl;
+	__u64			wwpn;
+	__u64			lun;
+	char			name[16];	/* sd device name */
+	__u32			major;
+	__u32			minor;
+	int			mp_idx;	/* multipath device index or -1 */
+	double			load;	/* relative amount of traffic */
+};
+
+struct options {
+	char		       *outfile_name;
+	int			num_hosts;
+	int			num_ports;
+	int			num_luns;
+	int			num_intervals;
+	int			interval_length;
+	int			requests;
+	int			multipath;
+	long			version;
+	long			size_limit;
+	__u64			begin;
+	__u64			seed;
+	enum gencap_shape	shape;
+	FILE		       *outfile;
+	FILE		       *outfile_agg;
+	struct aggr_data	agg_data;
+	struct file_header	f_hdr;
+	struct gencap_device   *devices;
+	int			num_devices;
+};
+
+
+static void init_opts(struct options *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->num_hosts = 2;
+	opts->num_ports = 2;
+	opts->num_luns = 4;
+	opts->num_intervals = 60;
+	opts->interval_length = 60;
+	opts->requests = 100;
+	opts->version = 3;
+	opts->size_limit = LONG_MAX;
+	opts->begin = GENCAP_BEGIN_DFT;
+	opts->seed = 1;
+	opts->shape = GENCAP_SHAPE_NORMAL;
+}
+
+
+static void deinit_opts(struct options *opts)
+{
+	if (opts->outfile)
+		fclose(opts->outfile);
+	if (opts->outfile_agg) {
+		fclose(opts->outfile_agg);
+		discard_aggr_data_struct(&opts->agg_data);
+	}
+	free(opts->outfile_name);
+	free(opts->devices);
+}
+
+
+static const char help_text[] =
+  "Usage: ziomon_gencap [-h] [-v] [-V] [-a <num>] [-p <num>] [-u <num>]\n"
+  "                     [-n <num>] [-i <length>] [-r <num>] [-H <shape>]\n"
+  "                     [-m] [-l <size>] [-x <version>] [-b <time>]\n"
+  "                     [-s <seed>] -o <filename>\n"
+  "Generate a synthetic set of ziomon data files.\n"
+  "\n"
+  "-h, --help              Print usage information and exit.\n"
+  "-v, --version           Print version information and exit.\n"
+  "-V, --verbose           Be verbose.\n"
+  "-a, --adapters <num>    Number of host adapters. Defaults to 2.\n"
+  "-p, --ports <num>       Number of target ports per host adapter.\n"
+  "                        Defaults to 2.\n"
+  "-u, --luns <num>        Number of LUNs per target port. Defaults to 4.\n"
+  "-n, --intervals <num>   Number of intervals. Defaults to 60.\n"
+  "-i, --interval-length   Interval length in seconds. Defaults to 60.\n"
+  "-r, --requests <num>    Average number of requests per device and\n"
+  "                        interval. Defaults to 100.\n"
+  "-H, --shape <shape>     Shape of the latency histograms: normal,\n"
+  "                        bimodal, longtail or uniform.\n"
+  "                        Defaults to normal.\n"
+  "-m, --multipath         Group the paths to each LUN in a multipath"
+			   " device.\n"
+  "-l, --size-limit <size> Maximum size of the .log file in KB. Older data\n"
+  "                        is aggregated in the .agg file.\n"
+  "-x, --enforce-version   Write .log and .agg files in version 2 or 3.\n"
+  "-b, --begin <time>      Start of data in seconds since the epoch.\n"
+  "-s, --seed <seed>       Seed of the random number generator.\n"
+  "-o, --output            Specify the name of the output file(s).\n";
+
+static void print_help(void)
+{
+	fprintf(stdout, "%s", help_text);
+}
+
+
+static void print_version(void)
+{
+	fprintf(stdout, "%s: ziomon capture generator, version %s\n"
+		"Copyright IBM Corp. 2026\n",
+		toolname, RELEASE_STRING);
+}
+
+
+/*
+ * xorshift64* - we do not use rand() so that the generated data does not
+ * depend on the C library in use.
+ */
+static __u64 rnd_state;
+
+static __u64 rnd_next(void)
+{
+	rnd_state ^= rnd_state >> 12;
+	rnd_state ^= rnd_state << 25;
+	rnd_state ^= rnd_state >> 27;
+
+	return rnd_state * 0x2545f4914f6cdd1dULL;
+}
+
+/* uniformly distributed in (0, 1] */
+static double rnd_double(void)
+{
+	return ((rnd_next() >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+static double rnd_normal(void)
+{
+	return sqrt(-2.0 * log(rnd_double())) * cos(2 * M_PI * rnd_double());
+}
+
+static double rnd_lognormal(double median, double sigma)
+{
+	return median * exp(sigma * rnd_normal());
+}
+
+
+/* dispatch to completion time in microseconds */
+static __u64 sample_latency(enum gencap_shape shape)
+{
+	double val;
+
+	switch (shape) {
+	case GENCAP_SHAPE_BIMODAL:
+		if (rnd_double() < 0.7)
+			val = rnd_lognormal(150, 0.3);
+		else
+			val = rnd_lognormal(3000, 0.4);
+		break;
+	case GENCAP_SHAPE_LONGTAIL:
+		val = 200 / pow(rnd_double(), 1 / 1.5);
+		break;
+	case GENCAP_SHAPE_UNIFORM:
+		val = 50 + rnd_double() * 4950;
+		break;
+	case GENCAP_SHAPE_NORMAL:
+	default:
+		val = rnd_lognormal(400, 0.5);
+		break;
+	}
+	if (val > 10000000)
+		val = 10000000;
+
+	return (__u64)val + 1;
+}
+
+
+/* request size in Bytes */
+static __u64 sample_size(void)
+{
+	static const __u64 sizes[] = {
+		4096, 8192, 16384, 32768, 65536, 131072, 262144
+	};
+	static const double weights[] = {
+		0.35, 0.20, 0.15, 0.10, 0.10, 0.06, 0.04
+	};
+	double r = rnd_double();
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(sizes) - 1; ++i) {
+		if (r <= weights[i])
+			break;
+		r -= weights[i];
+	}
+
+	return sizes[i];
+}
+
+
+static int parse_int_opt(const char *arg, int min, int *tgt, char opt)
+{
+	char *end;
+	long val;
+
+	errno = 0;
+	val = strtol(arg, &end, 0);
+	if (errno || *end || val < min || val > INT_MAX) {
+		fprintf(stderr, "%s: Invalid argument to option '-%c': %s\n",
+			toolname, opt, arg);
+		return -1;
+	}
+	*tgt = val;
+
+	return 0;
+}
+
+
+static int parse_params(int argc, char **argv, struct options *opts)
+{
+	int c, i, tmp;
+	int index;
+	char *end;
+	static struct option long_options[] = {
+		{ "version",         no_argument,       NULL, 'v'},
+		{ "help",            no_argument,       NULL, 'h'},
+		{ "verbose",         no_argument,       NULL, 'V'},
+		{ "adapters",        required_argument, NULL, 'a'},
+		{ "ports",           required_argument, NULL, 'p'},
+		{ "luns",            required_argument, NULL, 'u'},
+		{ "intervals",       required_argument, NULL, 'n'},
+		{ "interval-length", required_argument, NULL, 'i'},
+		{ "requests",        required_argument, NULL, 'r'},
+		{ "shape",           required_argument, NULL, 'H'},
+		{ "multipath",       no_argument,       NULL, 'm'},
+		{ "size-limit",      required_argument, NULL, 'l'},
+		{ "enforce-version", required_argument, NULL, 'x'},
+		{ "begin",           required_argument, NULL, 'b'},
+		{ "seed",            required_argument, NULL, 's'},
+		{ "output",          required_argument, NULL, 'o'},
+		{ 0,                 0,                 0,     0 }
+	};
+
+	if (argc <= 1) {
+		print_help();
+		return 1;
+	}
+
+	while ((c = getopt_long(argc, argv, "a:p:u:n:i:r:H:l:x:b:s:o:mVhv",
+				long_options, &index)) != EOF) {
+		switch (c) {
+		case 'V':
+			verbose++;
+			break;
+		case 'a':
+			if (parse_int_opt(optarg, 1, &opts->num_hosts, c))
+				return -1;
+			break;
+		case 'p':
+			if (parse_int_opt(optarg, 1, &opts->num_ports, c))
+				return -1;
+			break;
+		case 'u':
+			if (parse_int_opt(optarg, 1, &opts->num_luns, c))
+				return -1;
+			break;
+		case 'n':
+			if (parse_int_opt(optarg, 1, &opts->num_intervals, c))
+				return -1;
+			break;
+		case 'i':
+			if (parse_int_opt(optarg, 1, &opts->interval_length,
+					  c))
+				return -1;
+			break;
+		case 'r':
+			if (parse_int_opt(optarg, 0, &opts->requests, c))
+				return -1;
+			break;
+		case 'H':
+			for (i = 0; shape_names[i]; ++i) {
+				if (strcmp(optarg, shape_names[i]) == 0)
+					break;
+			}
+			if (!shape_names[i]) {
+				fprintf(stderr, "%s: Unknown shape: %s\n",
+					toolname, optarg);
+				return -1;
+			}
+			opts->shape = i;
+			break;
+		case 'm':
+			opts->multipath = 1;
+			break;
+		case 'l':
+			if (parse_int_opt(optarg, 1, &tmp, c))
+				return -1;
+			opts->size_limit = tmp * 1024L;
+			break;
+		case 'x':
+			if (parse_int_opt(optarg, 2, &tmp, c))
+				return -1;
+			if (tmp > 3) {
+				fprintf(stderr, "%s: Enforced version can only"
+					" be 2 or 3.\n", toolname);
+				return -1;
+			}
+			opts->version = tmp;
+			break;
+		case 'b':
+			errno = 0;
+			opts->begin = strtoull(optarg, &end, 0);
+			if (errno || *end) {
+				fprintf(stderr, "%s: Invalid argument to"
+					" option '-b': %s\n", toolname, optarg);
+				return -1;
+			}
+			break;
+		case 's':
+			errno = 0;
+			opts->seed = strtoull(optarg, &end, 0);
+			if (errno || *end) {
+				fprintf(stderr, "%s: Invalid argument to"
+					" option '-s': %s\n", toolname, optarg);
+				return -1;
+			}
+			break;
+		case 'o':
+			free(opts->outfile_name);
+			opts->outfile_name = strdup(optarg);
+			break;
+		case 'h':
+			print_help();
+			return 1;
+		case 'v':
+			print_version();
+			return 1;
+		default:
+			fprintf(stderr, "Try '%s --help' for"
+				" more information.\n", toolname);
+			return -1;
+		}
+	}
+
+	if (optind < argc) {
+		fprintf(stderr, "%s: Extra operand: %s\n", toolname,
+			argv[optind]);
+		return -1;
+	}
+	if (!opts->outfile_name) {
+		fprintf(stderr, "%s: No filename for"
+			" output specified\n", toolname);
+		return -1;
+	}
+	if (opts->num_hosts > 256) {
+		fprintf(stderr, "%s: At most 256 host adapters are"
+			" supported\n", toolname);
+		return -1;
+	}
+	/* a seed of 0 would get xorshift stuck */
+	rnd_state = opts->seed ? opts->seed : 0x9e3779b97f4a7c15ULL;
+
+	verbose_msg("host adapters        : %d\n", opts->num_hosts);
+	verbose_msg("ports per adapter    : %d\n", opts->num_ports);
+	verbose_msg("luns per port        : %d\n", opts->num_luns);
+	verbose_msg("intervals            : %d\n", opts->num_intervals);
+	verbose_msg("interval length      : %d\n", opts->interval_length);
+	verbose_msg("requests per interval: %d\n", opts->requests);
+	verbose_msg("shape                : %s\n", shape_names[opts->shape]);
+	verbose_msg("version              : %ld\n", opts->version);
+
+	return 0;
+}
+
+
+/* Block device numbers as assigned by the sd driver */
+static void get_sd_name_and_mm(int idx, struct gencap_device *dev)
+{
+	char tmp[sizeof(dev->name)];
+	int i = 0, j;
+	int n = idx;
+
+	do {
+		tmp[i++] = 'a' + n % 26;
+		n = n / 26 - 1;
+	} while (n >= 0 && i < (int)sizeof(tmp) - 4);
+	strcpy(dev->name, "sd");
+	for (j = 0; j < i; ++j)
+		dev->name[2 + j] = tmp[i - j - 1];
+	dev->name[2 + i] = '\0';
+
+	if (idx < 16) {
+		dev->major = 8;
+		dev->minor = idx * 16;
+	} else if (idx < 128) {
+		dev->major = 64 + idx / 16;
+		dev->minor = (idx % 16) * 16;
+	} else if (idx < 256) {
+		dev->major = 128 + (idx - 128) / 16;
+		dev->minor = (idx % 16) * 16;
+	} else {
+		/* extended devt */
+		dev->major = 259;
+		dev->minor = idx - 256;
+	}
+}
+
+
+static int setup_devices(struct options *opts)
+{
+	struct gencap_device *dev;
+	int h, p, l;
+
+	opts->num_devices = opts->num_hosts * opts->num_ports * opts->num_luns;
+	opts->devices = calloc(opts->num_devices, sizeof(*opts->devices));
+	if (!opts->devices) {
+		fprintf(stderr, "%s: Memory allocation failed\n", toolname);
+		return -1;
+	}
+	dev = opts->devices;
+	for (h = 0; h < opts->num_hosts; ++h) {
+		for (p = 0; p < opts->num_ports; ++p) {
+			for (l = 0; l < opts->num_luns; ++l, ++dev) {
+				dev->hctl.host = h;
+				dev->hctl.channel = 0;
+				dev->hctl.target = p;
+				dev->hctl.lun = l;
+				dev->wwpn = GENCAP_WWPN_BASE + p;
+				dev->lun = GENCAP_LUN_BASE
+					   | ((__u64)(l & 0xffff) << 32);
+				get_sd_name_and_mm(dev - opts->devices, dev);
+				dev->mp_idx = opts->multipath ?
+					p * opts->num_luns + l : -1;
+				/* some devices are busier than others, and
+				   a few are hardly used at all */
+				dev->load = 0.2 + 1.6 * rnd_double();
+				if (rnd_double() < 0.1)
+					dev->load = 0.01;
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+static __u32 get_mm_internal(const struct gencap_device *dev)
+{
+	return (dev->major << MINORBITS) + dev->minor;
+}
+
+
+/*
+ * Configuration data
+ */
+
+static int mkdir_p(char *path)
+{
+	char *p;
+
+	for (p = strchr(path + 1, '/'); p; p = strchr(p + 1, '/')) {
+		*p = '\0';
+		if (mkdir(path, 0755) && errno != EEXIST) {
+			*p = '/';
+			return -1;
+		}
+		*p = '/';
+	}
+	if (mkdir(path, 0755) && errno != EEXIST)
+		return -1;
+
+	return 0;
+}
+
+
+static int cfg_mkdir(const char *root, const char *fmt, ...)
+{
+	char path[PATH_MAX];
+	va_list ap;
+	int len;
+
+	len = snprintf(path, sizeof(path), "%s/", root);
+	va_start(ap, fmt);
+	vsnprintf(path + len, sizeof(path) - len, fmt, ap);
+	va_end(ap);
+	if (mkdir_p(path)) {
+		fprintf(stderr, "%s: Could not create directory %s: %s\n",
+			toolname, path, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/* Write an attribute below 'dir', creating 'dir' on the way */
+static int cfg_attr(const char *root, const char *dir, const char *attr,
+		    const char *fmt, ...)
+{
+	char path[PATH_MAX];
+	va_list ap;
+	FILE *fp;
+
+	if (cfg_mkdir(root, "%s", dir))
+		return -1;
+	snprintf(path, sizeof(path), "%s/%s/%s", root, dir, attr);
+	fp = fopen(path, "w");
+	if (!fp) {
+		fprintf(stderr, "%s: Could not create %s: %s\n", toolname,
+			path, strerror(errno));
+		return -1;
+	}
+	va_start(ap, fmt);
+	vfprintf(fp, fmt, ap);
+	va_end(ap);
+	fputc('\n', fp);
+	fclose(fp);
+
+	return 0;
+}
+
+
+static void get_host_ids(int host, char *subch, char *busid, size_t len)
+{
+	snprintf(subch, len, "0.0.%04x", 0x10 + host);
+	snprintf(busid, len, "0.0.%04x", 0x1700 + host * 0x100);
+}
+
+
+static int write_host_cfg(const char *root, int host)
+{
+	char subch[16], busid[16], dir[PATH_MAX], path[PATH_MAX];
+	int rc = 0;
+
+	get_host_ids(host, subch, busid, sizeof(subch));
+	snprintf(dir, sizeof(dir), "sys/devices/css0/%s/%s/host%d/fc_host/"
+		 "host%d", subch, busid, host, host);
+	rc |= cfg_attr(root, dir, "speed", "8 Gbit");
+	rc |= cfg_attr(root, dir, "port_name", "0xc05076ffe4800%03x", host);
+	rc |= cfg_attr(root, dir, "permanent_port_name",
+		       "0xc05076ffe4801%03x", host);
+	rc |= cfg_attr(root, dir, "port_type", "NPort (fabric via point-to-"
+		       "point)");
+	snprintf(dir, sizeof(dir), "sys/devices/css0/%s/%s", subch, busid);
+	rc |= cfg_attr(root, dir, "lic_version", "0x00000508");
+	rc |= cfg_attr(root, dir, "card_version", "0x0007");
+	rc |= cfg_attr(root, dir, "online", "1");
+	snprintf(dir, sizeof(dir), "sys/devices/css0/%s", subch);
+	rc |= cfg_attr(root, dir, "chpids", "%02x 00 00 00 00 00 00 00",
+		       GENCAP_CHPID_BASE + host);
+	rc |= cfg_mkdir(root, "sys/class/fc_host");
+	if (rc)
+		return -1;
+
+	snprintf(path, sizeof(path), "%s/sys/class/fc_host/host%d", root,
+		 host);
+	snprintf(dir, sizeof(dir), "../../devices/css0/%s/%s/host%d/fc_host/"
+		 "host%d", subch, busid, host, host);
+	if (symlink(dir, path)) {
+		fprintf(stderr, "%s: Could not create %s: %s\n", toolname,
+			path, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+
+static int write_device_cfg(const char *root, const struct options *opts,
+			    const struct gencap_device *dev)
+{
+	char subch[16], busid[16], dir[256], blk[PATH_MAX];
+	char mapper[64];
+	int idx = dev - opts->devices;
+	int rc = 0;
+
+	get_host_ids(dev->hctl.host, subch, busid, sizeof(subch));
+	snprintf(dir, sizeof(dir), "sys/class/scsi_device/%u:%u:%u:%u/device",
+		 dev->hctl.host, dev->hctl.channel, dev->hctl.target,
+		 dev->hctl.lun);
+	rc |= cfg_attr(root, dir, "type", "0");
+	rc |= cfg_attr(root, dir, "hba_id", "%s", busid);
+	rc |= cfg_attr(root, dir, "model", "2107900");
+	rc |= cfg_attr(root, dir, "vendor", "IBM");
+	rc |= cfg_attr(root, dir, "fcp_lun", "0x%016llx", dev->lun);
+	rc |= cfg_attr(root, dir, "wwpn", "0x%016llx", dev->wwpn);
+	rc |= cfg_mkdir(root, "%s/scsi_generic/sg%d", dir, idx);
+	snprintf(blk, sizeof(blk), "%s/generic", dir);
+	rc |= cfg_attr(root, blk, "dev", "%d:%d", GENCAP_SG_MAJOR, idx);
+	snprintf(blk, sizeof(blk), "%s/block/%s", dir, dev->name);
+	rc |= cfg_attr(root, blk, "dev", "%u:%u", dev->major, dev->minor);
+	if (dev->mp_idx >= 0) {
+		rc |= cfg_mkdir(root, "%s/holders/dm-%d", blk, dev->mp_idx);
+		snprintf(dir, sizeof(dir), "sys/block/dm-%d", dev->mp_idx);
+		rc |= cfg_attr(root, dir, "dev", "%d:%d", GENCAP_DM_MAJOR,
+			       dev->mp_idx);
+		snprintf(mapper, sizeof(mapper),
+			 "36005076303ffc10400000000000%04x", dev->mp_idx);
+		rc |= cfg_attr(root, "dev/mapper", mapper, "%d:%d",
+			       GENCAP_DM_MAJOR, dev->mp_idx);
+	}
+
+	return rc ? -1 : 0;
+}
+
+
+/* Create the .cfg file in the same layout as ziomon_fcpconf does */
+static int write_cfg(const struct options *opts)
+{
+	char root[] = "/tmp/ziomon_gencapXXXXXX";
+	char *cmd;
+	int rc = 0;
+	int i;
+
+	if (!mkdtemp(root)) {
+		fprintf(stderr, "%s: Could not create temporary directory:"
+			" %s\n", toolname, strerror(errno));
+		return -1;
+	}
+	verbose_msg("write configuration data to %s\n", root);
+	if (cfg_mkdir(root, "sys/class/fc_remote_ports")
+	    || cfg_mkdir(root, "dev/mapper")) {
+		rc = -1;
+		goto out;
+	}
+	for (i = 0; i < opts->num_hosts && !rc; ++i)
+		rc = write_host_cfg(root, i);
+	for (i = 0; i < opts->num_devices && !rc; ++i)
+		rc = write_device_cfg(root, opts, &opts->devices[i]);
+	if (rc)
+		goto out;
+
+	cmd = malloc(strlen(opts->outfile_name) + 2 * strlen(root) + 64);
+	if (!cmd) {
+		rc = -1;
+		goto out;
+	}
+	sprintf(cmd, "tar -czf %s.cfg -C %s sys dev", opts->outfile_name, root);
+	verbose_msg("issue command: %s\n", cmd);
+	if (system(cmd)) {
+		fprintf(stderr, "%s: Could not create %s.cfg\n", toolname,
+			opts->outfile_name);
+		rc = -1;
+	}
+	free(cmd);
+
+out:
+	cmd = malloc(strlen(root) + 8);
+	if (cmd) {
+		sprintf(cmd, "rm -rf %s", root);
+		if (system(cmd))
+			fprintf(stderr, "%s: Could not remove %s\n", toolname,
+				root);
+		free(cmd);
+	}
+
+	return rc;
+}
+
+
+/*
+ * Data files
+ */
+
+static int open_output_files(struct options *opts)
+{
+	char *fname;
+
+	fname = malloc(strlen(opts->outfile_name) + 5);
+	if (!fname)
+		return -1;
+	sprintf(fname, "%s" DACC_FILE_EXT_LOG, opts->outfile_name);
+	opts->outfile = fopen(fname, "w+");
+	if (!opts->outfile) {
+		fprintf(stderr, "%s: Could not open %s: %s\n", toolname,
+			fname, strerror(errno));
+		free(fname);
+		return -1;
+	}
+	/* remove stale data from previous runs */
+	sprintf(fname, "%s" DACC_FILE_EXT_AGG, opts->outfile_name);
+	remove(fname);
+	sprintf(fname, "%s.config", opts->outfile_name);
+	remove(fname);
+	free(fname);
+
+	opts->f_hdr.msgid_utilization = GENCAP_MSGID_UTIL;
+	opts->f_hdr.msgid_ioerr = GENCAP_MSGID_IOERR;
+	opts->f_hdr.msgid_blkiomon = GENCAP_MSGID_BLKIOMON;
+	opts->f_hdr.msgid_zfcpdd = GENCAP_MSGID_ZFCPDD;
+	opts->f_hdr.size_limit = opts->size_limit;
+	opts->f_hdr.interval_length = opts->interval_length;
+
+	return init_file(opts->outfile, &opts->f_hdr, opts->version);
+}
+
+
+static int add_to_aggregated(struct message **msgs, int num_msgs,
+			     struct options *opts)
+{
+	char *fname;
+	int i;
+
+	if (!opts->outfile_agg) {
+		fname = malloc(strlen(opts->outfile_name) + 5);
+		if (!fname)
+			return -1;
+		sprintf(fname, "%s" DACC_FILE_EXT_AGG, opts->outfile_name);
+		opts->outfile_agg = fopen(fname, "w+");
+		if (!opts->outfile_agg) {
+			fprintf(stderr, "%s: Could not open %s: %s\n",
+				toolname, fname, strerror(errno));
+			free(fname);
+			return -1;
+		}
+		free(fname);
+		init_aggr_data_struct(&opts->agg_data);
+	}
+
+	for (i = 0; i < num_msgs; ++i) {
+		if (add_to_agg(&opts->agg_data, msgs[i], &opts->f_hdr))
+			return -1;
+		discard_msg(msgs[i]);
+		free(msgs[i]);
+	}
+	free(msgs);
+
+	return 0;
+}
+
+
+/* Write a message in BE format to the .log file, just as ziomon_mgr does */
+static int write_msg(struct options *opts, __u32 type, void *data,
+		     __u32 length)
+{
+	struct message msg, **msgs;
+	int count;
+
+	msg.type = type;
+	msg.length = length;
+	msg.data = data;
+	if (add_msg(opts->outfile, &msg, &opts->f_hdr, &msgs, &count)) {
+		fprintf(stderr, "%s: Error while writing message\n", toolname);
+		return -1;
+	}
+	if (count && add_to_aggregated(msgs, count, opts)) {
+		fprintf(stderr, "%s: Failed to aggregate %d messages\n",
+			toolname, count);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/* Number of requests of a device in an interval */
+static int get_num_requests(const struct options *opts,
+			    const struct gencap_device *dev, int interval)
+{
+	/* slow swing over the course of the data to make the
+	   aggregation over larger intervals less trivial */
+	double swing = 1 + 0.5 * sin(2 * M_PI * interval / 24.0);
+	double val = opts->requests * dev->load * swing
+		     * (0.8 + 0.4 * rnd_double());
+
+	return (int)val;
+}
+
+
+static int write_utilization_msg(struct options *opts, __u64 timestamp)
+{
+	struct utilization_data *data;
+	struct adapter_utilization *a;
+	__u32 length;
+	int samples = opts->interval_length / 2;
+	int h, s;
+	double base;
+	int rc;
+
+	length = sizeof(*data) + opts->num_hosts * sizeof(*a);
+	data = calloc(1, length);
+	if (!data)
+		return -1;
+	data->timestamp = timestamp;
+	data->num_adapters = opts->num_hosts;
+	if (samples < 1)
+		samples = 1;
+	for (h = 0; h < opts->num_hosts; ++h) {
+		a = &data->adapt_utils[h];
+		a->adapter_no = h;
+		a->valid = 1;
+		a->stats.count = samples;
+		init_abbrev_stat(&a->stats.adapter);
+		init_abbrev_stat(&a->stats.bus);
+		init_abbrev_stat(&a->stats.cpu);
+		base = 5 + 40 * rnd_double();
+		for (s = 0; s < samples; ++s) {
+			update_abbrev_stat(&a->stats.adapter,
+				(__u64)(base * (0.7 + 0.6 * rnd_double())));
+			update_abbrev_stat(&a->stats.bus,
+				(__u64)(base / 2 * (0.7 + 0.6 * rnd_double())));
+			update_abbrev_stat(&a->stats.cpu,
+				(__u64)(base * 1.5 * (0.7 + 0.6 * rnd_double())));
+		}
+		a->stats.queue_util_interval =
+			(__u64)opts->interval_length * 1000000;
+		a->stats.queue_util_integral = (__u64)(base / 100 * 128
+			* a->stats.queue_util_interval);
+		a->stats.queue_full = rnd_double() < 0.05 ?
+			(__u32)(rnd_double() * 20) : 0;
+	}
+	conv_overall_result_to_BE(data);
+	rc = write_msg(opts, GENCAP_MSGID_UTIL, data, length);
+	free(data);
+
+	return rc;
+}
+
+
+static int write_ioerr_msg(struct options *opts, __u64 timestamp, int force)
+{
+	struct ioerr_data *data;
+	__u32 length;
+	int errors = 0;
+	int i, rc = 0;
+
+	length = sizeof(*data) + opts->num_devices * sizeof(struct ioerr_cnt);
+	data = calloc(1, length);
+	if (!data)
+		return -1;
+	data->timestamp = timestamp;
+	data->num_luns = opts->num_devices;
+	for (i = 0; i < opts->num_devices; ++i) {
+		data->ioerrors[i].identifier = opts->devices[i].hctl;
+		if (rnd_double() < 0.002) {
+			data->ioerrors[i].num_ioerr = 1 + rnd_next() % 3;
+			errors++;
+		}
+	}
+	/* ziomon_util only sends messages when there are errors */
+	if (errors || force) {
+		conv_ioerr_data_to_BE(data);
+		rc = write_msg(opts, GENCAP_MSGID_IOERR, data, length);
+	}
+	free(data);
+
+	return rc;
+}
+
+
+static int write_blkiomon_msg(struct options *opts, __u64 timestamp,
+			      const struct gencap_device *dev, int requests)
+{
+	struct blkiomon_stat stat;
+	struct blkiomon_stat_v2 stat_v2;
+	__u64 size, d2c;
+	int i;
+
+	blkiomon_stat_init(&stat);
+	stat.time = timestamp;
+	stat.device = get_mm_internal(dev);
+	for (i = 0; i < requests; ++i) {
+		size = sample_size();
+		d2c = sample_latency(opts->shape);
+		if (rnd_double() < 0.7) {
+			minmax_account(&stat.size_r, size);
+			minmax_account(&stat.d2c_r, d2c);
+			minmax_account(&stat.thrput_r, size * 1000 / d2c);
+		} else {
+			minmax_account(&stat.size_w, size);
+			minmax_account(&stat.d2c_w, d2c);
+			minmax_account(&stat.thrput_w, size * 1000 / d2c);
+		}
+		histlog2_account(stat.size_hist, size, &size_hist);
+		histlog2_account(stat.d2c_hist, d2c, &d2c_hist);
+	}
+	blkiomon_conv_to_BE(&stat);
+	if (opts->version != DATA_MGR_V2)
+		return write_msg(opts, GENCAP_MSGID_BLKIOMON, &stat,
+				 sizeof(stat));
+
+	/* version 2 has the device identifier at the end */
+	stat_v2.time = stat.time;
+	memcpy(stat_v2.size_hist, stat.size_hist, sizeof(stat.size_hist));
+	memcpy(stat_v2.d2c_hist, stat.d2c_hist, sizeof(stat.d2c_hist));
+	stat_v2.size_r = stat.size_r;
+	stat_v2.size_w = stat.size_w;
+	stat_v2.d2c_r = stat.d2c_r;
+	stat_v2.d2c_w = stat.d2c_w;
+	stat_v2.thrput_r = stat.thrput_r;
+	stat_v2.thrput_w = stat.thrput_w;
+	stat_v2.bidir = stat.bidir;
+	stat_v2.device = stat.device;
+
+	return write_msg(opts, GENCAP_MSGID_BLKIOMON, &stat_v2,
+			 sizeof(stat_v2));
+}
+
+
+static struct histlog2 chan_lat_hist = {0, 1000, BLKIOMON_CHAN_LAT_BUCKETS};
+static struct histlog2 fabr_lat_hist = {0, 8, BLKIOMON_FABR_LAT_BUCKETS};
+
+static int write_zfcpdd_msg(struct options *opts, __u64 timestamp,
+			    const struct gencap_device *dev, int requests)
+{
+	struct zfcpdd_dstat stat;
+	__u64 d2c, chan, fabr;
+	int i;
+
+	memset(&stat, 0, sizeof(stat));
+	stat.time = timestamp;
+	stat.device = get_mm_internal(dev);
+	init_abbrev_stat(&stat.chan_lat);
+	init_abbrev_stat(&stat.fabr_lat);
+	init_abbrev_stat(&stat.inb);
+	for (i = 0; i < requests; ++i) {
+		/* channel latency in nanoseconds, fabric latency in
+		   microseconds - both are a fraction of the total time */
+		d2c = sample_latency(opts->shape);
+		chan = (__u64)(d2c * 1000 * (0.02 + 0.08 * rnd_double()));
+		fabr = (__u64)(d2c * (0.3 + 0.5 * rnd_double()));
+		update_abbrev_stat(&stat.chan_lat, chan);
+		update_abbrev_stat(&stat.fabr_lat, fabr);
+		update_abbrev_stat(&stat.inb, 1 + rnd_next() % 32);
+		histlog2_account(stat.chan_lat_hist, chan, &chan_lat_hist);
+		histlog2_account(stat.fabr_lat_hist, fabr, &fabr_lat_hist);
+	}
+	stat.count = requests;
+	stat.outb_max = 1 + rnd_next() % 128;
+	conv_dstat_to_BE(&stat);
+
+	return write_msg(opts, GENCAP_MSGID_ZFCPDD, &stat, sizeof(stat));
+}
+
+
+static int write_interval(struct options *opts, int interval)
+{
+	__u64 timestamp = opts->begin
+			  + (__u64)(interval + 1) * opts->interval_length;
+	const struct gencap_device *dev;
+	int requests;
+	int i;
+
+	if (write_utilization_msg(opts, timestamp)
+	    || write_ioerr_msg(opts, timestamp, interval == 0))
+		return -1;
+	for (i = 0; i < opts->num_devices; ++i) {
+		dev = &opts->devices[i];
+		requests = get_num_requests(opts, dev, interval);
+		/* blkiomon and ziomon_zfcpdd only report devices with
+		   traffic */
+		if (!requests)
+			continue;
+		if (write_blkiomon_msg(opts, timestamp, dev, requests)
+		    || write_zfcpdd_msg(opts, timestamp, dev, requests))
+			return -1;
+	}
+
+	return 0;
+}
+
+
+static int write_data(struct options *opts)
+{
+	int rc = 0;
+	int i;
+
+	if (open_output_files(opts))
+		return -1;
+	for (i = 0; i < opts->num_intervals && !rc; ++i)
+		rc = write_interval(opts, i);
+	if (!rc && opts->outfile_agg) {
+		conv_aggr_data_msg_data_to_BE(&opts->agg_data);
+		rc = write_aggr_file(opts->outfile_agg, &opts->agg_data);
+		conv_aggr_data_msg_data_from_BE(&opts->agg_data);
+	}
+
+	return rc;
+}
+
+
+int main(int argc, char **argv)
+{
+	struct options opts;
+	int rc;
+
+	init_opts(&opts);
+
+	rc = parse_params(argc, argv, &opts);
+	if (rc) {
+		rc = (rc > 0 ? 0 : 1);
+		goto out;
+	}
+	rc = 1;
+	if (setup_devices(&opts))
+		goto out;
+	if (write_cfg(&opts))
+		goto out;
+	if (write_data(&opts))
+		goto out;
+	verbose_msg("wrote %d intervals for %d devices\n", opts.num_intervals,
+		    opts.num_devices);
+	rc = 0;
+
+out:
+	deinit_opts(&opts);
+
+	return rc;
+}
@@ -296,6 +296,8 @@ struct adapter_data {
 	int			host_nr;
 	char		       *path;
 	char		       *q_full_path;
+	int			fd;	/* kept open, -1 if not open */
+	int			q_full_fd;
 	int			status;	/* 0 if good != 0 in case of failure */
 	struct util_data	data;
 };
@@ -315,6 +317,7 @@ struct options {
 	char  **host_path;	/* array of paths to utilization files */
 	int     num_luns;	/* number of luns */
 	char  **luns;		/* array of luns to monitor */
+	int    *lun_fds;	/* array of fds of the ioerr_cnt attributes */
 	__u32  *luns_prev;	/* array of previous values of luns */
 	long  	duration;	/* overall duration in seconds */
 	long  	s_duration;	/* ssample duration in seconds */
@@ -338,6 +341,7 @@ static void init_opts(struct options *opts)
 	opts->host_path    = NULL;
 	opts->num_luns	   = 0;
 	opts->luns	   = NULL;
+	opts->lun_fds	   = NULL;
 	opts->luns_prev	   = NULL;
 	opts->msg_q_path   = NULL;
 	opts->msg_q_id	   = -1;
@@ -361,9 +365,16 @@ static void deinit_opts(struct options *opts)
 	}
 	for (i=0; i<opts->num_hosts_a; ++i)
 		free(opts->luns[i]);
+	if (opts->lun_fds) {
+		for (i = 0; i < opts->num_luns; ++i) {
+			if (opts->lun_fds[i] >= 0)
+				close(opts->lun_fds[i]);
+		}
+	}
 	opts->num_hosts_a = 0;
 	opts->msg_q = -1;
 	free(opts->luns);
+	free(opts->lun_fds);
 	free(opts->luns_prev);
 }
 
@@ -443,23 +454,96 @@ static int init_host_opts(struct options *opts, int num_hosts)
 
 #define LINE_LEN	255
 
-static int read_attribute(char *path, char *line, int *status)
+/* Accumulated cost of reading the sysfs attributes */
+static struct {
+	struct timespec	cpu;	/* CPU time spent polling in interval */
+	struct timespec	wall;	/* wall-clock time spent polling */
+	long		reads;	/* number of attribute reads */
+	struct timespec	cpu_total;
+	long		reads_total;
+} poll_cost;
+
+static void poll_cost_start(struct timespec *cpu, struct timespec *wall)
+{
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, cpu);
+	clock_gettime(CLOCK_MONOTONIC, wall);
+}
+
+static void timespec_add_diff(struct timespec *sum,
+			      const struct timespec *start,
+			      const struct timespec *end)
+{
+	sum->tv_sec += end->tv_sec - start->tv_sec;
+	sum->tv_nsec += end->tv_nsec - start->tv_nsec;
+	while (sum->tv_nsec < 0) {
+		sum->tv_nsec += 1000000000L;
+		sum->tv_sec--;
+	}
+	while (sum->tv_nsec >= 1000000000L) {
+		sum->tv_nsec -= 1000000000L;
+		sum->tv_sec++;
+	}
+}
+
+static void poll_cost_stop(const struct timespec *cpu,
+			   const struct timespec *wall)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+	timespec_add_diff(&poll_cost.cpu, cpu, &now);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	timespec_add_diff(&poll_cost.wall, wall, &now);
+}
+
+static long timespec_to_us(const struct timespec *t)
+{
+	return t->tv_sec * 1000000L + t->tv_nsec / 1000;
+}
+
+/* Report and reset the polling cost of the interval that just finished */
+static void poll_cost_report(void)
+{
+	verbose_msg("polling cost in interval: %ld reads, %ld us cpu,"
+		    " %ld us elapsed\n", poll_cost.reads,
+		    timespec_to_us(&poll_cost.cpu),
+		    timespec_to_us(&poll_cost.wall));
+	poll_cost.reads_total += poll_cost.reads;
+	timespec_add_diff(&poll_cost.cpu_total, &(struct timespec){ 0, 0 },
+			  &poll_cost.cpu);
+	poll_cost.reads = 0;
+	memset(&poll_cost.cpu, 0, sizeof(poll_cost.cpu));
+	memset(&poll_cost.wall, 0, sizeof(poll_cost.wall));
+}
+
+/*
+ * Read a sysfs attribute through a file descriptor that is kept open across
+ * polls. sysfs regenerates the content of an attribute on every read at
+ * offset 0, so pread() saves us the open() and close() on each sample.
+ * The fd is re-opened on the next call in case reading fails, e.g. if the
+ * adapter went away in the meantime.
+ */
+static int read_attribute(const char *path, int *fd, char *line, int *status)
 {
-	int fd;
+	ssize_t len;
 	int rc = 0;
 
-	fd = open(path, O_RDONLY);
-	if (fd < 0) {
-		rc = -1;		/* adapter gone */
-		goto out;
+	if (*fd < 0) {
+		*fd = open(path, O_RDONLY);
+		if (*fd < 0) {
+			rc = -1;	/* adapter gone */
+			goto out;
+		}
 	}
-	rc = read(fd, line, LINE_LEN);
-	if (rc < 0) {
+	poll_cost.reads++;
+	len = pread(*fd, line, LINE_LEN - 1, 0);
+	if (len < 0) {
+		close(*fd);
+		*fd = -1;
 		rc = -2;		/* I/O error */
 		goto out;
 	}
-	rc = 0;
-	close(fd);
+	line[len] = '\0';
 out:
 	if (status)
 		*status = rc;
@@ -467,29 +551,54 @@ out:
 	return rc;
 }
 
+/*
+ * Parse the next unsigned decimal number in the string pointed to by 'p',
+ * skipping leading blanks, and forward 'p' past the number.
+ * Returns 0 on success, -1 if no number was found.
+ */
+static int parse_ull(char **p, unsigned long long *val)
+{
+	char *s = *p;
+
+	while (*s == ' ' || *s == '\t')
+		s++;
+	if (*s < '0' || *s > '9')
+		return -1;
+	*val = 0;
+	while (*s >= '0' && *s <= '9')
+		*val = *val * 10 + (*s++ - '0');
+	*p = s;
+
+	return 0;
+}
+
 
 static int poll_utilization(struct adapters *all_adapters)
 {
 	char line[LINE_LEN];
-	int cpu, bus, adapter;
-	int rc = 0, grc = 0;
+	unsigned long long cpu, bus, adapter;
+	struct timespec cpu_start, wall_start;
+	int grc = 0;
 	struct adapter_data *adpt;
 	struct util_data    *u_data;
+	char *p;
 	int i;
 
+	poll_cost_start(&cpu_start, &wall_start);
 	for (i = 0; i < all_adapters->num_adapters; ++i) {
 		adpt = &all_adapters->adapters[i];
 		u_data = &adpt->data;
 		/* read utilization attribute */
-		if (read_attribute(adpt->path, line, &adpt->status)) {
+		if (read_attribute(adpt->path, &adpt->fd, line,
+				   &adpt->status)) {
 			grc++;
 			continue;
 		}
-		rc = sscanf(line, "%d %d %d", &cpu, &bus, &adapter);
-		if (rc != 3) {
+		p = line;
+		if (parse_ull(&p, &cpu) || parse_ull(&p, &bus)
+		    || parse_ull(&p, &adapter)) {
 			fprintf(stderr, "%s: Warning:"
-				" Could not parse %s: %s\n", toolname,
-				line, strerror(errno));
+				" Could not parse %s\n", toolname, line);
 			adpt->status = 3;
 			continue;
 		}
@@ -497,12 +606,13 @@ static int poll_utilization(struct adapters *all_adapters)
 		update_abbrev_stat(&u_data->bus, bus);
 		update_abbrev_stat(&u_data->cpu, cpu);
 
-		verbose_msg("data read for adapter %d: adapter=%d, bus=%d,"
-			    " cpu=%d\n",
+		verbose_msg("data read for adapter %d: adapter=%llu, bus=%llu,"
+			    " cpu=%llu\n",
 			    adpt->host_nr, adapter, bus, cpu);
 
 		u_data->count++;
 	}
+	poll_cost_stop(&cpu_start, &wall_start);
 
 	return grc;
 }
@@ -527,35 +637,40 @@ static int calc_overflow(__u64 old_val, __u64 new_val)
 static int poll_queue_full(int init, struct adapters *all_adapters)
 {
 	char line[LINE_LEN];
-	int rc = 0;
 	struct adapter_data *adpt;
 	struct util_data    *u_data;
+	unsigned long long queue_full_val;
 	int queue_full_tmp;
 	long long unsigned int queue_util_tmp;
-	int i;
+	struct timespec cpu_start, wall_start;
+	char *p;
+	int i, rc = 0;
 	struct timeval tmp, cur_time;
 
+	poll_cost_start(&cpu_start, &wall_start);
 	for (i = 0; i < all_adapters->num_adapters; ++i) {
 		adpt = &all_adapters->adapters[i];
 		u_data = &adpt->data;
 
 		/* read queue_full attribute */
-		if (read_attribute(adpt->q_full_path, line, &adpt->status))
+		if (read_attribute(adpt->q_full_path, &adpt->q_full_fd, line,
+				   &adpt->status))
 			continue;
-		rc = sscanf(line, "%d %Lu", &queue_full_tmp, &queue_util_tmp);
-		if (rc == 1) {
-			fprintf(stderr, "%s: Only one value in"
-				" %s, your kernel level is probably too old.\n",
-				toolname, adpt->q_full_path);
-			return -1;
-		}
-		if (rc != 2) {
+		p = line;
+		if (parse_ull(&p, &queue_full_val)) {
 			fprintf(stderr, "%s: Warning:"
-				" Could not parse %s: %s\n",
-				toolname, line,	strerror(errno));
+				" Could not parse %s\n", toolname, line);
 			adpt->status = 6;
 			continue;
 		}
+		if (parse_ull(&p, &queue_util_tmp)) {
+			fprintf(stderr, "%s: Only one value in"
+				" %s, your kernel level is probably too old.\n",
+				toolname, adpt->q_full_path);
+			rc = -1;
+			goto out;
+		}
+		queue_full_tmp = queue_full_val;
 		gettimeofday(&cur_time, NULL);
 		if (!init) {
 			if (queue_full_tmp < u_data->queue_full_prev)
@@ -580,8 +695,10 @@ static int poll_queue_full(int init, struct adapters *all_adapters)
 		u_data->queue_util_prev = queue_util_tmp;
 		u_data->queue_util_timestamp = cur_time;
 	}
+out:
+	poll_cost_stop(&cpu_start, &wall_start);
 
-	return 0;
+	return rc;
 }
 
 
@@ -589,28 +706,36 @@ static int poll_ioerr_cnt(int init, struct ioerr_data *data,
 			  struct options *opts)
 {
 	char line[LINE_LEN];
-	int rc = 0, grc = 0;
+	struct timespec cpu_start, wall_start;
+	unsigned long long val;
+	int grc = 0;
+	char *p;
 	int i;
 	__u32 tmp;
 
 	if (!init)
 		data->timestamp = time(NULL);
+	poll_cost_start(&cpu_start, &wall_start);
 	for (i=0; i<opts->num_luns; ++i) {
 		/* read ioerr_cnt attribute */
-		if (read_attribute(opts->luns[i], line, NULL)) {
+		if (read_attribute(opts->luns[i], &opts->lun_fds[i], line,
+				   NULL)) {
 			fprintf(stderr, "%s: Warning: Could not read %s\n",
 				toolname, opts->luns[i]);
 			grc++;
 			continue;
 		}
-		rc = sscanf(line, "%i", &tmp);
-		if (rc != 1) {
+		/* ioerr_cnt is printed as hex number with 0x prefix */
+		errno = 0;
+		val = strtoull(line, &p, 0);
+		if (p == line || errno) {
 			fprintf(stderr, "%s: Warning:"
-				" Could not parse ioerr line %s: %s\n",
-				toolname, line,	strerror(errno));
+				" Could not parse ioerr line %s\n",
+				toolname, line);
 			grc++;
 			continue;
 		}
+		tmp = val;
 		if (!init) {
 			if (tmp < opts->luns_prev[i])
 				data->ioerrors[i].num_ioerr = calc_overflow(
@@ -623,6 +748,7 @@ static int poll_ioerr_cnt(int init, struct ioerr_data *data,
 		}
 		opts->luns_prev[i] = tmp;
 	}
+	poll_cost_stop(&cpu_start, &wall_start);
 
 	return grc;
 }
@@ -667,6 +793,8 @@ static int init_adapters(struct adapters *all_adapters, struct options *opts)
 					toolname, adapter->q_full_path);
 				rc++;
 			}
+			adapter->fd = -1;
+			adapter->q_full_fd = -1;
 			adapter->status = 0;
 		}
 		init_util_data(&all_adapters->adapters[i].data);
@@ -683,6 +811,10 @@ static void deinit_adapters(struct adapters *all_adapters)
 	int i;
 
 	for (i = 0; i < all_adapters->num_adapters; ++i) {
+		if (all_adapters->adapters[i].fd >= 0)
+			close(all_adapters->adapters[i].fd);
+		if (all_adapters->adapters[i].q_full_fd >= 0)
+			close(all_adapters->adapters[i].q_full_fd);
 		free(all_adapters->adapters[i].path);
 		free(all_adapters->adapters[i].q_full_path);
 	}
@@ -707,6 +839,13 @@ static int init_ioerr_wrp(struct ioerr_wrp **wrp, struct options *opts)
 	}
 	(*wrp)->mtype = opts->msg_id_ioerr;
 	(*wrp)->data.num_luns = opts->num_luns;
+	opts->lun_fds = malloc(opts->num_luns * sizeof(int));
+	if (opts->num_luns && !opts->lun_fds) {
+		fprintf(stderr, "%s: Memory allocation failed\n", toolname);
+		return -1;
+	}
+	for (i = 0; i < opts->num_luns; ++i)
+		opts->lun_fds[i] = -1;
 	for (i=0; i<opts->num_luns; ++i) {
 		if (init_ioerr_cnt(&(*wrp)->data.ioerrors[i], opts->luns[i])) {
 			fprintf(stderr, "%s: Could not parse %s\n",
@@ -1366,6 +1505,7 @@ int main(int argc, char **argv)
 			break;	/* only publish results after a full cycle */
 
 		generate_result(&result_wrp->o_res, all_adapters);
+		poll_cost_report();
 
 		if (opts.msg_q >= 0)
 			/* Always print the first and the last message */
@@ -1383,6 +1523,8 @@ int main(int argc, char **argv)
 
 	if (!keep_running)
 		verbose_msg("signal received, ending...\n");
+	verbose_msg("total polling cost: %ld reads, %ld us cpu\n",
+		    poll_cost.reads_total, timespec_to_us(&poll_cost.cpu_total));
 
 out:
 	deinit_adapters(all_adapters);
@@ -285,3 +285,51 @@ int Framer::get_next_frameset(Frameset &frameset, bool replace_missing)
 	return rc;
 }
 
+
+int Framer::follow()
+{
+	__u64 limit;
+	__u64 num_frames;
+	int rc;
+
+	if (m_interval_length == 0)
+		return -1;
+
+	rc = sync_log_file(m_fp, &m_fhdr,
+			   m_begin - m_fhdr.interval_length / 2);
+	if (rc < 0)
+		return -1;
+
+	/* ziomon_mgr overwrote messages that we did not read yet, and moved
+	   them to the .agg file: start over with both files */
+	if (rc > 0) {
+		vverbose_msg(".log file wrapped past current position, re-open\n");
+		close_data_files(m_fp);
+		m_fp = NULL;
+		if (m_agg_data) {
+			discard_aggr_data_struct(m_agg_data);
+			free(m_agg_data);
+			m_agg_data = NULL;
+		}
+		if (open_data_files(&m_fp, m_filename, &m_fhdr, &m_agg_data))
+			return -2;
+		if (m_agg_data)
+			conv_aggr_data_msg_data_from_BE(m_agg_data);
+		m_agg_read = false;
+	}
+
+	/* A frame is complete once a message beyond its (shifted) end exists,
+	   since all messages of a frame are written before the first message
+	   of the next one */
+	limit = m_fhdr.end_time + m_fhdr.interval_length / 2;
+	num_frames = 0;
+	if (limit > m_begin)
+		num_frames = (limit - m_begin - 1) / m_interval_length;
+	if (num_frames)
+		m_end = m_begin + num_frames * m_interval_length
+			- m_fhdr.interval_length;
+	else
+		m_end = m_begin - 1;
+
+	return 0;
+}
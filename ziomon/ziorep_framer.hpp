@@ -51,6 +51,19 @@ public:
 	 */
 	int get_next_frameset(Frameset &frameset, bool replace_missing = false);
 
+	/**
+	 * Pick up data that ziomon_mgr appended to the .log file since the
+	 * last call, and extend the end of the timeframe to the last frame
+	 * that is complete, i.e. the last frame that a later message exists
+	 * for. Subsequent calls to get_next_frameset() will then return the
+	 * new frames, continuing at the current position in the file.
+	 * In case ziomon_mgr wrapped the .log file and overwrote messages
+	 * that were not read yet, the data files are re-opened and the
+	 * overwritten data is reported from the .agg file first.
+	 * Returns 0 in case of success, <0 in case of failure.
+	 */
+	int follow();
+
 private:
 	void handle_msg(struct message *msg, Frameset &frameset) const;
 	bool handle_agg_data(Frameset &frameset) const;
@@ -28,8 +28,10 @@ extern int verbose;
 
 
 
-Printer::Printer(const ConfigReader *cfg, bool csv_mode)
-: m_cfg(cfg), m_csv(csv_mode), m_prev_day(-1)
+Printer::Printer(const ConfigReader *cfg, bool csv_mode, bool json_mode,
+		 const char *json_rows)
+: m_cfg(cfg), m_csv(csv_mode), m_json(json_mode), m_prev_day(-1),
+	m_json_rows(json_rows), m_json_first(true)
 {
 	if (m_csv)
 		m_delim = ',';
@@ -52,12 +54,27 @@ bool Printer::print_csv() const
 }
 
 
+bool Printer::print_json() const
+{
+	return m_json;
+}
+
+
 void Printer::print_timestamp(FILE *fp, const Frameset &frameset)
 {
 	time_t t = frameset.get_end_time();
 	struct tm *tm = localtime(&t);
 
-	if (m_csv) {
+	if (m_json) {
+		fprintf(fp, "{\"timestamp\":\"%s\",\"aggregated\":%s,"
+			"\"interval\":%llu,\"%s\":[",
+			print_time_formatted(frameset.get_timestamp()),
+			frameset.is_aggregated() ? "true" : "false",
+			(long long unsigned int)frameset.get_duration(),
+			m_json_rows);
+		m_json_first = true;
+	}
+	else if (m_csv) {
 		fprintf(fp, "%s", print_time_formatted(frameset.get_timestamp()));
 		print_delimiter(fp);
 		fprintf(fp, "%d", frameset.is_aggregated());
@@ -171,7 +188,7 @@ void Printer::print_abbrev_num(FILE *fp, __u64 num, int max_digs) const
 	int rc = 0;
 	char tmp[128];
 
-	if (m_csv) {
+	if (m_csv || m_json) {
 		fprintf(fp, "%lld", (long long int)num);
 		return;
 	}
@@ -199,7 +216,11 @@ void Printer::print_abbrev_num(FILE *fp, double num, int max_digs,
 
 	assert(max_digs > 2);
 
-	if (m_csv) {
+	if (m_json && !isfinite(num)) {
+		fprintf(fp, "null");
+		return;
+	}
+	if (m_csv || m_json) {
 		fprintf(fp, "%lf", num);
 		return;
 	}
@@ -225,7 +246,11 @@ void Printer::print_abbrev_num(FILE *fp, double num) const
 	int  rc = 0;
 	char tmp[128];
 
-	if (m_csv) {
+	if (m_json && !isfinite(num)) {
+		fprintf(fp, "null");
+		return;
+	}
+	if (m_csv || m_json) {
 		fprintf(fp, "%.1lf", num);
 		return;
 	}
@@ -293,30 +318,88 @@ void Printer::print_delimiter(FILE *fp)
 
 void Printer::print_invalid(FILE *fp, int width)
 {
-	if (m_csv)
+	if (m_json)
+		fprintf(fp, "null");
+	else if (m_csv)
 		fputc('-', fp);
 	else
 		fprintf(fp, "%*c", width, '-');
 }
 
+void Printer::print_field(FILE *fp, const char *key)
+{
+	if (!m_json) {
+		print_delimiter(fp);
+		return;
+	}
+	if (!m_json_first)
+		fputc(',', fp);
+	m_json_first = false;
+	if (key)
+		fprintf(fp, "\"%s\":", key);
+}
+
+void Printer::print_json_open(FILE *fp, const char *key, char bracket)
+{
+	if (!m_json)
+		return;
+	print_field(fp, key);
+	fputc(bracket, fp);
+	m_json_first = true;
+}
+
+void Printer::print_json_close(FILE *fp, char bracket)
+{
+	if (!m_json)
+		return;
+	fputc(bracket, fp);
+	m_json_first = false;
+}
+
+void Printer::print_row_begin(FILE *fp)
+{
+	print_json_open(fp, NULL, '{');
+}
+
+void Printer::print_row_end(FILE *fp)
+{
+	if (m_json)
+		print_json_close(fp, '}');
+	else
+		fputc('\n', fp);
+}
+
+void Printer::print_frame_end(FILE *fp)
+{
+	if (!m_json)
+		return;
+	fprintf(fp, "]}\n");
+	m_json_first = true;
+}
+
 void PhysAdapterPrinter::print_phys_adpt(FILE *fp, __u32 host_id, int *rc)
 {
 	__u32 chpid = m_cfg->get_chpid_by_host_id(host_id, rc);
 
-	if (m_csv)
+	if (m_json) {
+		print_field(fp, "chpid");
+		fprintf(fp, "\"%x\"", chpid);
+	}
+	else if (m_csv)
 		fprintf(fp, "%x", chpid);
 	else
 		fprintf(fp, "%3x", chpid);
 }
 
 
-void PhysAdapterPrinter::print_utilization(FILE *fp,
+void PhysAdapterPrinter::print_utilization(FILE *fp, const char *key,
 					  const struct abbrev_stat *stat,
 					  __u64 count, bool valid)
 {
 	__u64 tmp64;
 
-	print_delimiter(fp);
+	print_json_open(fp, key, '{');
+	print_field(fp, "min");
 	if (valid) {
 		tmp64 = 0;
 		if (count)
@@ -327,7 +410,7 @@ void PhysAdapterPrinter::print_utilization(FILE *fp,
 		print_invalid(fp, 3);
 
 
-	print_delimiter(fp);
+	print_field(fp, "max");
 	if (valid) {
 		tmp64 = 0;
 		if (count)
@@ -337,7 +420,7 @@ void PhysAdapterPrinter::print_utilization(FILE *fp,
 	else
 		print_invalid(fp, 3);
 
-	print_delimiter(fp);
+	print_field(fp, "avg");
 	if (valid) {
 		double tmp = 0;
 		if (count)
@@ -346,18 +429,21 @@ void PhysAdapterPrinter::print_utilization(FILE *fp,
 	}
 	else
 		print_invalid(fp, 5);
+	print_json_close(fp, '}');
 }
 
 
 PhysAdapterPrinter::PhysAdapterPrinter(const ConfigReader *cfg,
-				       bool csv_mode)
-: Printer(cfg, csv_mode)
+				       bool csv_mode, bool json_mode)
+: Printer(cfg, csv_mode, json_mode, "adapters")
 {
 }
 
 
 void PhysAdapterPrinter::print_topline(FILE *fp)
 {
+	if (m_json)
+		return;
 	if (m_csv)
 		fprintf(fp, "timestamp,aggregated,CHPID,adapter min %%,"
 			"adapter max %%,adapter avg %%,bus min %%,bus max %%,"
@@ -387,31 +473,34 @@ int PhysAdapterPrinter::print_frame(FILE *fp,
 				// print timestamp for every line in CSV mode
 				timestamp_printed = true;
 		}
+		print_row_begin(fp);
 		print_phys_adpt(fp, *i, &lrc);
 		if (lrc)
 			return -1;
 		util = frameset.get_utilization_stat_by_host_id(*i);
 		if (!util)
 			util = get_empty_utilization(*i);
-		print_utilization(fp, &util->stats.adapter,
+		print_utilization(fp, "adapter", &util->stats.adapter,
 				  util->stats.count,
 				  util->valid);
-		print_utilization(fp, &util->stats.bus,
+		print_utilization(fp, "bus", &util->stats.bus,
 				  util->stats.count,
 				  util->valid);
-		print_utilization(fp, &util->stats.cpu,
+		print_utilization(fp, "cpu", &util->stats.cpu,
 				  util->stats.count,
 				  util->valid);
-		fputc('\n', fp);
+		print_row_end(fp);
 	}
+	if (timestamp_printed)
+		print_frame_end(fp);
 
 	return 0;
 }
 
 
 VirtAdapterPrinter::VirtAdapterPrinter(const ConfigReader *cfg,
-				       bool csv_mode)
-: Printer(cfg, csv_mode)
+				       bool csv_mode, bool json_mode)
+: Printer(cfg, csv_mode, json_mode, "subchannels")
 {
 }
 
@@ -419,7 +508,13 @@ VirtAdapterPrinter::VirtAdapterPrinter(const ConfigReader *cfg,
 void VirtAdapterPrinter::print_virt_adpt(FILE *fp, __u32 devno,
 					int *rc)
 {
-	if (m_csv)
+	if (m_json) {
+		print_field(fp, "chpid");
+		fprintf(fp, "\"%x\"", m_cfg->get_chpid_by_devno(devno, rc));
+		print_field(fp, "bus_id");
+		fprintf(fp, "\"%x.%x.%04x\"", ZIOREP_BUSID_UNPACKED(devno));
+	}
+	else if (m_csv)
 		fprintf(fp, "%x,%x.%x.%04x",
 			       m_cfg->get_chpid_by_devno(devno, rc),
 			       ZIOREP_BUSID_UNPACKED(devno));
@@ -438,14 +533,14 @@ void VirtAdapterPrinter::print_queue_fill(FILE *fp,
 	tmp = 0;
 	if (stat && stat->count)
 		tmp = (stat->outb_max * 100)/ZIOREP_PRINTERS_MAX_QUEUE_LEN;
-	print_delimiter(fp);
+	print_field(fp, "qdio_util_max");
 	print_abbrev_num(fp, tmp, 5);
 
 	tmp = 0;
 	if (res && res->valid)
 		tmp = res->stats.queue_util_integral
 			/ (double)res->stats.queue_util_interval;
-	print_delimiter(fp);
+	print_field(fp, "qdio_util_avg");
 	print_abbrev_num(fp, tmp, 5);
 }
 
@@ -459,18 +554,20 @@ void VirtAdapterPrinter::print_queue_full(FILE *fp,
 		if (res->valid)
 			val = res->stats.queue_full;
 		else {
+			if (m_json)
+				print_field(fp, "queue_full");
 			print_invalid(fp, 4);
 			return;
 		}
 	}
-	print_delimiter(fp);
+	print_field(fp, "queue_full");
 	print_abbrev_num(fp, val, 4);
 }
 
 
 void VirtAdapterPrinter::print_failures(FILE *fp, const struct ioerr_cnt *cnt)
 {
-	print_delimiter(fp);
+	print_field(fp, "failures");
 	if (cnt)
 		print_abbrev_num(fp, cnt->num_ioerr, 4);
 	else
@@ -487,27 +584,27 @@ void VirtAdapterPrinter::print_throughput(FILE *fp,
 		tmp = 0;
 	else
 		tmp = calc_avg(stat->size_r.sum, interval);
-	print_delimiter(fp);
+	print_field(fp, "throughput_read");
 	print_abbrev_num(fp, tmp);
 
 	if (!stat || interval == 0 || stat->size_w.num <= 0)
 		tmp = 0;
 	else
 		tmp = calc_avg(stat->size_w.sum, interval);
-	print_delimiter(fp);
+	print_field(fp, "throughput_write");
 	print_abbrev_num(fp, tmp);
 }
 
 
 void VirtAdapterPrinter::print_num_requests(FILE *fp, const struct blkiomon_stat *stat)
 {
-	print_delimiter(fp);
+	print_field(fp, "requests_read");
 	if (stat)
 		print_abbrev_num(fp, stat->size_r.num, 4);
 	else
 		print_abbrev_num(fp, (__u64)0, 4);
 
-	print_delimiter(fp);
+	print_field(fp, "requests_write");
 	if (stat)
 		print_abbrev_num(fp, stat->size_w.num, 4);
 	else
@@ -517,6 +614,8 @@ void VirtAdapterPrinter::print_num_requests(FILE *fp, const struct blkiomon_stat
 
 void VirtAdapterPrinter::print_topline(FILE *fp)
 {
+	if (m_json)
+		return;
 	if (m_csv)
 		fprintf(fp, "timestamp,aggregated,CHPID,Bus-ID,qdio utilization max %%,qdio utilization avg %%,queue full,fail erc,throughput read / MS/s,throughput write / MS/s,I/O requests read,I/O requests write\n");
 	else {
@@ -560,6 +659,7 @@ int VirtAdapterPrinter::print_frame(FILE *fp,
 		ioerr = frameset.get_ioerr_stat_by_devno(*i);
 		blk_stat = frameset.get_blkiomon_stat_by_devno(*i);
 		zfcp_stat = frameset.get_zfcpdd_stat_by_devno(*i);
+		print_row_begin(fp);
 		print_virt_adpt(fp, *i, &lrc);
 		print_queue_fill(fp, zfcp_stat, util);
 		print_queue_full(fp, util);
@@ -572,8 +672,10 @@ int VirtAdapterPrinter::print_frame(FILE *fp,
 				" data and try again.\n", toolname);
 			return -1;
 		}
-		fputc('\n', fp);
+		print_row_end(fp);
 	}
+	if (timestamp_printed)
+		print_frame_end(fp);
 
 	return 0;
 }
@@ -581,8 +683,8 @@ int VirtAdapterPrinter::print_frame(FILE *fp,
 
 
 TrafficPrinter::TrafficPrinter(const ConfigReader *cfg, Collapser &col,
-			       bool csv_mode)
-: Printer(cfg, csv_mode), m_mp_whitespace(NULL), m_mp_topline_pref1(NULL),
+			       bool csv_mode, bool json_mode)
+: Printer(cfg, csv_mode, json_mode, "devices"), m_mp_whitespace(NULL), m_mp_topline_pref1(NULL),
 	m_mp_topline_pref2(NULL)
 {
 	m_agg_crit = col.get_criterion();
@@ -760,12 +862,21 @@ void TrafficPrinter::get_device_list(list<__u64> &lst,
 
 void TrafficPrinter::print_device_wwpn(FILE *fp, __u64 wwpn)
 {
-	fprintf(fp, "0x%016Lx", (long long unsigned int)wwpn);
+	if (m_json) {
+		print_field(fp, "wwpn");
+		fprintf(fp, "\"0x%016Lx\"", (long long unsigned int)wwpn);
+	}
+	else
+		fprintf(fp, "0x%016Lx", (long long unsigned int)wwpn);
 }
 
 void TrafficPrinter::print_device_chpid(FILE *fp, __u32 chpid)
 {
-	if (m_csv)
+	if (m_json) {
+		print_field(fp, "chpid");
+		fprintf(fp, "\"%x\"", chpid);
+	}
+	else if (m_csv)
 		fprintf(fp, "%x", chpid);
 	else
 		fprintf(fp, "%3x", chpid);
@@ -773,13 +884,22 @@ void TrafficPrinter::print_device_chpid(FILE *fp, __u32 chpid)
 
 void TrafficPrinter::print_device_devno(FILE *fp, __u32 devno)
 {
-	fprintf(fp, "%x.%x.%04x", ZIOREP_BUSID_UNPACKED(devno));
+	if (m_json) {
+		print_field(fp, "bus_id");
+		fprintf(fp, "\"%x.%x.%04x\"", ZIOREP_BUSID_UNPACKED(devno));
+	}
+	else
+		fprintf(fp, "%x.%x.%04x", ZIOREP_BUSID_UNPACKED(devno));
 }
 
 void TrafficPrinter::print_device_mp_mm(FILE *fp, __u32 mp_mm,
 				       const ConfigReader &cfg, int *rc)
 {
-	if (m_csv)
+	if (m_json) {
+		print_field(fp, "multipath_device");
+		fprintf(fp, "\"%s\"", cfg.get_multipath_by_mp_mm(mp_mm, rc));
+	}
+	else if (m_csv)
 		fprintf(fp, "%s", cfg.get_multipath_by_mp_mm(mp_mm, rc));
 	else
 		fprintf(fp, "%16s", cfg.get_multipath_by_mp_mm(mp_mm, rc));
@@ -788,7 +908,15 @@ void TrafficPrinter::print_device_mp_mm(FILE *fp, __u32 mp_mm,
 void TrafficPrinter::print_device(FILE *fp, __u32 dev,
 				 const ConfigReader &cfg, int *rc)
 {
-	if (m_csv)
+	if (m_json) {
+		print_field(fp, "wwpn");
+		fprintf(fp, "\"0x%016Lx\"",
+			(long long unsigned int)cfg.get_wwpn_by_mm_internal(dev, rc));
+		print_field(fp, "lun");
+		fprintf(fp, "\"0x%016Lx\"",
+			(long long unsigned int)cfg.get_lun_by_mm_internal(dev, rc));
+	}
+	else if (m_csv)
 		fprintf(fp, "0x%016Lx,0x%016Lx",
 			       (long long unsigned int)cfg.get_wwpn_by_mm_internal(dev, rc),
 			       (long long unsigned int)cfg.get_lun_by_mm_internal(dev, rc));
@@ -800,7 +928,11 @@ void TrafficPrinter::print_device(FILE *fp, __u32 dev,
 
 void TrafficPrinter::print_device_all(FILE *fp)
 {
-	if (m_csv)
+	if (m_json) {
+		print_field(fp, "device");
+		fprintf(fp, "\"*\"");
+	}
+	else if (m_csv)
 		fprintf(fp, "*");
 	else
 		fprintf(fp, " * ");
@@ -859,15 +991,18 @@ int TrafficPrinter::print_frame(FILE *fp, const Frameset &frameset,
 
 			blk_stat = frameset.get_blkiomon_stat_by_wwpn(*i);
 			zfcp_stat = frameset.get_zfcpdd_stat_by_wwpn(*i);
+			print_row_begin(fp);
 			print_device_wwpn(fp, *i);
 			print_data_row(fp, blk_stat, zfcp_stat, interval);
 		}
 	}
 	else if (m_agg_crit == all) {
 		print_timestamp(fp, frameset);
+		timestamp_printed = true;
 
 		blk_stat = frameset.get_first_blkiomon_stat();
 		zfcp_stat = frameset.get_first_zfcpdd_stat();
+		print_row_begin(fp);
 		print_device_all(fp);
 		print_data_row(fp, blk_stat, zfcp_stat, interval);
 	}
@@ -881,6 +1016,7 @@ int TrafficPrinter::print_frame(FILE *fp, const Frameset &frameset,
 					timestamp_printed = true;
 			}
 
+			print_row_begin(fp);
 			switch (m_agg_crit) {
 			case none:
 				blk_stat = frameset.get_blkiomon_stat_by_mm(*i);
@@ -910,6 +1046,8 @@ int TrafficPrinter::print_frame(FILE *fp, const Frameset &frameset,
 			print_data_row(fp, blk_stat, zfcp_stat, interval);
 		}
 	}
+	if (timestamp_printed)
+		print_frame_end(fp);
 
 	return 0;
 }
@@ -917,14 +1055,16 @@ int TrafficPrinter::print_frame(FILE *fp, const Frameset &frameset,
 
 SummaryTrafficPrinter::SummaryTrafficPrinter(const ConfigReader *cfg,
 					     Collapser &col,
-					     bool csv_mode)
-: TrafficPrinter(cfg, col, csv_mode)
+					     bool csv_mode, bool json_mode)
+: TrafficPrinter(cfg, col, csv_mode, json_mode)
 {
 }
 
 
 void SummaryTrafficPrinter::print_topline(FILE *fp)
 {
+	if (m_json)
+		return;
 	if (m_csv) {
 		fprintf(fp, "timestamp,aggregated,");
 		print_topline_prefix1(fp);
@@ -965,7 +1105,7 @@ void SummaryTrafficPrinter::print_throughput(FILE *fp, const struct blkiomon_sta
 	tmp = 0;
 	if (stat)
 		tmp = thrp_data.min / 1000.;
-	print_delimiter(fp);
+	print_field(fp, "io_rate_min");
 	if (tmp < 1)
 		print_abbrev_num(fp, tmp, 5, true);
 	else
@@ -974,7 +1114,7 @@ void SummaryTrafficPrinter::print_throughput(FILE *fp, const struct blkiomon_sta
 	tmp = 0;
 	if (stat)
 		tmp = ((double)(thrp_data.max)) / 1000.;
-	print_delimiter(fp);
+	print_field(fp, "io_rate_max");
 	if (tmp < 1)
 		print_abbrev_num(fp, tmp, 5, false);
 	else
@@ -983,14 +1123,14 @@ void SummaryTrafficPrinter::print_throughput(FILE *fp, const struct blkiomon_sta
 	tmp = 0;
 	if (stat && total_size.sum > 0)
 		tmp = calc_avg(total_size.sum, interval);
-	print_delimiter(fp);
+	print_field(fp, "throughput_avg");
 	print_abbrev_num(fp, tmp);
 
 	tmp = 0;
 	if (stat && total_size.sum > 0)
 		tmp = calc_std_dev(total_size.sum, total_size.sos,
 					total_latency.sum);
-	print_delimiter(fp);
+	print_field(fp, "throughput_stdev");
 	print_abbrev_num(fp, tmp);
 }
 
@@ -1002,90 +1142,94 @@ void SummaryTrafficPrinter::print_request_stats(FILE *fp,
 	val = 0;
 	if (stat)
 		val = stat->bidir + stat->thrput_r.num + stat->thrput_w.num;
-	print_delimiter(fp);
+	print_field(fp, "requests");
 	print_abbrev_num(fp, val, 5);
 
 	val = 0;
 	if (stat)
 		val = stat->size_r.num;
-	print_delimiter(fp);
+	print_field(fp, "requests_read");
 	print_abbrev_num(fp, val, 4);
 
 	val = 0;
 	if (stat)
 		val = stat->size_w.num;
-	print_delimiter(fp);
+	print_field(fp, "requests_write");
 	print_abbrev_num(fp, val, 4);
 
 	val = 0;
 	if (stat)
 		val = stat->bidir;
-	print_delimiter(fp);
+	print_field(fp, "requests_bidi");
 	print_abbrev_num(fp, val, 4);
 }
 
 
-void SummaryTrafficPrinter::print_latency(FILE *fp,
+void SummaryTrafficPrinter::print_latency(FILE *fp, const char *key,
 					 const struct minmax *data)
 {
 	__u64 tmp64;
 	double tmplf;
 
+	print_json_open(fp, key, '{');
 	tmp64 = 0;
 	if (data && data->num > 0)
 		tmp64 = data->min;
-	print_delimiter(fp);
+	print_field(fp, "min");
 	print_abbrev_num(fp, tmp64, 4);
 
 	tmp64 = 0;
 	if (data && data->num > 0)
 		tmp64 = data->max;
-	print_delimiter(fp);
+	print_field(fp, "max");
 	print_abbrev_num(fp, tmp64, 4);
 
 	tmplf = 0;
 	if (data && data->num > 0)
 		tmplf = minmax_avg(data);
-	print_delimiter(fp);
+	print_field(fp, "avg");
 	print_abbrev_num(fp, tmplf);
 
 	tmplf = 0;
 	if (data && data->num > 0)
 		tmplf = minmax_std_dev(data);
-	print_delimiter(fp);
+	print_field(fp, "stdev");
 	print_abbrev_num(fp, tmplf);
+	print_json_close(fp, '}');
 }
 
-void SummaryTrafficPrinter::print_latency(FILE *fp,
+void SummaryTrafficPrinter::print_latency(FILE *fp, const char *key,
 					 const struct abbrev_stat *data,
 					 __u64 count)
 {
 	__u64 tmp64;
 	double tmplf;
 
+	print_json_open(fp, key, '{');
 	tmp64 = 0;
 	if (count > 0)
 		tmp64 = data->min;
-	print_delimiter(fp);
+	print_field(fp, "min");
 	print_abbrev_num(fp, tmp64, 4);
 
 	tmp64 = 0;
 	if (count > 0)
 		tmp64 = data->max;
-	print_delimiter(fp);
+	print_field(fp, "max");
 	print_abbrev_num(fp, tmp64, 4);
 
 	tmplf = 0;
 	if (count > 0)
 		tmplf = calc_avg(data->sum, count);
-	print_delimiter(fp);
+	print_field(fp, "avg");
 	print_abbrev_num(fp, tmplf);
 
 	tmplf = 0;
 	if (count > 0)
 		tmplf = calc_std_dev(data->sum, data->sos, count);
-	print_delimiter(fp);
+	print_field(fp, "stdev");
 	print_abbrev_num(fp, tmplf);
+	print_json_close(fp, '}');
 }
 
 void SummaryTrafficPrinter::print_io_subsystem_latency(FILE *fp,
@@ -1099,18 +1243,18 @@ void SummaryTrafficPrinter::print_io_subsystem_latency(FILE *fp,
 		minmax_merge(&data, &stat->d2c_w);
 	}
 
-	print_latency(fp, &data);
+	print_latency(fp, "io_subsystem_latency", &data);
 }
 
 void SummaryTrafficPrinter::print_channel_latency(FILE *fp,
 					const struct zfcpdd_dstat *stat)
 {
-	print_latency(fp, &stat->chan_lat, stat->count);
+	print_latency(fp, "channel_latency", &stat->chan_lat, stat->count);
 }
 
 void SummaryTrafficPrinter::print_fabric_latency(FILE *fp, const struct zfcpdd_dstat *stat)
 {
-	print_latency(fp, &stat->fabr_lat, stat->count);
+	print_latency(fp, "fabric_latency", &stat->fabr_lat, stat->count);
 }
 
 void SummaryTrafficPrinter::print_data_row(FILE *fp,
@@ -1128,20 +1272,22 @@ void SummaryTrafficPrinter::print_data_row(FILE *fp,
 	print_io_subsystem_latency(fp, blk_stat);
 	print_channel_latency(fp, zfcp_stat);
 	print_fabric_latency(fp, zfcp_stat);
-	fputc('\n', fp);
+	print_row_end(fp);
 }
 
 
 DetailedTrafficPrinter::DetailedTrafficPrinter(const ConfigReader *cfg,
 					       Collapser &col,
-					       bool csv_mode)
-: TrafficPrinter(cfg, col, csv_mode)
+					       bool csv_mode, bool json_mode)
+: TrafficPrinter(cfg, col, csv_mode, json_mode)
 {
 }
 
 
 void DetailedTrafficPrinter::print_topline(FILE *fp)
 {
+	if (m_json)
+		return;
 	if (m_csv) {
 		fprintf(fp, "timestamp,aggregated,");
 		print_topline_prefix1(fp);
@@ -1201,74 +1347,82 @@ void DetailedTrafficPrinter::print_data_row(FILE *fp,
 		zfcp_stat = get_empty_zfcpdd_dstat();
 
 	print_histogram_io_reqs(fp, blk_stat);
-	if (!m_csv) {
+	if (!m_csv && !m_json) {
 		fputc('\n', fp);
 		print_topline_whitespace(fp);
 	}
 	print_histogram_io_subs_lat(fp, blk_stat);
-	if (!m_csv) {
+	if (!m_csv && !m_json) {
 		fputc('\n', fp);
 		print_topline_whitespace(fp);
 	}
 	print_histogram_channel_lat(fp, zfcp_stat);
-	if (!m_csv) {
+	if (!m_csv && !m_json) {
 		fputc('\n', fp);
 		print_topline_whitespace(fp);
 	}
 	print_histogram_fabric_lat(fp, zfcp_stat);
-	fputc('\n', fp);
+	print_row_end(fp);
 }
 
 
 void DetailedTrafficPrinter::print_histogram_io_reqs(FILE *fp,
 			    const struct blkiomon_stat *stat)
 {
+	print_json_open(fp, "request_sizes", '[');
 	for (unsigned int i = 0; i < BLKIOMON_SIZE_BUCKETS; ++i) {
-		print_delimiter(fp);
+		print_field(fp, NULL);
 		if (stat)
 			print_abbrev_num(fp, stat->size_hist[i], 4);
 		else
 			print_abbrev_num(fp, (__u32)0, 4);
 	}
+	print_json_close(fp, ']');
 }
 
 
 void DetailedTrafficPrinter::print_histogram_io_subs_lat(FILE *fp,
 				const struct blkiomon_stat *stat)
 {
+	print_json_open(fp, "io_subsystem_latency", '[');
 	for (unsigned int i = 0; i < BLKIOMON_D2C_BUCKETS; ++i) {
-		print_delimiter(fp);
+		print_field(fp, NULL);
 		if (stat)
 			print_abbrev_num(fp, stat->d2c_hist[i], 4);
 		else
 			print_abbrev_num(fp, (__u32)0, 4);
 	}
+	print_json_close(fp, ']');
 }
 
 
 void DetailedTrafficPrinter::print_histogram_channel_lat(FILE *fp,
 				const struct zfcpdd_dstat *stat)
 {
+	print_json_open(fp, "channel_latency", '[');
 	for (unsigned int i = 0; i < BLKIOMON_CHAN_LAT_BUCKETS; ++i) {
-		print_delimiter(fp);
+		print_field(fp, NULL);
 		if (stat)
 			print_abbrev_num(fp, stat->chan_lat_hist[i], 4);
 		else
 			print_abbrev_num(fp, (__u32)0, 4);
 	}
+	print_json_close(fp, ']');
 }
 
 
 void DetailedTrafficPrinter::print_histogram_fabric_lat(FILE *fp,
 			       const struct zfcpdd_dstat *stat)
 {
+	print_json_open(fp, "fabric_latency", '[');
 	for (unsigned int i = 0; i < BLKIOMON_FABR_LAT_BUCKETS; ++i) {
-		print_delimiter(fp);
+		print_field(fp, NULL);
 		if (stat)
 			print_abbrev_num(fp, stat->fabr_lat_hist[i], 4);
 		else
 			print_abbrev_num(fp, (__u32)0, 4);
 	}
+	print_json_close(fp, ']');
 }
 
 
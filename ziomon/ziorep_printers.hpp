@@ -22,7 +22,12 @@
  */
 class Printer {
 public:
-	Printer(const ConfigReader *cfg, bool csv_mode);
+	/**
+	 * In JSON mode, each frame is printed as a single JSON object on a
+	 * line of its own, with the rows of the frame in an array named
+	 * 'json_rows'. */
+	Printer(const ConfigReader *cfg, bool csv_mode, bool json_mode = false,
+		const char *json_rows = "rows");
 	virtual ~Printer() {};
 
 	/**
@@ -39,6 +44,9 @@ public:
 	/// Whether the output should be done in CSV format or not
 	bool print_csv() const;
 
+	/// Whether the output should be done in JSON format or not
+	bool print_json() const;
+
 protected:
 	/**
 	 * Print timestamp before the actual frame is printed.
@@ -74,8 +82,31 @@ protected:
 	/// Print a character indicating that the respective value is not valid
 	inline void print_invalid(FILE *fp, int width);
 
+	/**
+	 * Print what goes in front of the next value. That's the delimiter
+	 * for regular and CSV output, and the (optional) name 'key' of the
+	 * value in JSON mode. */
+	void print_field(FILE *fp, const char *key);
+
+	/**
+	 * Open a JSON object ('{') or array ('[') named 'key'.
+	 * No-ops unless in JSON mode. */
+	void print_json_open(FILE *fp, const char *key, char bracket);
+	void print_json_close(FILE *fp, char bracket);
+
+	/**
+	 * Begin and end a row of data. Ending a row prints a newline
+	 * unless in JSON mode. */
+	void print_row_begin(FILE *fp);
+	void print_row_end(FILE *fp);
+
+	/// Terminate a frame that print_timestamp() was called for
+	void print_frame_end(FILE *fp);
+
 	/// set if result should be printed is csv
 	bool				m_csv;
+	/// set if result should be printed as JSON
+	bool				m_json;
 	char				m_delim;
 
 private:
@@ -94,12 +125,18 @@ private:
 
 	/// day of month of last day that was printed
 	int				m_prev_day;
+
+	/// name of the array that holds the rows of a frame in JSON mode
+	const char			*m_json_rows;
+	/// set if no value was printed in the current JSON object yet
+	bool				m_json_first;
 };
 
 
 class PhysAdapterPrinter : public Printer {
 public:
-	PhysAdapterPrinter(const ConfigReader *cfg, bool csv_mode);
+	PhysAdapterPrinter(const ConfigReader *cfg, bool csv_mode,
+			   bool json_mode = false);
 
 	virtual void print_topline(FILE *fp);
 	virtual int print_frame(FILE *fp, const Frameset &frameset,
@@ -108,7 +145,8 @@ public:
 private:
 	void print_phys_adpt(FILE *fp, __u32 host_id,
 			     int *rc);
-	void print_utilization(FILE *fp, const struct abbrev_stat *stat,
+	void print_utilization(FILE *fp, const char *key,
+			       const struct abbrev_stat *stat,
 			       __u64 count, bool valid);
 
 };
@@ -116,7 +154,8 @@ private:
 
 class VirtAdapterPrinter : public Printer {
 public:
-	VirtAdapterPrinter(const ConfigReader *cfg, bool csv_mode);
+	VirtAdapterPrinter(const ConfigReader *cfg, bool csv_mode,
+			   bool json_mode = false);
 
 	virtual void print_topline(FILE *fp);
 	virtual int print_frame(FILE *fp, const Frameset &frameset,
@@ -141,7 +180,7 @@ public:
 
 protected:
 	TrafficPrinter(const ConfigReader *cfg, Collapser &col,
-			bool csv_mode);
+			bool csv_mode, bool json_mode);
 	virtual ~TrafficPrinter();
 
 	/**
@@ -180,7 +219,8 @@ protected:
 class SummaryTrafficPrinter : public TrafficPrinter {
 public:
 	SummaryTrafficPrinter(const ConfigReader *cfg,
-			      Collapser &col, bool csv_mode);
+			      Collapser &col, bool csv_mode,
+			      bool json_mode = false);
 
 	virtual void print_topline(FILE *fp);
 
@@ -195,16 +235,17 @@ private:
 	void print_io_subsystem_latency(FILE *fp, const struct blkiomon_stat *stat);
 	void print_channel_latency(FILE *fp, const struct zfcpdd_dstat *stat);
 	void print_fabric_latency(FILE *fp, const struct zfcpdd_dstat *stat);
-	void print_latency(FILE *fp, const struct minmax *data);
-	void print_latency(FILE *fp, const struct abbrev_stat *data,
-			  __u64 count);
+	void print_latency(FILE *fp, const char *key,
+			  const struct minmax *data);
+	void print_latency(FILE *fp, const char *key,
+			  const struct abbrev_stat *data, __u64 count);
 };
 
 
 class DetailedTrafficPrinter : public TrafficPrinter {
 public:
 	DetailedTrafficPrinter(const ConfigReader *cfg, Collapser &col,
-			       bool csv_mode);
+			       bool csv_mode, bool json_mode = false);
 
 	virtual void print_topline(FILE *fp);
 
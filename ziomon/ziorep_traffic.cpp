@@ -49,6 +49,8 @@ struct options {
 	list<__u64>		wwpns;
 	list<__u64>		luns;
 	bool			csv_export;
+	bool			json;
+	bool			follow;
 };
 
 
@@ -63,6 +65,8 @@ static void init_opts(struct options *opts)
 	opts->details		= false;
 	opts->col_crit		= none;
 	opts->csv_export	= false;
+	opts->json		= false;
+	opts->follow		= false;
 }
 
 
@@ -70,8 +74,8 @@ static const char help_text[] =
     "Usage: ziorep_traffic [-V] [-v] [-h] [-b <begin>] [-e <end>]"
     " [-i <time>] [-s]\n"
     "                        [-c <chpid>] [-u <id>] [-t <num>] [-p <port>]\n"
-    "                        [-l <lun>] [-d <fdev> ] [-m <mdev>] [-x] [-D]\n"
-    "                        [-C a|u|p|m|A] <filename>\n\n"
+    "                        [-l <lun>] [-d <fdev> ] [-m <mdev>] [-x] [-j]\n"
+    "                        [-D] [-f] [-C a|u|p|m|A] <filename>\n\n"
     "-h, --help              Print usage information and exit.\n"
     "-v, --version           Print version information and exit.\n"
     "-V, --verbose           Be verbose.\n"
@@ -99,6 +103,9 @@ static const char help_text[] =
     "                        e.g. '-m 36005076303ffc1040002120'\n"
     "-D, --detailed          Print histograms instead of min/max/avg/stdev\n"
     "-x, --export-csv        Export data to files in CSV format.\n"
+    "-j, --json              Print data in JSON format, one object per frame.\n"
+    "-f, --follow            Keep reading data from a running ziomon session\n"
+    "                        and print each frame as soon as it is complete.\n"
     "-t, --topline <num>     Repeat topline after every 'num' frames.\n"
     "                        0 for no repeat (default).\n";
 
@@ -142,6 +149,8 @@ static int parse_params(int argc, char **argv, struct options *opts)
 		{ "mdev",            required_argument, NULL, 'm'},
 		{ "detailed",        required_argument, NULL, 'D'},
 		{ "export-csv",      no_argument,       NULL, 'x'},
+		{ "json",            no_argument,       NULL, 'j'},
+		{ "follow",          no_argument,       NULL, 'f'},
 		{ "topline",         required_argument, NULL, 't'},
                 { 0,                 0,                 0,     0 }
 	};
@@ -152,7 +161,7 @@ static int parse_params(int argc, char **argv, struct options *opts)
 	}
 
 	assert(sizeof(long long int) == sizeof(__u64));
-	while ((c = getopt_long(argc, argv, "m:C:b:e:i:c:u:p:l:d:t:xDshvV",
+	while ((c = getopt_long(argc, argv, "m:C:b:e:i:c:u:p:l:d:t:xjfDshvV",
 				long_options, &index)) != EOF) {
 		switch (c) {
 		case 'V':
@@ -247,6 +256,12 @@ static int parse_params(int argc, char **argv, struct options *opts)
 		case 'x':
 			opts->csv_export = true;
 			break;
+		case 'j':
+			opts->json = true;
+			break;
+		case 'f':
+			opts->follow = true;
+			break;
 		case 'C':
 			rc = 0;
 			switch (*optarg) {
@@ -372,6 +387,9 @@ static int check_opts(struct options *opts, ConfigReader **cfg)
 			" topline repeat.\n", toolname);
 		opts->topline = 0;
 	}
+	if (check_output_opts(opts->csv_export, opts->json, opts->follow,
+			      opts->print_summary, opts->end, opts->interval))
+		rc = -9;
 
 	if (!opts->print_summary
 	    && adjust_timeframe(opts->filename, &opts->begin, &opts->end,
@@ -491,7 +509,8 @@ static int print_report(struct options *opts, ConfigReader &cfg)
 		else
 			fp = stdout;
 		printer = new DetailedTrafficPrinter(&cfg, *col,
-						     opts->csv_export);
+						     opts->csv_export,
+						     opts->json);
 	}
 	else {
 		if (opts->csv_export) {
@@ -504,10 +523,23 @@ static int print_report(struct options *opts, ConfigReader &cfg)
 		else
 			fp = stdout;
 		printer = new SummaryTrafficPrinter(&cfg, *col,
-						    opts->csv_export);
+						    opts->csv_export,
+						    opts->json);
 	}
 
-	if ( (rc = print_report(fp, opts->begin, opts->end,
+	if (opts->follow) {
+		vector<struct follow_report> reports(1);
+
+		reports[0].filter_types = &type_flt;
+		reports[0].dev_filter = dev_filt;
+		reports[0].col = col;
+		reports[0].printer = printer;
+		reports[0].fp = fp;
+		if (follow_reports(opts->begin, opts->interval, opts->filename,
+				   opts->topline, reports) < 0)
+			rc = -3;
+	}
+	else if ( (rc = print_report(fp, opts->begin, opts->end,
 				opts->interval, opts->filename, opts->topline,
 				&type_flt, *dev_filt, *col, *printer)) < 0 )
 		rc = -3;
@@ -49,6 +49,8 @@ struct options {
 	char*		filename;
 	bool		print_summary;
 	bool		csv_export;
+	bool		json;
+	bool		follow;
 };
 
 
@@ -61,12 +63,15 @@ static void init_opts(struct options *opts)
 	opts->filename		= NULL;
 	opts->print_summary	= false;
 	opts->csv_export	= false;
+	opts->json		= false;
+	opts->follow		= false;
 }
 
 
 static const char help_text[] =
     "Usage: ziorep_utilization [-V] [-v] [-h] [-b <begin>] [-e <end>] [-i <time>]\n"
-    "                          [-x] [-s] [-c <chpid>] [-t <num>] <filename>\n\n"
+    "                          [-x] [-j] [-f] [-s] [-c <chpid>] [-t <num>]\n"
+    "                          <filename>\n\n"
     "-h, --help              Print usage information and exit.\n"
     "-v, --version           Print version information and exit.\n"
     "-V, --verbose           Be verbose.\n"
@@ -86,6 +91,9 @@ static const char help_text[] =
     "-c, --chpid <chpid>     Select physical adapter in hex.\n"
     "                        E.g. '-c 32a'\n"
     "-x, --export-csv        Export data to files in CSV format.\n"
+    "-j, --json              Print data in JSON format, one object per frame.\n"
+    "-f, --follow            Keep reading data from a running ziomon session\n"
+    "                        and print each frame as soon as it is complete.\n"
     "-t, --topline <num>     Repeat topline after every 'num' frames.\n"
     "                        0 for no repeat (default).\n";
 
@@ -120,6 +128,8 @@ static int parse_params(int argc, char **argv, struct options *opts)
 		{ "summary",         no_argument,       NULL, 's'},
 		{ "chpid",           required_argument, NULL, 'c'},
 		{ "export-csv",      no_argument,       NULL, 'x'},
+		{ "json",            no_argument,       NULL, 'j'},
+		{ "follow",          no_argument,       NULL, 'f'},
 		{ "topline",         required_argument, NULL, 't'},
                 { 0,                 0,                 0,     0 }
 	};
@@ -130,7 +140,7 @@ static int parse_params(int argc, char **argv, struct options *opts)
 	}
 
 	assert(sizeof(long long int) == sizeof(__u64));
-	while ((c = getopt_long(argc, argv, "b:e:i:c:t:xshvV",
+	while ((c = getopt_long(argc, argv, "b:e:i:c:t:xjfshvV",
 				long_options, &index)) != EOF) {
 		switch (c) {
 		case 'V':
@@ -179,6 +189,12 @@ static int parse_params(int argc, char **argv, struct options *opts)
 		case 'x':
 			opts->csv_export = true;
 			break;
+		case 'j':
+			opts->json = true;
+			break;
+		case 'f':
+			opts->follow = true;
+			break;
 		case 't':
 			if (parse_topline_arg(optarg, &opts->topline))
 				return -1;
@@ -252,6 +268,9 @@ static int check_opts(struct options *opts, ConfigReader **cfg)
 			" topline repeat.\n", toolname);
 		opts->topline = 0;
 	}
+	if (check_output_opts(opts->csv_export, opts->json, opts->follow,
+			      opts->print_summary, opts->end, opts->interval))
+		rc = -4;
 
 	if (!opts->print_summary
 		&& adjust_timeframe(opts->filename, &opts->begin, &opts->end,
@@ -262,11 +281,60 @@ static int check_opts(struct options *opts, ConfigReader **cfg)
 }
 
 
+static int follow_util_reports(struct options *opts,
+			       StagedDeviceFilter &dev_filt,
+			       NoopCollapser &noop_col,
+			       AggregationCollapser &col,
+			       list<MsgTypes> &type_flt,
+			       PhysAdapterPrinter &physPrnt,
+			       VirtAdapterPrinter &virtPrnt)
+{
+	vector<struct follow_report> reports(2);
+	FILE *fp_phys = stdout, *fp_virt = stdout;
+	int rc = 0;
+
+	if (opts->csv_export) {
+		fp_phys = open_csv_output_file(opts->filename,
+					       "_util_phys_adpt.csv", &rc);
+		if (!fp_phys)
+			return -1;
+		fp_virt = open_csv_output_file(opts->filename,
+					       "_util_virt_adpt.csv", &rc);
+		if (!fp_virt) {
+			fclose(fp_phys);
+			return -1;
+		}
+	}
+
+	reports[0].filter_types = &type_flt;
+	reports[0].dev_filter = &dev_filt;
+	reports[0].col = &noop_col;
+	reports[0].printer = &physPrnt;
+	reports[0].fp = fp_phys;
+	reports[1].filter_types = NULL;
+	reports[1].dev_filter = &dev_filt;
+	reports[1].col = &col;
+	reports[1].printer = &virtPrnt;
+	reports[1].fp = fp_virt;
+
+	if (follow_reports(opts->begin, opts->interval, opts->filename,
+			   opts->topline, reports) < 0)
+		rc = -3;
+
+	if (opts->csv_export) {
+		fclose(fp_phys);
+		fclose(fp_virt);
+	}
+
+	return rc;
+}
+
+
 static int print_reports(struct options *opts, ConfigReader &cfg)
 {
 	int rc = 0;
-	PhysAdapterPrinter physPrnt(&cfg, opts->csv_export);
-	VirtAdapterPrinter virtPrnt(&cfg, opts->csv_export);
+	PhysAdapterPrinter physPrnt(&cfg, opts->csv_export, opts->json);
+	VirtAdapterPrinter virtPrnt(&cfg, opts->csv_export, opts->json);
 	Aggregator agg = devno;
 	StagedDeviceFilter dev_filt;
 	NoopCollapser noop_col;
@@ -297,6 +365,12 @@ static int print_reports(struct options *opts, ConfigReader &cfg)
 
 	type_flt.push_back(utilization);
 
+	if (opts->follow) {
+		rc = follow_util_reports(opts, dev_filt, noop_col, *col,
+					 type_flt, physPrnt, virtPrnt);
+		goto out;
+	}
+
 	if (opts->csv_export) {
 		fp = open_csv_output_file(opts->filename,
 					  "_util_phys_adpt.csv", &rc);
@@ -326,7 +400,9 @@ static int print_reports(struct options *opts, ConfigReader &cfg)
 	}
 	else {
 		fp = stdout;
-		fputc('\n', fp);
+		/* JSON output is one object per line, without separators */
+		if (!opts->json)
+			fputc('\n', fp);
 	}
 
 	if (print_report(fp, opts->begin, opts->end, opts->interval,
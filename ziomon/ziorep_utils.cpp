@@ -14,6 +14,9 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
 
 #include "ziorep_utils.hpp"
 #include "ziorep_cfgreader.hpp"
@@ -26,6 +29,9 @@ extern const char *toolname;
 extern int verbose;
 
 
+/// interval at which the data files are checked for new data in follow mode
+#define ZIOREP_FOLLOW_POLL_MS	250
+
 
 /**
  * Read all essential data from the files,
@@ -335,6 +341,30 @@ out:
 }
 
 
+/**
+ * Print all frames that 'framer' has available.
+ * Returns <0 in case of error, 0 if all frames were printed and >0 in case
+ * the end of the data has been reached. */
+static int print_frames(FILE *fp, Framer &framer, Frameset &frameset,
+			__u64 topline, DeviceFilter &dev_filter,
+			Printer &printer, int *frames_printed)
+{
+	int rc;
+
+	while ( (rc = framer.get_next_frameset(frameset, true)) == 0 ) {
+		vverbose_msg("printing frameset %d\n", *frames_printed);
+		if (*frames_printed == 0
+		    || (topline && *frames_printed % topline == 0))
+			printer.print_topline(fp);
+		if (printer.print_frame(fp, frameset, dev_filter) < 0)
+			return -1;
+		++(*frames_printed);
+	}
+
+	return rc;
+}
+
+
 int print_report(FILE *fp, __u64 begin, __u64 end, __u32 interval,
 				char *filename, __u64 topline,
 				list<MsgTypes> *filter_types,
@@ -342,7 +372,6 @@ int print_report(FILE *fp, __u64 begin, __u64 end, __u32 interval,
 				Printer &printer)
 {
 	int frames_printed = 0;
-	bool first_time = true;
 	time_t t;
 	int rc = 0;
 	Frameset frameset(&col);
@@ -368,19 +397,83 @@ int print_report(FILE *fp, __u64 begin, __u64 end, __u32 interval,
 	verbose_msg("    topline  : %llu\n", (long long unsigned int)topline);
 	verbose_msg("    csv mode : %d\n", printer.print_csv());
 
-	while ( (rc = framer.get_next_frameset(frameset, true)) == 0 ) {
-		vverbose_msg("printing frameset %d\n", frames_printed);
-		if (first_time || (topline && frames_printed % topline == 0)) {
-			first_time = false;
-			printer.print_topline(fp);
+	rc = print_frames(fp, framer, frameset, topline, dev_filter, printer,
+			  &frames_printed);
+	if (rc > 0)
+		return frames_printed;
+
+	return rc;
+}
+
+
+static volatile sig_atomic_t follow_stop;
+
+static void follow_stop_handler(int sig __attribute__ ((unused)))
+{
+	follow_stop = 1;
+}
+
+
+int follow_reports(__u64 begin, __u32 interval, char *filename,
+		   __u64 topline, vector<struct follow_report> &reports)
+{
+	struct timespec poll_delay = { 0, ZIOREP_FOLLOW_POLL_MS * 1000000L };
+	vector<Frameset*> framesets;
+	vector<Framer*> framers;
+	vector<int> frames_printed;
+	struct sigaction sa;
+	int total = 0;
+	int rc = 0;
+	unsigned int i;
+
+	verbose_msg("follow reports, begin: %s", print_time_formatted(begin));
+
+	for (i = 0; i < reports.size(); ++i) {
+		framesets.push_back(new Frameset(reports[i].col));
+		framers.push_back(new Framer(begin, begin, interval,
+					     reports[i].filter_types,
+					     reports[i].dev_filter,
+					     filename, &rc));
+		frames_printed.push_back(0);
+		if (rc) {
+			rc = -1;
+			goto out;
 		}
-		if (printer.print_frame(fp, frameset, dev_filter) < 0)
-			return -1;
-		++frames_printed;
 	}
 
-	if (rc > 0)
-		return frames_printed;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = follow_stop_handler;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	while (!follow_stop) {
+		for (i = 0; i < reports.size(); ++i) {
+			if (framers[i]->follow()) {
+				fprintf(stderr, "%s: Could not re-read %s%s\n",
+					toolname, filename, DACC_FILE_EXT_LOG);
+				rc = -1;
+				goto out;
+			}
+			rc = print_frames(reports[i].fp, *framers[i],
+					  *framesets[i], topline,
+					  *reports[i].dev_filter,
+					  *reports[i].printer,
+					  &frames_printed[i]);
+			if (rc < 0)
+				goto out;
+			fflush(reports[i].fp);
+		}
+		nanosleep(&poll_delay, NULL);
+	}
+
+	for (i = 0; i < reports.size(); ++i)
+		total += frames_printed[i];
+	rc = total;
+out:
+	for (i = 0; i < framers.size(); ++i) {
+		delete framers[i];
+		delete framesets[i];
+	}
 
 	return rc;
 }
@@ -526,6 +619,37 @@ int parse_topline_arg(char *str, __u64 *arg)
 	return 0;
 }
 
+int check_output_opts(bool csv_export, bool json, bool follow,
+		      bool print_summary, __u64 end, __u32 interval)
+{
+	if (csv_export && json) {
+		fprintf(stderr, "%s: Cannot use CSV export and JSON output"
+			" at the same time.\n", toolname);
+		return -1;
+	}
+	if (!follow)
+		return 0;
+	if (print_summary) {
+		fprintf(stderr, "%s: Cannot print a summary in follow"
+			" mode.\n", toolname);
+		return -1;
+	}
+	if (end != UINT64_MAX) {
+		fprintf(stderr, "%s: Cannot specify an end of the timeframe"
+			" in follow mode.\n", toolname);
+		return -1;
+	}
+	if (interval == 0) {
+		fprintf(stderr, "%s: Cannot aggregate over all data in"
+			" follow mode, specify an interval greater than"
+			" 0.\n", toolname);
+		return -1;
+	}
+
+	return 0;
+}
+
+
 FILE* open_csv_output_file(const char *filename, const char *extension,
 			   int *rc)
 {
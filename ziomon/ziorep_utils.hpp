@@ -66,6 +66,35 @@ int print_report(FILE *fp, __u64 begin, __u64 end,
 				DeviceFilter &dev_filter, Collapser &col,
 				Printer &printer);
 
+/**
+ * Check that the output related options 'csv_export', 'json' and 'follow'
+ * are consistent with each other and the timeframe specified.
+ * Returns 0 if so, <0 otherwise. */
+int check_output_opts(bool csv_export, bool json, bool follow,
+		      bool print_summary, __u64 end, __u32 interval);
+
+/**
+ * A report to print in follow mode, see follow_reports().
+ */
+struct follow_report {
+	list<MsgTypes>	*filter_types;
+	DeviceFilter	*dev_filter;
+	Collapser	*col;
+	Printer		*printer;
+	/// file to write the report to
+	FILE		*fp;
+};
+
+/**
+ * Print the frames of all 'reports' beginning with 'begin', then keep
+ * watching the data files of a running ziomon session and print each
+ * further frame as soon as it is complete. Frames of the different reports
+ * are printed interleaved. Runs until interrupted by SIGINT or SIGTERM.
+ * Returns <0 in case of error and number of frames printed otherwise.
+ */
+int follow_reports(__u64 begin, __u32 interval, char *filename,
+		   __u64 topline, vector<struct follow_report> &reports);
+
 /**
  * Print summary of available data.
  * 'fp' is the file to write all output to, 'filename' the standard
@@ -417,6 +417,27 @@ error:
 	return NULL;
 }
 
+/**
+ * Frees the prefetched key information and key blobs
+ *
+ * @param ph                the plugin handle
+ */
+static void _free_prefetch(struct plugin_handle *ph)
+{
+	size_t i;
+
+	for (i = 0; i < ph->num_prefetch; i++) {
+		free(ph->prefetch[i].key_id);
+		if (ph->prefetch[i].key_info != NULL)
+			ekmf_free_key_info(ph->prefetch[i].key_info);
+		free(ph->prefetch[i].key_blob);
+	}
+	free(ph->prefetch);
+	ph->prefetch = NULL;
+	ph->num_prefetch = 0;
+	ph->next_prefetch = 0;
+}
+
 /**
  * Terminates the use of a KMS plugin. When a repository is bound to a KMS
  * plugin, zkey calls this function when closing the repository.
@@ -435,11 +456,14 @@ int kms_terminate(const kms_handle_t handle)
 
 	pr_verbose(&ph->pd, "Plugin terminating");
 
+	_free_prefetch(ph);
 	_free_ekmf_config(ph);
 	_unload_cca_library(ph);
 
 	if (ph->curl_handle != NULL)
 		ekmf_curl_destroy(ph->curl_handle);
+	if (ph->multi_handle != NULL)
+		ekmf_multi_destroy(ph->multi_handle);
 
 	plugin_term(&ph->pd);
 	free(ph);
@@ -4344,6 +4368,33 @@ out:
 	return rc;
 }
 
+/**
+ * Finds the prefetched information of a key. The keys are usually processed in
+ * the order they were prefetched, and each key is looked up once for its
+ * properties and once for its key blob, so the search starts at the key found
+ * last.
+ *
+ * @param ph                the plugin handle
+ * @param key_id            the ID of the key
+ *
+ * @returns the prefetched information, or NULL if none is available
+ */
+static struct ekmfweb_prefetch *_find_prefetch(struct plugin_handle *ph,
+					       const char *key_id)
+{
+	size_t i, k;
+
+	for (k = 0; k < ph->num_prefetch; k++) {
+		i = (ph->next_prefetch + k) % ph->num_prefetch;
+		if (strcmp(ph->prefetch[i].key_id, key_id) == 0) {
+			ph->next_prefetch = i;
+			return &ph->prefetch[i];
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * Gets properties of a key.
  *
@@ -4365,6 +4416,7 @@ int kms_get_key_properties(const kms_handle_t handle, const char *key_id,
 			   size_t *num_properties)
 {
 	struct ekmf_key_info *key_info = NULL;
+	struct ekmfweb_prefetch *prefetch;
 	struct plugin_handle *ph = handle;
 	char *error_msg = NULL;
 	int rc;
@@ -4386,6 +4438,15 @@ int kms_get_key_properties(const kms_handle_t handle, const char *key_id,
 		return -EINVAL;
 	}
 
+	prefetch = _find_prefetch(ph, key_id);
+	if (prefetch != NULL && prefetch->key_info != NULL) {
+		pr_verbose(&ph->pd, "Using prefetched key information");
+		rc = _ekmf_tags_to_properties(ph,
+					      &prefetch->key_info->custom_tags,
+					      properties, num_properties);
+		goto out;
+	}
+
 	rc = ekmf_get_key_info(&ph->ekmf_config, &ph->curl_handle,
 			       key_id, &key_info, &error_msg, ph->pd.verbose);
 	if (rc != 0) {
@@ -4899,6 +4960,48 @@ out:
 	return rc;
 }
 
+/**
+ * Gets the parameters for the session keys used to retrieve keys from the
+ * plugin configuration.
+ *
+ * @param ph                the plugin handle
+ * @param curve_nid         On return: the nid of the session key curve, or 0
+ * @param digest_nid        On return: the nid of the RSA signing digest, or 0
+ * @param rsa_pss           On return: true if RSA-PSS signatures are used
+ */
+static void _get_session_key_params(struct plugin_handle *ph, int *curve_nid,
+				    int *digest_nid, bool *rsa_pss)
+{
+	char *tmp;
+
+	*curve_nid = 0;
+	*digest_nid = 0;
+	*rsa_pss = false;
+
+	tmp = properties_get(ph->pd.properties, EKMFWEB_CONFIG_SESSION_KEY_CURVE);
+	if (tmp != NULL) {
+		*curve_nid = OBJ_txt2nid(tmp);
+		free(tmp);
+	}
+
+#ifdef EKMFWEB_SUPPORTS_RSA_DIGESTS_AND_PSS_SIGNATURES
+	tmp = properties_get(ph->pd.properties,
+			     EKMFWEB_CONFIG_SESSION_RSA_SIGN_DIGEST);
+	if (tmp != NULL) {
+		*digest_nid = OBJ_txt2nid(tmp);
+		free(tmp);
+	}
+
+	tmp = properties_get(ph->pd.properties,
+			     EKMFWEB_CONFIG_SESSION_RSA_SIGN_PSS);
+	if (tmp != NULL) {
+		if (strcasecmp(tmp, "yes") == 0)
+			*rsa_pss = true;
+		free(tmp);
+	}
+#endif
+}
+
 /**
  * Imports a key from the KMS and returns a secure key that is
  * enciphered under the current HSM master key.
@@ -4917,13 +5020,13 @@ out:
 int kms_import_key(const kms_handle_t handle, const char *key_id,
 		   unsigned char *key_blob, size_t *key_blob_length)
 {
+	struct ekmfweb_prefetch *prefetch;
 	struct plugin_handle *ph = handle;
 	int curve_nid = 0, digest_nid = 0;
 	char *identity_key_uuid = NULL;
 	char *error_msg = NULL;
 	bool rsa_pss = false;
 	int rc = 0;
-	char *tmp;
 
 	util_assert(handle != NULL, "Internal error: handle is NULL");
 	util_assert(key_blob != NULL, "Internal error: key_blob is NULL");
@@ -4956,28 +5059,16 @@ int kms_import_key(const kms_handle_t handle, const char *key_id,
 	if (rc != 0)
 		goto out;
 
-	tmp = properties_get(ph->pd.properties, EKMFWEB_CONFIG_SESSION_KEY_CURVE);
-	if (tmp != NULL) {
-		curve_nid = OBJ_txt2nid(tmp);
-		free(tmp);
+	prefetch = _find_prefetch(ph, key_id);
+	if (prefetch != NULL && prefetch->key_blob != NULL &&
+	    prefetch->key_blob_length <= *key_blob_length) {
+		pr_verbose(&ph->pd, "Using prefetched key");
+		memcpy(key_blob, prefetch->key_blob, prefetch->key_blob_length);
+		*key_blob_length = prefetch->key_blob_length;
+		goto imported;
 	}
 
-#ifdef EKMFWEB_SUPPORTS_RSA_DIGESTS_AND_PSS_SIGNATURES
-	tmp = properties_get(ph->pd.properties,
-			     EKMFWEB_CONFIG_SESSION_RSA_SIGN_DIGEST);
-	if (tmp != NULL) {
-		digest_nid = OBJ_txt2nid(tmp);
-		free(tmp);
-	}
-
-	tmp = properties_get(ph->pd.properties,
-			     EKMFWEB_CONFIG_SESSION_RSA_SIGN_PSS);
-	if (tmp != NULL) {
-		if (strcasecmp(tmp, "yes") == 0)
-			rsa_pss = true;
-		free(tmp);
-	}
-#endif
+	_get_session_key_params(ph, &curve_nid, &digest_nid, &rsa_pss);
 
 	rc = ekmf_retrieve_key(&ph->ekmf_config, &ph->curl_handle,
 				key_id, curve_nid, digest_nid, rsa_pss,
@@ -4991,6 +5082,8 @@ int kms_import_key(const kms_handle_t handle, const char *key_id,
 		goto out;
 	}
 
+imported:
+
 	rc = _restrict_key(ph, key_blob, *key_blob_length);
 	if (rc != 0)
 		goto out;
@@ -5002,8 +5095,192 @@ out:
 	return rc;
 }
 
+/**
+ * Checks the per-key results of a parallel request for an authorization
+ * error. Such an error applies to all keys, so it is reported like an error
+ * of the request itself.
+ *
+ * @param key_rcs           the per-key return codes
+ * @param num_key_ids       the number of keys
+ *
+ * @returns -EACCES if any of the keys failed with -EACCES, 0 otherwise.
+ */
+static int _prefetch_auth_error(const int *key_rcs, size_t num_key_ids)
+{
+	size_t i;
+
+	for (i = 0; i < num_key_ids; i++) {
+		if (key_rcs[i] == -EACCES)
+			return -EACCES;
+	}
+
+	return 0;
+}
+
+/**
+ * Prefetches the information and the key blobs of keys with parallel requests
+ * to EKMF Web. Keys that fail to be prefetched are retrieved individually
+ * later on.
+ *
+ * @param ph                the plugin handle
+ * @param key_ids           the key-IDs of the keys
+ * @param num_key_ids       the number of key-IDs in above array
+ *
+ * @returns 0 on success, or a negative errno in case of an error.
+ */
+static int _prefetch_keys(struct plugin_handle *ph, const char **key_ids,
+			  size_t num_key_ids)
+{
+	struct ekmf_key_info **key_infos = NULL;
+	size_t *key_blob_lengths = NULL;
+	unsigned char **key_blobs = NULL;
+	int curve_nid = 0, digest_nid = 0;
+	char *identity_key_uuid = NULL;
+	char *error_msg = NULL;
+	bool rsa_pss = false;
+	int *key_rcs = NULL;
+	size_t i;
+	int rc;
+
+	_free_prefetch(ph);
+
+	if (num_key_ids == 0)
+		return 0;
+
+	identity_key_uuid = properties_get(ph->pd.properties,
+					   EKMFWEB_CONFIG_IDENTITY_KEY_ID);
+	if (identity_key_uuid == NULL) {
+		_set_error(ph, "The zkey client is not registered with EKMF "
+			  "Web, run 'zkey kms configure --register CERT-FILE' "
+			  "to register the zkey client.");
+		return -EINVAL;
+	}
+
+	rc = _select_cca_adapter(ph);
+	if (rc != 0)
+		goto out;
+
+	_get_session_key_params(ph, &curve_nid, &digest_nid, &rsa_pss);
+
+	pr_verbose(&ph->pd, "Prefetching %zu keys", num_key_ids);
+
+	ph->prefetch = util_zalloc(num_key_ids *
+				   sizeof(struct ekmfweb_prefetch));
+	ph->num_prefetch = num_key_ids;
+	key_infos = util_zalloc(num_key_ids * sizeof(struct ekmf_key_info *));
+	key_blobs = util_zalloc(num_key_ids * sizeof(unsigned char *));
+	key_blob_lengths = util_zalloc(num_key_ids * sizeof(size_t));
+	key_rcs = util_zalloc(num_key_ids * sizeof(int));
+
+	for (i = 0; i < num_key_ids; i++) {
+		ph->prefetch[i].key_id = util_strdup(key_ids[i]);
+		ph->prefetch[i].key_blob = util_zalloc(MAX_SECURE_KEY_SIZE);
+		key_blobs[i] = ph->prefetch[i].key_blob;
+		key_blob_lengths[i] = MAX_SECURE_KEY_SIZE;
+	}
+
+	rc = ekmf_get_key_infos(&ph->ekmf_config, &ph->multi_handle, 0, true,
+				key_ids, num_key_ids, key_infos, key_rcs,
+				&error_msg, ph->pd.verbose);
+	for (i = 0; i < num_key_ids; i++)
+		ph->prefetch[i].key_info = key_infos[i];
+	if (rc == 0)
+		rc = _prefetch_auth_error(key_rcs, num_key_ids);
+	if (rc != 0) {
+		_set_error(ph, "Failed to get keys: %s", error_msg != NULL ?
+			   error_msg : strerror(-rc));
+		_remove_login_token_if_error(ph, rc);
+		goto out;
+	}
+
+	if (error_msg != NULL) {
+		pr_verbose(&ph->pd, "Some keys were not prefetched: %s",
+			   error_msg);
+		free(error_msg);
+		error_msg = NULL;
+	}
+
+	rc = ekmf_retrieve_keys(&ph->ekmf_config, &ph->multi_handle, 0, true,
+				key_ids, num_key_ids, curve_nid, digest_nid,
+				rsa_pss, identity_key_uuid, key_blobs,
+				key_blob_lengths, key_rcs, &error_msg,
+				&ph->ext_lib, ph->pd.verbose);
+	if (rc == 0)
+		rc = _prefetch_auth_error(key_rcs, num_key_ids);
+	if (rc != 0) {
+		_set_error(ph, "Failed to retrieve keys from EKMF Web: %s",
+			   error_msg != NULL ? error_msg : strerror(-rc));
+		_remove_login_token_if_error(ph, rc);
+		goto out;
+	}
+
+	for (i = 0; i < num_key_ids; i++) {
+		if (key_rcs[i] != 0) {
+			free(ph->prefetch[i].key_blob);
+			ph->prefetch[i].key_blob = NULL;
+			continue;
+		}
+		ph->prefetch[i].key_blob_length = key_blob_lengths[i];
+	}
+
+	if (error_msg != NULL)
+		pr_verbose(&ph->pd, "Some keys were not prefetched: %s",
+			   error_msg);
+
+out:
+	if (rc != 0)
+		_free_prefetch(ph);
+
+	free(key_infos);
+	free(key_blobs);
+	free(key_blob_lengths);
+	free(key_rcs);
+	free(identity_key_uuid);
+	if (error_msg != NULL)
+		free(error_msg);
+
+	return rc;
+}
+
+/**
+ * Prefetches the information of keys that are about to be refreshed or
+ * imported, so that the following calls for these keys are served from the
+ * prefetched information. The requests for the keys are sent to EKMF Web in
+ * parallel.
+ *
+ * @param handle            the KMS plugin handle obtained from kms_initialize()
+ * @param key_ids           the key-IDs of the keys
+ * @param num_key_ids       the number of key-IDs in above array
+ *
+ * @returns 0 on success, or a negative errno in case of an error.
+ * Function kms_get_last_error() can be used to obtain more details about the
+ * error.
+ */
+int kms_prefetch_keys(const kms_handle_t handle, const char **key_ids,
+		      size_t num_key_ids)
+{
+	struct plugin_handle *ph = handle;
+
+	util_assert(handle != NULL, "Internal error: handle is NULL");
+	util_assert(num_key_ids == 0 || key_ids != NULL,
+		    "Internal error: key_ids is NULL but num_key_ids > 0");
+
+	pr_verbose(&ph->pd, "Prefetch Keys, number of keys: %lu", num_key_ids);
+
+	plugin_clear_error(&ph->pd);
+
+	if (!ph->config_complete) {
+		_set_error(ph, "The configuration is incomplete, run 'zkey "
+			  "kms configure [OPTIONS]' to complete the "
+			  "configuration.");
+		return -EINVAL;
+	}
+
+	return _prefetch_keys(ph, key_ids, num_key_ids);
+}
+
 static const struct kms_functions kms_functions = {
-	.api_version = KMS_API_VERSION_1,
+	.api_version = KMS_API_VERSION_3,
 	.kms_bind = kms_bind,
 	.kms_initialize = kms_initialize,
 	.kms_terminate = kms_terminate,
@@ -5021,6 +5298,7 @@ static const struct kms_functions kms_functions = {
 	.kms_remove_key = kms_remove_key,
 	.kms_list_keys = kms_list_keys,
 	.kms_import_key = kms_import_key,
+	.kms_prefetch_keys = kms_prefetch_keys,
 };
 
 /**
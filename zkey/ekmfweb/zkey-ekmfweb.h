@@ -17,6 +17,16 @@
 
 #include "../plugin-utils.h"
 
+/*
+ * Key information and key blob prefetched for a key with parallel requests
+ */
+struct ekmfweb_prefetch {
+	char *key_id;
+	struct ekmf_key_info *key_info; /* NULL if not prefetched */
+	unsigned char *key_blob; /* NULL if not prefetched */
+	size_t key_blob_length;
+};
+
 struct plugin_handle {
 	struct plugin_data pd;
 	bool apqns_configured;
@@ -30,6 +40,10 @@ struct plugin_handle {
 	struct ekmf_cca_lib cca;
 	struct ekmf_config ekmf_config;
 	CURL *curl_handle;
+	struct ekmf_multi_handle *multi_handle;
+	struct ekmfweb_prefetch *prefetch;
+	size_t num_prefetch;
+	size_t next_prefetch;
 };
 
 #define EKMFWEB_CONFIG_FILE			"ekmfweb.conf"
@@ -14,6 +14,7 @@
 #include <err.h>
 #include <errno.h>
 #include <fnmatch.h>
+#include <limits.h>
 #include <regex.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,6 +24,7 @@
 #include <sys/file.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 
 #include "lib/util_base.h"
 #include "lib/util_file.h"
@@ -53,6 +55,9 @@ struct key_filenames {
 #define DUMMY_PASSPHRASE_LEN	16
 
 #define LOCK_FILE_NAME		".lock"
+#define INDEX_FILE_NAME		".index"
+#define INDEX_HEADER		"zkey-index "
+#define INDEX_VERSION		1
 
 #define VOLUME_TYPE_PLAIN	"plain"
 #define VOLUME_TYPE_LUKS2	"luks2"
@@ -964,6 +969,451 @@ static int _keystore_info_file_filter(const struct dirent *dirent)
 	return 0;
 }
 
+/*
+ * Properties that are kept in the metadata index. These are the properties
+ * used by the key filters of _keystore_process_filtered().
+ */
+static const char * const index_props[] = {
+	PROP_NAME_VOLUMES,
+	PROP_NAME_APQNS,
+	PROP_NAME_VOLUME_TYPE,
+	PROP_NAME_KEY_TYPE,
+	PROP_NAME_KMS,
+};
+
+#define NUM_INDEX_PROPS		ARRAY_SIZE(index_props)
+
+/*
+ * Index entry of a key. The entry is valid as long as the info file of the
+ * key has the same inode, size, and modification and change time.
+ */
+struct index_entry {
+	char *name;
+	ino_t ino;
+	off_t size;
+	struct timespec mtime;
+	struct timespec ctime;
+	char *values[NUM_INDEX_PROPS];
+	bool seen;
+	bool removed;
+};
+
+struct keystore_index {
+	struct index_entry **entries;
+	size_t num;
+	size_t size;
+	size_t num_sorted; /* entries[0..num_sorted-1] are sorted by name */
+	bool dirty;
+};
+
+static void _keystore_index_free_entry(struct index_entry *entry)
+{
+	unsigned int i;
+
+	for (i = 0; i < NUM_INDEX_PROPS; i++)
+		free(entry->values[i]);
+	free(entry->name);
+	free(entry);
+}
+
+static void _keystore_index_free(struct keystore_index *index)
+{
+	size_t i;
+
+	if (index == NULL)
+		return;
+	for (i = 0; i < index->num; i++)
+		_keystore_index_free_entry(index->entries[i]);
+	free(index->entries);
+	free(index);
+}
+
+static int _keystore_index_cmp(const void *a, const void *b)
+{
+	const struct index_entry *e1 = *(const struct index_entry **)a;
+	const struct index_entry *e2 = *(const struct index_entry **)b;
+
+	return strcmp(e1->name, e2->name);
+}
+
+static void _keystore_index_sort(struct keystore_index *index)
+{
+	if (index->num_sorted == index->num)
+		return;
+	qsort(index->entries, index->num, sizeof(index->entries[0]),
+	      _keystore_index_cmp);
+	index->num_sorted = index->num;
+}
+
+/**
+ * Adds a new entry to the index. The entry is found by
+ * _keystore_index_find() after the next _keystore_index_sort().
+ *
+ * @param[in] index      the index
+ * @param[in] name       the name of the key
+ *
+ * @returns the new entry
+ */
+static struct index_entry *_keystore_index_add(struct keystore_index *index,
+					       const char *name)
+{
+	struct index_entry *entry;
+
+	if (index->num == index->size) {
+		index->size = index->size ? index->size * 2 : 64;
+		index->entries = util_realloc(index->entries,
+					      index->size *
+					      sizeof(index->entries[0]));
+	}
+	entry = util_zalloc(sizeof(*entry));
+	entry->name = util_strdup(name);
+	index->entries[index->num++] = entry;
+	index->dirty = true;
+	return entry;
+}
+
+static struct index_entry *_keystore_index_find(struct keystore_index *index,
+						const char *name)
+{
+	struct index_entry key = { .name = (char *)name };
+	struct index_entry *pkey = &key, **entry;
+
+	entry = bsearch(&pkey, index->entries, index->num_sorted,
+			sizeof(index->entries[0]), _keystore_index_cmp);
+	return entry != NULL ? *entry : NULL;
+}
+
+static bool _keystore_index_fresh(struct index_entry *entry, struct stat *sb)
+{
+	return !entry->removed && entry->ino == sb->st_ino &&
+		entry->size == sb->st_size &&
+		entry->mtime.tv_sec == sb->st_mtim.tv_sec &&
+		entry->mtime.tv_nsec == sb->st_mtim.tv_nsec &&
+		entry->ctime.tv_sec == sb->st_ctim.tv_sec &&
+		entry->ctime.tv_nsec == sb->st_ctim.tv_nsec;
+}
+
+/**
+ * Sets an index entry from the properties of the key
+ *
+ * @param[in] index      the index
+ * @param[in] entry      the index entry
+ * @param[in] sb         the status of the info file of the key
+ * @param[in] properties the properties of the key
+ */
+static void _keystore_index_set(struct keystore_index *index,
+				struct index_entry *entry, struct stat *sb,
+				struct properties *properties)
+{
+	unsigned int i;
+
+	entry->ino = sb->st_ino;
+	entry->size = sb->st_size;
+	entry->mtime = sb->st_mtim;
+	entry->ctime = sb->st_ctim;
+	for (i = 0; i < NUM_INDEX_PROPS; i++) {
+		free(entry->values[i]);
+		entry->values[i] = properties_get(properties, index_props[i]);
+	}
+	entry->removed = false;
+	index->dirty = true;
+}
+
+/**
+ * Returns a properties object that contains the indexed properties of a key
+ *
+ * @param[in] entry      the index entry
+ *
+ * @returns the properties object. Must be freed by the caller.
+ */
+static struct properties *_keystore_index_props(struct index_entry *entry)
+{
+	struct properties *properties;
+	unsigned int i;
+
+	properties = properties_new();
+	for (i = 0; i < NUM_INDEX_PROPS; i++) {
+		if (entry->values[i] != NULL)
+			properties_set(properties, index_props[i],
+				       entry->values[i]);
+	}
+	return properties;
+}
+
+/**
+ * Marks the index entry of a key as removed, e.g. when the key is removed
+ * or renamed
+ *
+ * @param[in] keystore   the keystore
+ * @param[in] name       the name of the key
+ */
+static void _keystore_index_remove(struct keystore *keystore,
+				   const char *name)
+{
+	struct index_entry *entry;
+
+	if (keystore->index == NULL)
+		return;
+	entry = _keystore_index_find(keystore->index, name);
+	if (entry == NULL || entry->removed)
+		return;
+	entry->removed = true;
+	keystore->index->dirty = true;
+}
+
+/**
+ * Parses a line of the index file:
+ * <name> <ino> <size> <mtime> <mtime-ns> <ctime> <ctime-ns> <props...>
+ * All fields are separated by tabs. Each property is either '-' if the
+ * property is not set, or '=' followed by the value.
+ *
+ * @param[in] index      the index
+ * @param[in] line       the line without the newline character
+ *
+ * @returns 0 on success, -EINVAL if the line is malformed
+ */
+static int _keystore_index_parse(struct keystore_index *index, char *line)
+{
+	unsigned long long ino, size, mtime, mtime_ns, ctime, ctime_ns;
+	struct index_entry *entry;
+	char *fields[7 + NUM_INDEX_PROPS];
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(fields); i++) {
+		fields[i] = strsep(&line, "\t");
+		if (fields[i] == NULL)
+			return -EINVAL;
+	}
+	if (line != NULL || *fields[0] == '\0' ||
+	    sscanf(fields[1], "%llu", &ino) != 1 ||
+	    sscanf(fields[2], "%llu", &size) != 1 ||
+	    sscanf(fields[3], "%llu", &mtime) != 1 ||
+	    sscanf(fields[4], "%llu", &mtime_ns) != 1 ||
+	    sscanf(fields[5], "%llu", &ctime) != 1 ||
+	    sscanf(fields[6], "%llu", &ctime_ns) != 1)
+		return -EINVAL;
+
+	entry = _keystore_index_add(index, fields[0]);
+	entry->ino = ino;
+	entry->size = size;
+	entry->mtime.tv_sec = mtime;
+	entry->mtime.tv_nsec = mtime_ns;
+	entry->ctime.tv_sec = ctime;
+	entry->ctime.tv_nsec = ctime_ns;
+	for (i = 0; i < NUM_INDEX_PROPS; i++) {
+		if (fields[7 + i][0] == '=')
+			entry->values[i] = util_strdup(&fields[7 + i][1]);
+		else if (fields[7 + i][0] != '-')
+			return -EINVAL;
+	}
+	return 0;
+}
+
+/**
+ * Loads the metadata index of the repository. If the index does not exist
+ * or can not be used, an empty index is returned, so that all keys are
+ * read from their info files and the index is rebuilt.
+ *
+ * @param[in] keystore   the keystore
+ *
+ * @returns the index
+ */
+static struct keystore_index *_keystore_index_load(struct keystore *keystore)
+{
+	struct keystore_index *index;
+	char *filename, *line = NULL;
+	size_t line_size = 0;
+	ssize_t len;
+	int version;
+	FILE *fp;
+
+	index = util_zalloc(sizeof(*index));
+
+	util_asprintf(&filename, "%s/%s", keystore->directory,
+		      INDEX_FILE_NAME);
+	fp = fopen(filename, "r");
+	free(filename);
+	if (fp == NULL)
+		goto out_rebuild;
+
+	if (getline(&line, &line_size, fp) == -1 ||
+	    sscanf(line, INDEX_HEADER "%d", &version) != 1 ||
+	    version != INDEX_VERSION)
+		goto out_invalid;
+
+	while ((len = getline(&line, &line_size, fp)) != -1) {
+		if (len == 0 || line[len - 1] != '\n')
+			goto out_invalid;
+		line[len - 1] = '\0';
+		if (_keystore_index_parse(index, line) != 0)
+			goto out_invalid;
+	}
+	free(line);
+	fclose(fp);
+
+	_keystore_index_sort(index);
+	index->dirty = false;
+	pr_verbose(keystore, "Index with %zu keys loaded", index->num);
+	return index;
+
+out_invalid:
+	pr_verbose(keystore, "Index is invalid, it is rebuilt");
+	free(line);
+	fclose(fp);
+	_keystore_index_free(index);
+	index = util_zalloc(sizeof(*index));
+out_rebuild:
+	/* Write the index even if no key is processed */
+	index->dirty = true;
+	return index;
+}
+
+/**
+ * Saves the metadata index of the repository, if it has changed. The index
+ * is replaced atomically. Errors are not fatal, the index is rebuilt when
+ * it is used the next time.
+ *
+ * @param[in] keystore   the keystore
+ */
+static void _keystore_index_save(struct keystore *keystore)
+{
+	struct keystore_index *index = keystore->index;
+	char *filename, *tempname;
+	struct index_entry *entry;
+	unsigned int i;
+	size_t k;
+	FILE *fp;
+	int fd;
+
+	if (index == NULL || !index->dirty)
+		return;
+
+	_keystore_index_sort(index);
+
+	util_asprintf(&filename, "%s/%s", keystore->directory,
+		      INDEX_FILE_NAME);
+	util_asprintf(&tempname, "%s.XXXXXX", filename);
+	fd = mkstemp(tempname);
+	if (fd == -1)
+		goto out;
+	fp = fdopen(fd, "w");
+	if (fp == NULL) {
+		close(fd);
+		goto out_remove;
+	}
+
+	fprintf(fp, INDEX_HEADER "%d\n", INDEX_VERSION);
+	for (k = 0; k < index->num; k++) {
+		entry = index->entries[k];
+		if (entry->removed || strchr(entry->name, '\t') != NULL)
+			continue;
+		for (i = 0; i < NUM_INDEX_PROPS; i++) {
+			if (entry->values[i] != NULL &&
+			    strchr(entry->values[i], '\t') != NULL)
+				break;
+		}
+		/* Keys with tabs in indexed values are always read */
+		if (i < NUM_INDEX_PROPS)
+			continue;
+
+		fprintf(fp, "%s\t%llu\t%llu\t%llu\t%lu\t%llu\t%lu", entry->name,
+			(unsigned long long)entry->ino,
+			(unsigned long long)entry->size,
+			(unsigned long long)entry->mtime.tv_sec,
+			entry->mtime.tv_nsec,
+			(unsigned long long)entry->ctime.tv_sec,
+			entry->ctime.tv_nsec);
+		for (i = 0; i < NUM_INDEX_PROPS; i++) {
+			if (entry->values[i] != NULL)
+				fprintf(fp, "\t=%s", entry->values[i]);
+			else
+				fprintf(fp, "\t-");
+		}
+		fprintf(fp, "\n");
+	}
+	if (fclose(fp) != 0)
+		goto out_remove;
+
+	if (_keystore_set_file_permission(keystore, tempname) != 0)
+		goto out_remove;
+	if (rename(tempname, filename) != 0)
+		goto out_remove;
+
+	index->dirty = false;
+	pr_verbose(keystore, "Index with %zu keys saved", index->num);
+	goto out;
+
+out_remove:
+	pr_verbose(keystore, "Failed to save the index '%s'", filename);
+	remove(tempname);
+out:
+	free(tempname);
+	free(filename);
+}
+
+/**
+ * Checks if the key properties match the filters of
+ * _keystore_process_filtered().
+ *
+ * @returns 1 if the key matches, 0 if it is filtered out
+ */
+static int _keystore_match_key_filters(struct keystore *keystore,
+				       const char *name,
+				       struct properties *key_props,
+				       char **vol_filter_list,
+				       char **apqn_filter_list,
+				       const char *volume_type,
+				       const char *key_type,
+				       bool local, bool kms_bound)
+{
+	if (_keystore_match_filter_property(key_props, PROP_NAME_VOLUMES,
+					    vol_filter_list, NULL) == 0) {
+		pr_verbose(keystore,
+			   "Key '%s' filtered out due to volumes filter",
+			   name);
+		return 0;
+	}
+
+	if (_keystore_match_filter_property(key_props, PROP_NAME_APQNS,
+					    apqn_filter_list,
+					    _keystore_apqn_match) == 0) {
+		pr_verbose(keystore,
+			   "Key '%s' filtered out due to APQN filter",
+			   name);
+		return 0;
+	}
+
+	if (_keystore_match_volume_type_property(key_props,
+						 volume_type) == 0) {
+		pr_verbose(keystore,
+			   "Key '%s' filtered out due to volume type",
+			   name);
+		return 0;
+	}
+
+	if (_keystore_match_key_type_property(key_props, key_type) == 0) {
+		pr_verbose(keystore,
+			   "Key '%s' filtered out due to key type",
+			   name);
+		return 0;
+	}
+
+	if (local && _keystore_is_kms_bound_key(key_props, NULL)) {
+		pr_verbose(keystore,
+			   "Key '%s' filtered out because it is KMS "
+			   "bound", name);
+		return 0;
+	}
+	if (kms_bound && !_keystore_is_kms_bound_key(key_props, NULL)) {
+		pr_verbose(keystore,
+			   "Key '%s' filtered out because it is not "
+			   "KMS bound", name);
+		return 0;
+	}
+
+	return 1;
+}
+
 typedef int (*process_key_t)(struct keystore *keystore,
 			     const char *name, struct properties *properties,
 			     struct key_filenames *file_names, void *private);
@@ -1008,14 +1458,19 @@ static int _keystore_process_filtered(struct keystore *keystore,
 				      process_key_t process_func,
 				      void *process_private)
 {
+	struct keystore_index *index = keystore->index;
 	struct key_filenames file_names = { 0 };
 	char **apqn_filter_list = NULL;
 	char **vol_filter_list = NULL;
 	struct properties *key_props;
+	struct index_entry *entry;
 	struct dirent **namelist;
 	int n, i, rc = 0;
 	bool skip = 0;
+	struct stat sb;
+	bool indexed;
 	char *name;
+	size_t k;
 	int len;
 
 	pr_verbose(keystore, "Process_filtered: name_filter = '%s', "
@@ -1037,6 +1492,9 @@ static int _keystore_process_filtered(struct keystore *keystore,
 		return rc;
 	}
 
+	for (k = 0; k < index->num; k++)
+		index->entries[k]->seen = false;
+
 	for (i = 0; i < n ; i++) {
 		if (skip)
 			goto free;
@@ -1061,6 +1519,29 @@ static int _keystore_process_filtered(struct keystore *keystore,
 		if (rc != 0)
 			goto free_names;
 
+		/*
+		 * Apply the filters to the indexed properties first, so that
+		 * the info file is only read for keys that match.
+		 */
+		entry = _keystore_index_find(index, name);
+		if (entry != NULL)
+			entry->seen = true;
+		indexed = stat(file_names.info_filename, &sb) == 0;
+		if (indexed && entry != NULL &&
+		    _keystore_index_fresh(entry, &sb)) {
+			key_props = _keystore_index_props(entry);
+			rc = _keystore_match_key_filters(keystore, name,
+							 key_props,
+							 vol_filter_list,
+							 apqn_filter_list,
+							 volume_type, key_type,
+							 local, kms_bound);
+			properties_free(key_props);
+			if (rc == 0)
+				goto free_names;
+			indexed = false;
+		}
+
 		key_props = properties_new();
 		rc = properties_load(key_props, file_names.info_filename, 1);
 		if (rc != 0) {
@@ -1068,59 +1549,21 @@ static int _keystore_process_filtered(struct keystore *keystore,
 			goto free_prop;
 		}
 
-		rc = _keystore_match_filter_property(key_props,
-						     PROP_NAME_VOLUMES,
-						     vol_filter_list, NULL);
-		if (rc == 0) {
-			pr_verbose(keystore,
-				   "Key '%s' filtered out due to volumes filter",
-				   name);
-			goto free_prop;
-		}
-
-		rc = _keystore_match_filter_property(key_props,
-						     PROP_NAME_APQNS,
-						     apqn_filter_list,
-						     _keystore_apqn_match);
-		if (rc == 0) {
-			pr_verbose(keystore,
-				   "Key '%s' filtered out due to APQN filter",
-				   name);
-			goto free_prop;
-		}
-
-		rc = _keystore_match_volume_type_property(key_props,
-							  volume_type);
-		if (rc == 0) {
-			pr_verbose(keystore,
-				   "Key '%s' filtered out due to volume type",
-				   name);
-			goto free_prop;
-		}
-
-		rc = _keystore_match_key_type_property(key_props,
-						       key_type);
-		if (rc == 0) {
-			pr_verbose(keystore,
-				   "Key '%s' filtered out due to key type",
-				   name);
-			goto free_prop;
+		if (indexed) {
+			if (entry == NULL) {
+				entry = _keystore_index_add(index, name);
+				entry->seen = true;
+			}
+			_keystore_index_set(index, entry, &sb, key_props);
 		}
 
-		if (local && _keystore_is_kms_bound_key(key_props, NULL)) {
-			pr_verbose(keystore,
-				   "Key '%s' filtered out because it is KMS "
-				   "bound", name);
-			rc = 0;
-			goto free_prop;
-		}
-		if (kms_bound && !_keystore_is_kms_bound_key(key_props, NULL)) {
-			pr_verbose(keystore,
-				   "Key '%s' filtered out because it is not "
-				   "KMS bound", name);
-			rc = 0;
+		rc = _keystore_match_key_filters(keystore, name, key_props,
+						 vol_filter_list,
+						 apqn_filter_list,
+						 volume_type, key_type,
+						 local, kms_bound);
+		if (rc == 0)
 			goto free_prop;
-		}
 
 		rc = process_func(keystore, name, key_props, &file_names,
 				  process_private);
@@ -1139,6 +1582,18 @@ free:
 	}
 	free(namelist);
 
+	/* Drop the entries of keys that no longer exist */
+	if (name_filter == NULL && !skip) {
+		for (k = 0; k < index->num; k++) {
+			if (!index->entries[k]->seen &&
+			    !index->entries[k]->removed) {
+				index->entries[k]->removed = true;
+				index->dirty = true;
+			}
+		}
+	}
+	_keystore_index_sort(index);
+
 	if (vol_filter_list)
 		str_list_free_string_array(vol_filter_list);
 	if (apqn_filter_list)
@@ -1483,6 +1938,8 @@ struct keystore *keystore_new(const char *directory,
 		return NULL;
 	}
 
+	keystore->index = _keystore_index_load(keystore);
+
 	pr_verbose(keystore, "Keystore in directory '%s' opened successfully",
 		   keystore->directory);
 	return keystore;
@@ -2812,6 +3269,8 @@ int keystore_rename_key(struct keystore *keystore, const char *name,
 		free(msg);
 	}
 
+	_keystore_index_remove(keystore, name);
+
 	pr_verbose(keystore, "Successfully renamed key '%s' to '%s'", name,
 		   newname);
 
@@ -3333,6 +3792,33 @@ struct reencipher_info {
 	unsigned long num_reenciphered;
 	unsigned long num_failed;
 	unsigned long num_skipped;
+	unsigned int jobs;
+	unsigned int jobs_per_apqn;
+	unsigned int num_running;
+	struct util_list job_list;
+	const char *apqn; /* APQN to try first, or NULL */
+};
+
+/*
+ * Exit status of a re-enciphering worker process
+ */
+enum reencipher_result {
+	REENCIPHER_DONE = 0,
+	REENCIPHER_SKIPPED = 1,
+	REENCIPHER_FAILED = 2,
+};
+
+/*
+ * A key that is re-enciphered by a worker process. The output of the
+ * worker is captured and printed in the order of the keys.
+ */
+struct reencipher_job {
+	struct util_list_node node;
+	pid_t pid; /* 0 if the worker has finished */
+	char *apqn; /* APQN the key is distributed to, or NULL */
+	FILE *out;
+	FILE *err;
+	enum reencipher_result result;
 };
 
 /**
@@ -3526,6 +4012,16 @@ static int _keystore_process_reencipher(struct keystore *keystore,
 	if (!params.complete) {
 		printf("Re-enciphering key '%s'\n", name);
 
+		/*
+		 * The APQNs are tried in the specified order, so put the
+		 * APQN this key is distributed to first.
+		 */
+		if (info->apqn != NULL && apqns != NULL) {
+			util_asprintf(&temp, "%s,%s", info->apqn, apqns);
+			free(apqns);
+			apqns = temp;
+		}
+
 		rc = _keystore_perform_reencipher(keystore, name, info->lib,
 						  &params, secure_key,
 						  secure_key_size, is_old_mk,
@@ -3623,6 +4119,264 @@ out:
 	return rc;
 }
 
+/**
+ * Prints the captured output of a worker process and closes the file
+ *
+ * @param[in] file       the file containing the output
+ * @param[in] stream     the stream to print to
+ */
+static void _keystore_reencipher_print(FILE *file, FILE *stream)
+{
+	char buffer[4096];
+	size_t len;
+
+	rewind(file);
+	while ((len = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		fwrite(buffer, 1, len, stream);
+	fflush(stream);
+	fclose(file);
+}
+
+/**
+ * Prints the output and counts the results of the finished jobs in the
+ * order the keys were started. Stops at the first job that is still
+ * running.
+ *
+ * @param[in] info       the re-encipher info
+ */
+static void _keystore_reencipher_flush(struct reencipher_info *info)
+{
+	struct reencipher_job *job;
+
+	while ((job = util_list_start(&info->job_list)) != NULL &&
+	       job->pid == 0) {
+		_keystore_reencipher_print(job->out, stdout);
+		_keystore_reencipher_print(job->err, stderr);
+
+		switch (job->result) {
+		case REENCIPHER_DONE:
+			info->num_reenciphered++;
+			break;
+		case REENCIPHER_SKIPPED:
+			info->num_skipped++;
+			break;
+		default:
+			info->num_failed++;
+			break;
+		}
+
+		util_list_remove(&info->job_list, job);
+		free(job->apqn);
+		free(job);
+	}
+}
+
+/**
+ * Waits until one of the worker processes has finished. Only worker
+ * processes are reaped, other child processes are left untouched.
+ *
+ * @param[in] keystore   the keystore
+ * @param[in] info       the re-encipher info
+ *
+ * @returns 0 for success or a negative errno in case of an error. In case
+ *          of an error, all running jobs are marked as failed.
+ */
+static int _keystore_reencipher_wait(struct keystore *keystore,
+				     struct reencipher_info *info)
+{
+	struct reencipher_job *job, *found = NULL;
+	siginfo_t siginfo;
+	int status, rc;
+	pid_t pid;
+
+	/* Find out which child finished without reaping it */
+	memset(&siginfo, 0, sizeof(siginfo));
+	do {
+		rc = waitid(P_ALL, 0, &siginfo, WEXITED | WNOWAIT);
+	} while (rc == -1 && errno == EINTR);
+	if (rc == -1)
+		goto fail;
+
+	util_list_iterate(&info->job_list, job) {
+		if (job->pid != 0 && job->pid == siginfo.si_pid) {
+			found = job;
+			break;
+		}
+	}
+	/* Not a worker: wait for the oldest running worker instead */
+	if (found == NULL) {
+		util_list_iterate(&info->job_list, job) {
+			if (job->pid != 0) {
+				found = job;
+				break;
+			}
+		}
+	}
+	if (found == NULL) {
+		errno = ECHILD;
+		goto fail;
+	}
+
+	do {
+		pid = waitpid(found->pid, &status, 0);
+	} while (pid == -1 && errno == EINTR);
+	if (pid == -1)
+		goto fail;
+
+	found->pid = 0;
+	if (WIFEXITED(status))
+		found->result = WEXITSTATUS(status);
+	else
+		found->result = REENCIPHER_FAILED;
+	pr_verbose(keystore, "Worker %d finished with %d", pid, found->result);
+	info->num_running--;
+	_keystore_reencipher_flush(info);
+	return 0;
+
+fail:
+	rc = -errno;
+	warnx("Failed to wait for re-enciphering workers: %s", strerror(-rc));
+	util_list_iterate(&info->job_list, job) {
+		if (job->pid == 0)
+			continue;
+		job->pid = 0;
+		job->result = REENCIPHER_FAILED;
+	}
+	info->num_running = 0;
+	_keystore_reencipher_flush(info);
+	return rc;
+}
+
+/**
+ * Selects the APQN of a key with the fewest running jobs.
+ *
+ * @param[in] info       the re-encipher info
+ * @param[in] apqn_list  the APQNs associated with the key (or NULL if none)
+ * @param[out] apqn      the selected APQN or NULL if the key has no APQNs
+ *
+ * @returns true if the key can be started now, false if the job limit
+ *          or the limit of all its APQNs is reached
+ */
+static bool _keystore_reencipher_select(struct reencipher_info *info,
+					char **apqn_list, char **apqn)
+{
+	unsigned int count, min = UINT_MAX;
+	struct reencipher_job *job;
+	int i;
+
+	*apqn = NULL;
+	if (info->num_running >= info->jobs)
+		return false;
+	if (apqn_list == NULL || apqn_list[0] == NULL)
+		return true;
+
+	for (i = 0; apqn_list[i] != NULL; i++) {
+		count = 0;
+		util_list_iterate(&info->job_list, job) {
+			if (job->pid != 0 && job->apqn != NULL &&
+			    strcmp(job->apqn, apqn_list[i]) == 0)
+				count++;
+		}
+		if (count < min) {
+			min = count;
+			*apqn = apqn_list[i];
+		}
+	}
+	return min < info->jobs_per_apqn;
+}
+
+/**
+ * Processing function for re-enciphering keys in parallel: Starts a worker
+ * process for the key as soon as the job limits allow it. The worker
+ * re-enciphers the key with _keystore_process_reencipher().
+ *
+ * @param[in] keystore   the keystore
+ * @param[in] name       the name of the key
+ * @param[in] properties the properties object of the key
+ * @param[in] file_names the file names used by this key
+ * @param[in] private    private data: struct reencipher_info
+ *
+ * @returns 0 if the worker is started, a negative errno value otherwise
+ */
+static int _keystore_process_reenc_parallel(struct keystore *keystore,
+					    const char *name,
+					    struct properties *properties,
+					    struct key_filenames *file_names,
+					    void *private)
+{
+	struct reencipher_info *info = (struct reencipher_info *)private;
+	struct reencipher_job *job;
+	char **apqn_list = NULL;
+	char *apqns, *apqn;
+	int rc = 0;
+
+	apqns = properties_get(properties, PROP_NAME_APQNS);
+	if (apqns != NULL)
+		apqn_list = str_list_split(apqns);
+
+	while (!_keystore_reencipher_select(info, apqn_list, &apqn)) {
+		rc = _keystore_reencipher_wait(keystore, info);
+		if (rc != 0)
+			goto out;
+	}
+
+	job = util_zalloc(sizeof(*job));
+	job->apqn = apqn != NULL ? util_strdup(apqn) : NULL;
+	job->out = tmpfile();
+	job->err = tmpfile();
+	if (job->out == NULL || job->err == NULL) {
+		rc = -errno;
+		goto out_free;
+	}
+
+	/* Do not let the worker inherit buffered output */
+	fflush(stdout);
+	fflush(stderr);
+
+	job->pid = fork();
+	if (job->pid == -1) {
+		rc = -errno;
+		goto out_free;
+	}
+	if (job->pid == 0) {
+		dup2(fileno(job->out), STDOUT_FILENO);
+		dup2(fileno(job->err), STDERR_FILENO);
+
+		info->num_reenciphered = 0;
+		info->num_skipped = 0;
+		info->num_failed = 0;
+		info->apqn = job->apqn;
+		_keystore_process_reencipher(keystore, name, properties,
+					     file_names, info);
+		fflush(stdout);
+		fflush(stderr);
+		_exit(info->num_failed > 0 ? REENCIPHER_FAILED :
+		      info->num_skipped > 0 ? REENCIPHER_SKIPPED :
+					      REENCIPHER_DONE);
+	}
+
+	pr_verbose(keystore, "Worker %d re-enciphers key '%s' on APQN %s",
+		   job->pid, name, job->apqn != NULL ? job->apqn : "ANY");
+	util_list_add_tail(&info->job_list, job);
+	info->num_running++;
+	goto out;
+
+out_free:
+	warnx("Failed to start re-enciphering of key '%s': %s", name,
+	      strerror(-rc));
+	if (job->out != NULL)
+		fclose(job->out);
+	if (job->err != NULL)
+		fclose(job->err);
+	free(job->apqn);
+	free(job);
+out:
+	if (apqn_list != NULL)
+		str_list_free_string_array(apqn_list);
+	free(apqns);
+	return rc;
+}
+
 /**
  * Reenciphers a key in the keystore
  *
@@ -3638,6 +4392,10 @@ out:
  * @param[in] complete     if true, a pending re-encipherment is completed
  * @param[in] pkey_fd      the file descriptor of /dev/pkey
  * @param[in] lib          the external library struct
+ * @param[in] jobs         the number of keys that are re-enciphered in
+ *                         parallel, 1 re-enciphers the keys one by one
+ * @param[in] jobs_per_apqn the number of keys that are re-enciphered in
+ *                         parallel on the same APQN
  * Note: if both fromOld and toNew are FALSE, then the reencipherement mode is
  *       detected automatically. If both are TRUE then the key is reenciphered
  *       from the OLD to the NEW master key.
@@ -3650,10 +4408,12 @@ int keystore_reencipher_key(struct keystore *keystore, const char *name_filter,
 			    const char *apqn_filter,
 			    bool from_old, bool to_new, bool inplace,
 			    bool staged, bool complete, int pkey_fd,
-			    struct ext_lib *lib)
+			    struct ext_lib *lib, unsigned int jobs,
+			    unsigned int jobs_per_apqn)
 {
-	struct reencipher_info info;
-	int rc;
+	struct reencipher_info info = { 0 };
+	process_key_t process_func;
+	int rc, wait_rc;
 
 	util_assert(keystore != NULL, "Internal error: keystore is NULL");
 
@@ -3670,10 +4430,21 @@ int keystore_reencipher_key(struct keystore *keystore, const char *name_filter,
 	info.num_failed = 0;
 	info.num_reenciphered = 0;
 	info.num_skipped = 0;
+	info.jobs = MAX(jobs, 1U);
+	info.jobs_per_apqn = MAX(jobs_per_apqn, 1U);
+	util_list_init(&info.job_list, struct reencipher_job, node);
+
+	process_func = info.jobs > 1 ? _keystore_process_reenc_parallel :
+				       _keystore_process_reencipher;
 
 	rc = _keystore_process_filtered(keystore, name_filter, NULL,
 					apqn_filter, NULL, NULL, false, false,
-					_keystore_process_reencipher, &info);
+					process_func, &info);
+	while (info.num_running > 0) {
+		wait_rc = _keystore_reencipher_wait(keystore, &info);
+		if (wait_rc != 0 && rc == 0)
+			rc = wait_rc;
+	}
 
 	if (rc != 0) {
 		pr_verbose(keystore, "Failed to re-encipher keys: %s",
@@ -4025,6 +4796,7 @@ int keystore_remove_key(struct keystore *keystore, const char *name,
 		pr_verbose(keystore, "Failed to remove '%s': %s",
 			   file_names.info_filename, strerror(-rc));
 	}
+	_keystore_index_remove(keystore, name);
 	if (_keystore_reencipher_key_exists(&file_names)) {
 		if (remove(file_names.renc_filename) != 0) {
 			rc = -errno;
@@ -4956,6 +5728,8 @@ static int _keystore_process_kms_key_set_prop(struct keystore *keystore,
 
 	pr_verbose(keystore, "Setting property for KMS-bound key '%s'", name);
 
+	properties_begin(properties);
+
 	if (set_prop->prop_value != NULL) {
 		rc = properties_set(properties, set_prop->prop_name,
 				    set_prop->prop_value);
@@ -4977,7 +5751,8 @@ static int _keystore_process_kms_key_set_prop(struct keystore *keystore,
 		}
 	}
 
-	rc = properties_save(properties, file_names->info_filename, 1);
+	/* The info file is only rewritten if the property has changed */
+	rc = properties_commit(properties, file_names->info_filename, 1);
 	if (rc != 0) {
 		pr_verbose(keystore,
 			   "Key info file '%s' could not be written: %s",
@@ -5562,6 +6337,51 @@ int keystore_import_kms_keys(struct keystore *keystore,
 	return rc;
 }
 
+struct kms_key_ids {
+	char **key_ids;
+	size_t num_key_ids;
+};
+
+/**
+ * Processing function to collect the key-IDs of KMS-bound keys
+ *
+ * @param[in] keystore   the keystore (not used here)
+ * @param[in] name       the name of the key (not used here)
+ * @param[in] properties the properties object of the key
+ * @param[in] file_names the file names used by this key (not used here)
+ * @param[in] private    private data: struct kms_key_ids
+ *
+ * @returns 0 for success
+ */
+static int _keystore_collect_kms_key_ids(struct keystore *UNUSED(keystore),
+					 const char *UNUSED(name),
+					 struct properties *properties,
+					 struct key_filenames *UNUSED(file_names),
+					 void *private)
+{
+	static const char * const id_props[] = {
+		PROP_NAME_KMS_KEY_ID,
+		PROP_NAME_KMS_XTS_KEY1_ID,
+		PROP_NAME_KMS_XTS_KEY2_ID,
+	};
+	struct kms_key_ids *ids = private;
+	unsigned int i;
+	char *key_id;
+
+	for (i = 0; i < ARRAY_SIZE(id_props); i++) {
+		key_id = properties_get(properties, id_props[i]);
+		if (key_id == NULL)
+			continue;
+
+		ids->key_ids = util_realloc(ids->key_ids,
+					    (ids->num_key_ids + 1) *
+					    sizeof(char *));
+		ids->key_ids[ids->num_key_ids++] = key_id;
+	}
+
+	return 0;
+}
+
 struct kms_refresh {
 	bool refresh_properties;
 	bool novolcheck;
@@ -5764,6 +6584,8 @@ int keystore_refresh_kms_keys(struct keystore *keystore,
 			     bool refresh_properties, bool novolcheck)
 {
 	struct kms_refresh refresh_data = { 0 };
+	struct kms_key_ids key_ids = { 0 };
+	size_t i;
 	int rc;
 
 	util_assert(keystore != NULL, "Internal error: keystore is NULL");
@@ -5790,6 +6612,23 @@ int keystore_refresh_kms_keys(struct keystore *keystore,
 	refresh_data.num_refreshed = 0;
 	refresh_data.num_failed = 0;
 
+	/*
+	 * Let the KMS plugin retrieve the keys to refresh with as few
+	 * requests as possible. The keys are retrieved individually if
+	 * this fails.
+	 */
+	rc = _keystore_process_filtered(keystore, name_filter, volume_filter,
+					NULL, volume_type, key_type, false,
+					true, _keystore_collect_kms_key_ids,
+					&key_ids);
+	if (rc == 0 && key_ids.num_key_ids > 1)
+		prefetch_kms_keys(keystore->kms_info,
+				  (const char **)key_ids.key_ids,
+				  key_ids.num_key_ids, keystore->verbose);
+	for (i = 0; i < key_ids.num_key_ids; i++)
+		free(key_ids.key_ids[i]);
+	free(key_ids.key_ids);
+
 	rc = _keystore_process_filtered(keystore, name_filter, volume_filter,
 					NULL, volume_type, key_type, false,
 					true, _keystore_refresh_kms_key,
@@ -5817,6 +6656,8 @@ void keystore_free(struct keystore *keystore)
 {
 	util_assert(keystore != NULL, "Internal error: keystore is NULL");
 
+	_keystore_index_save(keystore);
+	_keystore_index_free(keystore->index);
 	_keystore_unlock_repository(keystore);
 	free(keystore->directory);
 	free(keystore);
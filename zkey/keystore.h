@@ -17,6 +17,8 @@
 #include "pkey.h"
 #include "kms.h"
 
+struct keystore_index;
+
 struct keystore {
 	bool verbose;
 	char *directory;
@@ -24,6 +26,7 @@ struct keystore {
 	mode_t mode;
 	gid_t owner;
 	struct kms_info *kms_info;
+	struct keystore_index *index;
 };
 
 #define PROP_NAME_KEY_TYPE		"key-type"
@@ -90,7 +93,8 @@ int keystore_reencipher_key(struct keystore *keystore, const char *name_filter,
 			    const char *apqn_filter,
 			    bool from_old, bool to_new, bool inplace,
 			    bool staged, bool complete, int pkey_fd,
-			    struct ext_lib *lib);
+			    struct ext_lib *lib, unsigned int jobs,
+			    unsigned int jobs_per_apqn);
 
 int keystore_copy_key(struct keystore *keystore, const char *name,
 		      const char *newname, const char *volumes, bool local);
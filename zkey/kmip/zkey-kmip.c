@@ -838,6 +838,58 @@ error:
 	return NULL;
 }
 
+/**
+ * Disconnects from the KMIP server and frees the connection pool. The TLS
+ * session is saved for resumption by later invocations, unless the
+ * connection related configuration changes.
+ *
+ * @param ph                the plugin handle
+ * @param forget_session    if true, the saved TLS session is removed
+ */
+static void _disconnect_from_server(struct plugin_handle *ph,
+				    bool forget_session)
+{
+	char *session_file = NULL;
+
+	if (ph->connection != NULL)
+		kmip_connection_pool_put(ph->pool, ph->connection, false,
+					 ph->pd.verbose);
+	ph->connection = NULL;
+
+	kmip_connection_pool_free(ph->pool, ph->pd.verbose);
+	ph->pool = NULL;
+
+	if (!forget_session)
+		return;
+
+	util_asprintf(&session_file, "%s/%s", ph->pd.config_path,
+		      KMIP_CONFIG_TLS_SESSION_FILE);
+	if (remove(session_file) != 0 && errno != ENOENT)
+		pr_verbose(&ph->pd, "Failed to remove '%s': %s", session_file,
+			   strerror(errno));
+	free(session_file);
+}
+
+/**
+ * Frees the prefetched responses
+ *
+ * @param ph                the plugin handle
+ */
+static void _free_prefetch(struct plugin_handle *ph)
+{
+	size_t i;
+
+	for (i = 0; i < ph->num_prefetch; i++) {
+		free(ph->prefetch[i].key_id);
+		kmip_node_free(ph->prefetch[i].attrs);
+		kmip_node_free(ph->prefetch[i].wrapped_key);
+	}
+	free(ph->prefetch);
+	ph->prefetch = NULL;
+	ph->num_prefetch = 0;
+	ph->next_prefetch = 0;
+}
+
 /**
  * Terminates the use of a KMS plugin. When a repository is bound to a KMS
  * plugin, zkey calls this function when closing the repository.
@@ -856,9 +908,9 @@ int kms_terminate(const kms_handle_t handle)
 
 	pr_verbose(&ph->pd, "Plugin terminating");
 
-	if (ph->connection != NULL)
-		kmip_connection_free(ph->connection);
+	_disconnect_from_server(ph, false);
 
+	_free_prefetch(ph);
 	_free_kmip_config(ph);
 
 	if (ph->identity_secure_key != NULL)
@@ -2290,14 +2342,32 @@ out:
  */
 static int _connect_to_server(struct plugin_handle *ph)
 {
+	char *session_file = NULL;
 	int rc;
 
 	if (ph->connection != NULL)
-		kmip_connection_free(ph->connection);
+		kmip_connection_pool_put(ph->pool, ph->connection, true,
+					 ph->pd.verbose);
 	ph->connection = NULL;
 
-	rc = kmip_connection_new(&ph->kmip_config, &ph->connection,
-				 ph->pd.verbose);
+	if (ph->pool == NULL) {
+		util_asprintf(&session_file, "%s/%s", ph->pd.config_path,
+			      KMIP_CONFIG_TLS_SESSION_FILE);
+		rc = kmip_connection_pool_new(&ph->kmip_config, 1,
+					      KMIP_POOL_IDLE_TIMEOUT,
+					      session_file, &ph->pool,
+					      ph->pd.verbose);
+		free(session_file);
+		if (rc != 0) {
+			_set_error(ph, "Failed to setup the connection to "
+				   "KMIP server at '%s': %s",
+				   ph->kmip_config.server, strerror(-rc));
+			return rc;
+		}
+	}
+
+	rc = kmip_connection_pool_get(ph->pool, &ph->connection,
+				      ph->pd.verbose);
 	if (rc != 0) {
 		_set_error(ph, "Failed to connect to KMIP server at '%s': "
 			   "%s", ph->kmip_config.server, strerror(-rc));
@@ -2542,6 +2612,141 @@ static int _perform_kmip_request(struct plugin_handle *ph,
 				      NULL, KMIP_BATCH_ERR_CONT_STOP);
 }
 
+/**
+ * Perform a KMIP request with multiple batch items. The result of each batch
+ * item is checked individually, so that a failing item does not fail the
+ * other items. If the server does not support batch items, all items are
+ * performed with a separate request each.
+ *
+ * @param ph                the plugin handle
+ * @param num_items         the number of batch items
+ * @param operations        the operations of the batch items
+ * @param req_pls           the request payloads of the batch items
+ * @param resp_pls          On return: the response payloads of the batch
+ *                          items. NULL for failed batch items.
+ * @param rcs               On return: 0 for each successful batch item, a
+ *                          negative errno for each failed batch item.
+ *
+ * @returns 0 on success, a negative errno in case the request as a whole
+ * failed.
+ */
+static int _perform_kmip_batch(struct plugin_handle *ph, int32_t num_items,
+			       const enum kmip_operation *operations,
+			       struct kmip_node **req_pls,
+			       struct kmip_node **resp_pls, int *rcs)
+{
+	struct kmip_node *req = NULL, *resp = NULL, *req_hdr = NULL;
+	struct kmip_node **req_bis = NULL, *resp_hdr = NULL;
+	int32_t i, batch_count;
+	int rc = 0;
+
+	for (i = 0; i < num_items; i++) {
+		resp_pls[i] = NULL;
+		rcs[i] = -EIO;
+	}
+
+	if (ph->batch_unsupported || num_items == 1)
+		goto single;
+
+	pr_verbose(&ph->pd, "Perform KMIP request, batch items: %d",
+		   num_items);
+
+	req_bis = util_zalloc(num_items * sizeof(struct kmip_node *));
+	for (i = 0; i < num_items; i++) {
+		req_bis[i] = kmip_new_request_batch_item(operations[i], NULL, 0,
+							 req_pls[i]);
+		CHECK_ERROR(req_bis[i] == NULL, rc, -ENOMEM,
+			    "Allocate KMIP node failed", ph, out);
+	}
+
+	req_hdr = kmip_new_request_header(NULL, 0, NULL, NULL, false, NULL,
+					  KMIP_BATCH_ERR_CONT_CONTINUE, true,
+					  num_items);
+	CHECK_ERROR(req_hdr == NULL, rc, -ENOMEM, "Allocate KMIP node failed",
+		    ph, out);
+
+	req = kmip_new_request(req_hdr, num_items, req_bis);
+	CHECK_ERROR(req == NULL, rc, -ENOMEM, "Allocate KMIP node failed",
+		    ph, out);
+
+	rc = kmip_connection_perform(ph->connection, req, &resp,
+				     ph->pd.verbose);
+	if (rc != 0) {
+		_set_error(ph, "Failed to perform KMIP request: %s",
+			   strerror(-rc));
+		goto out;
+	}
+
+	rc = kmip_get_response(resp, &resp_hdr, 0, NULL);
+	CHECK_ERROR(rc != 0, rc, rc, "Get KMIP response header failed",
+		    ph, out);
+
+	rc = kmip_get_response_header(resp_hdr, NULL, NULL, NULL, NULL,
+				      &batch_count);
+	CHECK_ERROR(rc != 0, rc, rc, "Get KMIP response header infos failed",
+		    ph, out);
+
+	/*
+	 * A server that does not support batch items rejects the request
+	 * with a single failed batch item.
+	 */
+	if (batch_count != num_items) {
+		pr_verbose(&ph->pd, "Batch items not supported by the server, "
+			   "performing separate requests");
+		ph->batch_unsupported = true;
+		goto single;
+	}
+
+	for (i = 0; i < num_items; i++)
+		rcs[i] = _check_kmip_response(ph, resp, i, operations[i],
+					      &resp_pls[i]);
+	goto out;
+
+single:
+	for (i = 0; i < num_items; i++)
+		rcs[i] = _perform_kmip_request(ph, operations[i], req_pls[i],
+					       &resp_pls[i]);
+
+out:
+	if (req_bis != NULL) {
+		for (i = 0; i < num_items; i++)
+			kmip_node_free(req_bis[i]);
+		free(req_bis);
+	}
+	kmip_node_free(req_hdr);
+	kmip_node_free(req);
+	kmip_node_free(resp_hdr);
+	kmip_node_free(resp);
+
+	return rc;
+}
+
+/**
+ * Finds the prefetched responses of a key. The keys are usually processed in
+ * the order they were prefetched, so the search starts after the key found
+ * last.
+ *
+ * @param ph                the plugin handle
+ * @param key_id            the ID of the key
+ *
+ * @returns the prefetched responses, or NULL if none are available
+ */
+static struct kmip_prefetch *_find_prefetch(struct plugin_handle *ph,
+					    const char *key_id)
+{
+	size_t i, k;
+
+	for (k = 0; k < ph->num_prefetch; k++) {
+		i = (ph->next_prefetch + k) % ph->num_prefetch;
+		if (strcmp(ph->prefetch[i].key_id, key_id) == 0) {
+			ph->next_prefetch = i + 1;
+			return &ph->prefetch[i];
+		}
+	}
+
+	return NULL;
+}
+
 
 /**
  * Checks if all required enumeration values are contained in the query
@@ -2919,8 +3124,7 @@ static int _configure_connection(struct plugin_handle *ph,
 			return rc;
 
 		/* re-establish the kmip configuration with the new profile */
-		kmip_connection_free(ph->connection);
-		ph->connection = NULL;
+		_disconnect_from_server(ph, true);
 
 		_free_kmip_config(ph);
 		rc = _get_kmip_config(ph);
@@ -4183,6 +4387,15 @@ int kms_configure(const kms_handle_t handle,
 		}
 	}
 
+	/*
+	 * A TLS session established with the previous identity or server
+	 * configuration must not be resumed.
+	 */
+	if (opts.generate_identity_key != NULL || opts.csr_pem_file != NULL ||
+	    opts.sscert_pem_file != NULL || opts.client_cert != NULL ||
+	    opts.kmip_server != NULL)
+		_disconnect_from_server(ph, true);
+
 	if (opts.generate_identity_key != NULL) {
 		rc = _generate_identity_key(ph, opts.generate_identity_key);
 		if (rc != 0)
@@ -4969,39 +5182,21 @@ out:
 }
 
 /**
- * Retrieves an AES key from the KMIP server. The key is wrapped with the
- * RSA wrapping key.
+ * Build a Get request payload to get a key wrapped with the wrapping key
  *
  * @param ph                the plugin handle
  * @param key_id            the key id of the key to get
- * @param wrapped_key       On return: an allocated buffer with the wrapped key.
- *                          Must be freed by the caller.
- * @param wrapped_key_len   On return: the size of the wrapped key.
- * @param key_bits          On return the cryptographic size of the key in bits
+ * @param req_pl            On return: the request payload
  *
  * @returns 0 on success, a negative errno in case of an error.
  */
-static int _get_key_rsa_wrapped(struct plugin_handle *ph, const char *key_id,
-				unsigned char **wrapped_key,
-				size_t *wrapped_key_len, size_t *key_bits)
+static int _build_get_wrapped_key_request(struct plugin_handle *ph,
+					  const char *key_id,
+					  struct kmip_node **req_pl)
 {
 	struct kmip_node *cparams = NULL, *wrap_id = NULL, *wkey_info = NULL;
-	struct kmip_node *wrap_spec = NULL, *req_pl = NULL, *resp_pl = NULL;
-	struct kmip_node *uid = NULL, *kobj = NULL, *kblock = NULL;
-	struct kmip_node *kval = NULL, *wrap = NULL, *key = NULL;
-	struct kmip_node *wkinfo = NULL, *wcparms = NULL;
-	enum kmip_hashing_algo halgo, mgfhalgo;
-	enum kmip_wrapping_method wmethod;
-	enum kmip_key_format_type ftype;
-	enum kmip_padding_method pmeth;
-	enum kmip_encoding_option enc;
-	enum kmip_mask_generator mgf;
-	enum kmip_object_type otype;
-	enum kmip_crypto_algo algo;
-	const unsigned char *kdata;
+	struct kmip_node *wrap_spec = NULL, *uid = NULL;
 	char *wrap_key_id = NULL;
-	uint32_t klen;
-	int32_t bits;
 	int rc = 0;
 
 	pr_verbose(&ph->pd, "Wrap padding method: %d",
@@ -5054,16 +5249,77 @@ static int _get_key_rsa_wrapped(struct plugin_handle *ph, const char *key_id,
 	CHECK_ERROR(uid == NULL, rc, -ENOMEM, "Allocate KMIP node failed",
 		    ph, out);
 
-	req_pl = kmip_new_get_request_payload(NULL, uid,
-					      KMIP_KEY_FORMAT_TYPE_RAW, 0, 0,
-					      wrap_spec);
-	CHECK_ERROR(req_pl == NULL, rc, -ENOMEM, "Allocate KMIP node failed",
+	*req_pl = kmip_new_get_request_payload(NULL, uid,
+					       KMIP_KEY_FORMAT_TYPE_RAW, 0, 0,
+					       wrap_spec);
+	CHECK_ERROR(*req_pl == NULL, rc, -ENOMEM, "Allocate KMIP node failed",
 		    ph, out);
 
+out:
+	kmip_node_free(cparams);
+	kmip_node_free(wrap_id);
+	kmip_node_free(wkey_info);
+	kmip_node_free(wrap_spec);
+	kmip_node_free(uid);
+
+	if (wrap_key_id != NULL)
+		free(wrap_key_id);
+
+	return rc;
+}
+
+/**
+ * Retrieves an AES key from the KMIP server. The key is wrapped with the
+ * RSA wrapping key.
+ *
+ * @param ph                the plugin handle
+ * @param key_id            the key id of the key to get
+ * @param wrapped_key       On return: an allocated buffer with the wrapped key.
+ *                          Must be freed by the caller.
+ * @param wrapped_key_len   On return: the size of the wrapped key.
+ * @param key_bits          On return the cryptographic size of the key in bits
+ *
+ * @returns 0 on success, a negative errno in case of an error.
+ */
+static int _get_key_rsa_wrapped(struct plugin_handle *ph, const char *key_id,
+				unsigned char **wrapped_key,
+				size_t *wrapped_key_len, size_t *key_bits)
+{
+	struct kmip_node *req_pl = NULL, *resp_pl = NULL, *kobj = NULL;
+	struct kmip_node *kval = NULL, *wrap = NULL, *key = NULL;
+	struct kmip_node *wkinfo = NULL, *wcparms = NULL, *kblock = NULL;
+	struct kmip_prefetch *prefetch;
+	enum kmip_hashing_algo halgo, mgfhalgo;
+	enum kmip_wrapping_method wmethod;
+	enum kmip_key_format_type ftype;
+	enum kmip_padding_method pmeth;
+	enum kmip_encoding_option enc;
+	enum kmip_mask_generator mgf;
+	enum kmip_object_type otype;
+	enum kmip_crypto_algo algo;
+	const unsigned char *kdata;
+	uint32_t klen;
+	int32_t bits;
+	int rc = 0;
+
+	prefetch = _find_prefetch(ph, key_id);
+	if (prefetch != NULL && prefetch->wrapped_key != NULL) {
+		pr_verbose(&ph->pd, "Using prefetched wrapped key '%s'",
+			   key_id);
+		kmip_node_upref(prefetch->wrapped_key);
+		resp_pl = prefetch->wrapped_key;
+		goto check;
+	}
+
+	rc = _build_get_wrapped_key_request(ph, key_id, &req_pl);
+	if (rc != 0)
+		goto out;
+
 	rc = _perform_kmip_request(ph, KMIP_OPERATION_GET, req_pl, &resp_pl);
 	if (rc != 0)
 		goto out;
 
+check:
 	rc = kmip_get_get_response_payload(resp_pl, &otype, NULL, &kobj);
 	CHECK_ERROR(rc != 0, rc, rc, "Failed to get wrapped key", ph, out);
 	CHECK_ERROR(otype != KMIP_OBJECT_TYPE_SYMMETRIC_KEY, rc, -EINVAL,
@@ -5140,11 +5396,6 @@ static int _get_key_rsa_wrapped(struct plugin_handle *ph, const char *key_id,
 	*key_bits = bits;
 
 out:
-	kmip_node_free(cparams);
-	kmip_node_free(wrap_id);
-	kmip_node_free(wkey_info);
-	kmip_node_free(wrap_spec);
-	kmip_node_free(uid);
 	kmip_node_free(req_pl);
 	kmip_node_free(resp_pl);
 	kmip_node_free(kobj);
@@ -5155,9 +5406,6 @@ out:
 	kmip_node_free(wcparms);
 	kmip_node_free(key);
 
-	if (wrap_key_id != NULL)
-		free(wrap_key_id);
-
 	return rc;
 }
 
@@ -5576,8 +5824,17 @@ static int _check_always_sensitive(struct plugin_handle *ph, const char *key_id)
 {
 	struct kmip_node *uid = NULL, *req_pl = NULL, *resp_pl = NULL;
 	struct kmip_node *attr_ref = NULL, *attr = NULL;
+	struct kmip_prefetch *prefetch;
+	int32_t i;
 	int rc;
 
+	prefetch = _find_prefetch(ph, key_id);
+	if (prefetch != NULL && prefetch->attrs != NULL) {
+		kmip_node_upref(prefetch->attrs);
+		resp_pl = prefetch->attrs;
+		goto check;
+	}
+
 	uid = kmip_new_unique_identifier(key_id, 0, 0);
 	CHECK_ERROR(uid == NULL, rc, -ENOMEM, "Allocate KMIP node failed",
 		    ph, out);
@@ -5597,11 +5854,18 @@ static int _check_always_sensitive(struct plugin_handle *ph, const char *key_id)
 	if (rc != 0)
 		goto out;
 
-	rc = kmip_get_get_attributes_response_payload(resp_pl, NULL, NULL,
-						      0, &attr);
-	CHECK_ERROR(rc != 0, rc, rc, "Failed to get attribute", ph, out);
-	CHECK_ERROR(kmip_node_get_tag(attr) != KMIP_TAG_ALWAYS_SENSITIVE, rc,
-		    -EINVAL, "Unexpected attribute", ph, out);
+check:
+	/* A prefetched response contains all attributes of the key */
+	for (i = 0; ; i++) {
+		rc = kmip_get_get_attributes_response_payload(resp_pl, NULL,
+							      NULL, i, &attr);
+		CHECK_ERROR(rc != 0, rc, rc, "Failed to get attribute",
+			    ph, out);
+		if (kmip_node_get_tag(attr) == KMIP_TAG_ALWAYS_SENSITIVE)
+			break;
+		kmip_node_free(attr);
+		attr = NULL;
+	}
 
 	if (kmip_node_get_boolean(attr) != true) {
 		_set_error(ph, "The 'Always Sensitive' attribute of the key "
@@ -5776,6 +6040,7 @@ int kms_generate_key(const kms_handle_t handle, const char *key_type,
 	}
 
 	plugin_clear_error(&ph->pd);
+	_free_prefetch(ph);
 
 	if (!ph->config_complete) {
 		_set_error(ph, "The configuration is incomplete, run 'zkey "
@@ -5949,6 +6214,7 @@ int kms_set_key_properties(const kms_handle_t handle, const char *key_id,
 	}
 
 	plugin_clear_error(&ph->pd);
+	_free_prefetch(ph);
 
 	if (!ph->config_complete) {
 		_set_error(ph, "The configuration is incomplete, run 'zkey "
@@ -5992,6 +6258,76 @@ static void _reealloc_props_array(struct kms_property **array,
 	*array = util_realloc(*array, *size * sizeof(struct kms_property));
 }
 
+/**
+ * Build a Get Attributes request payload that requests all attributes of a
+ * key
+ *
+ * @param ph                the plugin handle
+ * @param key_id            the ID of the key to get the attributes for
+ * @param req_pl            On return: the request payload
+ *
+ * @returns 0 on success, a negative errno in case of an error.
+ */
+static int _build_get_attributes_request(struct plugin_handle *ph,
+					 const char *key_id,
+					 struct kmip_node **req_pl)
+{
+	struct kmip_node *uid = NULL;
+	int rc = 0;
+
+	uid = kmip_new_unique_identifier(key_id, 0, 0);
+	CHECK_ERROR(uid == NULL, rc, -ENOMEM, "Allocate KMIP node failed",
+		    ph, out);
+
+	/* With no Attr-Refs specified, all attributes are to be returned */
+	*req_pl = kmip_new_get_attributes_request_payload(NULL, uid, 0, NULL);
+	CHECK_ERROR(*req_pl == NULL, rc, -ENOMEM, "Allocate KMIP node failed",
+		    ph, out);
+
+out:
+	kmip_node_free(uid);
+
+	return rc;
+}
+
+/**
+ * Get all attributes of a key. Uses the prefetched response, if available.
+ *
+ * @param ph                the plugin handle
+ * @param key_id            the ID of the key to get the attributes for
+ * @param resp_pl           On return: the Get Attributes response payload
+ *
+ * @returns 0 on success, a negative errno in case of an error.
+ */
+static int _get_all_attributes(struct plugin_handle *ph, const char *key_id,
+			       struct kmip_node **resp_pl)
+{
+	struct kmip_node *req_pl = NULL;
+	struct kmip_prefetch *prefetch;
+	int rc;
+
+	prefetch = _find_prefetch(ph, key_id);
+	if (prefetch != NULL && prefetch->attrs != NULL) {
+		pr_verbose(&ph->pd, "Using prefetched attributes of key '%s'",
+			   key_id);
+		kmip_node_upref(prefetch->attrs);
+		*resp_pl = prefetch->attrs;
+		return 0;
+	}
+
+	rc = _build_get_attributes_request(ph, key_id, &req_pl);
+	if (rc != 0)
+		goto out;
+
+	rc = _perform_kmip_request(ph, KMIP_OPERATION_GET_ATTRIBUTES, req_pl,
+				   resp_pl);
+
+out:
+	kmip_node_free(req_pl);
+
+	return rc;
+}
+
 /**
  * Get a list of key attributes that can be mapped to KMS properties.
  * The returned list of properties must be freed by the caller. Each property
@@ -6022,8 +6358,7 @@ static int _get_key_attributes(struct plugin_handle *ph, const char *key_id,
 			       enum kmip_crypto_algo *algo,
 			       bool *sensitive, bool *always_sensitive)
 {
-	struct kmip_node *req_pl = NULL, *resp_pl = NULL, *uid = NULL;
-	struct kmip_node *attr = NULL, *linked_id = NULL;
+	struct kmip_node *attr = NULL, *linked_id = NULL, *resp_pl = NULL;
 	const char *description, *id, *name, *value;
 	struct kms_property *props = NULL;
 	enum kmip_link_type link_type;
@@ -6046,17 +6381,7 @@ static int _get_key_attributes(struct plugin_handle *ph, const char *key_id,
 	if (always_sensitive != NULL)
 		*always_sensitive = false;
 
-	uid = kmip_new_unique_identifier(key_id, 0, 0);
-	CHECK_ERROR(uid == NULL, rc, -ENOMEM, "Allocate KMIP node failed",
-		    ph, out);
-
-	/* With no Attr-Refs specified, all attributes are to be returned */
-	req_pl = kmip_new_get_attributes_request_payload(NULL, uid, 0, NULL);
-	CHECK_ERROR(req_pl == NULL, rc, -ENOMEM, "Allocate KMIP node failed",
-		    ph, out);
-
-	rc = _perform_kmip_request(ph, KMIP_OPERATION_GET_ATTRIBUTES, req_pl,
-				   &resp_pl);
+	rc = _get_all_attributes(ph, key_id, &resp_pl);
 	if (rc != 0)
 		goto out;
 
@@ -6229,8 +6554,6 @@ static int _get_key_attributes(struct plugin_handle *ph, const char *key_id,
 	rc = 0;
 
 out:
-	kmip_node_free(uid);
-	kmip_node_free(req_pl);
 	kmip_node_free(resp_pl);
 	kmip_node_free(attr);
 	kmip_node_free(linked_id);
@@ -6397,6 +6720,7 @@ int kms_remove_key(const kms_handle_t handle, const char *key_id,
 	}
 
 	plugin_clear_error(&ph->pd);
+	_free_prefetch(ph);
 
 	for (i = 0; i < num_options; i++) {
 		switch (options[i].option) {
@@ -6470,6 +6794,95 @@ out:
 	return rc;
 }
 
+/**
+ * Prefetches the attributes, and optionally the wrapped keys, of a list of
+ * keys with batched requests. A key that fails to prefetch is requested
+ * again when it is used, so that its error is reported then.
+ *
+ * @param ph                the plugin handle
+ * @param key_ids           the IDs of the keys to prefetch
+ * @param num_key_ids       the number of key IDs
+ * @param wrapped_keys      if true, the wrapped keys are prefetched as well
+ *
+ * @returns 0 on success, a negative errno in case of an error.
+ */
+static int _prefetch_keys(struct plugin_handle *ph, const char **key_ids,
+			  size_t num_key_ids, bool wrapped_keys)
+{
+	struct kmip_node *req_pls[KMIP_MAX_BATCH_ITEMS] = { 0 };
+	struct kmip_node *resp_pls[KMIP_MAX_BATCH_ITEMS];
+	enum kmip_operation ops[KMIP_MAX_BATCH_ITEMS];
+	int rcs[KMIP_MAX_BATCH_ITEMS];
+	struct kmip_prefetch *prefetch;
+	size_t i, k, num, first;
+	int32_t n = 0;
+	int rc = 0;
+
+	_free_prefetch(ph);
+
+	if (num_key_ids == 0)
+		return 0;
+
+	if (ph->profile->wrap_key_algo != KMIP_CRYPTO_ALGO_RSA)
+		wrapped_keys = false;
+
+	pr_verbose(&ph->pd, "Prefetching %zu keys", num_key_ids);
+
+	ph->prefetch = util_zalloc(num_key_ids * sizeof(struct kmip_prefetch));
+
+	for (i = 0; i < num_key_ids; i += num) {
+		num = MIN(num_key_ids - i, (size_t)KMIP_MAX_BATCH_ITEMS /
+						(wrapped_keys ? 2 : 1));
+		first = ph->num_prefetch;
+
+		for (k = 0, n = 0; k < num; k++) {
+			ph->prefetch[first + k].key_id =
+						util_strdup(key_ids[i + k]);
+			ph->num_prefetch++;
+
+			ops[n] = KMIP_OPERATION_GET_ATTRIBUTES;
+			rc = _build_get_attributes_request(ph, key_ids[i + k],
+							   &req_pls[n++]);
+			if (rc != 0)
+				goto out;
+
+			if (!wrapped_keys)
+				continue;
+
+			ops[n] = KMIP_OPERATION_GET;
+			rc = _build_get_wrapped_key_request(ph, key_ids[i + k],
+							    &req_pls[n++]);
+			if (rc != 0)
+				goto out;
+		}
+
+		rc = _perform_kmip_batch(ph, n, ops, req_pls, resp_pls, rcs);
+		if (rc != 0)
+			goto out;
+
+		for (k = 0, n = 0; k < num; k++) {
+			prefetch = &ph->prefetch[first + k];
+			prefetch->attrs = resp_pls[n++];
+			if (wrapped_keys)
+				prefetch->wrapped_key = resp_pls[n++];
+		}
+
+		for (k = 0; k < (size_t)n; k++) {
+			kmip_node_free(req_pls[k]);
+			req_pls[k] = NULL;
+		}
+	}
+
+	/* Errors of individual keys are reported when the key is used */
+	plugin_clear_error(&ph->pd);
+
+out:
+	for (k = 0; k < (size_t)n; k++)
+		kmip_node_free(req_pls[k]);
+
+	return rc;
+}
+
 /**
  * Process a located key item.
  *
@@ -6596,11 +7009,12 @@ int kms_list_keys(const kms_handle_t handle, const char *label_pattern,
 		  kms_list_callback callback, void *private_data)
 {
 	struct kmip_node *req_pl = NULL, *resp_pl = NULL, *item_uid = NULL;
+	size_t num_attrs, num_key_ids = 0;
 	struct plugin_handle *ph = handle;
 	struct kmip_node **attrs = NULL;
 	bool label_filter = false;
+	char **key_ids = NULL;
 	char *key_type = NULL;
-	size_t num_attrs;
 	const char *id;
 	size_t i, k;
 	int rc = 0;
@@ -6756,17 +7170,35 @@ int kms_list_keys(const kms_handle_t handle, const char *label_pattern,
 		rc = kmip_get_unique_identifier(item_uid, &id, NULL, NULL);
 		CHECK_ERROR(rc != 0, rc, rc, "Failed to get item id", ph, out);
 
-		pr_verbose(&ph->pd, "Item ID: '%s'", id);
-
-		rc = _process_list_item(ph, id, label_pattern, key_type,
-					callback, private_data);
-		if (rc != 0)
-			goto out;
+		key_ids = util_realloc(key_ids,
+				       (num_key_ids + 1) * sizeof(char *));
+		key_ids[num_key_ids++] = util_strdup(id);
 
 		kmip_node_free(item_uid);
 		item_uid = NULL;
 	}
 
+	/*
+	 * Get the attributes of the located keys with batched requests. The
+	 * prefetched attributes are also used when the keys are imported.
+	 */
+	rc = _prefetch_keys(ph, (const char **)key_ids, num_key_ids, false);
+	if (rc != 0) {
+		pr_verbose(&ph->pd, "Failed to prefetch keys: %s, "
+			   "continue without", strerror(-rc));
+		_free_prefetch(ph);
+		plugin_clear_error(&ph->pd);
+	}
+
+	for (i = 0; i < num_key_ids; i++) {
+		pr_verbose(&ph->pd, "Item ID: '%s'", key_ids[i]);
+
+		rc = _process_list_item(ph, key_ids[i], label_pattern,
+					key_type, callback, private_data);
+		if (rc != 0)
+			goto out;
+	}
+
 	rc = 0;
 
 out:
@@ -6783,6 +7215,12 @@ out:
 	kmip_node_free(resp_pl);
 	kmip_node_free(item_uid);
 
+	if (key_ids != NULL) {
+		for (i = 0; i < num_key_ids; i++)
+			free(key_ids[i]);
+		free(key_ids);
+	}
+
 	return rc;
 }
 
@@ -6873,8 +7311,51 @@ int kms_import_key2(const kms_handle_t handle, const char *key_id,
 	return rc;
 }
 
+/**
+ * Prefetches the information of keys that are about to be refreshed or
+ * imported, so that the following calls for these keys do not need a
+ * separate request to the KMS for each key.
+ *
+ * @param handle            the KMS plugin handle obtained from kms_initialize()
+ * @param key_ids           the key-IDs of the keys
+ * @param num_key_ids       the number of key-IDs in above array
+ *
+ * @returns 0 on success, or a negative errno in case of an error.
+ * Function kms_get_last_error() can be used to obtain more details about the
+ * error.
+ */
+int kms_prefetch_keys(const kms_handle_t handle, const char **key_ids,
+		      size_t num_key_ids)
+{
+	struct plugin_handle *ph = handle;
+	int rc = 0;
+
+	util_assert(handle != NULL, "Internal error: handle is NULL");
+	util_assert(num_key_ids == 0 || key_ids != NULL,
+		    "Internal error: key_ids is NULL but num_key_ids > 0");
+
+	pr_verbose(&ph->pd, "Prefetch Keys, number of keys: %zu", num_key_ids);
+
+	plugin_clear_error(&ph->pd);
+
+	if (!ph->config_complete) {
+		_set_error(ph, "The configuration is incomplete, run 'zkey "
+			  "kms configure [OPTIONS]' to complete the "
+			  "configuration.");
+		return -EINVAL;
+	}
+
+	if (ph->connection == NULL) {
+		rc = _connect_to_server(ph);
+		if (rc != 0)
+			return rc;
+	}
+
+	return _prefetch_keys(ph, key_ids, num_key_ids, true);
+}
+
 static const struct kms_functions kms_functions = {
-	.api_version = KMS_API_VERSION_2,
+	.api_version = KMS_API_VERSION_3,
 	.kms_bind = kms_bind,
 	.kms_initialize = kms_initialize,
 	.kms_terminate = kms_terminate,
@@ -6892,6 +7373,7 @@ static const struct kms_functions kms_functions = {
 	.kms_remove_key = kms_remove_key,
 	.kms_list_keys = kms_list_keys,
 	.kms_import_key2 = kms_import_key2,
+	.kms_prefetch_keys = kms_prefetch_keys,
 };
 
 /**
@@ -20,6 +20,15 @@
 #include "../plugin-utils.h"
 #include "../pkey.h"
 
+/*
+ * Responses prefetched for a key with batched requests
+ */
+struct kmip_prefetch {
+	char *key_id;
+	struct kmip_node *attrs; /* Get Attributes response payload */
+	struct kmip_node *wrapped_key; /* Get response payload */
+};
+
 struct plugin_handle {
 	struct plugin_data pd;
 	bool apqns_configured;
@@ -39,7 +48,12 @@ struct plugin_handle {
 	struct kmip_conn_config kmip_config;
 	struct kmip_version kmip_version;
 	struct kmip_profile *profile;
+	struct kmip_connection_pool *pool;
 	struct kmip_connection *connection;
+	bool batch_unsupported;
+	struct kmip_prefetch *prefetch;
+	size_t num_prefetch;
+	size_t next_prefetch;
 };
 
 #define KMIP_CONFIG_FILE			"kmip.conf"
@@ -50,6 +64,7 @@ struct plugin_handle {
 #define KMIP_CONFIG_SERVER_PUBKEY_FILE		"server-pubkey.pem"
 #define KMIP_CONFIG_WRAPPING_KEY_FILE		"wrapping-key.skey"
 #define KMIP_CONFIG_WRAPPING_KEY_REENC_FILE	"wrapping-key.reenc"
+#define KMIP_CONFIG_TLS_SESSION_FILE		"tls-session.pem"
 
 #define KMIP_CONFIG_APQNS			"apqns"
 #define KMIP_CONFIG_APQN_TYPE			"apqn-type"
@@ -88,6 +103,9 @@ struct plugin_handle {
 
 #define KMIP_MAX_KEY_TOKEN_SIZE			8192
 
+#define KMIP_MAX_BATCH_ITEMS			50
+#define KMIP_POOL_IDLE_TIMEOUT			60
+
 #define KMIP_CERT_EXT_KEY_USAGE			"extendedKeyUsage"
 #define KMIP_CERT_EXT_KEY_USAGE_CLIENT_AUTH	"extendedKeyUsage=clientAuth"
 #define KMIP_CERT_EXT_SUBJECT_ALT_NAME		"subjectAltName"
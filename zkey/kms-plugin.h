@@ -499,8 +499,29 @@ int kms_import_key2(const kms_handle_t handle, const char *key_id,
 		    const char *key_type,
 		    unsigned char *key_blob, size_t *key_blob_length);
 
+/**
+ * Prefetches the information of keys that are about to be processed, e.g.
+ * refreshed, so that the plugin can retrieve the information of multiple
+ * keys with a single request to the KMS. A plugin can ignore this call.
+ * Errors of individual keys must not be reported here, but when the key is
+ * processed.
+ *
+ * Note: This function is optional for an API version 3 plugin.
+ *
+ * @param handle            the KMS plugin handle obtained from kms_initialize()
+ * @param key_ids           the key-IDs of the keys
+ * @param num_key_ids       the number of key-IDs in above array
+ *
+ * @returns 0 on success, or a negative errno in case of an error.
+ * Function kms_get_last_error() can be used to obtain more details about the
+ * error.
+ */
+int kms_prefetch_keys(const kms_handle_t handle, const char **key_ids,
+		      size_t num_key_ids);
+
 #define KMS_API_VERSION_1	1
 #define KMS_API_VERSION_2	2
+#define KMS_API_VERSION_3	3
 
 struct kms_functions {
 	unsigned int api_version;
@@ -561,6 +582,9 @@ struct kms_functions {
 			      const char *key_type,
 			      unsigned char *key_blob,
 			      size_t *key_blob_length);
+	/* Version 3 functions. Only used when api_version is >= 3. */
+	int (*kms_prefetch_keys)(const kms_handle_t handle,
+				 const char **key_ids, size_t num_key_ids);
 };
 
 /**
@@ -3206,6 +3206,44 @@ out:
 	return rc;
 }
 
+/**
+ * Prefetches the information of KMS managed keys that are about to be
+ * processed, if the KMS plugin supports this. Failures are not fatal, the
+ * keys are then retrieved individually.
+ *
+ * @param[in] kms_info        information of the currently bound plugin.
+ * @param[in] key_ids         the key-IDs of the keys
+ * @param[in] num_key_ids     the number of key-IDs in above array
+ * @param[in] verbose         if true, verbose messages are printed
+ *
+ * @returns 0 for success or a negative errno in case of an error.
+ */
+int prefetch_kms_keys(struct kms_info *kms_info, const char **key_ids,
+		      size_t num_key_ids, bool verbose)
+{
+	int rc;
+
+	util_assert(kms_info != NULL, "Internal error: kms_info is NULL");
+
+	if (kms_info->plugin_lib == NULL)
+		return -ENOENT;
+
+	if (kms_info->funcs->api_version < KMS_API_VERSION_3 ||
+	    kms_info->funcs->kms_prefetch_keys == NULL) {
+		pr_verbose(verbose, "The KMS plugin does not support to "
+			   "prefetch keys");
+		return 0;
+	}
+
+	rc = kms_info->funcs->kms_prefetch_keys(kms_info->handle, key_ids,
+						num_key_ids);
+	if (rc != 0)
+		pr_verbose(verbose, "KMS plugin failed to prefetch keys: %s",
+			   strerror(-rc));
+
+	return rc;
+}
+
 /**
  * Refreshes KMS managed keys.
  *
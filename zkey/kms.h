@@ -119,6 +119,9 @@ int import_kms_key(struct kms_info *kms_info, const char *key1_id,
 		   unsigned char *key_blob, size_t *key_blob_length,
 		   const char *key_type, bool verbose);
 
+int prefetch_kms_keys(struct kms_info *kms_info, const char **key_ids,
+		      size_t num_key_ids, bool verbose);
+
 int refresh_kms_key(struct kms_info *kms_info, struct properties *key_props,
 		    char **description, char **cipher, char **iv_mode,
 		    char **volumes, char **volume_type, ssize_t *sector_size,
@@ -14,6 +14,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include <openssl/evp.h>
 
@@ -23,16 +25,29 @@
 
 #include "properties.h"
 
+/*
+ * The properties are kept in a list in the order they were added, so that
+ * they are saved in a stable order, and in a hash table for the lookup by
+ * name.
+ */
 struct properties {
 	struct util_list list;
+	struct property **buckets;
+	unsigned int num_buckets;
+	unsigned int num_properties;
+	unsigned int changes;
 };
 
 struct property {
 	struct util_list_node node;
+	struct property *hash_next;
+	unsigned int hash;
 	char *name;
 	char *value;
 };
 
+#define INITIAL_NUM_BUCKETS	16
+
 #define SHA256_DIGEST_LEN	32
 #define INTEGRITY_KEY_NAME      "__hash__"
 
@@ -132,6 +147,9 @@ struct properties *properties_new(void)
 
 	util_list_init_offset(&properties->list,
 			      offsetof(struct property, node));
+	properties->num_buckets = INITIAL_NUM_BUCKETS;
+	properties->buckets = util_zalloc(properties->num_buckets *
+					  sizeof(struct property *));
 	return properties;
 }
 
@@ -153,31 +171,97 @@ void properties_free(struct properties *properties)
 		free(property);
 	}
 
+	free(properties->buckets);
 	free(properties);
 }
 
 /**
- * Find a property by its name in the list iof properties
+ * Calculates the hash of a property name (FNV-1a)
+ *
+ * @param[in]  name          the name of the property
+ *
+ * @returns the hash value
+ */
+static unsigned int properties_hash(const char *name)
+{
+	unsigned int hash = 2166136261u;
+
+	for (; *name != '\0'; name++) {
+		hash ^= (unsigned char)*name;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * Doubles the number of hash buckets and rehashes all properties
+ *
+ * @param[in]  properties    the properties object
+ */
+static void properties_grow(struct properties *properties)
+{
+	struct property *property;
+	unsigned int i;
+
+	free(properties->buckets);
+	properties->num_buckets *= 2;
+	properties->buckets = util_zalloc(properties->num_buckets *
+					  sizeof(struct property *));
+
+	util_list_iterate(&properties->list, property) {
+		i = property->hash & (properties->num_buckets - 1);
+		property->hash_next = properties->buckets[i];
+		properties->buckets[i] = property;
+	}
+}
+
+/**
+ * Find a property by its name in the hash table of properties
  *
  * @param[in]  properties    the properties object
  * @param[in]  name          the name of the property to find
+ * @param[in]  hash          the hash of the name
  *
  * @returns a pointer to the proerty when it has been found, or NULL if not
  */
 static struct property *properties_find(struct properties *properties,
-					const char *name)
+					const char *name, unsigned int hash)
 {
 	struct property *property;
 
-	property = util_list_start(&properties->list);
-	while (property != NULL) {
-		if (strcmp(property->name, name) == 0)
+	property = properties->buckets[hash & (properties->num_buckets - 1)];
+	for (; property != NULL; property = property->hash_next) {
+		if (property->hash == hash && strcmp(property->name, name) == 0)
 			return property;
-		property = util_list_next(&properties->list, property);
 	}
 	return NULL;
 }
 
+/**
+ * Removes a property from the hash table and the list of properties and
+ * frees it
+ *
+ * @param[in]  properties    the properties object
+ * @param[in]  property      the property to remove
+ */
+static void properties_unlink(struct properties *properties,
+			      struct property *property)
+{
+	struct property **prev;
+
+	prev = &properties->buckets[property->hash &
+				    (properties->num_buckets - 1)];
+	while (*prev != property)
+		prev = &(*prev)->hash_next;
+	*prev = property->hash_next;
+
+	util_list_remove(&properties->list, property);
+	properties->num_properties--;
+	free(property->name);
+	free(property->value);
+	free(property);
+}
+
 /**
  * Adds or updates a property
  *
@@ -193,6 +277,8 @@ int properties_set2(struct properties *properties,
 		    const char *name, const char *value, bool uppercase)
 {
 	struct property *property;
+	unsigned int hash, b;
+	char *new_value;
 	int i;
 
 	util_assert(properties != NULL, "Internal error: properties is NULL");
@@ -204,20 +290,36 @@ int properties_set2(struct properties *properties,
 	if (strpbrk(value, RESTRICTED_PROPERTY_VALUE_CHARS) != NULL)
 		return -EINVAL;
 
-	property = properties_find(properties, name);
+	new_value = util_strdup(value);
+	if (uppercase) {
+		for (i = 0; new_value[i] != '\0'; i++)
+			new_value[i] = toupper(new_value[i]);
+	}
+
+	hash = properties_hash(name);
+	property = properties_find(properties, name, hash);
 	if (property != NULL) {
+		if (strcmp(property->value, new_value) == 0) {
+			free(new_value);
+			return 0;
+		}
 		free(property->value);
-		property->value = util_strdup(value);
+		property->value = new_value;
 	} else {
+		if (properties->num_properties >= properties->num_buckets)
+			properties_grow(properties);
+
 		property = util_zalloc(sizeof(struct property));
 		property->name = util_strdup(name);
-		property->value = util_strdup(value);
+		property->value = new_value;
+		property->hash = hash;
+		b = hash & (properties->num_buckets - 1);
+		property->hash_next = properties->buckets[b];
+		properties->buckets[b] = property;
 		util_list_add_tail(&properties->list, property);
+		properties->num_properties++;
 	}
-	if (uppercase) {
-		for (i = 0; property->value[i] != '\0'; i++)
-			property->value[i] = toupper(property->value[i]);
-	}
+	properties->changes++;
 
 	return 0;
 }
@@ -255,7 +357,7 @@ char *properties_get(struct properties *properties, const char *name)
 	util_assert(properties != NULL, "Internal error: properties is NULL");
 	util_assert(name != NULL, "Internal error: name is NULL");
 
-	property = properties_find(properties, name);
+	property = properties_find(properties, name, properties_hash(name));
 	if (property == NULL)
 		return NULL;
 
@@ -277,19 +379,108 @@ int properties_remove(struct properties *properties, const char *name)
 	util_assert(properties != NULL, "Internal error: properties is NULL");
 	util_assert(name != NULL, "Internal error: name is NULL");
 
-	property = properties_find(properties, name);
+	property = properties_find(properties, name, properties_hash(name));
 	if (property == NULL)
 		return -ENOENT;
 
-	free(property->name);
-	free(property->value);
-	util_list_remove(&properties->list, property);
-	free(property);
+	properties_unlink(properties, property);
+	properties->changes++;
 	return 0;
 }
 
 /**
- * Saves the properties to a file
+ * Begins a transaction of updates of the properties. The updates are
+ * written with properties_commit() in one atomic write, or not at all
+ * if none of the updates has changed the properties.
+ *
+ * @param[in]  properties    the properties object
+ */
+void properties_begin(struct properties *properties)
+{
+	util_assert(properties != NULL, "Internal error: properties is NULL");
+
+	properties->changes = 0;
+}
+
+/**
+ * Checks if the properties have been changed since they were loaded,
+ * saved, or since the transaction has begun.
+ *
+ * @param[in]  properties    the properties object
+ *
+ * @returns true if the properties have been changed
+ */
+bool properties_changed(struct properties *properties)
+{
+	util_assert(properties != NULL, "Internal error: properties is NULL");
+
+	return properties->changes > 0;
+}
+
+/**
+ * Commits a transaction of updates of the properties: Saves the
+ * properties to a file if they have been changed.
+ *
+ * @param[in]  properties    the properties object
+ * @param[in]  filename      the file name
+ * @param[in]  check_integrity if TRUE, an hash of the key and values is
+ *                           stored as part of the file.
+ *
+ * @returns 0 on success, -EIO the file could not be created
+ */
+int properties_commit(struct properties *properties, const char *filename,
+		      bool check_integrity)
+{
+	util_assert(properties != NULL, "Internal error: properties is NULL");
+
+	if (!properties_changed(properties))
+		return 0;
+
+	return properties_save(properties, filename, check_integrity);
+}
+
+/**
+ * Opens a temporary file next to an existing file with the same mode and
+ * group, so that the existing file can be replaced atomically by renaming
+ * the temporary file.
+ *
+ * @param[in]  filename      the file name
+ * @param[in]  sb            the status of the existing file
+ * @param[out] tempname      on return: the name of the temporary file
+ *
+ * @returns the opened file, or NULL in case of an error
+ */
+static FILE *_properties_open_temp(const char *filename, struct stat *sb,
+				   char **tempname)
+{
+	FILE *fp;
+	int fd;
+
+	util_asprintf(tempname, "%s.XXXXXX", filename);
+	fd = mkstemp(*tempname);
+	if (fd == -1)
+		goto out_free;
+	if (fchmod(fd, sb->st_mode & 07777) != 0 ||
+	    fchown(fd, -1, sb->st_gid) != 0)
+		goto out_remove;
+	fp = fdopen(fd, "w");
+	if (fp == NULL)
+		goto out_remove;
+	return fp;
+
+out_remove:
+	close(fd);
+	remove(*tempname);
+out_free:
+	free(*tempname);
+	*tempname = NULL;
+	return NULL;
+}
+
+/**
+ * Saves the properties to a file. An existing file is replaced atomically,
+ * so that it contains either the old or the new properties, even if zkey
+ * is interrupted.
  *
  * @param[in]  properties    the properties object
  * @param[in]  filename      the file name
@@ -306,13 +497,19 @@ int properties_save(struct properties *properties, const char *filename,
 	unsigned int digest_len = sizeof(digest);
 	struct property *property;
 	EVP_MD_CTX *ctx = NULL;
+	char *tempname = NULL;
 	unsigned int i;
+	struct stat sb;
 	FILE *fp;
+	int rc = 0;
 
 	util_assert(properties != NULL, "Internal error: properties is NULL");
 	util_assert(filename != NULL, "Internal error: filename is NULL");
 
-	fp = fopen(filename, "w");
+	if (stat(filename, &sb) == 0)
+		fp = _properties_open_temp(filename, &sb, &tempname);
+	else
+		fp = fopen(filename, "w");
 	if (fp == NULL)
 		return -EIO;
 
@@ -345,8 +542,20 @@ int properties_save(struct properties *properties, const char *filename,
 		fprintf(fp, "%s=%s\n", INTEGRITY_KEY_NAME, digest_hex);
 	}
 
-	fclose(fp);
-	return 0;
+	if (fflush(fp) != 0 || (tempname != NULL && fsync(fileno(fp)) != 0))
+		rc = -EIO;
+	if (fclose(fp) != 0)
+		rc = -EIO;
+	if (tempname != NULL) {
+		if (rc == 0 && rename(tempname, filename) != 0)
+			rc = -EIO;
+		if (rc != 0)
+			remove(tempname);
+		free(tempname);
+	}
+	if (rc == 0)
+		properties->changes = 0;
+	return rc;
 }
 
 /**
@@ -431,6 +640,8 @@ int properties_load(struct properties *properties, const char *filename,
 		}
 	}
 
+	properties->changes = 0;
+
 out:
 	if (ctx != NULL)
 		sha256_final(ctx, NULL, NULL);
@@ -30,6 +30,13 @@ char *properties_get(struct properties *properties, const char *name);
 
 int properties_remove(struct properties *properties, const char *name);
 
+void properties_begin(struct properties *properties);
+
+bool properties_changed(struct properties *properties);
+
+int properties_commit(struct properties *properties, const char *filename,
+		      bool check_integrity);
+
 int properties_save(struct properties *properties, const char *filename,
 		    bool check_integrity);
 
@@ -93,6 +93,8 @@ static struct zkey_globals {
 	bool open;
 	bool format;
 	bool refresh_properties;
+	long int jobs;
+	long int jobs_per_apqn;
 	struct ext_lib lib;
 	struct cca_lib cca;
 	struct ep11_lib ep11;
@@ -105,6 +107,8 @@ static struct zkey_globals {
 } g = {
 	.pkey_fd = -1,
 	.sector_size = -1,
+	.jobs = 1,
+	.jobs_per_apqn = 1,
 	.lib.cca = &g.cca,
 	.lib.ep11 = &g.ep11,
 };
@@ -149,6 +153,7 @@ static struct zkey_globals {
 
 #define ENVVAR_ZKEY_REPOSITORY	"ZKEY_REPOSITORY"
 #define DEFAULT_KEYSTORE	"/etc/zkey/repository"
+#define MAX_REENCIPHER_JOBS	256
 
 #define OPT_CRYPTSETUP_KEYFILE		256
 #define OPT_CRYPTSETUP_KEYFILE_OFFSET	257
@@ -162,6 +167,7 @@ static struct zkey_globals {
 #define OPT_GEN_DUMMY_PASSPHRASE	265
 #define OPT_SET_DUMMY_PASSPHRASE	266
 #define OPT_REMOVE_DUMMY_PASSPHRASE	267
+#define OPT_JOBS_PER_APQN		268
 
 /*
  * Configuration of command line options
@@ -369,6 +375,24 @@ static struct util_opt opt_vec[] = {
 			"associated with specific crypto cards",
 		.command = COMMAND_REENCIPHER,
 	},
+	{
+		.option = { "jobs", required_argument, NULL, 'j'},
+		.argument = "NUMBER",
+		.desc = "Number of secure AES keys in the repository that are "
+			"re-enciphered in parallel. The keys are distributed "
+			"across their associated APQNs. The default is 1",
+		.command = COMMAND_REENCIPHER,
+	},
+	{
+		.option = { "jobs-per-apqn", required_argument, NULL,
+						OPT_JOBS_PER_APQN},
+		.argument = "NUMBER",
+		.desc = "Maximum number of secure AES keys that are "
+			"re-enciphered in parallel on the same APQN. The "
+			"default is 1",
+		.flags = UTIL_OPT_FLAG_NOSHORT,
+		.command = COMMAND_REENCIPHER,
+	},
 	/***********************************************************/
 	{
 		.flags = UTIL_OPT_FLAG_SECTION,
@@ -1910,6 +1934,12 @@ static int command_reencipher_file(void)
 		util_prg_print_parse_error();
 		return EXIT_FAILURE;
 	}
+	if (g.jobs != 1 || g.jobs_per_apqn != 1) {
+		warnx("Options '--jobs|-j' and '--jobs-per-apqn' are not valid "
+		      "for re-enciphering a key outside of the repository");
+		util_prg_print_parse_error();
+		return EXIT_FAILURE;
+	}
 
 	/* Read the secure key to be re-enciphered */
 	secure_key = read_secure_key(g.pos_arg, &secure_key_size, g.verbose);
@@ -2056,7 +2086,8 @@ static int command_reencipher_repository(void)
 
 	rc = keystore_reencipher_key(g.keystore, g.name, g.apqns, g.fromold,
 				     g.tonew, g.inplace, g.staged, g.complete,
-				     g.pkey_fd, &g.lib);
+				     g.pkey_fd, &g.lib, g.jobs,
+				     g.jobs_per_apqn);
 
 	return rc != 0 ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -3234,6 +3265,27 @@ int main(int argc, char *argv[])
 		case OPT_REMOVE_DUMMY_PASSPHRASE:
 			g.remove_passphrase = 1;
 			break;
+		case 'j':
+			g.jobs = strtol(optarg, &endp, 0);
+			if (*optarg == '\0' || *endp != '\0' ||
+			    g.jobs <= 0 || g.jobs > MAX_REENCIPHER_JOBS) {
+				warnx("Invalid value for '--jobs'|'-j': '%s'",
+				      optarg);
+				util_prg_print_parse_error();
+				return EXIT_FAILURE;
+			}
+			break;
+		case OPT_JOBS_PER_APQN:
+			g.jobs_per_apqn = strtol(optarg, &endp, 0);
+			if (*optarg == '\0' || *endp != '\0' ||
+			    g.jobs_per_apqn <= 0 ||
+			    g.jobs_per_apqn > MAX_REENCIPHER_JOBS) {
+				warnx("Invalid value for '--jobs-per-apqn': "
+				      "'%s'", optarg);
+				util_prg_print_parse_error();
+				return EXIT_FAILURE;
+			}
+			break;
 		case 'h':
 			print_help(command, sub_command);
 			return EXIT_SUCCESS;